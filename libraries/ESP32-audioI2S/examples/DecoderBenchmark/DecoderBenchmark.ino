@@ -0,0 +1,195 @@
+//**********************************************************************************************************
+//*    DecoderBenchmark -- CPU cycles of the decoders on the ESP32                                         *
+//**********************************************************************************************************
+//
+// Copy the files of additional_info/Testfiles to the root of a SD card. Each file is read into RAM and decoded
+// without I2S output, the results go to Serial:
+//   MP3: cycles per frame on one core, and frames per second without and with MP3SetDualCore(), together with the
+//        share of the stereo granules that were split between the cores
+//   AAC: cycles per frame and frames per second, for HE-AAC with SBR, and how many times faster than real time
+//   FLAC: cycles per sample and frames per second, build it once more with FLAC_RICE_REFERENCE in flac_decoder.h to
+//        compare the rice decoders
+//   Ogg: cycles per page of the demuxer and the share of the bytes it had to copy, the codec takes each packet whole
+// The host build in test/ gives the same figures for a PC, they can't be compared with these.
+//
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "SD.h"
+#include "FS.h"
+#include "mp3_decoder/mp3_decoder.h"
+#include "aac_decoder/aac_decoder.h"
+#include "flac_decoder/flac_decoder.h"
+#include "ogg_demuxer/ogg_demuxer.h"
+
+// Digital I/O used
+#define SD_CS          5
+#define SPI_MOSI      23
+#define SPI_MISO      19
+#define SPI_SCK       18
+
+static int16_t pcm[2 * 2048 * 2];
+
+uint8_t* loadFile(const char* path, size_t* size) {
+    File f = SD.open(path);
+    if(!f) {Serial.printf("can't open %s\n", path); return NULL;}
+    *size = f.size();
+    uint8_t* d = (uint8_t*)(psramFound() ? ps_malloc(*size) : malloc(*size));
+    if(d) f.read(d, *size);
+    else Serial.printf("%s: no memory for %u bytes\n", path, *size);
+    f.close();
+    return d;
+}
+
+size_t skipID3(const uint8_t* d, size_t size) {
+    if(size > 10 && !memcmp(d, "ID3", 3)) return 10 + ((d[6] << 21) | (d[7] << 14) | (d[8] << 7) | d[9]);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void benchMP3(const char* path) {
+    size_t size;
+    uint8_t* d = loadFile(path, &size);
+    if(!d) return;
+    uint32_t cycles[2] = {0, 0}, us[2] = {0, 0}, frames = 0;
+    for(int dual = 0; dual < 2; dual++) {
+        MP3Decoder_t* dec = MP3Decoder_Create();
+        if(!dec) {Serial.println("MP3Decoder_Create failed"); break;}
+        if(dual && !MP3SetDualCore(dec, true)) {Serial.println("no dual core"); MP3Decoder_Destroy(dec); break;}
+        int left = size - skipID3(d, size);
+        frames = 0;
+        uint32_t t0 = micros();
+        while(left > 4) {
+            uint32_t c0 = ESP.getCycleCount();
+            int err = MP3Decode(dec, d + size - left, &left, pcm, 0);
+            cycles[dual] += ESP.getCycleCount() - c0;
+            if(err == ERR_MP3_MAINDATA_UNDERFLOW) continue;
+            if(err) break;
+            frames++;
+        }
+        us[dual] = micros() - t0;
+        if(dual) Serial.printf("    dual core averages: split granule %u, one core %u cycles\n", dec->dualCycles,
+                               dec->serialCycles);
+        MP3Decoder_Destroy(dec);
+    }
+    if(frames) Serial.printf("%-28s %7u cycles/frame, %5.0f frames/s one core, %5.0f frames/s with worker\n", path,
+                             cycles[0] / frames, frames * 1e6 / us[0], us[1] ? frames * 1e6 / us[1] : 0.0);
+    free(d);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void benchAAC(const char* path) {
+    size_t size;
+    uint8_t* d = loadFile(path, &size);
+    if(!d) return;
+    AACDecoder_t* dec = AACDecoder_Create();
+    if(!dec) {Serial.println("AACDecoder_Create failed"); free(d); return;}
+    uint32_t cycles = 0, frames = 0;
+    int left = size;
+    uint32_t t0 = micros();
+    while(left > 7) {
+        uint32_t c0 = ESP.getCycleCount();
+        int err = AACDecode(dec, d + size - left, &left, pcm);
+        cycles += ESP.getCycleCount() - c0;
+        if(err) break;
+        frames++;
+    }
+    uint32_t us = micros() - t0;
+    if(frames) {
+        float fps = frames * 1e6 / us;
+        int   samps = AACGetOutputSamps(dec) / AACGetChannels(dec);
+        Serial.printf("%-28s %7u cycles/frame, %5.0f frames/s, %4.0fx real time\n", path, cycles / frames, fps,
+                      fps * samps / AACGetSampRate(dec));
+    }
+    AACDecoder_Destroy(dec);
+    free(d);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t skipFLACMetadata(const uint8_t* d, size_t size) {
+    if(size < 8 || memcmp(d, "fLaC", 4)) return 0;
+    size_t pos = 4;
+    bool last = false;
+    while(!last && pos + 4 <= size) {
+        last = d[pos] & 0x80;
+        pos += 4 + ((d[pos + 1] << 16) | (d[pos + 2] << 8) | d[pos + 3]);
+    }
+    return pos;
+}
+
+void benchFLAC(const char* path) {
+    size_t size;
+    uint8_t* d = loadFile(path, &size);
+    if(!d) return;
+    FLACDecoder_t* dec = FLACDecoder_Create();
+    if(!dec) {Serial.println("FLACDecoder_Create failed"); free(d); return;}
+    uint32_t cycles = 0, frames = 0, samples = 0;
+    int left = size - skipFLACMetadata(d, size);
+    uint32_t t0 = micros();
+    while(left > 0) {
+        uint32_t c0 = ESP.getCycleCount();
+        int err = FLACDecode(dec, d + size - left, &left, pcm);
+        cycles += ESP.getCycleCount() - c0;
+        if(err < 0) break;
+        int samps = FLACGetOutputSamps(dec);
+        samples += samps / FLACGetChannels(dec);
+        if(samps && err == ERR_FLAC_NONE) frames++;
+    }
+    uint32_t us = micros() - t0;
+    if(samples) Serial.printf("%-28s %7u cycles/sample, %5.0f frames/s, %4.0fx real time\n", path, cycles / samples,
+                              frames * 1e6 / us, samples * 1e6 / us / FLACGetSampRate(dec));
+    FLACDecoder_Destroy(dec);
+    free(d);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void benchOgg(const char* path, int window) {
+    size_t size;
+    uint8_t* d = loadFile(path, &size);
+    if(!d) return;
+    OggDemuxer_t* ogg = OggDemuxer_Create();
+    if(!ogg) {Serial.println("OggDemuxer_Create failed"); free(d); return;}
+    size_t pos = 0;
+    uint32_t c0 = ESP.getCycleCount();
+    while(pos < size || OggPacketPending(ogg)) {
+        int len = min((size_t)window, size - pos);
+        uint8_t* pkt;
+        int pktLen;
+        int res = OggReadPacket(ogg, d + pos, len, &pkt, &pktLen);
+        if(res < 0) break;
+        if(res > 0) {pos += res; continue;}
+        if(!pktLen) break;
+        ogg->f_bos = false;
+        pos += OggPacketUsed(ogg, pktLen);
+    }
+    uint32_t cycles = ESP.getCycleCount() - c0;
+    if(ogg->pages) Serial.printf("%-28s window %5i: %6u cycles/page, %u packets, copied %3.0f%% of the bytes\n", path,
+                                 window, cycles / ogg->pages, ogg->packets, 100.0 * ogg->bytesCopied / size);
+    OggDemuxer_Destroy(ogg);
+    free(d);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void setup() {
+    Serial.begin(115200);
+    pinMode(SD_CS, OUTPUT);      digitalWrite(SD_CS, HIGH);
+    SPI.begin(SPI_SCK, SPI_MISO, SPI_MOSI);
+    if(!SD.begin(SD_CS)) {Serial.println("no SD card"); return;}
+    Serial.printf("CPU %u MHz, running on core %i\n", getCpuFrequencyMhz(), xPortGetCoreID());
+
+    benchMP3("/test_128k_stereo.mp3");
+    benchMP3("/test_320k_stereo.mp3");
+    benchMP3("/test_64k_stereo_24kHz.mp3");
+    benchMP3("/test_48k_mono_22kHz.mp3");
+    benchAAC("/test_128k_stereo.aac");
+    benchAAC("/test_192k_stereo_48kHz.aac");
+    benchAAC("/test_48k_mono_32kHz.aac");
+    benchAAC("/test_he_aac_stereo.aac");
+    benchFLAC("/test_16bit_stereo.flac");
+    benchOgg("/test_16bit_stereo_flac.ogg", 4096);
+    benchOgg("/test_96k_stereo_opus.ogg", 4096);
+}
+
+void loop() {
+    vTaskDelay(1000);
+}
@@ -10,6 +10,10 @@
 #include "mp3_decoder/mp3_decoder.h"
 #include "aac_decoder/aac_decoder.h"
 #include "flac_decoder/flac_decoder.h"
+#include "opus_decoder/opus_decoder.h"
+#include "ogg_demuxer/ogg_demuxer.h"
+#include "audio_arena/audio_arena.h"
+#include <Preferences.h>
 
 #ifndef AUDIO_NO_SD_FS
 #ifdef SDFATFS_USED
@@ -24,6 +28,265 @@ fs::SDFATFS SD_SDFAT;
  *  } */
 #define AUDIO_INFO(cmd) if(audio_info) { cmd; audio_info(chbuf); }
 
+//---------------------------------------------------------------------------------------------------------------------
+//      C O D E C   P L U G I N S
+//---------------------------------------------------------------------------------------------------------------------
+// Every decoder is wrapped in a codecPlugin_t and registered in codecPlugins[]. The player only calls the plugin of
+// the current stream (m_plugin) with its own context (m_codecCtx), so several Audio objects can decode at the same
+// time. A decoder that is not registered is not referenced and not linked.
+
+#ifndef AUDIO_NO_MP3
+static uint8_t mp3Probe(const char* type){
+    if(strstr(type, "mpeg") || strstr(type, "mp3")) return Audio::CODEC_MP3;
+    return Audio::CODEC_NONE;
+}
+static void* mp3Create(){
+    return MP3Decoder_Create();
+}
+static void mp3Destroy(void* ctx){
+    MP3Decoder_Destroy((MP3Decoder_t*)ctx);
+}
+static void mp3Reset(void* ctx){
+    MP3Decoder_ClearBuffer((MP3Decoder_t*)ctx);
+}
+static int mp3Sync(void* ctx, uint8_t* data, int len, const codecSetup_t* cs){
+    return data ? MP3FindSyncWord(data, len) : 0;
+}
+static void mp3Configure(void* ctx, const codecSetup_t* cs){
+    MP3Decoder_t* dec = (MP3Decoder_t*)ctx;
+    MP3SetDownmix(dec, cs->downmix); // forced mono is mixed inside the decoder, before IMDCT
+    MP3SetQuality(dec, cs->quality);
+    MP3SetDualCore(dec, cs->dualCore);
+}
+static int mp3Decode(void* ctx, uint8_t* data, int* bytesLeft, int16_t* outbuf){
+    return MP3Decode((MP3Decoder_t*)ctx, data, bytesLeft, outbuf, 0);
+}
+static void mp3FrameInfo(void* ctx, codecFrameInfo_t* fi){
+    MP3Decoder_t* dec = (MP3Decoder_t*)ctx;
+    fi->sampleRate    = MP3GetSampRate(dec);
+    fi->bitRate       = MP3GetBitrate(dec);
+    fi->outputSamps   = MP3GetOutputSamps(dec);
+    fi->channels      = MP3GetChannels(dec);
+    fi->bitsPerSample = MP3GetBitsPerSample(dec);
+}
+static const char* mp3ErrorText(int err){
+    switch(err){
+        case ERR_MP3_NONE:                              return "NONE";
+        case ERR_MP3_INDATA_UNDERFLOW:                  return "INDATA_UNDERFLOW";
+        case ERR_MP3_MAINDATA_UNDERFLOW:                return "MAINDATA_UNDERFLOW";
+        case ERR_MP3_FREE_BITRATE_SYNC:                 return "FREE_BITRATE_SYNC";
+        case ERR_MP3_OUT_OF_MEMORY:                     return "OUT_OF_MEMORY";
+        case ERR_MP3_NULL_POINTER:                      return "NULL_POINTER";
+        case ERR_MP3_INVALID_FRAMEHEADER:               return "INVALID_FRAMEHEADER";
+        case ERR_MP3_INVALID_SIDEINFO:                  return "INVALID_SIDEINFO";
+        case ERR_MP3_INVALID_SCALEFACT:                 return "INVALID_SCALEFACT";
+        case ERR_MP3_INVALID_HUFFCODES:                 return "INVALID_HUFFCODES";
+        case ERR_MP3_INVALID_DEQUANTIZE:                return "INVALID_DEQUANTIZE";
+        case ERR_MP3_INVALID_IMDCT:                     return "INVALID_IMDCT";
+        case ERR_MP3_INVALID_SUBBAND:                   return "INVALID_SUBBAND";
+    }
+    return "ERR_UNKNOWN";
+}
+static const codecPlugin_t mp3Plugin = {
+    "MP3", CODEC_PLUGIN_MP3, {Audio::CODEC_MP3, Audio::CODEC_NONE}, 1600,
+    mp3Probe, mp3Create, mp3Destroy, mp3Reset, mp3Sync, mp3Configure, NULL,
+    mp3Decode, mp3FrameInfo, mp3ErrorText, MP3Decoder_BufferSize
+};
+#endif // AUDIO_NO_MP3
+
+#ifndef AUDIO_NO_AAC
+static uint8_t aacProbe(const char* type){
+    if(strstr(type, "aac")) return Audio::CODEC_AAC;                          // audio/aac, audio/x-aac, audio/aacp
+    if(strstr(type, "mp4") || strstr(type, "m4a")) return Audio::CODEC_M4A;   // audio/mp4a-latm, audio/x-m4a
+    return Audio::CODEC_NONE;
+}
+static void* aacCreate(){
+    return AACDecoder_Create();
+}
+static void aacDestroy(void* ctx){
+    AACDecoder_Destroy((AACDecoder_t*)ctx);
+}
+static int aacSync(void* ctx, uint8_t* data, int len, const codecSetup_t* cs){
+    if(cs->codec == Audio::CODEC_M4A){  // raw blocks, the parameters come with the first block
+        AACSetRawBlockParams((AACDecoder_t*)ctx, 0, 2, 44100, 1);
+        return 0;
+    }
+    return data ? AACFindSyncWord(data, len) : 0;
+}
+static void aacConfigure(void* ctx, const codecSetup_t* cs){
+    AACDecoder_t* dec = (AACDecoder_t*)ctx;
+    AACSetDownmix(dec, cs->downmix);
+    AACSetQuality(dec, cs->quality ? AAC_QUALITY_CORE : 0);
+    AACSetParametricStereo(dec, cs->stereoPS);
+}
+static int aacDecode(void* ctx, uint8_t* data, int* bytesLeft, int16_t* outbuf){
+    return AACDecode((AACDecoder_t*)ctx, data, bytesLeft, outbuf);
+}
+static void aacFrameInfo(void* ctx, codecFrameInfo_t* fi){
+    AACDecoder_t* dec = (AACDecoder_t*)ctx;
+    fi->sampleRate    = AACGetSampRate(dec);
+    fi->bitRate       = AACGetBitrate(dec);
+    fi->outputSamps   = AACGetOutputSamps(dec);
+    fi->channels      = AACGetChannels(dec);
+    fi->bitsPerSample = AACGetBitsPerSample();
+}
+static const char* aacErrorText(int err){
+    switch(err){
+        case ERR_AAC_NONE:                              return "NONE";
+        case ERR_AAC_INDATA_UNDERFLOW:                  return "INDATA_UNDERFLOW";
+        case ERR_AAC_NULL_POINTER:                      return "NULL_POINTER";
+        case ERR_AAC_INVALID_ADTS_HEADER:               return "INVALID_ADTS_HEADER";
+        case ERR_AAC_INVALID_ADIF_HEADER:               return "INVALID_ADIF_HEADER";
+        case ERR_AAC_INVALID_FRAME:                     return "INVALID_FRAME";
+        case ERR_AAC_MPEG4_UNSUPPORTED:                 return "MPEG4_UNSUPPORTED";
+        case ERR_AAC_CHANNEL_MAP:                       return "CHANNEL_MAP";
+        case ERR_AAC_SYNTAX_ELEMENT:                    return "SYNTAX_ELEMENT";
+        case ERR_AAC_DEQUANT:                           return "DEQUANT";
+        case ERR_AAC_STEREO_PROCESS:                    return "STEREO_PROCESS";
+        case ERR_AAC_PNS:                               return "PNS";
+        case ERR_AAC_SHORT_BLOCK_DEINT:                 return "SHORT_BLOCK_DEINT";
+        case ERR_AAC_TNS:                               return "TNS";
+        case ERR_AAC_IMDCT:                             return "IMDCT";
+        case ERR_AAC_SBR_INIT:                          return "SBR_INIT";
+        case ERR_AAC_SBR_BITSTREAM:                     return "SBR_BITSTREAM";
+        case ERR_AAC_SBR_DATA:                          return "SBR_DATA";
+        case ERR_AAC_SBR_PCM_FORMAT:                    return "SBR_PCM_FORMAT";
+        case ERR_AAC_SBR_NCHANS_TOO_HIGH:               return "SBR_NCHANS_TOO_HIGH";
+        case ERR_AAC_SBR_SINGLERATE_UNSUPPORTED:        return "BR_SINGLERATE_UNSUPPORTED";
+        case ERR_AAC_NCHANS_TOO_HIGH:                   return "NCHANS_TOO_HIGH";
+        case ERR_AAC_RAWBLOCK_PARAMS:                   return "RAWBLOCK_PARAMS";
+    }
+    return "ERR_UNKNOWN";
+}
+// no reset: the decoder keeps its state after a seek and from one m3u8 chunk to the next
+static const codecPlugin_t aacPlugin = {
+    "AAC", CODEC_PLUGIN_AAC, {Audio::CODEC_AAC, Audio::CODEC_M4A}, 1600,
+    aacProbe, aacCreate, aacDestroy, NULL, aacSync, aacConfigure, NULL,
+    aacDecode, aacFrameInfo, aacErrorText, AACDecoder_BufferSize
+};
+#endif // AUDIO_NO_AAC
+
+#ifndef AUDIO_NO_FLAC
+static uint8_t flacProbe(const char* type){
+    return strstr(type, "flac") ? Audio::CODEC_FLAC : Audio::CODEC_NONE;     // audio/flac, audio/x-flac
+}
+static void* flacCreate(){
+    return FLACDecoder_Create();
+}
+static void flacDestroy(void* ctx){
+    FLACDecoder_Destroy((FLACDecoder_t*)ctx);
+}
+static void flacReset(void* ctx){
+    FLACDecoderReset((FLACDecoder_t*)ctx);
+}
+static int flacSync(void* ctx, uint8_t* data, int len, const codecSetup_t* cs){
+    FLACDecoder_t* dec = (FLACDecoder_t*)ctx;
+    FLACSetRawBlockParams(dec, cs->channels, cs->sampleRate, cs->bitsPerSample, cs->totalSamples, cs->dataSize);
+    return data ? FLACFindSyncWord(dec, data, len) : 0;
+}
+static void flacConfigure(void* ctx, const codecSetup_t* cs){
+    FLACDecoder_t* dec = (FLACDecoder_t*)ctx;
+    FLACSetQuality(dec, cs->quality ? FLAC_QUALITY_48K : 0);
+    FLACSetCRCCheck(dec, cs->crcCheck);
+}
+static int flacDecode(void* ctx, uint8_t* data, int* bytesLeft, int16_t* outbuf){
+    return FLACDecode((FLACDecoder_t*)ctx, data, bytesLeft, outbuf);  // Ogg: one frame per packet
+}
+static void flacFrameInfo(void* ctx, codecFrameInfo_t* fi){
+    FLACDecoder_t* dec = (FLACDecoder_t*)ctx;
+    fi->sampleRate    = FLACGetSampRate(dec);
+    fi->bitRate       = FLACGetBitRate(dec);
+    fi->outputSamps   = FLACGetOutputSamps(dec);
+    fi->channels      = FLACGetChannels(dec);
+    fi->bitsPerSample = FLACGetBitsPerSample(dec);
+}
+static const char* flacErrorText(int err){
+    switch(err){
+        case ERR_FLAC_NONE:                             return "NONE";
+        case ERR_FLAC_BLOCKSIZE_TOO_BIG:                return "BLOCKSIZE TOO BIG";
+        case ERR_FLAC_RESERVED_BLOCKSIZE_UNSUPPORTED:   return "Reserved Blocksize unsupported";
+        case ERR_FLAC_SYNC_CODE_NOT_FOUND:              return "SYNC CODE NOT FOUND";
+        case ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT:       return "UNKNOWN CHANNEL ASSIGNMENT";
+        case ERR_FLAC_RESERVED_CHANNEL_ASSIGNMENT:      return "RESERVED CHANNEL ASSIGNMENT";
+        case ERR_FLAC_RESERVED_SUB_TYPE:                return "RESERVED SUB TYPE";
+        case ERR_FLAC_PREORDER_TOO_BIG:                 return "PREORDER TOO BIG";
+        case ERR_FLAC_RESERVED_RESIDUAL_CODING:         return "RESERVED RESIDUAL CODING";
+        case ERR_FLAC_WRONG_RICE_PARTITION_NR:          return "WRONG RICE PARTITION NR";
+        case ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG:          return "BITS PER SAMPLE > 24";
+        case ERR_FLAG_BITS_PER_SAMPLE_UNKNOWN:          return "BITS PER SAMPLE UNKNOWN";
+        case ERR_FLAC_OUT_OF_MEMORY:                    return "OUT OF MEMORY";
+        case ERR_FLAC_CRC_MISMATCH:                     return "CRC MISMATCH";
+    }
+    return "ERR_UNKNOWN";
+}
+static const codecPlugin_t flacPlugin = {
+    "FLAC", CODEC_PLUGIN_FLAC, {Audio::CODEC_FLAC, Audio::CODEC_OGG_FLAC}, 0,
+    flacProbe, flacCreate, flacDestroy, flacReset, flacSync, flacConfigure, NULL,
+    flacDecode, flacFrameInfo, flacErrorText, FLACDecoder_BufferSize
+};
+#endif // AUDIO_NO_FLAC
+
+#ifndef AUDIO_NO_OPUS
+static void* opusCreate(){
+    return OPUSDecoder_Create();
+}
+static void opusDestroy(void* ctx){
+    OPUSDecoder_Destroy((OpusDecoder_t*)ctx);
+}
+static void opusReset(void* ctx){
+    OPUSDecoderReset((OpusDecoder_t*)ctx);
+}
+static int opusHeader(void* ctx, uint8_t* data, int len){
+    return OPUSParseOpusHead((OpusDecoder_t*)ctx, data, len);
+}
+static int opusDecode(void* ctx, uint8_t* data, int* bytesLeft, int16_t* outbuf){
+    return OPUSDecode((OpusDecoder_t*)ctx, data, bytesLeft, outbuf);  // one frame per call, > 0: more in the packet
+}
+static void opusFrameInfo(void* ctx, codecFrameInfo_t* fi){
+    OpusDecoder_t* dec = (OpusDecoder_t*)ctx;
+    fi->sampleRate    = OPUSGetSampRate(dec);
+    fi->bitRate       = OPUSGetBitRate(dec);
+    fi->outputSamps   = OPUSGetOutputSamps(dec);
+    fi->channels      = OPUSGetChannels(dec);
+    fi->bitsPerSample = OPUSGetBitsPerSample(dec);
+}
+static const char* opusErrorText(int err){
+    switch(err){
+        case ERR_OPUS_NONE:                             return "NONE";
+        case ERR_OPUS_CHANNELS_OUT_OF_RANGE:            return "CHANNELS OUT OF RANGE";
+        case ERR_OPUS_INVALID_PACKET:                   return "INVALID PACKET";
+        case ERR_OPUS_NOT_INITIALIZED:                  return "NOT INITIALIZED";
+        case ERR_OPUS_OUT_OF_MEMORY:                    return "OUT OF MEMORY";
+        case ERR_OPUS_HEADER:                           return "HEADER";
+        case ERR_OPUS_FRAME_CORRUPT:                    return "FRAME CORRUPT";
+    }
+    return "ERR_UNKNOWN";
+}
+// Ogg only: no probe (the codec is known with the first packet, see readOggPacket()) and no sync, the demuxer
+// delivers whole packets
+static const codecPlugin_t opusPlugin = {
+    "OPUS", CODEC_PLUGIN_OPUS, {Audio::CODEC_OGG_OPUS, Audio::CODEC_NONE}, 1600,
+    NULL, opusCreate, opusDestroy, opusReset, NULL, NULL, opusHeader,
+    opusDecode, opusFrameInfo, opusErrorText, OPUSDecoder_BufferSize
+};
+#endif // AUDIO_NO_OPUS
+
+static const codecPlugin_t* const codecPlugins[] = {  // probe order
+#ifndef AUDIO_NO_MP3
+    &mp3Plugin,
+#endif
+#ifndef AUDIO_NO_AAC
+    &aacPlugin,
+#endif
+#ifndef AUDIO_NO_FLAC
+    &flacPlugin,
+#endif
+#ifndef AUDIO_NO_OPUS
+    &opusPlugin,
+#endif
+    NULL
+};
+
 //---------------------------------------------------------------------------------------------------------------------
 AudioBuffer::AudioBuffer(size_t maxBlockSize) {
     // if maxBlockSize isn't set use defaultspace (1600 bytes) is enough for aac and mp3 player
@@ -53,6 +316,7 @@ size_t AudioBuffer::init() {
         m_buffSize = m_buffSizePSRAM;
         m_buffer = (uint8_t*) ps_calloc(m_buffSize, sizeof(uint8_t));
         m_buffSize = m_buffSizePSRAM - m_resBuffSizePSRAM;
+        m_resBuffSize = m_resBuffSizePSRAM;
     }
     if(m_buffer == NULL) {
         // PSRAM not found, not configured or not enough available
@@ -60,6 +324,7 @@ size_t AudioBuffer::init() {
         m_buffSize = m_buffSizeRAM;
         m_buffer = (uint8_t*) calloc(m_buffSize, sizeof(uint8_t));
         m_buffSize = m_buffSizeRAM - m_resBuffSizeRAM;
+        m_resBuffSize = m_resBuffSizeRAM;
     }
     if(!m_buffer)
         return 0;
@@ -73,6 +338,32 @@ void AudioBuffer::changeMaxBlockSize(uint16_t mbs){
     return;
 }
 
+bool AudioBuffer::setMaxFrameSizeRAM(size_t mfs){
+    // The RAM buffer (no PSRAM) reserves room for one mp3/aac frame only. For bigger frames (FLAC) it is allocated
+    // again, with a reserve of mfs bytes and mfs + 4096 bytes for the ring, so that a whole frame can be read out.
+    // mfs = 0 goes back to the configured size. Unread data is kept, if it doesn't fit the size is not changed.
+    if(m_f_psram || !m_f_init) return true;
+    size_t res  = mfs ? mfs : m_resBuffSizeRAM;
+    size_t size = mfs ? 2 * mfs + 4096 : m_buffSizeRAM;
+    if(res == m_resBuffSize && size == m_buffSize + m_resBuffSize) return true;
+    size_t n = m_f_start ? 0 : bufferFilled();
+    if(n >= size - res) return res <= m_resBuffSize; // too much unread data, the old size must do
+    uint8_t* buf = (uint8_t*) calloc(size, sizeof(uint8_t));
+    if(!buf) return false;
+    if(n){
+        size_t len = m_endPtr - m_readPtr;
+        if(len >= n) memcpy(buf, m_readPtr, n);
+        else {memcpy(buf, m_readPtr, len); memcpy(buf + len, m_buffer, n - len);}
+    }
+    free(m_buffer);
+    m_buffer = buf;
+    m_buffSize = size - res;
+    m_resBuffSize = res;
+    resetBuffer();
+    if(n) bytesWritten(n);
+    return true;
+}
+
 uint16_t AudioBuffer::getMaxBlockSize(){
     return m_maxBlockSize;
 }
@@ -227,6 +518,26 @@ Audio::Audio(bool internalDAC /* = false */, uint8_t channelEnabled /* = I2S_DAC
         m_filter[i].b1  = 0;
         m_filter[i].b2  = 0;
     }
+
+    // one arena in internal RAM for the pipeline buffers and the internal buffers of the biggest decoder, reserved as
+    // long as the heap is not fragmented. Decoder buffers that prefer PSRAM are not counted, they come from the heap
+    size_t arenaSize = 0;
+    for(int i = 0; codecPlugins[i]; i++) {
+        if(codecPlugins[i]->bufferSize() > arenaSize) arenaSize = codecPlugins[i]->bufferSize();
+    }
+    arenaSize += ArenaBlockSize(CHBUF_SIZE, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT) +
+                 ArenaBlockSize(LASTHOST_SIZE, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT) +
+                 ArenaBlockSize(OUTBUFF_SIZE * sizeof(int16_t), MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL,
+                                MALLOC_CAP_DEFAULT);
+    ArenaCreate(arenaSize);
+    chbuf      = (char*)   ArenaMalloc(CHBUF_SIZE, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT);
+    m_lastHost = (char*)   ArenaMalloc(LASTHOST_SIZE, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT);
+    m_outBuff  = (int16_t*)ArenaMalloc(OUTBUFF_SIZE * sizeof(int16_t), MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL,
+                                       MALLOC_CAP_DEFAULT);
+    if(!chbuf || !m_lastHost || !m_outBuff) log_e("out of memory");
+    if(chbuf)      memset(chbuf, 0, CHBUF_SIZE);
+    if(m_lastHost) memset(m_lastHost, 0, LASTHOST_SIZE);
+    if(m_outBuff)  memset(m_outBuff, 0, OUTBUFF_SIZE * sizeof(int16_t));
 }
 //---------------------------------------------------------------------------------------------------------------------
 void Audio::setBufsize(int rambuf_sz, int psrambuf_sz) {
@@ -244,9 +555,25 @@ void Audio::initInBuff() {
             AUDIO_INFO(sprintf(chbuf, "PSRAM %sfound, inputBufferSize: %u bytes", InBuff.havePSRAM()?"":"not ", size - 1);)
         }
     }
+    else InBuff.setMaxFrameSizeRAM(0); // back to the default size if it was enlarged for FLAC
     changeMaxBlockSize(1600); // default size mp3 or aac
 }
 
+bool Audio::setFLACInBuff(size_t maxFrameSize) {
+    // With PSRAM the input buffer reserves m_frameSizeFLAC bytes. Without PSRAM the RAM buffer is enlarged for one
+    // frame, maxFrameSize (from STREAMINFO, 0 if unknown) keeps it small. Peak RAM without PSRAM:
+    // input buffer 2 * framesize + 4096 (55KB, or 30KB for a 12KB maxFrameSize), decoder 252 bytes + blocksize * 8
+    // (stereo, 32KB for 4096 samples per block)
+    size_t fs = m_frameSizeFLAC;
+    if(!InBuff.havePSRAM() && maxFrameSize && maxFrameSize + 1024 < fs) fs = (maxFrameSize + 1024 + 1023) & ~1023;
+    if(!InBuff.setMaxFrameSizeRAM(fs)){
+        if(audio_info) audio_info("not enough RAM for FLAC");
+        return false;
+    }
+    InBuff.changeMaxBlockSize(fs);
+    return true;
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 esp_err_t Audio::I2Sstart(uint8_t i2s_num) {
     // It is not necessary to call this function after i2s_driver_install() (it is started automatically),
@@ -291,17 +618,28 @@ Audio::~Audio() {
     //InBuff.~AudioBuffer(); #215 the AudioBuffer is automatically destroyed by the destructor
     setDefaults();
     if(m_playlistBuff) {free(m_playlistBuff); m_playlistBuff = NULL;}
+    if(m_streamProfiles) {free(m_streamProfiles); m_streamProfiles = NULL;}
+    if(m_stationUrl) {free(m_stationUrl); m_stationUrl = NULL;}
+    if(m_stationUser) {free(m_stationUser); m_stationUser = NULL;}
+    if(m_stationPwd) {free(m_stationPwd); m_stationPwd = NULL;}
     i2s_driver_uninstall((i2s_port_t)m_i2s_num); // #215 free I2S buffer
+    ArenaFree(chbuf);      chbuf = NULL;
+    ArenaFree(m_lastHost); m_lastHost = NULL;
+    ArenaFree(m_outBuff);  m_outBuff = NULL;
+    ArenaDestroy(); // if no other Audio object uses it
 }
 //---------------------------------------------------------------------------------------------------------------------
 void Audio::setDefaults() {
     stopSong();
     initInBuff(); // initialize InputBuffer if not already done
     InBuff.resetBuffer();
-    MP3Decoder_FreeBuffers();
-    FLACDecoder_FreeBuffers();
-    if(!m_f_m3u8data) AACDecoder_FreeBuffers();
+    for(int i = 0; codecPlugins[i]; i++){
+        if(m_f_m3u8data && codecPlugins[i] == m_plugin) continue; // m3u8: keep the decoder for the next chunk
+        releaseDecoder(codecPlugins[i]);
+    }
     if(!m_f_m3u8data) if(m_playlistBuff) {free(m_playlistBuff); m_playlistBuff = NULL;} // free if not m3u8
+    if(m_flacSeekTable) {free(m_flacSeekTable); m_flacSeekTable = NULL;}
+    if(m_ogg) {OggDemuxer_Destroy(m_ogg); m_ogg = NULL;}
     client.stop();
     client.flush(); // release memory
     clientsecure.stop();
@@ -309,7 +647,9 @@ void Audio::setDefaults() {
     _client = static_cast<WiFiClient*>(&clientsecure); /* default to *something* so that no NULL deref can happen */
     playI2Sremains();
 
-    AUDIO_INFO(sprintf(chbuf, "buffers freed, free Heap: %u bytes", ESP.getFreeHeap());)
+    AUDIO_INFO(memStats_t ms; getMemStats(&ms);
+               sprintf(chbuf, "buffers freed, free Heap: %u bytes, largest block: %u bytes, fragmentation: %u%%",
+                       ms.heapFree, ms.heapLargest, ms.heapFragmentation);)
 
     m_f_chunked = false;                                    // Assume not chunked
     m_f_ctseen = false;                                     // Contents type not seen yet
@@ -327,10 +667,12 @@ void Audio::setDefaults() {
     m_f_unsync = false;                                     // set within ID3 tag but not used
     m_f_exthdr = false;                                     // ID3 extended header
     m_f_rtsp = false;                                       // RTSP (m3u8)stream
+    resetPipelineState();                                   // before m_f_m3u8data is cleared
     m_f_m3u8data = false;                                   // set again in processM3U8entries() if necessary
     m_f_Log = true;                                         // logging always allowed
 
     m_codec = CODEC_NONE;
+    m_plugin = NULL;
     m_playlistFormat = FORMAT_NONE;
     m_datamode = AUDIO_NONE;
     m_audioCurrentTime = 0;                                 // Reset playtimer
@@ -338,6 +680,14 @@ void Audio::setDefaults() {
     m_audioDataStart = 0;
     m_audioDataSize = 0;
     m_avr_bitrate = 0;                                      // the same as m_bitrate if CBR, median if VBR
+    m_flacSeekPoints = 0;
+    m_flacSamplesToSkip = 0;
+    m_flacTotalSamplesInStream = 0;
+    m_decodeQuality = m_decodeQualityMin;                   // the load is measured again for the next stream
+    m_decodeUs = 0;
+    m_decodeSamples = 0;
+    m_armedCodec = CODEC_NONE;                              // nothing prepared by preArmStreamProfile()
+    m_f_i2sArmed = false;
     m_bitRate = 0;                                          // Bitrate still unknown
     m_bytesNotDecoded = 0;                                  // counts all not decodable bytes
     m_chunkcount = 0;                                       // for chunked streams
@@ -345,6 +695,8 @@ void Audio::setDefaults() {
     m_curSample = 0;
     m_metaint = 0;                                          // No metaint yet
     m_LFcount = 0;                                          // For end of header detection
+    m_hdrLen = 0;                                           // nothing received yet
+    m_hdrPos = 0;
     m_controlCounter = 0;                                   // Status within readID3data() and readWaveHeader()
     m_channels = 2;                                         // assume stereo #209
     m_streamTitleHash = 0;
@@ -355,6 +707,17 @@ void Audio::setDefaults() {
     //TEST loop
 }
 //---------------------------------------------------------------------------------------------------------------------
+void Audio::resetPipelineState() {
+    // everything the stream readers, header parsers and decoders remember from one call to the next, per connection.
+    // The sequence of a m3u8 playlist goes on over the connections to its chunks.
+    m_rx = rxState_t();
+    m_dec = decState_t();
+    m_meta = metaState_t();
+    m_fileHdr = fileHdrState_t();
+    m_pls = plsState_t();
+    if(!m_f_m3u8data) m_m3u8 = m3u8State_t();
+}
+//---------------------------------------------------------------------------------------------------------------------
 void Audio::httpPrint(const char* url) {
 
     // call to a new subdomain or if no connection is present connect first
@@ -403,6 +766,7 @@ void Audio::httpPrint(const char* url) {
         if(m_f_m3u8data && m_playlistBuff) strcpy(m_playlistBuff, url); // save new m3u8 chunklist
     }
     _client->print(resp);
+    m_openTime = millis();
 
     if(host)      {free(host);      host = NULL;}
 
@@ -419,10 +783,35 @@ void Audio::setConnectionTimeout(uint16_t timeout_ms, uint16_t timeout_ms_ssl){
 //---------------------------------------------------------------------------------------------------------------------
 bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
     // user and pwd for authentification only, can be empty
+    // the station is identified by the given url, redirects and playlists are resolved by openStream()
+
+    m_stationHash = simpleHash(host);
+    m_connectTime = millis();
+    m_f_endpointCached = false;
+    if(m_stationUrl) {free(m_stationUrl); m_stationUrl = NULL;}
+    m_stationUrl = strdup(host);
+    if(m_stationUser) {free(m_stationUser); m_stationUser = NULL;}
+    m_stationUser = strdup(user);
+    if(m_stationPwd) {free(m_stationPwd); m_stationPwd = NULL;}
+    m_stationPwd = strdup(pwd);
+
+    const char* endpoint = cachedEndpoint();
+    if(endpoint){ // skip redirects and playlists, resolve again if the endpoint is gone
+        AUDIO_INFO(sprintf(chbuf, "use cached endpoint \"%s\"", endpoint);)
+        m_f_endpointCached = true;
+        if(openStream(endpoint, user, pwd)) return true;
+        m_f_endpointCached = false;
+        m_connectTime = millis();
+    }
+    return openStream(host, user, pwd);
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::openStream(const char* host, const char* user, const char* pwd) {
 
     char* l_host = NULL; // local copy of host
     char* h_host = NULL; // pointer of l_host without http:// or https://
 
+    m_openTime = millis();
 
     if(strlen(host) == 0) {
         if(audio_info) audio_info("Hostaddress is empty");
@@ -554,6 +943,7 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
         uint32_t dt = millis() - t;
         AUDIO_INFO(sprintf(chbuf, "%s has been established in %u ms, free Heap: %u bytes", m_f_ssl?"SSL":"Connection", dt, ESP.getFreeHeap());)
         strcpy(m_lastHost, l_host);
+        if(m_datamode == AUDIO_HEADER) preArmStreamProfile(); // while the server prepares its response
         m_f_running = true;
         if(hostwoext) {free(hostwoext); hostwoext = NULL;}
         if(extension) {free(extension); extension = NULL;}
@@ -573,6 +963,207 @@ bool Audio::connecttohost(const char* host, const char* user, const char* pwd) {
     return false;
 }
 //---------------------------------------------------------------------------------------------------------------------
+bool Audio::loadStreamProfiles(){
+    // the table is read once from NVS, slot i is stored under the key "sp<i>"
+    if(m_streamProfiles) return true;
+    m_streamProfiles = (streamProfile_t*)calloc(STREAM_PROFILES, sizeof(streamProfile_t));
+    if(!m_streamProfiles) return false;
+    Preferences prefs;
+    if(!prefs.begin("audioI2S", true)) return true; // nothing stored yet
+    char key[8];
+    for(int i = 0; i < STREAM_PROFILES; i++){
+        sprintf(key, "sp%i", i);
+        if(prefs.getBytesLength(key) != sizeof(streamProfile_t)) continue; // missing or from another layout
+        prefs.getBytes(key, &m_streamProfiles[i], sizeof(streamProfile_t));
+        m_streamProfiles[i].resolvedUrl[sizeof(m_streamProfiles[i].resolvedUrl) - 1] = '\0';
+    }
+    prefs.end();
+    return true;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::clearStreamProfiles(){
+    if(m_streamProfiles) memset(m_streamProfiles, 0, STREAM_PROFILES * sizeof(streamProfile_t));
+    m_profileSlot = -1;
+    Preferences prefs;
+    if(prefs.begin("audioI2S", false)){
+        prefs.clear();
+        prefs.end();
+    }
+}
+//---------------------------------------------------------------------------------------------------------------------
+Audio::streamProfile_t* Audio::findStreamProfile(){
+    if(!m_stationHash || !loadStreamProfiles()) return NULL;
+    for(int i = 0; i < STREAM_PROFILES; i++){
+        if(m_streamProfiles[i].urlHash == m_stationHash) return &m_streamProfiles[i];
+    }
+    return NULL;
+}
+//---------------------------------------------------------------------------------------------------------------------
+const char* Audio::cachedEndpoint(){
+    // the final url of a station behind redirects or playlists, NULL if unknown or older than ENDPOINT_TTL
+    // without a synchronized clock the age is unknown, the entry is used and replaced if it fails
+    streamProfile_t* sp = findStreamProfile();
+    if(!sp || !sp->resolvedUrl[0]) return NULL;
+    time_t now = time(NULL);
+    if(sp->resolvedTime && now > 1600000000 && (uint32_t)(now - sp->resolvedTime) > ENDPOINT_TTL) {
+        AUDIO_INFO(sprintf(chbuf, "cached endpoint expired, resolve \"%s\" again", m_stationUrl);)
+        return NULL;
+    }
+    return sp->resolvedUrl;
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::retryWithoutCachedEndpoint(){
+    // the cached endpoint answered with an error, forget it and resolve the station url as usual
+    if(!m_f_endpointCached || !m_stationUrl) return false;
+    m_f_endpointCached = false;
+    streamProfile_t* sp = findStreamProfile();
+    if(sp) sp->resolvedUrl[0] = '\0'; // stored again with the next successful resolution
+    AUDIO_INFO(sprintf(chbuf, "cached endpoint failed, resolve \"%s\" again", m_stationUrl);)
+    m_connectTime = millis();
+    char* url = strdup(m_stationUrl);
+    bool res = openStream(url, m_stationUser ? m_stationUser : "", m_stationPwd ? m_stationPwd : "");
+    free(url);
+    return res;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::getEndpointCacheStats(uint32_t* hits, uint32_t* misses, uint32_t* savedMs){
+    if(hits)    *hits    = m_endpointHits;
+    if(misses)  *misses  = m_endpointMisses;
+    if(savedMs) *savedMs = m_endpointSavedMs;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::getStreamProfileStats(uint32_t* hits, uint32_t* misses, uint32_t* hitMs, uint32_t* missMs){
+    // number of webstream starts with and without a stored profile, mean ms from connecttohost() to the first frame
+    if(hits)   *hits   = m_profileHits;
+    if(misses) *misses = m_profileMisses;
+    if(hitMs)  *hitMs  = m_profileHits   ? m_profileHitMs   / m_profileHits   : 0;
+    if(missMs) *missMs = m_profileMisses ? m_profileMissMs / m_profileMisses : 0;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::preArmStreamProfile(){
+    // A station usually sends the same format every time. Allocate its decoder and set the I2S clock while the
+    // server prepares the response, the first frame then goes straight to the DMA buffer.
+    streamProfile_t* sp = findStreamProfile();
+    if(!sp) return;
+    const codecPlugin_t* p = findCodecPlugin(sp->codec);
+    if(!p || !initDecoder(p)) return;
+
+    m_armedCodec = sp->codec;
+    setChannels(sp->channels);
+    setBitsPerSample(sp->bitsPerSample);
+    setBitrate(sp->bitRate);
+    setSampleRate(sp->sampleRate);
+    m_f_i2sArmed = true; // the first setSampleRate() with the same value has nothing to do
+    AUDIO_INFO(sprintf(chbuf, "stream profile found, codec %i, %u Hz, %u ch, free Heap: %u bytes",
+                        sp->codec, sp->sampleRate, sp->channels, ESP.getFreeHeap());)
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::updateStreamProfile(){
+    // called with the first decoded frame of a webstream, learns or corrects the profile of the station in RAM.
+    // The NVS write stalls the flash cache, storeStreamProfile() does it later from loop() or stopSong()
+    auto family = [](uint8_t codec){return codec == CODEC_M4A ? (uint8_t)CODEC_AAC : codec;};
+
+    if(!m_stationHash || m_f_tts || m_f_webfile || m_f_m3u8data) return;
+    if(m_codec != CODEC_MP3 && m_codec != CODEC_AAC && m_codec != CODEC_M4A && m_codec != CODEC_FLAC) return;
+
+    if(!m_connectTime) return; // profile is already updated
+    uint32_t firstFrame = millis() - m_connectTime;
+    if(m_armedCodec != CODEC_NONE) {m_profileHits++;   m_profileHitMs  += firstFrame;}
+    else                           {m_profileMisses++; m_profileMissMs += firstFrame;}
+    AUDIO_INFO(sprintf(chbuf, "first frame decoded %u ms after connecttohost(), stream profile %s",
+                        firstFrame, m_armedCodec != CODEC_NONE ? "hit" : "miss");)
+    uint32_t resolveTime = m_openTime - m_connectTime; // redirects and playlists before the last openStream()
+    m_connectTime = 0;
+    if(!loadStreamProfiles()) return;
+
+    // compare without scheme, connecttohost() accepts urls without "http://"
+    auto skipScheme = [this](const char* url){
+        if(startsWith(url, "https://")) return url + 8;
+        if(startsWith(url, "http://"))  return url + 7;
+        return url;
+    };
+    bool indirect = m_stationUrl && strcmp(skipScheme(m_lastHost), skipScheme(m_stationUrl));
+
+    int slot = 0;
+    uint32_t maxUse = 0;
+    for(int i = 0; i < STREAM_PROFILES; i++){ // the own slot, otherwise the least recently used one
+        if(m_streamProfiles[i].urlHash == m_stationHash) {slot = i; break;}
+        if(m_streamProfiles[i].lastUse < m_streamProfiles[slot].lastUse) slot = i;
+    }
+    for(int i = 0; i < STREAM_PROFILES; i++){
+        if(m_streamProfiles[i].lastUse > maxUse) maxUse = m_streamProfiles[i].lastUse;
+    }
+    streamProfile_t* sp = &m_streamProfiles[slot];
+    streamProfile_t np;
+    memset(&np, 0, sizeof(np));
+    np.urlHash       = m_stationHash;
+    np.sampleRate    = getSampleRate();
+    np.bitRate       = getBitRate();
+    np.metaint       = m_metaint;
+    np.lastUse       = sp->lastUse;
+    np.codec         = m_codec;
+    np.channels      = getChannels();
+    np.bitsPerSample = getBitsPerSample();
+    if(indirect && strlen(m_lastHost) < sizeof(np.resolvedUrl)) strcpy(np.resolvedUrl, m_lastHost);
+    if(m_f_endpointCached){ // keep the time of the real resolution, otherwise the entry never expires
+        m_f_endpointCached = false;
+        m_endpointHits++;
+        m_endpointSavedMs += sp->resolveTime;
+        np.resolvedTime = sp->resolvedTime;
+        np.resolveTime  = sp->resolveTime;
+        AUDIO_INFO(sprintf(chbuf, "endpoint cache hit, %u ms saved (hits %u, misses %u, %u ms saved)",
+                            sp->resolveTime, m_endpointHits, m_endpointMisses, m_endpointSavedMs);)
+    }
+    else if(indirect){
+        if(sp->urlHash == m_stationHash) m_endpointMisses++; // expired or failed, the first contact is no miss
+        np.resolvedTime = (time(NULL) > 1600000000) ? time(NULL) : 0;
+        np.resolveTime  = resolveTime;
+    }
+
+    if(sp->urlHash == m_stationHash){
+        if(family(sp->codec) != family(np.codec) || sp->sampleRate != np.sampleRate || sp->channels != np.channels ||
+           sp->bitsPerSample != np.bitsPerSample || sp->metaint != np.metaint){
+            AUDIO_INFO(sprintf(chbuf, "stream profile mismatch, codec %i->%i, %u->%u Hz, %u->%u ch, metaint %u->%u",
+                                sp->codec, np.codec, sp->sampleRate, np.sampleRate, sp->channels, np.channels,
+                                sp->metaint, np.metaint);)
+        }
+    }
+    sp->lastUse = maxUse + 1; // RAM only, the order of use is not worth a NVS write
+    np.lastUse  = sp->lastUse;
+    if(sp->urlHash == m_stationHash && sp->codec == np.codec && sp->sampleRate == np.sampleRate &&
+       sp->channels == np.channels && sp->bitsPerSample == np.bitsPerSample && sp->metaint == np.metaint &&
+       !strcmp(sp->resolvedUrl, np.resolvedUrl) && sp->resolvedTime == np.resolvedTime &&
+       sp->resolveTime == np.resolveTime) return; // bitrate alone may vary (VBR), nothing to store
+
+    memcpy(sp, &np, sizeof(streamProfile_t));
+    m_profileSlot = slot;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::storeStreamProfile(){
+    // writes the profile learned by updateStreamProfile() to NVS, once the input buffer has a reserve or the
+    // connection stops
+    if(m_profileSlot < 0 || !m_streamProfiles) return;
+    char key[8];
+    sprintf(key, "sp%i", m_profileSlot);
+    Preferences prefs;
+    if(prefs.begin("audioI2S", false)){
+        prefs.putBytes(key, &m_streamProfiles[m_profileSlot], sizeof(streamProfile_t));
+        prefs.end();
+    }
+    m_profileSlot = -1;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::releaseArmedDecoder(){
+    // the content-type differs from the stored profile, don't keep the prepared decoder
+    if(m_armedCodec == CODEC_NONE) return;
+    const codecPlugin_t* armed = findCodecPlugin(m_armedCodec);
+    if(armed == m_plugin) return;
+    AUDIO_INFO(sprintf(chbuf, "stream profile mismatch, content-type is not codec %i", m_armedCodec);)
+    if(armed) releaseDecoder(armed);
+    m_armedCodec = CODEC_NONE;
+    m_f_i2sArmed = false;
+}
+//---------------------------------------------------------------------------------------------------------------------
 bool Audio::setFileLoop(bool input){
     m_f_loop = input;
     return input;
@@ -668,7 +1259,7 @@ bool Audio::connecttoFS(fs::FS &fs, const char* path, uint32_t resumeFilePos) {
     char* afn = NULL;  // audioFileName
 
 #ifdef SDFATFS_USED
-    audiofile.getName(chbuf, sizeof(chbuf));
+    audiofile.getName(chbuf, CHBUF_SIZE);
     afn = strdup(chbuf);
 #else
     afn = strdup(audiofile.name());
@@ -679,40 +1270,6 @@ bool Audio::connecttoFS(fs::FS &fs, const char* path, uint32_t resumeFilePos) {
         afn[i] = toLowerCase(afn[i]);
     }
 
-    if(endsWith(afn, ".mp3")){      // MP3 section
-        free(afn);
-        m_codec = CODEC_MP3;
-        if(!MP3Decoder_AllocateBuffers()){audiofile.close(); return false;}
-        InBuff.changeMaxBlockSize(m_frameSizeMP3);
-        AUDIO_INFO(sprintf(chbuf, "MP3Decoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-        m_f_running = true;
-        return true;
-    } // end MP3 section
-
-    if(endsWith(afn, ".m4a")){      // M4A section, iTunes
-        free(afn);
-        m_codec = CODEC_M4A;
-        if(!AACDecoder_IsInit()){
-            if(!AACDecoder_AllocateBuffers()) {m_f_running = false; stopSong(); return false;}
-            AUDIO_INFO(sprintf(chbuf, "AACDecoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-            InBuff.changeMaxBlockSize(m_frameSizeAAC);
-        };
-        m_f_running = true;
-        return true;
-    } // end M4A section
-
-    if(endsWith(afn, ".aac")){      // AAC section, without FileHeader
-        free(afn);
-        m_codec = CODEC_AAC;
-        if(!AACDecoder_IsInit()){
-            if(!AACDecoder_AllocateBuffers()) {m_f_running = false; stopSong(); return false;}
-            AUDIO_INFO(sprintf(chbuf, "AACDecoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-            InBuff.changeMaxBlockSize(m_frameSizeAAC);
-        }
-        m_f_running = true;
-        return true;
-    } // end AAC section
-
     if(endsWith(afn, ".wav")){      // WAVE section
         free(afn);
         m_codec = CODEC_WAV;
@@ -721,20 +1278,21 @@ bool Audio::connecttoFS(fs::FS &fs, const char* path, uint32_t resumeFilePos) {
         return true;
     } // end WAVE section
 
-    if(endsWith(afn, ".flac")) {     // FLAC section
+    if(endsWith(afn, ".ogg") || endsWith(afn, ".oga")) {     // OGG section, the codec is found in the first packet
         free(afn);
-        m_codec = CODEC_FLAC;
-        if(!psramFound()){
-            if(audio_info) audio_info("FLAC works only with PSRAM!");
-            m_f_running = false;
-            return false;
-        }
-        if(!FLACDecoder_AllocateBuffers()){audiofile.close(); return false;}
-        InBuff.changeMaxBlockSize(m_frameSizeFLAC);
-        AUDIO_INFO(sprintf(chbuf, "FLACDecoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
+        m_codec = CODEC_OGG;
+        if(!initOggDemuxer()){audiofile.close(); return false;}
         m_f_running = true;
         return true;
-    } // end FLAC section
+    } // end OGG section
+
+    uint8_t codec = strchr(afn, '.') ? probeCodec(strrchr(afn, '.') + 1) : (uint8_t)CODEC_NONE; // mp3, aac, m4a, flac
+    if(codec != CODEC_NONE){
+        free(afn);
+        if(!selectCodec(codec)){audiofile.close(); return false;}
+        m_f_running = true;
+        return true;
+    }
 
     AUDIO_INFO(sprintf(chbuf, "The %s format is not supported", afn + dotPos);)
     audiofile.close();
@@ -931,7 +1489,7 @@ void Audio::showID3Tag(const char* tag, const char* value){
     if(!strcmp(tag, "WOAR")) sprintf(chbuf, "OfficialArtistWebpage: %s", value);
     if(!strcmp(tag, "XDOR")) sprintf(chbuf, "OriginalReleaseTime: %s", value);
 
-    latinToUTF8(chbuf, sizeof(chbuf));
+    latinToUTF8(chbuf, CHBUF_SIZE);
     if(chbuf[0] != 0) if(audio_id3data) audio_id3data(chbuf);
 }
 //---------------------------------------------------------------------------------------------------------------------
@@ -1043,9 +1601,9 @@ bool Audio::latinToUTF8(char* buff, size_t bufflen){
 }
 //---------------------------------------------------------------------------------------------------------------------
 int Audio::read_WAV_Header(uint8_t* data, size_t len) {
-    static size_t headerSize;
-    static uint32_t cs = 0;
-    static uint8_t bts = 0;
+    size_t&   headerSize = m_fileHdr.wav.headerSize;
+    uint32_t& cs         = m_fileHdr.wav.cs;
+    uint8_t&  bts        = m_fileHdr.wav.bts;
 
     if(m_controlCounter == 0){
         m_controlCounter ++;
@@ -1183,9 +1741,12 @@ int Audio::read_WAV_Header(uint8_t* data, size_t len) {
 }
 //---------------------------------------------------------------------------------------------------------------------
 int Audio::read_FLAC_Header(uint8_t *data, size_t len) {
-    static size_t headerSize;
-    static size_t retvalue;
-    static bool   f_lastMetaBlock;
+    size_t&   headerSize      = m_fileHdr.flac.headerSize;
+    size_t&   retvalue        = m_fileHdr.flac.retvalue;
+    bool&     f_lastMetaBlock = m_fileHdr.flac.f_lastMetaBlock;
+    size_t&   seekBytesLeft   = m_fileHdr.flac.seekBytesLeft;
+    uint16_t& seekPointNr     = m_fileHdr.flac.seekPointNr;
+    uint16_t& seekStride      = m_fileHdr.flac.seekStride;
 
     if(retvalue) {
         if(retvalue > len) { // if returnvalue > bufferfillsize
@@ -1206,6 +1767,8 @@ int Audio::read_FLAC_Header(uint8_t *data, size_t len) {
         retvalue = 0;
         m_audioDataStart = 0;
         f_lastMetaBlock = false;
+        if(m_flacSeekTable) {free(m_flacSeekTable); m_flacSeekTable = NULL;}
+        m_flacSeekPoints = 0;
         m_controlCounter = FLAC_MAGIC;
         if(m_f_localfile){
             m_contentlength = getFileSize();
@@ -1254,49 +1817,13 @@ int Audio::read_FLAC_Header(uint8_t *data, size_t len) {
     if(m_controlCounter == FLAC_SINFO) { /* Stream info block */
         size_t l = bigEndian(data, 3);
         vTaskDelay(2);
-        m_flacMaxBlockSize = bigEndian(data + 5, 2);
-        AUDIO_INFO(sprintf(chbuf, "FLAC maxBlockSize: %u", m_flacMaxBlockSize);)
-        vTaskDelay(2);
-        m_flacMaxFrameSize = bigEndian(data + 10, 3);
-        if(m_flacMaxFrameSize){
-            AUDIO_INFO(sprintf(chbuf, "FLAC maxFrameSize: %u", m_flacMaxFrameSize);)
-        }
-        else {
-            if(audio_info) audio_info("FLAC maxFrameSize: N/A");
-        }
+        if(!parseFLACStreamInfo(data)) {stopSong(); return -1;}
         if(m_flacMaxFrameSize > InBuff.getMaxBlockSize()) {
             log_e("FLAC maxFrameSize too large!");
             stopSong();
             return -1;
         }
-//        InBuff.changeMaxBlockSize(m_flacMaxFrameSize);
-        vTaskDelay(2);
-        uint32_t nextval = bigEndian(data + 13, 3);
-        m_flacSampleRate = nextval >> 4;
-        AUDIO_INFO(sprintf(chbuf, "FLAC sampleRate: %u", m_flacSampleRate);)
-        vTaskDelay(2);
-        m_flacNumChannels = ((nextval & 0x06) >> 1) + 1;
-        AUDIO_INFO(sprintf(chbuf, "FLAC numChannels: %u", m_flacNumChannels);)
-        vTaskDelay(2);
-        uint8_t bps = (nextval & 0x01) << 4;
-        bps += (*(data +16) >> 4) + 1;
-        m_flacBitsPerSample = bps;
-        if((bps != 8) && (bps != 16)){
-            log_e("bits per sample must be 8 or 16, is %i", bps);
-            stopSong();
-            return -1;
-        }
-        AUDIO_INFO(sprintf(chbuf, "FLAC bitsPerSample: %u", m_flacBitsPerSample);)
-        m_flacTotalSamplesInStream = bigEndian(data + 17, 4);
-        if(m_flacTotalSamplesInStream){
-            AUDIO_INFO(sprintf(chbuf, "total samples in stream: %u", m_flacTotalSamplesInStream);)
-        }
-        else{
-            if(audio_info) audio_info("total samples in stream: N/A");
-        }
-        if(bps != 0 && m_flacTotalSamplesInStream) {
-            AUDIO_INFO(sprintf(chbuf, "audio file duration: %u seconds", m_flacTotalSamplesInStream / m_flacSampleRate);)
-        }
+        if(!InBuff.havePSRAM() && m_flacMaxFrameSize) setFLACInBuff(m_flacMaxFrameSize); // smaller RAM buffer
         m_controlCounter = FLAC_MBH; // METADATA_BLOCK_HEADER
         retvalue = l + 3;
         headerSize += retvalue;
@@ -1320,13 +1847,49 @@ int Audio::read_FLAC_Header(uint8_t *data, size_t len) {
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_SEEK) { /* SEEKTABLE */
+        const uint16_t maxSeekPoints = 256;                 // 8 bytes each, long tables are thinned out
         size_t l = bigEndian(data, 3);
-        m_controlCounter = FLAC_MBH;
-        retvalue = l + 3;
+        uint32_t n = l / 18;                                // 18 bytes per seekpoint
+        seekStride = (n + maxSeekPoints - 1) / maxSeekPoints;
+        if(!seekStride) seekStride = 1;
+        seekPointNr = 0;
+        seekBytesLeft = l;
+        if(m_flacSeekTable) {free(m_flacSeekTable); m_flacSeekTable = NULL;}
+        m_flacSeekPoints = 0;
+        if(n) m_flacSeekTable = (flacSeekPoint_t*)malloc(((n + seekStride - 1) / seekStride) * sizeof(flacSeekPoint_t));
+        if(!m_flacSeekTable) log_e("no memory for FLAC seektable, seeking will be slow");
+        m_controlCounter = FLAC_SEEKPOINTS;
+        retvalue = 3;
         headerSize += retvalue;
         return 0;
     }
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    if(m_controlCounter == FLAC_SEEKPOINTS) { /* SEEKTABLE, the points can span several calls */
+        size_t l = seekBytesLeft;
+        if(l > len) l = len;
+        if(l < 18 && seekBytesLeft >= 18) return 0;         // wait until a whole seekpoint is in the buffer
+        if(l >= 18) l -= l % 18;                            // else a malformed rest of < 18 bytes, skipped
+        for(size_t i = 0; i + 18 <= l; i += 18, seekPointNr++){
+            if(!m_flacSeekTable) break;
+            if(seekPointNr % seekStride) continue;
+            uint32_t sampleHi = bigEndian(data + i, 4);
+            uint32_t offsetHi = bigEndian(data + i + 8, 4);
+            if(sampleHi || offsetHi) continue;              // placeholder point (0xFFFFFFFFFFFFFFFF) or > 32 bit
+            uint32_t sample = bigEndian(data + i + 4, 4);
+            if(m_flacSeekPoints && sample <= m_flacSeekTable[m_flacSeekPoints - 1].sample) continue;
+            m_flacSeekTable[m_flacSeekPoints].sample = sample;
+            m_flacSeekTable[m_flacSeekPoints].offset = bigEndian(data + i + 12, 4);
+            m_flacSeekPoints++;
+        }
+        seekBytesLeft -= l;
+        headerSize += l;
+        if(!seekBytesLeft){
+            m_controlCounter = FLAC_MBH;
+            AUDIO_INFO(sprintf(chbuf, "FLAC seekpoints: %u", m_flacSeekPoints);)
+        }
+        return l;
+    }
+    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == FLAC_VORBIS) { /* VORBIS COMMENT */                          // field names
         const char fn[7][12] = {"TITLE", "VERSION", "ALBUM", "TRACKNUMBER", "ARTIST", "PERFORMER", "GENRE"};
         int offset;
@@ -1369,17 +1932,17 @@ int Audio::read_FLAC_Header(uint8_t *data, size_t len) {
 //---------------------------------------------------------------------------------------------------------------------
 int Audio::read_MP3_Header(uint8_t *data, size_t len) {
 
-    static size_t id3Size;
-    static size_t headerSize;
-    static uint8_t ID3version;
-    static int ehsz = 0;
-    static char tag[5];
-    static char frameid[5];
-    static size_t framesize = 0;
-    static bool compressed = false;
-    static bool APIC_seen = false;
-    static size_t APIC_size = 0;
-    static uint32_t APIC_pos = 0;
+    size_t&   id3Size    = m_fileHdr.id3.id3Size;
+    size_t&   headerSize = m_fileHdr.id3.headerSize;
+    uint8_t&  ID3version = m_fileHdr.id3.ID3version;
+    int&      ehsz       = m_fileHdr.id3.ehsz;
+    char*     tag        = m_fileHdr.id3.tag;
+    char*     frameid    = m_fileHdr.id3.frameid;
+    size_t&   framesize  = m_fileHdr.id3.framesize;
+    bool&     compressed = m_fileHdr.id3.compressed;
+    bool&     APIC_seen  = m_fileHdr.id3.APIC_seen;
+    size_t&   APIC_size  = m_fileHdr.id3.APIC_size;
+    uint32_t& APIC_pos   = m_fileHdr.id3.APIC_pos;
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_controlCounter == 0){      /* read ID3 tag and ID3 header size */
         if(m_f_localfile){
@@ -1632,10 +2195,10 @@ int Audio::read_M4A_Header(uint8_t *data, size_t len) {
        mdat contains the audio data                                                      */
 
 
-    static size_t headerSize = 0;
-    static size_t retvalue = 0;
-    static size_t atomsize = 0;
-    static size_t audioDataPos = 0;
+    size_t&   headerSize   = m_fileHdr.m4a.headerSize;
+    size_t&   retvalue     = m_fileHdr.m4a.retvalue;
+    size_t&   atomsize     = m_fileHdr.m4a.atomsize;
+    size_t&   audioDataPos = m_fileHdr.m4a.audioDataPos;
 
     if(retvalue) {
         if(retvalue > len) { // if returnvalue > bufferfillsize
@@ -1879,210 +2442,178 @@ int Audio::read_M4A_Header(uint8_t *data, size_t len) {
     return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
-int Audio::read_OGG_Header(uint8_t *data, size_t len){
-    static size_t retvalue = 0;
-    static size_t pageLen = 0;
-    static bool   f_firstPacket = false;
-
-    if(retvalue) {
-        if(retvalue > len) { // if returnvalue > bufferfillsize
-            if(len > InBuff.getMaxBlockSize()) len = InBuff.getMaxBlockSize();
-            retvalue -= len; // and wait for more bufferdata
-            return len;
-        }
-        else {
-            size_t tmp = retvalue;
-            retvalue = 0;
-            return tmp;
-        }
-        return 0;
+bool Audio::parseFLACStreamInfo(uint8_t* data){
+    // data: length field of the STREAMINFO block header, in a FLAC file or in the first packet of Ogg FLAC
+    m_flacMaxBlockSize = bigEndian(data + 5, 2);
+    AUDIO_INFO(sprintf(chbuf, "FLAC maxBlockSize: %u", m_flacMaxBlockSize);)
+    vTaskDelay(2);
+    m_flacMaxFrameSize = bigEndian(data + 10, 3);
+    if(m_flacMaxFrameSize){
+        AUDIO_INFO(sprintf(chbuf, "FLAC maxFrameSize: %u", m_flacMaxFrameSize);)
     }
-    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_controlCounter == OGG_BEGIN) {  // init
-        retvalue = 0;
-        m_audioDataStart = 0;
-        f_firstPacket = true;
-        m_controlCounter = OGG_MAGIC;
-        if(m_f_localfile){
-            m_contentlength = getFileSize();
-            AUDIO_INFO(sprintf(chbuf, "Content-Length: %u", m_contentlength);)
-        }
-        return 0;
+    else {
+        if(audio_info) audio_info("FLAC maxFrameSize: N/A");
+    }
+    vTaskDelay(2);
+    uint32_t nextval = bigEndian(data + 13, 3);
+    m_flacSampleRate = nextval >> 4;
+    AUDIO_INFO(sprintf(chbuf, "FLAC sampleRate: %u", m_flacSampleRate);)
+    vTaskDelay(2);
+    m_flacNumChannels = ((nextval & 0x06) >> 1) + 1;
+    AUDIO_INFO(sprintf(chbuf, "FLAC numChannels: %u", m_flacNumChannels);)
+    if(m_flacNumChannels != 1 && m_flacNumChannels != 2){
+        if(audio_info) audio_info("numChannels must be 1 or 2");
+        return false;
     }
-    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_controlCounter == OGG_MAGIC) { /* check MAGIC STRING */
-        if(specialIndexOf(data, "OggS", 10) != 0) {
-            log_e("Magic String 'OggS' not found in header");
-            stopSong();
-            return -1;
-        }
-        m_controlCounter = OGG_HEADER;
-        retvalue = 4;
-        return 0;
+    vTaskDelay(2);
+    uint8_t bps = (nextval & 0x01) << 4;
+    bps += (*(data +16) >> 4) + 1;
+    m_flacBitsPerSample = bps;
+    if(bps < 8 || bps > 24){
+        log_e("bits per sample must be 8...24, is %i", bps);
+        return false;
     }
-    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_controlCounter == OGG_HEADER) { /* check OGG PAGE HEADER */
-        uint8_t i = 0;
-        uint8_t ssv = *(data + i);                  // stream_structure_version
-        (void)ssv;
-        i++;
-        uint8_t htf = *(data + i);                  // header_type_flag
-        (void)htf;
-        i++;
-        uint32_t tmp = bigEndian(data + i, 4);      // absolute granule position
-        uint64_t agp = (uint64_t) tmp << 32;
-        i += 4;
-        agp += bigEndian(data + i, 4);
-        i += 4;
-        uint32_t ssnr = bigEndian(data + i, 4);     // stream serial number
-        (void)ssnr;
-        i += 4;
-        uint32_t psnr = bigEndian(data + i, 4);     // page sequence no
-        (void)psnr;
-        i += 4;
-        uint32_t pchk = bigEndian(data + i, 4);     // page checksum
-        (void)pchk;
-        i += 4;
-        uint8_t psegm = *(data + i);
-        i++;
-        uint8_t psegmBuff[256];
-        pageLen = 0;
-        for(uint8_t j = 0; j < psegm; j++){
-            psegmBuff[j] = *(data + i);
-            pageLen += psegmBuff[j];
-            i++;
-        }
-        retvalue = i;
-        if(agp == 0){
-            if(f_firstPacket == true){
-                f_firstPacket = false;
-                m_controlCounter = OGG_FIRST; // ogg first pages
-            }
-            else{
-                retvalue += pageLen;
-                m_controlCounter = OGG_MAGIC;
-            }
-        }
-        else{
-            if(m_codec == CODEC_OGG_FLAC){
-                m_controlCounter = OGG_AMRDY;
-            }
-            else {
-                if(audio_info) audio_info("unknown format");
-                stopSong();
-                return -1;
-            }
-        }
-        return 0;
+    AUDIO_INFO(sprintf(chbuf, "FLAC bitsPerSample: %u", m_flacBitsPerSample);)
+    m_flacTotalSamplesInStream = bigEndian(data + 17, 4);
+    if(m_flacTotalSamplesInStream){
+        AUDIO_INFO(sprintf(chbuf, "total samples in stream: %u", m_flacTotalSamplesInStream);)
     }
-    // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-    if(m_controlCounter == OGG_FIRST) { /* check OGG FIRST PAGES (has no streaming content) */
-        uint8_t i = 0;
-        uint8_t obp = *(data + i);                  // oneBytePacket shold be 0x7F
-        (void)obp;
-        i++;
-        if(specialIndexOf(data + i, "FLAC", 10) == 0){
+    else{
+        if(audio_info) audio_info("total samples in stream: N/A");
+    }
+    if(bps != 0 && m_flacTotalSamplesInStream) {
+        AUDIO_INFO(sprintf(chbuf, "audio file duration: %u seconds", m_flacTotalSamplesInStream / m_flacSampleRate);)
+    }
+    return true;
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::initOggDemuxer(){
+    // the codec of the logical stream is known with its first packet, see readOggPacket()
+    if(!m_ogg) m_ogg = OggDemuxer_Create();
+    if(!m_ogg) return false;
+    OggDemuxer_Reset(m_ogg);
+    m_ogg->f_bos = false;
+    return true;
+}
+//---------------------------------------------------------------------------------------------------------------------
+int Audio::readOggPacket(uint8_t** data, size_t* len){
+    // Return: > 0 bytes consumed by the demuxer or by a header packet, nothing to decode
+    //           0 and *len > 0: *data points to the next audio packet (in InBuff or in the reassembly buffer)
+    //           0 and *len == 0: wait for more data
+    uint8_t* pkt = NULL;
+    int      pktLen = 0;
+    int res = OggReadPacket(m_ogg, *data, *len, &pkt, &pktLen);
+    *len = 0;
+    if(res == ERR_OGG_SYNC_LOST) {m_f_playing = false; return 1;}  // findNextSync() searches the next page
+    if(res == ERR_OGG_OUT_OF_MEMORY) return 0;                     // this packet is skipped
+    if(res > 0 || !pktLen) return res;
+
+    if(m_ogg->f_bos){  // first packet of a logical stream, also the next song of a chained stream
+        m_ogg->f_bos = false;
+        if(pktLen >= 5 && pkt[0] == 0x7F && !memcmp(pkt + 1, "FLAC", 4)){
+            if(!readOggFLACHeader(pkt, pktLen)) {stopSong(); return OggPacketDrop(m_ogg);}
+            m_f_playing = false; // take the parameters of the new stream with its first frame
+        }
+        else if(pktLen >= 8 && !memcmp(pkt, "OpusHead", 8)){
+            if(!readOggOpusHead(pkt, pktLen)) stopSong();
+            m_f_playing = false;
         }
         else{
-            log_i("ogg/flac support only"); // ogg/vorbis or ogg//opus not supported yet
-            stopSong();
-            return -1;
-        }
-        i += 4;
-        uint8_t major_vers = *(data + i);
-        (void)major_vers;
-        i++;
-        uint8_t minor_vers = *(data + i);
-        (void)minor_vers;
-        i++;
-        uint16_t nonah = bigEndian(data + i, 2); // number of non audio headers (0x00 = unknown)
-        (void)nonah;
-        i += 2;
-        if(specialIndexOf(data + i, "fLaC", 10) == 0){
-            m_codec = CODEC_OGG_FLAC;
-        }
-        i += 4;
-        // STREAMINFO metadata block begins
-        uint32_t mblen = bigEndian(data + i, 4);
-        (void)mblen;
-        i += 4; // skip metadata block header + length
-        i += 2; // skip minimun block size
-        m_flacMaxBlockSize = bigEndian(data + i, 2);
-        i += 2;
-        vTaskDelay(2);
-        AUDIO_INFO(sprintf(chbuf, "FLAC maxBlockSize: %u", m_flacMaxBlockSize);)
-        i += 3; // skip minimun frame size
-        vTaskDelay(2);
-        m_flacMaxFrameSize = bigEndian(data + i, 3);
-        i += 3;
-        if(m_flacMaxFrameSize){
-            AUDIO_INFO(sprintf(chbuf, "FLAC maxFrameSize: %u", m_flacMaxFrameSize);)
-        }
-        else {
-            if(audio_info) audio_info("FLAC maxFrameSize: N/A");
-        }
-        if(m_flacMaxFrameSize > InBuff.getMaxBlockSize()) {
-            log_e("FLAC maxFrameSize too large!");
-            stopSong();
-            return -1;
-        }
-        vTaskDelay(2);
-        uint32_t nextval = bigEndian(data + i, 3);
-        i += 3;
-        m_flacSampleRate = nextval >> 4;
-        AUDIO_INFO(sprintf(chbuf, "FLAC sampleRate: %u", m_flacSampleRate);)
-        vTaskDelay(2);
-        m_flacNumChannels = ((nextval & 0x06) >> 1) + 1;
-        AUDIO_INFO(sprintf(chbuf, "FLAC numChannels: %u", m_flacNumChannels);)
-        if(m_flacNumChannels != 1 && m_flacNumChannels != 2){
-            vTaskDelay(2);
-            if(audio_info) audio_info("numChannels must be 1 or 2");
-            stopSong();
-            return -1;
-        }
-        vTaskDelay(2);
-        uint8_t bps = (nextval & 0x01) << 4;
-        bps += (*(data +i) >> 4) + 1;
-        i++;
-        m_flacBitsPerSample = bps;
-        if((bps != 8) && (bps != 16)){
-            log_e("bits per sample must be 8 or 16, is %i", bps);
+            if(pktLen >= 7 && !memcmp(pkt + 1, "vorbis", 6))      {if(audio_info) audio_info("Ogg Vorbis is not supported");}
+            else                                                  {if(audio_info) audio_info("unknown Ogg stream");}
             stopSong();
-            return -1;
-        }
-        AUDIO_INFO(sprintf(chbuf, "FLAC bitsPerSample: %u", m_flacBitsPerSample);)
-        m_flacTotalSamplesInStream = bigEndian(data + i, 4);
-        i++;
-        if(m_flacTotalSamplesInStream) {
-            AUDIO_INFO(sprintf(chbuf, "total samples in stream: %u", m_flacTotalSamplesInStream);)
-        }
-        else {
-            if(audio_info) audio_info("total samples in stream: N/A");
         }
-        if(bps != 0 && m_flacTotalSamplesInStream) {
-            AUDIO_INFO(sprintf(chbuf, "audio file duration: %u seconds", m_flacTotalSamplesInStream / m_flacSampleRate);)
-        }
-        m_controlCounter = OGG_MAGIC;
-        retvalue = pageLen;
-        return 0;
+        return OggPacketDrop(m_ogg);
     }
-    if(m_controlCounter == OGG_AMRDY){ // ogg almost ready
-        if(!psramFound()){
-            if(audio_info) audio_info("FLAC works only with PSRAM!");
-            m_f_running = false; stopSong();
-            return -1;
-        }
-        if(!FLACDecoder_AllocateBuffers()) {m_f_running = false; stopSong(); return -1;}
-        InBuff.changeMaxBlockSize(m_frameSizeFLAC);
-        AUDIO_INFO(sprintf(chbuf, "FLACDecoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-
-        m_controlCounter = OGG_OKAY; // 100
-        retvalue = 0;
-        return 0;
+    if(m_codec == CODEC_OGG) return OggPacketDrop(m_ogg);   // no BOS page seen yet
+    if(m_codec == CODEC_OGG_FLAC && !m_ogg->pktUsed && pkt[0] != 0xFF){  // metadata block, one per header packet
+        if((pkt[0] & 0x7F) == 4 && pktLen > 4) readOggComments(pkt + 4, pktLen - 4);
+        return OggPacketDrop(m_ogg);
     }
+    if(m_codec == CODEC_OGG_OPUS && !m_ogg->pktUsed && pktLen >= 8 && !memcmp(pkt, "OpusTags", 8)){
+        readOggComments(pkt + 8, pktLen - 8);
+        return OggPacketDrop(m_ogg);
+    }
+    *data = pkt;
+    *len = pktLen;
     return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
+bool Audio::readOggFLACHeader(uint8_t* pkt, size_t len){
+    // first packet: 0x7F "FLAC", major, minor version, number of header packets (2), "fLaC", STREAMINFO block
+    if(len < 51 || memcmp(pkt + 9, "fLaC", 4) || (pkt[13] & 0x7F) != 0){
+        log_e("Ogg FLAC: STREAMINFO not found");
+        return false;
+    }
+    if(pkt[5] != 1) log_w("Ogg FLAC mapping version %i.%i", pkt[5], pkt[6]);
+    if(!parseFLACStreamInfo(pkt + 14)) return false;
+    if(!findCodecPlugin(CODEC_OGG_FLAC)){
+        if(audio_info) audio_info("Ogg FLAC is not supported");
+        return false;
+    }
+    return selectCodec(CODEC_OGG_FLAC);  // pkt is invalid now, the input buffer is set for m_flacMaxFrameSize
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::readOggOpusHead(uint8_t* pkt, size_t len){
+    // first packet: "OpusHead", version, channels, pre-skip, input samplerate, output gain, mapping family
+#ifdef AUDIO_NO_OPUS
+    if(audio_info) audio_info("Ogg Opus is not supported");
+    return false;
+#else
+    if(!selectCodec(CODEC_OGG_OPUS)) return false;
+    int res = m_plugin->header(m_codecCtx[m_plugin->id], pkt, len);
+    if(res == ERR_OPUS_CHANNELS_OUT_OF_RANGE){
+        if(audio_info) audio_info("Ogg Opus: only mono and stereo streams are supported");
+        return false;
+    }
+    if(res < 0){
+        log_e("Ogg Opus: invalid OpusHead");
+        return false;
+    }
+    AUDIO_INFO(sprintf(chbuf, "Opus channels: %u, pre-skip: %u, input sampleRate: %u", pkt[9], pkt[10] | (pkt[11] << 8),
+                       pkt[12] | (pkt[13] << 8) | (pkt[14] << 16) | ((uint32_t)pkt[15] << 24));)
+    return true;
+#endif // AUDIO_NO_OPUS
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::readOggComments(uint8_t* data, size_t len){
+    // VORBIS_COMMENT, lengths are little endian: vendor string, number of comments, comments "FIELD=value"
+    const char fn[7][12] = {"TITLE", "VERSION", "ALBUM", "TRACKNUMBER", "ARTIST", "PERFORMER", "GENRE"};
+    auto le32 = [](uint8_t* p) -> uint32_t {return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);};
+    const char* title = NULL;  int titleLen = 0;
+    const char* artist = NULL; int artistLen = 0;
+
+    if(len < 8) return;
+    uint32_t i = 4 + le32(data);
+    if(i + 4 > len) return;
+    uint32_t n = le32(data + i);
+    i += 4;
+    for(uint32_t k = 0; k < n && i + 4 <= len; k++){
+        uint32_t l = le32(data + i);
+        i += 4;
+        if(l > len - i) break;
+        const char* c = (const char*)data + i;
+        for(int f = 0; f < 7; f++){
+            size_t fl = strlen(fn[f]);
+            if(l <= fl || c[fl] != '=' || strncasecmp(c, fn[f], fl)) continue;
+            int vl = l - fl - 1;
+            if(vl > CHBUF_SIZE - 16) vl = CHBUF_SIZE - 16;
+            sprintf(chbuf, "%s: %.*s", fn[f], vl, c + fl + 1);
+            if(audio_id3data) audio_id3data(chbuf);
+            if(f == 0) {title = c + fl + 1;  titleLen = vl;}
+            if(f == 4) {artist = c + fl + 1; artistLen = vl;}
+        }
+        i += l;
+    }
+    if(!m_f_localfile && title){  // chained webstream, each song brings its own comments
+        if(titleLen > 200) titleLen = 200;
+        if(artistLen > 200) artistLen = 200;
+        if(artist) sprintf(chbuf, "StreamTitle='%.*s - %.*s';", artistLen, artist, titleLen, title);
+        else       sprintf(chbuf, "StreamTitle='%.*s';", titleLen, title);
+        showstreamtitle(chbuf);
+    }
+}
+//---------------------------------------------------------------------------------------------------------------------
 uint32_t Audio::stopSong() {
     uint32_t pos = 0;
     if(m_f_running) {
@@ -2104,7 +2635,8 @@ uint32_t Audio::stopSong() {
         log_w("Closing audio file");  // for debug
     }
 #endif                                           // AUDIO_NO_SD_FS
-    memset(m_outBuff, 0, sizeof(m_outBuff));     //Clear OutputBuffer
+    storeStreamProfile(); // nothing plays now, the flash write can't cause a dropout
+    memset(m_outBuff, 0, OUTBUFF_SIZE * sizeof(int16_t)); //Clear OutputBuffer
     i2s_zero_dma_buffer((i2s_port_t) m_i2s_num);
     return pos;
 }
@@ -2112,8 +2644,8 @@ uint32_t Audio::stopSong() {
 void Audio::playI2Sremains() { // returns true if all dma_buffs flushed
     if(!getSampleRate()) setSampleRate(96000);
     if(!getChannels()) setChannels(2);
-    if(getBitsPerSample() > 8) memset(m_outBuff,   0, sizeof(m_outBuff));     //Clear OutputBuffer (signed)
-    else                       memset(m_outBuff, 128, sizeof(m_outBuff));     //Clear OutputBuffer (unsigned, PCM 8u)
+    if(getBitsPerSample() > 8) memset(m_outBuff,   0, OUTBUFF_SIZE * sizeof(int16_t)); //Clear OutputBuffer (signed)
+    else                       memset(m_outBuff, 128, OUTBUFF_SIZE * sizeof(int16_t)); //Clear OutputBuffer (unsigned, PCM 8u)
 
     m_validSamples = m_i2s_config.dma_buf_len;
     while(m_validSamples) {
@@ -2128,7 +2660,7 @@ bool Audio::pauseResume() {
         m_f_running = !m_f_running;
         retVal = true;
         if(!m_f_running) {
-            memset(m_outBuff, 0, sizeof(m_outBuff));               //Clear OutputBuffer
+            memset(m_outBuff, 0, OUTBUFF_SIZE * sizeof(int16_t));  //Clear OutputBuffer
             i2s_zero_dma_buffer((i2s_port_t) m_i2s_num);
         }
     }
@@ -2248,6 +2780,7 @@ void Audio::loop() {
         }
         if(m_datamode == AUDIO_DATA){
             processWebStream();
+            if(m_profileSlot >= 0 && InBuff.bufferFilled() > InBuff.freeSpace()) storeStreamProfile(); // half full
             return;
         }
     }
@@ -2256,12 +2789,12 @@ void Audio::loop() {
 //---------------------------------------------------------------------------------------------------------------------
 void Audio::processPlayListData() {
 
-    static bool f_entry     = false;                            // entryflag for asx playlist
-    static bool f_title     = false;                            // titleflag for asx playlist
-    static bool f_ref       = false;                            // refflag   for asx playlist
-    static bool f_begin     = false;
-    static bool f_end       = false;
-    static bool f_ct        = false;
+    bool& f_entry     = m_pls.f_entry;                          // entryflag for asx playlist
+    bool& f_title     = m_pls.f_title;                          // titleflag for asx playlist
+    bool& f_ref       = m_pls.f_ref;                            // refflag   for asx playlist
+    bool& f_begin     = m_pls.f_begin;
+    bool& f_end       = m_pls.f_end;
+    bool& f_ct        = m_pls.f_ct;
 
     (void)f_title;  // is unused yet
 
@@ -2399,7 +2932,7 @@ void Audio::processPlayListData() {
                 _client->stop(); _client->flush();
                 httpPrint(host);
             }
-            else connecttohost(host);                                                   // different host,
+            else openStream(host);                                                      // different host,
         }
         return;
     } // end AUDIO_PLAYLISTHEADER
@@ -2435,7 +2968,7 @@ void Audio::processPlayListData() {
            pos = indexOf(pl, "http://:@", 0); // ":@"??  remove that!
            if(pos >= 0) {
                AUDIO_INFO(sprintf(chbuf, "Entry in playlist found: %s", (pl + pos + 9));)
-               connecttohost(pl + pos + 9);
+               openStream(pl + pos + 9);
                return;
            }
            //sprintf(chbuf, "Entry in playlist found: %s", pl);
@@ -2444,7 +2977,7 @@ void Audio::processPlayListData() {
            const char* host;
            if(pos >= 0) {                                   // Does URL contain "http://"?
                host = (pl + pos);
-               connecttohost(host);
+               openStream(host);
            }                                                // Yes, set new host
            return;
         } //m3u
@@ -2491,7 +3024,7 @@ void Audio::processPlayListData() {
 
             if(f_end) {                                      // we have both StationName and StationURL
                 log_d("connect to new host %s", m_lastHost);
-                connecttohost(m_lastHost);                              // Connect to it
+                openStream(m_lastHost);                                 // Connect to it
             }
             return;
         } // pls
@@ -2541,20 +3074,20 @@ void Audio::processPlayListData() {
                 memcpy(m_lastHost, pl, strlen(pl)); // save url in array
                 m_lastHost[strlen(pl)] = '\0';
                 log_d("m_lastHost = %s",m_lastHost);
-                connecttohost(pl);
+                openStream(pl);
             }
             if(f_end) {   //we have both StationName and StationURL
-                connecttohost(m_lastHost);                          // Connect to it
+                openStream(m_lastHost);                             // Connect to it
             }
             return;
         }  //asx
         // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
         if(m_playlistFormat == FORMAT_M3U8) {
 
-            static bool f_StreamInf = false;                            // set if  #EXT-X-STREAM-INF in m3u8
-            static bool f_ExtInf    = false;                            // set if  #EXTINF in m3u8
-            static uint8_t plsEntry = 0;                                // used in m3u8, counts url entries
-            static uint8_t seqNrPos = 0;                                // position at which the SeqNr is found
+            bool&    f_StreamInf = m_pls.f_StreamInf;                   // set if  #EXT-X-STREAM-INF in m3u8
+            bool&    f_ExtInf    = m_pls.f_ExtInf;                      // set if  #EXTINF in m3u8
+            uint8_t& plsEntry    = m_pls.plsEntry;                      // used in m3u8, counts url entries
+            uint8_t& seqNrPos    = m_pls.seqNrPos;                      // position at which the SeqNr is found
 
             if(!f_begin){
                 if(strlen(pl) == 0) return;                             // empty line
@@ -2610,21 +3143,21 @@ void Audio::processPlayListData() {
                     strcpy(m_lastHost + pos + 1, pl);
                 }
                 f_StreamInf = false;
-                connecttohost(m_lastHost);
+                openStream(m_lastHost);
                 return;
             }
 
             if(m_m3u8codec == CODEC_NONE){                                                  // second guard
                 if(!f_end) return;
-                else {connecttohost(m_lastHost); return;}
+                else {openStream(m_lastHost); return;}
             }
 
-            static uint32_t seqNr = 0;
+            uint32_t& seqNr = m_pls.seqNr;
             if(startsWith(pl, "#EXT-X-MEDIA-SEQUENCE:")){
                 // do nothing, because MEDIA-SECUENCE is not set sometimes
             }
 
-            static uint16_t targetDuration = 0;
+            uint16_t& targetDuration = m_pls.targetDuration;
             if(startsWith(pl, "#EXT-X-TARGETDURATION:")) {targetDuration = atoi(pl + 22);}
 
             if(startsWith(pl,"#EXTINF")) {
@@ -2685,7 +3218,7 @@ void Audio::processPlayListData() {
                     processM3U8entries(plsEntry, seqNr, seqNrPos, targetDuration);
                 }
                 else{
-                    connecttohost(m_lastHost);
+                    openStream(m_lastHost);
                 }
             }
         } //end m3u8
@@ -2697,12 +3230,12 @@ void Audio::processPlayListData() {
 void Audio::processM3U8entries(uint8_t _nrOfEntries, uint32_t _seqNr, uint8_t _seqNrpos, uint16_t _targetDuration){
 
     // call up the entries in m3u8 sequentially, after the last we need a new playlist
-    static uint8_t  nrOfEntries = 0;
-    static uint32_t currentSeqNr = 0;
-    static uint32_t sequenceNr = 0;
-    static uint32_t maxSeqNr = 0;
-    static uint8_t  sequenceNrPos = 0;
-    static uint16_t targetDuration = 0;
+    uint8_t&  nrOfEntries    = m_m3u8.nrOfEntries;
+    uint32_t& currentSeqNr   = m_m3u8.currentSeqNr;
+    uint32_t& sequenceNr     = m_m3u8.sequenceNr;
+    uint32_t& maxSeqNr       = m_m3u8.maxSeqNr;
+    uint8_t&  sequenceNrPos  = m_m3u8.sequenceNrPos;
+    uint16_t& targetDuration = m_m3u8.targetDuration;
 
     char  resp[256 + 100];
     char* host = NULL;      // e.g  http://n31a-e2.revma.ihrhls.com
@@ -2717,8 +3250,8 @@ void Audio::processM3U8entries(uint8_t _nrOfEntries, uint32_t _seqNr, uint8_t _s
         maxSeqNr = currentSeqNr + _nrOfEntries;
         sequenceNrPos = _seqNrpos;
         targetDuration = _targetDuration;
-        connecttohost(m_playlistBuff + m_plsBuffEntryLen); // connect the streamserver first
-        m_f_m3u8data = true; // connecttohost() will clear m_f_m3u8data, set it again
+        openStream(m_playlistBuff + m_plsBuffEntryLen); // connect the streamserver first
+        m_f_m3u8data = true; // openStream() will clear m_f_m3u8data, set it again
 
 //        log_i("nrOfEntries=%d, currentSeqNr=%d, sequenceNrPos=%d targetDuration=%d", nrOfEntries, currentSeqNr, sequenceNrPos, targetDuration);
 //        log_i("m3u8_url=%s", m_playlistBuff);
@@ -2834,7 +3367,7 @@ void Audio::processLocalFile() {
     uint32_t bytesCanBeWritten = 0;
     uint32_t bytesCanBeRead = 0;
     int32_t bytesAddedToBuffer = 0;
-    static bool f_stream;
+    bool& f_stream = m_rx.f_stream;
 
     if(m_f_firstCall) {  // runs only one time per connection, prepare for start
         m_f_firstCall = false;
@@ -2898,8 +3431,8 @@ void Audio::processLocalFile() {
                     m_controlCounter = 100;
                 }
             }
-            if(m_codec == CODEC_AAC){
-                // stream only, no header
+            if(m_codec == CODEC_AAC || m_codec == CODEC_OGG){
+                // stream only, no header (Ogg: the header packets are read by readOggPacket())
                 m_audioDataSize = getFileSize();
                 m_controlCounter = 100;
             }
@@ -2921,9 +3454,9 @@ void Audio::processLocalFile() {
             bytesDecoded = sendBytes(InBuff.getReadPtr(), bytesCanBeRead);
         }
         if(bytesDecoded > 0) {InBuff.bytesWasRead(bytesDecoded); return;}
-        if(bytesDecoded < 0) {  // no syncword found or decode error, try next chunk
-            InBuff.bytesWasRead(200); // try next chunk
-            m_bytesNotDecoded += 200;
+        if(bytesDecoded < 0) {  // no syncword in the whole block, only the last byte can be the begin of one
+            InBuff.bytesWasRead(bytesCanBeRead - 1);
+            m_bytesNotDecoded += bytesCanBeRead - 1;
             return;
         }
         return;
@@ -2931,10 +3464,13 @@ void Audio::processLocalFile() {
 
     if(!bytesAddedToBuffer) {  // eof
         bytesCanBeRead = InBuff.bufferFilled();
-        if(bytesCanBeRead > 200){
+        if(bytesCanBeRead > 200 || (m_ogg && (bytesCanBeRead || OggPacketPending(m_ogg)))){ // Ogg: small last page
             if(bytesCanBeRead > InBuff.getMaxBlockSize()) bytesCanBeRead = InBuff.getMaxBlockSize();
+            uint32_t oggPackets = m_ogg ? m_ogg->packets : 0;
             bytesDecoded = sendBytes(InBuff.getReadPtr(), bytesCanBeRead); // play last chunk(s)
-            if(bytesDecoded > 0){
+            bool f_more = (bytesDecoded == 0 && m_f_playing);  // 0: FLAC block is output in pieces
+            if(f_more && m_ogg) f_more = OggPacketPending(m_ogg) || m_ogg->packets != oggPackets; // or truncated page
+            if(bytesDecoded > 0 || f_more){
                 InBuff.bytesWasRead(bytesDecoded);
                 return;
             }
@@ -2945,7 +3481,6 @@ void Audio::processLocalFile() {
         if(m_f_loop  && f_stream){  //eof
             AUDIO_INFO(sprintf(chbuf, "loop from: %u to: %u", getFilePos(), m_audioDataStart);) //TEST loop
             setFilePos(m_audioDataStart);
-            if(m_codec == CODEC_FLAC) FLACDecoderReset();
             /*
                 The current time of the loop mode is not reset,
                 which will cause the total audio duration to be exceeded.
@@ -2959,17 +3494,14 @@ void Audio::processLocalFile() {
         m_f_localfile = false;
 
 #ifdef SDFATFS_USED
-        audiofile.getName(chbuf, sizeof(chbuf));
+        audiofile.getName(chbuf, CHBUF_SIZE);
         char *afn =strdup(chbuf);
 #else
         char *afn =strdup(audiofile.name()); // store temporary the name
 #endif
 
         stopSong();
-        if(m_codec == CODEC_MP3)   MP3Decoder_FreeBuffers();
-        if(m_codec == CODEC_AAC)   AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_M4A)   AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_FLAC) FLACDecoder_FreeBuffers();
+        if(m_plugin) releaseDecoder(m_plugin);
         AUDIO_INFO(sprintf(chbuf, "End of file \"%s\"", afn);)
         if(audio_eof_mp3) audio_eof_mp3(afn);
         if(afn) free(afn);
@@ -2981,14 +3513,14 @@ void Audio::processWebStream() {
 
     const uint16_t  maxFrameSize = InBuff.getMaxBlockSize();    // every mp3/aac frame is not bigger
     int32_t         availableBytes;                             // available bytes in stream
-    static bool     f_tmr_1s;
-    static bool     f_stream;                                   // first audio data received
-    static int      bytesDecoded;
-    static uint32_t byteCounter;                                // count received data
-    static uint32_t chunksize;                                  // chunkcount read from stream
-    static uint32_t tmr_1s;                                     // timer 1 sec
-    static uint32_t loopCnt;                                    // count loops if clientbuffer is empty
-    static uint32_t metacount;                                  // counts down bytes between metadata
+    bool&           f_tmr_1s     = m_rx.f_tmr_1s;
+    bool&           f_stream     = m_rx.f_stream;               // first audio data received
+    int&            bytesDecoded = m_rx.bytesDecoded;
+    uint32_t&       byteCounter  = m_rx.byteCounter;            // count received data
+    uint32_t&       chunksize    = m_rx.chunksize;              // chunkcount read from stream
+    uint32_t&       tmr_1s       = m_rx.tmr_1s;                 // timer 1 sec
+    uint32_t&       loopCnt      = m_rx.loopCnt;                // count loops if clientbuffer is empty
+    uint32_t&       metacount    = m_rx.metacount;              // counts down bytes between metadata
 
 
     // first call, set some values to default - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -3056,14 +3588,14 @@ void Audio::processWebStream() {
         tmr_1s = millis();
     }
 
-    availableBytes = _client->available();      // available from stream
+    availableBytes = streamAvailable();         // available from stream
 
     if(ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_DEBUG){
         // Here you can see how much data comes in, a summary is displayed in every 10 calls
-        static uint8_t  i = 0;
-        static uint32_t t = 0;
-        static uint32_t t0 = 0;
-        static uint16_t avb[10];
+        uint8_t&  i   = m_rx.avbIdx;
+        uint32_t& t   = m_rx.avbT;
+        uint32_t& t0  = m_rx.avbT0;
+        uint16_t* avb = m_rx.avb;
         if(!i) t = millis();
         avb[i] = availableBytes;
         if(!avb[i]){if(!t0) t0 = millis();}
@@ -3079,7 +3611,7 @@ void Audio::processWebStream() {
     // if we have chunked data transfer: get the chunksize- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(m_f_chunked && !m_chunkcount && availableBytes) { // Expecting a new chunkcount?
         int b;
-        b = _client->read();
+        b = readStream();
 
         if(b == '\r') return;
         if(b == '\n'){
@@ -3102,7 +3634,7 @@ void Audio::processWebStream() {
     // if we have metadata: get them - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(!metacount && !m_f_swm && availableBytes){
         int16_t b = 0;
-        b = _client->read();
+        b = readStream();
         if(b >= 0) {
             if(m_f_chunked) m_chunkcount--;
             if(readMetadata(b)) metacount = m_metaint;
@@ -3112,7 +3644,7 @@ void Audio::processWebStream() {
 
     // if the buffer is often almost empty issue a warning  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(InBuff.bufferFilled() < maxFrameSize && f_stream){
-        static uint8_t cnt_slow = 0;
+        uint8_t& cnt_slow = m_rx.cnt_slow;
         cnt_slow ++;
         if(f_tmr_1s) {
             if(cnt_slow > 25 && audio_info) audio_info("slow stream, dropouts are possible");
@@ -3127,7 +3659,7 @@ void Audio::processWebStream() {
         if(loopCnt > 200000) {              // wait several seconds
             loopCnt = 0;
             if(audio_info) audio_info("Stream lost -> try new connection");
-            connecttohost(m_lastHost);
+            openStream(m_lastHost);
         }
     }
     if(availableBytes) loopCnt = 0;
@@ -3150,7 +3682,7 @@ void Audio::processWebStream() {
             if(byteCounter + bytesCanBeWritten >= m_contentlength) bytesCanBeWritten = m_contentlength - byteCounter;
         }
 
-        bytesAddedToBuffer = _client->read(InBuff.getWritePtr(), bytesCanBeWritten);
+        bytesAddedToBuffer = readStream(InBuff.getWritePtr(), bytesCanBeWritten);
 
         if(bytesAddedToBuffer > 0) {
             if(m_f_webfile)             byteCounter  += bytesAddedToBuffer;  // Pull request #42
@@ -3191,7 +3723,7 @@ void Audio::processWebStream() {
            if(res >= 0) bytesDecoded = res;
            else{stopSong(); return;} // error, skip header
        }
-       if(m_codec == CODEC_AAC){ // aac has no header
+       if(m_codec == CODEC_AAC || m_codec == CODEC_OGG){ // aac has no header, ogg: see readOggPacket()
            m_controlCounter = 100;
            return;
        }
@@ -3201,25 +3733,10 @@ void Audio::processWebStream() {
 
     // play audio data - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if((InBuff.bufferFilled() >= maxFrameSize) && (f_stream == true)) { // fill > framesize?
-        if(m_f_webfile){
-                bytesDecoded = sendBytes(InBuff.getReadPtr(), maxFrameSize);
-        }
-        else { // not a webfile
-            if(m_controlCounter != 100 && (m_codec == CODEC_OGG || m_codec == CODEC_OGG_FLAC)) {  //application/ogg
-                int res = read_OGG_Header(InBuff.getReadPtr(), InBuff.bufferFilled());
-                if(res >= 0) bytesDecoded = res;
-                else { // error, skip header
-                    stopSong();
-                    m_controlCounter = 100;
-                }
-            }
-            else{
-                bytesDecoded = sendBytes(InBuff.getReadPtr(), maxFrameSize);
-            }
-        }
-        if(bytesDecoded < 0) {  // no syncword found or decode error, try next chunk
-            InBuff.bytesWasRead(200); // try next chunk
-            m_bytesNotDecoded += 200;
+        bytesDecoded = sendBytes(InBuff.getReadPtr(), maxFrameSize);
+        if(bytesDecoded < 0) {  // no syncword in the whole block, only the last byte can be the begin of one
+            InBuff.bytesWasRead(maxFrameSize - 1);
+            m_bytesNotDecoded += maxFrameSize - 1;
             return;
         }
         else {
@@ -3229,37 +3746,106 @@ void Audio::processWebStream() {
     return;
 }
 //---------------------------------------------------------------------------------------------------------------------
+uint8_t Audio::headerNameId(const char* name, uint8_t len) {
+    // name is lowercase and without colon, the length is checked first, then the few candidates are compared
+    switch(len){
+        case  3: if(!memcmp(name, "p3p", 3))                  return HDR_IGNORE;              break;
+        case  6: if(!memcmp(name, "icy-br", 6))               return HDR_ICY_BR;
+                 if(!memcmp(name, "pragma", 6))               return HDR_IGNORE;              break;
+        case  7: if(!memcmp(name, "expires", 7))              return HDR_IGNORE;
+                 if(!memcmp(name, "icy-pub", 7))              return HDR_IGNORE;
+                 if(!memcmp(name, "icy-url", 7))              return HDR_ICY_URL;             break;
+        case  8: if(!memcmp(name, "location", 8))             return HDR_LOCATION;
+                 if(!memcmp(name, "icy-name", 8))             return HDR_ICY_NAME;            break;
+        case  9: if(!memcmp(name, "icy-genre", 9))            return HDR_IGNORE;              break;
+        case 10: if(!memcmp(name, "set-cookie", 10))          return HDR_IGNORE;
+                 if(!memcmp(name, "connection", 10))          return HDR_IGNORE;              break;
+        case 11: if(!memcmp(name, "icy-metaint", 11))         return HDR_ICY_METAINT;         break;
+        case 12: if(!memcmp(name, "content-type", 12))        return HDR_CONTENT_TYPE;        break;
+        case 13: if(!memcmp(name, "cache-control", 13))       return HDR_IGNORE;
+                 if(!memcmp(name, "accept-ranges", 13))       return HDR_IGNORE;              break;
+        case 14: if(!memcmp(name, "content-length", 14))      return HDR_CONTENT_LENGTH;      break;
+        case 15: if(!memcmp(name, "icy-description", 15))     return HDR_ICY_DESCRIPTION;     break;
+        case 16: if(!memcmp(name, "www-authenticate", 16))    return HDR_WWW_AUTHENTICATE;    break;
+        case 17: if(!memcmp(name, "transfer-encoding", 17))   return HDR_TRANSFER_ENCODING;   break;
+        case 19: if(!memcmp(name, "content-disposition", 19)) return HDR_CONTENT_DISPOSITION; break;
+    }
+    return HDR_UNKNOWN;
+}
+//---------------------------------------------------------------------------------------------------------------------
+int Audio::readStream(uint8_t* buff, size_t len) {
+    // bytes that were read with the header come first
+    size_t n = min((size_t)(m_hdrLen - m_hdrPos), len);
+    if(n){
+        memcpy(buff, m_hdrBuff + m_hdrPos, n);
+        m_hdrPos += n;
+        if(n == len) return n;
+    }
+    int res = _client->read(buff + n, len - n);
+    if(res < 0) return n ? n : res;
+    return n + res;
+}
+int Audio::readStream() {
+    if(m_hdrPos < m_hdrLen) return (uint8_t)m_hdrBuff[m_hdrPos++];
+    return _client->read();
+}
+int Audio::streamAvailable() {
+    return (m_hdrLen - m_hdrPos) + _client->available();
+}
+//---------------------------------------------------------------------------------------------------------------------
 void Audio::processAudioHeaderData() {
 
-    int av = 0;
-    av= _client->available();
-    if(av <= 0) return;
+    // Everything the client has is read at once into m_hdrBuff, the lines are terminated in place. A line that is not
+    // complete stays in the buffer until the next call. Bytes behind the header belong to the stream, readStream()
+    // delivers them first.
 
-    char hl[512]; // headerline
-    uint8_t b = 0;
-    uint16_t pos = 0;
+    char* hl;   // headerline
+    char* nl;
     int16_t idx = 0;
-    static bool f_icyname = false;
-    static bool f_icydescription = false;
-    static bool f_icyurl = false;
+    bool& f_icyname = m_meta.f_icyname;
+    bool& f_icydescription = m_meta.f_icydescription;
+    bool& f_icyurl = m_meta.f_icyurl;
 
     while(true){
-        b = _client->read();
-        if(b == '\n') break;
-        if(b == '\r') hl[pos] = 0;
-        if(b < 0x20) continue;
-        hl[pos] = b;
-        pos++;
-        if(pos == 510){
-            hl[pos] = '\0';
-            log_e("headerline overflow");
-            break;
+        nl = (char*)memchr(m_hdrBuff + m_hdrPos, '\n', m_hdrLen - m_hdrPos);
+        if(!nl){
+            if(m_hdrPos){ // keep the incomplete line, make room for the next read
+                memmove(m_hdrBuff, m_hdrBuff + m_hdrPos, m_hdrLen - m_hdrPos);
+                m_hdrLen -= m_hdrPos;
+                m_hdrPos = 0;
+            }
+            if(m_hdrLen == sizeof(m_hdrBuff) - 1){
+                log_e("headerline overflow");
+                nl = m_hdrBuff + m_hdrLen; // process the part we have, the remainder appears as a line of its own
+            }
+            else{
+                int av = _client->available();
+                if(av <= 0) return;
+                av = _client->read((uint8_t*)m_hdrBuff + m_hdrLen, min(av, (int)(sizeof(m_hdrBuff) - 1 - m_hdrLen)));
+                if(av <= 0) return;
+                m_hdrLen += av;
+                continue;
+            }
         }
+        hl = m_hdrBuff + m_hdrPos;
+        m_hdrPos = nl - m_hdrBuff + (nl < m_hdrBuff + m_hdrLen ? 1 : 0);
+        *nl = '\0';
+        if(nl > hl && nl[-1] == '\r') nl[-1] = '\0';
+
+        if(!hl[0]) break; // empty line
+        idx = indexOf(hl, ":", 0); // lowercase all letters up to the colon
+        if(idx > 0) {
+            for(int i=0; i< idx; i++) {
+                hl[i] = toLowerCase(hl[i]);
+            }
+        }
+        if(!parseHeaderLine(hl, idx, &f_icyname, &f_icydescription, &f_icyurl)) return; // stopped or redirected
     }
 
-    if(!pos && m_f_ctseen){  // audio header complete?
+    if(m_f_ctseen){  // audio header complete?
         m_datamode = AUDIO_DATA;                         // Expecting data now
         if(m_f_Log) { AUDIO_INFO(sprintf(chbuf, "Switch to DATA, metaint is %d", m_metaint);) }
+        AUDIO_INFO(sprintf(chbuf, "response header received in %u ms", millis() - m_openTime);)
         memcpy(chbuf, m_lastHost, strlen(m_lastHost)+1);
 //        uint idx = indexOf(chbuf, "?", 0);
 //        if(idx > 0) chbuf[idx] = 0;
@@ -3273,158 +3859,153 @@ void Audio::processAudioHeaderData() {
         delay(50);  // #77
         return;
     }
-    if(!pos){
-        stopSong();
-        if(audio_showstation) audio_showstation("");
-        if(audio_icydescription) audio_icydescription("");
-        if(audio_icyurl) audio_icyurl("");
-        f_icyname = false;
-        f_icydescription = false;
-        f_icyurl = false;
-        log_e("can't see content in audioHeaderData");
-        return;
-    }
+    if(retryWithoutCachedEndpoint()) return;
+    stopSong();
+    if(audio_showstation) audio_showstation("");
+    if(audio_icydescription) audio_icydescription("");
+    if(audio_icyurl) audio_icyurl("");
+    f_icyname = false;
+    f_icydescription = false;
+    f_icyurl = false;
+    log_e("can't see content in audioHeaderData");
+    return;
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::parseHeaderLine(char* hl, int16_t idx, bool* f_icyname, bool* f_icydescription, bool* f_icyurl) {
+    // returns false if the header must not be read further (error, redirect)
 
-    idx = indexOf(hl, ":", 0); // lowercase all letters up to the colon
-    if(idx >= 0) {
-        for(int i=0; i< idx; i++) {
-            hl[i] = toLowerCase(hl[i]);
+    if(idx < 0) { // status line
+        if(indexOf(hl, "HTTP/1.0 404", 0) >= 0 || indexOf(hl, "HTTP/1.1 404", 0) >= 0) {
+            m_f_running = false;
+            if(retryWithoutCachedEndpoint()) return false;
+            stopSong();
+            if(audio_info) audio_info("404 Not Found");
+            return false;
+        }
+        if(indexOf(hl, "ICY 401", 0) >= 0) {
+            m_f_running = false;
+            if(retryWithoutCachedEndpoint()) return false;
+            stopSong();
+            if(audio_info) audio_info("ICY 401 Service Unavailable");
+            return false;
         }
     }
 
-    if(indexOf(hl, "HTTP/1.0 404", 0) >= 0) {
-        m_f_running = false;
-        stopSong();
-        if(audio_info) audio_info("404 Not Found");
-        return;
-    }
-
-    if(indexOf(hl, "HTTP/1.1 404", 0) >= 0) {
-        m_f_running = false;
-        stopSong();
-        if(audio_info) audio_info("404 Not Found");
-        return;
-    }
-
-    if(indexOf(hl, "ICY 401", 0) >= 0) {
-        m_f_running = false;
-        stopSong();
-        if(audio_info) audio_info("ICY 401 Service Unavailable");
-        return;
-    }
-
-    if(indexOf(hl, "content-type:", 0) >= 0) {
-        if(parseContentType(hl)) m_f_ctseen = true;
-    }
-    else if(startsWith(hl, "location:")) {
-        int pos = indexOf(hl, "http", 0);
-        const char* c_host = (hl + pos);
-        AUDIO_INFO(sprintf(chbuf, "redirect to new host \"%s\"", c_host);)
-        connecttohost(c_host);
-    }
-    else if(startsWith(hl, "content-disposition:")) {
-        int pos1, pos2; // pos3;
-        // e.g we have this headerline:  content-disposition: attachment; filename=stream.asx
-        // filename is: "stream.asx"
-        pos1 = indexOf(hl, "filename=", 0);
-        if(pos1 > 0){
-            pos1 += 9;
-            if(hl[pos1] == '\"') pos1++;  // remove '\"' around filename if present
-            pos2 = strlen(hl);
-            if(hl[pos2 - 1] == '\"') hl[pos2 - 1] = '\0';
-        }
-        log_d("Filename is %s", hl + pos1);
-    }
-    else if(startsWith(hl, "set-cookie:")    ||
-            startsWith(hl, "pragma:")        ||
-            startsWith(hl, "expires:")       ||
-            startsWith(hl, "cache-control:") ||
-            startsWith(hl, "icy-pub:")       ||
-            startsWith(hl, "p3p:")           ||
-            startsWith(hl, "accept-ranges:") ){
-        ; // do nothing
-    }
-    else if(startsWith(hl, "connection:")) {
-        if(indexOf(hl, "close", 0) >= 0) {; /* do nothing */}
-    }
-    else if(startsWith(hl, "icy-genre:")) {
-        ; // do nothing Ambient, Rock, etc
-    }
-    else if(startsWith(hl, "icy-br:")) {
-        const char* c_bitRate = (hl + 7);
-        int32_t br = atoi(c_bitRate); // Found bitrate tag, read the bitrate in Kbit
-        br = br * 1000;
-        setBitrate(br);
-        sprintf(chbuf, "%d", getBitRate());
-        if(audio_bitrate) audio_bitrate(chbuf);
-    }
-    else if(startsWith(hl, "icy-metaint:")) {
-        const char* c_metaint = (hl + 12);
-        int32_t i_metaint = atoi(c_metaint);
-        m_metaint = i_metaint;
-        if(m_metaint) m_f_swm = false     ;                            // Multimediastream
-    }
-    else if(startsWith(hl, "icy-name:")) {
-        char* c_icyname = (hl + 9); // Get station name
-        idx = 0;
-        while(c_icyname[idx] == ' '){idx++;} c_icyname += idx;        // Remove leading spaces
-        idx = strlen(c_icyname);
-        while(c_icyname[idx] == ' '){idx--;} c_icyname[idx + 1] = 0;  // Remove trailing spaces
-
-        if(strlen(c_icyname) > 0) {
-            AUDIO_INFO(sprintf(chbuf, "icy-name: %s", c_icyname);)
-            if(audio_showstation) audio_showstation(c_icyname);
-            f_icyname = true;
-        }
-    }
-    else if(startsWith(hl, "content-length:")) {
-        const char* c_cl = (hl + 15);
-        int32_t i_cl = atoi(c_cl);
-        m_contentlength = i_cl;
-        m_f_webfile = true; // Stream comes from a fileserver
-        if(m_f_Log) { AUDIO_INFO(sprintf(chbuf, "content-length: %i", m_contentlength);) }
-    }
-    else if(startsWith(hl, "icy-description:")) {
-        const char* c_idesc = (hl + 16);
-        while(c_idesc[0] == ' ') c_idesc++;
-        latinToUTF8(hl, sizeof(hl)); // if already UTF-0 do nothing, otherwise convert to UTF-8
-        if(audio_icydescription) audio_icydescription(c_idesc);
-        f_icydescription = true;
-    }
-    else if((startsWith(hl, "transfer-encoding:"))){
-        if(endsWith(hl, "chunked") || endsWith(hl, "Chunked") ) { // Station provides chunked transfer
-            m_f_chunked = true;
-            if(audio_info) audio_info("chunked data transfer");
-            m_chunkcount = 0;                         // Expect chunkcount in DATA
-        }
-    }
-    else if(startsWith(hl, "icy-url:")) {
-        const char* icyurl = (hl + 8);
-        idx = 0;
-        while(icyurl[idx] == ' ') {idx ++;} icyurl += idx; // remove leading blanks
-        //sprintf(chbuf, "icy-url: %s", icyurl);
-        // if(audio_info) audio_info(chbuf);
-        if(audio_icyurl) audio_icyurl(icyurl);
-        f_icyurl = true;
-    }
-    else if(startsWith(hl, "www-authenticate:")) {
-        if(audio_info) audio_info("authentification failed, wrong credentials?");
-        m_f_running = false;
-        stopSong();
-    }
-    else {
-        if(isascii(hl[0]) && hl[0] >= 0x20) {  // all other
-            if(m_f_Log) { AUDIO_INFO(sprintf(chbuf, "%s", hl);) }
+    switch(idx > 0 ? headerNameId(hl, idx) : HDR_UNKNOWN){
+        case HDR_CONTENT_TYPE: {
+            if(parseContentType(hl)) m_f_ctseen = true;
+            releaseArmedDecoder();
+            break;
+        }
+        case HDR_LOCATION: {
+            int pos = indexOf(hl, "http", 0);
+            const char* c_host = (hl + pos);
+            AUDIO_INFO(sprintf(chbuf, "redirect to new host \"%s\"", c_host);)
+            openStream(c_host);
+            return false;
+        }
+        case HDR_CONTENT_DISPOSITION: {
+            int pos1, pos2; // pos3;
+            // e.g we have this headerline:  content-disposition: attachment; filename=stream.asx
+            // filename is: "stream.asx"
+            pos1 = indexOf(hl, "filename=", 0);
+            if(pos1 > 0){
+                pos1 += 9;
+                if(hl[pos1] == '\"') pos1++;  // remove '\"' around filename if present
+                pos2 = strlen(hl);
+                if(hl[pos2 - 1] == '\"') hl[pos2 - 1] = '\0';
+            }
+            log_d("Filename is %s", hl + pos1);
+            break;
+        }
+        case HDR_IGNORE: // set-cookie, pragma, expires, cache-control, icy-pub, p3p, accept-ranges, connection, icy-genre
+            break;
+        case HDR_ICY_BR: {
+            const char* c_bitRate = (hl + 7);
+            int32_t br = atoi(c_bitRate); // Found bitrate tag, read the bitrate in Kbit
+            br = br * 1000;
+            setBitrate(br);
+            sprintf(chbuf, "%d", getBitRate());
+            if(audio_bitrate) audio_bitrate(chbuf);
+            break;
+        }
+        case HDR_ICY_METAINT: {
+            const char* c_metaint = (hl + 12);
+            int32_t i_metaint = atoi(c_metaint);
+            m_metaint = i_metaint;
+            if(m_metaint) m_f_swm = false     ;                            // Multimediastream
+            break;
+        }
+        case HDR_ICY_NAME: {
+            char* c_icyname = (hl + 9); // Get station name
+            idx = 0;
+            while(c_icyname[idx] == ' '){idx++;} c_icyname += idx;        // Remove leading spaces
+            idx = strlen(c_icyname);
+            while(c_icyname[idx] == ' '){idx--;} c_icyname[idx + 1] = 0;  // Remove trailing spaces
+
+            if(strlen(c_icyname) > 0) {
+                AUDIO_INFO(sprintf(chbuf, "icy-name: %s", c_icyname);)
+                if(audio_showstation) audio_showstation(c_icyname);
+                *f_icyname = true;
+            }
+            break;
+        }
+        case HDR_CONTENT_LENGTH: {
+            const char* c_cl = (hl + 15);
+            int32_t i_cl = atoi(c_cl);
+            m_contentlength = i_cl;
+            m_f_webfile = true; // Stream comes from a fileserver
+            if(m_f_Log) { AUDIO_INFO(sprintf(chbuf, "content-length: %i", m_contentlength);) }
+            break;
+        }
+        case HDR_ICY_DESCRIPTION: {
+            char desc[512];  // the conversion can grow, don't overwrite the next lines in m_hdrBuff
+            strcpy(desc, hl);
+            latinToUTF8(desc, sizeof(desc)); // if already UTF-8 do nothing, otherwise convert to UTF-8
+            const char* c_idesc = (desc + 16);
+            while(c_idesc[0] == ' ') c_idesc++;
+            if(audio_icydescription) audio_icydescription(c_idesc);
+            *f_icydescription = true;
+            break;
+        }
+        case HDR_TRANSFER_ENCODING: {
+            if(endsWith(hl, "chunked") || endsWith(hl, "Chunked") ) { // Station provides chunked transfer
+                m_f_chunked = true;
+                if(audio_info) audio_info("chunked data transfer");
+                m_chunkcount = 0;                         // Expect chunkcount in DATA
+            }
+            break;
+        }
+        case HDR_ICY_URL: {
+            const char* icyurl = (hl + 8);
+            idx = 0;
+            while(icyurl[idx] == ' ') {idx ++;} icyurl += idx; // remove leading blanks
+            //sprintf(chbuf, "icy-url: %s", icyurl);
+            // if(audio_info) audio_info(chbuf);
+            if(audio_icyurl) audio_icyurl(icyurl);
+            *f_icyurl = true;
+            break;
+        }
+        case HDR_WWW_AUTHENTICATE: {
+            if(audio_info) audio_info("authentification failed, wrong credentials?");
+            m_f_running = false;
+            stopSong();
+            return false;
+        }
+        default: {
+            if(isascii(hl[0]) && hl[0] >= 0x20) {  // all other
+                if(m_f_Log) { AUDIO_INFO(sprintf(chbuf, "%s", hl);) }
+            }
         }
     }
-    return;
+    return m_f_running;
 }
 
 //---------------------------------------------------------------------------------------------------------------------
 bool Audio::readMetadata(uint8_t b, bool first) {
 
-    static uint16_t pos_ml = 0;                          // determines the current position in metaline
-    static uint16_t metalen = 0;
+    uint16_t& pos_ml = m_meta.pos_ml;                    // determines the current position in metaline
+    uint16_t& metalen = m_meta.metalen;
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     if(first){
         pos_ml = 0;
@@ -3457,7 +4038,7 @@ bool Audio::readMetadata(uint8_t b, bool first) {
             // Isolate the StreamTitle, remove leading and trailing quotes if present.
             // log_i("ST %s", metaline);
 
-            latinToUTF8(chbuf, sizeof(chbuf)); // convert to UTF-8 if necessary
+            latinToUTF8(chbuf, CHBUF_SIZE); // convert to UTF-8 if necessary
 
             int pos = indexOf(chbuf, "song_spot", 0);    // remove some irrelevant infos
             if(pos > 3) {                                // e.g. song_spot="T" MediaBaseId="0" itunesTrackId="0"
@@ -3474,48 +4055,8 @@ bool Audio::parseContentType(const char* ct) {
     bool ct_seen = false;
     if(indexOf(ct, "audio", 0) >= 0) {        // Is ct audio?
         ct_seen = true;                       // Yes, remember seeing this
-        if(indexOf(ct, "mpeg", 13) >= 0) {
-            m_codec = CODEC_MP3;
-            AUDIO_INFO(sprintf(chbuf, "%s, format is mp3", ct);) //ok is likely mp3
-            if(!MP3Decoder_AllocateBuffers()) {m_f_running = false; stopSong(); return false;}
-            AUDIO_INFO(sprintf(chbuf, "MP3Decoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-            InBuff.changeMaxBlockSize(m_frameSizeMP3);
-        }
-        else if(indexOf(ct, "mp3", 13) >= 0) {
-            m_codec = CODEC_MP3;
-            AUDIO_INFO(sprintf(chbuf, "%s, format is mp3", ct);)
-            if(!MP3Decoder_AllocateBuffers()) {m_f_running = false; stopSong(); return false;}
-            AUDIO_INFO(sprintf(chbuf, "MP3Decoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-            InBuff.changeMaxBlockSize(m_frameSizeMP3);
-        }
-        else if(indexOf(ct, "aac", 13) >= 0) {      // audio/x-aac
-            m_codec = CODEC_AAC;
-            if(m_f_Log) { AUDIO_INFO(sprintf(chbuf, "%s, format is aac", ct);) }
-            if(!AACDecoder_IsInit()){
-                if(!AACDecoder_AllocateBuffers()) {m_f_running = false; stopSong(); return false;}
-                AUDIO_INFO(sprintf(chbuf, "AACDecoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-       }
-        else if(indexOf(ct, "mp4", 13) >= 0) {      // audio/mp4a, audio/mp4a-latm
-            m_codec = CODEC_M4A;
-            if(m_f_Log) { AUDIO_INFO(sprintf(chbuf, "%s, format is aac", ct);) }
-            if(!AACDecoder_IsInit()){
-                if(!AACDecoder_AllocateBuffers()) {m_f_running = false; stopSong(); return false;}
-                AUDIO_INFO(sprintf(chbuf, "AACDecoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-        }
-        else if(indexOf(ct, "m4a", 13) >= 0) {      // audio/x-m4a
-            m_codec = CODEC_M4A;
-            AUDIO_INFO(sprintf(chbuf, "%s, format is aac", ct);)
-            if(!AACDecoder_IsInit()){
-                if(!AACDecoder_AllocateBuffers()) {m_f_running = false; stopSong(); return false;}
-                AUDIO_INFO(sprintf(chbuf, "AACDecoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-        }
-        else if(indexOf(ct, "wav", 13) >= 0) {      // audio/x-wav
+        uint8_t codec = (strlen(ct) > 13) ? probeCodec(ct + 13) : (uint8_t)CODEC_NONE; // mpeg, mp3, aac, mp4, m4a, flac
+        if(indexOf(ct, "wav", 13) >= 0) {           // audio/x-wav
             m_codec = CODEC_WAV;
             AUDIO_INFO(sprintf(chbuf, "%s, format is wav", ct);)
             InBuff.changeMaxBlockSize(m_frameSizeWav);
@@ -3523,18 +4064,11 @@ bool Audio::parseContentType(const char* ct) {
         else if(indexOf(ct, "ogg", 13) >= 0) {
             m_codec = CODEC_OGG;
             AUDIO_INFO(sprintf(chbuf, "ContentType %s found", ct);)
+            if(!initOggDemuxer()) {m_f_running = false; stopSong(); return false;}
         }
-        else if(indexOf(ct, "flac", 13) >= 0) {     // audio/flac, audio/x-flac
-            m_codec = CODEC_FLAC;
-            AUDIO_INFO(sprintf(chbuf, "%s, format is flac", ct);)
-            if(!psramFound()){
-                if(audio_info) audio_info("FLAC works only with PSRAM!");
-                m_f_running = false;
-                return false;
-            }
-            if(!FLACDecoder_AllocateBuffers()) {m_f_running = false; stopSong(); return false;}
-            InBuff.changeMaxBlockSize(m_frameSizeFLAC);
-            AUDIO_INFO(sprintf(chbuf, "FLACDecoder has been initialized, free Heap: %u bytes", ESP.getFreeHeap());)
+        else if(codec != CODEC_NONE) {
+            if(m_f_Log) { AUDIO_INFO(sprintf(chbuf, "%s, format is %s", ct, codecname[codec]);) }
+            if(!selectCodec(codec)) {m_f_running = false; stopSong(); return false;}
         }
         else {
             m_f_running = false;
@@ -3547,6 +4081,7 @@ bool Audio::parseContentType(const char* ct) {
         if(indexOf(ct, "ogg", 13) >= 0) {
             m_codec = CODEC_OGG;
             AUDIO_INFO(sprintf(chbuf, "ContentType %s found", ct + pos);)
+            if(!initOggDemuxer()) {m_f_running = false; stopSong(); return false;}
         }
     }
     return ct_seen;
@@ -3630,25 +4165,123 @@ void Audio::showCodecParams(){
             audio_info("BitRate: N/A");
         }
 
+#ifndef AUDIO_NO_AAC
         if(m_codec == CODEC_AAC || m_codec == CODEC_M4A){
+            AACDecoder_t* dec = (AACDecoder_t*)m_codecCtx[CODEC_PLUGIN_AAC];
             uint8_t answ;
-            if((answ = AACGetFormat()) < 4){
+            if((answ = AACGetFormat(dec)) < 4){
                 const char hf[4][8] = {"unknown", "ADTS", "ADIF", "RAW"};
                 sprintf(chbuf, "AAC HeaderFormat: %s", hf[answ]);
                 audio_info(chbuf);
             }
             if(answ == 1){ // ADTS Header
                 const char co[2][23] = {"MPEG-4", "MPEG-2"};
-                sprintf(chbuf, "AAC Codec: %s", co[AACGetID()]);
+                sprintf(chbuf, "AAC Codec: %s", co[AACGetID(dec)]);
                 audio_info(chbuf);
-                if(AACGetProfile() <5){
+                if(AACGetProfile(dec) <5){
                     const char pr[4][23] = {"Main", "LowComplexity", "Scalable Sampling Rate", "reserved"};
                     sprintf(chbuf, "AAC Profile: %s", pr[answ]);
                     audio_info(chbuf);
                 }
             }
         }
+#endif // AUDIO_NO_AAC
+    }
+}
+//---------------------------------------------------------------------------------------------------------------------
+const codecPlugin_t* Audio::findCodecPlugin(uint8_t codec){
+    if(codec == CODEC_NONE) return NULL;
+    for(int i = 0; codecPlugins[i]; i++){
+        if(codecPlugins[i]->codecs[0] == codec || codecPlugins[i]->codecs[1] == codec) return codecPlugins[i];
     }
+    return NULL;
+}
+//---------------------------------------------------------------------------------------------------------------------
+uint8_t Audio::probeCodec(const char* type){
+    // type: content-type or file extension, the first registered decoder that knows it wins
+    for(int i = 0; codecPlugins[i]; i++){
+        if(!codecPlugins[i]->probe) continue;
+        uint8_t codec = codecPlugins[i]->probe(type);
+        if(codec != CODEC_NONE) return codec;
+    }
+    return CODEC_NONE;
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::initDecoder(const codecPlugin_t* p){
+    // creates the decoder context or resets the existing one (m3u8: the next chunk, a prepared decoder) and sets the
+    // input block size, the RAM it takes goes into the statistics
+    ArenaStats_t as;
+    ArenaGetStats(&as);
+    uint32_t arena = as.used;
+    uint32_t heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    void*& ctx = m_codecCtx[p->id];
+    if(ctx){
+        if(p->reset) p->reset(ctx);
+    }
+    else ctx = p->create();
+    if(!ctx){
+        AUDIO_INFO(sprintf(chbuf, "not enough RAM for the %sDecoder", p->name);)
+        return false;
+    }
+    ArenaGetStats(&as);
+    uint32_t used = heap - min(heap, (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT)) + as.used - min(arena, as.used);
+    if(used > m_codecStats[p->id].heap) m_codecStats[p->id].heap = used;
+    if(p->frameSize) InBuff.changeMaxBlockSize(p->frameSize);
+    else if(!setFLACInBuff(m_codec == CODEC_OGG_FLAC ? m_flacMaxFrameSize : 0)) return false;
+    return true;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::releaseDecoder(const codecPlugin_t* p){
+    if(!m_codecCtx[p->id]) return;
+    p->destroy(m_codecCtx[p->id]);
+    m_codecCtx[p->id] = NULL;
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::selectCodec(uint8_t codec){
+    // set m_codec and prepare its decoder, WAV and OGG (codec not yet known) have none
+    m_codec = codec;
+    m_plugin = findCodecPlugin(codec);
+    if(!m_plugin) return (codec == CODEC_WAV || codec == CODEC_OGG);
+    if(!initDecoder(m_plugin)) return false;
+    if(m_f_Log) {AUDIO_INFO(memStats_t ms; getMemStats(&ms);
+                            sprintf(chbuf, "%sDecoder has been initialized, free Heap: %u bytes, arena: %u of %u bytes",
+                                    m_plugin->name, ms.heapFree, ms.arenaUsed, ms.arenaSize);)}
+    return true;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::codecSetup(codecSetup_t* cs){
+    cs->codec         = m_codec;
+    cs->quality       = m_decodeQuality;
+    cs->downmix       = m_f_forceMono;
+    cs->dualCore      = m_f_decodeDualCore;
+    cs->crcCheck      = m_f_flacCRCCheck;
+    cs->stereoPS      = m_f_parametricStereo;
+    cs->channels      = m_flacNumChannels;
+    cs->bitsPerSample = m_flacBitsPerSample;
+    cs->sampleRate    = m_flacSampleRate;
+    cs->totalSamples  = m_flacTotalSamplesInStream;
+    cs->dataSize      = m_ogg ? 0 : m_audioDataSize;
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::getCodecStats(int codec, codecStats_t* stats){
+    const codecPlugin_t* p = findCodecPlugin(codec);
+    if(!p) return false;
+    if(stats) *stats = m_codecStats[p->id];
+    return true;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::getMemStats(memStats_t* stats){
+    // the arena and the internal heap, a high fragmentation (small largest block) is what lets big allocations fail
+    ArenaStats_t as;
+    ArenaGetStats(&as);
+    stats->arenaSize      = as.size;
+    stats->arenaUsed      = as.used;
+    stats->arenaHighWater = as.highWater;
+    stats->arenaMisses    = as.misses;
+    stats->heapFree       = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    stats->heapMinFree    = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    stats->heapLargest    = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    stats->heapFragmentation = stats->heapFree ? 100 - (uint64_t)stats->heapLargest * 100 / stats->heapFree : 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
 int Audio::findNextSync(uint8_t* data, size_t len){
@@ -3659,38 +4292,22 @@ int Audio::findNextSync(uint8_t* data, size_t len){
     //         > 0 is the offset to the next sync word
     //         -1 the sync word was not found within the block with the length len
 
-    int nextSync;
-    static uint32_t swnf = 0;
-    if(m_codec == CODEC_WAV)  {
-        m_f_playing = true; nextSync = 0;
-    }
-    if(m_codec == CODEC_MP3) {
-        nextSync = MP3FindSyncWord(data, len);
-    }
-    if(m_codec == CODEC_AAC) {
-        nextSync = AACFindSyncWord(data, len);
-    }
-    if(m_codec == CODEC_M4A) {
-        AACSetRawBlockParams(0, 2,44100, 1); m_f_playing = true; nextSync = 0;
-    }
-    if(m_codec == CODEC_FLAC) {
-        FLACSetRawBlockParams(m_flacNumChannels,   m_flacSampleRate,
-                              m_flacBitsPerSample, m_flacTotalSamplesInStream, m_audioDataSize);
-        nextSync = FLACFindSyncWord(data, len);
-    }
-    if(m_codec == CODEC_OGG_FLAC) {
-        FLACSetRawBlockParams(m_flacNumChannels,   m_flacSampleRate,
-                              m_flacBitsPerSample, m_flacTotalSamplesInStream, m_audioDataSize);
-        nextSync = FLACFindSyncWord(data, len);
-    }
+    int nextSync = 0;
+    uint32_t& swnf = m_dec.swnf;
+    codecSetup_t cs;
+    codecSetup(&cs);
+    if(m_ogg) {  // sync to the next page, the decoder gets whole packets
+        if(m_plugin && m_plugin->sync) m_plugin->sync(m_codecCtx[m_plugin->id], NULL, 0, &cs);
+        nextSync = OggInSync(m_ogg) ? 0 : OggFindSyncWord(data, len);
+        if(nextSync == -1 && len > 5) nextSync = len - 5;  // keep a possible begin of "OggS"
+    }
+    else if(m_plugin && m_plugin->sync) {
+        nextSync = m_plugin->sync(m_codecCtx[m_plugin->id], data, len, &cs);
+    }
+    // else WAV, no frames
     if(nextSync == -1) {
          if(audio_info && swnf == 0) audio_info("syncword not found");
-         if(m_codec == CODEC_OGG_FLAC){
-             nextSync = len;
-         }
-         else {
-             swnf++; // syncword not found counter, can be multimediadata
-         }
+         swnf++; // syncword not found counter, can be multimediadata
      }
      if (nextSync == 0){
          if(audio_info && swnf>0){
@@ -3710,7 +4327,7 @@ int Audio::findNextSync(uint8_t* data, size_t len){
 //---------------------------------------------------------------------------------------------------------------------
 int Audio::sendBytes(uint8_t* data, size_t len) {
     int bytesLeft;
-    static bool f_setDecodeParamsOnce = true;
+    bool& f_setDecodeParamsOnce = m_dec.f_setDecodeParamsOnce;
     int nextSync = 0;
     if(!m_f_playing) {
         f_setDecodeParamsOnce = true;
@@ -3719,22 +4336,42 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
         return nextSync;
     }
     // m_f_playing is true at this pos
+    bool f_ogg = (m_ogg != NULL);
+    if(f_ogg){  // the codec gets whole packets, page headers and packets spanning pages are handled by the demuxer
+        int res = readOggPacket(&data, &len);
+        if(res || !len) return res;
+    }
     bytesLeft = len;
     int ret = 0;
     int bytesDecoded = 0;
-    if(m_codec == CODEC_WAV){ //copy len data in outbuff and set validsamples and bytesdecoded=len
+    uint32_t t0 = micros();
+    if(!m_plugin){ // WAV: copy len data in outbuff and set validsamples and bytesdecoded=len
         memmove(m_outBuff, data , len);
         if(getBitsPerSample() == 16) m_validSamples = len / (2 * getChannels());
         if(getBitsPerSample() == 8 ) m_validSamples = len / 2;
         bytesLeft = 0;
     }
-    if(m_codec == CODEC_MP3)      ret = MP3Decode(data, &bytesLeft, m_outBuff, 0);
-    if(m_codec == CODEC_AAC)      ret = AACDecode(data, &bytesLeft, m_outBuff);
-    if(m_codec == CODEC_M4A)      ret = AACDecode(data, &bytesLeft, m_outBuff);
-    if(m_codec == CODEC_FLAC)     ret = FLACDecode(data, &bytesLeft, m_outBuff);
-    if(m_codec == CODEC_OGG_FLAC) ret = FLACDecode(data, &bytesLeft, m_outBuff); // FLAC webstream wrapped in OGG
+    else{
+        codecSetup_t cs;
+        codecSetup(&cs);
+        void* ctx = m_codecCtx[m_plugin->id];
+        if(m_plugin->configure) m_plugin->configure(ctx, &cs);
+        ret = m_plugin->decode(ctx, data, &bytesLeft, m_outBuff);
+        codecStats_t* st = &m_codecStats[m_plugin->id];
+        uint32_t us = micros() - t0;
+        st->frames++;
+        st->decodeUs += us;
+        if(us > st->maxUs) st->maxUs = us;
+        if(ret < 0) st->errors++;
+    }
 
     bytesDecoded = len - bytesLeft;
+    if(f_ogg && (ret < 0 || (bytesDecoded == 0 && ret == 0))){ // the pages are intact, only this packet is lost
+        if(ret < 0) printDecodeError(ret);
+        if(m_plugin->reset) m_plugin->reset(m_codecCtx[m_plugin->id]);
+        return OggPacketDrop(m_ogg);
+    }
+    int bytesUsed = f_ogg ? OggPacketUsed(m_ogg, bytesDecoded) : bytesDecoded; // Ogg: 0 if the packet was copied
     if(bytesDecoded == 0 && ret == 0){ // unlikely framesize
             if(audio_info) audio_info("framesize is 0, start decoding again");
             m_f_playing = false; // seek for new syncword
@@ -3756,39 +4393,43 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
         return bytesDecoded;
     }
     else{  // ret>=0
+        if(m_plugin) m_plugin->frameInfo(m_codecCtx[m_plugin->id], &m_frameInfo);
         if(f_setDecodeParamsOnce){
             f_setDecodeParamsOnce = false;
             m_PlayingStartTime = millis();
 
-            if(m_codec == CODEC_MP3){
-                setChannels(MP3GetChannels());
-                setSampleRate(MP3GetSampRate());
-                setBitsPerSample(MP3GetBitsPerSample());
-                setBitrate(MP3GetBitrate());
-            }
-            if(m_codec == CODEC_AAC || m_codec == CODEC_M4A){
-                setChannels(AACGetChannels());
-                setSampleRate(AACGetSampRate());
-                setBitsPerSample(AACGetBitsPerSample());
-                setBitrate(AACGetBitrate());
-            }
-            if(m_codec == CODEC_FLAC || m_codec == CODEC_OGG_FLAC){
-                setChannels(FLACGetChannels());
-                setSampleRate(FLACGetSampRate());
-                setBitsPerSample(FLACGetBitsPerSample());
-                setBitrate(FLACGetBitRate());
+            if(m_plugin){
+                setChannels(m_frameInfo.channels);
+                setSampleRate(m_frameInfo.sampleRate);
+                setBitsPerSample(m_frameInfo.bitsPerSample);
+                setBitrate(m_frameInfo.bitRate);
             }
             showCodecParams();
+            if(m_f_webstream) updateStreamProfile();
+            m_decodeQualitySet = m_decodeQuality;
         }
-        if(m_codec == CODEC_MP3){
-            m_validSamples = MP3GetOutputSamps() / getChannels();
+        else if(m_decodeQualitySet != m_decodeQuality){ // the quality level can change the samplerate
+            m_decodeQualitySet = m_decodeQuality;
+            uint32_t sr = m_plugin ? m_frameInfo.sampleRate : 0;
+            if(sr && sr != getSampleRate()) setSampleRate(sr);
         }
-        if((m_codec == CODEC_AAC) || (m_codec == CODEC_M4A)){
-            m_validSamples = AACGetOutputSamps() / getChannels();
+        if(m_plugin && m_frameInfo.channels && m_frameInfo.channels != getChannels()){ // HE-AACv2: mono up to the
+            setChannels(m_frameInfo.channels);                                          // first PS header
+            AUDIO_INFO(sprintf(chbuf, "Channels: %i", getChannels());)
         }
-        if((m_codec == CODEC_FLAC) || (m_codec == CODEC_OGG_FLAC)){
-            m_validSamples = FLACGetOutputSamps() / getChannels();
+        if(m_plugin){
+            m_validSamples = m_frameInfo.outputSamps / getChannels();
         }
+        if(m_flacSamplesToSkip && m_plugin && m_plugin->id == CODEC_PLUGIN_FLAC){
+            // after setAudioPlayPosition(), drop the samples in front of the seek target
+            uint32_t d = m_frameInfo.sampleRate ? m_flacSampleRate / m_frameInfo.sampleRate : 1; // > 1 if rate limited
+            if(!d) d = 1;
+            uint16_t skip = min((uint32_t)m_validSamples, (m_flacSamplesToSkip + d - 1) / d);
+            m_flacSamplesToSkip -= min(m_flacSamplesToSkip, skip * d);
+            m_validSamples -= skip;
+            memmove(m_outBuff, m_outBuff + 2 * skip, m_validSamples * 2 * sizeof(int16_t));
+        }
+        checkDecodeLoad(micros() - t0);
     }
     compute_audioCurrentTime(bytesDecoded);
 
@@ -3796,26 +4437,43 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
         bool continueI2S = false;
         audio_process_extern(m_outBuff, m_validSamples, &continueI2S);
         if(!continueI2S){
-            return bytesDecoded;
+            return bytesUsed;
         }
     }
 
     while(m_validSamples) {
         playChunk();
     }
-    return bytesDecoded;
+    return bytesUsed;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::checkDecodeLoad(uint32_t us) {
+    // compares the decode time with the play time of the decoded samples, about once per second of audio
+    // the level is raised if the load is above m_decodeLoadLimit and lowered again below the half of it
+    if(!m_decodeLoadLimit) return;
+    m_decodeUs += us;
+    m_decodeSamples += m_validSamples;
+    if(!getSampleRate() || m_decodeSamples < getSampleRate()) return;
+
+    uint32_t load = (uint64_t)m_decodeUs * getSampleRate() / m_decodeSamples / 10000; // percent
+    uint8_t level = m_decodeQuality;
+    if(load > m_decodeLoadLimit && level < 2) level++;
+    else if(load < m_decodeLoadLimit / 2 && level > m_decodeQualityMin) level--;
+    if(level != m_decodeQuality) {
+        AUDIO_INFO(sprintf(chbuf, "decode load %u%%, quality level %u -> %u", load, m_decodeQuality, level);)
+        m_decodeQuality = level;
+    }
+    m_decodeUs = 0;
+    m_decodeSamples = 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
 void Audio::compute_audioCurrentTime(int bd) {
-    static uint16_t loop_counter = 0;
-    static int old_bitrate = 0;
-    static uint64_t sum_bitrate = 0;
-    static boolean f_CBR = true; // constant bitrate
-
-    if(m_codec == CODEC_MP3) {setBitrate(MP3GetBitrate()) ;} // if not CBR, bitrate can be changed
-    if(m_codec == CODEC_M4A) {setBitrate(AACGetBitrate()) ;} // if not CBR, bitrate can be changed
-    if(m_codec == CODEC_AAC) {setBitrate(AACGetBitrate()) ;} // if not CBR, bitrate can be changed
-    if(m_codec == CODEC_FLAC){setBitrate(FLACGetBitRate());} // if not CBR, bitrate can be changed
+    uint16_t& loop_counter = m_dec.loop_counter;
+    int&      old_bitrate  = m_dec.old_bitrate;
+    uint64_t& sum_bitrate  = m_dec.sum_bitrate;
+    bool&     f_CBR        = m_dec.f_CBR; // constant bitrate
+
+    if(m_plugin) setBitrate(m_frameInfo.bitRate); // if not CBR, bitrate can be changed
     if(!getBitRate()) return;
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -3860,74 +4518,8 @@ void Audio::compute_audioCurrentTime(int bd) {
 }
 //---------------------------------------------------------------------------------------------------------------------
 void Audio::printDecodeError(int r) {
-    const char *e;
-
-    if(m_codec == CODEC_MP3){
-        switch(r){
-            case ERR_MP3_NONE:                              e = "NONE";                             break;
-            case ERR_MP3_INDATA_UNDERFLOW:                  e = "INDATA_UNDERFLOW";                 break;
-            case ERR_MP3_MAINDATA_UNDERFLOW:                e = "MAINDATA_UNDERFLOW";               break;
-            case ERR_MP3_FREE_BITRATE_SYNC:                 e = "FREE_BITRATE_SYNC";                break;
-            case ERR_MP3_OUT_OF_MEMORY:                     e = "OUT_OF_MEMORY";                    break;
-            case ERR_MP3_NULL_POINTER:                      e = "NULL_POINTER";                     break;
-            case ERR_MP3_INVALID_FRAMEHEADER:               e = "INVALID_FRAMEHEADER";              break;
-            case ERR_MP3_INVALID_SIDEINFO:                  e = "INVALID_SIDEINFO";                 break;
-            case ERR_MP3_INVALID_SCALEFACT:                 e = "INVALID_SCALEFACT";                break;
-            case ERR_MP3_INVALID_HUFFCODES:                 e = "INVALID_HUFFCODES";                break;
-            case ERR_MP3_INVALID_DEQUANTIZE:                e = "INVALID_DEQUANTIZE";               break;
-            case ERR_MP3_INVALID_IMDCT:                     e = "INVALID_IMDCT";                    break;
-            case ERR_MP3_INVALID_SUBBAND:                   e = "INVALID_SUBBAND";                  break;
-            default: e = "ERR_UNKNOWN";
-        }
-        AUDIO_INFO(sprintf(chbuf, "MP3 decode error %d : %s", r, e);)
-     }
-    if(m_codec == CODEC_AAC){
-        switch(r){
-            case ERR_AAC_NONE:                              e = "NONE";                             break;
-            case ERR_AAC_INDATA_UNDERFLOW:                  e = "INDATA_UNDERFLOW";                 break;
-            case ERR_AAC_NULL_POINTER:                      e = "NULL_POINTER";                     break;
-            case ERR_AAC_INVALID_ADTS_HEADER:               e = "INVALID_ADTS_HEADER";              break;
-            case ERR_AAC_INVALID_ADIF_HEADER:               e = "INVALID_ADIF_HEADER";              break;
-            case ERR_AAC_INVALID_FRAME:                     e = "INVALID_FRAME";                    break;
-            case ERR_AAC_MPEG4_UNSUPPORTED:                 e = "MPEG4_UNSUPPORTED";                break;
-            case ERR_AAC_CHANNEL_MAP:                       e = "CHANNEL_MAP";                      break;
-            case ERR_AAC_SYNTAX_ELEMENT:                    e = "SYNTAX_ELEMENT";                   break;
-            case ERR_AAC_DEQUANT:                           e = "DEQUANT";                          break;
-            case ERR_AAC_STEREO_PROCESS:                    e = "STEREO_PROCESS";                   break;
-            case ERR_AAC_PNS:                               e = "PNS";                              break;
-            case ERR_AAC_SHORT_BLOCK_DEINT:                 e = "SHORT_BLOCK_DEINT";                break;
-            case ERR_AAC_TNS:                               e = "TNS";                              break;
-            case ERR_AAC_IMDCT:                             e = "IMDCT";                            break;
-            case ERR_AAC_SBR_INIT:                          e = "SBR_INIT";                         break;
-            case ERR_AAC_SBR_BITSTREAM:                     e = "SBR_BITSTREAM";                    break;
-            case ERR_AAC_SBR_DATA:                          e = "SBR_DATA";                         break;
-            case ERR_AAC_SBR_PCM_FORMAT:                    e = "SBR_PCM_FORMAT";                   break;
-            case ERR_AAC_SBR_NCHANS_TOO_HIGH:               e = "SBR_NCHANS_TOO_HIGH";              break;
-            case ERR_AAC_SBR_SINGLERATE_UNSUPPORTED:        e = "BR_SINGLERATE_UNSUPPORTED";        break;
-            case ERR_AAC_NCHANS_TOO_HIGH:                   e = "NCHANS_TOO_HIGH";                  break;
-            case ERR_AAC_RAWBLOCK_PARAMS:                   e = "RAWBLOCK_PARAMS";                  break;
-            default: e = "ERR_UNKNOWN";
-        }
-        AUDIO_INFO(sprintf(chbuf, "AAC decode error %d : %s", r, e);)
-    }
-    if(m_codec == CODEC_FLAC){
-        switch(r){
-            case ERR_FLAC_NONE:                             e = "NONE";                             break;
-            case ERR_FLAC_BLOCKSIZE_TOO_BIG:                e = "BLOCKSIZE TOO BIG";                break;
-            case ERR_FLAC_RESERVED_BLOCKSIZE_UNSUPPORTED:   e = "Reserved Blocksize unsupported";   break;
-            case ERR_FLAC_SYNC_CODE_NOT_FOUND:              e = "SYNC CODE NOT FOUND";              break;
-            case ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT:       e = "UNKNOWN CHANNEL ASSIGNMENT";       break;
-            case ERR_FLAC_RESERVED_CHANNEL_ASSIGNMENT:      e = "RESERVED CHANNEL ASSIGNMENT";      break;
-            case ERR_FLAC_RESERVED_SUB_TYPE:                e = "RESERVED SUB TYPE";                break;
-            case ERR_FLAC_PREORDER_TOO_BIG:                 e = "PREORDER TOO BIG";                 break;
-            case ERR_FLAC_RESERVED_RESIDUAL_CODING:         e = "RESERVED RESIDUAL CODING";         break;
-            case ERR_FLAC_WRONG_RICE_PARTITION_NR:          e = "WRONG RICE PARTITION NR";          break;
-            case ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG:          e = "BITS PER SAMPLE > 16";             break;
-            case ERR_FLAG_BITS_PER_SAMPLE_UNKNOWN:          e = "BITS PER SAMPLE UNKNOWN";          break;
-            default: e = "ERR_UNKNOWN";
-        }
-        AUDIO_INFO(sprintf(chbuf, "FLAC decode error %d : %s", r, e);)
-    }
+    if(!m_plugin) return;
+    AUDIO_INFO(sprintf(chbuf, "%s decode error %d : %s", m_plugin->name, r, m_plugin->errorText(r));)
 }
 //---------------------------------------------------------------------------------------------------------------------
 bool Audio::setPinout(uint8_t BCLK, uint8_t LRC, uint8_t DOUT, int8_t DIN) {
@@ -3978,7 +4570,9 @@ uint32_t Audio::getAudioFileDuration() {
     else if(m_avr_bitrate && m_codec == CODEC_WAV)   m_audioFileDuration = 8 * (m_audioDataSize / m_avr_bitrate);
     else if(m_avr_bitrate && m_codec == CODEC_M4A)   m_audioFileDuration = 8 * (m_audioDataSize / m_avr_bitrate);
     else if(m_avr_bitrate && m_codec == CODEC_AAC)   m_audioFileDuration = 8 * (m_audioDataSize / m_avr_bitrate);
-    else if(                 m_codec == CODEC_FLAC)  m_audioFileDuration = FLACGetAudioFileDuration();
+    else if(m_flacSampleRate && m_flacTotalSamplesInStream && m_codec == CODEC_FLAC)
+                                                     m_audioFileDuration = m_flacTotalSamplesInStream / m_flacSampleRate;
+    else if(m_avr_bitrate && m_codec == CODEC_FLAC)  m_audioFileDuration = 8 * (m_audioDataSize / m_avr_bitrate);
     else return 0;
     return m_audioFileDuration;
 }
@@ -3990,14 +4584,109 @@ uint32_t Audio::getAudioCurrentTime() {  // return current time in seconds
 bool Audio::setAudioPlayPosition(uint16_t sec){
     // Jump to an absolute position in time within an audio file
     // e.g. setAudioPlayPosition(300) sets the pointer at pos 5 min
-    // works only with format mp3 or wav
+    // works only with format mp3, wav or flac, flac is sample accurate
     if(m_codec == CODEC_M4A)  return false;
     if(sec > getAudioFileDuration()) sec = getAudioFileDuration();
+    if(m_codec == CODEC_FLAC) return flacSeekToSample((uint64_t)sec * m_flacSampleRate);
     uint32_t filepos = m_audioDataStart + (m_avr_bitrate * sec / 8);
 
     return setFilePos(filepos);
 }
 //---------------------------------------------------------------------------------------------------------------------
+int32_t Audio::flacNextFrame(uint32_t pos, uint32_t end, uint32_t* firstSample){
+    // search the first valid FLAC frame header in the file between pos and end
+    // Return: file position of the frame, -1 if there is none
+#if defined AUDIO_NO_SD_FS || defined AUDIO_NO_FLAC
+    return -1;
+#else
+    uint8_t buf[256];
+    const int hdrMax = 16;                                  // max length of a frame header
+    while(pos < end){
+        if(!audiofile.seek(pos)) return -1;
+        int n = audiofile.read(buf, sizeof(buf));
+        if(n <= 0) return -1;
+        int last = (n == sizeof(buf)) ? n - hdrMax : n - 1;
+        for(int i = 0; i < last; i++){
+            if(pos + i >= end) return -1;
+            if(buf[i] != 0xFF || (buf[i + 1] & 0xFE) != 0xF8) continue;
+            if(FLACParseFrameHeader(buf + i, n - i, m_flacMaxBlockSize, firstSample)) return pos + i;
+        }
+        if(n < (int)sizeof(buf)) return -1;
+        pos += last;
+    }
+    return -1;
+#endif // AUDIO_NO_SD_FS, AUDIO_NO_FLAC
+}
+//---------------------------------------------------------------------------------------------------------------------
+bool Audio::flacSeekToSample(uint64_t target){
+    // Jump to the frame that contains 'sample', the samples in front of it are dropped in sendBytes().
+    // The SEEKTABLE (if any) gives the nearest points before and after the target, the rest is found by
+    // bisection over the frame headers, so only a few hundred bytes have to be read per step.
+#ifdef AUDIO_NO_SD_FS
+    return false;
+#else
+    if(!audiofile || !m_flacSampleRate || !m_flacMaxBlockSize) return false;
+    // seconds * samplerate is 64 bit, past 6h at 192kHz it does not fit in 32 bits
+    if(m_flacTotalSamplesInStream && target >= m_flacTotalSamplesInStream) target = m_flacTotalSamplesInStream - 1;
+    if(target > UINT32_MAX) target = UINT32_MAX;
+    uint32_t sample = target;
+
+    uint32_t oldPos     = getFilePos();
+    uint32_t lowPos     = m_audioDataStart;
+    uint32_t lowSample  = 0;
+    uint32_t highPos    = m_audioDataStart + m_audioDataSize;
+
+    if(m_flacSeekPoints){ // binary search in seektable
+        int lo = 0, hi = m_flacSeekPoints;
+        while(lo < hi){
+            int mid = (lo + hi) / 2;
+            if(m_flacSeekTable[mid].sample <= sample) lo = mid + 1;
+            else hi = mid;
+        }
+        if(lo > 0){
+            uint32_t fs = 0;
+            uint32_t pos = m_audioDataStart + m_flacSeekTable[lo - 1].offset;
+            if(flacNextFrame(pos, pos + 1, &fs) == (int32_t)pos && fs == m_flacSeekTable[lo - 1].sample){
+                lowPos = pos;
+                lowSample = fs;
+            }
+            else log_i("FLAC seekpoint %i does not match, ignored", lo - 1);
+        }
+        if(lo < m_flacSeekPoints && m_audioDataStart + m_flacSeekTable[lo].offset > lowPos){
+            uint32_t pos = m_audioDataStart + m_flacSeekTable[lo].offset;
+            if(pos < highPos) highPos = pos;
+        }
+    }
+
+    uint32_t fs = 0;
+    int32_t  found = flacNextFrame(lowPos, lowPos + 1, &fs);
+    if(found < 0){ // first frame is not valid, no chance
+        audiofile.seek(oldPos);
+        return false;
+    }
+    lowSample = fs;
+
+    while(highPos - lowPos > 2 * (uint32_t)max(m_flacMaxFrameSize, (uint16_t)4096)){ // bisection
+        uint32_t mid = lowPos + (highPos - lowPos) / 2;
+        found = flacNextFrame(mid, highPos, &fs);
+        if(found < 0)          {highPos = mid; continue;}
+        if(fs <= sample)       {lowPos = found; lowSample = fs;}
+        else                   {highPos = found;}
+    }
+    while(true){ // the rest frame by frame
+        found = flacNextFrame(lowPos + 1, highPos, &fs);
+        if(found < 0 || fs > sample) break;
+        lowPos = found;
+        lowSample = fs;
+    }
+
+    setFilePos(lowPos);
+    m_flacSamplesToSkip = sample - lowSample;
+    m_audioCurrentTime = (float)sample / m_flacSampleRate;
+    return true;
+#endif // AUDIO_NO_SD_FS
+}
+//---------------------------------------------------------------------------------------------------------------------
 uint32_t Audio::getTotalPlayingTime() {
     // Is set to zero by a connectToXXX() and starts as soon as the first audio data is available,
     // the time counting is not interrupted by a 'pause / resume' and is not reset by a fileloop
@@ -4010,6 +4699,11 @@ bool Audio::setTimeOffset(int sec){
 
 #ifndef AUDIO_NO_SD_FS
 
+    if(audiofile && m_codec == CODEC_FLAC && m_flacSampleRate){ // sample accurate, see flacSeekToSample()
+        int32_t t = (int32_t)m_audioCurrentTime + sec;
+        if(t < 0) t = 0;
+        return flacSeekToSample((uint64_t)t * m_flacSampleRate);
+    }
     if(!audiofile || !m_avr_bitrate) return false;
 
     uint32_t oneSec  = m_avr_bitrate / 8;                   // bytes decoded in one sec
@@ -4037,9 +4731,10 @@ bool Audio::setFilePos(uint32_t pos) {
 //    if(!m_avr_bitrate) return false;
     if(m_codec == CODEC_M4A) return false;
     m_f_playing = false;
-    if(m_codec == CODEC_MP3) MP3Decoder_ClearBuffer();
+    if(m_plugin && m_plugin->reset) m_plugin->reset(m_codecCtx[m_plugin->id]);
     if(m_codec == CODEC_WAV) {while((pos % 4) != 0) pos++;} // must be divisible by four
-    if(m_codec == CODEC_FLAC) FLACDecoderReset();
+    if(m_ogg) OggDemuxer_Reset(m_ogg);
+    m_flacSamplesToSkip = 0;
     InBuff.resetBuffer();
     if(pos < m_audioDataStart) pos = m_audioDataStart; // issue #96
     if(m_avr_bitrate) m_audioCurrentTime = ((pos-m_audioDataStart) / m_avr_bitrate) * 8; // #96
@@ -4060,6 +4755,8 @@ bool Audio::audioFileSeek(const float speed) {
 //---------------------------------------------------------------------------------------------------------------------
 bool Audio::setSampleRate(uint32_t sampRate) {
     if(!sampRate) sampRate = 16000; // fuse, if there is no value -> set default #209
+    if(m_f_i2sArmed && sampRate == m_sampleRate) {m_f_i2sArmed = false; return true;} // set by preArmStreamProfile()
+    m_f_i2sArmed = false;
     i2s_set_sample_rates((i2s_port_t)m_i2s_num, sampRate);
     m_sampleRate = sampRate;
     IIR_calculateCoefficients(m_gain0, m_gain1, m_gain2); // must be recalculated after each samplerate change
@@ -4193,6 +4890,42 @@ void Audio::forceMono(bool m) { // #100 mono option
     m_f_forceMono = m; // false stereo, true mono
 }
 //---------------------------------------------------------------------------------------------------------------------
+void Audio::setDecodeQuality(uint8_t level) {
+    // 0: full quality
+    // 1: MP3 above 13.8kHz (at 44.1kHz) dropped, HE-AAC without SBR at the core rate, FLAC above 48kHz decimated
+    // 2: as 1, MP3 keeps 16 subbands and is synthesized at half the rate
+    // with setDecodeLoadLimit() this is the lowest level used, takes effect with the next frame
+    if(level > 2) level = 2;
+    m_decodeQualityMin = level;
+    if(!m_decodeLoadLimit || m_decodeQuality < level) m_decodeQuality = level;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::setDecodeLoadLimit(uint8_t percent) {
+    // e.g. 60: while decoding takes more than 60% of the play time the quality level is raised step by step,
+    // below 30% it returns towards the level of setDecodeQuality()
+    if(percent > 100) percent = 100;
+    m_decodeLoadLimit = percent;
+    if(!percent) m_decodeQuality = m_decodeQualityMin;
+    m_decodeUs = 0;
+    m_decodeSamples = 0;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::setDecodeDualCore(bool on) {
+    // the worker task is started with the next MP3 frame on the core loop() is not running on, one priority above
+    // the caller. Only stereo granules are split, and only while that is measured to be faster than one core
+    m_f_decodeDualCore = on;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::setFlacCRCCheck(bool on) {
+    // a damaged frame is dropped instead of played as noise, the check costs 6...12% of the FLAC decode time (host)
+    m_f_flacCRCCheck = on;
+}
+//---------------------------------------------------------------------------------------------------------------------
+void Audio::setParametricStereo(bool on) {
+    // off saves the PS share of the HE-AACv2 decode time, takes effect with the next frame
+    m_f_parametricStereo = on;
+}
+//---------------------------------------------------------------------------------------------------------------------
 void Audio::setBalance(int8_t bal){ // bal -16...16
     if(bal < -16) bal = -16;
     if(bal >  16) bal =  16;
@@ -4351,7 +5084,7 @@ int16_t* Audio::IIR_filterChain0(int16_t iir_in[2], bool clear){  // Infinite Im
     enum: uint8_t {in = 0, out = 1};
     float inSample[2];
     float outSample[2];
-    static int16_t iir_out[2];
+    int16_t* iir_out = m_iirOut[0];
 
     if(clear){
         memset(m_filterBuff, 0, sizeof(m_filterBuff));            // zero IIR filterbuffer
@@ -4398,7 +5131,7 @@ int16_t* Audio::IIR_filterChain1(int16_t iir_in[2], bool clear){  // Infinite Im
     enum: uint8_t {in = 0, out = 1};
     float inSample[2];
     float outSample[2];
-    static int16_t iir_out[2];
+    int16_t* iir_out = m_iirOut[1];
 
     if(clear){
         memset(m_filterBuff, 0, sizeof(m_filterBuff));            // zero IIR filterbuffer
@@ -4445,7 +5178,7 @@ int16_t* Audio::IIR_filterChain2(int16_t iir_in[2], bool clear){  // Infinite Im
     enum: uint8_t {in = 0, out = 1};
     float inSample[2];
     float outSample[2];
-    static int16_t iir_out[2];
+    int16_t* iir_out = m_iirOut[2];
 
     if(clear){
         memset(m_filterBuff, 0, sizeof(m_filterBuff));            // zero IIR filterbuffer
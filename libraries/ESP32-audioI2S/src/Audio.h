@@ -117,7 +117,8 @@ public:
     size_t   init();                            // set default values
     bool     isInitialized() { return m_f_init; };
     void     setBufsize(int ram, int psram);
-    void     changeMaxBlockSize(uint16_t mbs);  // is default 1600 for mp3 and aac, set 16384 for FLAC
+    void     changeMaxBlockSize(uint16_t mbs);  // is default 1600 for mp3 and aac, set 25600 for FLAC
+    bool     setMaxFrameSizeRAM(size_t mfs);    // without PSRAM: make room for frames of mfs bytes, 0 = default
     uint16_t getMaxBlockSize();                 // returns maxBlockSize
     size_t   freeSpace();                       // number of free bytes to overwrite
     size_t   writeSpace();                      // space fom writepointer to bufferend
@@ -139,7 +140,8 @@ protected:
     size_t   m_writeSpace       = 0;
     size_t   m_dataLength       = 0;
     size_t   m_resBuffSizeRAM   = 1600;     // reserved buffspace, >= one mp3  frame
-    size_t   m_resBuffSizePSRAM = 4096 * 4; // reserved buffspace, >= one flac frame
+    size_t   m_resBuffSizePSRAM = 4096 * 6 + 1024; // reserved buffspace, >= one flac frame
+    size_t   m_resBuffSize      = 0;        // reserved buffspace in use
     size_t   m_maxBlockSize     = 1600;
     uint8_t* m_buffer           = NULL;
     uint8_t* m_writePtr         = NULL;
@@ -150,6 +152,72 @@ protected:
     bool     m_f_psram          = false;    // PSRAM is available (and used...)
 };
 //----------------------------------------------------------------------------------------------------------------------
+// The decoders are plugged in through codecPlugin_t, see the registry codecPlugins[] in Audio.cpp. Define AUDIO_NO_MP3,
+// AUDIO_NO_AAC, AUDIO_NO_FLAC or AUDIO_NO_OPUS to leave a decoder out, the linker then drops its code and tables.
+
+typedef struct _codecSetup{                         // what a decoder gets from the player
+    uint8_t  codec;                                 // Audio::CODEC_xxx of the stream
+    uint8_t  quality;                               // decode quality level in use, see setDecodeQuality()
+    bool     downmix;                               // forceMono()
+    bool     dualCore;                              // setDecodeDualCore()
+    bool     crcCheck;                              // setFlacCRCCheck()
+    bool     stereoPS;                              // setParametricStereo()
+    uint8_t  channels;                              // container parameters (STREAMINFO) for streams without them
+    uint8_t  bitsPerSample;                         // in the frame headers
+    uint32_t sampleRate;
+    uint32_t totalSamples;
+    uint32_t dataSize;                              // bytes of audio data, 0 if unknown
+} codecSetup_t;
+
+typedef struct _codecFrameInfo{                     // parameters of the last decoded frame
+    uint32_t sampleRate;
+    uint32_t bitRate;
+    uint16_t outputSamps;                           // samples of all channels
+    uint8_t  channels;
+    uint8_t  bitsPerSample;
+} codecFrameInfo_t;
+
+typedef struct _codecPlugin{                        // hooks that a decoder does not need are NULL
+    const char* name;
+    uint8_t  id;                                    // CODEC_PLUGIN_xxx, index of the statistics and contexts
+    uint8_t  codecs[2];                             // Audio::CODEC_xxx decoded by this plugin
+    uint16_t frameSize;                             // max block of the input buffer, 0: from the container (FLAC)
+    uint8_t  (*probe)(const char* type);            // content-type or file extension -> Audio::CODEC_xxx, CODEC_NONE
+                                                    // NULL: only found in a container (Ogg)
+    void*    (*create)();                           // decoder context of one Audio object, NULL: not enough memory
+    void     (*destroy)(void* ctx);
+    void     (*reset)(void* ctx);                   // new position in the stream, after a seek or a lost packet
+    int      (*sync)(void* ctx, uint8_t* data, int len, const codecSetup_t* cs); // offset of the next frame, -1 not
+                                                    // found, data NULL: the container is in sync, only take cs
+    void     (*configure)(void* ctx, const codecSetup_t* cs);  // called before each frame
+    int      (*header)(void* ctx, uint8_t* data, int len);     // codec header packet of the container (OpusHead)
+    int      (*decode)(void* ctx, uint8_t* data, int* bytesLeft, int16_t* outbuf); // < 0 error, > 0 more frames
+    void     (*frameInfo)(void* ctx, codecFrameInfo_t* fi);
+    const char* (*errorText)(int err);
+    size_t   (*bufferSize)();                       // bytes create() takes from the arena
+} codecPlugin_t;
+
+typedef struct _codecStats{                         // per decoder since the Audio object was created
+    uint32_t frames;                                // decoded frames
+    uint32_t errors;                                // frames with a decode error
+    uint64_t decodeUs;                              // time spent in decode()
+    uint32_t maxUs;                                 // slowest frame
+    uint32_t heap;                                  // RAM taken by the decoder buffers (arena and heap), the largest
+} codecStats_t;
+
+typedef struct _memStats{                           // see getMemStats()
+    uint32_t arenaSize;                             // reserved for the decoder and pipeline buffers, 0: no arena
+    uint32_t arenaUsed;
+    uint32_t arenaHighWater;                        // most bytes in use since the Audio object was created
+    uint32_t arenaMisses;                           // buffers that did not fit and were taken from the heap
+    uint32_t heapFree;                              // internal RAM
+    uint32_t heapMinFree;                           // lowest free heap since boot, the high-water mark of its use
+    uint32_t heapLargest;                           // largest free block
+    uint8_t  heapFragmentation;                     // percent of the free heap outside the largest block
+} memStats_t;
+
+enum : uint8_t { CODEC_PLUGIN_MP3, CODEC_PLUGIN_AAC, CODEC_PLUGIN_FLAC, CODEC_PLUGIN_OPUS, CODEC_PLUGINS };
+//----------------------------------------------------------------------------------------------------------------------
 
 class Audio : private AudioBuffer{
 
@@ -167,6 +235,9 @@ public:
 #endif                           // AUDIO_NO_SD_FS
     bool setFileLoop(bool input);//TEST loop
     void setConnectionTimeout(uint16_t timeout_ms, uint16_t timeout_ms_ssl);
+    void clearStreamProfiles(); // forget all learned station parameters (RAM and NVS)
+    void getEndpointCacheStats(uint32_t* hits, uint32_t* misses, uint32_t* savedMs);
+    void getStreamProfileStats(uint32_t* hits, uint32_t* misses, uint32_t* hitMs, uint32_t* missMs);
     bool setAudioPlayPosition(uint16_t sec);
     bool setFilePos(uint32_t pos);
     bool audioFileSeek(const float speed);
@@ -177,6 +248,12 @@ public:
     void loop();
     uint32_t stopSong();
     void forceMono(bool m);
+    void setDecodeQuality(uint8_t level);      // 0 full ... 2 lowest, trades bandwidth for CPU time
+    void setDecodeLoadLimit(uint8_t percent);  // raise the quality level while decoding takes longer, 0 = off
+    uint8_t getDecodeQuality() {return m_decodeQuality;}
+    void setDecodeDualCore(bool on);           // MP3: second channel of stereo frames decoded on the other core
+    void setFlacCRCCheck(bool on);             // FLAC: drop frames with a wrong CRC-16 before output, default off
+    void setParametricStereo(bool on);         // HE-AACv2: decode the PS data, off plays these streams in mono
     void setBalance(int8_t bal = 0);
     void setVolume(uint8_t vol);
     uint8_t getVolume();
@@ -202,13 +279,18 @@ public:
     const char *getCodecname() {return codecname[m_codec];}
     enum : int { CODEC_NONE, CODEC_WAV, CODEC_MP3, CODEC_AAC, CODEC_M4A, CODEC_FLAC, CODEC_OGG,
                  CODEC_OGG_FLAC, CODEC_OGG_OPUS};
+    bool getCodecStats(int codec, codecStats_t* stats); // false if no decoder of codec is built in
+    void getMemStats(memStats_t* stats);
 
 private:
     void UTF8toASCII(char* str);
     bool latinToUTF8(char* buff, size_t bufflen);
     void httpPrint(const char* url);
+    bool openStream(const char* host, const char* user = "", const char* pwd = "");
     void setDefaults(); // free buffers and set defaults
+    void resetPipelineState();
     void initInBuff();
+    bool setFLACInBuff(size_t maxFrameSize);
 #ifndef AUDIO_NO_SD_FS
     void processLocalFile();
 #endif // AUDIO_NO_SD_FS
@@ -217,17 +299,38 @@ private:
     void processM3U8entries(uint8_t nrOfEntries = 0, uint32_t seqNr = 0, uint8_t pos = 0, uint16_t targetDuration = 0);
     bool STfromEXTINF(char* str);
     void showCodecParams();
+    const codecPlugin_t* findCodecPlugin(uint8_t codec);
+    uint8_t probeCodec(const char* type);
+    bool selectCodec(uint8_t codec);
+    bool initDecoder(const codecPlugin_t* p);
+    void releaseDecoder(const codecPlugin_t* p);
+    void codecSetup(codecSetup_t* cs);
     int  findNextSync(uint8_t* data, size_t len);
     int  sendBytes(uint8_t* data, size_t len);
+    void checkDecodeLoad(uint32_t us);
     void compute_audioCurrentTime(int bd);
     void printDecodeError(int r);
+    bool loadStreamProfiles();
+    const char* cachedEndpoint();
+    bool retryWithoutCachedEndpoint();
+    void preArmStreamProfile();
+    void updateStreamProfile();
+    void storeStreamProfile();
+    void releaseArmedDecoder();
     void showID3Tag(const char* tag, const char* val);
     void unicode2utf8(char* buff, uint32_t len);
     int  read_WAV_Header(uint8_t* data, size_t len);
     int  read_FLAC_Header(uint8_t *data, size_t len);
+    bool parseFLACStreamInfo(uint8_t* data);
+    int32_t flacNextFrame(uint32_t pos, uint32_t end, uint32_t* firstSample);
+    bool flacSeekToSample(uint64_t target);
     int  read_MP3_Header(uint8_t* data, size_t len);
     int  read_M4A_Header(uint8_t* data, size_t len);
-    int  read_OGG_Header(uint8_t *data, size_t len);
+    bool initOggDemuxer();
+    int  readOggPacket(uint8_t** data, size_t* len);
+    bool readOggFLACHeader(uint8_t* pkt, size_t len);
+    bool readOggOpusHead(uint8_t* pkt, size_t len);
+    void readOggComments(uint8_t* data, size_t len);
     bool setSampleRate(uint32_t hz);
     bool setBitsPerSample(int bits);
     bool setChannels(int channels);
@@ -240,6 +343,11 @@ private:
     void showstreamtitle(const char* ml);
     bool parseContentType(const char* ct);
     void processAudioHeaderData();
+    bool parseHeaderLine(char* hl, int16_t idx, bool* f_icyname, bool* f_icydescription, bool* f_icyurl);
+    uint8_t headerNameId(const char* name, uint8_t len);
+    int  readStream(uint8_t* buff, size_t len);
+    int  readStream();
+    int  streamAvailable();
     bool readMetadata(uint8_t b, bool first = false);
     esp_err_t I2Sstart(uint8_t i2s_num);
     esp_err_t I2Sstop(uint8_t i2s_num);
@@ -344,6 +452,11 @@ private:
         }
         return result;
     }
+    uint32_t simpleHash(const char* str){ // FNV-1a, 0 is reserved for 'no hash'
+        uint32_t hash = 2166136261UL;
+        while(*str) {hash ^= (uint8_t)*str++; hash *= 16777619UL;}
+        return hash ? hash : 1;
+    }
     size_t bigEndian(uint8_t* base, uint8_t numBytes, uint8_t shiftLeft = 8){
         size_t result = 0;
         if(numBytes < 1 or numBytes > 4) return 0;
@@ -383,11 +496,16 @@ private:
     enum : int { FORMAT_NONE = 0, FORMAT_M3U = 1, FORMAT_PLS = 2, FORMAT_ASX = 3, FORMAT_M3U8 = 4};
     enum : int { AUDIO_NONE, AUDIO_HEADER, AUDIO_DATA,
                  AUDIO_PLAYLISTINIT, AUDIO_PLAYLISTHEADER,  AUDIO_PLAYLISTDATA};
+    enum : int { HDR_UNKNOWN, HDR_IGNORE, HDR_CONTENT_TYPE, HDR_LOCATION, HDR_CONTENT_DISPOSITION, HDR_ICY_BR,
+                 HDR_ICY_METAINT, HDR_ICY_NAME, HDR_CONTENT_LENGTH, HDR_ICY_DESCRIPTION, HDR_TRANSFER_ENCODING,
+                 HDR_ICY_URL, HDR_WWW_AUTHENTICATE};
     enum : int { FLAC_BEGIN = 0, FLAC_MAGIC = 1, FLAC_MBH =2, FLAC_SINFO = 3, FLAC_PADDING = 4, FLAC_APP = 5,
-                 FLAC_SEEK = 6, FLAC_VORBIS = 7, FLAC_CUESHEET = 8, FLAC_PICTURE = 9, FLAC_OKAY = 100};
+                 FLAC_SEEK = 6, FLAC_VORBIS = 7, FLAC_CUESHEET = 8, FLAC_PICTURE = 9, FLAC_SEEKPOINTS = 10,
+                 FLAC_OKAY = 100};
     enum : int { M4A_BEGIN = 0, M4A_FTYP = 1, M4A_CHK = 2, M4A_MOOV = 3, M4A_FREE = 4, M4A_TRAK = 5, M4A_MDAT = 6,
                  M4A_ILST = 7, M4A_MP4A = 8, M4A_AMRDY = 99, M4A_OKAY = 100};
-    enum : int { OGG_BEGIN = 0, OGG_MAGIC = 1, OGG_HEADER = 2, OGG_FIRST = 3, OGG_AMRDY = 99, OGG_OKAY = 100};
+    enum : int { STREAM_PROFILES = 8, ENDPOINT_TTL = 24 * 3600 /* seconds */ };
+    enum : int { CHBUF_SIZE = 512 + 128, LASTHOST_SIZE = 512, OUTBUFF_SIZE = 2048 * 2 /* samples */ };
     typedef enum { LEFTCHANNEL=0, RIGHTCHANNEL=1 } SampleIndex;
     typedef enum { LOWSHELF = 0, PEAKEQ = 1, HIFGSHELF =2 } FilterType;
 
@@ -402,6 +520,120 @@ private:
         float b2;
     } filter_t;
 
+    typedef struct _streamProfile{                  // learned parameters of a station, stored in NVS
+        uint32_t urlHash;                           // hash of the url given to connecttohost(), 0: slot is empty
+        uint32_t sampleRate;
+        uint32_t bitRate;
+        uint32_t metaint;
+        uint32_t lastUse;                           // for replacement of the least recently used entry
+        uint32_t resolvedTime;                      // unix time of the resolution of resolvedUrl, 0: clock not set
+        uint32_t resolveTime;                       // ms spent in redirects and playlists to get resolvedUrl
+        uint8_t  codec;
+        uint8_t  channels;
+        uint8_t  bitsPerSample;
+        char     resolvedUrl[256];                  // final endpoint after redirects and playlists, "" if none or too long
+    } streamProfile_t;
+    streamProfile_t* findStreamProfile();
+
+    typedef struct _flacSeekPoint{
+        uint32_t sample;                            // first sample of the target frame
+        uint32_t offset;                            // byte offset of the target frame, relative to the first frame
+    } flacSeekPoint_t;
+
+    // State of the pipeline that belongs to one connection, reset together by resetPipelineState(). The groups that
+    // are touched on every loop() come first, the header parsers and playlists that run once per connection last.
+    typedef struct _rxState{                        // processWebStream(), processLocalFile()
+        uint32_t byteCounter;                       // count received data
+        uint32_t metacount;                         // counts down bytes between metadata
+        uint32_t chunksize;                         // chunkcount read from stream
+        uint32_t tmr_1s;                            // timer 1 sec
+        uint32_t loopCnt;                           // count loops if clientbuffer is empty
+        int      bytesDecoded;
+        bool     f_stream;                          // first audio data received
+        bool     f_tmr_1s;
+        uint8_t  cnt_slow;                          // polls with an almost empty buffer within one second
+        uint8_t  avbIdx;                            // debug log: bytes available in the last 10 polls
+        uint16_t avb[10];
+        uint32_t avbT;
+        uint32_t avbT0;                             // begin of a poll sequence without data
+    } rxState_t;
+
+    typedef struct _decState{                       // sendBytes(), findNextSync(), compute_audioCurrentTime()
+        uint64_t sum_bitrate;
+        int      old_bitrate;
+        uint32_t swnf;                              // sync word not found, counts the retries
+        uint16_t loop_counter;
+        bool     f_CBR = true;                      // constant bitrate
+        bool     f_setDecodeParamsOnce = true;
+    } decState_t;
+
+    typedef struct _metaState{                      // readMetadata(), processAudioHeaderData()
+        uint16_t pos_ml;                            // current position in metaline
+        uint16_t metalen;
+        bool     f_icyname;                         // icy-name, icy-description, icy-url seen in this header
+        bool     f_icydescription;
+        bool     f_icyurl;
+    } metaState_t;
+
+    typedef struct _fileHdrState{                   // read_WAV_Header(), read_FLAC_Header(), ...
+        struct {
+            size_t   headerSize;
+            uint32_t cs;
+            uint8_t  bts;
+        } wav;
+        struct {
+            size_t   headerSize;
+            size_t   retvalue;
+            size_t   seekBytesLeft;
+            uint16_t seekPointNr;
+            uint16_t seekStride;
+            bool     f_lastMetaBlock;
+        } flac;
+        struct {
+            size_t   id3Size;
+            size_t   headerSize;
+            size_t   framesize;
+            size_t   APIC_size;
+            uint32_t APIC_pos;
+            int      ehsz;
+            uint8_t  ID3version;
+            char     tag[5];
+            char     frameid[5];
+            bool     compressed;
+            bool     APIC_seen;
+        } id3;
+        struct {
+            size_t   headerSize;
+            size_t   retvalue;
+            size_t   atomsize;
+            size_t   audioDataPos;
+        } m4a;
+    } fileHdrState_t;
+
+    typedef struct _plsState{                       // processPlayListData()
+        uint32_t seqNr;                             // m3u8: sequence number of the first entry
+        uint16_t targetDuration;                    // m3u8: #EXT-X-TARGETDURATION
+        uint8_t  plsEntry;                          // m3u8: counts url entries
+        uint8_t  seqNrPos;                          // m3u8: position at which the SeqNr is found
+        bool     f_entry;                           // entryflag for asx playlist
+        bool     f_title;                           // titleflag for asx playlist
+        bool     f_ref;                             // refflag   for asx playlist
+        bool     f_begin;
+        bool     f_end;
+        bool     f_ct;
+        bool     f_StreamInf;                       // m3u8: #EXT-X-STREAM-INF seen
+        bool     f_ExtInf;                          // m3u8: #EXTINF seen
+    } plsState_t;
+
+    typedef struct _m3u8State{                      // processM3U8entries(), kept over the chunks of one playlist
+        uint32_t currentSeqNr;
+        uint32_t sequenceNr;
+        uint32_t maxSeqNr;
+        uint16_t targetDuration;
+        uint8_t  nrOfEntries;
+        uint8_t  sequenceNrPos;
+    } m3u8State_t;
+
 #ifndef AUDIO_NO_SD_FS
     File              audiofile;    // @suppress("Abstract class cannot be instantiated")
 #endif                              // AUDIO_NO_SD_FS
@@ -412,12 +644,13 @@ private:
     i2s_pin_config_t  m_pin_config;
 
     const size_t    m_frameSizeWav  = 1600;
-    const size_t    m_frameSizeMP3  = 1600;
-    const size_t    m_frameSizeAAC  = 1600;
-    const size_t    m_frameSizeFLAC = 4096 * 4;
+    const size_t    m_frameSizeFLAC = 4096 * 6 + 1024;  // 4096 samples 24 bit stereo, verbatim
 
-    char            chbuf[512 + 128];               // must be greater than m_lastHost #254
-    char            m_lastHost[512];                // Store the last URL to a webstream
+    char*           chbuf = NULL;                   // CHBUF_SIZE, must be greater than m_lastHost #254
+    char*           m_lastHost = NULL;              // LASTHOST_SIZE, Store the last URL to a webstream
+    char            m_hdrBuff[512];                 // response header, received in blocks
+    uint16_t        m_hdrLen = 0;                   // bytes in m_hdrBuff
+    uint16_t        m_hdrPos = 0;                   // first byte in m_hdrBuff not yet processed
     char*           m_playlistBuff = NULL;          // stores playlistdata
     const uint16_t  m_plsBuffEntryLen = 256;        // length of each entry in playlistBuff
     filter_t        m_filter[3];                    // digital filters
@@ -436,8 +669,12 @@ private:
     uint8_t         m_playlistFormat = 0;           // M3U, PLS, ASX
     uint8_t         m_m3u8codec = CODEC_NONE;       // M4A
     uint8_t         m_codec = CODEC_NONE;           //
+    const codecPlugin_t* m_plugin = NULL;           // decoder of m_codec, NULL: none (WAV) or not yet known (OGG)
+    void*           m_codecCtx[CODEC_PLUGINS] = {}; // decoder contexts of this object, created by initDecoder()
+    codecFrameInfo_t m_frameInfo;                   // of the last decoded frame
+    codecStats_t    m_codecStats[CODEC_PLUGINS] = {}; // see getCodecStats()
     uint8_t         m_filterType[2];                // lowpass, highpass
-    int16_t         m_outBuff[2048*2];              // Interleaved L/R
+    int16_t*        m_outBuff = NULL;               // OUTBUFF_SIZE, Interleaved L/R
     int16_t         m_validSamples = 0;
     int16_t         m_curSample = 0;
     uint16_t        m_datamode = 0;                 // Statemaschine
@@ -451,6 +688,37 @@ private:
     uint16_t        m_flacMaxFrameSize = 0;         // can be read out in the FLAC file header
     uint16_t        m_flacMaxBlockSize = 0;         // can be read out in the FLAC file header
     uint32_t        m_flacTotalSamplesInStream = 0; // can be read out in the FLAC file header
+    streamProfile_t* m_streamProfiles = NULL;       // profile cache, STREAM_PROFILES entries
+    uint32_t        m_stationHash = 0;              // simpleHash() of the url given to connecttohost()
+    uint32_t        m_connectTime = 0;              // millis() at connecttohost(), for time to first sample
+    uint32_t        m_openTime = 0;                 // millis() at the last openStream()
+    char*           m_stationUrl = NULL;            // url given to connecttohost()
+    char*           m_stationUser = NULL;           // user and password given to connecttohost(), for a retry
+    char*           m_stationPwd = NULL;
+    uint32_t        m_endpointHits = 0;             // connects with the cached endpoint
+    uint32_t        m_endpointMisses = 0;           // full resolutions of a known station
+    uint32_t        m_endpointSavedMs = 0;          // sum of the resolution times skipped by endpoint hits
+    bool            m_f_endpointCached = false;     // connected to the cached endpoint of the station
+    int8_t          m_profileSlot = -1;             // slot of m_streamProfiles to be written to NVS, -1: none
+    uint32_t        m_profileHits = 0;              // first frames with a pre-armed decoder
+    uint32_t        m_profileMisses = 0;            // first frames without
+    uint32_t        m_profileHitMs = 0;             // sum of the times to the first frame of the hits
+    uint32_t        m_profileMissMs = 0;            // sum of the times to the first frame of the misses
+    uint8_t         m_armedCodec = CODEC_NONE;      // decoder prepared by preArmStreamProfile()
+    bool            m_f_i2sArmed = false;           // I2S samplerate is set by preArmStreamProfile()
+    flacSeekPoint_t* m_flacSeekTable = NULL;        // SEEKTABLE metadata block, thinned out if too big
+    struct OggDemuxer* m_ogg = NULL;                // Ogg container of CODEC_OGG and CODEC_OGG_xxx
+    uint16_t        m_flacSeekPoints = 0;           // number of entries in m_flacSeekTable
+    uint32_t        m_flacSamplesToSkip = 0;        // samples to drop after a seek to reach the exact position
+    uint8_t         m_decodeQualityMin = 0;         // set by setDecodeQuality()
+    uint8_t         m_decodeQuality = 0;            // level in use, raised above the minimum by the load limit
+    uint8_t         m_decodeQualitySet = 0;         // level the output samplerate was taken with
+    uint8_t         m_decodeLoadLimit = 0;          // decode time in percent of the play time, 0: no automatic level
+    uint32_t        m_decodeUs = 0;                 // decode time since the last load check
+    uint32_t        m_decodeSamples = 0;            // samples decoded since the last load check
+    bool            m_f_decodeDualCore = false;     // set by setDecodeDualCore()
+    bool            m_f_flacCRCCheck = false;       // set by setFlacCRCCheck()
+    bool            m_f_parametricStereo = true;    // set by setParametricStereo()
     uint32_t        m_metaint = 0;                  // Number of databytes between metadata
     uint32_t        m_chunkcount = 0 ;              // Counter for chunked transfer
     uint32_t        m_t0 = 0;                       // store millis(), is needed for a small delay
@@ -485,6 +753,13 @@ private:
     uint32_t        m_audioDataStart = 0;           // in bytes
     size_t          m_audioDataSize = 0;            //
     float           m_filterBuff[3][2][2][2];       // IIR filters memory for Audio DSP
+    int16_t         m_iirOut[3][2] = {};            // output sample of IIR_filterChain0...2
+    rxState_t       m_rx = {};                      // pipeline state of one connection, see resetPipelineState()
+    decState_t      m_dec = {};
+    metaState_t     m_meta = {};
+    fileHdrState_t  m_fileHdr = {};
+    plsState_t      m_pls = {};
+    m3u8State_t     m_m3u8 = {};
     size_t          m_i2s_bytesWritten = 0;         // set in i2s_write() but not used
     size_t          m_file_size = 0;                // size of the file
     uint16_t        m_filterFrequency[2];
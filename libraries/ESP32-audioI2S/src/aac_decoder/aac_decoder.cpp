@@ -7,6 +7,9 @@
  ************************************************************************************/
 
 #include "aac_decoder.h"
+#include "../audio_arena/audio_arena.h"
+#include "../audio_sync/audio_sync.h"
+#include <mutex>
 
 const uint32_t SQRTHALF             = 0x5a82799a;    /* sqrt(0.5), format = Q31 */
 const uint32_t Q28_2                = 0x20000000;    /* Q28: 2.0 */
@@ -34,6 +37,7 @@ const uint8_t  MAX_NCHANS_ELEM      = 2;             /* max number of channels i
 const uint8_t  MAX_NUM_PCE_ADIF     = 16;
 const uint8_t  ADIF_COPYID_SIZE     = 9;
 const uint8_t  HUFFTAB_SPEC_OFFSET  = 1;
+const uint8_t  HUFF_FAST_BITS       = 8;             /* bits per probe of the fast spectral Huffman tables */
 const uint8_t  FBITS_OUT_DQ_OFF     = 20 - 15;       /* (FBITS_OUT_DQ - SF_DQ_OFFSET)  */
 const uint8_t  GBITS_IN_DCT4        = 4;             /* min guard bits in for DCT4 */
 const uint8_t  FBITS_LOST_DCT4      = 1;             /* number of fraction bits lost (>> out) in DCT-IV */
@@ -70,21 +74,23 @@ const uint8_t  FBITS_OUT_DQ_ENV     = 29;            /* dequantized env scalefac
 const uint8_t  FBITS_GLIM_BOOST     = 24;
 const uint8_t  FBITS_QLIM_BOOST     = 14;
 const uint8_t  MIN_GBITS_IN_QMFS    = 2;
+const uint8_t  EXT_ID_PS            = 2;             /* bs_extension_id of parametric stereo */
+const uint8_t  NUM_HYBRID_BANDS     = 71;            /* PS: 10 sub-subbands of QMF bands 0...2, QMF bands 3...63 */
+const uint8_t  NUM_ALLPASS_BANDS    = 30;            /* PS: decorrelated by allpass filters, above by delays */
+const uint8_t  SHORT_DELAY_BAND     = 42;            /* PS: delay of 14 slots below, of 1 slot from here */
 const uint16_t nmdctTab[2]          = {128, 1024};
 const uint8_t  postSkip[2]          = {15, 1};
 const uint16_t nfftTab[2]           = {64, 512};
 const uint8_t  nfftlog2Tab[2]       = {6, 9};
 const uint8_t  cos4sin4tabOffset[2] = {0, 128};
 
-PSInfoBase_t        *m_PSInfoBase;
-AACDecInfo_t        *m_AACDecInfo;
-AACFrameInfo_t       m_AACFrameInfo;
-ADTSHeader_t         m_fhADTS;
-ADIFHeader_t         m_fhADIF;
-ProgConfigElement_t *m_pce[16];
-PulseInfo_t          m_pulseInfo[2]; // [MAX_NCHANS_ELEM]
-aac_BitStreamInfo_t  m_aac_BitStreamInfo;
-PSInfoSBR_t         *m_PSInfoSBR;
+/* The decoder state lives in a AACDecoder_t context. The API functions make their context the current one of the
+ * calling task, all internal functions work on m_dec. */
+static thread_local AACDecoder_t *m_dec = NULL;
+static AACDecoder_t *m_defaultDec = NULL;   // used by the API without context
+static uint32_t *m_huffSpecFast = NULL;     // fast spectral Huffman tables, shared by all contexts
+static uint8_t   m_huffSpecFastUsers = 0;
+static std::mutex m_huffSpecFastLock;       // the contexts can be created and destroyed on different tasks
 
 //----------------------------------------------------------------------------------------------------------------------
 inline int MULSHIFT32(int x, int y){
@@ -115,6 +121,9 @@ inline int FASTABS(int x){
     x ^= sign; x -= sign; return x;
 #endif
 }
+inline int AVG2(int x, int y){ /* floor((x + y) / 2) without overflow */
+    return (x >> 1) + (y >> 1) + (x & y & 1);
+}
 inline int64_t MADD64(int64_t sum64, int x, int y){
     sum64 += (int64_t)x * (int64_t)y;
     return sum64;
@@ -675,7 +684,7 @@ const int kbdWindow[128 + 1024] PROGMEM = {
 };
 /* bit reverse tables for FFT */
 const uint8_t bitrevtabOffset[NUM_IMDCT_SIZES] PROGMEM = {0, 17};
-const uint8_t bitrevtab[17 + 129] PROGMEM = {
+const uint8_t bitrevtab[17 + 129] AAC_DRAM = {
 /* nfft = 64 */
 0x01, 0x08, 0x02, 0x04, 0x03, 0x0c, 0x05, 0x0a, 0x07, 0x0e, 0x0b, 0x0d, 0x00, 0x06, 0x09, 0x0f,
 0x00,
@@ -901,7 +910,7 @@ const int log2Tab[65] PROGMEM = {
     0x60000000
 };
 
-const HuffInfo_t huffTabSpecInfo[11] PROGMEM = {
+const HuffInfo_t huffTabSpecInfo[11] AAC_DRAM = {
     /* table 0 not used */
     {11, {  1,  0,  0,  0,  8,  0, 24,  0, 24,  8, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0},   0},
     { 9, {  0,  0,  1,  1,  7, 24, 15, 19, 14,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},  81},
@@ -916,7 +925,7 @@ const HuffInfo_t huffTabSpecInfo[11] PROGMEM = {
     {12, {  0,  0,  0,  2,  6,  7, 16, 59, 55, 95, 43,  6,  0,  0,  0,  0,  0,  0,  0,  0}, 952},
 };
 
-const short huffTabSpec[1241] PROGMEM = {
+const short huffTabSpec[1241] AAC_DRAM = {
     /* spectrum table 1 [81] (signed) */
     0x0000, 0x0200, 0x0e00, 0x0007, 0x0040, 0x0001, 0x0038, 0x0008, 0x01c0, 0x03c0, 0x0e40, 0x0039, 0x0078, 0x01c8, 0x000f, 0x0240,
     0x003f, 0x0fc0, 0x01f8, 0x0238, 0x0047, 0x0e08, 0x0009, 0x0208, 0x01c1, 0x0048, 0x0041, 0x0e38, 0x0201, 0x0e07, 0x0207, 0x0e01,
@@ -1558,6 +1567,349 @@ static const int invBandTab[64] PROGMEM = {
     0x023ee090, 0x0234f72c, 0x022b63cc, 0x02222222, 0x02192e2a, 0x02108421, 0x02082082, 0x02000000,
 };
 
+#ifdef AAC_ENABLE_PS
+/* parametric stereo Huffman codes (8.B.1) as {symbol, length}, in code order: the codes of one table are consecutive
+ * binary numbers, the left-aligned code is found by adding up the code intervals (see DecodePSSymbol())
+ * iid_df1, iid_dt1 (fine quantization), iid_df0, iid_dt0, icc_df, icc_dt
+ */
+static const uint8_t huffTabPS[210][2] PROGMEM = {
+    /* iid_df1 [61] */
+    {28, 4}, {32, 4}, {29, 3}, {31, 3}, {27, 5}, {33, 5}, {26, 6}, {34, 6},
+    {25, 7}, {35, 7}, {24, 8}, {36, 8}, {37, 9}, {40,11}, {19,12}, {41,12},
+    {22,10}, {38,10}, { 9,17}, {51,17}, {11,17}, {49,17}, {13,16}, {47,16},
+    {16,14}, {18,13}, {42,13}, {44,14}, {12,17}, {48,17}, { 4,18}, { 5,18},
+    { 2,18}, { 3,18}, {15,15}, {21,11}, {39,11}, {45,15}, { 8,18}, {52,18},
+    { 6,18}, { 7,18}, {55,18}, {56,18}, {53,18}, {54,18}, {17,14}, {43,14},
+    {59,18}, {60,18}, {57,18}, {58,18}, { 0,18}, { 1,18}, {10,18}, {50,18},
+    {14,16}, {46,16}, {20,12}, {23,10}, {30, 1},
+    /* iid_dt1 [61] */
+    {31, 2}, {26, 7}, {34, 7}, {27, 6}, {33, 6}, {35, 8}, {24, 9}, {36, 9},
+    {39,11}, {41,12}, { 9,15}, {10,15}, {48,15}, {49,15}, {17,13}, {23,10},
+    {37,10}, {43,13}, {11,15}, {12,15}, { 4,16}, {56,16}, { 2,16}, { 3,16},
+    {59,16}, {60,16}, {57,16}, {58,16}, { 0,16}, { 1,16}, { 5,16}, {55,16},
+    { 6,16}, {54,16}, {13,15}, {15,14}, {20,12}, {40,12}, {22,11}, {38,11},
+    {45,14}, {47,15}, { 7,16}, {53,16}, {18,13}, {42,13}, {16,14}, {44,14},
+    { 8,16}, {52,16}, {14,15}, {46,15}, {50,16}, {51,16}, {19,13}, {21,12},
+    {25, 9}, {28, 5}, {32, 5}, {29, 3}, {30, 1},
+    /* iid_df0 [29] */
+    {14, 1}, {15, 3}, {13, 3}, {16, 4}, {12, 4}, {17, 5}, {11, 5}, {10, 6},
+    {18, 6}, {19, 6}, { 9, 7}, {20, 8}, { 8, 9}, { 7,10}, {21,11}, {22,13},
+    { 6,13}, {23,14}, {24,14}, { 5,15}, {25,15}, { 4,16}, { 3,17}, { 0,17},
+    { 1,17}, { 2,17}, {26,17}, {27,18}, {28,18},
+    /* iid_dt0 [29] */
+    {14, 1}, {13, 2}, {15, 3}, {12, 4}, {16, 5}, {11, 6}, {17, 7}, {10, 8},
+    {18, 9}, { 9,10}, {19,11}, { 8,12}, {20,13}, {21,14}, { 7,15}, {22,17},
+    { 6,17}, {23,19}, { 0,19}, { 1,19}, { 2,19}, { 3,20}, { 4,20}, { 5,20},
+    {24,20}, {25,20}, {26,20}, {27,20}, {28,20},
+    /* icc_df [15] */
+    { 7, 1}, { 8, 2}, { 6, 3}, { 9, 4}, { 5, 5}, {10, 6}, { 4, 7}, {11, 8},
+    {12, 9}, { 3,10}, {13,11}, { 2,12}, {14,13}, { 1,14}, { 0,14},
+    /* icc_dt [15] */
+    { 7, 1}, { 8, 2}, { 6, 3}, { 9, 4}, { 5, 5}, {10, 6}, { 4, 7}, {11, 8},
+    { 3, 9}, {12,10}, { 2,11}, {13,12}, { 1,13}, { 0,14}, {14,14},
+};
+
+/* offset, number of codes, longest code and largest absolute value of the tables in huffTabPS */
+static const uint8_t huffTabPSInfo[6][4] PROGMEM = {
+    {  0, 61, 18, 30}, { 61, 61, 16, 30}, {122, 29, 18, 14}, {151, 29, 20, 14}, {180, 15, 14,  7}, {195, 15, 14,  7},
+};
+
+/* parameter bands of iid_mode/icc_mode 0...5, numbers of envelopes [frameClass][numEnvIdx] */
+static const uint8_t nrParTabPS[6] PROGMEM = {10, 20, 34, 10, 20, 34};
+static const uint8_t numEnvTabPS[2][4] PROGMEM = {{0, 1, 2, 4}, {1, 2, 3, 4}};
+
+/* parameter band (of 20) of the 71 hybrid bands: 10 sub-subbands of QMF bands 0...2, then QMF bands 3...63 */
+static const uint8_t bandMapPS[71] PROGMEM = {
+     1,  0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 14, 15, 15, 15, 16, 16, 16, 16, 17, 17, 17,
+    17, 17, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+};
+
+/* mixing matrices {h11, h12, h21, h22} [iid index: 15 coarse, 31 fine steps][icc], Q14, ISO/IEC 14496-3 8.6.4.6.2
+ * A: rotation (icc_mode 0...2), B: principal axis (icc_mode 3...5)
+ */
+static const int16_t mixTabPSA[46][8][4] PROGMEM = {
+    {{1301, 23134, 0, 0}, {1224, 23133, 442, -238}, {1106, 23131, 685, -381}, {809, 23126, 1019, -618},
+     {520, 23120, 1193, -797}, {59, 23110, 1300, -1048}, {-698, 23087, 1098, -1468}, {-1296, 23039, 118, -2095}},
+    {{2894, 22989, 0, 0}, {2735, 22983, 947, -544}, {2492, 22972, 1472, -872}, {1878, 22946, 2202, -1412},
+     {1274, 22917, 2599, -1820}, {301, 22864, 2878, -2392}, {-1346, 22744, 2562, -3346}, {-2831, 22491, 599, -4759}},
+    {{4534, 22723, 0, 0}, {4306, 22706, 1420, -871}, {3957, 22680, 2213, -1395}, {3071, 22610, 3335, -2259},
+     {2193, 22536, 3968, -2909}, {762, 22399, 4469, -3819}, {-1737, 22090, 4188, -5325}, {-4278, 21439, 1502, -7529}},
+    {{6986, 22092, 0, 0}, {6685, 22050, 2030, -1371}, {6223, 21983, 3176, -2193}, {5040, 21806, 4838, -3545},
+     {3854, 21617, 5827, -4559}, {1886, 21272, 6727, -5964}, {-1707, 20492, 6774, -8255}, {-5968, 18872, 3632, -11485}},
+    {{9450, 21156, 0, 0}, {9111, 21073, 2508, -1865}, {8590, 20945, 3939, -2980}, {7246, 20603, 6066, -4805},
+     {5883, 20239, 7396, -6160}, {3581, 19578, 8745, -8016}, {-806, 18097, 9416, -10957}, {-6737, 15081, 6627, -14837}},
+    {{12364, 19596, 0, 0}, {12027, 19448, 2868, -2399}, {11506, 19219, 4527, -3826}, {10151, 18610, 7059, -6137},
+     {8759, 17966, 8727, -7825}, {6360, 16805, 10603, -10079}, {1567, 14246, 12264, -13456}, {-5822, 9227, 10908, -17288}},
+    {{14412, 18143, 0, 0}, {14104, 17940, 2964, -2706}, {13626, 17625, 4693, -4307}, {12378, 16791, 7380, -6873},
+     {11084, 15914, 9211, -8714}, {8824, 14345, 11395, -11108}, {4166, 10947, 13796, -14469}, {-3607, 4541, 13953, -17566}},
+    {{16384, 16384, 0, 0}, {16124, 16124, 2908, -2908}, {15720, 15720, 4617, -4617}, {14659, 14659, 7319, -7319},
+     {13548, 13548, 9213, -9213}, {11585, 11585, 11585, -11585}, {7427, 7427, 14604, -14604}, {0, 0, 16384, -16384}},
+    {{18143, 14412, 0, 0}, {17940, 14104, 2706, -2964}, {17625, 13626, 4307, -4693}, {16791, 12378, 6873, -7380},
+     {15914, 11084, 8714, -9211}, {14345, 8824, 11108, -11395}, {10947, 4166, 14469, -13796}, {4541, -3607, 17566, -13953}},
+    {{19596, 12364, 0, 0}, {19448, 12027, 2399, -2868}, {19219, 11506, 3826, -4527}, {18610, 10151, 6137, -7059},
+     {17966, 8759, 7825, -8727}, {16805, 6360, 10079, -10603}, {14246, 1567, 13456, -12264}, {9227, -5822, 17288, -10908}},
+    {{21156, 9450, 0, 0}, {21073, 9111, 1865, -2508}, {20945, 8590, 2980, -3939}, {20603, 7246, 4805, -6066},
+     {20239, 5883, 6160, -7396}, {19578, 3581, 8016, -8745}, {18097, -806, 10957, -9416}, {15081, -6737, 14837, -6627}},
+    {{22092, 6986, 0, 0}, {22050, 6685, 1371, -2030}, {21983, 6223, 2193, -3176}, {21806, 5040, 3545, -4838},
+     {21617, 3854, 4559, -5827}, {21272, 1886, 5964, -6727}, {20492, -1707, 8255, -6774}, {18872, -5968, 11485, -3632}},
+    {{22723, 4534, 0, 0}, {22706, 4306, 871, -1420}, {22680, 3957, 1395, -2213}, {22610, 3071, 2259, -3335},
+     {22536, 2193, 2909, -3968}, {22399, 762, 3819, -4469}, {22090, -1737, 5325, -4188}, {21439, -4278, 7529, -1502}},
+    {{22989, 2894, 0, 0}, {22983, 2735, 544, -947}, {22972, 2492, 872, -1472}, {22946, 1878, 1412, -2202},
+     {22917, 1274, 1820, -2599}, {22864, 301, 2392, -2878}, {22744, -1346, 3346, -2562}, {22491, -2831, 4759, -599}},
+    {{23134, 1301, 0, 0}, {23133, 1224, 238, -442}, {23131, 1106, 381, -685}, {23126, 809, 618, -1019},
+     {23120, 520, 797, -1193}, {23110, 59, 1048, -1300}, {23087, -698, 1468, -1098}, {23039, -1296, 2095, -118}},
+    {{73, 23170, 0, 0}, {69, 23170, 26, -13}, {62, 23170, 40, -21}, {44, 23170, 59, -34},
+     {27, 23170, 68, -44}, {0, 23170, 73, -58}, {-43, 23170, 59, -81}, {-73, 23170, 0, -115}},
+    {{130, 23170, 0, 0}, {122, 23170, 45, -23}, {110, 23170, 70, -37}, {79, 23170, 104, -61},
+     {48, 23170, 121, -78}, {1, 23170, 130, -103}, {-76, 23170, 106, -144}, {-130, 23169, 1, -205}},
+    {{232, 23169, 0, 0}, {217, 23169, 81, -42}, {195, 23169, 125, -67}, {140, 23169, 185, -108},
+     {86, 23169, 215, -139}, {2, 23169, 232, -183}, {-134, 23168, 189, -256}, {-232, 23166, 4, -366}},
+    {{412, 23167, 0, 0}, {386, 23167, 143, -74}, {348, 23167, 221, -119}, {250, 23166, 327, -192},
+     {156, 23165, 381, -248}, {6, 23165, 412, -326}, {-236, 23162, 338, -457}, {-412, 23158, 12, -653}},
+    {{732, 23159, 0, 0}, {688, 23159, 252, -133}, {620, 23158, 390, -212}, {449, 23156, 579, -344},
+     {282, 23155, 676, -444}, {18, 23152, 732, -584}, {-410, 23144, 607, -818}, {-731, 23129, 37, -1167}},
+    {{1301, 23134, 0, 0}, {1224, 23133, 442, -238}, {1106, 23131, 685, -381}, {809, 23126, 1019, -618},
+     {520, 23120, 1193, -797}, {59, 23110, 1300, -1048}, {-698, 23087, 1098, -1468}, {-1296, 23039, 118, -2095}},
+    {{1835, 23098, 0, 0}, {1728, 23095, 616, -339}, {1566, 23091, 956, -543}, {1158, 23081, 1423, -880},
+     {758, 23070, 1671, -1135}, {119, 23049, 1831, -1492}, {-942, 23003, 1574, -2089}, {-1819, 22905, 237, -2979}},
+    {{2584, 23026, 0, 0}, {2439, 23021, 851, -484}, {2219, 23013, 1323, -774}, {1663, 22992, 1977, -1255},
+     {1116, 22969, 2330, -1618}, {239, 22928, 2573, -2126}, {-1239, 22833, 2267, -2975}, {-2540, 22633, 475, -4234}},
+    {{3627, 22885, 0, 0}, {3435, 22874, 1164, -689}, {3142, 22858, 1812, -1104}, {2399, 22815, 2720, -1788},
+     {1666, 22769, 3222, -2304}, {480, 22684, 3595, -3026}, {-1558, 22491, 3275, -4228}, {-3500, 22084, 951, -5999}},
+    {{5062, 22611, 0, 0}, {4815, 22590, 1561, -979}, {4437, 22557, 2436, -1566}, {3476, 22468, 3680, -2535},
+     {2521, 22374, 4389, -3264}, {959, 22202, 4970, -4283}, {-1797, 21810, 4732, -5965}, {-4699, 20989, 1883, -8410}},
+    {{6986, 22092, 0, 0}, {6685, 22050, 2030, -1371}, {6223, 21983, 3176, -2193}, {5040, 21806, 4838, -3545},
+     {3854, 21617, 5827, -4559}, {1886, 21272, 6727, -5964}, {-1707, 20492, 6774, -8255}, {-5968, 18872, 3632, -11485}},
+    {{8570, 21527, 0, 0}, {8241, 21461, 2354, -1691}, {7734, 21357, 3692, -2704}, {6432, 21080, 5664, -4364},
+     {5116, 20786, 6876, -5601}, {2908, 20250, 8062, -7305}, {-1237, 19045, 8480, -10036}, {-6597, 16570, 5471, -13743}},
+    {{10382, 20714, 0, 0}, {10038, 20613, 2649, -2044}, {9509, 20456, 4167, -3265}, {8140, 20036, 6444, -5257},
+     {6746, 19591, 7891, -6729}, {4376, 18784, 9414, -8732}, {-210, 16983, 10380, -11860}, {-6692, 13352, 7937, -15837}},
+    {{12364, 19596, 0, 0}, {12027, 19448, 2868, -2399}, {11506, 19219, 4527, -3826}, {10151, 18610, 7059, -6137},
+     {8759, 17966, 8727, -7825}, {6360, 16805, 10603, -10079}, {1567, 14246, 12264, -13456}, {-5822, 9227, 10908, -17288}},
+    {{14412, 18143, 0, 0}, {14104, 17940, 2964, -2706}, {13626, 17625, 4693, -4307}, {12378, 16791, 7380, -6873},
+     {11084, 15914, 9211, -8714}, {8824, 14345, 11395, -11108}, {4166, 10947, 13796, -14469}, {-3607, 4541, 13953, -17566}},
+    {{16384, 16384, 0, 0}, {16124, 16124, 2908, -2908}, {15720, 15720, 4617, -4617}, {14659, 14659, 7319, -7319},
+     {13548, 13548, 9213, -9213}, {11585, 11585, 11585, -11585}, {7427, 7427, 14604, -14604}, {0, 0, 16384, -16384}},
+    {{18143, 14412, 0, 0}, {17940, 14104, 2706, -2964}, {17625, 13626, 4307, -4693}, {16791, 12378, 6873, -7380},
+     {15914, 11084, 8714, -9211}, {14345, 8824, 11108, -11395}, {10947, 4166, 14469, -13796}, {4541, -3607, 17566, -13953}},
+    {{19596, 12364, 0, 0}, {19448, 12027, 2399, -2868}, {19219, 11506, 3826, -4527}, {18610, 10151, 6137, -7059},
+     {17966, 8759, 7825, -8727}, {16805, 6360, 10079, -10603}, {14246, 1567, 13456, -12264}, {9227, -5822, 17288, -10908}},
+    {{20714, 10382, 0, 0}, {20613, 10038, 2044, -2649}, {20456, 9509, 3265, -4167}, {20036, 8140, 5257, -6444},
+     {19591, 6746, 6729, -7891}, {18784, 4376, 8732, -9414}, {16983, -210, 11860, -10380}, {13352, -6692, 15837, -7937}},
+    {{21527, 8570, 0, 0}, {21461, 8241, 1691, -2354}, {21357, 7734, 2704, -3692}, {21080, 6432, 4364, -5664},
+     {20786, 5116, 5601, -6876}, {20250, 2908, 7305, -8062}, {19045, -1237, 10036, -8480}, {16570, -6597, 13743, -5471}},
+    {{22092, 6986, 0, 0}, {22050, 6685, 1371, -2030}, {21983, 6223, 2193, -3176}, {21806, 5040, 3545, -4838},
+     {21617, 3854, 4559, -5827}, {21272, 1886, 5964, -6727}, {20492, -1707, 8255, -6774}, {18872, -5968, 11485, -3632}},
+    {{22611, 5062, 0, 0}, {22590, 4815, 979, -1561}, {22557, 4437, 1566, -2436}, {22468, 3476, 2535, -3680},
+     {22374, 2521, 3264, -4389}, {22202, 959, 4283, -4970}, {21810, -1797, 5965, -4732}, {20989, -4699, 8410, -1883}},
+    {{22885, 3627, 0, 0}, {22874, 3435, 689, -1164}, {22858, 3142, 1104, -1812}, {22815, 2399, 1788, -2720},
+     {22769, 1666, 2304, -3222}, {22684, 480, 3026, -3595}, {22491, -1558, 4228, -3275}, {22084, -3500, 5999, -951}},
+    {{23026, 2584, 0, 0}, {23021, 2439, 484, -851}, {23013, 2219, 774, -1323}, {22992, 1663, 1255, -1977},
+     {22969, 1116, 1618, -2330}, {22928, 239, 2126, -2573}, {22833, -1239, 2975, -2267}, {22633, -2540, 4234, -475}},
+    {{23098, 1835, 0, 0}, {23095, 1728, 339, -616}, {23091, 1566, 543, -956}, {23081, 1158, 880, -1423},
+     {23070, 758, 1135, -1671}, {23049, 119, 1492, -1831}, {23003, -942, 2089, -1574}, {22905, -1819, 2979, -237}},
+    {{23134, 1301, 0, 0}, {23133, 1224, 238, -442}, {23131, 1106, 381, -685}, {23126, 809, 618, -1019},
+     {23120, 520, 797, -1193}, {23110, 59, 1048, -1300}, {23087, -698, 1468, -1098}, {23039, -1296, 2095, -118}},
+    {{23159, 732, 0, 0}, {23159, 688, 133, -252}, {23158, 620, 212, -390}, {23156, 449, 344, -579},
+     {23155, 282, 444, -676}, {23152, 18, 584, -732}, {23144, -410, 818, -607}, {23129, -731, 1167, -37}},
+    {{23167, 412, 0, 0}, {23167, 386, 74, -143}, {23167, 348, 119, -221}, {23166, 250, 192, -327},
+     {23165, 156, 248, -381}, {23165, 6, 326, -412}, {23162, -236, 457, -338}, {23158, -412, 653, -12}},
+    {{23169, 232, 0, 0}, {23169, 217, 42, -81}, {23169, 195, 67, -125}, {23169, 140, 108, -185},
+     {23169, 86, 139, -215}, {23169, 2, 183, -232}, {23168, -134, 256, -189}, {23166, -232, 366, -4}},
+    {{23170, 130, 0, 0}, {23170, 122, 23, -45}, {23170, 110, 37, -70}, {23170, 79, 61, -104},
+     {23170, 48, 78, -121}, {23170, 1, 103, -130}, {23170, -76, 144, -106}, {23169, -130, 205, -1}},
+    {{23170, 73, 0, 0}, {23170, 69, 13, -26}, {23170, 62, 21, -40}, {23170, 44, 34, -59},
+     {23170, 27, 44, -68}, {23170, 0, 58, -73}, {23170, -43, 81, -59}, {23170, -73, 115, 0}},
+};
+
+static const int16_t mixTabPSB[46][8][4] PROGMEM = {
+    {{1301, 23134, 0, 0}, {1219, 23134, -453, 24}, {1095, 23134, -702, 33}, {783, 23134, -1039, 35},
+     {480, 23134, -1209, 25}, {65, 23134, -1299, 4}, {65, 23134, -1299, 4}, {65, 23134, -1299, 4}},
+    {{2894, 22989, 0, 0}, {2717, 22989, -997, 118}, {2446, 22988, -1548, 165}, {1757, 22988, -2300, 176},
+     {1079, 22989, -2686, 126}, {147, 22989, -2890, 18}, {147, 22989, -2890, 18}, {147, 22989, -2890, 18}},
+    {{4534, 22723, 0, 0}, {4268, 22721, -1530, 287}, {3857, 22719, -2383, 405}, {2794, 22718, -3571, 439},
+     {1726, 22720, -4192, 318}, {236, 22723, -4528, 47}, {236, 22723, -4528, 47}, {236, 22723, -4528, 47}},
+    {{6986, 22092, 0, 0}, {6617, 22082, -2240, 671}, {6036, 22071, -3518, 962}, {4468, 22065, -5371, 1087},
+     {2806, 22077, -6398, 813}, {388, 22092, -6975, 123}, {388, 22092, -6975, 123}, {388, 22092, -6975, 123}},
+    {{9450, 21156, 0, 0}, {9027, 21122, -2796, 1195}, {8346, 21083, -4433, 1755}, {6405, 21050, -6948, 2114},
+     {4158, 21090, -8486, 1673}, {590, 21154, -9432, 263}, {590, 21154, -9432, 263}, {590, 21154, -9432, 263}},
+    {{12364, 19596, 0, 0}, {11955, 19500, -3155, 1934}, {11286, 19374, -5049, 2941}, {9270, 19193, -8182, 3952},
+     {6564, 19268, -10478, 3569}, {1024, 19585, -12322, 644}, {1024, 19585, -12322, 644}, {1024, 19585, -12322, 644}},
+    {{14412, 18143, 0, 0}, {14063, 17975, -3152, 2466}, {13498, 17731, -5048, 3843}, {11819, 17240, -8247, 5654},
+     {9434, 17121, -10894, 6003}, {1924, 18079, -14283, 1520}, {1924, 18079, -14283, 1520}, {1924, 18079, -14283, 1520}},
+    {{16384, 16384, 0, 0}, {16124, 16124, -2908, 2908}, {15720, 15720, -4617, 4617}, {14659, 14659, -7319, 7319},
+     {13548, 13548, -9213, 9213}, {11871, 11871, -11292, 11292}, {11871, 11871, -11292, 11292}, {11871, 11871, -11292, 11292}},
+    {{18143, 14412, 0, 0}, {17975, 14063, -2466, 3152}, {17731, 13498, -3843, 5048}, {17240, 11819, -5654, 8247},
+     {17121, 9434, -6003, 10894}, {18079, 1924, -1520, 14283}, {18079, 1924, -1520, 14283}, {18079, 1924, -1520, 14283}},
+    {{19596, 12364, 0, 0}, {19500, 11955, -1934, 3155}, {19374, 11286, -2941, 5049}, {19193, 9270, -3952, 8182},
+     {19268, 6564, -3569, 10478}, {19585, 1024, -644, 12322}, {19585, 1024, -644, 12322}, {19585, 1024, -644, 12322}},
+    {{21156, 9450, 0, 0}, {21122, 9027, -1195, 2796}, {21083, 8346, -1755, 4433}, {21050, 6405, -2114, 6948},
+     {21090, 4158, -1673, 8486}, {21154, 590, -263, 9432}, {21154, 590, -263, 9432}, {21154, 590, -263, 9432}},
+    {{22092, 6986, 0, 0}, {22082, 6617, -671, 2240}, {22071, 6036, -962, 3518}, {22065, 4468, -1087, 5371},
+     {22077, 2806, -813, 6398}, {22092, 388, -123, 6975}, {22092, 388, -123, 6975}, {22092, 388, -123, 6975}},
+    {{22723, 4534, 0, 0}, {22721, 4268, -287, 1530}, {22719, 3857, -405, 2383}, {22718, 2794, -439, 3571},
+     {22720, 1726, -318, 4192}, {22723, 236, -47, 4528}, {22723, 236, -47, 4528}, {22723, 236, -47, 4528}},
+    {{22989, 2894, 0, 0}, {22989, 2717, -118, 997}, {22988, 2446, -165, 1548}, {22988, 1757, -176, 2300},
+     {22989, 1079, -126, 2686}, {22989, 147, -18, 2890}, {22989, 147, -18, 2890}, {22989, 147, -18, 2890}},
+    {{23134, 1301, 0, 0}, {23134, 1219, -24, 453}, {23134, 1095, -33, 702}, {23134, 783, -35, 1039},
+     {23134, 480, -25, 1209}, {23134, 65, -4, 1299}, {23134, 65, -4, 1299}, {23134, 65, -4, 1299}},
+    {{73, 23170, 0, 0}, {69, 23170, -26, 0}, {62, 23170, -40, 0}, {44, 23170, -59, 0},
+     {27, 23170, -68, 0}, {4, 23170, -73, 0}, {4, 23170, -73, 0}, {4, 23170, -73, 0}},
+    {{130, 23170, 0, 0}, {122, 23170, -46, 0}, {110, 23170, -70, 0}, {78, 23170, -104, 0},
+     {48, 23170, -121, 0}, {7, 23170, -130, 0}, {7, 23170, -130, 0}, {7, 23170, -130, 0}},
+    {{232, 23169, 0, 0}, {217, 23169, -81, 1}, {195, 23169, -125, 1}, {139, 23169, -185, 1},
+     {85, 23169, -215, 1}, {12, 23169, -231, 0}, {12, 23169, -231, 0}, {12, 23169, -231, 0}},
+    {{412, 23167, 0, 0}, {386, 23167, -144, 2}, {347, 23167, -223, 3}, {248, 23167, -329, 4},
+     {151, 23167, -383, 3}, {21, 23167, -411, 0}, {21, 23167, -411, 0}, {21, 23167, -411, 0}},
+    {{732, 23159, 0, 0}, {686, 23159, -256, 8}, {616, 23159, -396, 11}, {440, 23159, -585, 11},
+     {269, 23159, -681, 8}, {37, 23159, -731, 1}, {37, 23159, -731, 1}, {37, 23159, -731, 1}},
+    {{1301, 23134, 0, 0}, {1219, 23134, -453, 24}, {1095, 23134, -702, 33}, {783, 23134, -1039, 35},
+     {480, 23134, -1209, 25}, {65, 23134, -1299, 4}, {65, 23134, -1299, 4}, {65, 23134, -1299, 4}},
+    {{1835, 23098, 0, 0}, {1720, 23098, -637, 47}, {1546, 23098, -988, 66}, {1107, 23098, -1463, 70},
+     {678, 23098, -1705, 50}, {92, 23098, -1832, 7}, {92, 23098, -1832, 7}, {92, 23098, -1832, 7}},
+    {{2584, 23026, 0, 0}, {2424, 23026, -893, 94}, {2181, 23026, -1385, 131}, {1565, 23026, -2056, 140},
+     {960, 23026, -2398, 100}, {131, 23026, -2580, 15}, {131, 23026, -2580, 15}, {131, 23026, -2580, 15}},
+    {{3627, 22885, 0, 0}, {3409, 22884, -1240, 185}, {3073, 22883, -1927, 259}, {2215, 22883, -2872, 278},
+     {1363, 22884, -3361, 200}, {186, 22885, -3622, 29}, {186, 22885, -3622, 29}, {186, 22885, -3622, 29}},
+    {{5062, 22611, 0, 0}, {4770, 22608, -1693, 357}, {4318, 22605, -2642, 505}, {3140, 22604, -3971, 552},
+     {1944, 22607, -4674, 402}, {266, 22611, -5055, 60}, {266, 22611, -5055, 60}, {266, 22611, -5055, 60}},
+    {{6986, 22092, 0, 0}, {6617, 22082, -2240, 671}, {6036, 22071, -3518, 962}, {4468, 22065, -5371, 1087},
+     {2806, 22077, -6398, 813}, {388, 22092, -6975, 123}, {388, 22092, -6975, 123}, {388, 22092, -6975, 123}},
+    {{8570, 21527, 0, 0}, {8160, 21504, -2620, 994}, {7504, 21479, -4140, 1446}, {5674, 21460, -6423, 1698},
+     {3630, 21487, -7763, 1312}, {509, 21526, -8555, 202}, {509, 21526, -8555, 202}, {509, 21526, -8555, 202}},
+    {{10382, 20714, 0, 0}, {9954, 20666, -2951, 1421}, {9259, 20607, -4695, 2110}, {7239, 20548, -7442, 2622},
+     {4795, 20603, -9208, 2143}, {692, 20712, -10359, 346}, {692, 20712, -10359, 346}, {692, 20712, -10359, 346}},
+    {{12364, 19596, 0, 0}, {11955, 19500, -3155, 1934}, {11286, 19374, -5049, 2941}, {9270, 19193, -8182, 3952},
+     {6564, 19268, -10478, 3569}, {1024, 19585, -12322, 644}, {1024, 19585, -12322, 644}, {1024, 19585, -12322, 644}},
+    {{14412, 18143, 0, 0}, {14063, 17975, -3152, 2466}, {13498, 17731, -5048, 3843}, {11819, 17240, -8247, 5654},
+     {9434, 17121, -10894, 6003}, {1924, 18079, -14283, 1520}, {1924, 18079, -14283, 1520}, {1924, 18079, -14283, 1520}},
+    {{16384, 16384, 0, 0}, {16124, 16124, -2908, 2908}, {15720, 15720, -4617, 4617}, {14659, 14659, -7319, 7319},
+     {13548, 13548, -9213, 9213}, {11871, 11871, -11292, 11292}, {11871, 11871, -11292, 11292}, {11871, 11871, -11292, 11292}},
+    {{18143, 14412, 0, 0}, {17975, 14063, -2466, 3152}, {17731, 13498, -3843, 5048}, {17240, 11819, -5654, 8247},
+     {17121, 9434, -6003, 10894}, {18079, 1924, -1520, 14283}, {18079, 1924, -1520, 14283}, {18079, 1924, -1520, 14283}},
+    {{19596, 12364, 0, 0}, {19500, 11955, -1934, 3155}, {19374, 11286, -2941, 5049}, {19193, 9270, -3952, 8182},
+     {19268, 6564, -3569, 10478}, {19585, 1024, -644, 12322}, {19585, 1024, -644, 12322}, {19585, 1024, -644, 12322}},
+    {{20714, 10382, 0, 0}, {20666, 9954, -1421, 2951}, {20607, 9259, -2110, 4695}, {20548, 7239, -2622, 7442},
+     {20603, 4795, -2143, 9208}, {20712, 692, -346, 10359}, {20712, 692, -346, 10359}, {20712, 692, -346, 10359}},
+    {{21527, 8570, 0, 0}, {21504, 8160, -994, 2620}, {21479, 7504, -1446, 4140}, {21460, 5674, -1698, 6423},
+     {21487, 3630, -1312, 7763}, {21526, 509, -202, 8555}, {21526, 509, -202, 8555}, {21526, 509, -202, 8555}},
+    {{22092, 6986, 0, 0}, {22082, 6617, -671, 2240}, {22071, 6036, -962, 3518}, {22065, 4468, -1087, 5371},
+     {22077, 2806, -813, 6398}, {22092, 388, -123, 6975}, {22092, 388, -123, 6975}, {22092, 388, -123, 6975}},
+    {{22611, 5062, 0, 0}, {22608, 4770, -357, 1693}, {22605, 4318, -505, 2642}, {22604, 3140, -552, 3971},
+     {22607, 1944, -402, 4674}, {22611, 266, -60, 5055}, {22611, 266, -60, 5055}, {22611, 266, -60, 5055}},
+    {{22885, 3627, 0, 0}, {22884, 3409, -185, 1240}, {22883, 3073, -259, 1927}, {22883, 2215, -278, 2872},
+     {22884, 1363, -200, 3361}, {22885, 186, -29, 3622}, {22885, 186, -29, 3622}, {22885, 186, -29, 3622}},
+    {{23026, 2584, 0, 0}, {23026, 2424, -94, 893}, {23026, 2181, -131, 1385}, {23026, 1565, -140, 2056},
+     {23026, 960, -100, 2398}, {23026, 131, -15, 2580}, {23026, 131, -15, 2580}, {23026, 131, -15, 2580}},
+    {{23098, 1835, 0, 0}, {23098, 1720, -47, 637}, {23098, 1546, -66, 988}, {23098, 1107, -70, 1463},
+     {23098, 678, -50, 1705}, {23098, 92, -7, 1832}, {23098, 92, -7, 1832}, {23098, 92, -7, 1832}},
+    {{23134, 1301, 0, 0}, {23134, 1219, -24, 453}, {23134, 1095, -33, 702}, {23134, 783, -35, 1039},
+     {23134, 480, -25, 1209}, {23134, 65, -4, 1299}, {23134, 65, -4, 1299}, {23134, 65, -4, 1299}},
+    {{23159, 732, 0, 0}, {23159, 686, -8, 256}, {23159, 616, -11, 396}, {23159, 440, -11, 585},
+     {23159, 269, -8, 681}, {23159, 37, -1, 731}, {23159, 37, -1, 731}, {23159, 37, -1, 731}},
+    {{23167, 412, 0, 0}, {23167, 386, -2, 144}, {23167, 347, -3, 223}, {23167, 248, -4, 329},
+     {23167, 151, -3, 383}, {23167, 21, 0, 411}, {23167, 21, 0, 411}, {23167, 21, 0, 411}},
+    {{23169, 232, 0, 0}, {23169, 217, -1, 81}, {23169, 195, -1, 125}, {23169, 139, -1, 185},
+     {23169, 85, -1, 215}, {23169, 12, 0, 231}, {23169, 12, 0, 231}, {23169, 12, 0, 231}},
+    {{23170, 130, 0, 0}, {23170, 122, 0, 46}, {23170, 110, 0, 70}, {23170, 78, 0, 104},
+     {23170, 48, 0, 121}, {23170, 7, 0, 130}, {23170, 7, 0, 130}, {23170, 7, 0, 130}},
+    {{23170, 73, 0, 0}, {23170, 69, 0, 26}, {23170, 62, 0, 40}, {23170, 44, 0, 59},
+     {23170, 27, 0, 68}, {23170, 4, 0, 73}, {23170, 4, 0, 73}, {23170, 4, 0, 73}},
+};
+
+/* decorrelation filter of the 30 allpass bands, Q31, 8.6.4.5.2
+ * phiFractPS[k] = exp(-i * pi * 0.39 * f(k)), qFractPS[k][m] = exp(-i * pi * {0.43, 0.75, 0.347}[m] * f(k)), f(k) is the
+ * center frequency of the hybrid band in QMF band units, apGainPS[k][m] = allpass coefficient times the decay slope
+ */
+static const uint32_t phiFractPS[30][2] PROGMEM = {
+    0x72b9baca, 0x38c35f85, 0x7e8073ae, 0x1386e8f4, 0x7e8073ae, 0xec79170c, 0x72b9baca, 0xc73ca07b,
+    0x5c44ee40, 0xa748e9ce, 0x3d39385b, 0x8f976992, 0x05067734, 0x80194350, 0xba914696, 0x9477d07e,
+    0x895cc359, 0xcff261f0, 0x834e4955, 0x1ce70e50, 0xcb537f5c, 0x74a8dcd1, 0x5beb9002, 0x5913aba7,
+    0x72f2914e, 0xc7b012c3, 0xf1f439e1, 0x80c5e32d, 0x838961e8, 0xe21e765a, 0xb9b99ecc, 0x6afbbc51,
+    0x4cda91e8, 0x665c1120, 0x7a576cee, 0xda5ce2fa, 0x0607958d, 0x80246067, 0x89be50c3, 0xcf043ab3,
+    0xa9dab9d8, 0x5eac3b52, 0x3be51fc9, 0x711f3b6f, 0x7eb91860, 0xedf6f2cc, 0x19f4ef21, 0x82a8d3b2,
+    0x92dcafe5, 0xbd1ec45c, 0x9c1adb3e, 0x5007f38d, 0x2976203f, 0x79195336, 0x7ffbf51e, 0x0202b287,
+    0x2d3ea9e7, 0x88435eb8, 0x9eab046f, 0xacdee2e8,
+};
+
+static const uint32_t qFractPS[30][3][2] PROGMEM = {
+    0x6fec9aaa, 0x3e1abec6, 0x5133cc94, 0x62f201ac, 0x7573deeb, 0x32e18cfb,
+    0x7e2defed, 0x1582f755, 0x7a7d055b, 0x25280c5e, 0x7ed03e2a, 0x116360a2,
+    0x7e2defed, 0xea7d08ab, 0x7a7d055b, 0xdad7f3a2, 0x7ed03e2a, 0xee9c9f5e,
+    0x6fec9aaa, 0xc1e5413a, 0x5133cc94, 0x9d0dfe54, 0x7573deeb, 0xcd1e7305,
+    0x55063951, 0xa051a5ab, 0x0c8bd35e, 0x809dc971, 0x636c0442, 0xaf61c447,
+    0x3084ca33, 0x898d4e33, 0xc3a94590, 0x8f1d343a, 0x4a0d6730, 0x979882b3,
+    0xf0f488d9, 0x80e321ff, 0x8275a0c0, 0xe70747c4, 0x1a72e379, 0x82c32b3c,
+    0xa4c842d2, 0xa63437df, 0xb8e31319, 0x6a6d98a4, 0xd5af016e, 0x873279c5,
+    0x80aaa6ae, 0xf2f423b2, 0x471cece7, 0x6a6d98a4, 0x9d2ead98, 0xaea47031,
+    0x9477d07e, 0x456eb96a, 0x7d8a5f40, 0xe70747c4, 0x8151df9d, 0xedaa8617,
+    0x0202b287, 0x7ffbf51e, 0xcf043ab3, 0x89be50c3, 0x9bfab4a1, 0x4fdfc183,
+    0x7d572c4e, 0x19f4ef21, 0xcf043ab3, 0x7641af3d, 0x1893b8fd, 0x7d9e4bf8,
+    0x34ac80a4, 0x8b57232f, 0x7641af3d, 0xcf043ab3, 0x7abf7944, 0x244a29ad,
+    0x99a3eee0, 0xb3256e18, 0x89be50c3, 0xcf043ab3, 0x58eeadda, 0xa3f0a587,
+    0x9eab046f, 0x53211d18, 0x30fbc54d, 0x7641af3d, 0xd77daec8, 0x869444d2,
+    0x3be51fc9, 0x711f3b6f, 0x30fbc54d, 0x89be50c3, 0x819b8536, 0xebc71fa7,
+    0x7b769e14, 0xde39686c, 0x89be50c3, 0x30fbc54d, 0xb3a121be, 0x66b87d65,
+    0xf9f86a73, 0x80246067, 0x7641af3d, 0x30fbc54d, 0x37c51905, 0x73362c90,
+    0x81e7f007, 0xe9fe3a2d, 0xcf043ab3, 0x89be50c3, 0x7ff16847, 0x03d1d1ef,
+    0xcf043ab3, 0x7641af3d, 0xcf043ab3, 0x7641af3d, 0x3e8b240e, 0x90520d04,
+    0x68b92144, 0x4999c5a8, 0x7641af3d, 0xcf043ab3, 0xb9e4a9bc, 0x94e809f9,
+    0x5eac3b52, 0xa9dab9d8, 0x89be50c3, 0xcf043ab3, 0x80a051ca, 0x0ca56fc9,
+    0xc094cf73, 0x90d0aebb, 0x30fbc54d, 0x7641af3d, 0xd051db6f, 0x76c9bbd1,
+    0x85a89312, 0x25a31d06, 0x30fbc54d, 0x89be50c3, 0x53483a15, 0x6133860f,
+    0x0a0af299, 0x7f9afcb9, 0x89be50c3, 0x30fbc54d, 0x7cb1b6ab, 0xe318f1b0,
+    0x7eb91860, 0x12090d34, 0x7641af3d, 0x30fbc54d, 0x2006ea38, 0x84124e81,
+    0x2d3ea9e7, 0x88435eb8, 0xcf043ab3, 0x89be50c3, 0xa0ec1d3a, 0xaa4d2e53,
+    0x950443af, 0xb9b99ecc, 0xcf043ab3, 0x7641af3d, 0x880d20e7, 0x2cae16a8,
+    0xa4146ffe, 0x5913aba7, 0x7641af3d, 0xcf043ab3, 0xf02826d1, 0x7f04068b,
+    0x42e13ba4, 0x6d23501b, 0x89be50c3, 0xcf043ab3, 0x694c48d5, 0x48c6a27d,
+};
+
+static const int apGainPS[30][3] PROGMEM = {
+    0x53625ae4, 0x4848aef5, 0x3ea94d15, 0x53625ae4, 0x4848aef5, 0x3ea94d15,
+    0x53625ae4, 0x4848aef5, 0x3ea94d15, 0x53625ae4, 0x4848aef5, 0x3ea94d15,
+    0x53625ae4, 0x4848aef5, 0x3ea94d15, 0x53625ae4, 0x4848aef5, 0x3ea94d15,
+    0x53625ae4, 0x4848aef5, 0x3ea94d15, 0x53625ae4, 0x4848aef5, 0x3ea94d15,
+    0x53625ae4, 0x4848aef5, 0x3ea94d15, 0x53625ae4, 0x4848aef5, 0x3ea94d15,
+    0x53625ae4, 0x4848aef5, 0x3ea94d15, 0x4f37098c, 0x44ab7302, 0x3b873c6d,
+    0x4b0bb833, 0x410e370f, 0x38652bc6, 0x46e066db, 0x3d70fb1d, 0x35431b1f,
+    0x42b51583, 0x39d3bf2a, 0x32210a77, 0x3e89c42b, 0x36368338, 0x2efef9d0,
+    0x3a5e72d3, 0x32994745, 0x2bdce928, 0x3633217a, 0x2efc0b52, 0x28bad881,
+    0x3207d022, 0x2b5ecf60, 0x2598c7d9, 0x2ddc7eca, 0x27c1936d, 0x2276b732,
+    0x29b12d72, 0x2424577a, 0x1f54a68a, 0x2585dc1a, 0x20871b88, 0x1c3295e3,
+    0x215a8ac1, 0x1ce9df95, 0x1910853c, 0x1d2f3969, 0x194ca3a2, 0x15ee7494,
+    0x1903e811, 0x15af67b0, 0x12cc63ed, 0x14d896b9, 0x12122bbd, 0x0faa5345,
+    0x10ad4561, 0x0e74efcb, 0x0c88429e, 0x0c81f409, 0x0ad7b3d8, 0x096631f6,
+    0x0856a2b0, 0x073a77e5, 0x0644214f, 0x042b5158, 0x039d3bf3, 0x032210a7,
+};
+
+/* hybrid analysis of QMF band 0, 8 complex bands: g0[n] * exp(i * 2pi * (q + 0.5) * (n - 6) / 8), n = 0...6, Q31.
+ * Taps 7...12 are the conjugate mirror, see HybridAnalysisPS()
+ */
+static const uint32_t hybFilt8PS[8][7][2] PROGMEM = {
+    0xff532109, 0x00acdef7, 0xfee34b5f, 0x02af570f, 0x00000000, 0x05d1eac2, 0x038f276e, 0x0897b86d,
+    0x08f26d36, 0x08f26d36, 0x0df26407, 0x05c6e77e, 0x10000000, 0x00000000, 0x00acdef7, 0x00acdef7,
+    0x02af570f, 0xfee34b5f, 0x00000000, 0xfa2e153e, 0xf7684793, 0xfc70d892, 0xf70d92ca, 0x08f26d36,
+    0x05c6e77e, 0x0df26407, 0x10000000, 0x00000000, 0x00acdef7, 0xff532109, 0xfd50a8f1, 0xfee34b5f,
+    0x00000000, 0x05d1eac2, 0x0897b86d, 0xfc70d892, 0xf70d92ca, 0xf70d92ca, 0xfa391882, 0x0df26407,
+    0x10000000, 0x00000000, 0xff532109, 0xff532109, 0x011cb4a1, 0x02af570f, 0x00000000, 0xfa2e153e,
+    0xfc70d892, 0x0897b86d, 0x08f26d36, 0xf70d92ca, 0xf20d9bf9, 0x05c6e77e, 0x10000000, 0x00000000,
+    0xff532109, 0x00acdef7, 0x011cb4a1, 0xfd50a8f1, 0x00000000, 0x05d1eac2, 0xfc70d892, 0xf7684793,
+    0x08f26d36, 0x08f26d36, 0xf20d9bf9, 0xfa391882, 0x10000000, 0x00000000, 0x00acdef7, 0x00acdef7,
+    0xfd50a8f1, 0x011cb4a1, 0x00000000, 0xfa2e153e, 0x0897b86d, 0x038f276e, 0xf70d92ca, 0x08f26d36,
+    0xfa391882, 0xf20d9bf9, 0x10000000, 0x00000000, 0x00acdef7, 0xff532109, 0x02af570f, 0x011cb4a1,
+    0x00000000, 0x05d1eac2, 0xf7684793, 0x038f276e, 0xf70d92ca, 0xf70d92ca, 0x05c6e77e, 0xf20d9bf9,
+    0x10000000, 0x00000000, 0xff532109, 0xff532109, 0xfee34b5f, 0xfd50a8f1, 0x00000000, 0xfa2e153e,
+    0x038f276e, 0xf7684793, 0x08f26d36, 0xf70d92ca, 0x0df26407, 0xfa391882, 0x10000000, 0x00000000,
+};
+
+/* hybrid analysis of QMF bands 1 and 2, real 2 band filter: g1 of taps 1, 3 and 5 (mirrored 11, 9, 7), Q31. Tap 6 is
+ * 0.5, the even taps are zero
+ */
+static const uint32_t hybFilt2PS[3] PROGMEM = {0x026e6c90, 0xf6aa2f25, 0x2729e766};
+#endif
+
 static const uint32_t poly43lo[5] PROGMEM = { 0x29a0bda9, 0xb02e4828, 0x5957aa1b, 0x236c498d, 0xff581859 };
 static const uint32_t poly43hi[5] PROGMEM = { 0x10852163, 0xd333f6a4, 0x46e9408b, 0x27c2cef0, 0xfef577b4 };
 
@@ -1578,7 +1930,7 @@ static const int pow14[4] PROGMEM = {
 /* pow(2, i/4.0) * pow(j, 4.0/3.0) for i = [0,1,2,3],  j = [0,1,2,...,15]
  * format = Q28 for j = [0-3], Q25 for j = [4-15]
  */
-static const uint32_t pow43_14[4][16] PROGMEM = {
+static const uint32_t pow43_14[4][16] AAC_DRAM = {
     {
     0x00000000, 0x10000000, 0x285145f3, 0x453a5cdb, /* Q28 */
     0x0cb2ff53, 0x111989d6, 0x15ce31c8, 0x1ac7f203, /* Q25 */
@@ -1606,7 +1958,7 @@ static const uint32_t pow43_14[4][16] PROGMEM = {
 };
 
 /* pow(j, 4.0 / 3.0) for j = [16,17,18,...,63], format = Q23 */
-static const int pow43[48] PROGMEM = {
+static const int pow43[48] AAC_DRAM = {
     0x1428a2fa, 0x15db1bd6, 0x1796302c, 0x19598d85,
     0x1b24e8bb, 0x1cf7fcfa, 0x1ed28af2, 0x20b4582a,
     0x229d2e6e, 0x248cdb55, 0x26832fda, 0x28800000,
@@ -1642,79 +1994,158 @@ static const int8_t sgnMask[3] = {0x02,  0x04,  0x08};
 static const int8_t negMask[3] = {~0x03, ~0x07, ~0x0f};
 
 /***********************************************************************************************************************
- * Function:    AACDecoder_AllocateBuffers
+ * Function:    AACDecoder_ClearBuffer
+ *
+ * Description: clear all the memory needed for the AAC decoder
+ *
+ * Inputs:      decoder context
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ **********************************************************************************************************************/
+void AACDecoder_ClearBuffer(AACDecoder_t *dec) {
+
+    memset( dec->AACDecInfo,        0, sizeof(AACDecInfo_t));              //Clear AACDecInfo
+    memset( dec->PSInfoBase,        0, sizeof(PSInfoBase_t));              //Clear PSInfoBase
+    memset(&dec->AACFrameInfo,      0, sizeof(AACFrameInfo_t));            //Clear AACFrameInfo
+    memset(&dec->fhADTS,            0, sizeof(ADTSHeader_t));              //Clear fhADTS
+    memset(&dec->fhADIF,            0, sizeof(ADIFHeader_t));              //Clear fhADIS
+    memset( dec->pce[0],            0, sizeof(ProgConfigElement_t) * 16);  //Clear ProgConfigElement
+    memset(&dec->pulseInfo[0],      0, sizeof(PulseInfo_t) *2);            //Clear PulseInfo
+    memset(&dec->aac_BitStreamInfo, 0, sizeof(aac_BitStreamInfo_t));       //Clear aac_BitStreamInfo
+#ifdef AAC_ENABLE_SBR
+    memset( dec->PSInfoSBR,         0, sizeof(PSInfoSBR_t));               //Clear PSInfoSBR
+    memset( dec->PSInfoSBRQMF,      0, sizeof(PSInfoSBRQMF_t));            //Clear PSInfoSBRQMF
+#ifdef AAC_ENABLE_PS
+    memset( dec->PSInfoPS,          0, sizeof(PSInfoPS_t));                //Clear PSInfoPS
+#endif
+    AACDecoder_t *prev = m_dec;
+    m_dec = dec;
+    InitSBRState();
+    m_dec = prev;
+#endif
+
+    dec->AACDecInfo->prevBlockID = AAC_ID_INVALID;
+    dec->AACDecInfo->currBlockID = AAC_ID_INVALID;
+    dec->AACDecInfo->currInstTag = -1;
+    for(int ch = 0; ch < MAX_NCHANS_ELEM; ch++)
+        dec->AACDecInfo->sbDeinterleaveReqd[ch] = 0;
+    dec->AACDecInfo->adtsBlocksLeft = 0;
+    dec->AACDecInfo->tnsUsed = 0;
+    dec->AACDecInfo->pnsUsed = 0;
+    dec->monoActive = false;
+    dec->monoSplit = false;
+}
+/***********************************************************************************************************************
+ * Function:    AACDecoder_Create, AACDecoder_AllocateBuffers
  *
  * Description: allocate all the memory needed for the AAC decoder
- *              try heap first, because it's faster
  *
  * Inputs:      none
  *
  * Outputs:     none
  *
- * Return:      false if not enough memory, otherwise true
+ * Return:      new decoder context or NULL (Create)
+ *              false if not enough memory, otherwise true (AllocateBuffers)
  *
  **********************************************************************************************************************/
 
+// the internal RAM buffers are carved from the arena, the heap is only asked if it is full
 #ifdef CONFIG_IDF_TARGET_ESP32S3
-    // ESP32-S3: If there is PSRAM, prefer it
-    #define __malloc_heap_psram(size) \
-        heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL)
+    #define AAC_RAM_PSRAM   ARENA_PREFER_PSRAM      // ESP32-S3: If there is PSRAM, prefer it
+#else
+    #define AAC_RAM_PSRAM   ARENA_PREFER_INTERNAL   // ESP32, PSRAM is too slow, prefer SRAM
+#endif
+// buffers touched every frame, internal RAM first on all chips if AAC_PLACEMENT asks for it
+#if AAC_PLACEMENT >= 2
+    #define AAC_RAM_SBR     ARENA_PREFER_INTERNAL   // PSInfoSBR
+#else
+    #define AAC_RAM_SBR     AAC_RAM_PSRAM
+#endif
+#if AAC_PLACEMENT >= 1
+    #define AAC_RAM_FAST    ARENA_PREFER_INTERNAL   // PSInfoBase, SBR QMF and PS
 #else
-    // ESP32, PSRAM is too slow, prefer SRAM
-    #define __malloc_heap_psram(size) \
-        heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM)
+    #define AAC_RAM_FAST    AAC_RAM_PSRAM
 #endif
+#define __malloc_heap_psram(size)   ArenaMalloc(size, AAC_RAM_PSRAM)
+#define __malloc_heap_fast(size)    ArenaMalloc(size, AAC_RAM_FAST)
 
-bool AACDecoder_AllocateBuffers(void){
+AACDecoder_t* AACDecoder_Create(void){
+
+    AACDecoder_t *dec = (AACDecoder_t*)__malloc_heap_psram(sizeof(AACDecoder_t));
+    if(!dec) {
+        log_e("not enough memory to allocate aacdecoder context");
+        return NULL;
+    }
+    memset(dec, 0, sizeof(AACDecoder_t));
 
-    /* here, sizes are: AACDecInfo_t:96 PSInfoBase_t:27364 ProgConfigElement_t*16:1312 PSInfoSBR_t:50788 */
+    /* here, sizes are: AACDecInfo_t:96 PSInfoBase_t:19172 ProgConfigElement_t*16:1312 PSInfoSBR_t:18024
+       PSInfoSBRQMF_t:33280 */
 #ifdef AAC_ENABLE_SBR
-    if(!m_PSInfoSBR) {m_PSInfoSBR   = (PSInfoSBR_t*)__malloc_heap_psram(sizeof(PSInfoSBR_t));}
+    dec->PSInfoSBR = (PSInfoSBR_t*)ArenaMalloc(sizeof(PSInfoSBR_t), AAC_RAM_SBR);
+    dec->PSInfoSBRQMF = (PSInfoSBRQMF_t*)__malloc_heap_fast(sizeof(PSInfoSBRQMF_t));
 
-    if(!m_PSInfoSBR) {
-        log_e("OOM in SBR, can't allocate %d bytes\n", sizeof(PSInfoSBR_t));
-        return false; // ERR_AAC_SBR_INIT;
+    if(!dec->PSInfoSBR || !dec->PSInfoSBRQMF) {
+        log_e("OOM in SBR, can't allocate %u bytes\n", (unsigned)(sizeof(PSInfoSBR_t) + sizeof(PSInfoSBRQMF_t)));
+        AACDecoder_Destroy(dec);
+        return NULL; // ERR_AAC_SBR_INIT;
     }
     else {
-        log_d("AAC Spectral Band Replication enabled, %d additional bytes allocated", sizeof(PSInfoSBR_t));
+        log_d("AAC Spectral Band Replication enabled, %u additional bytes allocated",
+              (unsigned)(sizeof(PSInfoSBR_t) + sizeof(PSInfoSBRQMF_t)));
+    }
+#endif
+#ifdef AAC_ENABLE_PS
+    dec->PSInfoPS = (PSInfoPS_t*)__malloc_heap_fast(sizeof(PSInfoPS_t));
+    if(!dec->PSInfoPS) {
+        log_e("OOM in PS, can't allocate %u bytes\n", (unsigned)sizeof(PSInfoPS_t));
+        AACDecoder_Destroy(dec);
+        return NULL;
     }
 #endif
 
     /* these could fall back to PSRAM if not enough heap available */
-    if(!m_AACDecInfo) {m_AACDecInfo = (AACDecInfo_t*)        __malloc_heap_psram(sizeof(AACDecInfo_t));}
-    if(!m_PSInfoBase) {m_PSInfoBase = (PSInfoBase_t*)        __malloc_heap_psram(sizeof(PSInfoBase_t));}
-    if(!m_pce[0])     {m_pce[0]     = (ProgConfigElement_t*) __malloc_heap_psram(sizeof(ProgConfigElement_t)*16);}
+    dec->AACDecInfo = (AACDecInfo_t*)        __malloc_heap_psram(sizeof(AACDecInfo_t));
+    dec->PSInfoBase = (PSInfoBase_t*)        __malloc_heap_fast(sizeof(PSInfoBase_t));
+    dec->pce[0]     = (ProgConfigElement_t*) __malloc_heap_psram(sizeof(ProgConfigElement_t)*16);
 
-    if(!m_AACDecInfo || !m_PSInfoBase || !m_pce[0]) {
+    if(!dec->AACDecInfo || !dec->PSInfoBase || !dec->pce[0]) {
             log_e("not enough memory to allocate aacdecoder buffers");
-            AACDecoder_FreeBuffers();
-            return false;
-    }
-
-    // Clear Buffer
-    memset( m_AACDecInfo,        0, sizeof(AACDecInfo_t));              //Clear AACDecInfo
-    memset( m_PSInfoBase,        0, sizeof(PSInfoBase_t));              //Clear PSInfoBase
-    memset(&m_AACFrameInfo,      0, sizeof(AACFrameInfo_t));            //Clear AACFrameInfo
-    memset(&m_fhADTS,            0, sizeof(ADTSHeader_t));              //Clear fhADTS
-    memset(&m_fhADIF,            0, sizeof(ADIFHeader_t));              //Clear fhADIS
-    memset( m_pce[0],            0, sizeof(ProgConfigElement_t) * 16);  //Clear ProgConfigElement
-    memset(&m_pulseInfo[0],      0, sizeof(PulseInfo_t) *2);            //Clear PulseInfo
-    memset(&m_aac_BitStreamInfo, 0, sizeof(aac_BitStreamInfo_t));       //Clear aac_BitStreamInfo
-#ifdef AAC_ENABLE_SBR
-    memset( m_PSInfoSBR,         0, sizeof(PSInfoSBR_t));               //Clear PSInfoSBR
-    InitSBRState();
-#endif
+            AACDecoder_Destroy(dec);
+            return NULL;
+    }
+    for(int i = 1; i < 16; i++) dec->pce[i] = dec->pce[0] + i;
 
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
-    for(int ch = 0; ch < MAX_NCHANS_ELEM; ch++)
-        m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
-    m_AACDecInfo->adtsBlocksLeft = 0;
-    m_AACDecInfo->tnsUsed = 0;
-    m_AACDecInfo->pnsUsed = 0;
+    dec->huffFastRef = AACInitHuffFastTables();
+    if(!dec->huffFastRef) {
+            AACDecoder_Destroy(dec);
+            return NULL;
+    }
 
-    return true;
+    AACDecoder_ClearBuffer(dec);
+    return dec;
+}
+bool AACDecoder_AllocateBuffers(void){
+    if(!m_defaultDec) m_defaultDec = AACDecoder_Create();
+    else AACDecoder_ClearBuffer(m_defaultDec);
+    return m_defaultDec != NULL;
+}
+size_t AACDecoder_BufferSize(void){
+    // arena bytes of one context, the huffman tables included, the buffers that go to PSRAM count 0
+    size_t size = ArenaBlockSize(sizeof(AACDecoder_t), AAC_RAM_PSRAM) +
+                  ArenaBlockSize(sizeof(AACDecInfo_t), AAC_RAM_PSRAM) +
+                  ArenaBlockSize(sizeof(ProgConfigElement_t) * 16, AAC_RAM_PSRAM) +
+                  ArenaBlockSize(sizeof(PSInfoBase_t), AAC_RAM_FAST) +
+                  ArenaBlockSize((11 << HUFF_FAST_BITS) * sizeof(uint32_t), ARENA_PREFER_INTERNAL);
+#ifdef AAC_ENABLE_SBR
+    size += ArenaBlockSize(sizeof(PSInfoSBR_t), AAC_RAM_SBR) + ArenaBlockSize(sizeof(PSInfoSBRQMF_t), AAC_RAM_FAST);
+#endif
+#ifdef AAC_ENABLE_PS
+    size += ArenaBlockSize(sizeof(PSInfoPS_t), AAC_RAM_FAST);
+#endif
+    return size;
 }
 
 /**************************************************************************************
@@ -1722,61 +2153,80 @@ bool AACDecoder_AllocateBuffers(void){
  *
  * Description: flush internal codec state (after seeking, for example)
  *
- * Inputs:      valid AAC decoder instance pointer (HAACDecoder)
+ * Inputs:      decoder context (default instance if omitted)
  *
  * Outputs:     updated state variables in aacDecInfo
  *
  * Return:      0 if successful, error code (< 0) if error
  **************************************************************************************/
-int AACFlushCodec()
+int AACFlushCodec(AACDecoder_t *dec)
 {
     int ch;
 
-    if (!m_AACDecInfo)
+    if (!dec || !dec->AACDecInfo)
         return ERR_AAC_NULL_POINTER;
 
     /* reset common state variables which change per-frame
      * don't touch state variables which are (usually) constant for entire clip
      *   (nChans, sampRate, profile, format, sbrEnabled)
      */
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    dec->AACDecInfo->prevBlockID = AAC_ID_INVALID;
+    dec->AACDecInfo->currBlockID = AAC_ID_INVALID;
+    dec->AACDecInfo->currInstTag = -1;
     for (ch = 0; ch < MAX_NCHANS_ELEM; ch++)
-        m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
-    m_AACDecInfo->adtsBlocksLeft = 0;
-    m_AACDecInfo->tnsUsed = 0;
-    m_AACDecInfo->pnsUsed = 0;
+        dec->AACDecInfo->sbDeinterleaveReqd[ch] = 0;
+    dec->AACDecInfo->adtsBlocksLeft = 0;
+    dec->AACDecInfo->tnsUsed = 0;
+    dec->AACDecInfo->pnsUsed = 0;
 
     /* reset internal codec state (flush overlap buffers, etc.) */
-    memset(m_PSInfoBase->overlap, 0,  AAC_MAX_NCHANS * AAC_MAX_NSAMPS * sizeof(int));
-    memset(m_PSInfoBase->prevWinShape, 0, AAC_MAX_NCHANS * sizeof(int));
+    memset(dec->PSInfoBase->overlap, 0,  AAC_MAX_NCHANS * AAC_MAX_NSAMPS * sizeof(int));
+    memset(dec->PSInfoBase->prevWinShape, 0, AAC_MAX_NCHANS * sizeof(int));
+    dec->monoSplit = false;
 
     return ERR_AAC_NONE;
 }
+int AACFlushCodec()
+{
+    return AACFlushCodec(m_defaultDec);
+}
 /***********************************************************************************************************************
- * Function:    AACDecoder_FreeBuffers
+ * Function:    AACDecoder_Destroy, AACDecoder_FreeBuffers
  *
- * Description: allocate all the memory needed for the AAC decoder
+ * Description: frees all the memory used by the AAC decoder
  *
- * Inputs:      none
+ * Inputs:      decoder context (default instance if omitted)
  *
  * Outputs:     none
  *
  * Return:      none
-
+ *
+ * Notes:       safe to call even if some buffers were not allocated
  **********************************************************************************************************************/
-void AACDecoder_FreeBuffers(void) {
-
-//    uint32_t i = ESP.getFreeHeap();
+void AACDecoder_Destroy(AACDecoder_t *dec) {
 
-    if(m_AACDecInfo)                         {free(m_AACDecInfo);    m_AACDecInfo=NULL;}
-    if(m_PSInfoBase)                         {free(m_PSInfoBase);    m_PSInfoBase=NULL;}
-    if(m_pce[0])                             {free(m_pce[0]);        m_pce[0]=NULL;}
+    if(!dec) return;
+    if(m_dec == dec) m_dec = NULL;
+    if(dec->AACDecInfo)                      {ArenaFree(dec->AACDecInfo);    dec->AACDecInfo=NULL;}
+    if(dec->PSInfoBase)                      {ArenaFree(dec->PSInfoBase);    dec->PSInfoBase=NULL;}
+    if(dec->pce[0])                          {ArenaFree(dec->pce[0]);        dec->pce[0]=NULL;}
+    if(dec->huffFastRef)                     {AACFreeHuffFastTables();  dec->huffFastRef=false;}
 
 #ifdef AAC_ENABLE_SBR
-    if(m_PSInfoSBR)                           {free(m_PSInfoSBR);    m_PSInfoSBR=NULL;}               //Clear AACDecInfo
+    if(dec->PSInfoSBR)                       {ArenaFree(dec->PSInfoSBR);     dec->PSInfoSBR=NULL;}
+    if(dec->PSInfoSBRQMF)                    {ArenaFree(dec->PSInfoSBRQMF);  dec->PSInfoSBRQMF=NULL;}
 #endif
+#ifdef AAC_ENABLE_PS
+    if(dec->PSInfoPS)                        {ArenaFree(dec->PSInfoPS);      dec->PSInfoPS=NULL;}
+#endif
+    ArenaFree(dec);
+}
+void AACDecoder_FreeBuffers(void) {
+
+//    uint32_t i = ESP.getFreeHeap();
+
+    AACDecoder_Destroy(m_defaultDec);
+    m_defaultDec = NULL;
 
 //    log_i("AACDecoder: %lu bytes memory was freed", ESP.getFreeHeap() - i);
 }
@@ -1790,29 +2240,50 @@ void AACDecoder_FreeBuffers(void) {
  *
  * Outputs:     none
  *
- * Return:      true if buffers allocated, otherwise false
+ * Return:      true if the default instance is allocated, otherwise false
 
  **********************************************************************************************************************/
 bool AACDecoder_IsInit(void) {
-    if(m_AACDecInfo && m_PSInfoBase && m_pce[0]){
-        return true;
-    }
-    return false;
+    return m_defaultDec != NULL;
 }
-
 /***********************************************************************************************************************
- * Function:    AACDecoder_FreeBuffers
+ * Function:    CheckADTSHeader
  *
- * Description: allocate all the memory needed for the AAC decoder
+ * Description: plausibility check of an ADTS header (needs 7 bytes)
  *
- * Inputs:      none
+ * Inputs:      pointer to the header
  *
- * Outputs:     none
+ * Return:      length of the ADTS frame in bytes, -1 if the header is invalid
+ **********************************************************************************************************************/
+static int CheckADTSHeader(const uint8_t *buf) {
+    if ((buf[0] & SYNCWORDH) != SYNCWORDH || (buf[1] & SYNCWORDL) != SYNCWORDL) return -1;
+    if (buf[1] & 0x06) return -1;                           /* layer must be 0 */
+    if (((buf[2] >> 2) & 0x0f) >= NUM_SAMPLE_RATES) return -1;
+    int len = ((buf[3] & 0x03) << 11) | (buf[4] << 3) | (buf[5] >> 5);
+    if (len < 7) return -1;                                 /* smaller than the header itself */
+    int nch = channelMapTab[((buf[2] & 0x01) << 2) | (buf[3] >> 6)];
+    if (nch < 0) nch = AAC_MAX_NCHANS;                      /* configuration 0, the channels are given by a PCE */
+    int blocks = (buf[6] & 0x03) + 1;                       /* number_of_raw_data_blocks_in_frame + 1 */
+    if (len > 7 + 4 * blocks + blocks * nch * 768) return -1; /* max 6144 bits per channel and block, header, crcs */
+    return len;
+}
+/***********************************************************************************************************************
+ * Function:    FindADTSHeader
  *
- * Return:      none
-
+ * Description: locate the next byte-aligned valid ADTS header, used within AACDecode()
+ *
+ * Inputs:      buffer to search, max number of bytes to search in buffer
+ *
+ * Return:      offset to the header, -1 if not found
  **********************************************************************************************************************/
-
+static int FindADTSHeader(uint8_t *buf, int nBytes) {
+    int i = 0;
+    while ((i = FindFFByte(buf, i, nBytes - 1)) >= 0) {
+        if ((buf[i + 1] & SYNCWORDL) == SYNCWORDL && (i + 7 > nBytes || CheckADTSHeader(buf + i) > 0)) return i;
+        i++;
+    }
+    return -1;
+}
 /***********************************************************************************************************************
  * Function:    AACFindSyncWord
  *
@@ -1825,30 +2296,142 @@ bool AACDecoder_IsInit(void) {
  *
  * Return:      offset to first sync word (bytes from start of buf)
  *              -1 if sync not found after searching nBytes
+ *
+ * Notes:       a candidate is only taken if the next two ADTS headers are consistent with it
+ *              (same id, profile, samplerate and channel configuration). If buf ends before that can be
+ *              checked, the candidate is returned, the caller skips up to it and looks again
+ *              with more data. At offset 0 at least one following header must be confirmed, buf has
+ *              to hold more than one maximal frame. So -1 means that buf contains no frame start except
+ *              maybe the last byte.
  **********************************************************************************************************************/
 int AACFindSyncWord(uint8_t *buf, int nBytes)
 {
-    int i;
+    int i = 0;
 
     /* find byte-aligned syncword (12 bits = 0xFFF) */
-    for (i = 0; i < nBytes - 1; i++) {
-        if ( (buf[i+0] & SYNCWORDH) == SYNCWORDH && (buf[i+1] & SYNCWORDL) == SYNCWORDL )
-            return i;
+    while ((i = FindFFByte(buf, i, nBytes - 1)) >= 0) {
+        if ((buf[i + 1] & SYNCWORDL) != SYNCWORDL) {i++; continue;}
+        if (i + 7 > nBytes) return i;                       /* header incomplete */
+        int len = CheckADTSHeader(buf + i);
+        if (len < 0) {i++; continue;}
+
+        int next = i, confirmed = 0;
+        while (confirmed < 2) {
+            next += len;
+            if (next + 7 > nBytes) break;                   /* not enough data to confirm */
+            if (buf[next + 1] != buf[i + 1] || (buf[next + 2] & 0xfd) != (buf[i + 2] & 0xfd)
+                    || (buf[next + 3] & 0xc0) != (buf[i + 3] & 0xc0)) break;
+            len = CheckADTSHeader(buf + next);
+            if (len < 0) break;
+            confirmed++;
+        }
+        if (confirmed == 2 || (next + 7 > nBytes && (confirmed || i > 0))) return i;
+        i++;
     }
-
     return -1;
 }
 //**************************************************************************************
-int AACGetSampRate(){return m_AACDecInfo->sampRate * (m_AACDecInfo->sbrEnabled ? 2 : 1);}
-int AACGetChannels(){return m_AACDecInfo->nChans;}
+int AACGetSampRate(AACDecoder_t *dec){return dec->AACDecInfo->sampRate * (AACSBRActive(dec) ? 2 : 1);}
+int AACGetChannels(AACDecoder_t *dec){return AACOutChannels(dec);}
 int AACGetBitsPerSample(){return 16;}
-int AACGetID() {return m_AACDecInfo->id;} // 0-MPEG4, 1-MPEG2
-uint8_t AACGetProfile() {return (uint8_t)m_AACDecInfo->profile;} // 0-Main, 1-LC, 2-SSR, 3-reserved
-uint8_t AACGetFormat() {return (uint8_t)m_AACDecInfo->format;}   // 0-unknown 1-ADTS 2-ADIF, 3-RAW
-int AACGetOutputSamps(){return m_AACDecInfo->nChans * AAC_MAX_NSAMPS  * (m_AACDecInfo->sbrEnabled ? 2 : 1);}
-int AACGetBitrate() {
-    uint32_t br = AACGetBitsPerSample() * AACGetChannels() *  AACGetSampRate();
-    return (br / m_AACDecInfo->compressionRatio);
+int AACGetID(AACDecoder_t *dec) {return dec->AACDecInfo->id;} // 0-MPEG4, 1-MPEG2
+uint8_t AACGetProfile(AACDecoder_t *dec) {return (uint8_t)dec->AACDecInfo->profile;} // 0-Main, 1-LC, 2-SSR, 3-reserved
+uint8_t AACGetFormat(AACDecoder_t *dec) {return (uint8_t)dec->AACDecInfo->format;}   // 0-unknown 1-ADTS 2-ADIF, 3-RAW
+int AACGetOutputSamps(AACDecoder_t *dec){return AACOutChannels(dec) * AAC_MAX_NSAMPS  * (AACSBRActive(dec) ? 2 : 1);}
+int AACGetBitrate(AACDecoder_t *dec) {
+    uint32_t br = AACGetBitsPerSample() * AACGetChannels(dec) *  AACGetSampRate(dec);
+    return (br / dec->AACDecInfo->compressionRatio);
+}
+int AACGetSampRate(){return AACGetSampRate(m_defaultDec);}
+int AACGetChannels(){return AACGetChannels(m_defaultDec);}
+int AACGetID() {return AACGetID(m_defaultDec);}
+uint8_t AACGetProfile() {return AACGetProfile(m_defaultDec);}
+uint8_t AACGetFormat() {return AACGetFormat(m_defaultDec);}
+int AACGetOutputSamps(){return AACGetOutputSamps(m_defaultDec);}
+int AACGetBitrate() {return AACGetBitrate(m_defaultDec);}
+/***********************************************************************************************************************
+ * Function:    AACSetDownmix
+ *
+ * Description: request mono output, the channel pair is mixed after the stereo processing, PNS and TNS, only one
+ *                inverse transform runs per frame
+ *
+ * Inputs:      decoder context (default instance if omitted), true for mono
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       the output format does not change, a stereo stream still delivers LRLR... with L == R
+ *              not applied while SBR is active, the SBR envelopes are per channel
+ **********************************************************************************************************************/
+void AACSetDownmix(AACDecoder_t *dec, bool mono) {
+    if(dec) dec->downmix = mono;
+}
+void AACSetDownmix(bool mono) {
+    AACSetDownmix(m_defaultDec, mono);
+}
+/***********************************************************************************************************************
+ * Function:    AACSetQuality
+ *
+ * Description: trade audio bandwidth for CPU time
+ *
+ * Inputs:      decoder context (default instance if omitted), AAC_QUALITY_FULL or AAC_QUALITY_CORE
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       AAC_QUALITY_CORE skips the SBR decoding of HE-AAC streams, the core is output at half the rate,
+ *                AACGetSampRate() and AACGetOutputSamps() follow. No effect on LC streams or without AAC_ENABLE_SBR
+ *              takes effect with the next frame. Back at AAC_QUALITY_FULL the SBR filterbanks restart from
+ *                silence and the envelopes from a reset, the first frames after the switch are not exact
+ **********************************************************************************************************************/
+void AACSetQuality(AACDecoder_t *dec, uint8_t level) {
+    if(!dec) return;
+    if(level > AAC_QUALITY_CORE) level = AAC_QUALITY_CORE;
+#ifdef AAC_ENABLE_SBR
+    PSInfoSBR_t *psi = dec->PSInfoSBR;
+    if(psi && dec->quality != AAC_QUALITY_FULL && level == AAC_QUALITY_FULL) {
+        memset(psi->delayIdxQMFA, 0, sizeof(psi->delayIdxQMFA));
+        memset(psi->delayIdxQMFS, 0, sizeof(psi->delayIdxQMFS));
+        memset(psi->XBufDelay,    0, sizeof(psi->XBufDelay));
+        memset(dec->PSInfoSBRQMF, 0, sizeof(PSInfoSBRQMF_t));
+        for(int ch = 0; ch < AAC_MAX_NCHANS; ch++) psi->sbrChan[ch].reset = 1;
+#ifdef AAC_ENABLE_PS
+        if(dec->PSInfoPS) {
+            uint8_t stereo = dec->PSInfoPS->stereo;  // the output format stays
+            memset(dec->PSInfoPS, 0, sizeof(PSInfoPS_t));
+            dec->PSInfoPS->stereo = stereo;
+        }
+#endif
+    }
+#endif
+    dec->quality = level;
+}
+void AACSetQuality(uint8_t level) {
+    AACSetQuality(m_defaultDec, level);
+}
+/***********************************************************************************************************************
+ * Function:    AACSetParametricStereo
+ *
+ * Description: switch the parametric stereo decoding of HE-AACv2 streams on or off (default on)
+ *
+ * Inputs:      decoder context (default instance if omitted), false to play the PS streams in mono
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       saves the PS share of the SBR time (decorrelator, mixing and the second QMF synthesis), the PS data
+ *                is still parsed. The output stays stereo with L == R, see AACOutChannels()
+ *              no effect without AAC_ENABLE_PS, which is not defined with AAC_DISABLE_PS or without SBR
+ **********************************************************************************************************************/
+void AACSetParametricStereo(AACDecoder_t *dec, bool enable) {
+    if(!dec) return;
+    dec->psOff = !enable;
+}
+void AACSetParametricStereo(bool enable) {
+    AACSetParametricStereo(m_defaultDec, enable);
 }
 /**************************************************************************************
  * Function:    AACSetRawBlockParams
@@ -1870,24 +2453,30 @@ int AACGetBitrate() {
  *                aacFrameInfo to configure its internal state (useful when the
  *                source is MP4 format, for example)
  **************************************************************************************/
-int AACSetRawBlockParams(int copyLast, int nChans, int sampRateCore, int profile)
+int AACSetRawBlockParams(AACDecoder_t *dec, int copyLast, int nChans, int sampRateCore, int profile)
 {
-    if (!m_AACDecInfo)
+    if (!dec || !dec->AACDecInfo)
         return ERR_AAC_NULL_POINTER;
 
-    m_AACDecInfo->format = AAC_FF_RAW;
+    m_dec = dec;
+    m_dec->AACDecInfo->format = AAC_FF_RAW;
     if (copyLast)
         return SetRawBlockParams(1, 0, 0, 0);
     else
         return SetRawBlockParams(0, nChans, sampRateCore, profile);
 }
+int AACSetRawBlockParams(int copyLast, int nChans, int sampRateCore, int profile)
+{
+    return AACSetRawBlockParams(m_defaultDec, copyLast, nChans, sampRateCore, profile);
+}
 
 /***********************************************************************************************************************
  * Function:    AACDecode
  *
  * Description: decode AAC frame
  *
- * Inputs:      double pointer to buffer of AAC data
+ * Inputs:      decoder context (default instance if omitted)
+ *              double pointer to buffer of AAC data
  *              pointer to number of valid bytes remaining in inbuf
  *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
  *
@@ -1902,42 +2491,50 @@ int AACSetRawBlockParams(int copyLast, int nChans, int sampRateCore, int profile
  *                successfully decoded, so if ERR_AAC_INDATA_UNDERFLOW is returned
  *                just call AACDecode again with more data in inbuf
  **********************************************************************************************************************/
-int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
+int AACDecode(AACDecoder_t *dec, uint8_t *inbuf, int *bytesLeft, short *outbuf)
 {
     int err, offset, bitOffset, bitsAvail;
     int ch, baseChan, elementChans;
+    bool mono;
     uint8_t *inptr;
 
 #ifdef AAC_ENABLE_SBR
     int baseChanSBR, elementChansSBR;
 #endif
 
+    if (!dec)
+        return ERR_AAC_NULL_POINTER;
+    m_dec = dec;
+#ifdef AAC_PROFILE
+    uint32_t t0 = ESP.getCycleCount(), t1;
+#endif
+
     /* make local copies (see "Notes" above) */
     inptr = inbuf;
     bitOffset = 0;
     bitsAvail = (*bytesLeft) << 3;
 
     /* first time through figure out what the file format is */
-    if (m_AACDecInfo->format == AAC_FF_Unknown) {
+    if (m_dec->AACDecInfo->format == AAC_FF_Unknown) {
         if (bitsAvail < 32)
             return ERR_AAC_INDATA_UNDERFLOW;
 
         if ((inptr)[0] == 'A' && (inptr)[1] == 'D' && (inptr)[2] == 'I' && (inptr)[3] == 'F') {
             /* unpack ADIF header */
-            m_AACDecInfo->format = AAC_FF_ADIF;
+            m_dec->AACDecInfo->format = AAC_FF_ADIF;
             err = UnpackADIFHeader(&inptr, &bitOffset, &bitsAvail);
             if (err)
                 return err;
         } else {
             /* assume ADTS by default */
-            m_AACDecInfo->format = AAC_FF_ADTS;
+            m_dec->AACDecInfo->format = AAC_FF_ADTS;
         }
     }
     /* if ADTS, search for start of next frame */
-    if (m_AACDecInfo->format == AAC_FF_ADTS) {
+    if (m_dec->AACDecInfo->format == AAC_FF_ADTS) {
         /* can have 1-4 raw data blocks per ADTS frame (header only present for first one) */
-        if (m_AACDecInfo->adtsBlocksLeft == 0) {
-            offset = AACFindSyncWord(inptr, bitsAvail >> 3);
+        if (m_dec->AACDecInfo->adtsBlocksLeft == 0) {
+            offset = FindADTSHeader(inptr, bitsAvail >> 3);
             if (offset < 0)
                 return ERR_AAC_INDATA_UNDERFLOW;
             inptr += offset;
@@ -1947,27 +2544,30 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
             if (err)
                 return err;
 
-            if (m_AACDecInfo->nChans == -1) {
+            if (m_dec->AACDecInfo->nChans == -1) {
                 /* figure out implicit channel mapping if necessary */
                 err = GetADTSChannelMapping(inptr, bitOffset, bitsAvail);
                 if (err)
                     return err;
             }
         }
-        m_AACDecInfo->adtsBlocksLeft--;
-    } else if (m_AACDecInfo->format == AAC_FF_RAW) {
+        m_dec->AACDecInfo->adtsBlocksLeft--;
+    } else if (m_dec->AACDecInfo->format == AAC_FF_RAW) {
         err = PrepareRawBlock();
         if (err)
             return err;
     }
 
     /* check for valid number of channels */
-    if (m_AACDecInfo->nChans > AAC_MAX_NCHANS || m_AACDecInfo->nChans <= 0)
+    if (m_dec->AACDecInfo->nChans > AAC_MAX_NCHANS || m_dec->AACDecInfo->nChans <= 0)
         return ERR_AAC_NCHANS_TOO_HIGH;
 
     /* will be set later if active in this frame */
-    m_AACDecInfo->tnsUsed = 0;
-    m_AACDecInfo->pnsUsed = 0;
+    m_dec->AACDecInfo->tnsUsed = 0;
+    m_dec->AACDecInfo->pnsUsed = 0;
+#ifdef AAC_ENABLE_PS
+    m_dec->PSInfoPS->stereoOut = 0;
+#endif
 
     bitOffset = 0;
     baseChan = 0;
@@ -1982,11 +2582,14 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
         if (err)
             return err;
 
-        elementChans = elementNumChans[m_AACDecInfo->currBlockID];
+        elementChans = elementNumChans[m_dec->AACDecInfo->currBlockID];
         if (baseChan + elementChans > AAC_MAX_NCHANS)
             return ERR_AAC_NCHANS_TOO_HIGH;
 
         /* noiseless decoder and dequantizer */
+#ifdef AAC_PROFILE
+        t1 = ESP.getCycleCount();
+#endif
         for (ch = 0; ch < elementChans; ch++) {
             err = DecodeNoiselessData(&inptr, &bitOffset, &bitsAvail, ch);
 
@@ -1996,47 +2599,62 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
             if (AACDequantize(ch))
                 return ERR_AAC_DEQUANT;
         }
+#ifdef AAC_PROFILE
+        m_dec->profNoiseless += ESP.getCycleCount() - t1;
+#endif
 
         /* mid-side and intensity stereo */
-        if (m_AACDecInfo->currBlockID == AAC_ID_CPE) {
+        if (m_dec->AACDecInfo->currBlockID == AAC_ID_CPE) {
             if (StereoProcess())
                 return ERR_AAC_STEREO_PROCESS;
         }
 
         /* PNS, TNS, inverse transform */
+#ifdef AAC_PROFILE
+        t1 = ESP.getCycleCount();
+#endif
+        mono = (m_dec->AACDecInfo->currBlockID == AAC_ID_CPE && AACDownmixActive());
         for (ch = 0; ch < elementChans; ch++) {
 
             if (PNS(ch))
                 return ERR_AAC_PNS;
 
-            if (m_AACDecInfo->sbDeinterleaveReqd[ch]) {
+            if (m_dec->AACDecInfo->sbDeinterleaveReqd[ch]) {
                 /* deinterleave short blocks, if required */
                 if (DeinterleaveShortBlocks(ch))
                     return ERR_AAC_SHORT_BLOCK_DEINT;
-                m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
+                m_dec->AACDecInfo->sbDeinterleaveReqd[ch] = 0;
             }
 
             if (TNSFilter(ch))
                 return ERR_AAC_TNS;
 
-            if (IMDCT(ch, baseChan + ch, outbuf))
+            if (!mono && IMDCT(ch, baseChan + ch, outbuf))
                 return ERR_AAC_IMDCT;
         }
+        if (mono && AACDownmixIMDCT(outbuf))
+            return ERR_AAC_IMDCT;
+#ifdef AAC_PROFILE
+        m_dec->profImdct += ESP.getCycleCount() - t1;
+#endif
 
 #ifdef AAC_ENABLE_SBR
-        if (m_AACDecInfo->sbrEnabled && (m_AACDecInfo->currBlockID == AAC_ID_FIL ||
-                                         m_AACDecInfo->currBlockID == AAC_ID_LFE)) {
-            if (m_AACDecInfo->currBlockID == AAC_ID_LFE)
+        if (AACSBRActive(m_dec) && (m_dec->AACDecInfo->currBlockID == AAC_ID_FIL ||
+                                         m_dec->AACDecInfo->currBlockID == AAC_ID_LFE)) {
+            if (m_dec->AACDecInfo->currBlockID == AAC_ID_LFE)
                 elementChansSBR = elementNumChans[AAC_ID_LFE];
-            else if (m_AACDecInfo->currBlockID == AAC_ID_FIL && (m_AACDecInfo->prevBlockID == AAC_ID_SCE ||
-                                                                 m_AACDecInfo->prevBlockID == AAC_ID_CPE))
-                elementChansSBR = elementNumChans[m_AACDecInfo->prevBlockID];
+            else if (m_dec->AACDecInfo->currBlockID == AAC_ID_FIL && (m_dec->AACDecInfo->prevBlockID == AAC_ID_SCE ||
+                                                                 m_dec->AACDecInfo->prevBlockID == AAC_ID_CPE))
+                elementChansSBR = elementNumChans[m_dec->AACDecInfo->prevBlockID];
             else
                 elementChansSBR = 0;
 
             if (baseChanSBR + elementChansSBR > AAC_MAX_NCHANS)
                 return ERR_AAC_SBR_NCHANS_TOO_HIGH;
 
+#ifdef AAC_PROFILE
+            t1 = ESP.getCycleCount();
+#endif
             /* parse SBR extension data if present (contained in a fill element) */
             if (DecodeSBRBitstream(baseChanSBR))
                 return ERR_AAC_SBR_BITSTREAM;
@@ -2044,13 +2662,16 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
             /* apply SBR */
             if (DecodeSBRData(baseChanSBR, outbuf))
                 return ERR_AAC_SBR_DATA;
+#ifdef AAC_PROFILE
+            m_dec->profSBR += ESP.getCycleCount() - t1;
+#endif
 
             baseChanSBR += elementChansSBR;
         }
 #endif
 
     baseChan += elementChans;
-    } while (m_AACDecInfo->currBlockID != AAC_ID_END);
+    } while (m_dec->AACDecInfo->currBlockID != AAC_ID_END);
 
     /* byte align after each raw_data_block */
     if (bitOffset) {
@@ -2061,15 +2682,42 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
             return ERR_AAC_INDATA_UNDERFLOW;
     }
 
-    m_AACDecInfo->compressionRatio = (float)(AACGetOutputSamps()) * 2 / (inptr - inbuf);
+#ifdef AAC_ENABLE_PS
+    /* stereo output of a mono SBR stream without parametric stereo in this frame (PS switched off or an error),
+     * both output channels are the same */
+    if (AACOutChannels(m_dec) > m_dec->AACDecInfo->nChans && !m_dec->PSInfoPS->stereoOut) {
+        for (int i = AACGetOutputSamps(m_dec) / 2 - 1; i >= 0; i--)
+            outbuf[2 * i] = outbuf[2 * i + 1] = outbuf[i];
+    }
+#endif
+
+    m_dec->AACDecInfo->compressionRatio = (float)(AACGetOutputSamps(m_dec)) * 2 / (inptr - inbuf);
 
     /* update pointers */
-    m_AACDecInfo->frameCount++;
+    m_dec->AACDecInfo->frameCount++;
     *bytesLeft -= (inptr - inbuf);
     inbuf = inptr;
+#ifdef AAC_PROFILE
+    m_dec->profCycles += ESP.getCycleCount() - t0;
+    if (++m_dec->profFrames == 256) {
+        log_i("AAC placement %d, %lu cycles/frame, noiseless+dequant %lu, PNS/TNS/IMDCT %lu, SBR %lu (QMF analysis %lu, "
+              "HF gen+adj %lu, QMF synthesis %lu)", AAC_PLACEMENT,
+              (unsigned long)(m_dec->profCycles / 256), (unsigned long)(m_dec->profNoiseless / 256),
+              (unsigned long)(m_dec->profImdct / 256), (unsigned long)(m_dec->profSBR / 256),
+              (unsigned long)(m_dec->profQMFA / 256), (unsigned long)(m_dec->profHF / 256),
+              (unsigned long)(m_dec->profQMFS / 256));
+        m_dec->profFrames = 0; m_dec->profCycles = 0;
+        m_dec->profNoiseless = 0; m_dec->profImdct = 0; m_dec->profSBR = 0;
+        m_dec->profQMFA = 0; m_dec->profHF = 0; m_dec->profQMFS = 0;
+    }
+#endif
 
     return ERR_AAC_NONE;
 }
+int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
+{
+    return AACDecode(m_defaultDec, inbuf, bytesLeft, outbuf);
+}
 /***********************************************************************************************************************
  * Function:    DecodeLPCCoefs
  *
@@ -2196,8 +2844,8 @@ int TNSFilter(int ch)
     ICSInfo_t *icsInfo;
     TNSInfo_t *ti;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
-    ti = &m_PSInfoBase->tnsInfo[ch];
+    icsInfo = (ch == 1 && m_dec->PSInfoBase->commonWin == 1) ? &(m_dec->PSInfoBase->icsInfo[0]) : &(m_dec->PSInfoBase->icsInfo[ch]);
+    ti = &m_dec->PSInfoBase->tnsInfo[ch];
 
     if (!ti->tnsDataPresent)
         return 0;
@@ -2205,19 +2853,19 @@ int TNSFilter(int ch)
     if (icsInfo->winSequence == 2) {
         nWindows = NWINDOWS_SHORT;
         winLen = NSAMPS_SHORT;
-        nSFB = sfBandTotalShort[m_PSInfoBase->sampRateIdx];
-        maxOrder = tnsMaxOrderShort[m_AACDecInfo->profile];
-        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
-        tnsMaxBandTab = tnsMaxBandsShort + tnsMaxBandsShortOffset[m_AACDecInfo->profile];
-        tnsMaxBand = tnsMaxBandTab[m_PSInfoBase->sampRateIdx];
+        nSFB = sfBandTotalShort[m_dec->PSInfoBase->sampRateIdx];
+        maxOrder = tnsMaxOrderShort[m_dec->AACDecInfo->profile];
+        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_dec->PSInfoBase->sampRateIdx];
+        tnsMaxBandTab = tnsMaxBandsShort + tnsMaxBandsShortOffset[m_dec->AACDecInfo->profile];
+        tnsMaxBand = tnsMaxBandTab[m_dec->PSInfoBase->sampRateIdx];
     } else {
         nWindows = NWINDOWS_LONG;
         winLen = NSAMPS_LONG;
-        nSFB = sfBandTotalLong[m_PSInfoBase->sampRateIdx];
-        maxOrder = tnsMaxOrderLong[m_AACDecInfo->profile];
-        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
-        tnsMaxBandTab = tnsMaxBandsLong + tnsMaxBandsLongOffset[m_AACDecInfo->profile];
-        tnsMaxBand = tnsMaxBandTab[m_PSInfoBase->sampRateIdx];
+        nSFB = sfBandTotalLong[m_dec->PSInfoBase->sampRateIdx];
+        maxOrder = tnsMaxOrderLong[m_dec->AACDecInfo->profile];
+        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_dec->PSInfoBase->sampRateIdx];
+        tnsMaxBandTab = tnsMaxBandsLong + tnsMaxBandsLongOffset[m_dec->AACDecInfo->profile];
+        tnsMaxBand = tnsMaxBandTab[m_dec->PSInfoBase->sampRateIdx];
     }
 
     if (tnsMaxBand > icsInfo->maxSFB)
@@ -2230,7 +2878,7 @@ int TNSFilter(int ch)
     filtCoef =   ti->coef;
 
     gbMask = 0;
-    audioCoef =  m_PSInfoBase->coef[ch];
+    audioCoef =  m_dec->PSInfoBase->coef[ch];
     for (win = 0; win < nWindows; win++) {
         bottom = nSFB;
         numFilt = ti->numFilt[win];
@@ -2250,9 +2898,9 @@ int TNSFilter(int ch)
                     if (dir)
                         start = end - 1;
 
-                    DecodeLPCCoefs(order, filtRes[win], filtCoef, m_PSInfoBase->tnsLPCBuf, m_PSInfoBase->tnsWorkBuf);
-                    gbMask |= FilterRegion(size, dir, order, audioCoef + start, m_PSInfoBase->tnsLPCBuf,
-                                                                                           m_PSInfoBase->tnsWorkBuf);
+                    DecodeLPCCoefs(order, filtRes[win], filtCoef, m_dec->PSInfoBase->tnsLPCBuf, m_dec->PSInfoBase->tnsWorkBuf);
+                    gbMask |= FilterRegion(size, dir, order, audioCoef + start, m_dec->PSInfoBase->tnsLPCBuf,
+                                                                                           m_dec->PSInfoBase->tnsWorkBuf);
                 }
                 filtCoef += order;
             }
@@ -2262,8 +2910,8 @@ int TNSFilter(int ch)
 
     /* update guard bit count if necessary */
     size = CLZ(gbMask) - 1;
-    if (m_PSInfoBase->gbCurrent[ch] > size)
-        m_PSInfoBase->gbCurrent[ch] = size;
+    if (m_dec->PSInfoBase->gbCurrent[ch] > size)
+        m_dec->PSInfoBase->gbCurrent[ch] = size;
 
     return 0;
 }
@@ -2284,7 +2932,7 @@ int TNSFilter(int ch)
 int DecodeSingleChannelElement()
 {
     /* read instance tag */
-    m_AACDecInfo->currInstTag = GetBits(NUM_INST_TAG_BITS);
+    m_dec->AACDecInfo->currInstTag = GetBits(NUM_INST_TAG_BITS);
 
     return 0;
 }
@@ -2312,25 +2960,25 @@ int DecodeChannelPairElement()
     ICSInfo_t *icsInfo;
 
 
-    icsInfo = m_PSInfoBase->icsInfo;
+    icsInfo = m_dec->PSInfoBase->icsInfo;
 
     /* read instance tag */
-    m_AACDecInfo->currInstTag = GetBits(NUM_INST_TAG_BITS);
+    m_dec->AACDecInfo->currInstTag = GetBits(NUM_INST_TAG_BITS);
 
     /* read common window flag and mid-side info (if present)
-     * store msMask bits in m_PSInfoBase->msMaskBits[] as follows:
+     * store msMask bits in m_dec->PSInfoBase->msMaskBits[] as follows:
      *  long blocks -  pack bits for each SFB in range [0, maxSFB) starting with lsb of msMaskBits[0]
      *  short blocks - pack bits for each SFB in range [0, maxSFB), for each group [0, 7]
      * msMaskPresent = 0 means no M/S coding
-     *               = 1 means m_PSInfoBase->msMaskBits contains 1 bit per SFB to toggle M/S coding
-     *               = 2 means all SFB's are M/S coded (so m_PSInfoBase->msMaskBits is not needed)
+     *               = 1 means m_dec->PSInfoBase->msMaskBits contains 1 bit per SFB to toggle M/S coding
+     *               = 2 means all SFB's are M/S coded (so m_dec->PSInfoBase->msMaskBits is not needed)
      */
-    m_PSInfoBase->commonWin = GetBits(1);
-    if (m_PSInfoBase->commonWin) {
-        DecodeICSInfo(icsInfo, m_PSInfoBase->sampRateIdx);
-        m_PSInfoBase->msMaskPresent = GetBits(2);
-        if (m_PSInfoBase->msMaskPresent == 1) {
-            maskPtr = m_PSInfoBase->msMaskBits;
+    m_dec->PSInfoBase->commonWin = GetBits(1);
+    if (m_dec->PSInfoBase->commonWin) {
+        DecodeICSInfo(icsInfo, m_dec->PSInfoBase->sampRateIdx);
+        m_dec->PSInfoBase->msMaskPresent = GetBits(2);
+        if (m_dec->PSInfoBase->msMaskPresent == 1) {
+            maskPtr = m_dec->PSInfoBase->msMaskBits;
             *maskPtr = 0;
             maskOffset = 0;
             for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
@@ -2366,7 +3014,7 @@ int DecodeChannelPairElement()
 int DecodeLFEChannelElement()
 {
     /* read instance tag */
-    m_AACDecInfo->currInstTag = GetBits( NUM_INST_TAG_BITS);
+    m_dec->AACDecInfo->currInstTag = GetBits( NUM_INST_TAG_BITS);
 
     return 0;
 }
@@ -2388,7 +3036,7 @@ int DecodeDataStreamElement()
     uint32_t byteAlign, dataCount;
     uint8_t *dataBuf;
 
-    m_AACDecInfo->currInstTag = GetBits( NUM_INST_TAG_BITS);
+    m_dec->AACDecInfo->currInstTag = GetBits( NUM_INST_TAG_BITS);
     byteAlign = GetBits(1);
     dataCount = GetBits(8);
     if (dataCount == 255)
@@ -2397,8 +3045,8 @@ int DecodeDataStreamElement()
     if (byteAlign)
         ByteAlignBitstream();
 
-    m_PSInfoBase->dataCount = dataCount;
-    dataBuf = m_PSInfoBase->dataBuf;
+    m_dec->PSInfoBase->dataCount = dataCount;
+    dataBuf = m_dec->PSInfoBase->dataBuf;
     while (dataCount--)
         *dataBuf++ = GetBits(8);
 
@@ -2424,54 +3072,54 @@ int DecodeProgramConfigElement(uint8_t idx)
 {
     int i;
 
-    m_pce[idx]->elemInstTag =   GetBits(4);
-    m_pce[idx]->profile =       GetBits(2);
-    m_pce[idx]->sampRateIdx =   GetBits(4);
-    m_pce[idx]->numFCE =        GetBits(4);
-    m_pce[idx]->numSCE =        GetBits(4);
-    m_pce[idx]->numBCE =        GetBits(4);
-    m_pce[idx]->numLCE =        GetBits(2);
-    m_pce[idx]->numADE =        GetBits(3);
-    m_pce[idx]->numCCE =        GetBits(4);
+    m_dec->pce[idx]->elemInstTag =   GetBits(4);
+    m_dec->pce[idx]->profile =       GetBits(2);
+    m_dec->pce[idx]->sampRateIdx =   GetBits(4);
+    m_dec->pce[idx]->numFCE =        GetBits(4);
+    m_dec->pce[idx]->numSCE =        GetBits(4);
+    m_dec->pce[idx]->numBCE =        GetBits(4);
+    m_dec->pce[idx]->numLCE =        GetBits(2);
+    m_dec->pce[idx]->numADE =        GetBits(3);
+    m_dec->pce[idx]->numCCE =        GetBits(4);
 
-    m_pce[idx]->monoMixdown = GetBits(1) << 4;    /* present flag */
-    if (m_pce[idx]->monoMixdown)
-        m_pce[idx]->monoMixdown |= GetBits(4);    /* element number */
+    m_dec->pce[idx]->monoMixdown = GetBits(1) << 4;    /* present flag */
+    if (m_dec->pce[idx]->monoMixdown)
+        m_dec->pce[idx]->monoMixdown |= GetBits(4);    /* element number */
 
-    m_pce[idx]->stereoMixdown = GetBits(1) << 4;    /* present flag */
-    if (m_pce[idx]->stereoMixdown)
-        m_pce[idx]->stereoMixdown  |= GetBits(4);    /* element number */
+    m_dec->pce[idx]->stereoMixdown = GetBits(1) << 4;    /* present flag */
+    if (m_dec->pce[idx]->stereoMixdown)
+        m_dec->pce[idx]->stereoMixdown  |= GetBits(4);    /* element number */
 
-    m_pce[idx]->matrixMixdown = GetBits(1) << 4;    /* present flag */
-    if (m_pce[idx]->matrixMixdown) {
-        m_pce[idx]->matrixMixdown  |= GetBits(2) << 1;    /* index */
-        m_pce[idx]->matrixMixdown  |= GetBits(1);            /* pseudo-surround enable */
+    m_dec->pce[idx]->matrixMixdown = GetBits(1) << 4;    /* present flag */
+    if (m_dec->pce[idx]->matrixMixdown) {
+        m_dec->pce[idx]->matrixMixdown  |= GetBits(2) << 1;    /* index */
+        m_dec->pce[idx]->matrixMixdown  |= GetBits(1);            /* pseudo-surround enable */
     }
 
-    for (i = 0; i < m_pce[idx]->numFCE; i++) {
-        m_pce[idx]->fce[i]  = GetBits(1) << 4;    /* is_cpe flag */
-        m_pce[idx]->fce[i] |= GetBits(4);            /* tag select */
+    for (i = 0; i < m_dec->pce[idx]->numFCE; i++) {
+        m_dec->pce[idx]->fce[i]  = GetBits(1) << 4;    /* is_cpe flag */
+        m_dec->pce[idx]->fce[i] |= GetBits(4);            /* tag select */
     }
 
-    for (i = 0; i < m_pce[idx]->numSCE; i++) {
-        m_pce[idx]->sce[i]  = GetBits(1) << 4;    /* is_cpe flag */
-        m_pce[idx]->sce[i] |= GetBits(4);            /* tag select */
+    for (i = 0; i < m_dec->pce[idx]->numSCE; i++) {
+        m_dec->pce[idx]->sce[i]  = GetBits(1) << 4;    /* is_cpe flag */
+        m_dec->pce[idx]->sce[i] |= GetBits(4);            /* tag select */
     }
 
-    for (i = 0; i < m_pce[idx]->numBCE; i++) {
-        m_pce[idx]->bce[i]  = GetBits(1) << 4;    /* is_cpe flag */
-        m_pce[idx]->bce[i] |= GetBits(4);            /* tag select */
+    for (i = 0; i < m_dec->pce[idx]->numBCE; i++) {
+        m_dec->pce[idx]->bce[i]  = GetBits(1) << 4;    /* is_cpe flag */
+        m_dec->pce[idx]->bce[i] |= GetBits(4);            /* tag select */
     }
 
-    for (i = 0; i < m_pce[idx]->numLCE; i++)
-        m_pce[idx]->lce[i] = GetBits(4);            /* tag select */
+    for (i = 0; i < m_dec->pce[idx]->numLCE; i++)
+        m_dec->pce[idx]->lce[i] = GetBits(4);            /* tag select */
 
-    for (i = 0; i < m_pce[idx]->numADE; i++)
-        m_pce[idx]->ade[i] = GetBits(4);            /* tag select */
+    for (i = 0; i < m_dec->pce[idx]->numADE; i++)
+        m_dec->pce[idx]->ade[i] = GetBits(4);            /* tag select */
 
-    for (i = 0; i < m_pce[idx]->numCCE; i++) {
-        m_pce[idx]->cce[i]  = GetBits(1) << 4;    /* independent/dependent flag */
-        m_pce[idx]->cce[i] |= GetBits(4);            /* tag select */
+    for (i = 0; i < m_dec->pce[idx]->numCCE; i++) {
+        m_dec->pce[idx]->cce[i]  = GetBits(1) << 4;    /* independent/dependent flag */
+        m_dec->pce[idx]->cce[i] |= GetBits(4);            /* tag select */
     }
 
     ByteAlignBitstream();
@@ -2505,13 +3153,13 @@ int DecodeFillElement()
     if (fillCount == 15)
         fillCount += (GetBits(8) - 1);
 
-    m_PSInfoBase->fillCount = fillCount;
-    fillBuf = m_PSInfoBase->fillBuf;
+    m_dec->PSInfoBase->fillCount = fillCount;
+    fillBuf = m_dec->PSInfoBase->fillBuf;
     while (fillCount--)
         *fillBuf++ = GetBits(8);
 
-    m_AACDecInfo->currInstTag = -1;    /* fill elements don't have instance tag */
-    m_AACDecInfo->fillExtType = 0;
+    m_dec->AACDecInfo->currInstTag = -1;    /* fill elements don't have instance tag */
+    m_dec->AACDecInfo->fillExtType = 0;
 
 #ifdef AAC_ENABLE_SBR
     /* check for SBR
@@ -2519,16 +3167,16 @@ int DecodeFillElement()
      *    need to verify that all SCE/CPE/ICCE have valid SBR fill element following, and
      *    must upsample by 2 for LFE
      */
-    if (m_PSInfoBase->fillCount > 0) {
-        m_AACDecInfo->fillExtType = (int)((m_PSInfoBase->fillBuf[0] >> 4) & 0x0f);
-        if (m_AACDecInfo->fillExtType == EXT_SBR_DATA || m_AACDecInfo->fillExtType == EXT_SBR_DATA_CRC)
-            m_AACDecInfo->sbrEnabled = 1;
+    if (m_dec->PSInfoBase->fillCount > 0) {
+        m_dec->AACDecInfo->fillExtType = (int)((m_dec->PSInfoBase->fillBuf[0] >> 4) & 0x0f);
+        if (m_dec->AACDecInfo->fillExtType == EXT_SBR_DATA || m_dec->AACDecInfo->fillExtType == EXT_SBR_DATA_CRC)
+            m_dec->AACDecInfo->sbrEnabled = 1;
     }
 #endif
 
 
-    m_AACDecInfo->fillBuf = m_PSInfoBase->fillBuf;
-    m_AACDecInfo->fillCount = m_PSInfoBase->fillCount;
+    m_dec->AACDecInfo->fillBuf = m_dec->PSInfoBase->fillBuf;
+    m_dec->AACDecInfo->fillCount = m_dec->PSInfoBase->fillCount;
 
     return 0;
 }
@@ -2559,14 +3207,14 @@ int DecodeNextElement(uint8_t **buf, int *bitOffset, int *bitsAvail)
     SetBitstreamPointer((*bitsAvail + 7) >> 3, *buf);
     GetBits(*bitOffset);
 
-    m_AACDecInfo->prevBlockID = m_AACDecInfo->currBlockID;
-    m_AACDecInfo->currBlockID = GetBits(NUM_SYN_ID_BITS);
+    m_dec->AACDecInfo->prevBlockID = m_dec->AACDecInfo->currBlockID;
+    m_dec->AACDecInfo->currBlockID = GetBits(NUM_SYN_ID_BITS);
 
     /* set defaults (could be overwritten by DecodeXXXElement(), depending on currBlockID) */
-    m_PSInfoBase->commonWin = 0;
+    m_dec->PSInfoBase->commonWin = 0;
 
     err = 0;
-    switch (m_AACDecInfo->currBlockID) {
+    switch (m_dec->AACDecInfo->currBlockID) {
     case AAC_ID_SCE:
         err = DecodeSingleChannelElement();
         break;
@@ -2622,7 +3270,7 @@ int DecodeNextElement(uint8_t **buf, int *bitOffset, int *bitsAvail)
  *              normalization by -1/N is rolled into tables here (see trigtabs.c)
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void PreMultiply(int tabidx, int *zbuf1)
+void AAC_IRAM PreMultiply(int tabidx, int *zbuf1)
 {
     int i, nmdct, ar1, ai1, ar2, ai2, z1, z2;
     int t, cms2, cps2a, sin2a, cps2b, sin2b;
@@ -2682,7 +3330,7 @@ void PreMultiply(int tabidx, int *zbuf1)
  * Notes:       minimum 1 GB in, 2 GB out - gains 2 int bits
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void PostMultiply(int tabidx, int *fft1)
+void AAC_IRAM PostMultiply(int tabidx, int *fft1)
 {
     int i, nmdct, ar1, ai1, ar2, ai2, skipFactor;
     int t, cms2, cps2, sin2;
@@ -2743,7 +3391,7 @@ void PostMultiply(int tabidx, int *fft1)
  *
  * Notes:       see notes on PreMultiply(), above
  **********************************************************************************************************************/
-void PreMultiplyRescale(int tabidx, int *zbuf1, int es)
+void AAC_IRAM PreMultiplyRescale(int tabidx, int *zbuf1, int es)
 {
     int i, nmdct, ar1, ai1, ar2, ai2, z1, z2;
     int t, cms2, cps2a, sin2a, cps2b, sin2b;
@@ -2801,7 +3449,7 @@ void PreMultiplyRescale(int tabidx, int *zbuf1, int es)
  * Notes:       clips output to [-2^30, 2^30 - 1], guaranteeing at least 1 guard bit
  *              see notes on PostMultiply(), above
  **********************************************************************************************************************/
-void PostMultiplyRescale(int tabidx, int *fft1, int es)
+void AAC_IRAM PostMultiplyRescale(int tabidx, int *fft1, int es)
 {
     int i, nmdct, ar1, ai1, ar2, ai2, skipFactor, z;
     int t, cs2, sin2;
@@ -2904,7 +3552,7 @@ void DCT4(int tabidx, int *coef, int gb)
  *
  * Return:      none
  **********************************************************************************************************************/
-void BitReverse(int *inout, int tabidx)
+void AAC_IRAM BitReverse(int *inout, int tabidx)
 {
     int *part0, *part1;
     int a,b, t;
@@ -2953,7 +3601,7 @@ void BitReverse(int *inout, int tabidx)
  * Notes:       assumes 2 guard bits, gains no integer bits,
  *                guard bits out = guard bits in - 2
  **********************************************************************************************************************/
-void R4FirstPass(int *x, int bg)
+void AAC_IRAM R4FirstPass(int *x, int bg)
 {
     int ar, ai, br, bi, cr, ci, dr, di;
 
@@ -2999,7 +3647,7 @@ void R4FirstPass(int *x, int bg)
  *                or guard bits in - 2 (if inputs bounded to +/- sqrt(2)/2)
  *              see scaling comments in code
  **********************************************************************************************************************/
-void R8FirstPass(int *x, int bg)
+void AAC_IRAM R8FirstPass(int *x, int bg)
 {
     int ar, ai, br, bi, cr, ci, dr, di;
     int sr, si, tr, ti, ur, ui, vr, vi;
@@ -3103,11 +3751,94 @@ void R8FirstPass(int *x, int bg)
  *              min 1 GB in
  *              gbOut = gbIn - 1 (short block) or gbIn - 2 (long block)
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
+ *              the twiddle tables start every pass with (1.0, 0), so the first butterfly of a group needs no multiply
  **********************************************************************************************************************/
-void R4Core(int *x, int bg, int gp, int *wtab)
+static inline __attribute__((always_inline)) int *R4CoreButterfly(int *xptr, int step, const int *wptr, bool trivial)
 {
     int ar, ai, br, bi, cr, ci, dr, di, tr, ti;
     int wd, ws, wi;
+
+    ar = xptr[0];
+    ai = xptr[1];
+    xptr += step;
+
+    /* gain 2 int bits for br/bi, cr/ci, dr/di (MULSHIFT32 by Q30)
+     * gain 1 net GB
+     * the first butterfly of a group has the twiddles (1.0, 0), there MULSHIFT32 is the same as >> 2
+     */
+    br = xptr[0];
+    bi = xptr[1];
+    if (trivial) {
+        br >>= 2;
+        bi >>= 2;
+    } else {
+        ws = wptr[0];
+        wi = wptr[1];
+        wd = ws + 2*wi;
+        tr = MULSHIFT32(wi, br + bi);
+        br = MULSHIFT32(wd, br) - tr;    /* cos*br + sin*bi */
+        bi = MULSHIFT32(ws, bi) + tr;    /* cos*bi - sin*br */
+    }
+    xptr += step;
+
+    cr = xptr[0];
+    ci = xptr[1];
+    if (trivial) {
+        cr >>= 2;
+        ci >>= 2;
+    } else {
+        ws = wptr[2];
+        wi = wptr[3];
+        wd = ws + 2*wi;
+        tr = MULSHIFT32(wi, cr + ci);
+        cr = MULSHIFT32(wd, cr) - tr;
+        ci = MULSHIFT32(ws, ci) + tr;
+    }
+    xptr += step;
+
+    dr = xptr[0];
+    di = xptr[1];
+    if (trivial) {
+        dr >>= 2;
+        di >>= 2;
+    } else {
+        ws = wptr[4];
+        wi = wptr[5];
+        wd = ws + 2*wi;
+        tr = MULSHIFT32(wi, dr + di);
+        dr = MULSHIFT32(wd, dr) - tr;
+        di = MULSHIFT32(ws, di) + tr;
+    }
+
+    tr = ar;
+    ti = ai;
+    ar = (tr >> 2) - br;
+    ai = (ti >> 2) - bi;
+    br = (tr >> 2) + br;
+    bi = (ti >> 2) + bi;
+
+    tr = cr;
+    ti = ci;
+    cr = tr + dr;
+    ci = di - ti;
+    dr = tr - dr;
+    di = di + ti;
+
+    xptr[0] = ar + ci;
+    xptr[1] = ai + dr;
+    xptr -= step;
+    xptr[0] = br - cr;
+    xptr[1] = bi - di;
+    xptr -= step;
+    xptr[0] = ar - ci;
+    xptr[1] = ai - dr;
+    xptr -= step;
+    xptr[0] = br + cr;
+    xptr[1] = bi + di;
+    return xptr + 2;
+}
+void AAC_IRAM R4Core(int *x, int bg, int gp, int *wtab)
+{
     int i, j, step;
     int *xptr, *wptr;
 
@@ -3126,73 +3857,12 @@ void R4Core(int *x, int bg, int gp, int *wtab)
          */
         for (i = bg; i != 0; i--) {
 
-            wptr = wtab;
-
-            for (j = gp; j != 0; j--) {
+            xptr = R4CoreButterfly(xptr, step, wtab, true);
+            wptr = wtab + 6;
 
-                ar = xptr[0];
-                ai = xptr[1];
-                xptr += step;
-
-                /* gain 2 int bits for br/bi, cr/ci, dr/di (MULSHIFT32 by Q30)
-                 * gain 1 net GB
-                 */
-                ws = wptr[0];
-                wi = wptr[1];
-                br = xptr[0];
-                bi = xptr[1];
-                wd = ws + 2*wi;
-                tr = MULSHIFT32(wi, br + bi);
-                br = MULSHIFT32(wd, br) - tr;    /* cos*br + sin*bi */
-                bi = MULSHIFT32(ws, bi) + tr;    /* cos*bi - sin*br */
-                xptr += step;
-
-                ws = wptr[2];
-                wi = wptr[3];
-                cr = xptr[0];
-                ci = xptr[1];
-                wd = ws + 2*wi;
-                tr = MULSHIFT32(wi, cr + ci);
-                cr = MULSHIFT32(wd, cr) - tr;
-                ci = MULSHIFT32(ws, ci) + tr;
-                xptr += step;
-
-                ws = wptr[4];
-                wi = wptr[5];
-                dr = xptr[0];
-                di = xptr[1];
-                wd = ws + 2*wi;
-                tr = MULSHIFT32(wi, dr + di);
-                dr = MULSHIFT32(wd, dr) - tr;
-                di = MULSHIFT32(ws, di) + tr;
+            for (j = gp - 1; j != 0; j--) {
+                xptr = R4CoreButterfly(xptr, step, wptr, false);
                 wptr += 6;
-
-                tr = ar;
-                ti = ai;
-                ar = (tr >> 2) - br;
-                ai = (ti >> 2) - bi;
-                br = (tr >> 2) + br;
-                bi = (ti >> 2) + bi;
-
-                tr = cr;
-                ti = ci;
-                cr = tr + dr;
-                ci = di - ti;
-                dr = tr - dr;
-                di = di + ti;
-
-                xptr[0] = ar + ci;
-                xptr[1] = ai + dr;
-                xptr -= step;
-                xptr[0] = br - cr;
-                xptr[1] = bi - di;
-                xptr -= step;
-                xptr[0] = ar - ci;
-                xptr[1] = ai - dr;
-                xptr -= step;
-                xptr[0] = br + cr;
-                xptr[1] = bi + di;
-                xptr += 2;
             }
             xptr += 3*step;
         }
@@ -3262,6 +3932,125 @@ void UnpackZeros(int nVals, int *coef)
     }
 }
 
+/***********************************************************************************************************************
+ * Function:    AACInitHuffFastTables, AACFreeHuffFastTables
+ *
+ * Description: build (free) the single probe lookup tables of the spectral Huffman decoder
+ *
+ * Inputs:      none
+ *
+ * Outputs:     m_huffSpecFast, shared by all decoder contexts, built by the first user, freed by the last one
+ *
+ * Return:      false if not enough memory, otherwise true (Init)
+ *
+ * Notes:       one table per spectral codebook 1..11, each indexed by the next HUFF_FAST_BITS bits of the bitstream
+ *              an entry holds up to two symbols (codeword plus sign bits) with the sign already applied
+ *                bit 0-3 length of the first symbol, bit 4-7 length of both (0 if the second one does not fit)
+ *                bit 8-19 first symbol, bit 20-31 second symbol
+ *                quads: 4 x 3 bits, w in the lowest bits, pairs: 2 x 6 bits, y in the lowest bits
+ *              0 if the first codeword or its sign bits do not fit into HUFF_FAST_BITS or it holds an escape
+ *                (codebook 11). Then the decoder takes the slow path through DecodeHuffmanScalar()
+ **********************************************************************************************************************/
+static int MakeHuffSpecSymbol(int cb, uint32_t cache, int bitsLeft, uint32_t *sym){
+    int32_t val;
+    int v[4], nVals, nSignBits, nCodeBits, i;
+
+    nCodeBits = DecodeHuffmanScalar(huffTabSpec, &huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET], cache, &val);
+    if (nCodeBits > bitsLeft) return 0;
+    if (cb <= 4) {
+        v[0] = ((int32_t)(val) << 20) >> 29;
+        v[1] = ((int32_t)(val) << 23) >> 29;
+        v[2] = ((int32_t)(val) << 26) >> 29;
+        v[3] = ((int32_t)(val) << 29) >> 29;
+        nSignBits = ((uint32_t)(val) << 17) >> 29;
+        nVals = 4;
+    } else {
+        if (cb <= 10) {
+            v[0] = ((int32_t)(val) << 22) >> 27;
+            v[1] = ((int32_t)(val) << 27) >> 27;
+            nSignBits = ((uint32_t)(val) << 20) >> 30;
+        } else {
+            v[0] = ((int32_t)(val) << 20) >> 26;
+            v[1] = ((int32_t)(val) << 26) >> 26;
+            nSignBits = ((uint32_t)(val) << 18) >> 30;
+            if (v[0] == 16 || v[1] == 16) return 0;
+        }
+        nVals = 2;
+    }
+    if (nCodeBits + nSignBits > bitsLeft) return 0;
+    cache <<= nCodeBits;
+    *sym = 0;
+    for (i = 0; i < nVals; i++) {
+        if (nSignBits && v[i]) {
+            if ((int32_t)cache < 0) v[i] = -v[i];
+            cache <<= 1;
+        }
+        if (nVals == 4) *sym |= (uint32_t)(v[i] & 0x07) << (3 * i);
+        else            *sym |= (uint32_t)(v[i] & 0x3f) << (6 * i);
+    }
+    return nCodeBits + nSignBits;
+}
+static uint32_t MakeHuffSpecFast(int cb, unsigned int bits){
+    uint32_t cache = bits << (32 - HUFF_FAST_BITS), sym1, sym2;
+    int len1, len2;
+
+    len1 = MakeHuffSpecSymbol(cb, cache, HUFF_FAST_BITS, &sym1);
+    if (!len1) return 0;
+    len2 = MakeHuffSpecSymbol(cb, cache << len1, HUFF_FAST_BITS - len1, &sym2);
+    if (!len2) return len1 | (sym1 << 8);
+    return len1 | ((len1 + len2) << 4) | (sym1 << 8) | (sym2 << 20);
+}
+bool AACInitHuffFastTables(){
+    std::lock_guard<std::mutex> lock(m_huffSpecFastLock);  /* the second user waits until the tables are complete */
+    if (m_huffSpecFastUsers++) return true;
+    const int size = 11 << HUFF_FAST_BITS;
+    /* probed for every codeword, so internal RAM is preferred also where the decoder buffers are in PSRAM */
+    m_huffSpecFast = (uint32_t*)ArenaMalloc(size * sizeof(uint32_t), ARENA_PREFER_INTERNAL);
+    if (!m_huffSpecFast) {
+        m_huffSpecFastUsers = 0;
+        log_e("not enough memory to allocate the aac huffman tables");
+        return false;
+    }
+    for (int cb = 1; cb <= 11; cb++) {
+        uint32_t *t = m_huffSpecFast + ((cb - HUFFTAB_SPEC_OFFSET) << HUFF_FAST_BITS);
+        for (unsigned int bits = 0; bits < (1u << HUFF_FAST_BITS); bits++) t[bits] = MakeHuffSpecFast(cb, bits);
+    }
+    return true;
+}
+void AACFreeHuffFastTables(){
+    std::lock_guard<std::mutex> lock(m_huffSpecFastLock);
+    if (!m_huffSpecFastUsers || --m_huffSpecFastUsers) return;
+    ArenaFree(m_huffSpecFast);
+    m_huffSpecFast = NULL;
+}
+
+/* The unpack loops work on a local copy of the bitstream reader, refilled bytewise so that it holds at least 25 bits
+ * as long as there are bytes left. Near the end of the buffer and for escape sequences they go through the
+ * regular reader, which pads with zeros.
+ */
+static inline __attribute__((always_inline)) void FillSpecCache(aac_BitStreamInfo_t *bs){
+    while (bs->cachedBits <= 24 && bs->nBytes > 0) {
+        bs->iCache |= (uint32_t)(*bs->bytePtr++) << (24 - bs->cachedBits);
+        bs->cachedBits += 8;
+        bs->nBytes--;
+    }
+}
+static inline __attribute__((always_inline)) uint32_t PeekSpecCache(aac_BitStreamInfo_t *bs, int nBits){
+    if (bs->cachedBits >= nBits) return bs->iCache;
+    m_dec->aac_BitStreamInfo = *bs;
+    return GetBitsNoAdvance(nBits) << (32 - nBits);
+}
+static inline __attribute__((always_inline)) void SkipSpecCache(aac_BitStreamInfo_t *bs, int nBits){
+    if (bs->cachedBits >= nBits) {
+        bs->iCache <<= nBits;
+        bs->cachedBits -= nBits;
+        return;
+    }
+    m_dec->aac_BitStreamInfo = *bs;
+    AdvanceBitstream(nBits);
+    *bs = m_dec->aac_BitStreamInfo;
+}
+
 /***********************************************************************************************************************
  * Function:    UnpackQuads
  *
@@ -3276,16 +4065,44 @@ void UnpackZeros(int nVals, int *coef)
  *
  * Notes:       assumes nVals is always a multiple of 4 because all scalefactor bands
  *                are a multiple of 4 coefficients long
+ *              short codewords (up to two quads per probe) come from m_huffSpecFast
  **********************************************************************************************************************/
-void UnpackQuads(int cb, int nVals, int *coef)
+void AAC_IRAM UnpackQuads(int cb, int nVals, int *coef)
 {
     int w, x, y, z, maxBits, nCodeBits, nSignBits, val;
-    uint32_t bitBuf;
+    uint32_t bitBuf, fe;
+    const uint32_t *tFast = m_huffSpecFast + ((cb - HUFFTAB_SPEC_OFFSET) << HUFF_FAST_BITS);
+    aac_BitStreamInfo_t bs = m_dec->aac_BitStreamInfo;
 
     maxBits = huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET].maxBits + 4;
     while (nVals > 0) {
+        FillSpecCache(&bs);
+        if (bs.cachedBits >= HUFF_FAST_BITS && (fe = tFast[bs.iCache >> (32 - HUFF_FAST_BITS)]) != 0) {
+            /* codewords and sign bits in one probe */
+            coef[0] = ((int32_t)(fe << 21)) >> 29;
+            coef[1] = ((int32_t)(fe << 18)) >> 29;
+            coef[2] = ((int32_t)(fe << 15)) >> 29;
+            coef[3] = ((int32_t)(fe << 12)) >> 29;
+            if ((fe & 0xf0) && nVals >= 8) {
+                coef[4] = ((int32_t)(fe <<  9)) >> 29;
+                coef[5] = ((int32_t)(fe <<  6)) >> 29;
+                coef[6] = ((int32_t)(fe <<  3)) >> 29;
+                coef[7] = ((int32_t)(fe      )) >> 29;
+                nCodeBits = (fe >> 4) & 0x0f;
+                coef += 8;
+                nVals -= 8;
+            } else {
+                nCodeBits = fe & 0x0f;
+                coef += 4;
+                nVals -= 4;
+            }
+            bs.iCache <<= nCodeBits;
+            bs.cachedBits -= nCodeBits;
+            continue;
+        }
+
         /* decode quad */
-        bitBuf = GetBitsNoAdvance(maxBits) << (32 - maxBits);
+        bitBuf = PeekSpecCache(&bs, maxBits);
         nCodeBits = DecodeHuffmanScalar(huffTabSpec, &huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET], bitBuf, &val);
 
         w = (((int32_t)(val) << 20) >>   29);    /* bits 11-9, sign-extend */
@@ -3296,7 +4113,7 @@ void UnpackQuads(int cb, int nVals, int *coef)
         bitBuf <<= nCodeBits;
         nSignBits = (int)(((uint32_t)(val) << 17) >> 29);    /* bits 14-12, unsigned */
 
-        AdvanceBitstream(nCodeBits + nSignBits);
+        SkipSpecCache(&bs, nCodeBits + nSignBits);
         if (nSignBits) {
             if (w)    {w ^= ((int32_t)bitBuf >> 31); w -= ((int32_t)bitBuf >> 31); bitBuf <<= 1;}
             if (x)    {x ^= ((int32_t)bitBuf >> 31); x -= ((int32_t)bitBuf >> 31); bitBuf <<= 1;}
@@ -3306,6 +4123,7 @@ void UnpackQuads(int cb, int nVals, int *coef)
         *coef++ = w; *coef++ = x; *coef++ = y; *coef++ = z;
         nVals -= 4;
     }
+    m_dec->aac_BitStreamInfo = bs;
 }
 
 /***********************************************************************************************************************
@@ -3323,16 +4141,40 @@ void UnpackQuads(int cb, int nVals, int *coef)
  *
  * Notes:       assumes nVals is always a multiple of 2 because all scalefactor bands
  *                are a multiple of 4 coefficients long
+ *              short codewords (up to two pairs per probe) come from m_huffSpecFast
  **********************************************************************************************************************/
-void UnpackPairsNoEsc(int cb, int nVals, int *coef)
+void AAC_IRAM UnpackPairsNoEsc(int cb, int nVals, int *coef)
 {
     int y, z, maxBits, nCodeBits, nSignBits, val;
-    uint32_t bitBuf;
+    uint32_t bitBuf, fe;
+    const uint32_t *tFast = m_huffSpecFast + ((cb - HUFFTAB_SPEC_OFFSET) << HUFF_FAST_BITS);
+    aac_BitStreamInfo_t bs = m_dec->aac_BitStreamInfo;
 
     maxBits = huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET].maxBits + 2;
     while (nVals > 0) {
+        FillSpecCache(&bs);
+        if (bs.cachedBits >= HUFF_FAST_BITS && (fe = tFast[bs.iCache >> (32 - HUFF_FAST_BITS)]) != 0) {
+            /* codewords and sign bits in one probe */
+            coef[0] = ((int32_t)(fe << 18)) >> 26;
+            coef[1] = ((int32_t)(fe << 12)) >> 26;
+            if ((fe & 0xf0) && nVals >= 4) {
+                coef[2] = ((int32_t)(fe <<  6)) >> 26;
+                coef[3] = ((int32_t)(fe      )) >> 26;
+                nCodeBits = (fe >> 4) & 0x0f;
+                coef += 4;
+                nVals -= 4;
+            } else {
+                nCodeBits = fe & 0x0f;
+                coef += 2;
+                nVals -= 2;
+            }
+            bs.iCache <<= nCodeBits;
+            bs.cachedBits -= nCodeBits;
+            continue;
+        }
+
         /* decode pair */
-        bitBuf = GetBitsNoAdvance(maxBits) << (32 - maxBits);
+        bitBuf = PeekSpecCache(&bs, maxBits);
         nCodeBits = DecodeHuffmanScalar(huffTabSpec, &huffTabSpecInfo[cb-HUFFTAB_SPEC_OFFSET], bitBuf, &val);
 
         y = (((int32_t)(val) << 22) >>   27);    /* bits  9-5, sign-extend */
@@ -3340,7 +4182,7 @@ void UnpackPairsNoEsc(int cb, int nVals, int *coef)
 
         bitBuf <<= nCodeBits;
         nSignBits = (((uint32_t)(val) << 20) >> 30);    /* bits 11-10, unsigned */
-        AdvanceBitstream(nCodeBits + nSignBits);
+        SkipSpecCache(&bs, nCodeBits + nSignBits);
         if (nSignBits) {
             if (y)    {y ^= ((int32_t)bitBuf >> 31); y -= ((int32_t)bitBuf >> 31); bitBuf <<= 1;}
             if (z)    {z ^= ((int32_t)bitBuf >> 31); z -= ((int32_t)bitBuf >> 31); bitBuf <<= 1;}
@@ -3348,6 +4190,7 @@ void UnpackPairsNoEsc(int cb, int nVals, int *coef)
         *coef++ = y; *coef++ = z;
         nVals -= 2;
     }
+    m_dec->aac_BitStreamInfo = bs;
 }
 
 /***********************************************************************************************************************
@@ -3365,16 +4208,40 @@ void UnpackPairsNoEsc(int cb, int nVals, int *coef)
  *
  * Notes:       assumes nVals is always a multiple of 2 because all scalefactor bands
  *                are a multiple of 4 coefficients long
+ *              short codewords without escape (up to two pairs per probe) come from m_huffSpecFast
  **********************************************************************************************************************/
-void UnpackPairsEsc(int cb, int nVals, int *coef)
+void AAC_IRAM UnpackPairsEsc(int cb, int nVals, int *coef)
 {
     int y, z, maxBits, nCodeBits, nSignBits, n, val;
-    uint32_t bitBuf;
+    uint32_t bitBuf, fe;
+    const uint32_t *tFast = m_huffSpecFast + ((cb - HUFFTAB_SPEC_OFFSET) << HUFF_FAST_BITS);
+    aac_BitStreamInfo_t bs = m_dec->aac_BitStreamInfo;
 
     maxBits = huffTabSpecInfo[cb - HUFFTAB_SPEC_OFFSET].maxBits + 2;
     while (nVals > 0) {
+        FillSpecCache(&bs);
+        if (bs.cachedBits >= HUFF_FAST_BITS && (fe = tFast[bs.iCache >> (32 - HUFF_FAST_BITS)]) != 0) {
+            /* codewords and sign bits in one probe */
+            coef[0] = ((int32_t)(fe << 18)) >> 26;
+            coef[1] = ((int32_t)(fe << 12)) >> 26;
+            if ((fe & 0xf0) && nVals >= 4) {
+                coef[2] = ((int32_t)(fe <<  6)) >> 26;
+                coef[3] = ((int32_t)(fe      )) >> 26;
+                nCodeBits = (fe >> 4) & 0x0f;
+                coef += 4;
+                nVals -= 4;
+            } else {
+                nCodeBits = fe & 0x0f;
+                coef += 2;
+                nVals -= 2;
+            }
+            bs.iCache <<= nCodeBits;
+            bs.cachedBits -= nCodeBits;
+            continue;
+        }
+
         /* decode pair with escape value */
-        bitBuf = GetBitsNoAdvance(maxBits) << (32 - maxBits);
+        bitBuf = PeekSpecCache(&bs, maxBits);
         nCodeBits = DecodeHuffmanScalar(huffTabSpec, &huffTabSpecInfo[cb-HUFFTAB_SPEC_OFFSET], bitBuf, &val);
 
         y = (((int32_t)(val) << 20) >>   26);    /* bits 11-6, sign-extend */
@@ -3382,19 +4249,23 @@ void UnpackPairsEsc(int cb, int nVals, int *coef)
 
         bitBuf <<= nCodeBits;
         nSignBits = (((uint32_t)(val) << 18) >> 30);    /* bits 13-12, unsigned */
-        AdvanceBitstream(nCodeBits + nSignBits);
-
-        if (y == 16) {
-            n = 4;
-            while (GetBits(1) == 1)
-                n++;
-            y = (1 << n) + GetBits(n);
-        }
-        if (z == 16) {
-            n = 4;
-            while (GetBits(1) == 1)
-                n++;
-            z = (1 << n) + GetBits(n);
+        SkipSpecCache(&bs, nCodeBits + nSignBits);
+
+        if (y == 16 || z == 16) {
+            m_dec->aac_BitStreamInfo = bs;
+            if (y == 16) {
+                n = 4;
+                while (GetBits(1) == 1)
+                    n++;
+                y = (1 << n) + GetBits(n);
+            }
+            if (z == 16) {
+                n = 4;
+                while (GetBits(1) == 1)
+                    n++;
+                z = (1 << n) + GetBits(n);
+            }
+            bs = m_dec->aac_BitStreamInfo;
         }
 
         if (nSignBits) {
@@ -3405,6 +4276,7 @@ void UnpackPairsEsc(int cb, int nVals, int *coef)
         *coef++ = y; *coef++ = z;
         nVals -= 2;
     }
+    m_dec->aac_BitStreamInfo = bs;
 }
 
 /***********************************************************************************************************************
@@ -3430,12 +4302,12 @@ void DecodeSpectrumLong(int ch)
     int *coef;
     ICSInfo_t *icsInfo;
 
-    coef = m_PSInfoBase->coef[ch];
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    coef = m_dec->PSInfoBase->coef[ch];
+    icsInfo = (ch == 1 && m_dec->PSInfoBase->commonWin == 1) ? &(m_dec->PSInfoBase->icsInfo[0]) : &(m_dec->PSInfoBase->icsInfo[ch]);
 
     /* decode long block */
-    sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
-    sfbCodeBook = m_PSInfoBase->sfbCodeBook[ch];
+    sfbTab = sfBandTabLong + sfBandTabLongOffset[m_dec->PSInfoBase->sampRateIdx];
+    sfbCodeBook = m_dec->PSInfoBase->sfbCodeBook[ch];
     for (sfb = 0; sfb < icsInfo->maxSFB; sfb++) {
         cb = *sfbCodeBook++;
         nVals = sfbTab[sfb+1] - sfbTab[sfb];
@@ -3459,15 +4331,15 @@ void DecodeSpectrumLong(int ch)
     UnpackZeros(nVals, coef);
 
     /* add pulse data, if present */
-    if (m_pulseInfo[ch].pulseDataPresent) {
-        coef = m_PSInfoBase->coef[ch];
-        offset = sfbTab[m_pulseInfo[ch].startSFB];
-        for (i = 0; i < m_pulseInfo[ch].numPulse; i++) {
-            offset += m_pulseInfo[ch].offset[i];
+    if (m_dec->pulseInfo[ch].pulseDataPresent) {
+        coef = m_dec->PSInfoBase->coef[ch];
+        offset = sfbTab[m_dec->pulseInfo[ch].startSFB];
+        for (i = 0; i < m_dec->pulseInfo[ch].numPulse; i++) {
+            offset += m_dec->pulseInfo[ch].offset[i];
             if (coef[offset] > 0)
-                coef[offset] += m_pulseInfo[ch].amp[i];
+                coef[offset] += m_dec->pulseInfo[ch].amp[i];
             else
-                coef[offset] -= m_pulseInfo[ch].amp[i];
+                coef[offset] -= m_dec->pulseInfo[ch].amp[i];
         }
         ASSERT(offset < NSAMPS_LONG);
     }
@@ -3496,12 +4368,12 @@ void DecodeSpectrumShort(int ch)
     int *coef;
     ICSInfo_t *icsInfo;
 
-    coef = m_PSInfoBase->coef[ch];
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    coef = m_dec->PSInfoBase->coef[ch];
+    icsInfo = (ch == 1 && m_dec->PSInfoBase->commonWin == 1) ? &(m_dec->PSInfoBase->icsInfo[0]) : &(m_dec->PSInfoBase->icsInfo[ch]);
 
     /* decode short blocks, deinterleaving in-place */
-    sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
-    sfbCodeBook = m_PSInfoBase->sfbCodeBook[ch];
+    sfbTab = sfBandTabShort + sfBandTabShortOffset[m_dec->PSInfoBase->sampRateIdx];
+    sfbCodeBook = m_dec->PSInfoBase->sfbCodeBook[ch];
     for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
         for (sfb = 0; sfb < icsInfo->maxSFB; sfb++) {
             nVals = sfbTab[sfb+1] - sfbTab[sfb];
@@ -3533,7 +4405,7 @@ void DecodeSpectrumShort(int ch)
         coef += (icsInfo->winGroupLen[gp] - 1)*NSAMPS_SHORT;
     }
 
-    ASSERT(coef == m_PSInfoBase->coef[ch] + NSAMPS_LONG);
+    ASSERT(coef == m_dec->PSInfoBase->coef[ch] + NSAMPS_LONG);
 }
 
 #ifndef AAC_ENABLE_SBR
@@ -3558,7 +4430,7 @@ void DecodeSpectrumShort(int ch)
  *              this should fit in registers on ARM
  *
  **********************************************************************************************************************/
-void DecWindowOverlap(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
+void AAC_IRAM DecWindowOverlap(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev)
 {
     int in, w0, w1, f0, f1;
     int *buf1, *over1;
@@ -4001,17 +4873,17 @@ int IMDCT(int ch, int chOut, short *outbuf)
     int i;
     ICSInfo_t *icsInfo;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && m_dec->PSInfoBase->commonWin == 1) ? &(m_dec->PSInfoBase->icsInfo[0]) : &(m_dec->PSInfoBase->icsInfo[ch]);
     outbuf += chOut;
 
     /* optimized type-IV DCT (operates inplace) */
     if (icsInfo->winSequence == 2) {
         /* 8 short blocks */
         for (i = 0; i < 8; i++)
-            DCT4(0, m_PSInfoBase->coef[ch] + i*128, m_PSInfoBase->gbCurrent[ch]);
+            DCT4(0, m_dec->PSInfoBase->coef[ch] + i*128, m_dec->PSInfoBase->gbCurrent[ch]);
     } else {
         /* 1 long block */
-        DCT4(1, m_PSInfoBase->coef[ch], m_PSInfoBase->gbCurrent[ch]);
+        DCT4(1, m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->gbCurrent[ch]);
     }
 
 #ifdef AAC_ENABLE_SBR
@@ -4019,50 +4891,138 @@ int IMDCT(int ch, int chOut, short *outbuf)
      * store the decoded 32-bit samples in top half (second AAC_MAX_NSAMPS samples) of coef buffer
      */
     if (icsInfo->winSequence == 0)
-        DecWindowOverlapNoClip(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut],
-                               m_PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapNoClip(m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->overlap[chOut],
+                               m_dec->PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_dec->PSInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 1)
-        DecWindowOverlapLongStartNoClip(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut],
-                                        m_PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapLongStartNoClip(m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->overlap[chOut],
+                                        m_dec->PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_dec->PSInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 2)
-        DecWindowOverlapShortNoClip(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut],
-                                    m_PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapShortNoClip(m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->overlap[chOut],
+                                    m_dec->PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_dec->PSInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 3)
-        DecWindowOverlapLongStopNoClip(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut],
-                                       m_PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapLongStopNoClip(m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->overlap[chOut],
+                                       m_dec->PSInfoBase->sbrWorkBuf[ch], icsInfo->winShape, m_dec->PSInfoBase->prevWinShape[chOut]);
 
-    if (!m_AACDecInfo->sbrEnabled) {
+    if (!AACSBRActive(m_dec)) {
         for (i = 0; i < AAC_MAX_NSAMPS; i++) {
-            *outbuf = CLIPTOSHORT((m_PSInfoBase->sbrWorkBuf[ch][i] + RND_VAL) >> FBITS_OUT_IMDCT);
-            outbuf += m_AACDecInfo->nChans;
+            *outbuf = CLIPTOSHORT((m_dec->PSInfoBase->sbrWorkBuf[ch][i] + RND_VAL) >> FBITS_OUT_IMDCT);
+            outbuf += m_dec->AACDecInfo->nChans;
         }
     }
 
-    m_AACDecInfo->rawSampleBuf[ch] = m_PSInfoBase->sbrWorkBuf[ch];
-    m_AACDecInfo->rawSampleBytes = sizeof(int);
-    m_AACDecInfo->rawSampleFBits = FBITS_OUT_IMDCT;
+    m_dec->AACDecInfo->rawSampleBuf[ch] = m_dec->PSInfoBase->sbrWorkBuf[ch];
+    m_dec->AACDecInfo->rawSampleBytes = sizeof(int);
+    m_dec->AACDecInfo->rawSampleFBits = FBITS_OUT_IMDCT;
 #else
     /* window, overlap-add, round to PCM - optimized for each window sequence */
     if (icsInfo->winSequence == 0)
-        DecWindowOverlap(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut], outbuf, m_AACDecInfo->nChans,
-                                                                  icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlap(m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->overlap[chOut], outbuf, m_dec->AACDecInfo->nChans,
+                                                                  icsInfo->winShape, m_dec->PSInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 1)
-        DecWindowOverlapLongStart(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut], outbuf, m_AACDecInfo->nChans,
-                                                                  icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapLongStart(m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->overlap[chOut], outbuf, m_dec->AACDecInfo->nChans,
+                                                                  icsInfo->winShape, m_dec->PSInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 2)
-        DecWindowOverlapShort(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut], outbuf, m_AACDecInfo->nChans,
-                                                                  icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapShort(m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->overlap[chOut], outbuf, m_dec->AACDecInfo->nChans,
+                                                                  icsInfo->winShape, m_dec->PSInfoBase->prevWinShape[chOut]);
     else if (icsInfo->winSequence == 3)
-        DecWindowOverlapLongStop(m_PSInfoBase->coef[ch], m_PSInfoBase->overlap[chOut], outbuf, m_AACDecInfo->nChans,
-                                                                  icsInfo->winShape, m_PSInfoBase->prevWinShape[chOut]);
+        DecWindowOverlapLongStop(m_dec->PSInfoBase->coef[ch], m_dec->PSInfoBase->overlap[chOut], outbuf, m_dec->AACDecInfo->nChans,
+                                                                  icsInfo->winShape, m_dec->PSInfoBase->prevWinShape[chOut]);
 
-    m_AACDecInfo->rawSampleBuf[ch] = 0;
-    m_AACDecInfo->rawSampleBytes = 0;
-    m_AACDecInfo->rawSampleFBits = 0;
+    m_dec->AACDecInfo->rawSampleBuf[ch] = 0;
+    m_dec->AACDecInfo->rawSampleBytes = 0;
+    m_dec->AACDecInfo->rawSampleFBits = 0;
 #endif
 
-    m_PSInfoBase->prevWinShape[chOut] = icsInfo->winShape;
+    m_dec->PSInfoBase->prevWinShape[chOut] = icsInfo->winShape;
+
+    return 0;
+}
+
+/***********************************************************************************************************************
+ * Function:    AACDownmixActive
+ *
+ * Description: follow AACSetDownmix() for the current channel pair element
+ *
+ * Inputs:      none
+ *
+ * Outputs:     overlap state handed over between the modes
+ *
+ * Return:      true if the channel pair is transformed once for both channels
+ *
+ * Notes:       entering the mix keeps the overlaps apart until AACDownmixIMDCT() can merge them,
+ *                leaving it gives the mixed overlap to both channels
+ **********************************************************************************************************************/
+bool AACDownmixActive() {
+    bool mono = m_dec->downmix && m_dec->AACDecInfo->nChans == 2;
+
+    if (AACSBRActive(m_dec))
+        mono = false;
+    if (mono && !m_dec->monoActive)
+        m_dec->monoSplit = true;
+    else if (!mono && m_dec->monoActive && !m_dec->monoSplit) {
+        memcpy(m_dec->PSInfoBase->overlap[1], m_dec->PSInfoBase->overlap[0], AAC_MAX_NSAMPS * sizeof(int));
+        m_dec->PSInfoBase->prevWinShape[1] = m_dec->PSInfoBase->prevWinShape[0];
+    }
+    m_dec->monoActive = mono;
+    return mono;
+}
+
+/***********************************************************************************************************************
+ * Function:    AACDownmixIMDCT
+ *
+ * Description: inverse transform of a channel pair for mono output
+ *
+ * Inputs:      both channels after stereo processing, PNS and TNS
+ *
+ * Outputs:     PCM samples, interleaved LRLR... with L == R
+ *
+ * Return:      0 if successful, -1 if error
+ *
+ * Notes:       with the same window sequence and shape in both channels the spectra are averaged and only
+ *                channel 0 is transformed, overlap[0] then holds the overlap of the mix
+ *              otherwise both channels are transformed, each starting from the mixed overlap, and the PCM is
+ *                averaged. Their overlaps stay separate until prevWinShape matches again
+ **********************************************************************************************************************/
+int AACDownmixIMDCT(short *outbuf) {
+    int i;
+    PSInfoBase_t *psi = m_dec->PSInfoBase;
+    ICSInfo_t *ics0 = &psi->icsInfo[0];
+    ICSInfo_t *ics1 = (psi->commonWin == 1) ? &psi->icsInfo[0] : &psi->icsInfo[1];
+    bool sameWin = ics0->winSequence == ics1->winSequence && ics0->winShape == ics1->winShape;
+
+    if (m_dec->monoSplit && sameWin && psi->prevWinShape[0] == psi->prevWinShape[1]) {
+        for (i = 0; i < AAC_MAX_NSAMPS; i++)
+            psi->overlap[0][i] = AVG2(psi->overlap[0][i], psi->overlap[1][i]);
+        m_dec->monoSplit = false;
+    }
+
+    if (!m_dec->monoSplit && sameWin) {
+        /* mix the spectra, one inverse transform for both channels */
+        for (i = 0; i < AAC_MAX_NSAMPS; i++)
+            psi->coef[0][i] = AVG2(psi->coef[0][i], psi->coef[1][i]);
+        psi->gbCurrent[0] = MIN(psi->gbCurrent[0], psi->gbCurrent[1]);
+        if (IMDCT(0, 0, outbuf))
+            return -1;
+#ifdef AAC_ENABLE_SBR
+        /* SBR may be switched on by a fill element of this frame */
+        memcpy(psi->sbrWorkBuf[1], psi->sbrWorkBuf[0], AAC_MAX_NSAMPS * sizeof(int));
+        m_dec->AACDecInfo->rawSampleBuf[1] = psi->sbrWorkBuf[1];
+#endif
+        for (i = 0; i < AAC_MAX_NSAMPS; i++)
+            outbuf[2 * i + 1] = outbuf[2 * i];
+        return 0;
+    }
 
+    if (!m_dec->monoSplit) {
+        /* different windows, both channels continue from the mixed overlap */
+        memcpy(psi->overlap[1], psi->overlap[0], AAC_MAX_NSAMPS * sizeof(int));
+        psi->prevWinShape[1] = psi->prevWinShape[0];
+        m_dec->monoSplit = true;
+    }
+    if (IMDCT(0, 0, outbuf) || IMDCT(1, 1, outbuf))
+        return -1;
+    for (i = 0; i < AAC_MAX_NSAMPS; i++)
+        outbuf[2 * i] = outbuf[2 * i + 1] = (outbuf[2 * i] + outbuf[2 * i + 1]) >> 1;
     return 0;
 }
 
@@ -4257,11 +5217,11 @@ void DecodePulseInfo(uint8_t ch)
 {
     int i;
 
-    m_pulseInfo[ch].numPulse = GetBits(2) + 1;        /* add 1 here */
-    m_pulseInfo[ch].startSFB = GetBits(6);
-    for (i = 0; i < m_pulseInfo[ch].numPulse; i++) {
-        m_pulseInfo[ch].offset[i] = GetBits(5);
-        m_pulseInfo[ch].amp[i] = GetBits(4);
+    m_dec->pulseInfo[ch].numPulse = GetBits(2) + 1;        /* add 1 here */
+    m_dec->pulseInfo[ch].startSFB = GetBits(6);
+    for (i = 0; i < m_dec->pulseInfo[ch].numPulse; i++) {
+        m_dec->pulseInfo[ch].offset[i] = GetBits(5);
+        m_dec->pulseInfo[ch].amp[i] = GetBits(4);
     }
 }
 
@@ -4400,27 +5360,27 @@ void DecodeICS(int ch)
     TNSInfo_t *ti;
     GainControlInfo_t *gi;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && m_dec->PSInfoBase->commonWin == 1) ? &(m_dec->PSInfoBase->icsInfo[0]) : &(m_dec->PSInfoBase->icsInfo[ch]);
 
     globalGain = GetBits(8);
-    if (!m_PSInfoBase->commonWin)
-        DecodeICSInfo(icsInfo, m_PSInfoBase->sampRateIdx);
+    if (!m_dec->PSInfoBase->commonWin)
+        DecodeICSInfo(icsInfo, m_dec->PSInfoBase->sampRateIdx);
 
-    DecodeSectionData(icsInfo->winSequence, icsInfo->numWinGroup, icsInfo->maxSFB, m_PSInfoBase->sfbCodeBook[ch]);
+    DecodeSectionData(icsInfo->winSequence, icsInfo->numWinGroup, icsInfo->maxSFB, m_dec->PSInfoBase->sfbCodeBook[ch]);
 
-    DecodeScaleFactors(icsInfo->numWinGroup, icsInfo->maxSFB, globalGain, m_PSInfoBase->sfbCodeBook[ch],
-                                                                                        m_PSInfoBase->scaleFactors[ch]);
+    DecodeScaleFactors(icsInfo->numWinGroup, icsInfo->maxSFB, globalGain, m_dec->PSInfoBase->sfbCodeBook[ch],
+                                                                                        m_dec->PSInfoBase->scaleFactors[ch]);
 
-    m_pulseInfo[ch].pulseDataPresent = GetBits(1);
-    if (m_pulseInfo[ch].pulseDataPresent)
+    m_dec->pulseInfo[ch].pulseDataPresent = GetBits(1);
+    if (m_dec->pulseInfo[ch].pulseDataPresent)
         DecodePulseInfo(ch);
 
-    ti = &m_PSInfoBase->tnsInfo[ch];
+    ti = &m_dec->PSInfoBase->tnsInfo[ch];
     ti->tnsDataPresent = GetBits(1);
     if (ti->tnsDataPresent)
         DecodeTNSInfo(icsInfo->winSequence, ti, ti->coef);
 
-    gi = &m_PSInfoBase->gainControlInfo[ch];
+    gi = &m_dec->PSInfoBase->gainControlInfo[ch];
     gi->gainControlDataPresent = GetBits(1);
     if (gi->gainControlDataPresent)
         DecodeGainControlInfo(icsInfo->winSequence, gi);
@@ -4447,7 +5407,7 @@ int DecodeNoiselessData(uint8_t **buf, int *bitOffset, int *bitsAvail, int ch)
     int bitsUsed;
     ICSInfo_t *icsInfo;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && m_dec->PSInfoBase->commonWin == 1) ? &(m_dec->PSInfoBase->icsInfo[0]) : &(m_dec->PSInfoBase->icsInfo[ch]);
 
     SetBitstreamPointer((*bitsAvail+7) >> 3, *buf);
     GetBits(*bitOffset);
@@ -4464,8 +5424,8 @@ int DecodeNoiselessData(uint8_t **buf, int *bitOffset, int *bitsAvail, int ch)
     *bitOffset = ((bitsUsed + *bitOffset) & 0x07);
     *bitsAvail -= bitsUsed;
 
-    m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
-    m_AACDecInfo->tnsUsed |= m_PSInfoBase->tnsInfo[ch].tnsDataPresent;    /* set flag if TNS used for any channel */
+    m_dec->AACDecInfo->sbDeinterleaveReqd[ch] = 0;
+    m_dec->AACDecInfo->tnsUsed |= m_dec->PSInfoBase->tnsInfo[ch].tnsDataPresent;    /* set flag if TNS used for any channel */
 
     return ERR_AAC_NONE;
 }
@@ -4488,7 +5448,7 @@ int DecodeNoiselessData(uint8_t **buf, int *bitOffset, int *bitsAvail, int ch)
  *                if there are no codes at nBits, then we just keep << 1 each time
  *                  (since count[nBits] = 0)
  **********************************************************************************************************************/
-int DecodeHuffmanScalar(const signed short *huffTab, const HuffInfo_t *huffTabInfo, uint32_t bitBuf, int32_t *val)
+int AAC_IRAM DecodeHuffmanScalar(const signed short *huffTab, const HuffInfo_t *huffTabInfo, uint32_t bitBuf, int32_t *val)
 {
     uint32_t count, start, shift, t;
     const uint8_t *countPtr;
@@ -4543,59 +5503,59 @@ int UnpackADTSHeader(uint8_t **buf, int *bitOffset, int *bitsAvail)
     }
 
     /* fixed fields - should not change from frame to frame */
-    m_fhADTS.id =               GetBits(1);
-    m_fhADTS.layer =            GetBits(2);
-    m_fhADTS.protectBit =       GetBits(1);
-    m_fhADTS.profile =          GetBits(2);
-    m_fhADTS.sampRateIdx =      GetBits(4);
-    m_fhADTS.privateBit =       GetBits(1);
-    m_fhADTS.channelConfig =    GetBits(3);
-    m_fhADTS.origCopy =         GetBits(1);
-    m_fhADTS.home =             GetBits(1);
+    m_dec->fhADTS.id =               GetBits(1);
+    m_dec->fhADTS.layer =            GetBits(2);
+    m_dec->fhADTS.protectBit =       GetBits(1);
+    m_dec->fhADTS.profile =          GetBits(2);
+    m_dec->fhADTS.sampRateIdx =      GetBits(4);
+    m_dec->fhADTS.privateBit =       GetBits(1);
+    m_dec->fhADTS.channelConfig =    GetBits(3);
+    m_dec->fhADTS.origCopy =         GetBits(1);
+    m_dec->fhADTS.home =             GetBits(1);
 
     /* variable fields - can change from frame to frame */
-    m_fhADTS.copyBit =          GetBits(1);
-    m_fhADTS.copyStart =        GetBits(1);
-    m_fhADTS.frameLength =      GetBits(13);
-    m_fhADTS.bufferFull =       GetBits(11);
-    m_fhADTS.numRawDataBlocks = GetBits(2) + 1;
+    m_dec->fhADTS.copyBit =          GetBits(1);
+    m_dec->fhADTS.copyStart =        GetBits(1);
+    m_dec->fhADTS.frameLength =      GetBits(13);
+    m_dec->fhADTS.bufferFull =       GetBits(11);
+    m_dec->fhADTS.numRawDataBlocks = GetBits(2) + 1;
 
     /* note - MPEG4 spec, correction 1 changes how CRC is handled when protectBit == 0 and numRawDataBlocks > 1 */
-    if (m_fhADTS.protectBit == 0)
-        m_fhADTS.crcCheckWord = GetBits(16);
+    if (m_dec->fhADTS.protectBit == 0)
+        m_dec->fhADTS.crcCheckWord = GetBits(16);
 
     /* byte align */
     ByteAlignBitstream();    /* should always be aligned anyway */
 
     /* check validity of header */
-    if (m_fhADTS.layer != 0 || m_fhADTS.profile != AAC_PROFILE_LC ||
-        m_fhADTS.sampRateIdx >= NUM_SAMPLE_RATES || m_fhADTS.channelConfig >= NUM_DEF_CHAN_MAPS)
+    if (m_dec->fhADTS.layer != 0 || m_dec->fhADTS.profile != AAC_PROFILE_LC ||
+        m_dec->fhADTS.sampRateIdx >= NUM_SAMPLE_RATES || m_dec->fhADTS.channelConfig >= NUM_DEF_CHAN_MAPS)
         return ERR_AAC_INVALID_ADTS_HEADER;
 
 #ifndef AAC_ENABLE_MPEG4
-    if (m_fhADTS.id != 1)
+    if (m_dec->fhADTS.id != 1)
         return ERR_AAC_MPEG4_UNSUPPORTED;
 #endif
 
 
     /* update codec info */
-    m_PSInfoBase->sampRateIdx = m_fhADTS.sampRateIdx;
-    if (!m_PSInfoBase->useImpChanMap)
-        m_PSInfoBase->nChans = channelMapTab[m_fhADTS.channelConfig];
+    m_dec->PSInfoBase->sampRateIdx = m_dec->fhADTS.sampRateIdx;
+    if (!m_dec->PSInfoBase->useImpChanMap)
+        m_dec->PSInfoBase->nChans = channelMapTab[m_dec->fhADTS.channelConfig];
 
     /* syntactic element fields will be read from bitstream for each element */
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    m_dec->AACDecInfo->prevBlockID = AAC_ID_INVALID;
+    m_dec->AACDecInfo->currBlockID = AAC_ID_INVALID;
+    m_dec->AACDecInfo->currInstTag = -1;
 
     /* fill in user-accessible data */
-    m_AACDecInfo->bitRate = 0;
-    m_AACDecInfo->nChans = m_PSInfoBase->nChans;
-    m_AACDecInfo->sampRate = sampRateTab[m_PSInfoBase->sampRateIdx];
-    m_AACDecInfo->id = m_fhADTS.id;
-    m_AACDecInfo->profile = m_fhADTS.profile;
-    m_AACDecInfo->sbrEnabled = 0;
-    m_AACDecInfo->adtsBlocksLeft = m_fhADTS.numRawDataBlocks;
+    m_dec->AACDecInfo->bitRate = 0;
+    m_dec->AACDecInfo->nChans = m_dec->PSInfoBase->nChans;
+    m_dec->AACDecInfo->sampRate = sampRateTab[m_dec->PSInfoBase->sampRateIdx];
+    m_dec->AACDecInfo->id = m_dec->fhADTS.id;
+    m_dec->AACDecInfo->profile = m_dec->fhADTS.profile;
+    m_dec->AACDecInfo->sbrEnabled = 0;
+    m_dec->AACDecInfo->adtsBlocksLeft = m_dec->fhADTS.numRawDataBlocks;
 
     /* update bitstream reader */
     bitsUsed = CalcBitsUsed(*buf, *bitOffset);
@@ -4635,7 +5595,7 @@ int GetADTSChannelMapping(uint8_t *buf, int bitOffset, int bitsAvail)
         if (err)
             return err;
 
-        elementChans = elementNumChans[m_AACDecInfo->currBlockID];
+        elementChans = elementNumChans[m_dec->AACDecInfo->currBlockID];
         nChans += elementChans;
 
         for (ch = 0; ch < elementChans; ch++) {
@@ -4643,15 +5603,15 @@ int GetADTSChannelMapping(uint8_t *buf, int bitOffset, int bitsAvail)
             if (err)
                 return err;
         }
-    } while (m_AACDecInfo->currBlockID != AAC_ID_END);
+    } while (m_dec->AACDecInfo->currBlockID != AAC_ID_END);
 
     if (nChans <= 0)
         return ERR_AAC_CHANNEL_MAP;
 
     /* update number of channels in codec state and user-accessible info structs */
-    m_PSInfoBase->nChans = nChans;
-    m_AACDecInfo->nChans = m_PSInfoBase->nChans;
-    m_PSInfoBase->useImpChanMap = 1;
+    m_dec->PSInfoBase->nChans = nChans;
+    m_dec->AACDecInfo->nChans = m_dec->PSInfoBase->nChans;
+    m_dec->PSInfoBase->useImpChanMap = 1;
 
     return ERR_AAC_NONE;
 }
@@ -4679,26 +5639,26 @@ int GetNumChannelsADIF(int nPCE)
     nChans = 0;
     for (i = 0; i < nPCE; i++) {
         /* for now: only support LC, no channel coupling */
-        if (m_pce[i]->profile != AAC_PROFILE_LC || m_pce[i]->numCCE > 0)
+        if (m_dec->pce[i]->profile != AAC_PROFILE_LC || m_dec->pce[i]->numCCE > 0)
             return -1;
 
         /* add up number of channels in all channel elements (assume all single-channel) */
-       nChans += m_pce[i]->numFCE;
-       nChans += m_pce[i]->numSCE;
-       nChans += m_pce[i]->numBCE;
-       nChans += m_pce[i]->numLCE;
+       nChans += m_dec->pce[i]->numFCE;
+       nChans += m_dec->pce[i]->numSCE;
+       nChans += m_dec->pce[i]->numBCE;
+       nChans += m_dec->pce[i]->numLCE;
 
         /* add one more for every element which is a channel pair */
-       for (j = 0; j < m_pce[i]->numFCE; j++) {
-           if ((m_pce[i]->fce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
+       for (j = 0; j < m_dec->pce[i]->numFCE; j++) {
+           if ((m_dec->pce[i]->fce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
                nChans++;
        }
-       for (j = 0; j < m_pce[i]->numSCE; j++) {
-           if ((m_pce[i]->sce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
+       for (j = 0; j < m_dec->pce[i]->numSCE; j++) {
+           if ((m_dec->pce[i]->sce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
                nChans++;
        }
-       for (j = 0; j < m_pce[i]->numBCE; j++) {
-           if ((m_pce[i]->bce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
+       for (j = 0; j < m_dec->pce[i]->numBCE; j++) {
+           if ((m_dec->pce[i]->bce[j] & 0x10) >> 4)  /* bit 4 = SCE/CPE flag */
                nChans++;
        }
 
@@ -4728,9 +5688,9 @@ int GetSampleRateIdxADIF(int nPCE)
         return -1;
 
     /* make sure all PCE's have the same sample rate */
-    idx = m_pce[0]->sampRateIdx;
+    idx = m_dec->pce[0]->sampRateIdx;
     for (i = 1; i < nPCE; i++) {
-        if (m_pce[i]->sampRateIdx != idx)
+        if (m_dec->pce[i]->sampRateIdx != idx)
             return -1;
     }
 
@@ -4768,45 +5728,45 @@ int UnpackADIFHeader(uint8_t **buf, int *bitOffset, int *bitsAvail)
         return ERR_AAC_INVALID_ADIF_HEADER;
 
     /* read ADIF header fields */
-    m_fhADIF.copyBit = GetBits(1);
-    if (m_fhADIF.copyBit) {
+    m_dec->fhADIF.copyBit = GetBits(1);
+    if (m_dec->fhADIF.copyBit) {
         for (i = 0; i < ADIF_COPYID_SIZE; i++)
-            m_fhADIF.copyID[i] = GetBits(8);
+            m_dec->fhADIF.copyID[i] = GetBits(8);
     }
-    m_fhADIF.origCopy = GetBits(1);
-    m_fhADIF.home =     GetBits(1);
-    m_fhADIF.bsType =   GetBits(1);
-    m_fhADIF.bitRate =  GetBits(23);
-    m_fhADIF.numPCE =   GetBits(4) + 1;    /* add 1 (so range = [1, 16]) */
-    if (m_fhADIF.bsType == 0)
-        m_fhADIF.bufferFull = GetBits(20);
+    m_dec->fhADIF.origCopy = GetBits(1);
+    m_dec->fhADIF.home =     GetBits(1);
+    m_dec->fhADIF.bsType =   GetBits(1);
+    m_dec->fhADIF.bitRate =  GetBits(23);
+    m_dec->fhADIF.numPCE =   GetBits(4) + 1;    /* add 1 (so range = [1, 16]) */
+    if (m_dec->fhADIF.bsType == 0)
+        m_dec->fhADIF.bufferFull = GetBits(20);
 
     /* parse all program config elements */
-    for (i = 0; i < m_fhADIF.numPCE; i++)
+    for (i = 0; i < m_dec->fhADIF.numPCE; i++)
         DecodeProgramConfigElement(i);
 
     /* byte align */
     ByteAlignBitstream();
 
     /* update codec info */
-    m_PSInfoBase->nChans = GetNumChannelsADIF(m_fhADIF.numPCE);
-    m_PSInfoBase->sampRateIdx = GetSampleRateIdxADIF(m_fhADIF.numPCE);
+    m_dec->PSInfoBase->nChans = GetNumChannelsADIF(m_dec->fhADIF.numPCE);
+    m_dec->PSInfoBase->sampRateIdx = GetSampleRateIdxADIF(m_dec->fhADIF.numPCE);
 
     /* check validity of header */
-    if (m_PSInfoBase->nChans < 0 || m_PSInfoBase->sampRateIdx < 0 || m_PSInfoBase->sampRateIdx >= NUM_SAMPLE_RATES)
+    if (m_dec->PSInfoBase->nChans < 0 || m_dec->PSInfoBase->sampRateIdx < 0 || m_dec->PSInfoBase->sampRateIdx >= NUM_SAMPLE_RATES)
         return ERR_AAC_INVALID_ADIF_HEADER;
 
     /* syntactic element fields will be read from bitstream for each element */
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    m_dec->AACDecInfo->prevBlockID = AAC_ID_INVALID;
+    m_dec->AACDecInfo->currBlockID = AAC_ID_INVALID;
+    m_dec->AACDecInfo->currInstTag = -1;
 
     /* fill in user-accessible data */
-    m_AACDecInfo->bitRate = 0;
-    m_AACDecInfo->nChans = m_PSInfoBase->nChans;
-    m_AACDecInfo->sampRate = sampRateTab[m_PSInfoBase->sampRateIdx];
-    m_AACDecInfo->profile = m_pce[0]->profile;
-    m_AACDecInfo->sbrEnabled = 0;
+    m_dec->AACDecInfo->bitRate = 0;
+    m_dec->AACDecInfo->nChans = m_dec->PSInfoBase->nChans;
+    m_dec->AACDecInfo->sampRate = sampRateTab[m_dec->PSInfoBase->sampRateIdx];
+    m_dec->AACDecInfo->profile = m_dec->pce[0]->profile;
+    m_dec->AACDecInfo->sbrEnabled = 0;
 
     /* update bitstream reader */
     bitsUsed = CalcBitsUsed(*buf, *bitOffset);
@@ -4834,7 +5794,7 @@ int UnpackADIFHeader(uint8_t **buf, int *bitOffset, int *bitsAvail)
 *
 * Return:      0 if successful, error code (< 0) if error
 *
-* Notes:       if copyLast == 1, then m_PSInfoBase->nChans, m_PSInfoBase->sampRateIdx, and
+* Notes:       if copyLast == 1, then m_dec->PSInfoBase->nChans, m_dec->PSInfoBase->sampRateIdx, and
 *                aacDecInfo->profile are not changed (it's assumed that we already
 *                set them, such as by a previous call to UnpackADTSHeader())
 *              if copyLast == 0, then the parameters we passed in are used instead
@@ -4844,23 +5804,23 @@ int SetRawBlockParams(int copyLast, int nChans, int sampRate, int profile)
     int idx;
 
     if (!copyLast) {
-        m_AACDecInfo->profile = profile;
-        m_PSInfoBase->nChans = nChans;
+        m_dec->AACDecInfo->profile = profile;
+        m_dec->PSInfoBase->nChans = nChans;
         for (idx = 0; idx < NUM_SAMPLE_RATES; idx++) {
             if (sampRate == sampRateTab[idx]) {
-                m_PSInfoBase->sampRateIdx = idx;
+                m_dec->PSInfoBase->sampRateIdx = idx;
                 break;
             }
         }
         if (idx == NUM_SAMPLE_RATES)
             return ERR_AAC_INVALID_FRAME;
     }
-    m_AACDecInfo->nChans = m_PSInfoBase->nChans;
-    m_AACDecInfo->sampRate = sampRateTab[m_PSInfoBase->sampRateIdx];
+    m_dec->AACDecInfo->nChans = m_dec->PSInfoBase->nChans;
+    m_dec->AACDecInfo->sampRate = sampRateTab[m_dec->PSInfoBase->sampRateIdx];
 
     /* check validity of header */
-    if (m_PSInfoBase->sampRateIdx >= NUM_SAMPLE_RATES || m_PSInfoBase->sampRateIdx < 0 ||
-        m_AACDecInfo->profile != AAC_PROFILE_LC)
+    if (m_dec->PSInfoBase->sampRateIdx >= NUM_SAMPLE_RATES || m_dec->PSInfoBase->sampRateIdx < 0 ||
+        m_dec->AACDecInfo->profile != AAC_PROFILE_LC)
         return ERR_AAC_RAWBLOCK_PARAMS;
 
     return ERR_AAC_NONE;
@@ -4880,13 +5840,13 @@ int SetRawBlockParams(int copyLast, int nChans, int sampRate, int profile)
 int PrepareRawBlock()
 {
     /* syntactic element fields will be read from bitstream for each element */
-    m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currBlockID = AAC_ID_INVALID;
-    m_AACDecInfo->currInstTag = -1;
+    m_dec->AACDecInfo->prevBlockID = AAC_ID_INVALID;
+    m_dec->AACDecInfo->currBlockID = AAC_ID_INVALID;
+    m_dec->AACDecInfo->currInstTag = -1;
 
     /* fill in user-accessible data */
-    m_AACDecInfo->bitRate = 0;
-    m_AACDecInfo->sbrEnabled = 0;
+    m_dec->AACDecInfo->bitRate = 0;
+    m_dec->AACDecInfo->sbrEnabled = 0;
 
     return ERR_AAC_NONE;
 }
@@ -4909,7 +5869,7 @@ int PrepareRawBlock()
  *              clips outputs to Q(FBITS_OUT_DQ_OFF)
  *              output has no minimum number of guard bits
  **********************************************************************************************************************/
-int DequantBlock(int *inbuf, int nSamps, int scale)
+int AAC_IRAM DequantBlock(int *inbuf, int nSamps, int scale)
 {
     int iSamp, scalef, scalei, x, y, gbMask, shift, tab4[4];
     const uint32_t *tab16, *coef;
@@ -4994,7 +5954,7 @@ int DequantBlock(int *inbuf, int nSamps, int scale)
                 if (x < 0x40000000)
                     x <<= 1, shift += 1;
 
-                coef = (x < SQRTHALF) ? poly43lo : poly43hi;
+                coef = ((uint32_t)x < SQRTHALF) ? poly43lo : poly43hi;
 
                 /* polynomial */
                 y = coef[0];
@@ -5064,21 +6024,21 @@ int AACDequantize(int ch)
     short *scaleFactors;
     ICSInfo_t *icsInfo;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && m_dec->PSInfoBase->commonWin == 1) ? &(m_dec->PSInfoBase->icsInfo[0]) : &(m_dec->PSInfoBase->icsInfo[ch]);
 
     if (icsInfo->winSequence == 2) {
-        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_dec->PSInfoBase->sampRateIdx];
         nSamps = NSAMPS_SHORT;
     } else {
-        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_dec->PSInfoBase->sampRateIdx];
         nSamps = NSAMPS_LONG;
     }
-    coef = m_PSInfoBase->coef[ch];
-    sfbCodeBook = m_PSInfoBase->sfbCodeBook[ch];
-    scaleFactors = m_PSInfoBase->scaleFactors[ch];
+    coef = m_dec->PSInfoBase->coef[ch];
+    sfbCodeBook = m_dec->PSInfoBase->sfbCodeBook[ch];
+    scaleFactors = m_dec->PSInfoBase->scaleFactors[ch];
 
-    m_PSInfoBase->intensityUsed[ch] = 0;
-    m_PSInfoBase->pnsUsed[ch] = 0;
+    m_dec->PSInfoBase->intensityUsed[ch] = 0;
+    m_dec->PSInfoBase->pnsUsed[ch] = 0;
     gbMask = 0;
     for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
         for (win = 0; win < icsInfo->winGroupLen[gp]; win++) {
@@ -5091,9 +6051,9 @@ int AACDequantize(int ch)
                 if (cb >= 0 && cb <= 11)
                     gbMask |= DequantBlock(coef, width, scaleFactors[sfb]);
                 else if (cb == 13)
-                    m_PSInfoBase->pnsUsed[ch] = 1;
+                    m_dec->PSInfoBase->pnsUsed[ch] = 1;
                 else if (cb == 14 || cb == 15)
-                    m_PSInfoBase->intensityUsed[ch] = 1;    /* should only happen if ch == 1 */
+                    m_dec->PSInfoBase->intensityUsed[ch] = 1;    /* should only happen if ch == 1 */
                 coef += width;
             }
             coef += (nSamps - sfbTab[icsInfo->maxSFB]);
@@ -5101,10 +6061,10 @@ int AACDequantize(int ch)
         sfbCodeBook += icsInfo->maxSFB;
         scaleFactors += icsInfo->maxSFB;
     }
-    m_AACDecInfo->pnsUsed |= m_PSInfoBase->pnsUsed[ch];    /* set flag if PNS used for any channel */
+    m_dec->AACDecInfo->pnsUsed |= m_dec->PSInfoBase->pnsUsed[ch];    /* set flag if PNS used for any channel */
 
     /* calculate number of guard bits in dequantized data */
-    m_PSInfoBase->gbCurrent[ch] = CLZ(gbMask) - 1;
+    m_dec->PSInfoBase->gbCurrent[ch] = CLZ(gbMask) - 1;
 
     return ERR_AAC_NONE;
 }
@@ -5125,7 +6085,7 @@ int AACDequantize(int ch)
 int DeinterleaveShortBlocks(int ch)
 {
 //    (void)aacDecInfo;
-//    (void)ch;
+    (void)ch;
     /* not used for this implementation - short block deinterleaving performed during Huffman decoding */
     return ERR_AAC_NONE;
 }
@@ -5357,27 +6317,27 @@ int PNS(int ch)
     uint8_t *msMaskPtr;
     ICSInfo_t *icsInfo;
 
-    icsInfo = (ch == 1 && m_PSInfoBase->commonWin == 1) ? &(m_PSInfoBase->icsInfo[0]) : &(m_PSInfoBase->icsInfo[ch]);
+    icsInfo = (ch == 1 && m_dec->PSInfoBase->commonWin == 1) ? &(m_dec->PSInfoBase->icsInfo[0]) : &(m_dec->PSInfoBase->icsInfo[ch]);
 
-    if (!m_PSInfoBase->pnsUsed[ch])
+    if (!m_dec->PSInfoBase->pnsUsed[ch])
         return 0;
 
     if (icsInfo->winSequence == 2) {
-        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_dec->PSInfoBase->sampRateIdx];
         nSamps = NSAMPS_SHORT;
     } else {
-        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_dec->PSInfoBase->sampRateIdx];
         nSamps = NSAMPS_LONG;
     }
-    coef = m_PSInfoBase->coef[ch];
-    sfbCodeBook = m_PSInfoBase->sfbCodeBook[ch];
-    scaleFactors = m_PSInfoBase->scaleFactors[ch];
-    checkCorr = (m_AACDecInfo->currBlockID == AAC_ID_CPE && m_PSInfoBase->commonWin == 1 ? 1 : 0);
+    coef = m_dec->PSInfoBase->coef[ch];
+    sfbCodeBook = m_dec->PSInfoBase->sfbCodeBook[ch];
+    scaleFactors = m_dec->PSInfoBase->scaleFactors[ch];
+    checkCorr = (m_dec->AACDecInfo->currBlockID == AAC_ID_CPE && m_dec->PSInfoBase->commonWin == 1 ? 1 : 0);
 
     gbMask = 0;
     for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
         for (win = 0; win < icsInfo->winGroupLen[gp]; win++) {
-            msMaskPtr = m_PSInfoBase->msMaskBits + ((gp*icsInfo->maxSFB) >> 3);
+            msMaskPtr = m_dec->PSInfoBase->msMaskBits + ((gp*icsInfo->maxSFB) >> 3);
             msMaskOffset = ((gp*icsInfo->maxSFB) & 0x07);
             msMask = (*msMaskPtr++) >> msMaskOffset;
 
@@ -5389,20 +6349,20 @@ int PNS(int ch)
                          * if ch 1 has PNS enabled for this SFB but it's uncorrelated (i.e. ms_used == 0),
                          *    the copied values will be overwritten when we process ch 1
                          */
-                        GenerateNoiseVector(coef, &m_PSInfoBase->pnsLastVal, width);
-                        if (checkCorr && m_PSInfoBase->sfbCodeBook[1][gp*icsInfo->maxSFB + sfb] == 13)
-                            CopyNoiseVector(coef, m_PSInfoBase->coef[1] + (coef - m_PSInfoBase->coef[0]), width);
+                        GenerateNoiseVector(coef, &m_dec->PSInfoBase->pnsLastVal, width);
+                        if (checkCorr && m_dec->PSInfoBase->sfbCodeBook[1][gp*icsInfo->maxSFB + sfb] == 13)
+                            CopyNoiseVector(coef, m_dec->PSInfoBase->coef[1] + (coef - m_dec->PSInfoBase->coef[0]), width);
                     } else {
                         /* generate new vector if no correlation between channels */
                         genNew = 1;
-                        if (checkCorr && m_PSInfoBase->sfbCodeBook[0][gp*icsInfo->maxSFB + sfb] == 13) {
-                            if((m_PSInfoBase->msMaskPresent==1 && (msMask & 0x01)) || m_PSInfoBase->msMaskPresent == 2 )
+                        if (checkCorr && m_dec->PSInfoBase->sfbCodeBook[0][gp*icsInfo->maxSFB + sfb] == 13) {
+                            if((m_dec->PSInfoBase->msMaskPresent==1 && (msMask & 0x01)) || m_dec->PSInfoBase->msMaskPresent == 2 )
                                 genNew = 0;
                         }
                         if (genNew)
-                            GenerateNoiseVector(coef, &m_PSInfoBase->pnsLastVal, width);
+                            GenerateNoiseVector(coef, &m_dec->PSInfoBase->pnsLastVal, width);
                     }
-                    gbMask |= ScaleNoiseVector(coef, width, m_PSInfoBase->scaleFactors[ch][gp*icsInfo->maxSFB + sfb]);
+                    gbMask |= ScaleNoiseVector(coef, width, m_dec->PSInfoBase->scaleFactors[ch][gp*icsInfo->maxSFB + sfb]);
                 }
                 coef += width;
 
@@ -5421,8 +6381,8 @@ int PNS(int ch)
 
     /* update guard bit count if necessary */
     gb = CLZ(gbMask) - 1;
-    if (m_PSInfoBase->gbCurrent[ch] > gb)
-        m_PSInfoBase->gbCurrent[ch] = gb;
+    if (m_dec->PSInfoBase->gbCurrent[ch] > gb)
+        m_dec->PSInfoBase->gbCurrent[ch] = gb;
 
     return 0;
 }
@@ -5598,32 +6558,32 @@ int StereoProcess()
 
 
     /* mid-side and intensity stereo require common_window == 1 (see MPEG4 spec, Correction 2, 2004) */
-    if (m_PSInfoBase->commonWin != 1 || m_AACDecInfo->currBlockID != AAC_ID_CPE)
+    if (m_dec->PSInfoBase->commonWin != 1 || m_dec->AACDecInfo->currBlockID != AAC_ID_CPE)
         return 0;
 
     /* nothing to do */
-    if (!m_PSInfoBase->msMaskPresent && !m_PSInfoBase->intensityUsed[1])
+    if (!m_dec->PSInfoBase->msMaskPresent && !m_dec->PSInfoBase->intensityUsed[1])
         return 0;
 
-    icsInfo = &(m_PSInfoBase->icsInfo[0]);
+    icsInfo = &(m_dec->PSInfoBase->icsInfo[0]);
     if (icsInfo->winSequence == 2) {
-        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabShort + sfBandTabShortOffset[m_dec->PSInfoBase->sampRateIdx];
         nSamps = NSAMPS_SHORT;
     } else {
-        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_PSInfoBase->sampRateIdx];
+        sfbTab = sfBandTabLong + sfBandTabLongOffset[m_dec->PSInfoBase->sampRateIdx];
         nSamps = NSAMPS_LONG;
     }
-    coefL = m_PSInfoBase->coef[0];
-    coefR = m_PSInfoBase->coef[1];
+    coefL = m_dec->PSInfoBase->coef[0];
+    coefR = m_dec->PSInfoBase->coef[1];
 
     /* do fused mid-side/intensity processing for each block (one long or eight short) */
     msMaskOffset = 0;
-    msMaskPtr = m_PSInfoBase->msMaskBits;
+    msMaskPtr = m_dec->PSInfoBase->msMaskBits;
     for (gp = 0; gp < icsInfo->numWinGroup; gp++) {
         for (win = 0; win < icsInfo->winGroupLen[gp]; win++) {
-            StereoProcessGroup(coefL, coefR, sfbTab, m_PSInfoBase->msMaskPresent,
-                msMaskPtr, msMaskOffset, icsInfo->maxSFB, m_PSInfoBase->sfbCodeBook[1] + gp*icsInfo->maxSFB,
-                m_PSInfoBase->scaleFactors[1] + gp*icsInfo->maxSFB, m_PSInfoBase->gbCurrent);
+            StereoProcessGroup(coefL, coefR, sfbTab, m_dec->PSInfoBase->msMaskPresent,
+                msMaskPtr, msMaskOffset, icsInfo->maxSFB, m_dec->PSInfoBase->sfbCodeBook[1] + gp*icsInfo->maxSFB,
+                m_dec->PSInfoBase->scaleFactors[1] + gp*icsInfo->maxSFB, m_dec->PSInfoBase->gbCurrent);
             coefL += nSamps;
             coefR += nSamps;
         }
@@ -5632,8 +6592,8 @@ int StereoProcess()
         msMaskOffset = (msMaskOffset + icsInfo->maxSFB) & 0x07;
     }
 
-    ASSERT(coefL == m_PSInfoBase->coef[0] + 1024);
-    ASSERT(coefR == m_PSInfoBase->coef[1] + 1024);
+    ASSERT(coefL == m_dec->PSInfoBase->coef[0] + 1024);
+    ASSERT(coefR == m_dec->PSInfoBase->coef[1] + 1024);
 
     return 0;
 }
@@ -5778,65 +6738,13 @@ int InvRNormalized(int r)
 
 
 /***********************************************************************************************************************
- * Function:    BitReverse32
+ * Function:    R8FirstPass32
  *
- * Description: Ken's fast in-place bit reverse
+ * Description: radix-8 trivial pass for decimation-in-time FFT (log2(N) = 5)
  *
- * Inputs:      buffer of 32 complex samples
+ * Inputs:      buffer of (bit-reversed) samples
  *
- * Outputs:     bit-reversed samples in same buffer
- *
- * Return:      none
-***********************************************************************************************************************/
-void BitReverse32(int *inout)
-{
-    int t;
-    t=inout[2] ; inout[2]=inout[32]; inout[32]=t;
-    t=inout[3] ; inout[3]=inout[33]; inout[33]=t;
-
-    t=inout[4] ; inout[4]=inout[16]; inout[16]=t;
-    t=inout[5] ; inout[5]=inout[17]; inout[17]=t;
-
-    t=inout[6] ; inout[6]=inout[48]; inout[48]=t;
-    t=inout[7] ; inout[7]=inout[49]; inout[49]=t;
-
-    t=inout[10]; inout[10]=inout[40]; inout[40]=t;
-    t=inout[11]; inout[11]=inout[41]; inout[41]=t;
-
-    t=inout[12]; inout[12]=inout[24]; inout[24]=t;
-    t=inout[13]; inout[13]=inout[25]; inout[25]=t;
-
-    t=inout[14]; inout[14]=inout[56]; inout[56]=t;
-    t=inout[15]; inout[15]=inout[57]; inout[57]=t;
-
-    t=inout[18]; inout[18]=inout[36]; inout[36]=t;
-    t=inout[19]; inout[19]=inout[37]; inout[37]=t;
-
-    t=inout[22]; inout[22]=inout[52]; inout[52]=t;
-    t=inout[23]; inout[23]=inout[53]; inout[53]=t;
-
-    t=inout[26]; inout[26]=inout[44]; inout[44]=t;
-    t=inout[27]; inout[27]=inout[45]; inout[45]=t;
-
-    t=inout[30]; inout[30]=inout[60]; inout[60]=t;
-    t=inout[31]; inout[31]=inout[61]; inout[61]=t;
-
-    t=inout[38]; inout[38]=inout[50]; inout[50]=t;
-    t=inout[39]; inout[39]=inout[51]; inout[51]=t;
-
-    t=inout[46]; inout[46]=inout[58]; inout[58]=t;
-    t=inout[47]; inout[47]=inout[59]; inout[59]=t;
-
-}
-
-/***********************************************************************************************************************
- * Function:    R8FirstPass32
- *
- * Description: radix-8 trivial pass for decimation-in-time FFT (log2(N) = 5)
- *
- * Inputs:      buffer of (bit-reversed) samples
- *
- * Outputs:     processed samples in same buffer
+ * Outputs:     processed samples in same buffer
  *
  * Return:      none
  *
@@ -5847,7 +6755,7 @@ void BitReverse32(int *inout)
  *              should compile with no stack spills on ARM (verify compiled output)
  *              current instruction count (per pass): 16 LDR, 16 STR, 4 SMULL, 61 ALU
  **********************************************************************************************************************/
-void R8FirstPass32(int *r0)
+void AAC_IRAM R8FirstPass32(int *r0)
 {
     int r1, r2, r3, r4, r5, r6, r7;
     int r8, r9, r10, r11, r12, r14;
@@ -5997,7 +6905,7 @@ void R8FirstPass32(int *r0)
  *              should compile with no stack spills on ARM (verify compiled output)
  *              current instruction count (per pass): 16 LDR, 16 STR, 4 SMULL, 61 ALU
  **********************************************************************************************************************/
-void R4Core32(int *r0)
+void AAC_IRAM R4Core32(int *r0)
 {
     int r2, r3, r4, r5, r6, r7;
     int r8, r9, r10, r12, r14;
@@ -6078,7 +6986,7 @@ void R4Core32(int *r0)
  *
  * Description: Ken's very fast in-place radix-4 decimation-in-time FFT
  *
- * Inputs:      buffer of 32 complex samples (before bit-reversal)
+ * Inputs:      buffer of 32 complex samples (after bit-reversal, PreMultiply64() stores them in that order)
  *
  * Outputs:     processed samples in same buffer
  *
@@ -6091,10 +6999,7 @@ void R4Core32(int *r0)
  **********************************************************************************************************************/
 void FFT32C(int *x)
 {
-    /* decimation in time */
-    BitReverse32(x);
-
-    /* 32-point complex FFT */
+    /* decimation in time, 32-point complex FFT */
     R8FirstPass32(x);    /* gain 1 int bit,  lose 2 GB (making assumptions about input) */
     R4Core32(x);        /* gain 2 int bits, lose 0 GB (making assumptions about input) */
 }
@@ -6115,7 +7020,7 @@ void FFT32C(int *x)
  * Notes:       this is carefully written to be efficient on ARM
  *              use the assembly code version in sbrcov.s when building for ARM!
  **********************************************************************************************************************/
-void CVKernel1(int *XBuf, int *accBuf)
+void AAC_IRAM CVKernel1(int *XBuf, int *accBuf)
 {
     U64 p01re, p01im, p12re, p12im, p11re, p22re;
     int n, x0re, x0im, x1re, x1im;
@@ -6188,7 +7093,7 @@ void CVKernel1(int *XBuf, int *accBuf)
  * Notes:       this is carefully written to be efficient on ARM
  *              use the assembly code version in sbrcov.s when building for ARM!
  **********************************************************************************************************************/
-void CVKernel2(int *XBuf, int *accBuf)
+void AAC_IRAM CVKernel2(int *XBuf, int *accBuf)
 {
     U64 p02re, p02im;
     int n, x0re, x0im, x1re, x1im, x2re, x2im;
@@ -6240,10 +7145,10 @@ void CVKernel2(int *XBuf, int *accBuf)
 void SetBitstreamPointer(int nBytes, uint8_t *buf)
 {
     /* init bitstream */
-    m_aac_BitStreamInfo.bytePtr = buf;
-    m_aac_BitStreamInfo.iCache = 0;        /* 4-byte uint32_t */
-    m_aac_BitStreamInfo.cachedBits = 0;    /* i.e. zero bits in cache */
-    m_aac_BitStreamInfo.nBytes = nBytes;
+    m_dec->aac_BitStreamInfo.bytePtr = buf;
+    m_dec->aac_BitStreamInfo.iCache = 0;        /* 4-byte uint32_t */
+    m_dec->aac_BitStreamInfo.cachedBits = 0;    /* i.e. zero bits in cache */
+    m_dec->aac_BitStreamInfo.nBytes = nBytes;
 }
 
 /***********************************************************************************************************************
@@ -6264,25 +7169,25 @@ void SetBitstreamPointer(int nBytes, uint8_t *buf)
 //Optimized for REV16, REV32 (FB)
 inline void RefillBitstreamCache()
 {
-    int nBytes = m_aac_BitStreamInfo.nBytes;
+    int nBytes = m_dec->aac_BitStreamInfo.nBytes;
     if (nBytes >= 4) {
         /* optimize for common case, independent of machine endian-ness */
-        m_aac_BitStreamInfo.iCache  = (*m_aac_BitStreamInfo.bytePtr++) << 24;
-        m_aac_BitStreamInfo.iCache |= (*m_aac_BitStreamInfo.bytePtr++) << 16;
-        m_aac_BitStreamInfo.iCache |= (*m_aac_BitStreamInfo.bytePtr++) <<  8;
-        m_aac_BitStreamInfo.iCache |= (*m_aac_BitStreamInfo.bytePtr++);
+        m_dec->aac_BitStreamInfo.iCache  = (*m_dec->aac_BitStreamInfo.bytePtr++) << 24;
+        m_dec->aac_BitStreamInfo.iCache |= (*m_dec->aac_BitStreamInfo.bytePtr++) << 16;
+        m_dec->aac_BitStreamInfo.iCache |= (*m_dec->aac_BitStreamInfo.bytePtr++) <<  8;
+        m_dec->aac_BitStreamInfo.iCache |= (*m_dec->aac_BitStreamInfo.bytePtr++);
 
-        m_aac_BitStreamInfo.cachedBits = 32;
-        m_aac_BitStreamInfo.nBytes -= 4;
+        m_dec->aac_BitStreamInfo.cachedBits = 32;
+        m_dec->aac_BitStreamInfo.nBytes -= 4;
     } else {
-        m_aac_BitStreamInfo.iCache = 0;
+        m_dec->aac_BitStreamInfo.iCache = 0;
         while (nBytes--) {
-            m_aac_BitStreamInfo.iCache |= (*m_aac_BitStreamInfo.bytePtr++);
-            m_aac_BitStreamInfo.iCache <<= 8;
+            m_dec->aac_BitStreamInfo.iCache |= (*m_dec->aac_BitStreamInfo.bytePtr++);
+            m_dec->aac_BitStreamInfo.iCache <<= 8;
         }
-        m_aac_BitStreamInfo.iCache <<= ((3 - m_aac_BitStreamInfo.nBytes)*8);
-        m_aac_BitStreamInfo.cachedBits = 8*m_aac_BitStreamInfo.nBytes;
-        m_aac_BitStreamInfo.nBytes = 0;
+        m_dec->aac_BitStreamInfo.iCache <<= ((3 - m_dec->aac_BitStreamInfo.nBytes)*8);
+        m_dec->aac_BitStreamInfo.cachedBits = 8*m_dec->aac_BitStreamInfo.nBytes;
+        m_dec->aac_BitStreamInfo.nBytes = 0;
     }
 }
 
@@ -6307,19 +7212,19 @@ unsigned int GetBits(int nBits)
     uint32_t data, lowBits;
 
     nBits &= 0x1f;                          /* nBits mod 32 to avoid unpredictable results like >> by negative amount */
-    data = m_aac_BitStreamInfo.iCache >> (31 - nBits);        /* unsigned >> so zero-extend */
+    data = m_dec->aac_BitStreamInfo.iCache >> (31 - nBits);        /* unsigned >> so zero-extend */
     data >>= 1;                                         /* do as >> 31, >> 1 so that nBits = 0 works okay (returns 0) */
-    m_aac_BitStreamInfo.iCache <<= nBits;                    /* left-justify cache */
-    m_aac_BitStreamInfo.cachedBits -= nBits;                 /* how many bits have we drawn from the cache so far */
+    m_dec->aac_BitStreamInfo.iCache <<= nBits;                    /* left-justify cache */
+    m_dec->aac_BitStreamInfo.cachedBits -= nBits;                 /* how many bits have we drawn from the cache so far */
 
     /* if we cross an int boundary, refill the cache */
-    if (m_aac_BitStreamInfo.cachedBits < 0) {
-        lowBits = -m_aac_BitStreamInfo.cachedBits;
+    if (m_dec->aac_BitStreamInfo.cachedBits < 0) {
+        lowBits = -m_dec->aac_BitStreamInfo.cachedBits;
         RefillBitstreamCache();
-        data |= m_aac_BitStreamInfo.iCache >> (32 - lowBits);        /* get the low-order bits */
+        data |= m_dec->aac_BitStreamInfo.iCache >> (32 - lowBits);        /* get the low-order bits */
 
-        m_aac_BitStreamInfo.cachedBits -= lowBits;            /* how many bits have we drawn from the cache so far */
-        m_aac_BitStreamInfo.iCache <<= lowBits;            /* left-justify cache */
+        m_dec->aac_BitStreamInfo.cachedBits -= lowBits;            /* how many bits have we drawn from the cache so far */
+        m_dec->aac_BitStreamInfo.iCache <<= lowBits;            /* left-justify cache */
     }
 
     return data;
@@ -6348,17 +7253,17 @@ unsigned int GetBitsNoAdvance(int nBits)
     int32_t lowBits;
 
     nBits &= 0x1f;                          /* nBits mod 32 to avoid unpredictable results like >> by negative amount */
-    data = m_aac_BitStreamInfo.iCache >> (31 - nBits);        /* unsigned >> so zero-extend */
+    data = m_dec->aac_BitStreamInfo.iCache >> (31 - nBits);        /* unsigned >> so zero-extend */
     data >>= 1;                                         /* do as >> 31, >> 1 so that nBits = 0 works okay (returns 0) */
-    lowBits = nBits - m_aac_BitStreamInfo.cachedBits;        /* how many bits do we have left to read */
+    lowBits = nBits - m_dec->aac_BitStreamInfo.cachedBits;        /* how many bits do we have left to read */
 
     /* if we cross an int boundary, read next bytes in buffer */
     if (lowBits > 0) {
         iCache = 0;
-        buf = m_aac_BitStreamInfo.bytePtr;
+        buf = m_dec->aac_BitStreamInfo.bytePtr;
         while (lowBits > 0) {
             iCache <<= 8;
-            if (buf < m_aac_BitStreamInfo.bytePtr + m_aac_BitStreamInfo.nBytes)
+            if (buf < m_dec->aac_BitStreamInfo.bytePtr + m_dec->aac_BitStreamInfo.nBytes)
                 iCache |= (uint32_t)*buf++;
             lowBits -= 8;
         }
@@ -6385,12 +7290,12 @@ unsigned int GetBitsNoAdvance(int nBits)
 void AdvanceBitstream(int nBits)
 {
     nBits &= 0x1f;
-    if (nBits > m_aac_BitStreamInfo.cachedBits) {
-        nBits -= m_aac_BitStreamInfo.cachedBits;
+    if (nBits > m_dec->aac_BitStreamInfo.cachedBits) {
+        nBits -= m_dec->aac_BitStreamInfo.cachedBits;
         RefillBitstreamCache();
     }
-    m_aac_BitStreamInfo.iCache <<= nBits;
-    m_aac_BitStreamInfo.cachedBits -= nBits;
+    m_dec->aac_BitStreamInfo.iCache <<= nBits;
+    m_dec->aac_BitStreamInfo.cachedBits -= nBits;
 }
 
 /***********************************************************************************************************************
@@ -6409,8 +7314,8 @@ int CalcBitsUsed(uint8_t *startBuf, int startOffset) {
 
     int bitsUsed;
 
-    bitsUsed  = (m_aac_BitStreamInfo.bytePtr - startBuf) * 8;
-    bitsUsed -= m_aac_BitStreamInfo.cachedBits;
+    bitsUsed  = (m_dec->aac_BitStreamInfo.bytePtr - startBuf) * 8;
+    bitsUsed -= m_dec->aac_BitStreamInfo.cachedBits;
     bitsUsed -= startOffset;
 
     return bitsUsed;
@@ -6432,12 +7337,42 @@ void ByteAlignBitstream(){
 
     int offset;
 
-    offset = m_aac_BitStreamInfo.cachedBits & 0x07;
+    offset = m_dec->aac_BitStreamInfo.cachedBits & 0x07;
     AdvanceBitstream(offset);
 }
 
+/**************************************************************************************
+ * Function:    AACSBRActive
+ *
+ * Description: SBR is signalled in the stream and not bypassed by AACSetQuality()
+ **************************************************************************************/
+bool AACSBRActive(AACDecoder_t *dec) {
 #ifdef AAC_ENABLE_SBR
+    return dec->AACDecInfo->sbrEnabled && dec->quality == AAC_QUALITY_FULL;
+#else
+    return false;
+#endif
+}
 
+/**************************************************************************************
+ * Function:    AACOutChannels
+ *
+ * Description: channels of the PCM output
+ *
+ * Notes:       a mono stream with SBR is output in stereo from the frame with the first
+ *                PS header on, the caller has to follow the change (AACGetChannels()).
+ *                Afterwards independent of AACSetQuality() and AACSetParametricStereo(),
+ *                the output stays stereo until the decoder is cleared
+ **************************************************************************************/
+int AACOutChannels(AACDecoder_t *dec) {
+#ifdef AAC_ENABLE_PS
+    if (dec->AACDecInfo->nChans == 1 && dec->AACDecInfo->sbrEnabled && dec->PSInfoPS->stereo)
+        return 2;
+#endif
+    return dec->AACDecInfo->nChans;
+}
+
+#ifdef AAC_ENABLE_SBR
 /**************************************************************************************
  * Function:    InitSBRState
  *
@@ -6454,18 +7389,18 @@ void InitSBRState() {
     int i, ch;
     uint8_t *c;
 
-    if (!m_PSInfoSBR)
+    if (!m_dec->PSInfoSBR)
         return;
 
     /* clear SBR state structure */
-    c = (uint8_t *)m_PSInfoSBR;
-    for (i = 0; i < (int)sizeof(m_PSInfoSBR); i++)
+    c = (uint8_t *)m_dec->PSInfoSBR;
+    for (i = 0; i < (int)sizeof(m_dec->PSInfoSBR); i++)
         *c++ = 0;
 
     /* initialize non-zero state variables */
     for (ch = 0; ch < AAC_MAX_NCHANS; ch++) {
-        m_PSInfoSBR->sbrChan[ch].reset = 1;
-        m_PSInfoSBR->sbrChan[ch].laPrev = -1;
+        m_dec->PSInfoSBR->sbrChan[ch].reset = 1;
+        m_dec->PSInfoSBR->sbrChan[ch].laPrev = -1;
     }
 }
 #endif
@@ -6489,43 +7424,43 @@ int DecodeSBRBitstream(int chBase) {
 
     int headerFlag;
 
-    if(m_AACDecInfo->currBlockID != AAC_ID_FIL
-            || (m_AACDecInfo->fillExtType != EXT_SBR_DATA && m_AACDecInfo->fillExtType != EXT_SBR_DATA_CRC))
+    if(m_dec->AACDecInfo->currBlockID != AAC_ID_FIL
+            || (m_dec->AACDecInfo->fillExtType != EXT_SBR_DATA && m_dec->AACDecInfo->fillExtType != EXT_SBR_DATA_CRC))
         return ERR_AAC_NONE;
 
-    SetBitstreamPointer(m_AACDecInfo->fillCount, m_AACDecInfo->fillBuf);
-    if(GetBits(4) != (unsigned int) m_AACDecInfo->fillExtType) return ERR_AAC_SBR_BITSTREAM;
+    SetBitstreamPointer(m_dec->AACDecInfo->fillCount, m_dec->AACDecInfo->fillBuf);
+    if(GetBits(4) != (unsigned int) m_dec->AACDecInfo->fillExtType) return ERR_AAC_SBR_BITSTREAM;
 
-    if(m_AACDecInfo->fillExtType == EXT_SBR_DATA_CRC) m_PSInfoSBR->crcCheckWord = GetBits(10);
+    if(m_dec->AACDecInfo->fillExtType == EXT_SBR_DATA_CRC) m_dec->PSInfoSBR->crcCheckWord = GetBits(10);
 
     headerFlag = GetBits(1);
     if(headerFlag) {
         /* get sample rate index for output sample rate (2x base rate) */
-        m_PSInfoSBR->sampRateIdx = GetSampRateIdx(2 * m_AACDecInfo->sampRate);
-        if(m_PSInfoSBR->sampRateIdx < 0 || m_PSInfoSBR->sampRateIdx >= NUM_SAMPLE_RATES)
+        m_dec->PSInfoSBR->sampRateIdx = GetSampRateIdx(2 * m_dec->AACDecInfo->sampRate);
+        if(m_dec->PSInfoSBR->sampRateIdx < 0 || m_dec->PSInfoSBR->sampRateIdx >= NUM_SAMPLE_RATES)
             return ERR_AAC_SBR_BITSTREAM;
-        else if(m_PSInfoSBR->sampRateIdx >= NUM_SAMPLE_RATES_SBR) return ERR_AAC_SBR_SINGLERATE_UNSUPPORTED;
+        else if(m_dec->PSInfoSBR->sampRateIdx >= NUM_SAMPLE_RATES_SBR) return ERR_AAC_SBR_SINGLERATE_UNSUPPORTED;
 
         /* reset flag = 1 if header values changed */
-        if(UnpackSBRHeader(&(m_PSInfoSBR->sbrHdr[chBase]))) m_PSInfoSBR->sbrChan[chBase].reset = 1;
+        if(UnpackSBRHeader(&(m_dec->PSInfoSBR->sbrHdr[chBase]))) m_dec->PSInfoSBR->sbrChan[chBase].reset = 1;
 
         /* first valid SBR header should always trigger CalcFreqTables(), since psi->reset was set in InitSBR() */
-        if(m_PSInfoSBR->sbrChan[chBase].reset)
-            CalcFreqTables(&(m_PSInfoSBR->sbrHdr[chBase + 0]), &(m_PSInfoSBR->sbrFreq[chBase]),
-                    m_PSInfoSBR->sampRateIdx);
+        if(m_dec->PSInfoSBR->sbrChan[chBase].reset)
+            CalcFreqTables(&(m_dec->PSInfoSBR->sbrHdr[chBase + 0]), &(m_dec->PSInfoSBR->sbrFreq[chBase]),
+                    m_dec->PSInfoSBR->sampRateIdx);
 
         /* copy and reset state to right channel for CPE */
-        if(m_AACDecInfo->prevBlockID == AAC_ID_CPE)
-            m_PSInfoSBR->sbrChan[chBase + 1].reset = m_PSInfoSBR->sbrChan[chBase + 0].reset;
+        if(m_dec->AACDecInfo->prevBlockID == AAC_ID_CPE)
+            m_dec->PSInfoSBR->sbrChan[chBase + 1].reset = m_dec->PSInfoSBR->sbrChan[chBase + 0].reset;
     }
 
     /* if no header has been received, upsample only */
-    if(m_PSInfoSBR->sbrHdr[chBase].count == 0) return ERR_AAC_NONE;
+    if(m_dec->PSInfoSBR->sbrHdr[chBase].count == 0) return ERR_AAC_NONE;
 
-    if(m_AACDecInfo->prevBlockID == AAC_ID_SCE) {
+    if(m_dec->AACDecInfo->prevBlockID == AAC_ID_SCE) {
         UnpackSBRSingleChannel(chBase);
     }
-    else if(m_AACDecInfo->prevBlockID == AAC_ID_CPE) {
+    else if(m_dec->AACDecInfo->prevBlockID == AAC_ID_CPE) {
         UnpackSBRChannelPair(chBase);
     }
     else {
@@ -6565,26 +7500,29 @@ int DecodeSBRData(int chBase, short *outbuf) {
     SBRGrid *sbrGrid;
     SBRFreq *sbrFreq;
     SBRChan *sbrChan;
+#ifdef AAC_PROFILE
+    uint32_t t0, t1;
+#endif
 
     /* same header and freq tables for both channels in CPE */
-    sbrHdr = &(m_PSInfoSBR->sbrHdr[chBase]);
-    sbrFreq = &(m_PSInfoSBR->sbrFreq[chBase]);
+    sbrHdr = &(m_dec->PSInfoSBR->sbrHdr[chBase]);
+    sbrFreq = &(m_dec->PSInfoSBR->sbrFreq[chBase]);
 
     /* upsample only if we haven't received an SBR header yet or if we have an LFE block */
-    if(m_AACDecInfo->currBlockID == AAC_ID_LFE) {
+    if(m_dec->AACDecInfo->currBlockID == AAC_ID_LFE) {
         chBlock = 1;
         upsampleOnly = 1;
     }
-    else if(m_AACDecInfo->currBlockID == AAC_ID_FIL) {
-        if(m_AACDecInfo->prevBlockID == AAC_ID_SCE)
+    else if(m_dec->AACDecInfo->currBlockID == AAC_ID_FIL) {
+        if(m_dec->AACDecInfo->prevBlockID == AAC_ID_SCE)
             chBlock = 1;
-        else if(m_AACDecInfo->prevBlockID == AAC_ID_CPE)
+        else if(m_dec->AACDecInfo->prevBlockID == AAC_ID_CPE)
             chBlock = 2;
         else
             return ERR_AAC_NONE;
 
         upsampleOnly = (sbrHdr->count == 0 ? 1 : 0);
-        if(m_AACDecInfo->fillExtType != EXT_SBR_DATA && m_AACDecInfo->fillExtType != EXT_SBR_DATA_CRC)
+        if(m_dec->AACDecInfo->fillExtType != EXT_SBR_DATA && m_dec->AACDecInfo->fillExtType != EXT_SBR_DATA_CRC)
             return ERR_AAC_NONE;
     }
     else {
@@ -6598,40 +7536,53 @@ int DecodeSBRData(int chBase, short *outbuf) {
     }
 
     for(ch = 0; ch < chBlock; ch++) {
-        sbrGrid = &(m_PSInfoSBR->sbrGrid[chBase + ch]);
-        sbrChan = &(m_PSInfoSBR->sbrChan[chBase + ch]);
+        sbrGrid = &(m_dec->PSInfoSBR->sbrGrid[chBase + ch]);
+        sbrChan = &(m_dec->PSInfoSBR->sbrChan[chBase + ch]);
 
-        if(m_AACDecInfo->rawSampleBuf[ch] == 0 || m_AACDecInfo->rawSampleBytes != 4) return ERR_AAC_SBR_PCM_FORMAT;
-        inbuf = (int*) m_AACDecInfo->rawSampleBuf[ch];
+        if(m_dec->AACDecInfo->rawSampleBuf[ch] == 0 || m_dec->AACDecInfo->rawSampleBytes != 4) return ERR_AAC_SBR_PCM_FORMAT;
+        inbuf = (int*) m_dec->AACDecInfo->rawSampleBuf[ch];
         outptr = outbuf + chBase + ch;
 
         /* restore delay buffers (could use ring buffer or keep in temp buffer for nChans == 1) */
         for(l = 0; l < HF_GEN; l++) {
             for(k = 0; k < 64; k++) {
-                m_PSInfoSBR->XBuf[l][k][0] = m_PSInfoSBR->XBufDelay[chBase + ch][l][k][0];
-                m_PSInfoSBR->XBuf[l][k][1] = m_PSInfoSBR->XBufDelay[chBase + ch][l][k][1];
+                m_dec->PSInfoSBRQMF->XBuf[l][k][0] = m_dec->PSInfoSBR->XBufDelay[chBase + ch][l][k][0];
+                m_dec->PSInfoSBRQMF->XBuf[l][k][1] = m_dec->PSInfoSBR->XBufDelay[chBase + ch][l][k][1];
             }
         }
 
         /* step 1 - analysis QMF */
+#ifdef AAC_PROFILE
+        t0 = ESP.getCycleCount();
+#endif
         qmfaBands = sbrFreq->kStart;
         for(l = 0; l < 32; l++) {
-            gbMask = QMFAnalysis(inbuf + l * 32, m_PSInfoSBR->delayQMFA[chBase + ch], m_PSInfoSBR->XBuf[l + HF_GEN][0],
-                    m_AACDecInfo->rawSampleFBits, &(m_PSInfoSBR->delayIdxQMFA[chBase + ch]), qmfaBands);
+            gbMask = QMFAnalysis(inbuf + l * 32, m_dec->PSInfoSBRQMF->delayQMFA[chBase + ch], m_dec->PSInfoSBRQMF->XBuf[l + HF_GEN][0],
+                    m_dec->AACDecInfo->rawSampleFBits, &(m_dec->PSInfoSBR->delayIdxQMFA[chBase + ch]), qmfaBands);
 
             gbIdx = ((l + HF_GEN) >> 5) & 0x01;
             sbrChan->gbMask[gbIdx] |= gbMask; /* gbIdx = (0 if i < 32), (1 if i >= 32) */
         }
+#ifdef AAC_PROFILE
+        t1 = ESP.getCycleCount();
+        m_dec->profQMFA += t1 - t0;
+#endif
 
         if(upsampleOnly) {
             /* no SBR - just run synthesis QMF to upsample by 2x */
+#ifdef AAC_PROFILE
+            t0 = t1;
+#endif
             qmfsBands = 32;
             for(l = 0; l < 32; l++) {
                 /* step 4 - synthesis QMF */
-                QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
-                        &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
-                outptr += 64 * m_AACDecInfo->nChans;
+                QMFSynthesis(m_dec->PSInfoSBRQMF->XBuf[l + HF_ADJ][0], m_dec->PSInfoSBRQMF->delayQMFS[chBase + ch],
+                        &(m_dec->PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_dec->AACDecInfo->nChans);
+                outptr += 64 * m_dec->AACDecInfo->nChans;
             }
+#ifdef AAC_PROFILE
+            m_dec->profQMFS += ESP.getCycleCount() - t0;
+#endif
         }
         else {
             /* if previous frame had lower SBR starting freq than current, zero out the synthesized QMF
@@ -6641,8 +7592,8 @@ int DecodeSBRData(int chBase, short *outbuf) {
              */
             for(k = sbrFreq->kStartPrev; k < sbrFreq->kStart; k++) {
                 for(l = 0; l < sbrGrid->envTimeBorder[0] + HF_ADJ; l++) {
-                    m_PSInfoSBR->XBuf[l][k][0] = 0;
-                    m_PSInfoSBR->XBuf[l][k][1] = 0;
+                    m_dec->PSInfoSBRQMF->XBuf[l][k][0] = 0;
+                    m_dec->PSInfoSBRQMF->XBuf[l][k][1] = 0;
                 }
             }
 
@@ -6652,37 +7603,53 @@ int DecodeSBRData(int chBase, short *outbuf) {
             /* restore SBR bands that were cleared before patch generation (time slots 0, 1 no longer needed) */
             for(k = sbrFreq->kStartPrev; k < sbrFreq->kStart; k++) {
                 for(l = HF_ADJ; l < sbrGrid->envTimeBorder[0] + HF_ADJ; l++) {
-                    m_PSInfoSBR->XBuf[l][k][0] = m_PSInfoSBR->XBufDelay[chBase + ch][l][k][0];
-                    m_PSInfoSBR->XBuf[l][k][1] = m_PSInfoSBR->XBufDelay[chBase + ch][l][k][1];
+                    m_dec->PSInfoSBRQMF->XBuf[l][k][0] = m_dec->PSInfoSBR->XBufDelay[chBase + ch][l][k][0];
+                    m_dec->PSInfoSBRQMF->XBuf[l][k][1] = m_dec->PSInfoSBR->XBufDelay[chBase + ch][l][k][1];
                 }
             }
 
             /* step 3 - HF adjustment */
             AdjustHighFreq(sbrHdr, sbrGrid, sbrFreq, sbrChan, ch);
 
+#ifdef AAC_PROFILE
+            t0 = ESP.getCycleCount();
+            m_dec->profHF += t0 - t1;
+#endif
             /* step 4 - synthesis QMF */
             qmfsBands = sbrFreq->kStartPrev + sbrFreq->numQMFBandsPrev;
-            for(l = 0; l < sbrGrid->envTimeBorder[0]; l++) {
+            l = 0;
+#ifdef AAC_ENABLE_PS
+            if(chBlock == 1 && m_dec->AACDecInfo->nChans == 1 && m_dec->PSInfoPS->start && !m_dec->psOff
+                    && !m_dec->downmix) {
+                /* parametric stereo, both output channels are synthesized from this one */
+                ApplyPS(sbrGrid, sbrFreq, outbuf);
+                l = 32;
+            }
+#endif
+            for(; l < sbrGrid->envTimeBorder[0]; l++) {
                 /* if new envelope starts mid-frame, use old settings until start of first envelope in this frame */
-                QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
-                        &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
-                outptr += 64 * m_AACDecInfo->nChans;
+                QMFSynthesis(m_dec->PSInfoSBRQMF->XBuf[l + HF_ADJ][0], m_dec->PSInfoSBRQMF->delayQMFS[chBase + ch],
+                        &(m_dec->PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_dec->AACDecInfo->nChans);
+                outptr += 64 * m_dec->AACDecInfo->nChans;
             }
 
             qmfsBands = sbrFreq->kStart + sbrFreq->numQMFBands;
             for(; l < 32; l++) {
                 /* use new settings for rest of frame (usually the entire frame, unless the first envelope starts mid-frame) */
-                QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
-                        &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
-                outptr += 64 * m_AACDecInfo->nChans;
+                QMFSynthesis(m_dec->PSInfoSBRQMF->XBuf[l + HF_ADJ][0], m_dec->PSInfoSBRQMF->delayQMFS[chBase + ch],
+                        &(m_dec->PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_dec->AACDecInfo->nChans);
+                outptr += 64 * m_dec->AACDecInfo->nChans;
             }
+#ifdef AAC_PROFILE
+            m_dec->profQMFS += ESP.getCycleCount() - t0;
+#endif
         }
 
         /* save delay */
         for(l = 0; l < HF_GEN; l++) {
             for(k = 0; k < 64; k++) {
-                m_PSInfoSBR->XBufDelay[chBase + ch][l][k][0] = m_PSInfoSBR->XBuf[l + 32][k][0];
-                m_PSInfoSBR->XBufDelay[chBase + ch][l][k][1] = m_PSInfoSBR->XBuf[l + 32][k][1];
+                m_dec->PSInfoSBR->XBufDelay[chBase + ch][l][k][0] = m_dec->PSInfoSBRQMF->XBuf[l + 32][k][0];
+                m_dec->PSInfoSBR->XBufDelay[chBase + ch][l][k][1] = m_dec->PSInfoSBRQMF->XBuf[l + 32][k][1];
             }
         }
         sbrChan->gbMask[0] = sbrChan->gbMask[1];
@@ -6693,7 +7660,7 @@ int DecodeSBRData(int chBase, short *outbuf) {
     sbrFreq->kStartPrev = sbrFreq->kStart;
     sbrFreq->numQMFBandsPrev = sbrFreq->numQMFBands;
 
-    if(m_AACDecInfo->nChans > 0 && (chBase + ch) == m_AACDecInfo->nChans) m_PSInfoSBR->frameCount++;
+    if(m_dec->AACDecInfo->nChans > 0 && (chBase + ch) == m_dec->AACDecInfo->nChans) m_dec->PSInfoSBR->frameCount++;
 
     return ERR_AAC_NONE;
 }
@@ -7319,7 +8286,7 @@ void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int
     if(sbrHdr->interpFreq) {
         for(m = 0; m < sbrFreq->numQMFBands; m++) {
             eCurr.w64 = 0;
-            XBuf = m_PSInfoSBR->XBuf[iStart][sbrFreq->kStart + m];
+            XBuf = m_dec->PSInfoSBRQMF->XBuf[iStart][sbrFreq->kStart + m];
             for(i = iStart; i < iEnd; i++) {
                 /* scale to int before calculating power (precision not critical, and avoids overflow) */
                 xre = (*XBuf) >> FBITS_OUT_QMFA;
@@ -7348,9 +8315,9 @@ void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int
             }
 
             invFact = invBandTab[(iEnd - iStart) - 1];
-            m_PSInfoSBR->eCurr[m] = MULSHIFT32(t, invFact);
-            m_PSInfoSBR->eCurrExp[m] = nScale + 1; /* +1 for invFact = Q31 */
-            if(m_PSInfoSBR->eCurrExp[m] > expMax) expMax = m_PSInfoSBR->eCurrExp[m];
+            m_dec->PSInfoSBR->eCurr[m] = MULSHIFT32(t, invFact);
+            m_dec->PSInfoSBR->eCurrExp[m] = nScale + 1; /* +1 for invFact = Q31 */
+            if(m_dec->PSInfoSBR->eCurrExp[m] > expMax) expMax = m_dec->PSInfoSBR->eCurrExp[m];
         }
     }
     else {
@@ -7359,7 +8326,7 @@ void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int
             mEnd = freqBandTab[p + 1];
             eCurr.w64 = 0;
             for(i = iStart; i < iEnd; i++) {
-                XBuf = m_PSInfoSBR->XBuf[i][mStart];
+                XBuf = m_dec->PSInfoSBRQMF->XBuf[i][mStart];
                 for(m = mStart; m < mEnd; m++) {
                     xre = (*XBuf++) >> FBITS_OUT_QMFA;
                     xim = (*XBuf++) >> FBITS_OUT_QMFA;
@@ -7387,14 +8354,14 @@ void EstimateEnvelope(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int
             t = MULSHIFT32(t, invFact);
 
             for(m = mStart; m < mEnd; m++) {
-                m_PSInfoSBR->eCurr[m - sbrFreq->kStart] = t;
-                m_PSInfoSBR->eCurrExp[m - sbrFreq->kStart] = nScale + 1; /* +1 for invFact = Q31 */
+                m_dec->PSInfoSBR->eCurr[m - sbrFreq->kStart] = t;
+                m_dec->PSInfoSBR->eCurrExp[m - sbrFreq->kStart] = nScale + 1; /* +1 for invFact = Q31 */
             }
-            if(m_PSInfoSBR->eCurrExp[mStart - sbrFreq->kStart] > expMax)
-                expMax = m_PSInfoSBR->eCurrExp[mStart - sbrFreq->kStart];
+            if(m_dec->PSInfoSBR->eCurrExp[mStart - sbrFreq->kStart] > expMax)
+                expMax = m_dec->PSInfoSBR->eCurrExp[mStart - sbrFreq->kStart];
         }
     }
-    m_PSInfoSBR->eCurrExpMax = expMax;
+    m_dec->PSInfoSBR->eCurrExpMax = expMax;
 }
 /***********************************************************************************************************************
  * Function:    GetSMapped
@@ -7476,28 +8443,28 @@ void CalcMaxGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int ch,
     /* calculate max gain to apply to signal in this limiter band */
     sumECurr = 0;
     sumEOrigMapped = 0;
-    eCurrExpMax = m_PSInfoSBR->eCurrExpMax;
-    eOMGainMax = m_PSInfoSBR->eOMGainMax;
-    envBand = m_PSInfoSBR->envBand;
+    eCurrExpMax = m_dec->PSInfoSBR->eCurrExpMax;
+    eOMGainMax = m_dec->PSInfoSBR->eOMGainMax;
+    envBand = m_dec->PSInfoSBR->envBand;
     for(m = mStart; m < mEnd; m++) {
         /* map current QMF band to appropriate envelope band */
         if(m == freqBandTab[envBand + 1] - sbrFreq->kStart) {
             envBand++;
-            eOMGainMax = m_PSInfoSBR->envDataDequant[ch][env][envBand] >> ACC_SCALE; /* summing max 48 bands */
+            eOMGainMax = m_dec->PSInfoSBR->envDataDequant[ch][env][envBand] >> ACC_SCALE; /* summing max 48 bands */
         }
         sumEOrigMapped += eOMGainMax;
 
         /* easy test for overflow on ARM */
-        sumECurr += (m_PSInfoSBR->eCurr[m] >> (eCurrExpMax - m_PSInfoSBR->eCurrExp[m]));
+        sumECurr += (m_dec->PSInfoSBR->eCurr[m] >> (eCurrExpMax - m_dec->PSInfoSBR->eCurrExp[m]));
         if(sumECurr >> 30) {
             sumECurr >>= 1;
             eCurrExpMax++;
         }
     }
-    m_PSInfoSBR->eOMGainMax = eOMGainMax;
-    m_PSInfoSBR->envBand = envBand;
+    m_dec->PSInfoSBR->eOMGainMax = eOMGainMax;
+    m_dec->PSInfoSBR->envBand = envBand;
 
-    m_PSInfoSBR->gainMaxFBits = 30; /* Q30 tables */
+    m_dec->PSInfoSBR->gainMaxFBits = 30; /* Q30 tables */
     if(sumECurr == 0) {
         /* any non-zero numerator * 1/EPS_0 is > G_MAX */
         gainMax = (sumEOrigMapped == 0 ? (int) limGainTab[sbrHdr->limiterGains] : (int) 0x80000000);
@@ -7514,11 +8481,11 @@ void CalcMaxGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, int ch,
             z = CLZ(sumECurr) - 1;
             r = InvRNormalized(sumECurr << z); /* in =  Q(z - eCurrExpMax), out = Q(29 + 31 - z + eCurrExpMax) */
             gainMax = MULSHIFT32(q, r); /* Q(29 + 31 - z + eCurrExpMax + fbitsDQ - ACC_SCALE - 2 - 32) */
-            m_PSInfoSBR->gainMaxFBits = 26 - z + eCurrExpMax + fbitsDQ - ACC_SCALE;
+            m_dec->PSInfoSBR->gainMaxFBits = 26 - z + eCurrExpMax + fbitsDQ - ACC_SCALE;
         }
     }
-    m_PSInfoSBR->sumEOrigMapped = sumEOrigMapped;
-    m_PSInfoSBR->gainMax = gainMax;
+    m_dec->PSInfoSBR->sumEOrigMapped = sumEOrigMapped;
+    m_dec->PSInfoSBR->gainMax = gainMax;
 }
 /***********************************************************************************************************************
  * Function:    CalcNoiseDivFactors
@@ -7579,40 +8546,40 @@ void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, in
     mStart = sbrFreq->freqLimiter[lim]; /* these are offsets from kStart */
     mEnd = sbrFreq->freqLimiter[lim + 1];
 
-    gainMax = m_PSInfoSBR->gainMax;
-    gainMaxFBits = m_PSInfoSBR->gainMaxFBits;
+    gainMax = m_dec->PSInfoSBR->gainMax;
+    gainMaxFBits = m_dec->PSInfoSBR->gainMaxFBits;
 
-    d = (env == m_PSInfoSBR->la || env == sbrChan->laPrev ? 0 : 1);
+    d = (env == m_dec->PSInfoSBR->la || env == sbrChan->laPrev ? 0 : 1);
     freqBandTab = (sbrGrid->freqRes[env] ? sbrFreq->freqHigh : sbrFreq->freqLow);
 
     /* figure out which noise floor this envelope is in (only 1 or 2 noise floors allowed) */
     noiseFloor = 0;
     if(sbrGrid->numNoiseFloors == 2 && sbrGrid->noiseTimeBorder[1] <= sbrGrid->envTimeBorder[env]) noiseFloor++;
 
-    m_PSInfoSBR->sumECurrGLim = 0;
-    m_PSInfoSBR->sumSM = 0;
-    m_PSInfoSBR->sumQM = 0;
+    m_dec->PSInfoSBR->sumECurrGLim = 0;
+    m_dec->PSInfoSBR->sumSM = 0;
+    m_dec->PSInfoSBR->sumQM = 0;
     /* calculate energy of noise to add in this limiter band */
     for(m = mStart; m < mEnd; m++) {
-        if(m == sbrFreq->freqNoise[m_PSInfoSBR->noiseFloorBand + 1] - sbrFreq->kStart) {
+        if(m == sbrFreq->freqNoise[m_dec->PSInfoSBR->noiseFloorBand + 1] - sbrFreq->kStart) {
             /* map current QMF band to appropriate noise floor band (NOTE: freqLimiter[0] == freqLow[0] = freqHigh[0]) */
-            m_PSInfoSBR->noiseFloorBand++;
-            CalcNoiseDivFactors(m_PSInfoSBR->noiseDataDequant[ch][noiseFloor][m_PSInfoSBR->noiseFloorBand],
-                    &(m_PSInfoSBR->qp1Inv), &(m_PSInfoSBR->qqp1Inv));
+            m_dec->PSInfoSBR->noiseFloorBand++;
+            CalcNoiseDivFactors(m_dec->PSInfoSBR->noiseDataDequant[ch][noiseFloor][m_dec->PSInfoSBR->noiseFloorBand],
+                    &(m_dec->PSInfoSBR->qp1Inv), &(m_dec->PSInfoSBR->qqp1Inv));
         }
-        if(m == sbrFreq->freqHigh[m_PSInfoSBR->highBand + 1] - sbrFreq->kStart) m_PSInfoSBR->highBand++;
-        if(m == freqBandTab[m_PSInfoSBR->sBand + 1] - sbrFreq->kStart) {
-            m_PSInfoSBR->sBand++;
-            m_PSInfoSBR->sMapped = GetSMapped(sbrGrid, sbrFreq, sbrChan, env, m_PSInfoSBR->sBand, m_PSInfoSBR->la);
+        if(m == sbrFreq->freqHigh[m_dec->PSInfoSBR->highBand + 1] - sbrFreq->kStart) m_dec->PSInfoSBR->highBand++;
+        if(m == freqBandTab[m_dec->PSInfoSBR->sBand + 1] - sbrFreq->kStart) {
+            m_dec->PSInfoSBR->sBand++;
+            m_dec->PSInfoSBR->sMapped = GetSMapped(sbrGrid, sbrFreq, sbrChan, env, m_dec->PSInfoSBR->sBand, m_dec->PSInfoSBR->la);
         }
 
         /* get sIndexMapped for this QMF subband */
         sIndexMapped = 0;
-        r = ((sbrFreq->freqHigh[m_PSInfoSBR->highBand + 1] + sbrFreq->freqHigh[m_PSInfoSBR->highBand]) >> 1);
+        r = ((sbrFreq->freqHigh[m_dec->PSInfoSBR->highBand + 1] + sbrFreq->freqHigh[m_dec->PSInfoSBR->highBand]) >> 1);
         if(m + sbrFreq->kStart == r) {
             /* r = center frequency, deltaStep = (env >= la || sIndexMapped'(r, numEnv'-1) == 1) */
-            if(env >= m_PSInfoSBR->la || sbrChan->addHarmonic[0][r] == 1) sIndexMapped =
-                    sbrChan->addHarmonic[1][m_PSInfoSBR->highBand];
+            if(env >= m_dec->PSInfoSBR->la || sbrChan->addHarmonic[0][r] == 1) sIndexMapped =
+                    sbrChan->addHarmonic[1][m_dec->PSInfoSBR->highBand];
         }
 
         /* save sine flags from last envelope in this frame:
@@ -7623,27 +8590,27 @@ void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, in
          */
         if(env == sbrGrid->numEnv - 1) {
             if(m + sbrFreq->kStart == r)
-                sbrChan->addHarmonic[0][m + sbrFreq->kStart] = sbrChan->addHarmonic[1][m_PSInfoSBR->highBand];
+                sbrChan->addHarmonic[0][m + sbrFreq->kStart] = sbrChan->addHarmonic[1][m_dec->PSInfoSBR->highBand];
             else
                 sbrChan->addHarmonic[0][m + sbrFreq->kStart] = 0;
         }
 
-        gain = m_PSInfoSBR->envDataDequant[ch][env][m_PSInfoSBR->sBand];
-        qm = MULSHIFT32(gain, m_PSInfoSBR->qqp1Inv) << 1;
-        sm = (sIndexMapped ? MULSHIFT32(gain, m_PSInfoSBR->qp1Inv) << 1 : 0);
+        gain = m_dec->PSInfoSBR->envDataDequant[ch][env][m_dec->PSInfoSBR->sBand];
+        qm = MULSHIFT32(gain, m_dec->PSInfoSBR->qqp1Inv) << 1;
+        sm = (sIndexMapped ? MULSHIFT32(gain, m_dec->PSInfoSBR->qp1Inv) << 1 : 0);
 
         /* three cases: (sMapped == 0 && delta == 1), (sMapped == 0 && delta == 0), (sMapped == 1) */
-        if(d == 1 && m_PSInfoSBR->sMapped == 0)
-            gain = MULSHIFT32(m_PSInfoSBR->qp1Inv, gain) << 1;
-        else if(m_PSInfoSBR->sMapped != 0) gain = MULSHIFT32(m_PSInfoSBR->qqp1Inv, gain) << 1;
+        if(d == 1 && m_dec->PSInfoSBR->sMapped == 0)
+            gain = MULSHIFT32(m_dec->PSInfoSBR->qp1Inv, gain) << 1;
+        else if(m_dec->PSInfoSBR->sMapped != 0) gain = MULSHIFT32(m_dec->PSInfoSBR->qqp1Inv, gain) << 1;
 
         /* gain, qm, sm = Q(fbitsDQ), gainMax = Q(fbitsGainMax) */
-        eCurr = m_PSInfoSBR->eCurr[m];
+        eCurr = m_dec->PSInfoSBR->eCurr[m];
         if(eCurr) {
             z = CLZ(eCurr) - 1;
             r = InvRNormalized(eCurr << z); /* in = Q(z - eCurrExp), out = Q(29 + 31 - z + eCurrExp) */
             gainScale = MULSHIFT32(gain, r); /* out = Q(29 + 31 - z + eCurrExp + fbitsDQ - 32) */
-            fbitsGain = 29 + 31 - z + m_PSInfoSBR->eCurrExp[m] + fbitsDQ - 32;
+            fbitsGain = 29 + 31 - z + m_dec->PSInfoSBR->eCurrExp[m] + fbitsDQ - 32;
         }
         else {
             /* if eCurr == 0, then gain is unchanged (divide by EPS = 1) */
@@ -7687,25 +8654,25 @@ void CalcComponentGains(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, in
 
             qm = MULSHIFT32(qm, r) << 2;
             gain = MULSHIFT32(gain, r) << 2;
-            m_PSInfoSBR->gLimBuf[m] = gainMax;
-            m_PSInfoSBR->gLimFbits[m] = gainMaxFBits;
+            m_dec->PSInfoSBR->gLimBuf[m] = gainMax;
+            m_dec->PSInfoSBR->gLimFbits[m] = gainMaxFBits;
         }
         else {
-            m_PSInfoSBR->gLimBuf[m] = gainScale;
-            m_PSInfoSBR->gLimFbits[m] = fbitsGain;
+            m_dec->PSInfoSBR->gLimBuf[m] = gainScale;
+            m_dec->PSInfoSBR->gLimFbits[m] = fbitsGain;
         }
 
         /* sumSM, sumQM, sumECurrGLim = Q(fbitsDQ - ACC_SCALE) */
-        m_PSInfoSBR->smBuf[m] = sm;
-        m_PSInfoSBR->sumSM += (sm >> ACC_SCALE);
+        m_dec->PSInfoSBR->smBuf[m] = sm;
+        m_dec->PSInfoSBR->sumSM += (sm >> ACC_SCALE);
 
-        m_PSInfoSBR->qmLimBuf[m] = qm;
-        if(env != m_PSInfoSBR->la && env != sbrChan->laPrev && sm == 0) m_PSInfoSBR->sumQM += (qm >> ACC_SCALE);
+        m_dec->PSInfoSBR->qmLimBuf[m] = qm;
+        if(env != m_dec->PSInfoSBR->la && env != sbrChan->laPrev && sm == 0) m_dec->PSInfoSBR->sumQM += (qm >> ACC_SCALE);
 
         /* eCurr * gain^2 same as gain^2, before division by eCurr
          * (but note that gain != 0 even if eCurr == 0, since it's divided by eps)
          */
-        if(eCurr) m_PSInfoSBR->sumECurrGLim += (gain >> ACC_SCALE);
+        if(eCurr) m_dec->PSInfoSBR->sumECurrGLim += (gain >> ACC_SCALE);
     }
 }
 /***********************************************************************************************************************
@@ -7735,8 +8702,8 @@ void ApplyBoost(SBRFreq *sbrFreq, int lim, int fbitsDQ) {
     mStart = sbrFreq->freqLimiter[lim]; /* these are offsets from kStart */
     mEnd = sbrFreq->freqLimiter[lim + 1];
 
-    sumEOrigMapped = m_PSInfoSBR->sumEOrigMapped >> 1;
-    r = (m_PSInfoSBR->sumECurrGLim >> 1) + (m_PSInfoSBR->sumSM >> 1) + (m_PSInfoSBR->sumQM >> 1); /* 1 GB fine (sm and qm are mutually exclusive in acc) */
+    sumEOrigMapped = m_dec->PSInfoSBR->sumEOrigMapped >> 1;
+    r = (m_dec->PSInfoSBR->sumECurrGLim >> 1) + (m_dec->PSInfoSBR->sumSM >> 1) + (m_dec->PSInfoSBR->sumQM >> 1); /* 1 GB fine (sm and qm are mutually exclusive in acc) */
     if(r < (1 << (31 - 28))) {
         /* any non-zero numerator * 1/EPS_0 is > GBOOST_MAX
          * round very small r to zero to avoid scaling problems
@@ -7772,40 +8739,40 @@ void ApplyBoost(SBRFreq *sbrFreq, int lim, int fbitsDQ) {
          *   unless limiterGains == 3 (limiter off) and eCurr ~= 0 (i.e. huge gain, but only
          *   because the envelope has 0 power anyway)
          */
-        q = MULSHIFT32(m_PSInfoSBR->gLimBuf[m], gBoost) << 2; /* Q(gLimFbits) * Q(28) --> Q(gLimFbits[m]-2) */
-        r = SqrtFix(q, m_PSInfoSBR->gLimFbits[m] - 2, &z);
+        q = MULSHIFT32(m_dec->PSInfoSBR->gLimBuf[m], gBoost) << 2; /* Q(gLimFbits) * Q(28) --> Q(gLimFbits[m]-2) */
+        r = SqrtFix(q, m_dec->PSInfoSBR->gLimFbits[m] - 2, &z);
         z -= FBITS_GLIM_BOOST;
         if(z >= 0) {
-            m_PSInfoSBR->gLimBoost[m] = r >> MIN(z, 31);
+            m_dec->PSInfoSBR->gLimBoost[m] = r >> MIN(z, 31);
         }
         else {
             z = MIN(30, -z);
             r = CLIP_2N_SHIFT30(r, z);
-            m_PSInfoSBR->gLimBoost[m] = r;
+            m_dec->PSInfoSBR->gLimBoost[m] = r;
         }
 
-        q = MULSHIFT32(m_PSInfoSBR->qmLimBuf[m], gBoost) << 2; /* Q(fbitsDQ) * Q(28) --> Q(fbitsDQ-2) */
+        q = MULSHIFT32(m_dec->PSInfoSBR->qmLimBuf[m], gBoost) << 2; /* Q(fbitsDQ) * Q(28) --> Q(fbitsDQ-2) */
         r = SqrtFix(q, fbitsDQ - 2, &z);
         z -= FBITS_QLIM_BOOST; /* << by 14, since integer sqrt of x < 2^16, and we want to leave 1 GB */
         if(z >= 0) {
-            m_PSInfoSBR->qmLimBoost[m] = r >> MIN(31, z);
+            m_dec->PSInfoSBR->qmLimBoost[m] = r >> MIN(31, z);
         }
         else {
             z = MIN(30, -z);
             r = CLIP_2N_SHIFT30(r, z);
-            m_PSInfoSBR->qmLimBoost[m] = r;
+            m_dec->PSInfoSBR->qmLimBoost[m] = r;
         }
 
-        q = MULSHIFT32(m_PSInfoSBR->smBuf[m], gBoost) << 2; /* Q(fbitsDQ) * Q(28) --> Q(fbitsDQ-2) */
+        q = MULSHIFT32(m_dec->PSInfoSBR->smBuf[m], gBoost) << 2; /* Q(fbitsDQ) * Q(28) --> Q(fbitsDQ-2) */
         r = SqrtFix(q, fbitsDQ - 2, &z);
         z -= FBITS_OUT_QMFA; /* justify for adding to signal (xBuf) later */
         if(z >= 0) {
-            m_PSInfoSBR->smBoost[m] = r >> MIN(31, z);
+            m_dec->PSInfoSBR->smBoost[m] = r >> MIN(31, z);
         }
         else {
             z = MIN(30, -z);
             r = CLIP_2N_SHIFT30(r, z);
-            m_PSInfoSBR->smBoost[m] = r;
+            m_dec->PSInfoSBR->smBoost[m] = r;
         }
     }
 }
@@ -7831,12 +8798,12 @@ void CalcGain(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sb
     int lim, fbitsDQ;
 
     /* initialize to -1 so that mapping limiter bands to env/noise bands works right on first pass */
-    m_PSInfoSBR->envBand = -1;
-    m_PSInfoSBR->noiseFloorBand = -1;
-    m_PSInfoSBR->sBand = -1;
-    m_PSInfoSBR->highBand = -1;
+    m_dec->PSInfoSBR->envBand = -1;
+    m_dec->PSInfoSBR->noiseFloorBand = -1;
+    m_dec->PSInfoSBR->sBand = -1;
+    m_dec->PSInfoSBR->highBand = -1;
 
-    fbitsDQ = (FBITS_OUT_DQ_ENV - m_PSInfoSBR->envDataDequantScale[ch][env]); /* Q(29 - optional scalefactor) */
+    fbitsDQ = (FBITS_OUT_DQ_ENV - m_dec->PSInfoSBR->envDataDequantScale[ch][env]); /* Q(29 - optional scalefactor) */
     for(lim = 0; lim < sbrFreq->nLimiter; lim++) {
         /* the QMF bands are divided into lim regions (consecutive, non-overlapping) */
         CalcMaxGain(sbrHdr, sbrGrid, sbrFreq, ch, env, lim, fbitsDQ);
@@ -7886,8 +8853,8 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
     if(hfReset) {
         for(i = 0; i < hSL; i++) {
             for(m = 0; m < sbrFreq->numQMFBands; m++) {
-                sbrChan->gTemp[gainNoiseIndex][m] = m_PSInfoSBR->gLimBoost[m];
-                sbrChan->qTemp[gainNoiseIndex][m] = m_PSInfoSBR->qmLimBoost[m];
+                sbrChan->gTemp[gainNoiseIndex][m] = m_dec->PSInfoSBR->gLimBoost[m];
+                sbrChan->qTemp[gainNoiseIndex][m] = m_dec->PSInfoSBR->qmLimBoost[m];
             }
             gainNoiseIndex++;
             if(gainNoiseIndex == MAX_NUM_SMOOTH_COEFS) gainNoiseIndex = 0;
@@ -7903,27 +8870,27 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
          */
         if(i - iStart < MAX_NUM_SMOOTH_COEFS) {
             for(m = 0; m < sbrFreq->numQMFBands; m++) {
-                sbrChan->gTemp[gainNoiseIndex][m] = m_PSInfoSBR->gLimBoost[m];
-                sbrChan->qTemp[gainNoiseIndex][m] = m_PSInfoSBR->qmLimBoost[m];
+                sbrChan->gTemp[gainNoiseIndex][m] = m_dec->PSInfoSBR->gLimBoost[m];
+                sbrChan->qTemp[gainNoiseIndex][m] = m_dec->PSInfoSBR->qmLimBoost[m];
             }
         }
 
         /* see 4.6.18.7.6 */
-        XBuf = m_PSInfoSBR->XBuf[i + HF_ADJ][sbrFreq->kStart];
+        XBuf = m_dec->PSInfoSBRQMF->XBuf[i + HF_ADJ][sbrFreq->kStart];
         gbMask = 0;
         for(m = 0; m < sbrFreq->numQMFBands; m++) {
-            if(env == m_PSInfoSBR->la || env == sbrChan->laPrev) {
+            if(env == m_dec->PSInfoSBR->la || env == sbrChan->laPrev) {
                 /* no smoothing filter for gain, and qFilt = 0 (only need to do once) */
                 if(i == iStart) {
-                    m_PSInfoSBR->gFiltLast[m] = sbrChan->gTemp[gainNoiseIndex][m];
-                    m_PSInfoSBR->qFiltLast[m] = 0;
+                    m_dec->PSInfoSBR->gFiltLast[m] = sbrChan->gTemp[gainNoiseIndex][m];
+                    m_dec->PSInfoSBR->qFiltLast[m] = 0;
                 }
             }
             else if(hSL == 0) {
                 /* no smoothing filter for gain, (only need to do once) */
                 if(i == iStart) {
-                    m_PSInfoSBR->gFiltLast[m] = sbrChan->gTemp[gainNoiseIndex][m];
-                    m_PSInfoSBR->qFiltLast[m] = sbrChan->qTemp[gainNoiseIndex][m];
+                    m_dec->PSInfoSBR->gFiltLast[m] = sbrChan->gTemp[gainNoiseIndex][m];
+                    m_dec->PSInfoSBR->qFiltLast[m] = sbrChan->qTemp[gainNoiseIndex][m];
                 }
             }
             else {
@@ -7939,14 +8906,14 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
                         idx--;
                         if(idx < 0) idx += MAX_NUM_SMOOTH_COEFS;
                     }
-                    m_PSInfoSBR->gFiltLast[m] = gFilt << 1; /* restore to Q(FBITS_GLIM_BOOST) (gain of filter < 1.0, so no overflow) */
-                    m_PSInfoSBR->qFiltLast[m] = qFilt << 1; /* restore to Q(FBITS_QLIM_BOOST) */
+                    m_dec->PSInfoSBR->gFiltLast[m] = gFilt << 1; /* restore to Q(FBITS_GLIM_BOOST) (gain of filter < 1.0, so no overflow) */
+                    m_dec->PSInfoSBR->qFiltLast[m] = qFilt << 1; /* restore to Q(FBITS_QLIM_BOOST) */
                 }
             }
 
-            if(m_PSInfoSBR->smBoost[m] != 0) {
+            if(m_dec->PSInfoSBR->smBoost[m] != 0) {
                 /* add scaled signal and sinusoid, don't add noise (qFilt = 0) */
-                smre = m_PSInfoSBR->smBoost[m];
+                smre = m_dec->PSInfoSBR->smBoost[m];
                 smim = smre;
 
                 /* sinIndex:  [0] xre += sm   [1] xim += sm*s   [2] xre -= sm   [3] xim -= sm*s  */
@@ -7968,7 +8935,7 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
             }
             else {
                 /* add scaled signal and scaled noise */
-                qFilt = m_PSInfoSBR->qFiltLast[m];
+                qFilt = m_dec->PSInfoSBR->qFiltLast[m];
                 n = noiseTab[noiseTabIndex++];
                 smre = MULSHIFT32(n, qFilt) >> (FBITS_QLIM_BOOST - 1 - FBITS_OUT_QMFA);
 
@@ -7977,7 +8944,7 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
             }
             noiseTabIndex &= 1023; /* 512 complex numbers */
 
-            gFilt = m_PSInfoSBR->gFiltLast[m];
+            gFilt = m_dec->PSInfoSBR->gFiltLast[m];
             xre = MULSHIFT32(gFilt, XBuf[0]);
             xim = MULSHIFT32(gFilt, XBuf[1]);
             xre = CLIP_2N_SHIFT30(xre, 32 - FBITS_GLIM_BOOST);
@@ -8002,7 +8969,7 @@ void MapHF(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrCh
          * almost never occurs in practice, but checking here makes synth QMF logic very simple
          */
         if(gbMask >> (31 - MIN_GBITS_IN_QMFS)) {
-            XBuf = m_PSInfoSBR->XBuf[i + HF_ADJ][sbrFreq->kStart];
+            XBuf = m_dec->PSInfoSBRQMF->XBuf[i + HF_ADJ][sbrFreq->kStart];
             for(m = 0; m < sbrFreq->numQMFBands; m++) {
                 xre = XBuf[0];
                 xim = XBuf[1];
@@ -8045,11 +9012,11 @@ void AdjustHighFreq(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRCh
 
     /* derive la from table 4.159 */
     if ((frameClass == SBR_GRID_FIXVAR || frameClass == SBR_GRID_VARVAR) && pointer > 0)
-        m_PSInfoSBR->la = sbrGrid->numEnv + 1 - pointer;
+        m_dec->PSInfoSBR->la = sbrGrid->numEnv + 1 - pointer;
     else if (frameClass == SBR_GRID_VARFIX && pointer > 1)
-        m_PSInfoSBR->la = pointer - 1;
+        m_dec->PSInfoSBR->la = pointer - 1;
     else
-        m_PSInfoSBR->la = -1;
+        m_dec->PSInfoSBR->la = -1;
 
     /* for each envelope, estimate gain and adjust SBR QMF bands */
     hfReset = sbrChan->reset;
@@ -8068,7 +9035,7 @@ void AdjustHighFreq(SBRHeader *sbrHdr, SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRCh
     sbrChan->addHarmonicFlag[0] = sbrChan->addHarmonicFlag[1];
 
     /* save la for next frame */
-    if (m_PSInfoSBR->la == sbrGrid->numEnv)
+    if (m_dec->PSInfoSBR->la == sbrGrid->numEnv)
         sbrChan->laPrev = 0;
     else
         sbrChan->laPrev = -1;
@@ -8336,7 +9303,8 @@ void CalcLPCoefs(int *XBuf, int *a0re, int *a0im, int *a1re, int *a1im, int gb)
      * i.e. a0re < 4, a0im < 4, a1re < 4, a1im < 4
      * Q29*Q29 = Q26
      */
-    if (zFlag || MULSHIFT32(*a0re, *a0re) + MULSHIFT32(*a0im, *a0im) >= MAG_16 || MULSHIFT32(*a1re, *a1re) + MULSHIFT32(*a1im, *a1im) >= MAG_16) {
+    if (zFlag || (uint32_t)(MULSHIFT32(*a0re, *a0re) + MULSHIFT32(*a0im, *a0im)) >= MAG_16 ||
+                 (uint32_t)(MULSHIFT32(*a1re, *a1re) + MULSHIFT32(*a1im, *a1im)) >= MAG_16) {
         *a0re = *a0im = 0;
         *a1re = *a1im = 0;
     }
@@ -8372,6 +9340,7 @@ void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
     int x1re, x1im, x2re, x2im;
     int ACCre, ACCim;
     int *XBufLo, *XBufHi;
+    int *lpCoefs;
     (void) ch;
 
     /* calculate array of chirp factors */
@@ -8408,6 +9377,12 @@ void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
     gbMask = (sbrChan->gbMask[0] | sbrChan->gbMask[1]); /* older 32 | newer 8 */
     gb = CLZ(gbMask) - 1;
 
+    /* patches often start at the same low band, the LP coefficients of a band depend only on XBuf[][p] and gb, which
+     * don't change in here (p < kStart), so every band is solved once per channel. A repeated CalcLPCoefs() would
+     * return the same values, its pre-scaling is undone bit-exact on the second pass
+     */
+    m_dec->PSInfoSBR->lpCoefsValid = 0;
+
     for (currPatch = 0; currPatch < sbrFreq->numPatches; currPatch++) {
         for (x = 0; x < sbrFreq->patchNumSubbands[currPatch]; x++) {
             /* map k to corresponding noise floor band */
@@ -8418,16 +9393,27 @@ void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
             }
 
             p = sbrFreq->patchStartSubband[currPatch] + x;  /* low QMF band */
-            XBufHi = m_PSInfoSBR->XBuf[iStart][k];
+            XBufHi = m_dec->PSInfoSBRQMF->XBuf[iStart][k];
             if (bw) {
-                CalcLPCoefs(m_PSInfoSBR->XBuf[0][p], &a0re, &a0im, &a1re, &a1im, gb);
+                lpCoefs = m_dec->PSInfoSBR->lpCoefs[p & 31];
+                if (p < 32 && (m_dec->PSInfoSBR->lpCoefsValid >> p) & 1) {
+                    a0re = lpCoefs[0]; a0im = lpCoefs[1];
+                    a1re = lpCoefs[2]; a1im = lpCoefs[3];
+                } else {
+                    CalcLPCoefs(m_dec->PSInfoSBRQMF->XBuf[0][p], &a0re, &a0im, &a1re, &a1im, gb);
+                    if (p < 32) {
+                        lpCoefs[0] = a0re; lpCoefs[1] = a0im;
+                        lpCoefs[2] = a1re; lpCoefs[3] = a1im;
+                        m_dec->PSInfoSBR->lpCoefsValid |= 1u << p;
+                    }
+                }
 
                 a0re = MULSHIFT32(bw, a0re);    /* Q31 * Q29 = Q28 */
                 a0im = MULSHIFT32(bw, a0im);
                 a1re = MULSHIFT32(bwsq, a1re);
                 a1im = MULSHIFT32(bwsq, a1im);
 
-                XBufLo = m_PSInfoSBR->XBuf[iStart-2][p];
+                XBufLo = m_dec->PSInfoSBRQMF->XBuf[iStart-2][p];
 
                 x2re = XBufLo[0];   /* RE{XBuf[n-2]} */
                 x2im = XBufLo[1];   /* IM{XBuf[n-2]} */
@@ -8469,7 +9455,7 @@ void GenerateHighFreq(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
                     sbrChan->gbMask[gbIdx] |= gbMask;
                 }
             } else {
-                XBufLo = (int *)m_PSInfoSBR->XBuf[iStart][p];
+                XBufLo = (int *)m_dec->PSInfoSBRQMF->XBuf[iStart][p];
                 for (i = iStart; i < iEnd; i++) {
                     XBufHi[0] = XBufLo[0];
                     XBufHi[1] = XBufLo[1];
@@ -8676,7 +9662,7 @@ void DecodeSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
     int huffIndexTime, huffIndexFreq, env, envStartBits, band, nBands, sf, lastEnv;
     int freqRes, freqResPrev, dShift, i;
 
-    if(m_PSInfoSBR->couplingFlag && ch) {
+    if(m_dec->PSInfoSBR->couplingFlag && ch) {
         dShift = 1;
         if(sbrGrid->ampResFrame) {
             huffIndexTime = HuffTabSBR_tEnv30b;
@@ -8758,9 +9744,9 @@ void DecodeSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int
         }
 
         /* skip coupling channel */
-        if(ch != 1 || m_PSInfoSBR->couplingFlag != 1)
-            m_PSInfoSBR->envDataDequantScale[ch][env] = DequantizeEnvelope(nBands, sbrGrid->ampResFrame,
-                    sbrChan->envDataQuant[env], m_PSInfoSBR->envDataDequant[ch][env]);
+        if(ch != 1 || m_dec->PSInfoSBR->couplingFlag != 1)
+            m_dec->PSInfoSBR->envDataDequantScale[ch][env] = DequantizeEnvelope(nBands, sbrGrid->ampResFrame,
+                    sbrChan->envDataQuant[env], m_dec->PSInfoSBR->envDataDequant[ch][env]);
     }
     sbrGrid->numEnvPrev = sbrGrid->numEnv;
     sbrGrid->freqResPrev = sbrGrid->freqRes[sbrGrid->numEnv - 1];
@@ -8785,7 +9771,7 @@ void DecodeSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int ch
 
     int huffIndexTime, huffIndexFreq, noiseFloor, band, dShift, sf, lastNoiseFloor;
 
-    if(m_PSInfoSBR->couplingFlag && ch) {
+    if(m_dec->PSInfoSBR->couplingFlag && ch) {
         dShift = 1;
         huffIndexTime = HuffTabSBR_tNoise30b;
         huffIndexFreq = HuffTabSBR_fNoise30b;
@@ -8819,9 +9805,9 @@ void DecodeSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChan, int ch
         }
 
         /* skip coupling channel */
-        if(ch != 1 || m_PSInfoSBR->couplingFlag != 1)
+        if(ch != 1 || m_dec->PSInfoSBR->couplingFlag != 1)
             DequantizeNoise(sbrFreq->numNoiseFloorBands, sbrChan->noiseDataQuant[noiseFloor],
-                    m_PSInfoSBR->noiseDataDequant[ch][noiseFloor]);
+                    m_dec->PSInfoSBR->noiseDataDequant[ch][noiseFloor]);
     }
     sbrGrid->numNoiseFloorsPrev = sbrGrid->numNoiseFloors;
 }
@@ -8857,7 +9843,7 @@ void UncoupleSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR)
     scalei = (sbrGrid->ampResFrame ? 0 : 1);
     for(env = 0; env < sbrGrid->numEnv; env++) {
         nBands = (sbrGrid->freqRes[env] ? sbrFreq->nHigh : sbrFreq->nLow);
-        m_PSInfoSBR->envDataDequantScale[1][env] = m_PSInfoSBR->envDataDequantScale[0][env];
+        m_dec->PSInfoSBR->envDataDequantScale[1][env] = m_dec->PSInfoSBR->envDataDequantScale[0][env];
         for(band = 0; band < nBands; band++) {
             /* clip E_1 to [0, 24] (scalefactors approach 0 or 2) */
             E_1 = sbrChanR->envDataQuant[env][band] >> scalei;
@@ -8865,9 +9851,9 @@ void UncoupleSBREnvelope(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR)
             if(E_1 > 24) E_1 = 24;
 
             /* envDataDequant[0] has 1 GB, so << by 2 is okay */
-            m_PSInfoSBR->envDataDequant[1][env][band] = MULSHIFT32(m_PSInfoSBR->envDataDequant[0][env][band],
+            m_dec->PSInfoSBR->envDataDequant[1][env][band] = MULSHIFT32(m_dec->PSInfoSBR->envDataDequant[0][env][band],
                     dqTabCouple[24 - E_1]) << 2;
-            m_PSInfoSBR->envDataDequant[0][env][band] = MULSHIFT32(m_PSInfoSBR->envDataDequant[0][env][band],
+            m_dec->PSInfoSBR->envDataDequant[0][env][band] = MULSHIFT32(m_dec->PSInfoSBR->envDataDequant[0][env][band],
                     dqTabCouple[E_1]) << 2;
         }
     }
@@ -8900,10 +9886,10 @@ void UncoupleSBRNoise(SBRGrid *sbrGrid, SBRFreq *sbrFreq, SBRChan *sbrChanR) {
             if (Q_1 > 24)   Q_1 = 24;
 
             /* noiseDataDequant[0] has 1 GB, so << by 2 is okay */
-            m_PSInfoSBR->noiseDataDequant[1][noiseFloor][band] =
-                    MULSHIFT32(m_PSInfoSBR->noiseDataDequant[0][noiseFloor][band], dqTabCouple[24 - Q_1]) << 2;
-            m_PSInfoSBR->noiseDataDequant[0][noiseFloor][band] =
-                    MULSHIFT32(m_PSInfoSBR->noiseDataDequant[0][noiseFloor][band], dqTabCouple[Q_1]) << 2;
+            m_dec->PSInfoSBR->noiseDataDequant[1][noiseFloor][band] =
+                    MULSHIFT32(m_dec->PSInfoSBR->noiseDataDequant[0][noiseFloor][band], dqTabCouple[24 - Q_1]) << 2;
+            m_dec->PSInfoSBR->noiseDataDequant[0][noiseFloor][band] =
+                    MULSHIFT32(m_dec->PSInfoSBR->noiseDataDequant[0][noiseFloor][band], dqTabCouple[Q_1]) << 2;
         }
     }
 }
@@ -9303,14 +10289,48 @@ void DecWindowOverlapShortNoClip(int *buf0, int *over0, int *out0, int winTypeCu
         i -= 4;
     } while (i);
 }
+/* pass i of the pre-twiddle, complex samples i and 31-i from the loaded inputs, the results go to z1 (sample i) and
+ * z2 (sample 31-i)
+ */
+static inline __attribute__((always_inline)) void PreMultiply64Pass(int ar1, int ai2, int ai1, int ar2, const int *csptr,
+                                                                     int *z1, int *z2) {
+
+    int t, cms2;
+
+    /* gain 2 ints bit from MULSHIFT32 by Q30
+     * max per-sample gain (ignoring implicit scaling) = MAX(sin(angle)+cos(angle)) = 1.414
+     * i.e. gain 1 GB since worst case is sin(angle) = cos(angle) = 0.707 (Q30), gain 2 from
+     *   extra sign bits, and eat one in adding
+     */
+    t  = MULSHIFT32(csptr[1], ar1 + ai1);
+    cms2 = csptr[0] - 2*csptr[1];
+    z1[0] = MULSHIFT32(cms2, ar1) + t;      /* cos*ar1 + sin*ai1 */
+    z1[1] = MULSHIFT32(csptr[0], ai1) - t;  /* cos*ai1 - sin*ar1 */
+
+    t  = MULSHIFT32(csptr[3], ar2 + ai2);
+    cms2 = csptr[2] - 2*csptr[3];
+    z2[0] = MULSHIFT32(cms2, ar2) + t;      /* cos*ar2 + sin*ai2 */
+    z2[1] = MULSHIFT32(csptr[2], ai2) - t;  /* cos*ai2 - sin*ar2 */
+}
+/* passes i and j, the results of one pass are stored where the inputs of the other one were read, so i and j must form
+ * a closed group under the bit reversal (x and 31-x included)
+ */
+static inline __attribute__((always_inline)) void PreMultiply64Group(int *z, int i, int j, int iTo, int jTo) {
+
+    int ar1 = z[2*j], ai2 = z[2*j + 1], ai1 = z[63 - 2*j], ar2 = z[62 - 2*j];    /* inputs of pass j */
+
+    /* iTo, jTo: position of sample i, j after bit reversal, sample 31-x always lands on 31-xTo */
+    PreMultiply64Pass(z[2*i], z[2*i + 1], z[63 - 2*i], z[62 - 2*i], cos4sin4tab64 + 4*i, z + 2*iTo, z + 62 - 2*iTo);
+    PreMultiply64Pass(ar1, ai2, ai1, ar2, cos4sin4tab64 + 4*j, z + 2*jTo, z + 62 - 2*jTo);
+}
 /***********************************************************************************************************************
  * Function:    PreMultiply64
  *
- * Description: pre-twiddle stage of 64-point DCT-IV
+ * Description: pre-twiddle stage of 64-point DCT-IV, combined with the bit reversal of the following FFT32C
  *
  * Inputs:      buffer of 64 samples
  *
- * Outputs:     processed samples in same buffer
+ * Outputs:     processed samples in same buffer, in bit-reversed order of the 32 complex samples
  *
  * Return:      none
  *
@@ -9318,49 +10338,27 @@ void DecWindowOverlapShortNoClip(int *buf0, int *over0, int *out0, int winTypeCu
  *              gbOut = gbIn + 1
  *              output is limited to sqrt(2)/2 plus GB in full GB
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
+ *              the 16 passes (sample x and 31-x each) are grouped by the bit reversal: 0, 4, 10, 14 map onto
+ *                themselves, 2 <-> 8 and 6 <-> 12 swap, 1 <-> 15, 3 <-> 7, 5 <-> 11, 9 <-> 13 swap with the mirrored
+ *                sample (x -> 31-y), so every result is written straight to its final place
  **********************************************************************************************************************/
-void PreMultiply64(int *zbuf1) {
-
-    int i, ar1, ai1, ar2, ai2, z1, z2;
-    int t, cms2, cps2a, sin2a, cps2b, sin2b;
-    int *zbuf2;
-    const int *csptr;
-
-    zbuf2 = zbuf1 + 64 - 1;
-    csptr = cos4sin4tab64;
-
-    /* whole thing should fit in registers - verify that compiler does this */
-    for (i = 64 >> 2; i != 0; i--) {
-        /* cps2 = (cos+sin), sin2 = sin, cms2 = (cos-sin) */
-        cps2a = *csptr++;
-        sin2a = *csptr++;
-        cps2b = *csptr++;
-        sin2b = *csptr++;
+void AAC_IRAM PreMultiply64(int *zbuf1) {
 
-        ar1 = *(zbuf1 + 0);
-        ai2 = *(zbuf1 + 1);
-        ai1 = *(zbuf2 + 0);
-        ar2 = *(zbuf2 - 1);
+    /* samples mapping onto themselves, 31-x onto 31-x */
+    PreMultiply64Pass(zbuf1[ 0], zbuf1[ 1], zbuf1[63], zbuf1[62], cos4sin4tab64 +  0, zbuf1 +  0, zbuf1 + 62);
+    PreMultiply64Pass(zbuf1[ 8], zbuf1[ 9], zbuf1[55], zbuf1[54], cos4sin4tab64 + 16, zbuf1 +  8, zbuf1 + 54);
+    PreMultiply64Pass(zbuf1[20], zbuf1[21], zbuf1[43], zbuf1[42], cos4sin4tab64 + 40, zbuf1 + 20, zbuf1 + 42);
+    PreMultiply64Pass(zbuf1[28], zbuf1[29], zbuf1[35], zbuf1[34], cos4sin4tab64 + 56, zbuf1 + 28, zbuf1 + 34);
 
-        /* gain 2 ints bit from MULSHIFT32 by Q30
-         * max per-sample gain (ignoring implicit scaling) = MAX(sin(angle)+cos(angle)) = 1.414
-         * i.e. gain 1 GB since worst case is sin(angle) = cos(angle) = 0.707 (Q30), gain 2 from
-         *   extra sign bits, and eat one in adding
-         */
-        t  = MULSHIFT32(sin2a, ar1 + ai1);
-        z2 = MULSHIFT32(cps2a, ai1) - t;
-        cms2 = cps2a - 2*sin2a;
-        z1 = MULSHIFT32(cms2, ar1) + t;
-        *zbuf1++ = z1;  /* cos*ar1 + sin*ai1 */
-        *zbuf1++ = z2;  /* cos*ai1 - sin*ar1 */
+    /* bitrev(i) = j */
+    PreMultiply64Group(zbuf1,  2,  8,  8,  2);
+    PreMultiply64Group(zbuf1,  6, 12, 12,  6);
 
-        t  = MULSHIFT32(sin2b, ar2 + ai2);
-        z2 = MULSHIFT32(cps2b, ai2) - t;
-        cms2 = cps2b - 2*sin2b;
-        z1 = MULSHIFT32(cms2, ar2) + t;
-        *zbuf2-- = z2;  /* cos*ai2 - sin*ar2 */
-        *zbuf2-- = z1;  /* cos*ar2 + sin*ai2 */
-    }
+    /* bitrev(i) = 31-j */
+    PreMultiply64Group(zbuf1,  1, 15, 31 - 15, 31 -  1);
+    PreMultiply64Group(zbuf1,  3,  7, 31 -  7, 31 -  3);
+    PreMultiply64Group(zbuf1,  5, 11, 31 - 11, 31 -  5);
+    PreMultiply64Group(zbuf1,  9, 13, 31 - 13, 31 -  9);
 }
 /***********************************************************************************************************************
  * Function:    PostMultiply64
@@ -9380,7 +10378,7 @@ void PreMultiply64(int *zbuf1) {
  *              nSampsOut is rounded up to next multiple of 4, since we calculate
  *                4 samples per loop
  **********************************************************************************************************************/
-void PostMultiply64(int *fft1, int nSampsOut) {
+void AAC_IRAM PostMultiply64(int *fft1, int nSampsOut) {
 
     int i, ar1, ai1, ar2, ai2;
     int t, cms2, cps2, sin2;
@@ -9418,6 +10416,116 @@ void PostMultiply64(int *fft1, int nSampsOut) {
         *fft1++ = t + MULSHIFT32(cms2, ar2);
     }
 }
+/***********************************************************************************************************************
+ * Function:    PostMultiply64Synth
+ *
+ * Description: post-twiddle stage of both 64-point type-IV DCTs in QMFSynthesis, merged with the butterfly that
+ *                combines them into the delay line
+ *
+ * Inputs:      buffer of 2*64 samples, first DCT in [0, 63], second DCT in [64, 127]
+ *
+ * Outputs:     delay line samples in same buffer
+ *
+ * Return:      none
+ *
+ * Notes:       same results as PostMultiply64() on both halves followed by the butterfly, in one pass
+ *              even positions n: lo = hi - lo, hi = hi + lo, odd positions: lo = -hi - lo, hi = lo - hi
+ **********************************************************************************************************************/
+void AAC_IRAM PostMultiply64Synth(int *fft1) {
+
+    int i, ar1, ai1, ar2, ai2, br1, bi1, br2, bi2;
+    int t, u, lo, hi, cms2, cps2, sin2;
+    int *fft2;
+    const int *csptr;
+
+    csptr = cos1sin1tab64;
+    fft2 = fft1 + 64 - 1;
+
+    /* load coeffs for first pass
+     * cps2 = (cos+sin)/2, sin2 = sin/2, cms2 = (cos-sin)/2
+     */
+    cps2 = *csptr++;
+    sin2 = *csptr++;
+    cms2 = cps2 - 2*sin2;
+
+    for (i = 16; i != 0; i--) {
+        ar1 = fft1[0];
+        ai1 = fft1[1];
+        ai2 = fft2[0];
+        br1 = fft1[64];
+        bi1 = fft1[65];
+        bi2 = fft2[64];
+
+        /* gain 2 int bits (multiplying by Q30), max gain = sqrt(2) */
+        t = MULSHIFT32(sin2, ar1 + ai1);
+        u = MULSHIFT32(sin2, br1 + bi1);
+        lo = t - MULSHIFT32(cps2, ai1);     /* odd position 63 - 2*(16-i) */
+        hi = u - MULSHIFT32(cps2, bi1);
+        fft2[0]  = -hi - lo;
+        fft2[64] =  lo - hi;
+        lo = t + MULSHIFT32(cms2, ar1);     /* even position 2*(16-i) */
+        hi = u + MULSHIFT32(cms2, br1);
+        fft1[0]  = hi - lo;
+        fft1[64] = hi + lo;
+
+        cps2 = *csptr++;
+        sin2 = *csptr++;
+        cms2 = cps2 - 2*sin2;
+
+        ar2 = fft2[-1];
+        br2 = fft2[63];
+        ai2 = -ai2;
+        bi2 = -bi2;
+        t = MULSHIFT32(sin2, ar2 + ai2);
+        u = MULSHIFT32(sin2, br2 + bi2);
+        lo = t - MULSHIFT32(cps2, ai2);     /* even position 62 - 2*(16-i) */
+        hi = u - MULSHIFT32(cps2, bi2);
+        fft2[-1] = hi - lo;
+        fft2[63] = hi + lo;
+        lo = t + MULSHIFT32(cms2, ar2);     /* odd position 2*(16-i) + 1 */
+        hi = u + MULSHIFT32(cms2, br2);
+        fft1[1]  = -hi - lo;
+        fft1[65] =  lo - hi;
+
+        fft1 += 2;
+        fft2 -= 2;
+    }
+}
+/* taps k = 1...31 of QMFAnalysisConv() for one ring index, called with a constant dIdx every delay address becomes a
+ * fixed offset from d, the ring wrap is resolved at compile time
+ */
+static inline __attribute__((always_inline)) void QMFAnalysisConvTaps(const int *cPtr0, const int *cPtr1, const int *d,
+                                                                       const int dIdx, int *uBuf) {
+
+    const int o0 = ((dIdx + 10) % 10) * 32, o1 = ((dIdx + 9) % 10) * 32, o2 = ((dIdx + 8) % 10) * 32;
+    const int o3 = ((dIdx +  7) % 10) * 32, o4 = ((dIdx + 6) % 10) * 32, o5 = ((dIdx + 5) % 10) * 32;
+    const int o6 = ((dIdx +  4) % 10) * 32, o7 = ((dIdx + 3) % 10) * 32, o8 = ((dIdx + 2) % 10) * 32;
+    const int o9 = ((dIdx +  1) % 10) * 32;
+    int k;
+    U64 u64lo, u64hi;
+
+    for (k = 31; k != 0; k--) {
+        u64lo.w64 = 0;
+        u64hi.w64 = 0;
+        u64lo.w64 = MADD64(u64lo.w64, cPtr0[ 0], d[o0]);
+        u64hi.w64 = MADD64(u64hi.w64, cPtr0[ 1], d[o1]);
+        u64lo.w64 = MADD64(u64lo.w64, cPtr0[ 2], d[o2]);
+        u64hi.w64 = MADD64(u64hi.w64, cPtr0[ 3], d[o3]);
+        u64lo.w64 = MADD64(u64lo.w64, cPtr0[ 4], d[o4]);
+        u64hi.w64 = MADD64(u64hi.w64, cPtr1[ 0], d[o5]);
+        u64lo.w64 = MADD64(u64lo.w64, cPtr1[-1], d[o6]);
+        u64hi.w64 = MADD64(u64hi.w64, cPtr1[-2], d[o7]);
+        u64lo.w64 = MADD64(u64lo.w64, cPtr1[-3], d[o8]);
+        u64hi.w64 = MADD64(u64hi.w64, cPtr1[-4], d[o9]);
+
+        uBuf[0]  = u64lo.r.hi32;
+        uBuf[32] = u64hi.r.hi32;
+        uBuf++;
+        d--;
+        cPtr0 += 5;
+        cPtr1 -= 5;
+    }
+}
 /***********************************************************************************************************************
  * Function:    QMFAnalysisConv
  *
@@ -9431,12 +10539,12 @@ void PostMultiply64(int *fft1, int nSampsOut) {
  *
  * Return:      none
  *
- * Notes:       this is carefully written to be efficient on ARM
- *              use the assembly code version in sbrqmfak.s when building for ARM!
+ * Notes:       the first pass walks the ring with a wrap check per tap, the remaining 31 passes run in a copy of
+ *                QMFAnalysisConvTaps() per ring index without any wrap check
  **********************************************************************************************************************/
-void QMFAnalysisConv(int *cTab, int *delay, int dIdx, int *uBuf) {
+void AAC_IRAM QMFAnalysisConv(int *cTab, int *delay, int dIdx, int *uBuf) {
 
-    int k, dOff;
+    int dOff;
     int *cPtr0, *cPtr1;
     U64 u64lo, u64hi;
 
@@ -9456,34 +10564,26 @@ void QMFAnalysisConv(int *cTab, int *delay, int dIdx, int *uBuf) {
     u64lo.w64 = MADD64(u64lo.w64, -(*cPtr1--), delay[dOff]);    dOff -= 32; if (dOff < 0) {dOff += 320;}
     u64hi.w64 = MADD64(u64hi.w64,  *cPtr1--,   delay[dOff]);    dOff -= 32; if (dOff < 0) {dOff += 320;}
     u64lo.w64 = MADD64(u64lo.w64, -(*cPtr1--), delay[dOff]);    dOff -= 32; if (dOff < 0) {dOff += 320;}
-    u64hi.w64 = MADD64(u64hi.w64,  *cPtr1--,   delay[dOff]);    dOff -= 32; if (dOff < 0) {dOff += 320;}
+    u64hi.w64 = MADD64(u64hi.w64,  *cPtr1--,   delay[dOff]);
 
     uBuf[0]  = u64lo.r.hi32;
     uBuf[32] = u64hi.r.hi32;
     uBuf++;
-    dOff--;
 
     /* max gain for any sample in uBuf, after scaling by cTab, ~= 0.99
      * so we can just sum the uBuf values with no overflow problems
      */
-    for (k = 1; k <= 31; k++) {
-        u64lo.w64 = 0;
-        u64hi.w64 = 0;
-        u64lo.w64 = MADD64(u64lo.w64, *cPtr0++, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64hi.w64 = MADD64(u64hi.w64, *cPtr0++, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64lo.w64 = MADD64(u64lo.w64, *cPtr0++, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64hi.w64 = MADD64(u64hi.w64, *cPtr0++, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64lo.w64 = MADD64(u64lo.w64, *cPtr0++, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64hi.w64 = MADD64(u64hi.w64, *cPtr1--, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64lo.w64 = MADD64(u64lo.w64, *cPtr1--, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64hi.w64 = MADD64(u64hi.w64, *cPtr1--, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64lo.w64 = MADD64(u64lo.w64, *cPtr1--, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-        u64hi.w64 = MADD64(u64hi.w64, *cPtr1--, delay[dOff]);   dOff -= 32; if (dOff < 0) {dOff += 320;}
-
-        uBuf[0]  = u64lo.r.hi32;
-        uBuf[32] = u64hi.r.hi32;
-        uBuf++;
-        dOff--;
+    switch (dIdx) {
+        case 0:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 0, uBuf); break;
+        case 1:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 1, uBuf); break;
+        case 2:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 2, uBuf); break;
+        case 3:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 3, uBuf); break;
+        case 4:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 4, uBuf); break;
+        case 5:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 5, uBuf); break;
+        case 6:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 6, uBuf); break;
+        case 7:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 7, uBuf); break;
+        case 8:  QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 8, uBuf); break;
+        default: QMFAnalysisConvTaps(cPtr0, cPtr1, delay + 30, 9, uBuf); break;
     }
 }
 /***********************************************************************************************************************
@@ -9574,6 +10674,41 @@ int QMFAnalysis(int *inbuf, int *delay, int *XBuf, int fBitsIn, int *delayIdx, i
     /* minimum of 2 GB in output */
     return gbMask;
 }
+/* all 64 output samples of QMFSynthesisConv() for one ring index, the even taps read the blocks dIdx, dIdx-2, ...
+ * forwards, the odd taps the blocks dIdx-1, dIdx-3, ... backwards. Called with a constant dIdx the ring wrap is resolved
+ * at compile time
+ */
+static inline __attribute__((always_inline)) void QMFSynthesisConvTaps(const int *cPtr, const int *delay, const int dIdx,
+                                                                        short *outbuf, int nChans) {
+
+    const int o0 = ((dIdx + 10) % 10) * 128, o1 = ((dIdx + 9) % 10) * 128 + 127, o2 = ((dIdx + 8) % 10) * 128;
+    const int o3 = ((dIdx +  7) % 10) * 128 + 127, o4 = ((dIdx + 6) % 10) * 128, o5 = ((dIdx + 5) % 10) * 128 + 127;
+    const int o6 = ((dIdx +  4) % 10) * 128, o7 = ((dIdx + 3) % 10) * 128 + 127, o8 = ((dIdx + 2) % 10) * 128;
+    const int o9 = ((dIdx +  1) % 10) * 128 + 127;
+    const int *d0 = delay, *d1 = delay;
+    int k;
+    U64 sum64;
+
+    for (k = 64; k != 0; k--) {
+        sum64.w64 = 0;
+        sum64.w64 = MADD64(sum64.w64, cPtr[0], d0[o0]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[1], d1[o1]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[2], d0[o2]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[3], d1[o3]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[4], d0[o4]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[5], d1[o5]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[6], d0[o6]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[7], d1[o7]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[8], d0[o8]);
+        sum64.w64 = MADD64(sum64.w64, cPtr[9], d1[o9]);
+
+        cPtr += 10;
+        d0++;
+        d1--;
+        *outbuf = CLIPTOSHORT((sum64.r.hi32 + RND_VAL) >> FBITS_OUT_QMFS);
+        outbuf += nChans;
+    }
+}
 /***********************************************************************************************************************
  * Function:    QMFSynthesisConv
  *
@@ -9589,37 +10724,23 @@ int QMFAnalysis(int *inbuf, int *delay, int *XBuf, int fBitsIn, int *delayIdx, i
  *
  * Return:      none
  *
- * Notes:       this is carefully written to be efficient on ARM
- *              use the assembly code version in sbrqmfsk.s when building for ARM!
+ * Notes:       one copy of QMFSynthesisConvTaps() per ring index, no wrap check in the taps
+ *              scaling note: total gain of coefs (cPtr[0]-cPtr[9] for any k) is < 2.0, so 1 GB in delay values is
+ *                adequate
  **********************************************************************************************************************/
-void QMFSynthesisConv(int *cPtr, int *delay, int dIdx, short *outbuf, int nChans) {
+void AAC_IRAM QMFSynthesisConv(int *cPtr, int *delay, int dIdx, short *outbuf, int nChans) {
 
-    int k, dOff0, dOff1;
-    U64 sum64;
-
-    dOff0 = (dIdx)*128;
-    dOff1 = dOff0 - 1;
-    if (dOff1 < 0)
-        dOff1 += 1280;
-
-    /* scaling note: total gain of coefs (cPtr[0]-cPtr[9] for any k) is < 2.0, so 1 GB in delay values is adequate */
-    for (k = 0; k <= 63; k++) {
-        sum64.w64 = 0;
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff0]);   dOff0 -= 256; if (dOff0 < 0) {dOff0 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff1]);   dOff1 -= 256; if (dOff1 < 0) {dOff1 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff0]);   dOff0 -= 256; if (dOff0 < 0) {dOff0 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff1]);   dOff1 -= 256; if (dOff1 < 0) {dOff1 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff0]);   dOff0 -= 256; if (dOff0 < 0) {dOff0 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff1]);   dOff1 -= 256; if (dOff1 < 0) {dOff1 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff0]);   dOff0 -= 256; if (dOff0 < 0) {dOff0 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff1]);   dOff1 -= 256; if (dOff1 < 0) {dOff1 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff0]);   dOff0 -= 256; if (dOff0 < 0) {dOff0 += 1280;}
-        sum64.w64 = MADD64(sum64.w64, *cPtr++, delay[dOff1]);   dOff1 -= 256; if (dOff1 < 0) {dOff1 += 1280;}
-
-        dOff0++;
-        dOff1--;
-        *outbuf = CLIPTOSHORT((sum64.r.hi32 + RND_VAL) >> FBITS_OUT_QMFS);
-        outbuf += nChans;
+    switch (dIdx) {
+        case 0:  QMFSynthesisConvTaps(cPtr, delay, 0, outbuf, nChans); break;
+        case 1:  QMFSynthesisConvTaps(cPtr, delay, 1, outbuf, nChans); break;
+        case 2:  QMFSynthesisConvTaps(cPtr, delay, 2, outbuf, nChans); break;
+        case 3:  QMFSynthesisConvTaps(cPtr, delay, 3, outbuf, nChans); break;
+        case 4:  QMFSynthesisConvTaps(cPtr, delay, 4, outbuf, nChans); break;
+        case 5:  QMFSynthesisConvTaps(cPtr, delay, 5, outbuf, nChans); break;
+        case 6:  QMFSynthesisConvTaps(cPtr, delay, 6, outbuf, nChans); break;
+        case 7:  QMFSynthesisConvTaps(cPtr, delay, 7, outbuf, nChans); break;
+        case 8:  QMFSynthesisConvTaps(cPtr, delay, 8, outbuf, nChans); break;
+        default: QMFSynthesisConvTaps(cPtr, delay, 9, outbuf, nChans); break;
     }
 }
 /***********************************************************************************************************************
@@ -9644,7 +10765,7 @@ void QMFSynthesisConv(int *cPtr, int *delay, int dIdx, short *outbuf, int nChans
  **********************************************************************************************************************/
 void QMFSynthesis(int *inbuf, int *delay, int *delayIdx, int qmfsBands, short *outbuf, int nChans) {
 
-    int n, a0, a1, b0, b1, dOff0, dOff1, dIdx;
+    int n, a0, a1, b0, b1, dIdx;
     int *tBufLo, *tBufHi;
 
     dIdx = *delayIdx;
@@ -9690,24 +10811,8 @@ void QMFSynthesis(int *inbuf, int *delay, int *delayIdx, int qmfsBands, short *o
     FFT32C(tBufLo);
     FFT32C(tBufHi);
 
-    /* 1 GB in, 2 GB out */
-    PostMultiply64(tBufLo, 64);
-    PostMultiply64(tBufHi, 64);
-
-    /* could fuse with PostMultiply64 to avoid separate pass */
-    dOff0 = dIdx*128;
-    dOff1 = dIdx*128 + 64;
-    for (n = 32; n != 0; n--) {
-        a0 =  (*tBufLo++);
-        a1 =  (*tBufLo++);
-        b0 =  (*tBufHi++);
-        b1 = -(*tBufHi++);
-
-        delay[dOff0++] = (b0 - a0);
-        delay[dOff0++] = (b1 - a1);
-        delay[dOff1++] = (b0 + a0);
-        delay[dOff1++] = (b1 + a1);
-    }
+    /* 1 GB in, 2 GB out, with the final butterfly into the delay line */
+    PostMultiply64Synth(tBufLo);
 
     QMFSynthesisConv((int *)cTabS, delay, dIdx, outbuf, nChans);
 
@@ -10100,13 +11205,13 @@ void CopyCouplingInverseFilterMode(int numNoiseFloorBands, uint8_t *modeLeft, ui
 void UnpackSBRSingleChannel(int chBase) {
 
     int bitsLeft;
-    SBRHeader *sbrHdr = &(m_PSInfoSBR->sbrHdr[chBase]);
-    SBRGrid *sbrGridL = &(m_PSInfoSBR->sbrGrid[chBase + 0]);
-    SBRFreq *sbrFreq = &(m_PSInfoSBR->sbrFreq[chBase]);
-    SBRChan *sbrChanL = &(m_PSInfoSBR->sbrChan[chBase + 0]);
+    SBRHeader *sbrHdr = &(m_dec->PSInfoSBR->sbrHdr[chBase]);
+    SBRGrid *sbrGridL = &(m_dec->PSInfoSBR->sbrGrid[chBase + 0]);
+    SBRFreq *sbrFreq = &(m_dec->PSInfoSBR->sbrFreq[chBase]);
+    SBRChan *sbrChanL = &(m_dec->PSInfoSBR->sbrChan[chBase + 0]);
 
-    m_PSInfoSBR->dataExtra = GetBits(1);
-    if(m_PSInfoSBR->dataExtra) m_PSInfoSBR->resBitsData = GetBits(4);
+    m_dec->PSInfoSBR->dataExtra = GetBits(1);
+    if(m_dec->PSInfoSBR->dataExtra) m_dec->PSInfoSBR->resBitsData = GetBits(4);
 
     UnpackSBRGrid(sbrHdr, sbrGridL);
     UnpackDeltaTimeFreq(sbrGridL->numEnv, sbrChanL->deltaFlagEnv, sbrGridL->numNoiseFloors, sbrChanL->deltaFlagNoise);
@@ -10118,18 +11223,32 @@ void UnpackSBRSingleChannel(int chBase) {
     sbrChanL->addHarmonicFlag[1] = GetBits(1);
     UnpackSinusoids(sbrFreq->nHigh, sbrChanL->addHarmonicFlag[1], sbrChanL->addHarmonic[1]);
 
-    m_PSInfoSBR->extendedDataPresent = GetBits(1);
-    if(m_PSInfoSBR->extendedDataPresent) {
-        m_PSInfoSBR->extendedDataSize = GetBits(4);
-        if(m_PSInfoSBR->extendedDataSize == 15) m_PSInfoSBR->extendedDataSize += GetBits(8);
+    m_dec->PSInfoSBR->extendedDataPresent = GetBits(1);
+    if(m_dec->PSInfoSBR->extendedDataPresent) {
+        m_dec->PSInfoSBR->extendedDataSize = GetBits(4);
+        if(m_dec->PSInfoSBR->extendedDataSize == 15) m_dec->PSInfoSBR->extendedDataSize += GetBits(8);
 
-        bitsLeft = 8 * m_PSInfoSBR->extendedDataSize;
+        bitsLeft = 8 * m_dec->PSInfoSBR->extendedDataSize;
 
+#ifdef AAC_ENABLE_PS
+        /* bs_extension_id 2: parametric stereo, the other extensions are skipped with the rest of the data */
+        while(bitsLeft > 7 && m_dec->AACDecInfo->nChans == 1) {
+            bitsLeft -= 2;
+            if(GetBits(2) != EXT_ID_PS) break;
+            bitsLeft -= UnpackPSData(bitsLeft);
+        }
+        while(bitsLeft >= 8) {
+            GetBits(8);
+            bitsLeft -= 8;
+        }
+        GetBits(bitsLeft);
+#else
         /* get ID, unpack extension info, do whatever is necessary with it... */
         while(bitsLeft > 0) {
             GetBits(8);
             bitsLeft -= 8;
         }
+#endif
     }
 }
 /***********************************************************************************************************************
@@ -10147,19 +11266,19 @@ void UnpackSBRSingleChannel(int chBase) {
 void UnpackSBRChannelPair(int chBase) {
 
     int bitsLeft;
-    SBRHeader *sbrHdr = &(m_PSInfoSBR->sbrHdr[chBase]);
-    SBRGrid *sbrGridL = &(m_PSInfoSBR->sbrGrid[chBase + 0]), *sbrGridR = &(m_PSInfoSBR->sbrGrid[chBase + 1]);
-    SBRFreq *sbrFreq = &(m_PSInfoSBR->sbrFreq[chBase]);
-    SBRChan *sbrChanL = &(m_PSInfoSBR->sbrChan[chBase + 0]), *sbrChanR = &(m_PSInfoSBR->sbrChan[chBase + 1]);
+    SBRHeader *sbrHdr = &(m_dec->PSInfoSBR->sbrHdr[chBase]);
+    SBRGrid *sbrGridL = &(m_dec->PSInfoSBR->sbrGrid[chBase + 0]), *sbrGridR = &(m_dec->PSInfoSBR->sbrGrid[chBase + 1]);
+    SBRFreq *sbrFreq = &(m_dec->PSInfoSBR->sbrFreq[chBase]);
+    SBRChan *sbrChanL = &(m_dec->PSInfoSBR->sbrChan[chBase + 0]), *sbrChanR = &(m_dec->PSInfoSBR->sbrChan[chBase + 1]);
 
-    m_PSInfoSBR->dataExtra = GetBits(1);
-    if(m_PSInfoSBR->dataExtra) {
-        m_PSInfoSBR->resBitsData = GetBits(4);
-        m_PSInfoSBR->resBitsData = GetBits(4);
+    m_dec->PSInfoSBR->dataExtra = GetBits(1);
+    if(m_dec->PSInfoSBR->dataExtra) {
+        m_dec->PSInfoSBR->resBitsData = GetBits(4);
+        m_dec->PSInfoSBR->resBitsData = GetBits(4);
     }
 
-    m_PSInfoSBR->couplingFlag = GetBits(1);
-    if(m_PSInfoSBR->couplingFlag) {
+    m_dec->PSInfoSBR->couplingFlag = GetBits(1);
+    if(m_dec->PSInfoSBR->couplingFlag) {
         UnpackSBRGrid(sbrHdr, sbrGridL);
         CopyCouplingGrid(sbrGridL, sbrGridR);
 
@@ -10203,12 +11322,12 @@ void UnpackSBRChannelPair(int chBase) {
     sbrChanR->addHarmonicFlag[1] = GetBits(1);
     UnpackSinusoids(sbrFreq->nHigh, sbrChanR->addHarmonicFlag[1], sbrChanR->addHarmonic[1]);
 
-    m_PSInfoSBR->extendedDataPresent = GetBits(1);
-    if(m_PSInfoSBR->extendedDataPresent) {
-        m_PSInfoSBR->extendedDataSize = GetBits(4);
-        if(m_PSInfoSBR->extendedDataSize == 15) m_PSInfoSBR->extendedDataSize += GetBits(8);
+    m_dec->PSInfoSBR->extendedDataPresent = GetBits(1);
+    if(m_dec->PSInfoSBR->extendedDataPresent) {
+        m_dec->PSInfoSBR->extendedDataSize = GetBits(4);
+        if(m_dec->PSInfoSBR->extendedDataSize == 15) m_dec->PSInfoSBR->extendedDataSize += GetBits(8);
 
-        bitsLeft = 8 * m_PSInfoSBR->extendedDataSize;
+        bitsLeft = 8 * m_dec->PSInfoSBR->extendedDataSize;
 
         /* get ID, unpack extension info, do whatever is necessary with it... */
         while(bitsLeft > 0) {
@@ -10217,3 +11336,480 @@ void UnpackSBRChannelPair(int chBase) {
         }
     }
 }
+
+#ifdef AAC_ENABLE_PS
+/***********************************************************************************************************************
+ * Function:    DecodePSSymbol
+ *
+ * Description: decode one Huffman codeword of the parametric stereo data
+ *
+ * Inputs:      table index in huffTabPSInfo
+ *
+ * Outputs:     bitstream advanced by the length of the codeword
+ *
+ * Return:      decoded value, symbol minus the largest absolute value of the table
+ *
+ * Notes:       the last code of a table is taken if none of the others matches, it ends with all ones
+ **********************************************************************************************************************/
+int DecodePSSymbol(int tab) {
+
+    int i, nCodes, maxBits;
+    uint32_t bits, end;
+    const uint8_t (*code)[2];
+
+    code = huffTabPS + huffTabPSInfo[tab][0];
+    nCodes = huffTabPSInfo[tab][1];
+    maxBits = huffTabPSInfo[tab][2];
+
+    bits = GetBitsNoAdvance(maxBits) << (32 - maxBits);
+    end = 0;
+    for(i = 0; i < nCodes - 1; i++) {
+        end += 1u << (32 - code[i][1]);
+        if(bits < end) break;
+    }
+    AdvanceBitstream(code[i][1]);
+
+    return code[i][0] - huffTabPSInfo[tab][3];
+}
+/***********************************************************************************************************************
+ * Function:    UnpackPSData
+ *
+ * Description: unpack the parametric stereo data of an SBR extension (8.A.1)
+ *
+ * Inputs:      BitStreamInfo struct pointing behind bs_extension_id
+ *              number of bits left in the SBR extension
+ *
+ * Outputs:     updated PSInfoPS struct (header, envelopes and their IID and ICC indices)
+ *
+ * Return:      number of bits used
+ *
+ * Notes:       dt coded parameters refer to the last envelope of the previous frame, so they are unpacked in every
+ *                frame, also while AACSetParametricStereo() has switched PS off
+ *              if the last envelope ends before the frame end, the parameters are held to the end by an additional
+ *                envelope, numEnv == 0 holds those of the previous frame
+ *              on errors PS stops until the next header, the rest of the extension is skipped
+ **********************************************************************************************************************/
+int UnpackPSData(int bitsLeft) {
+
+    int e, b, mode, header, frameClass, dt, val, src, bitsUsed;
+    int8_t *par, *prev;
+    PSInfoPS_t *ps = m_dec->PSInfoPS;
+    int bitsStart = CalcBitsUsed(m_dec->AACDecInfo->fillBuf, 0);
+
+    header = GetBits(1);
+    if(header) {
+        ps->enableIID = GetBits(1);
+        if(ps->enableIID) {
+            mode = GetBits(3);
+            if(mode > 5) goto err;  // reserved
+            ps->nrIIDPar = nrParTabPS[mode];
+            ps->iidQuant = (mode > 2);
+        }
+        ps->enableICC = GetBits(1);
+        if(ps->enableICC) {
+            mode = GetBits(3);
+            if(mode > 5) goto err;
+            ps->nrICCPar = nrParTabPS[mode];
+            ps->iccMixB = (mode > 2);
+        }
+        ps->enableExt = GetBits(1);
+    }
+
+    frameClass = GetBits(1);
+    ps->numEnvPrev = ps->numEnv;
+    ps->numEnv = numEnvTabPS[frameClass][GetBits(2)];
+    ps->borderPos[0] = -1;
+    for(e = 1; e <= ps->numEnv; e++) {
+        if(frameClass) {
+            /* variable borders */
+            ps->borderPos[e] = GetBits(5);
+            if(ps->borderPos[e] < ps->borderPos[e - 1]) goto err;
+        }
+        else {
+            /* fixed borders, 1, 2 or 4 envelopes of equal length */
+            ps->borderPos[e] = (e * 32 / ps->numEnv) - 1;
+        }
+    }
+
+    /* IID (inter-channel intensity difference), absolute value at most 7 (coarse) or 15 (fine) */
+    if(ps->enableIID) {
+        for(e = 0; e < ps->numEnv; e++) {
+            dt = GetBits(1);
+            par = ps->iidPar[e];
+            prev = ps->iidPar[e ? e - 1 : (ps->numEnvPrev > 0 ? ps->numEnvPrev - 1 : 0)];
+            for(b = 0, val = 0; b < ps->nrIIDPar; b++) {
+                val = (dt ? prev[b] : val) + DecodePSSymbol(ps->iidQuant ? (dt ? 1 : 0) : (dt ? 3 : 2));
+                if(val > 7 + 8 * ps->iidQuant || val < -7 - 8 * ps->iidQuant) goto err;
+                par[b] = val;
+            }
+        }
+    }
+    else {
+        memset(ps->iidPar, 0, sizeof(ps->iidPar));
+    }
+
+    /* ICC (inter-channel coherence), 0...7 */
+    if(ps->enableICC) {
+        for(e = 0; e < ps->numEnv; e++) {
+            dt = GetBits(1);
+            par = ps->iccPar[e];
+            prev = ps->iccPar[e ? e - 1 : (ps->numEnvPrev > 0 ? ps->numEnvPrev - 1 : 0)];
+            for(b = 0, val = 0; b < ps->nrICCPar; b++) {
+                val = (dt ? prev[b] : val) + DecodePSSymbol(dt ? 5 : 4);
+                if(val < 0 || val > 7) goto err;
+                par[b] = val;
+            }
+        }
+    }
+    else {
+        memset(ps->iccPar, 0, sizeof(ps->iccPar));
+    }
+
+    /* PS extension, IPD/OPD (inter-channel and overall phase difference) are not used by the baseline decoder */
+    if(ps->enableExt) {
+        val = GetBits(4);
+        if(val == 15) val += GetBits(8);
+        for(val *= 8; val > 0; val -= 8)
+            GetBits(8);
+    }
+
+    /* hold the parameters to the frame end */
+    if(ps->numEnv == 0 || ps->borderPos[ps->numEnv] < 31) {
+        src = ps->numEnv ? ps->numEnv - 1 : ps->numEnvPrev - 1;
+        if(src >= 0 && src != ps->numEnv) {
+            memcpy(ps->iidPar[ps->numEnv], ps->iidPar[src], sizeof(ps->iidPar[0]));
+            memcpy(ps->iccPar[ps->numEnv], ps->iccPar[src], sizeof(ps->iccPar[0]));
+        }
+        for(b = 0; b < ps->nrIIDPar; b++) {
+            if(FASTABS(ps->iidPar[ps->numEnv][b]) > 7 + 8 * ps->iidQuant) goto err;
+        }
+        ps->numEnv++;
+        ps->borderPos[ps->numEnv] = 31;
+    }
+
+    bitsUsed = CalcBitsUsed(m_dec->AACDecInfo->fillBuf, 0) - bitsStart;
+    if(bitsUsed > bitsLeft) goto err;
+    if(header) ps->start = ps->stereo = 1;
+    ps->present = 1;
+    return bitsUsed;
+
+err:
+    ps->start = 0;
+    ps->numEnv = 0;
+    memset(ps->iidPar, 0, sizeof(ps->iidPar));
+    memset(ps->iccPar, 0, sizeof(ps->iccPar));
+    bitsUsed = CalcBitsUsed(m_dec->AACDecInfo->fillBuf, 0) - bitsStart;
+    for(bitsUsed = bitsLeft - bitsUsed; bitsUsed >= 8; bitsUsed -= 8)
+        GetBits(8);
+    if(bitsUsed > 0) GetBits(bitsUsed);
+    return bitsLeft;
+}
+/***********************************************************************************************************************
+ * Function:    MapParPS
+ *
+ * Description: IID or ICC indices of one envelope for the 20 stereo bands
+ *
+ * Inputs:      indices of 10, 20 or 34 parameter bands
+ *
+ * Outputs:     indices of 20 bands
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void MapParPS(int8_t *out, const int8_t *par, int nrPar) {
+
+    int b;
+
+    if(nrPar == 10) {
+        for(b = 0; b < 10; b++)
+            out[2 * b] = out[2 * b + 1] = par[b];
+    }
+    else if(nrPar == 34) {
+        out[ 0] = (2 * par[ 0] + par[ 1]) / 3;
+        out[ 1] = (par[ 1] + 2 * par[ 2]) / 3;
+        out[ 2] = (2 * par[ 3] + par[ 4]) / 3;
+        out[ 3] = (par[ 4] + 2 * par[ 5]) / 3;
+        out[ 4] = (par[ 6] + par[ 7]) / 2;
+        out[ 5] = (par[ 8] + par[ 9]) / 2;
+        out[ 6] = par[10];
+        out[ 7] = par[11];
+        out[ 8] = (par[12] + par[13]) / 2;
+        out[ 9] = (par[14] + par[15]) / 2;
+        out[10] = par[16];
+        out[11] = par[17];
+        out[12] = par[18];
+        out[13] = par[19];
+        out[14] = (par[20] + par[21]) / 2;
+        out[15] = (par[22] + par[23]) / 2;
+        out[16] = (par[24] + par[25]) / 2;
+        out[17] = (par[26] + par[27]) / 2;
+        out[18] = (par[28] + par[29] + par[30] + par[31]) / 4;
+        out[19] = (par[32] + par[33]) / 2;
+    }
+    else {
+        memcpy(out, par, 20);
+    }
+}
+/***********************************************************************************************************************
+ * Function:    HybridAnalysisPS
+ *
+ * Description: split QMF band 0 into 6 and the bands 1 and 2 into 2 sub-subbands (8.6.4.3)
+ *
+ * Inputs:      slot (range = [0, 31]), hybIn of the frame
+ *
+ * Outputs:     10 complex sub-subband samples, format = Q(FBITS_IN_QMFS)
+ *
+ * Return:      none
+ *
+ * Notes:       the 13 tap filters look 6 slots ahead, the SBR delay of HF_GEN - HF_ADJ slots provides them
+ *              band 0 is filtered into 8 bands, 2 + 5 and 3 + 4 are combined
+ **********************************************************************************************************************/
+void HybridAnalysisPS(int n, int (*out)[2]) {
+
+    int q, j, re, im;
+    int t[8][2];
+    int (*x)[2];
+    const int *f;
+
+    x = m_dec->PSInfoPS->hybIn[0] + n;
+    for(q = 0; q < 8; q++) {
+        f = (const int *)hybFilt8PS[q][0];
+        re = MULSHIFT32(f[12], x[6][0]);
+        im = MULSHIFT32(f[12], x[6][1]);
+        for(j = 0; j < 6; j++, f += 2) {
+            /* taps 12 - j are the complex conjugates of taps j */
+            re += MULSHIFT32(f[0], x[j][0] + x[12 - j][0]) - MULSHIFT32(f[1], x[j][1] - x[12 - j][1]);
+            im += MULSHIFT32(f[0], x[j][1] + x[12 - j][1]) + MULSHIFT32(f[1], x[j][0] - x[12 - j][0]);
+        }
+        t[q][0] = re;
+        t[q][1] = im;
+    }
+    for(j = 0; j < 2; j++) {
+        out[0][j] = t[6][j] << 1;
+        out[1][j] = t[7][j] << 1;
+        out[2][j] = t[0][j] << 1;
+        out[3][j] = t[1][j] << 1;
+        out[4][j] = (t[2][j] + t[5][j]) << 1;
+        out[5][j] = (t[3][j] + t[4][j]) << 1;
+    }
+
+    for(q = 1; q < 3; q++) {
+        x = m_dec->PSInfoPS->hybIn[q] + n;
+        for(j = 0; j < 2; j++) {
+            re = x[6][j] >> 1;
+            im = (MULSHIFT32((int)hybFilt2PS[0], x[1][j] + x[11][j]) + MULSHIFT32((int)hybFilt2PS[1], x[3][j] + x[9][j])
+                  + MULSHIFT32((int)hybFilt2PS[2], x[5][j] + x[7][j])) << 1;
+            /* the upper half of band 1 is the mirror image of the lower one */
+            out[4 + 2 * q][j] = (q == 1 ? re - im : re + im);
+            out[5 + 2 * q][j] = (q == 1 ? re + im : re - im);
+        }
+    }
+}
+/***********************************************************************************************************************
+ * Function:    MixSlotPS
+ *
+ * Description: stereo signal of one slot: transient detection, decorrelation and mixing (8.6.4.4 - 8.6.4.6)
+ *
+ * Inputs:      slot (range = [0, 31]), QMF bands of the slot, QMF bands that keep their decorrelator state
+ *              XBuf, hybIn and mixing matrix of the slot
+ *
+ * Outputs:     outL, outR, updated decorrelator state
+ *
+ * Return:      none
+ *
+ * Notes:       the allpass chain runs on half the input scale, the outputs are clipped to MIN_GBITS_IN_QMFS guard bits
+ **********************************************************************************************************************/
+void MixSlotPS(int n, int top, int kEnd) {
+
+    static const int zero[2] = {0, 0};
+    static const uint8_t apBase[3] = {0, 3, 7}, apLen[3] = {3, 4, 5};
+    PSInfoPS_t *ps = m_dec->PSInfoPS;
+    int (*X)[2] = m_dec->PSInfoSBRQMF->XBuf[n + HF_ADJ];
+    int hyb[10][2], mixL[10][2], mixR[10][2];
+    int gain[20];
+    uint64_t power[20], peak;
+    int64_t denom;
+    int k, b, m, j, sh, ag, inRe, inIm, tRe, tIm, dRe, dIm, lRe, lIm, rRe, rIm;
+    int *dl, *ap, *h;
+    const int *x, *phi, *qf;
+
+    HybridAnalysisPS(n, hyb);
+
+    /* transient detection per stereo band, 8.6.4.5.2 */
+    memset(power, 0, sizeof(power));
+    for(k = 0; k < NUM_HYBRID_BANDS - 64 + top; k++) {
+        x = (k < 10 ? hyb[k] : X[k - 7]);
+        power[bandMapPS[k]] += (uint64_t)((int64_t)(x[0] >> 4) * (x[0] >> 4) + (int64_t)(x[1] >> 4) * (x[1] >> 4));
+    }
+    for(b = 0; b < 20; b++) {
+        peak = (ps->peakDecayNrg[b] >> 15) * 25098;     /* decay 0.76592833836465, Q15 */
+        if(peak < power[b]) peak = power[b];
+        ps->peakDecayNrg[b] = peak;
+        ps->powerSmooth[b] += ((int64_t)power[b] - ps->powerSmooth[b]) >> 2;
+        ps->peakDiffSmooth[b] += ((int64_t)(peak - power[b]) - ps->peakDiffSmooth[b]) >> 2;
+        denom = ps->peakDiffSmooth[b] + (ps->peakDiffSmooth[b] >> 1);
+        if(denom > ps->powerSmooth[b]) {
+            /* gain = powerSmooth / (1.5 * peakDiffSmooth), Q15 quotient of 16 bit values */
+            sh = 48 - __builtin_clzll(denom);
+            if(sh < 0) sh = 0;
+            gain[b] = (int)((((uint32_t)(ps->powerSmooth[b] >> sh)) << 15) / (uint32_t)(denom >> sh)) << 16;
+        }
+        else {
+            gain[b] = 0x7fffffff;
+        }
+    }
+
+    for(k = 0; k < kEnd; k++) {
+        x = (k < 10 ? hyb[k] : (k - 7 < top ? X[k - 7] : zero));
+        b = bandMapPS[k];
+
+        /* decorrelation 8.6.4.5.3: fractional delay and 3 allpass links below NUM_ALLPASS_BANDS, plain delays above */
+        if(k < NUM_ALLPASS_BANDS) {
+            dl = ps->delay2[ps->idx2][k];
+            phi = (const int *)phiFractPS[k];
+            inRe = MULSHIFT32(dl[0], phi[0]) - MULSHIFT32(dl[1], phi[1]);
+            inIm = MULSHIFT32(dl[0], phi[1]) + MULSHIFT32(dl[1], phi[0]);
+            dl[0] = x[0];
+            dl[1] = x[1];
+            for(m = 0; m < 3; m++) {
+                ap = ps->apDelay[apBase[m] + ps->apIdx[m]][k];
+                qf = (const int *)qFractPS[k][m];
+                ag = apGainPS[k][m];
+                tRe = ((MULSHIFT32(ap[0], qf[0]) - MULSHIFT32(ap[1], qf[1])) << 1) - (MULSHIFT32(ag, inRe) << 1);
+                tIm = ((MULSHIFT32(ap[0], qf[1]) + MULSHIFT32(ap[1], qf[0])) << 1) - (MULSHIFT32(ag, inIm) << 1);
+                ap[0] = inRe + (MULSHIFT32(ag, tRe) << 1);
+                ap[1] = inIm + (MULSHIFT32(ag, tIm) << 1);
+                inRe = tRe;
+                inIm = tIm;
+            }
+            dRe = MULSHIFT32(gain[b], inRe) << 2;
+            dIm = MULSHIFT32(gain[b], inIm) << 2;
+        }
+        else {
+            dl = (k < SHORT_DELAY_BAND ? ps->delay14[ps->idx14][k - NUM_ALLPASS_BANDS] : ps->delay1[k - SHORT_DELAY_BAND]);
+            dRe = MULSHIFT32(gain[b], dl[0]) << 1;
+            dIm = MULSHIFT32(gain[b], dl[1]) << 1;
+            dl[0] = x[0];
+            dl[1] = x[1];
+        }
+
+        /* mixing 8.6.4.6, h11 h12 h21 h22 are Q30 */
+        h = ps->hCur[b];
+        lRe = CLIP_2N(MULSHIFT32(h[0], x[0]) + MULSHIFT32(h[2], dRe), 31 - 2 - MIN_GBITS_IN_QMFS) << 2;
+        lIm = CLIP_2N(MULSHIFT32(h[0], x[1]) + MULSHIFT32(h[2], dIm), 31 - 2 - MIN_GBITS_IN_QMFS) << 2;
+        rRe = CLIP_2N(MULSHIFT32(h[1], x[0]) + MULSHIFT32(h[3], dRe), 31 - 2 - MIN_GBITS_IN_QMFS) << 2;
+        rIm = CLIP_2N(MULSHIFT32(h[1], x[1]) + MULSHIFT32(h[3], dIm), 31 - 2 - MIN_GBITS_IN_QMFS) << 2;
+        if(k < 10) {
+            mixL[k][0] = lRe; mixL[k][1] = lIm;
+            mixR[k][0] = rRe; mixR[k][1] = rIm;
+        }
+        else {
+            ps->outL[k - 7][0] = lRe; ps->outL[k - 7][1] = lIm;
+            ps->outR[k - 7][0] = rRe; ps->outR[k - 7][1] = rIm;
+        }
+    }
+
+    /* hybrid synthesis: sum of the sub-subbands */
+    for(j = 0; j < 2; j++) {
+        ps->outL[0][j] = CLIP_2N((int)(((int64_t)mixL[0][j] + mixL[1][j] + mixL[2][j] + mixL[3][j] + mixL[4][j] +
+                                         mixL[5][j]) >> 2), 31 - 2 - MIN_GBITS_IN_QMFS) << 2;
+        ps->outR[0][j] = CLIP_2N((int)(((int64_t)mixR[0][j] + mixR[1][j] + mixR[2][j] + mixR[3][j] + mixR[4][j] +
+                                         mixR[5][j]) >> 2), 31 - 2 - MIN_GBITS_IN_QMFS) << 2;
+        ps->outL[1][j] = CLIP_2N((mixL[6][j] >> 1) + (mixL[7][j] >> 1), 31 - 1 - MIN_GBITS_IN_QMFS) << 1;
+        ps->outR[1][j] = CLIP_2N((mixR[6][j] >> 1) + (mixR[7][j] >> 1), 31 - 1 - MIN_GBITS_IN_QMFS) << 1;
+        ps->outL[2][j] = CLIP_2N((mixL[8][j] >> 1) + (mixL[9][j] >> 1), 31 - 1 - MIN_GBITS_IN_QMFS) << 1;
+        ps->outR[2][j] = CLIP_2N((mixR[8][j] >> 1) + (mixR[9][j] >> 1), 31 - 1 - MIN_GBITS_IN_QMFS) << 1;
+    }
+
+    ps->idx2 ^= 1;
+    ps->idx14 = (ps->idx14 == 13 ? 0 : ps->idx14 + 1);
+    for(m = 0; m < 3; m++)
+        ps->apIdx[m] = (ps->apIdx[m] == apLen[m] - 1 ? 0 : ps->apIdx[m] + 1);
+}
+/***********************************************************************************************************************
+ * Function:    ApplyPS
+ *
+ * Description: parametric stereo of one frame, replaces the QMF synthesis of the mono channel
+ *
+ * Inputs:      SBRGrid and SBRFreq of the channel, XBuf after HF adjustment, PSInfoPS struct with the envelopes
+ *
+ * Outputs:     2048 stereo samples of 16-bit PCM, interleaved LRLR...
+ *
+ * Return:      none
+ *
+ * Notes:       the mixing matrix is interpolated over the slots of each envelope, starting from the last one of the
+ *                previous frame. A frame without PS data repeats the parameters of the last envelope
+ *              the slots before the first SBR envelope use the previous frequency range like the mono synthesis
+ **********************************************************************************************************************/
+void ApplyPS(SBRGrid *sbrGrid, SBRFreq *sbrFreq, short *outbuf) {
+
+    int b, e, j, k, l, n, width, top, topPrev, kEnd;
+    int8_t iid[20], icc[20];
+    int hEnd[20][4];
+    const int16_t (*mix)[8][4];
+    PSInfoPS_t *ps = m_dec->PSInfoPS;
+
+    if(!ps->present) {
+        /* hold the last envelope of the previous frame */
+        ps->numEnvPrev = ps->numEnv;
+        memcpy(ps->iidPar[0], ps->iidPar[ps->numEnv - 1], sizeof(ps->iidPar[0]));
+        memcpy(ps->iccPar[0], ps->iccPar[ps->numEnv - 1], sizeof(ps->iccPar[0]));
+        ps->numEnv = 1;
+        ps->borderPos[1] = 31;
+    }
+    ps->present = 0;
+
+    /* hybrid analysis input: slots -6...37 of the QMF bands 0...2 */
+    for(b = 0; b < 3; b++) {
+        memmove(ps->hybIn[b][0], ps->hybIn[b][32], 6 * sizeof(ps->hybIn[b][0]));
+        for(l = 0; l < 38; l++) {
+            ps->hybIn[b][l + 6][0] = m_dec->PSInfoSBRQMF->XBuf[l + HF_ADJ][b][0];
+            ps->hybIn[b][l + 6][1] = m_dec->PSInfoSBRQMF->XBuf[l + HF_ADJ][b][1];
+        }
+    }
+
+    /* clear the decorrelator above the SBR range of this frame */
+    top = sbrFreq->kStart + sbrFreq->numQMFBands;
+    topPrev = sbrFreq->kStartPrev + sbrFreq->numQMFBandsPrev;
+    kEnd = NUM_HYBRID_BANDS - 64 + top;
+    for(k = kEnd; k < NUM_HYBRID_BANDS; k++) {
+        if(k < NUM_ALLPASS_BANDS) {
+            for(j = 0; j < 2; j++) ps->delay2[j][k][0] = ps->delay2[j][k][1] = 0;
+            for(j = 0; j < 12; j++) ps->apDelay[j][k][0] = ps->apDelay[j][k][1] = 0;
+        }
+        else if(k < SHORT_DELAY_BAND) {
+            for(j = 0; j < 14; j++) ps->delay14[j][k - NUM_ALLPASS_BANDS][0] = ps->delay14[j][k - NUM_ALLPASS_BANDS][1] = 0;
+        }
+        else {
+            ps->delay1[k - SHORT_DELAY_BAND][0] = ps->delay1[k - SHORT_DELAY_BAND][1] = 0;
+        }
+    }
+    if(topPrev > top) kEnd = NUM_HYBRID_BANDS - 64 + topPrev;
+
+    mix = (ps->iccMixB ? mixTabPSB : mixTabPSA) + 23 * ps->iidQuant + 7;
+    n = 0;
+    for(e = 0; e < ps->numEnv; e++) {
+        MapParPS(iid, ps->iidPar[e], ps->nrIIDPar);
+        MapParPS(icc, ps->iccPar[e], ps->nrICCPar);
+        width = ps->borderPos[e + 1] - ps->borderPos[e];
+        for(b = 0; b < 20; b++) {
+            for(j = 0; j < 4; j++) {
+                hEnd[b][j] = mix[iid[b]][icc[b]][j] << 16;
+                ps->hStep[b][j] = (width ? (hEnd[b][j] - ps->hCur[b][j]) / width : 0);
+            }
+        }
+        for(; n <= ps->borderPos[e + 1]; n++) {
+            for(b = 0; b < 20; b++) {
+                for(j = 0; j < 4; j++) ps->hCur[b][j] += ps->hStep[b][j];
+            }
+            l = (n < sbrGrid->envTimeBorder[0] ? topPrev : top);
+            MixSlotPS(n, l, kEnd);
+            QMFSynthesis(ps->outL[0], m_dec->PSInfoSBRQMF->delayQMFS[0], &(m_dec->PSInfoSBR->delayIdxQMFS[0]), l,
+                    outbuf + 128 * n, 2);
+            QMFSynthesis(ps->outR[0], m_dec->PSInfoSBRQMF->delayQMFS[1], &(m_dec->PSInfoSBR->delayIdxQMFS[1]), l,
+                    outbuf + 128 * n + 1, 2);
+        }
+        memcpy(ps->hCur, hEnd, sizeof(hEnd));
+    }
+    ps->stereoOut = 1;
+}
+#endif /* AAC_ENABLE_PS */
@@ -10,6 +10,43 @@
 #if (defined CONFIG_IDF_TARGET_ESP32S3 && defined BOARD_HAS_PSRAM)
     #define AAC_ENABLE_SBR  // needs additional 60KB DRAM,
 #endif
+#if (defined AAC_ENABLE_SBR && !defined AAC_DISABLE_PS)
+    #define AAC_ENABLE_PS   // parametric stereo of HE-AACv2 streams, needs additional 8.3KB and about 80% more CPU
+                            // than the mono stream, define AAC_DISABLE_PS on units that should play these streams
+                            // in mono, see also AACSetParametricStereo()
+#endif
+
+//#define AAC_PROFILE               // log the CPU cycles per frame and per stage (noiseless decoding + dequantization,
+                                    // PNS/TNS/IMDCT, SBR and its QMF analysis, HF generation/adjustment, QMF
+                                    // synthesis) together with AAC_PLACEMENT every 256 frames
+
+/* placement of the hot code and data, trades internal RAM for speed
+ *   0: all buffers follow the chip default (PSRAM first on ESP32-S3), code and tables stay in flash
+ *   1: PSInfoBase (19172 bytes: coefficients, overlap, TNS/PNS state) and PSInfoSBRQMF (33280 bytes: QMF delay lines
+ *      and XBuf, only with AAC_ENABLE_SBR) are taken from internal RAM if possible
+ *   2: as 1, additionally PSInfoSBR (18024 bytes) goes to internal RAM first, the FFT/DCT4 kernels, window overlap,
+ *      spectral Huffman decoding, dequantizer, the SBR QMF kernels and covariance kernels run from IRAM (about 14KB),
+ *      the spectral Huffman, bit reverse and pow43 tables are held in DRAM (about 3.4KB). The transform twiddles and
+ *      windows (~20KB) are read sequentially and stay in flash
+ * the hot set was taken from AAC_PROFILE builds and a function profile of LC streams, share of a frame mono...stereo:
+ * noiseless decoding + dequantization 59...47% (Huffman, unpack, dequant), PNS/TNS/IMDCT 40...46% (R4Core, pre/post
+ * multiply, window overlap). With SBR the QMF analysis and synthesis are touched 32 times per frame and channel,
+ * they take most of the SBR time, followed by the HF generator (covariance + LPC)
+ */
+/* decode quality, see AACSetQuality() */
+enum : uint8_t {AAC_QUALITY_FULL = 0,       // HE-AAC streams are decoded with SBR at twice the core rate
+                AAC_QUALITY_CORE = 1};      // SBR is bypassed, the AAC core is played at its own rate
+
+#ifndef AAC_PLACEMENT
+    #define AAC_PLACEMENT 1
+#endif
+#if AAC_PLACEMENT >= 2
+    #define AAC_IRAM IRAM_ATTR
+    #define AAC_DRAM DRAM_ATTR
+#else
+    #define AAC_IRAM
+    #define AAC_DRAM
+#endif
 
 #define ASSERT(x) /* do nothing */
 
@@ -422,18 +459,96 @@ typedef struct _PSInfoSBR {
     int      gFiltLast[48];
     int      qFiltLast[48];
 
+    int      lpCoefs[32][4];         // a0re, a0im, a1re, a1im of the low bands, valid if bit p of lpCoefsValid is set
+    uint32_t lpCoefsValid;           // cleared per channel in GenerateHighFreq()
+
     /* large buffers */
     int      delayIdxQMFA[2];        // [AAC_MAX_NCHANS]
-    int      delayQMFA[2][10 * 32];  // [AAC_MAX_NCHANS][DELAY_SAMPS_QMFA]
     int      delayIdxQMFS[2];        // [AAC_MAX_NCHANS]
-    int      delayQMFS[2][10 * 128]; // [AAC_MAX_NCHANS][DELAY_SAMPS_QMFS]
     int      XBufDelay[2][8][64][2]; // [AAC_MAX_NCHANS][HF_GEN][64][2]
-    int      XBuf[32+8][64][2];
 } PSInfoSBR_t;
 
+/* the buffers touched on every QMF slot, kept apart from PSInfoSBR_t so they can be placed in internal RAM on their
+ * own (see AAC_PLACEMENT), the rest of the SBR state is read a few times per frame only
+ */
+typedef struct _PSInfoSBRQMF {
+    int      delayQMFS[2][10 * 128]; // [AAC_MAX_NCHANS][DELAY_SAMPS_QMFS]
+    int      XBuf[32+8][64][2];
+    int      delayQMFA[2][10 * 32];  // [AAC_MAX_NCHANS][DELAY_SAMPS_QMFA]
+} PSInfoSBRQMF_t;
+
+/* parametric stereo (HE-AACv2) of a mono SBR stream, baseline decoder with 20 stereo bands (ISO/IEC 14496-3 8.6.4)
+ * the parameters of 34 band streams are mapped to 20 bands, IPD/OPD are skipped.
+ * 8504 bytes, most of it the delay lines of the decorrelator (4.8KB) and the hybrid filter input (1KB)
+ */
+typedef struct _PSInfoPS {
+    uint8_t  start;                  // a PS header was received, PS is applied until an error
+    uint8_t  stereo;                 // a PS header was received since the stream began, AACOutChannels() is 2
+    uint8_t  present;                // PS data in the current frame
+    uint8_t  stereoOut;              // ApplyPS() has written the current frame
+    uint8_t  enableIID, enableICC, enableExt;
+    uint8_t  iidQuant;               // fine IID quantization (iid_mode 3...5)
+    uint8_t  iccMixB;                // mixing procedure B (icc_mode 3...5)
+    uint8_t  nrIIDPar, nrICCPar;     // parameter bands 10, 20 or 34
+    int8_t   numEnv, numEnvPrev;     // envelopes including the one added to reach the frame end
+    int8_t   borderPos[6];           // last slot of envelope e is borderPos[e + 1], borderPos[0] = -1
+    int8_t   iidPar[5][34];          // [envelope][parameter band], the last envelope of a frame is the dt reference
+    int8_t   iccPar[5][34];
+    int      hybIn[3][44][2];        // QMF bands 0...2 from slot -6 to 37, input of the hybrid analysis
+    int      hCur[20][4];            // mixing matrix h11, h12, h21, h22 per stereo band, Q30, interpolated per slot
+    int      hStep[20][4];
+    uint64_t peakDecayNrg[20];       // transient detector per stereo band
+    int64_t  powerSmooth[20];
+    int64_t  peakDiffSmooth[20];
+    int      delay2[2][30][2];       // decorrelator input delays: allpass bands, 14 slots, 1 slot
+    int      delay14[14][12][2];
+    int      delay1[29][2];
+    int      apDelay[12][30][2];     // allpass links of 3, 4 and 5 slots, one after the other
+    uint8_t  idx2, idx14, apIdx[3];  // ring buffer positions
+    int      outL[64][2];            // QMF input of the synthesis of one slot
+    int      outR[64][2];
+} PSInfoPS_t;
+
+/* all state of one decoder instance, created by AACDecoder_Create()
+ * cost per context on ESP32: 72104 bytes, PSInfoSBRQMF 33280, PSInfoBase 19172, PSInfoSBR 18024, pce 1312, the
+ * context itself 220, AACDecInfo 96, with AAC_ENABLE_PS 8504 bytes PSInfoPS more. Without AAC_ENABLE_SBR 20800 bytes
+ * plus once for all contexts 11264 bytes fast spectral Huffman tables (11 tables of 2^HUFF_FAST_BITS entries)
+ */
+typedef struct AACDecoder {
+    PSInfoBase_t        *PSInfoBase;
+    AACDecInfo_t        *AACDecInfo;
+    AACFrameInfo_t       AACFrameInfo;
+    ADTSHeader_t         fhADTS;
+    ADIFHeader_t         fhADIF;
+    ProgConfigElement_t *pce[16];       // pce[i] points into one block of 16 elements
+    PulseInfo_t          pulseInfo[2];  // [MAX_NCHANS_ELEM]
+    aac_BitStreamInfo_t  aac_BitStreamInfo;
+    PSInfoSBR_t         *PSInfoSBR;     // NULL without AAC_ENABLE_SBR
+    PSInfoSBRQMF_t      *PSInfoSBRQMF;  // NULL without AAC_ENABLE_SBR
+    PSInfoPS_t          *PSInfoPS;      // NULL without AAC_ENABLE_PS
+    bool                 huffFastRef;   // holds a reference to the shared fast Huffman tables
+    bool                 downmix;       // mono output requested, see AACSetDownmix()
+    bool                 monoActive;    // channel pair is transformed once, overlap[0] holds the mix
+    bool                 monoSplit;     // overlaps still per channel, merged as soon as both use the same window
+    uint8_t              quality;       // AAC_QUALITY_xxx, see AACSetQuality()
+    bool                 psOff;         // parametric stereo switched off, see AACSetParametricStereo()
+#ifdef AAC_PROFILE
+    uint32_t             profFrames;
+    uint64_t             profCycles;    // sums over profFrames frames
+    uint64_t             profNoiseless;
+    uint64_t             profImdct;
+    uint64_t             profSBR;
+    uint64_t             profQMFA;      // parts of profSBR
+    uint64_t             profHF;
+    uint64_t             profQMFS;
+#endif
+} AACDecoder_t;
+
+// prototypes, the functions without decoder context work on a default instance
 bool AACDecoder_AllocateBuffers(void);
 int AACFlushCodec();
 void AACDecoder_FreeBuffers(void);
+size_t AACDecoder_BufferSize(void); // bytes AACDecoder_AllocateBuffers() takes from the arena
 bool AACDecoder_IsInit(void);
 int AACFindSyncWord(uint8_t *buf, int nBytes);
 int AACSetRawBlockParams(int copyLast, int nChans, int sampRateCore, int profile);
@@ -446,7 +561,29 @@ uint8_t AACGetFormat(); // 0-unknown 1-ADTS 2-ADIF, 3-RAW
 int AACGetBitsPerSample();
 int AACGetBitrate();
 int AACGetOutputSamps();
-int AACGetBitrate();
+void AACSetDownmix(bool mono);
+void AACSetQuality(uint8_t level);
+void AACSetParametricStereo(bool enable);
+
+// reentrant API, every context decodes its own stream
+AACDecoder_t* AACDecoder_Create(void);
+void AACDecoder_Destroy(AACDecoder_t *dec);
+void AACDecoder_ClearBuffer(AACDecoder_t *dec);
+int AACFlushCodec(AACDecoder_t *dec);
+int AACSetRawBlockParams(AACDecoder_t *dec, int copyLast, int nChans, int sampRateCore, int profile);
+int AACDecode(AACDecoder_t *dec, uint8_t *inbuf, int *bytesLeft, short *outbuf);
+int AACGetSampRate(AACDecoder_t *dec);
+int AACGetChannels(AACDecoder_t *dec);
+int AACGetID(AACDecoder_t *dec);
+uint8_t AACGetProfile(AACDecoder_t *dec);
+uint8_t AACGetFormat(AACDecoder_t *dec);
+int AACGetBitrate(AACDecoder_t *dec);
+int AACGetOutputSamps(AACDecoder_t *dec);
+void AACSetDownmix(AACDecoder_t *dec, bool mono);
+void AACSetQuality(AACDecoder_t *dec, uint8_t level);
+void AACSetParametricStereo(AACDecoder_t *dec, bool enable);
+
+//internally used
 void DecodeLPCCoefs(int order, int res, int8_t *filtCoef, int *a, int *b);
 int FilterRegion(int size, int dir, int order, int *audioCoef, int *a, int *hist);
 int TNSFilter(int ch);
@@ -468,6 +605,8 @@ void R8FirstPass(int *x, int bg);
 void R4Core(int *x, int bg, int gp, int *wtab);
 void R4FFT(int tabidx, int *x);
 void UnpackZeros(int nVals, int *coef);
+bool AACInitHuffFastTables();
+void AACFreeHuffFastTables();
 void UnpackQuads(int cb, int nVals, int *coef);
 void UnpackPairsNoEsc(int cb, int nVals, int *coef);
 void UnpackPairsEsc(int cb, int nVals, int *coef);
@@ -478,6 +617,8 @@ void DecWindowOverlapLongStart(int *buf0, int *over0, short *pcm0, int nChans, i
 void DecWindowOverlapLongStop(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev);
 void DecWindowOverlapShort(int *buf0, int *over0, short *pcm0, int nChans, int winTypeCurr, int winTypePrev);
 int IMDCT(int ch, int chOut, short *outbuf);
+bool AACDownmixActive();
+int AACDownmixIMDCT(short *outbuf);
 void DecodeICSInfo(ICSInfo_t *icsInfo, int sampRateIdx);
 void DecodeSectionData(int winSequence, int numWinGrp, int maxSFB, uint8_t *sfbCodeBook);
 int DecodeOneScaleFactor();
@@ -511,7 +652,6 @@ int StereoProcess();
 int RatioPowInv(int a, int b, int c);
 int SqrtFix(int q, int fBitsIn, int *fBitsOut);
 int InvRNormalized(int r);
-void BitReverse32(int *inout);
 void R8FirstPass32(int *r0);
 void R4Core32(int *r0);
 void FFT32C(int *x);
@@ -526,6 +666,7 @@ int CalcBitsUsed(uint8_t *startBuf, int startOffset);
 void ByteAlignBitstream();
 // SBR
 void InitSBRState();
+bool AACSBRActive(AACDecoder_t *dec);
 int DecodeSBRBitstream(int chBase);
 int DecodeSBRData(int chBase, short *outbuf);
 int FlushCodecSBR();
@@ -571,6 +712,7 @@ void DecWindowOverlapLongStopNoClip(int *buf0, int *over0, int *out0, int winTyp
 void DecWindowOverlapShortNoClip(int *buf0, int *over0, int *out0, int winTypeCurr, int winTypePrev);
 void PreMultiply64(int *zbuf1);
 void PostMultiply64(int *fft1, int nSampsOut);
+void PostMultiply64Synth(int *fft1);
 void QMFAnalysisConv(int *cTab, int *delay, int dIdx, int *uBuf);
 int QMFAnalysis(int *inbuf, int *delay, int *XBuf, int fBitsIn, int *delayIdx, int qmfaBands);
 void QMFSynthesisConv(int *cPtr, int *delay, int dIdx, short *outbuf, int nChans);
@@ -584,3 +726,10 @@ void CopyCouplingGrid(SBRGrid *sbrGridLeft, SBRGrid *sbrGridRight);
 void CopyCouplingInverseFilterMode(int numNoiseFloorBands, uint8_t *modeLeft, uint8_t *modeRight);
 void UnpackSBRSingleChannel(int chBase);
 void UnpackSBRChannelPair(int chBase);
+int AACOutChannels(AACDecoder_t *dec);
+int DecodePSSymbol(int tab);
+int UnpackPSData(int bitsLeft);
+void MapParPS(int8_t *out, const int8_t *par, int nrPar);
+void HybridAnalysisPS(int n, int (*out)[2]);
+void MixSlotPS(int n, int top, int kEnd);
+void ApplyPS(SBRGrid *sbrGrid, SBRFreq *sbrFreq, short *outbuf);
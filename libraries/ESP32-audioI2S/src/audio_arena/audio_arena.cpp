@@ -0,0 +1,140 @@
+/*
+ * audio_arena.cpp
+ *
+ * first fit allocator in one block of internal RAM
+ *
+ * The arena is a chain of blocks without gaps, each with an ARENA_HEADER in front:
+ *   0  size    bytes of the block including the header, a multiple of ARENA_ALIGN
+ *   4  used    0: free
+ * A freed block is merged with the free blocks behind it at once, with the free blocks before it when ArenaMalloc()
+ * or ArenaGetStats() walk past them.
+ *
+ */
+#include "audio_arena.h"
+#include <mutex>
+
+typedef struct ArenaBlock {
+    uint32_t  size;
+    uint32_t  used;
+} ArenaBlock_t;
+
+static uint8_t*  m_mem       = NULL;    // as allocated
+static uint8_t*  m_base      = NULL;    // first block, aligned
+static uint32_t  m_size      = 0;
+static uint32_t  m_used      = 0;
+static uint32_t  m_highWater = 0;
+static uint16_t  m_blocks    = 0;
+static uint32_t  m_misses    = 0;
+static std::mutex m_lock;
+
+static inline ArenaBlock_t* blockAt(uint32_t pos){
+    return (ArenaBlock_t*)(m_base + pos);
+}
+static inline uint32_t blockSize(size_t size){
+    return ((size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1)) + ARENA_HEADER;
+}
+static inline bool toPSRAM(uint32_t caps){
+    return (caps & MALLOC_CAP_SPIRAM) && psramFound();
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void mergeFree(uint32_t pos){
+    // join the free blocks behind the free block at pos
+    ArenaBlock_t* b = blockAt(pos);
+    while(pos + b->size < m_size && !blockAt(pos + b->size)->used) b->size += blockAt(pos + b->size)->size;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ArenaCreate(size_t size){
+    // reserves the arena, as long as the heap is not yet fragmented. Only one arena exists, further calls keep it.
+    std::lock_guard<std::mutex> lock(m_lock);
+    if(m_base) return true;
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    m_mem = (uint8_t*)heap_caps_malloc(size + ARENA_ALIGN, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if(!m_mem){
+        log_w("no internal RAM for an arena of %u bytes, the buffers are allocated on the heap", (unsigned)size);
+        return false;
+    }
+    m_base = (uint8_t*)(((uintptr_t)m_mem + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1));
+    m_size = size;
+    m_used = 0;
+    m_highWater = 0;
+    m_blocks = 0;
+    m_misses = 0;
+    blockAt(0)->size = size;
+    blockAt(0)->used = 0;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ArenaDestroy(){
+    // the arena is kept as long as a block is in use
+    std::lock_guard<std::mutex> lock(m_lock);
+    if(!m_base || m_blocks) return;
+    free(m_mem);
+    m_mem = NULL;
+    m_base = NULL;
+    m_size = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void* ArenaMalloc(size_t size, uint32_t caps, uint32_t fallbackCaps){
+    // a block of the arena, if it has none left or caps prefer PSRAM: heap_caps_malloc_prefer(size, 2, caps,
+    // fallbackCaps)
+    if(toPSRAM(caps)) return heap_caps_malloc_prefer(size, 2, caps, fallbackCaps);
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint32_t need = blockSize(size);
+    for(uint32_t pos = 0; pos < m_size; pos += blockAt(pos)->size){
+        ArenaBlock_t* b = blockAt(pos);
+        if(b->used) continue;
+        mergeFree(pos);
+        if(b->size < need) continue;
+        if(b->size - need >= ARENA_HEADER + ARENA_ALIGN){   // split, the rest stays free
+            blockAt(pos + need)->size = b->size - need;
+            blockAt(pos + need)->used = 0;
+            b->size = need;
+        }
+        b->used = 1;
+        m_used += b->size;
+        m_blocks++;
+        if(m_used > m_highWater) m_highWater = m_used;
+        return (uint8_t*)b + ARENA_HEADER;
+    }
+    if(m_base) m_misses++;
+    return heap_caps_malloc_prefer(size, 2, caps, fallbackCaps);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ArenaFree(void* ptr){
+    // blocks of the arena go back to it, all other pointers to the heap
+    if(!ptr) return;
+    if(!ArenaContains(ptr)) {free(ptr); return;}
+    std::lock_guard<std::mutex> lock(m_lock);
+    uint32_t pos = (uint8_t*)ptr - ARENA_HEADER - m_base;
+    ArenaBlock_t* b = blockAt(pos);
+    b->used = 0;
+    m_used -= b->size;
+    m_blocks--;
+    mergeFree(pos);
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool ArenaContains(const void* ptr){
+    return m_base && (const uint8_t*)ptr >= m_base && (const uint8_t*)ptr < m_base + m_size;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t ArenaBlockSize(size_t size, uint32_t caps, uint32_t fallbackCaps){
+    // bytes of the arena ArenaMalloc(size, caps, fallbackCaps) takes, 0 if it goes to PSRAM. To size the arena from
+    // the buffers of the decoders
+    (void)fallbackCaps;
+    return toPSRAM(caps) ? 0 : blockSize(size);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ArenaGetStats(ArenaStats_t* st){
+    std::lock_guard<std::mutex> lock(m_lock);
+    st->size        = m_size;
+    st->used        = m_used;
+    st->highWater   = m_highWater;
+    st->largestFree = 0;
+    st->blocks      = m_blocks;
+    st->misses      = m_misses;
+    for(uint32_t pos = 0; pos < m_size; pos += blockAt(pos)->size){
+        if(blockAt(pos)->used) continue;
+        mergeFree(pos);
+        if(blockAt(pos)->size - ARENA_HEADER > st->largestFree) st->largestFree = blockAt(pos)->size - ARENA_HEADER;
+    }
+}
@@ -0,0 +1,43 @@
+/*
+ * audio_arena.h
+ *
+ * one block of internal RAM for the decoder and pipeline buffers, reserved once when the Audio object is created
+ *
+ *  The decoders take their buffers with ArenaMalloc() and give them back with ArenaFree(). Blocks are taken first fit
+ *  and merged with free neighbours when they come back, so the next codec reuses the space of the one before and the
+ *  heap sees no allocation on a station change. What does not fit (a second decoder context, a FLAC stream with big
+ *  blocks) is taken from the heap as before and counted as a miss. Blocks whose caps prefer PSRAM are taken from the
+ *  heap (PSRAM) if there is one, the arena holds only what has to be in internal RAM and is sized for that with the
+ *  same caps (ArenaBlockSize).
+ *
+ *  Restrictions:
+ *  the calls are serialized by a mutex, Audio instances on different tasks share the arena
+ *
+ */
+#pragma once
+
+#include "Arduino.h"
+
+#define ARENA_ALIGN     8       // every block is 8 byte aligned
+#define ARENA_HEADER    8       // bytes in front of each block
+
+// caps, fallbackCaps of ArenaMalloc() and ArenaBlockSize()
+#define ARENA_PREFER_PSRAM      MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM,   MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL
+#define ARENA_PREFER_INTERNAL   MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM
+
+typedef struct ArenaStats {
+    uint32_t  size;             // bytes of the arena, 0: there is none, all buffers are on the heap
+    uint32_t  used;             // bytes in blocks including their headers
+    uint32_t  highWater;        // most bytes used since ArenaCreate()
+    uint32_t  largestFree;      // biggest block ArenaMalloc() can carve now
+    uint16_t  blocks;           // allocated blocks
+    uint32_t  misses;           // allocations that went to the heap because the arena was full
+} ArenaStats_t;
+
+bool     ArenaCreate(size_t size);
+void     ArenaDestroy();
+void*    ArenaMalloc(size_t size, uint32_t caps, uint32_t fallbackCaps);
+void     ArenaFree(void* ptr);
+bool     ArenaContains(const void* ptr);
+size_t   ArenaBlockSize(size_t size, uint32_t caps, uint32_t fallbackCaps);
+void     ArenaGetStats(ArenaStats_t* st);
@@ -0,0 +1,30 @@
+/*
+ * audio_sync.h
+ *
+ * helpers for the sync word search of the decoders
+ *
+ *  MP3FindSyncWord(), AACFindSyncWord() and FLACFindSyncWord() look for candidates with FindFFByte(), every sync word
+ *  of these formats begins with a 0xFF byte. The frame header checks that follow are codec specific.
+ *
+ */
+#pragma once
+
+#include "Arduino.h"
+
+/* index of the first 0xFF byte in buf[i...nBytes-1], -1 if there is none. Four bytes are tested at once. */
+static inline int FindFFByte(const uint8_t *buf, int i, int nBytes) {
+    uint32_t w;
+    while(i < nBytes && ((uintptr_t)(buf + i) & 0x03)) {   // up to the next word boundary
+        if(buf[i] == 0xFF) return i;
+        i++;
+    }
+    for(; i + 4 <= nBytes; i += 4) {
+        memcpy(&w, buf + i, 4);
+        w = ~w;                                              // 0xFF bytes become 0x00
+        if((w - 0x01010101) & ~w & 0x80808080) break;      // at least one zero byte in w
+    }
+    for(; i < nBytes; i++) {
+        if(buf[i] == 0xFF) return i;
+    }
+    return -1;
+}
@@ -11,79 +11,144 @@
  *
  */
 #include "flac_decoder.h"
-#include "vector"
-using namespace std;
+#include "../audio_arena/audio_arena.h"
+#include "../audio_sync/audio_sync.h"
 
 
-FLACFrameHeader_t   *FLACFrameHeader;
-FLACMetadataBlock_t *FLACMetadataBlock;
-FLACsubFramesBuff_t *FLACsubFramesBuff;
-
-vector<int32_t>coefs;
 const uint16_t outBuffSize = 2048;
-uint16_t m_blockSize=0;
-uint16_t m_blockSizeLeft = 0;
-uint16_t m_validSamples = 0;
-uint8_t  m_status = 0;
-uint8_t* m_inptr;
-int16_t  m_bytesAvail;
-int16_t  m_bytesDecoded = 0;
-float    m_compressionRatio = 0;
-uint16_t m_rIndex=0;
-uint64_t m_bitBuffer = 0;
-uint8_t  m_bitBufferLen = 0;
-bool     m_f_OggS_found = false;
+
+// The decoder state lives in a FLACDecoder_t context. The API functions make their context the current one of the
+// calling task, all internal functions work on m_dec.
+static thread_local FLACDecoder_t *m_dec = NULL;
+static FLACDecoder_t *m_defaultDec = NULL;   // used by the API without context
 
 //----------------------------------------------------------------------------------------------------------------------
 //          FLAC INI SECTION
 //----------------------------------------------------------------------------------------------------------------------
-bool FLACDecoder_AllocateBuffers(void){
-    if(psramFound()) {
-        // PSRAM found, Buffer will be allocated in PSRAM
-        if(!FLACFrameHeader)    {FLACFrameHeader   = (FLACFrameHeader_t*)    ps_malloc(sizeof(FLACFrameHeader_t));}
-        if(!FLACMetadataBlock)  {FLACMetadataBlock = (FLACMetadataBlock_t*)  ps_malloc(sizeof(FLACMetadataBlock_t));}
-        if(!FLACsubFramesBuff)  {FLACsubFramesBuff = (FLACsubFramesBuff_t*)  ps_malloc(sizeof(FLACsubFramesBuff_t));}
-    }
-    else {
-        if(!FLACFrameHeader)    {FLACFrameHeader   = (FLACFrameHeader_t*)    malloc(sizeof(FLACFrameHeader_t));}
-        if(!FLACMetadataBlock)  {FLACMetadataBlock = (FLACMetadataBlock_t*)  malloc(sizeof(FLACMetadataBlock_t));}
-        if(!FLACsubFramesBuff)  {FLACsubFramesBuff = (FLACsubFramesBuff_t*)  malloc(sizeof(FLACsubFramesBuff_t));}
-    }
-    if(!FLACFrameHeader || !FLACMetadataBlock || !FLACsubFramesBuff ){
+// the internal RAM buffers are carved from the arena, the heap is only asked if it is full
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+    #define FLAC_RAM    ARENA_PREFER_PSRAM      // ESP32-S3: If there is PSRAM, prefer it
+#else
+    #define FLAC_RAM    ARENA_PREFER_INTERNAL   // ESP32, PSRAM is too slow, prefer SRAM
+#endif
+#define __malloc_flac(size) ArenaMalloc(size, FLAC_RAM)
+
+FLACDecoder_t* FLACDecoder_Create(void){
+    FLACDecoder_t* dec = (FLACDecoder_t*) __malloc_flac(sizeof(FLACDecoder_t));
+    if(dec){
+        memset(dec, 0, sizeof(FLACDecoder_t));
+        dec->FLACFrameHeader   = (FLACFrameHeader_t*)    __malloc_flac(sizeof(FLACFrameHeader_t));
+        dec->FLACMetadataBlock = (FLACMetadataBlock_t*)  __malloc_flac(sizeof(FLACMetadataBlock_t));
+        dec->FLACsubFramesBuff = (FLACsubFramesBuff_t*)  __malloc_flac(sizeof(FLACsubFramesBuff_t));
+    }
+    if(dec && dec->FLACsubFramesBuff) memset(dec->FLACsubFramesBuff, 0, sizeof(FLACsubFramesBuff_t));
+    if(!dec || !dec->FLACFrameHeader || !dec->FLACMetadataBlock || !dec->FLACsubFramesBuff ){
         log_e("not enough memory to allocate flacdecoder buffers");
-        return false;
+        FLACDecoder_Destroy(dec);
+        return NULL;
     }
-    FLACDecoder_ClearBuffer();
-    return true;
+    FLACDecoder_ClearBuffer(dec);
+    return dec;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void FLACDecoder_ClearBuffer(){
-    memset(FLACFrameHeader,   0, sizeof(FLACFrameHeader_t));
-    memset(FLACMetadataBlock, 0, sizeof(FLACMetadataBlock_t));
-    memset(FLACsubFramesBuff, 0, sizeof(FLACsubFramesBuff_t));
-    m_status = DECODE_FRAME;
+bool FLACDecoder_AllocateBuffers(void){
+    if(!m_defaultDec) m_defaultDec = FLACDecoder_Create();
+    else FLACDecoder_ClearBuffer(m_defaultDec);
+    return m_defaultDec != NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t FLACDecoder_BufferSize(void){
+    // arena bytes of one context with the samples buffer of a stereo stream with 4096 samples per block (libFLAC)
+    return ArenaBlockSize(sizeof(FLACDecoder_t), FLAC_RAM) +
+           ArenaBlockSize(sizeof(FLACFrameHeader_t), FLAC_RAM) +
+           ArenaBlockSize(sizeof(FLACMetadataBlock_t), FLAC_RAM) +
+           ArenaBlockSize(sizeof(FLACsubFramesBuff_t), FLAC_RAM) +
+           2 * ArenaBlockSize(4096 * sizeof(int32_t), FLAC_RAM);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FLACDecoder_ClearBuffer(FLACDecoder_t* dec){
+    memset(dec->FLACFrameHeader,   0, sizeof(FLACFrameHeader_t));
+    memset(dec->FLACMetadataBlock, 0, sizeof(FLACMetadataBlock_t));
+    for(int ch = 0; ch < dec->FLACsubFramesBuff->chans; ch++){  // the samples buffer is kept for the next stream
+        memset(dec->FLACsubFramesBuff->samplesBuffer[ch], 0, dec->FLACsubFramesBuff->size * sizeof(int32_t));
+    }
+    dec->status = DECODE_FRAME;
     return;
 }
 //----------------------------------------------------------------------------------------------------------------------
+void FLACDecoder_ClearBuffer(){
+    if(m_defaultDec) FLACDecoder_ClearBuffer(m_defaultDec);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FLACDecoder_Destroy(FLACDecoder_t* dec){
+    if(!dec) return;
+    if(m_dec == dec) m_dec = NULL;
+    if(dec->FLACFrameHeader)    {ArenaFree(dec->FLACFrameHeader);   dec->FLACFrameHeader   = NULL;}
+    if(dec->FLACMetadataBlock)  {ArenaFree(dec->FLACMetadataBlock); dec->FLACMetadataBlock = NULL;}
+    if(dec->FLACsubFramesBuff)  {
+        for(int ch = 0; ch < MAX_CHANNELS; ch++) ArenaFree(dec->FLACsubFramesBuff->samplesBuffer[ch]);
+        ArenaFree(dec->FLACsubFramesBuff); dec->FLACsubFramesBuff = NULL;
+    }
+    ArenaFree(dec);
+}
+//----------------------------------------------------------------------------------------------------------------------
 void FLACDecoder_FreeBuffers(){
-    if(FLACFrameHeader)    {free(FLACFrameHeader);   FLACFrameHeader   = NULL;}
-    if(FLACMetadataBlock)  {free(FLACMetadataBlock); FLACMetadataBlock = NULL;}
-    if(FLACsubFramesBuff)  {free(FLACsubFramesBuff); FLACsubFramesBuff = NULL;}
+    FLACDecoder_Destroy(m_defaultDec);
+    m_defaultDec = NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool FLACAllocSamplesBuffer(FLACDecoder_t* dec, uint16_t blockSize, uint8_t chans){
+    // The subframes of one block are decoded completely before the output, so the buffer must hold blockSize
+    // samples per channel. It is sized by the stream instead of MAX_BLOCKSIZE, a stream with 4096 samples per block
+    // needs half, one with 1152 an eighth of it.
+    FLACsubFramesBuff_t* sb = dec->FLACsubFramesBuff;
+    if(blockSize <= sb->size && chans <= sb->chans) return true;
+    if(blockSize < sb->size) blockSize = sb->size;
+    if(chans < sb->chans) chans = sb->chans;
+    for(int ch = 0; ch < MAX_CHANNELS; ch++) {ArenaFree(sb->samplesBuffer[ch]); sb->samplesBuffer[ch] = NULL;}
+    sb->size = 0;
+    sb->chans = 0;
+    for(int ch = 0; ch < chans; ch++){
+        sb->samplesBuffer[ch] = (int32_t*) __malloc_flac(blockSize * sizeof(int32_t));
+        if(!sb->samplesBuffer[ch]){
+            log_e("not enough memory for %u FLAC samples", blockSize);
+            for(int i = 0; i < ch; i++) {ArenaFree(sb->samplesBuffer[i]); sb->samplesBuffer[i] = NULL;}
+            return false;
+        }
+    }
+    sb->size = blockSize;
+    sb->chans = chans;
+    return true;
 }
 //----------------------------------------------------------------------------------------------------------------------
 //            B I T R E A D E R
 //----------------------------------------------------------------------------------------------------------------------
+// The bits are held in a 64 bit reservoir, the valid ones are the lowest bitBufferLen bits. It is refilled with
+// 32 bits at once as long as 4 bytes are available, byte by byte near the end of the input. So the reservoir can hold
+// whole unread bytes, alignToByte() gives them back to inptr before the caller learns the number of consumed bytes.
+static inline __attribute__((always_inline)) void refill32(){
+    const uint8_t* p = m_dec->inptr + m_dec->rIndex;
+    m_dec->bitBuffer = (m_dec->bitBuffer << 32) | ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                       ((uint32_t)p[2] << 8) | p[3];
+    m_dec->rIndex += 4;
+    m_dec->bytesAvail -= 4;
+    m_dec->bitBufferLen += 32;
+}
+
 uint32_t readUint(uint8_t nBits){
-    while (m_bitBufferLen < nBits){
-        uint8_t temp = *(m_inptr + m_rIndex);
-        m_rIndex++;
-        m_bytesAvail--;
-        if(m_bytesAvail < 0) { log_i("error in bitreader"); }
-        m_bitBuffer = (m_bitBuffer << 8) | temp;
-        m_bitBufferLen += 8;
-    }
-    m_bitBufferLen -= nBits;
-    uint32_t result = m_bitBuffer >> m_bitBufferLen;
+#ifndef FLAC_RICE_REFERENCE
+    if(m_dec->bitBufferLen < nBits && m_dec->bytesAvail >= 4) refill32();
+#endif
+    while (m_dec->bitBufferLen < nBits){
+        uint8_t temp = *(m_dec->inptr + m_dec->rIndex);
+        m_dec->rIndex++;
+        m_dec->bytesAvail--;
+        if(m_dec->bytesAvail < 0) { log_i("error in bitreader"); }
+        m_dec->bitBuffer = (m_dec->bitBuffer << 8) | temp;
+        m_dec->bitBufferLen += 8;
+    }
+    m_dec->bitBufferLen -= nBits;
+    uint32_t result = m_dec->bitBuffer >> m_dec->bitBufferLen;
     if (nBits < 32)
         result &= (1 << nBits) - 1;
     return result;
@@ -103,128 +168,295 @@ int64_t readRiceSignedInt(uint8_t param){
     return (val >> 1) ^ -(val & 1);
 }
 
+void readRicePartition(int32_t* out, int n, uint8_t param){
+    // All residuals of one rice partition. The reservoir is kept in locals, the unary part is counted with clz.
+    // Codes with 32 or more leading zeros and the last bytes of the input go through readRiceSignedInt().
+    uint64_t buf   = m_dec->bitBuffer;
+    uint8_t  len   = m_dec->bitBufferLen;
+    int      idx   = m_dec->rIndex;
+    int32_t  avail = m_dec->bytesAvail;
+    const uint8_t* in = m_dec->inptr;
+    const uint32_t mask = (1u << param) - 1;
+
+    for(int i = 0; i < n; i++){
+        if(len < 32 && avail >= 4){
+            buf = (buf << 32) | ((uint32_t)in[idx] << 24) | ((uint32_t)in[idx + 1] << 16) |
+                  ((uint32_t)in[idx + 2] << 8) | in[idx + 3];
+            idx += 4; avail -= 4; len += 32;
+        }
+        uint32_t top = (len >= 32) ? (uint32_t)(buf >> (len - 32)) : 0;
+        if(top == 0){  // slow path, state back to m_dec
+            m_dec->bitBuffer = buf; m_dec->bitBufferLen = len; m_dec->rIndex = idx; m_dec->bytesAvail = avail;
+            out[i] = readRiceSignedInt(param);
+            buf = m_dec->bitBuffer; len = m_dec->bitBufferLen; idx = m_dec->rIndex; avail = m_dec->bytesAvail;
+            continue;
+        }
+        uint32_t q = __builtin_clz(top);
+        len -= q + 1;
+        uint32_t r;
+        if(len >= param){
+            len -= param;
+            r = (uint32_t)(buf >> len) & mask;
+        }
+        else{
+            m_dec->bitBuffer = buf; m_dec->bitBufferLen = len; m_dec->rIndex = idx; m_dec->bytesAvail = avail;
+            r = readUint(param);
+            buf = m_dec->bitBuffer; len = m_dec->bitBufferLen; idx = m_dec->rIndex; avail = m_dec->bytesAvail;
+        }
+        uint32_t val = (q << param) | r;
+        out[i] = (int32_t)(val >> 1) ^ -(int32_t)(val & 1);
+    }
+    m_dec->bitBuffer = buf; m_dec->bitBufferLen = len; m_dec->rIndex = idx; m_dec->bytesAvail = avail;
+}
+
 void alignToByte() {
-    m_bitBufferLen -= m_bitBufferLen % 8;
+    // drop the rest of the current byte and give the whole unread bytes back
+    uint8_t n = m_dec->bitBufferLen / 8;
+    m_dec->rIndex -= n;
+    m_dec->bytesAvail += n;
+    m_dec->bitBufferLen = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+//              C R C
+//----------------------------------------------------------------------------------------------------------------------
+// The frame header ends with a CRC-8 of the header, the frame with a CRC-16 of the whole frame (MSB first, init 0).
+// crc16Tab[0] is the usual byte table, crc16Tab[k] advances a table value by k more zero bytes, so four bytes are
+// processed with four independent lookups (slice-by-4).
+const uint8_t crc8Tab[256] PROGMEM = {  // CRC-8, polynomial x^8 + x^2 + x^1 + x^0
+    0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
+    0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
+    0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
+    0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
+    0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
+    0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
+    0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
+    0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
+    0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
+    0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
+    0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
+    0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
+    0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
+    0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
+    0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
+    0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3,
+};
+
+const uint16_t crc16Tab[4][256] PROGMEM = {  // CRC-16, polynomial x^16 + x^15 + x^2 + x^0, slice-by-4
+    {
+    0x0000, 0x8005, 0x800f, 0x000a, 0x801b, 0x001e, 0x0014, 0x8011, 0x8033, 0x0036, 0x003c, 0x8039, 0x0028, 0x802d, 0x8027, 0x0022,
+    0x8063, 0x0066, 0x006c, 0x8069, 0x0078, 0x807d, 0x8077, 0x0072, 0x0050, 0x8055, 0x805f, 0x005a, 0x804b, 0x004e, 0x0044, 0x8041,
+    0x80c3, 0x00c6, 0x00cc, 0x80c9, 0x00d8, 0x80dd, 0x80d7, 0x00d2, 0x00f0, 0x80f5, 0x80ff, 0x00fa, 0x80eb, 0x00ee, 0x00e4, 0x80e1,
+    0x00a0, 0x80a5, 0x80af, 0x00aa, 0x80bb, 0x00be, 0x00b4, 0x80b1, 0x8093, 0x0096, 0x009c, 0x8099, 0x0088, 0x808d, 0x8087, 0x0082,
+    0x8183, 0x0186, 0x018c, 0x8189, 0x0198, 0x819d, 0x8197, 0x0192, 0x01b0, 0x81b5, 0x81bf, 0x01ba, 0x81ab, 0x01ae, 0x01a4, 0x81a1,
+    0x01e0, 0x81e5, 0x81ef, 0x01ea, 0x81fb, 0x01fe, 0x01f4, 0x81f1, 0x81d3, 0x01d6, 0x01dc, 0x81d9, 0x01c8, 0x81cd, 0x81c7, 0x01c2,
+    0x0140, 0x8145, 0x814f, 0x014a, 0x815b, 0x015e, 0x0154, 0x8151, 0x8173, 0x0176, 0x017c, 0x8179, 0x0168, 0x816d, 0x8167, 0x0162,
+    0x8123, 0x0126, 0x012c, 0x8129, 0x0138, 0x813d, 0x8137, 0x0132, 0x0110, 0x8115, 0x811f, 0x011a, 0x810b, 0x010e, 0x0104, 0x8101,
+    0x8303, 0x0306, 0x030c, 0x8309, 0x0318, 0x831d, 0x8317, 0x0312, 0x0330, 0x8335, 0x833f, 0x033a, 0x832b, 0x032e, 0x0324, 0x8321,
+    0x0360, 0x8365, 0x836f, 0x036a, 0x837b, 0x037e, 0x0374, 0x8371, 0x8353, 0x0356, 0x035c, 0x8359, 0x0348, 0x834d, 0x8347, 0x0342,
+    0x03c0, 0x83c5, 0x83cf, 0x03ca, 0x83db, 0x03de, 0x03d4, 0x83d1, 0x83f3, 0x03f6, 0x03fc, 0x83f9, 0x03e8, 0x83ed, 0x83e7, 0x03e2,
+    0x83a3, 0x03a6, 0x03ac, 0x83a9, 0x03b8, 0x83bd, 0x83b7, 0x03b2, 0x0390, 0x8395, 0x839f, 0x039a, 0x838b, 0x038e, 0x0384, 0x8381,
+    0x0280, 0x8285, 0x828f, 0x028a, 0x829b, 0x029e, 0x0294, 0x8291, 0x82b3, 0x02b6, 0x02bc, 0x82b9, 0x02a8, 0x82ad, 0x82a7, 0x02a2,
+    0x82e3, 0x02e6, 0x02ec, 0x82e9, 0x02f8, 0x82fd, 0x82f7, 0x02f2, 0x02d0, 0x82d5, 0x82df, 0x02da, 0x82cb, 0x02ce, 0x02c4, 0x82c1,
+    0x8243, 0x0246, 0x024c, 0x8249, 0x0258, 0x825d, 0x8257, 0x0252, 0x0270, 0x8275, 0x827f, 0x027a, 0x826b, 0x026e, 0x0264, 0x8261,
+    0x0220, 0x8225, 0x822f, 0x022a, 0x823b, 0x023e, 0x0234, 0x8231, 0x8213, 0x0216, 0x021c, 0x8219, 0x0208, 0x820d, 0x8207, 0x0202,
+    },
+    {
+    0x0000, 0x8603, 0x8c03, 0x0a00, 0x9803, 0x1e00, 0x1400, 0x9203, 0xb003, 0x3600, 0x3c00, 0xba03, 0x2800, 0xae03, 0xa403, 0x2200,
+    0xe003, 0x6600, 0x6c00, 0xea03, 0x7800, 0xfe03, 0xf403, 0x7200, 0x5000, 0xd603, 0xdc03, 0x5a00, 0xc803, 0x4e00, 0x4400, 0xc203,
+    0x4003, 0xc600, 0xcc00, 0x4a03, 0xd800, 0x5e03, 0x5403, 0xd200, 0xf000, 0x7603, 0x7c03, 0xfa00, 0x6803, 0xee00, 0xe400, 0x6203,
+    0xa000, 0x2603, 0x2c03, 0xaa00, 0x3803, 0xbe00, 0xb400, 0x3203, 0x1003, 0x9600, 0x9c00, 0x1a03, 0x8800, 0x0e03, 0x0403, 0x8200,
+    0x8006, 0x0605, 0x0c05, 0x8a06, 0x1805, 0x9e06, 0x9406, 0x1205, 0x3005, 0xb606, 0xbc06, 0x3a05, 0xa806, 0x2e05, 0x2405, 0xa206,
+    0x6005, 0xe606, 0xec06, 0x6a05, 0xf806, 0x7e05, 0x7405, 0xf206, 0xd006, 0x5605, 0x5c05, 0xda06, 0x4805, 0xce06, 0xc406, 0x4205,
+    0xc005, 0x4606, 0x4c06, 0xca05, 0x5806, 0xde05, 0xd405, 0x5206, 0x7006, 0xf605, 0xfc05, 0x7a06, 0xe805, 0x6e06, 0x6406, 0xe205,
+    0x2006, 0xa605, 0xac05, 0x2a06, 0xb805, 0x3e06, 0x3406, 0xb205, 0x9005, 0x1606, 0x1c06, 0x9a05, 0x0806, 0x8e05, 0x8405, 0x0206,
+    0x8009, 0x060a, 0x0c0a, 0x8a09, 0x180a, 0x9e09, 0x9409, 0x120a, 0x300a, 0xb609, 0xbc09, 0x3a0a, 0xa809, 0x2e0a, 0x240a, 0xa209,
+    0x600a, 0xe609, 0xec09, 0x6a0a, 0xf809, 0x7e0a, 0x740a, 0xf209, 0xd009, 0x560a, 0x5c0a, 0xda09, 0x480a, 0xce09, 0xc409, 0x420a,
+    0xc00a, 0x4609, 0x4c09, 0xca0a, 0x5809, 0xde0a, 0xd40a, 0x5209, 0x7009, 0xf60a, 0xfc0a, 0x7a09, 0xe80a, 0x6e09, 0x6409, 0xe20a,
+    0x2009, 0xa60a, 0xac0a, 0x2a09, 0xb80a, 0x3e09, 0x3409, 0xb20a, 0x900a, 0x1609, 0x1c09, 0x9a0a, 0x0809, 0x8e0a, 0x840a, 0x0209,
+    0x000f, 0x860c, 0x8c0c, 0x0a0f, 0x980c, 0x1e0f, 0x140f, 0x920c, 0xb00c, 0x360f, 0x3c0f, 0xba0c, 0x280f, 0xae0c, 0xa40c, 0x220f,
+    0xe00c, 0x660f, 0x6c0f, 0xea0c, 0x780f, 0xfe0c, 0xf40c, 0x720f, 0x500f, 0xd60c, 0xdc0c, 0x5a0f, 0xc80c, 0x4e0f, 0x440f, 0xc20c,
+    0x400c, 0xc60f, 0xcc0f, 0x4a0c, 0xd80f, 0x5e0c, 0x540c, 0xd20f, 0xf00f, 0x760c, 0x7c0c, 0xfa0f, 0x680c, 0xee0f, 0xe40f, 0x620c,
+    0xa00f, 0x260c, 0x2c0c, 0xaa0f, 0x380c, 0xbe0f, 0xb40f, 0x320c, 0x100c, 0x960f, 0x9c0f, 0x1a0c, 0x880f, 0x0e0c, 0x040c, 0x820f,
+    },
+    {
+    0x0000, 0x8017, 0x802b, 0x003c, 0x8053, 0x0044, 0x0078, 0x806f, 0x80a3, 0x00b4, 0x0088, 0x809f, 0x00f0, 0x80e7, 0x80db, 0x00cc,
+    0x8143, 0x0154, 0x0168, 0x817f, 0x0110, 0x8107, 0x813b, 0x012c, 0x01e0, 0x81f7, 0x81cb, 0x01dc, 0x81b3, 0x01a4, 0x0198, 0x818f,
+    0x8283, 0x0294, 0x02a8, 0x82bf, 0x02d0, 0x82c7, 0x82fb, 0x02ec, 0x0220, 0x8237, 0x820b, 0x021c, 0x8273, 0x0264, 0x0258, 0x824f,
+    0x03c0, 0x83d7, 0x83eb, 0x03fc, 0x8393, 0x0384, 0x03b8, 0x83af, 0x8363, 0x0374, 0x0348, 0x835f, 0x0330, 0x8327, 0x831b, 0x030c,
+    0x8503, 0x0514, 0x0528, 0x853f, 0x0550, 0x8547, 0x857b, 0x056c, 0x05a0, 0x85b7, 0x858b, 0x059c, 0x85f3, 0x05e4, 0x05d8, 0x85cf,
+    0x0440, 0x8457, 0x846b, 0x047c, 0x8413, 0x0404, 0x0438, 0x842f, 0x84e3, 0x04f4, 0x04c8, 0x84df, 0x04b0, 0x84a7, 0x849b, 0x048c,
+    0x0780, 0x8797, 0x87ab, 0x07bc, 0x87d3, 0x07c4, 0x07f8, 0x87ef, 0x8723, 0x0734, 0x0708, 0x871f, 0x0770, 0x8767, 0x875b, 0x074c,
+    0x86c3, 0x06d4, 0x06e8, 0x86ff, 0x0690, 0x8687, 0x86bb, 0x06ac, 0x0660, 0x8677, 0x864b, 0x065c, 0x8633, 0x0624, 0x0618, 0x860f,
+    0x8a03, 0x0a14, 0x0a28, 0x8a3f, 0x0a50, 0x8a47, 0x8a7b, 0x0a6c, 0x0aa0, 0x8ab7, 0x8a8b, 0x0a9c, 0x8af3, 0x0ae4, 0x0ad8, 0x8acf,
+    0x0b40, 0x8b57, 0x8b6b, 0x0b7c, 0x8b13, 0x0b04, 0x0b38, 0x8b2f, 0x8be3, 0x0bf4, 0x0bc8, 0x8bdf, 0x0bb0, 0x8ba7, 0x8b9b, 0x0b8c,
+    0x0880, 0x8897, 0x88ab, 0x08bc, 0x88d3, 0x08c4, 0x08f8, 0x88ef, 0x8823, 0x0834, 0x0808, 0x881f, 0x0870, 0x8867, 0x885b, 0x084c,
+    0x89c3, 0x09d4, 0x09e8, 0x89ff, 0x0990, 0x8987, 0x89bb, 0x09ac, 0x0960, 0x8977, 0x894b, 0x095c, 0x8933, 0x0924, 0x0918, 0x890f,
+    0x0f00, 0x8f17, 0x8f2b, 0x0f3c, 0x8f53, 0x0f44, 0x0f78, 0x8f6f, 0x8fa3, 0x0fb4, 0x0f88, 0x8f9f, 0x0ff0, 0x8fe7, 0x8fdb, 0x0fcc,
+    0x8e43, 0x0e54, 0x0e68, 0x8e7f, 0x0e10, 0x8e07, 0x8e3b, 0x0e2c, 0x0ee0, 0x8ef7, 0x8ecb, 0x0edc, 0x8eb3, 0x0ea4, 0x0e98, 0x8e8f,
+    0x8d83, 0x0d94, 0x0da8, 0x8dbf, 0x0dd0, 0x8dc7, 0x8dfb, 0x0dec, 0x0d20, 0x8d37, 0x8d0b, 0x0d1c, 0x8d73, 0x0d64, 0x0d58, 0x8d4f,
+    0x0cc0, 0x8cd7, 0x8ceb, 0x0cfc, 0x8c93, 0x0c84, 0x0cb8, 0x8caf, 0x8c63, 0x0c74, 0x0c48, 0x8c5f, 0x0c30, 0x8c27, 0x8c1b, 0x0c0c,
+    },
+    {
+    0x0000, 0x9403, 0xa803, 0x3c00, 0xd003, 0x4400, 0x7800, 0xec03, 0x2003, 0xb400, 0x8800, 0x1c03, 0xf000, 0x6403, 0x5803, 0xcc00,
+    0x4006, 0xd405, 0xe805, 0x7c06, 0x9005, 0x0406, 0x3806, 0xac05, 0x6005, 0xf406, 0xc806, 0x5c05, 0xb006, 0x2405, 0x1805, 0x8c06,
+    0x800c, 0x140f, 0x280f, 0xbc0c, 0x500f, 0xc40c, 0xf80c, 0x6c0f, 0xa00f, 0x340c, 0x080c, 0x9c0f, 0x700c, 0xe40f, 0xd80f, 0x4c0c,
+    0xc00a, 0x5409, 0x6809, 0xfc0a, 0x1009, 0x840a, 0xb80a, 0x2c09, 0xe009, 0x740a, 0x480a, 0xdc09, 0x300a, 0xa409, 0x9809, 0x0c0a,
+    0x801d, 0x141e, 0x281e, 0xbc1d, 0x501e, 0xc41d, 0xf81d, 0x6c1e, 0xa01e, 0x341d, 0x081d, 0x9c1e, 0x701d, 0xe41e, 0xd81e, 0x4c1d,
+    0xc01b, 0x5418, 0x6818, 0xfc1b, 0x1018, 0x841b, 0xb81b, 0x2c18, 0xe018, 0x741b, 0x481b, 0xdc18, 0x301b, 0xa418, 0x9818, 0x0c1b,
+    0x0011, 0x9412, 0xa812, 0x3c11, 0xd012, 0x4411, 0x7811, 0xec12, 0x2012, 0xb411, 0x8811, 0x1c12, 0xf011, 0x6412, 0x5812, 0xcc11,
+    0x4017, 0xd414, 0xe814, 0x7c17, 0x9014, 0x0417, 0x3817, 0xac14, 0x6014, 0xf417, 0xc817, 0x5c14, 0xb017, 0x2414, 0x1814, 0x8c17,
+    0x803f, 0x143c, 0x283c, 0xbc3f, 0x503c, 0xc43f, 0xf83f, 0x6c3c, 0xa03c, 0x343f, 0x083f, 0x9c3c, 0x703f, 0xe43c, 0xd83c, 0x4c3f,
+    0xc039, 0x543a, 0x683a, 0xfc39, 0x103a, 0x8439, 0xb839, 0x2c3a, 0xe03a, 0x7439, 0x4839, 0xdc3a, 0x3039, 0xa43a, 0x983a, 0x0c39,
+    0x0033, 0x9430, 0xa830, 0x3c33, 0xd030, 0x4433, 0x7833, 0xec30, 0x2030, 0xb433, 0x8833, 0x1c30, 0xf033, 0x6430, 0x5830, 0xcc33,
+    0x4035, 0xd436, 0xe836, 0x7c35, 0x9036, 0x0435, 0x3835, 0xac36, 0x6036, 0xf435, 0xc835, 0x5c36, 0xb035, 0x2436, 0x1836, 0x8c35,
+    0x0022, 0x9421, 0xa821, 0x3c22, 0xd021, 0x4422, 0x7822, 0xec21, 0x2021, 0xb422, 0x8822, 0x1c21, 0xf022, 0x6421, 0x5821, 0xcc22,
+    0x4024, 0xd427, 0xe827, 0x7c24, 0x9027, 0x0424, 0x3824, 0xac27, 0x6027, 0xf424, 0xc824, 0x5c27, 0xb024, 0x2427, 0x1827, 0x8c24,
+    0x802e, 0x142d, 0x282d, 0xbc2e, 0x502d, 0xc42e, 0xf82e, 0x6c2d, 0xa02d, 0x342e, 0x082e, 0x9c2d, 0x702e, 0xe42d, 0xd82d, 0x4c2e,
+    0xc028, 0x542b, 0x682b, 0xfc28, 0x102b, 0x8428, 0xb828, 0x2c2b, 0xe02b, 0x7428, 0x4828, 0xdc2b, 0x3028, 0xa42b, 0x982b, 0x0c28,
+    },
+};
+
+static inline __attribute__((always_inline)) uint8_t crc8(const uint8_t* buf, int n){
+    uint8_t crc = 0;
+    while(n--) crc = crc8Tab[crc ^ *buf++];
+    return crc;
+}
+static inline __attribute__((always_inline)) uint16_t crc16(uint16_t crc, const uint8_t* buf, int n){
+    for(; n >= 4; n -= 4, buf += 4){
+        crc = crc16Tab[3][(crc >> 8) ^ buf[0]] ^ crc16Tab[2][(crc & 0xFF) ^ buf[1]] ^
+              crc16Tab[1][buf[2]] ^ crc16Tab[0][buf[3]];
+    }
+    while(n--) crc = (crc << 8) ^ crc16Tab[0][(crc >> 8) ^ *buf++];
+    return crc;
 }
 //----------------------------------------------------------------------------------------------------------------------
 //              F L A C - D E C O D E R
 //----------------------------------------------------------------------------------------------------------------------
+void FLACSetRawBlockParams(FLACDecoder_t* dec, uint8_t Chans, uint32_t SampRate, uint8_t BPS, uint32_t tsis,
+                           uint32_t AuDaLength){
+    dec->FLACMetadataBlock->numChannels = Chans;
+    dec->FLACMetadataBlock->sampleRate = SampRate;
+    dec->FLACMetadataBlock->bitsPerSample = BPS;
+    dec->FLACMetadataBlock->totalSamples = tsis;  // total samples in stream
+    dec->FLACMetadataBlock->audioDataLength = AuDaLength;
+}
 void FLACSetRawBlockParams(uint8_t Chans, uint32_t SampRate, uint8_t BPS, uint32_t tsis, uint32_t AuDaLength){
-    FLACMetadataBlock->numChannels = Chans;
-    FLACMetadataBlock->sampleRate = SampRate;
-    FLACMetadataBlock->bitsPerSample = BPS;
-    FLACMetadataBlock->totalSamples = tsis;  // total samples in stream
-    FLACMetadataBlock->audioDataLength = AuDaLength;
+    FLACSetRawBlockParams(m_defaultDec, Chans, SampRate, BPS, tsis, AuDaLength);
 }
 //----------------------------------------------------------------------------------------------------------------------
-void FLACDecoderReset(){ // set var to default
-    m_status = DECODE_FRAME;
-    m_bitBuffer = 0;
-    m_bitBufferLen = 0;
+void FLACDecoderReset(FLACDecoder_t* dec){ // set var to default
+    dec->status = DECODE_FRAME;
+    dec->bitBuffer = 0;
+    dec->bitBufferLen = 0;
+    dec->offset = 0;
 }
-//----------------------------------------------------------------------------------------------------------------------
-int FLACFindSyncWord(unsigned char *buf, int nBytes) {
-    int i;
-
-    /* find byte-aligned syncword - need 13 matching bits */
-    for (i = 0; i < nBytes - 1; i++) {
-        if ((buf[i + 0] & 0xFF) == 0xFF  && (buf[i + 1] & 0xF8) == 0xF8) {
-            FLACDecoderReset();
-            return i;
-        }
-    }
-    return -1;
+void FLACDecoderReset(){
+    if(m_defaultDec) FLACDecoderReset(m_defaultDec);
 }
 //----------------------------------------------------------------------------------------------------------------------
-int FLACFindOggSyncWord(unsigned char *buf, int nBytes){
-    int i;
-
-    /* find byte-aligned syncword - need 13 matching bits */
-    for (i = 0; i < nBytes - 1; i++) {
-        if ((buf[i + 0] & 0xFF) == 0xFF  && (buf[i + 1] & 0xF8) == 0xF8) {
-            FLACDecoderReset();
-            log_i("FLAC sync found");
-            return i;
+int FLACFindSyncWord(FLACDecoder_t* dec, unsigned char *buf, int nBytes) {
+    // A candidate must have a valid frame header (CRC-8) and the next frame header must follow on it
+    // (same samplerate and samplesize, frame number + 1). If buf ends before the next frame header,
+    // the candidate is returned, the caller skips up to it and looks again with more data.
+    // So -1 means that buf contains no frame start except maybe the last bytes.
+    int i = 0;
+    uint32_t num = 0, nextNum = 0;
+
+    /* find byte-aligned syncword - need 14 matching bits and a valid header */
+    while((i = FindFFByte(buf, i, nBytes - 1)) >= 0) {
+        if((buf[i + 1] & 0xFE) != 0xF8) {i++; continue;}
+        if(i + 16 > nBytes) {FLACDecoderReset(dec); return i;} // header may be incomplete
+        int hl = FLACParseFrameHeader(buf + i, nBytes - i, 1, &num);
+        if(!hl) {i++; continue;}
+        int j = i + hl;
+        int next = -1;
+        while((j = FindFFByte(buf, j, nBytes - 1)) >= 0) {  // next frame header
+            if((buf[j + 1] & 0xFE) == 0xF8 && FLACParseFrameHeader(buf + j, nBytes - j, 1, &nextNum)) {next = j; break;}
+            j++;
         }
-    }
-    /* find byte-aligned OGG Magic - OggS */
-    for (i = 0; i < nBytes - 1; i++) {
-        if ((buf[i + 0] == 'O') && (buf[i + 1] == 'g') && (buf[i + 2] == 'g') && (buf[i + 3] == 'S')) {
-            FLACDecoderReset();
-            log_i("OggS found");
-            m_f_OggS_found = true;
+        if(next < 0 || (buf[next + 1] == buf[i + 1] && (buf[next + 2] & 0x0F) == (buf[i + 2] & 0x0F) &&
+                        (buf[next + 3] & 0x0E) == (buf[i + 3] & 0x0E) &&
+                        ((buf[i + 1] & 0x01) ? nextNum > num : nextNum == num + 1))) {
+            FLACDecoderReset(dec);
             return i;
         }
+        i++;
     }
     return -1;
 }
+int FLACFindSyncWord(unsigned char *buf, int nBytes) {
+    return FLACFindSyncWord(m_defaultDec, buf, nBytes);
+}
 //----------------------------------------------------------------------------------------------------------------------
-int FLACparseOggHeader(unsigned char *buf){
-    uint8_t i = 0;
-    uint8_t ssv = *(buf + i);                  // stream_structure_version
-    (void)ssv;
-    i++;
-    uint8_t htf = *(buf + i);                  // header_type_flag
-    (void)htf;
-    i++;
-    uint32_t tmp = 0;                         // absolute granule position
-    for (int j = 0; j < 4; j++) {
-        tmp += *(buf + j + i) << (4 -j - 1) * 8;
-    }
-    i += 4;
-    uint64_t agp = (uint64_t) tmp << 32;
-    for (int j = 0; j < 4; j++) {
-        agp += *(buf + j + i) << (4 -j - 1) * 8;
-    }
-    i += 4;
-    uint32_t ssnr = 0;                        // stream serial number
-    for (int j = 0; j < 4; j++) {
-        ssnr += *(buf + j + i) << (4 -j - 1) * 8;
-    }
-    i += 4;
-    uint32_t psnr = 0;                        // page sequence no
-    for (int j = 0; j < 4; j++) {
-        psnr += *(buf + j + i) << (4 -j - 1) * 8;
-    }
-    i += 4;
-    uint32_t pchk = 0;                        // page checksum
-    for (int j = 0; j < 4; j++) {
-        pchk += *(buf + j + i) << (4 -j - 1) * 8;
-    }
-    i += 4;
-    uint8_t psegm = *(buf + i);
+int FLACParseFrameHeader(const uint8_t *buf, int nBytes, uint16_t nominalBlockSize, uint32_t *firstSample){
+    // Checks whether a complete and valid frame header starts at buf[0]. All reserved and invalid codes are
+    // rejected and the header CRC-8 must match, so a random 0xFFF8 inside the audio data is not taken as a frame.
+    // Return: length of the frame header in bytes, 0 if there is no valid header
+    //         firstSample: number of the first (inter-channel) sample in this frame
+
+    if(nBytes < 6) return 0;
+    if(buf[0] != 0xFF || (buf[1] & 0xFE) != 0xF8) return 0;     // sync code, reserved bit must be 0
+    uint8_t blockingStrategy = buf[1] & 0x01;
+    uint8_t blockSizeCode    = buf[2] >> 4;
+    uint8_t sampleRateCode   = buf[2] & 0x0F;
+    uint8_t chanAsgn         = buf[3] >> 4;
+    uint8_t sampleSizeCode   = (buf[3] >> 1) & 0x07;
+    if(blockSizeCode == 0 || sampleRateCode == 15) return 0;
+    if(chanAsgn > 10) return 0;
+    if(sampleSizeCode == 3 || sampleSizeCode == 7 || (buf[3] & 0x01)) return 0;
+
+    // frame number (fixed blocksize) or sample number (variable blocksize), UTF-8 coded
+    int i = 4;
+    uint32_t num = buf[i];
+    uint8_t  extra = 0;
+    if     (!(num & 0x80))        {extra = 0;}
+    else if((num & 0xE0) == 0xC0) {extra = 1; num &= 0x1F;}
+    else if((num & 0xF0) == 0xE0) {extra = 2; num &= 0x0F;}
+    else if((num & 0xF8) == 0xF0) {extra = 3; num &= 0x07;}
+    else if((num & 0xFC) == 0xF8) {extra = 4; num &= 0x03;}
+    else if((num & 0xFE) == 0xFC) {extra = 5; num &= 0x01;}
+    else return 0;                                            // 36 bit sample numbers are not supported
     i++;
-    uint8_t psegmBuff[256];
-    uint32_t pageLen = 0;
-    for(uint8_t j = 0; j < psegm; j++){
-        psegmBuff[j] = *(buf + i);
-        pageLen += psegmBuff[j];
+    if(i + extra + 5 > nBytes) return 0;
+    for(int j = 0; j < extra; j++){
+        if((buf[i] & 0xC0) != 0x80) return 0;
+        num = (num << 6) | (buf[i] & 0x3F);
         i++;
     }
-    return i;
+    if(blockSizeCode == 6) i += 1;
+    if(blockSizeCode == 7) i += 2;
+    if(sampleRateCode == 12) i += 1;
+    if(sampleRateCode == 13 || sampleRateCode == 14) i += 2;
+
+    if(crc8(buf, i) != buf[i]) return 0;
+
+    if(firstSample) *firstSample = blockingStrategy ? num : num * nominalBlockSize;
+    return i + 1;
 }
 //----------------------------------------------------------------------------------------------------------------------
 int8_t FLACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf){
+    return FLACDecode(m_defaultDec, inbuf, bytesLeft, outbuf);
+}
+int8_t FLACDecode(FLACDecoder_t* dec, uint8_t *inbuf, int *bytesLeft, short *outbuf){
 
-    if(m_f_OggS_found == true){
-        m_f_OggS_found = false;
-        *bytesLeft -= FLACparseOggHeader(inbuf);
-        return ERR_FLAC_NONE;
-    }
+    m_dec = dec;
 
-    if(m_status != OUT_SAMPLES){
-        m_rIndex = 0;
-        m_bytesAvail = (*bytesLeft);
-        m_inptr = inbuf;
+    if(m_dec->status != OUT_SAMPLES){
+        m_dec->rIndex = 0;
+        m_dec->bytesAvail = (*bytesLeft);
+        m_dec->inptr = inbuf;
+        m_dec->bitBufferLen = 0;  // frames and subframes start byte aligned, nothing left from an aborted frame
     }
 
-    if(m_status == DECODE_FRAME){  // Read a ton of header fields, and ignore most of them
+    if(m_dec->status == DECODE_FRAME){  // Read a ton of header fields, and ignore most of them
 
-        if ((inbuf[0] == 'O') && (inbuf[1] == 'g') && (inbuf[2] == 'g') && (inbuf[3] == 'S')){
-            *bytesLeft -= 4;
-            m_f_OggS_found = true;
-            return ERR_FLAC_NONE;
+        // The header is only accepted with a matching CRC-8, else the caller searches the next frame start at once.
+        int hl = FLACParseFrameHeader(inbuf, *bytesLeft, 1, NULL);
+        if(!hl){
+            log_i("invalid frame header");
+            return ERR_FLAC_SYNC_CODE_NOT_FOUND;
         }
+        m_dec->frameCRC = crc16(0, inbuf, hl);
 
         uint32_t temp = readUint(8);
         uint16_t sync = temp << 6 |readUint(6);
@@ -234,41 +466,41 @@ int8_t FLACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf){
         }
 
         readUint(1);
-        FLACFrameHeader->blockingStrategy = readUint(1);
-        FLACFrameHeader->blockSizeCode = readUint(4);
-        FLACFrameHeader->sampleRateCode = readUint(4);
-        FLACFrameHeader->chanAsgn = readUint(4);
-        FLACFrameHeader->sampleSizeCode = readUint(3);
-
-        if(!FLACMetadataBlock->numChannels){
-            if(FLACFrameHeader->chanAsgn == 0) FLACMetadataBlock->numChannels = 1;
-            if(FLACFrameHeader->chanAsgn == 1) FLACMetadataBlock->numChannels = 2;
-            if(FLACFrameHeader->chanAsgn > 7)  FLACMetadataBlock->numChannels = 2;
+        m_dec->FLACFrameHeader->blockingStrategy = readUint(1);
+        m_dec->FLACFrameHeader->blockSizeCode = readUint(4);
+        m_dec->FLACFrameHeader->sampleRateCode = readUint(4);
+        m_dec->FLACFrameHeader->chanAsgn = readUint(4);
+        m_dec->FLACFrameHeader->sampleSizeCode = readUint(3);
+
+        if(!m_dec->FLACMetadataBlock->numChannels){
+            if(m_dec->FLACFrameHeader->chanAsgn == 0) m_dec->FLACMetadataBlock->numChannels = 1;
+            if(m_dec->FLACFrameHeader->chanAsgn == 1) m_dec->FLACMetadataBlock->numChannels = 2;
+            if(m_dec->FLACFrameHeader->chanAsgn > 7)  m_dec->FLACMetadataBlock->numChannels = 2;
         }
-        if(FLACMetadataBlock->numChannels < 1) return ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT;
-
-        if(!FLACMetadataBlock->bitsPerSample){
-            if(FLACFrameHeader->sampleSizeCode == 1) FLACMetadataBlock->bitsPerSample =  8;
-            if(FLACFrameHeader->sampleSizeCode == 2) FLACMetadataBlock->bitsPerSample = 12;
-            if(FLACFrameHeader->sampleSizeCode == 4) FLACMetadataBlock->bitsPerSample = 16;
-            if(FLACFrameHeader->sampleSizeCode == 5) FLACMetadataBlock->bitsPerSample = 20;
-            if(FLACFrameHeader->sampleSizeCode == 6) FLACMetadataBlock->bitsPerSample = 24;
+        if(m_dec->FLACMetadataBlock->numChannels < 1) return ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT;
+
+        if(!m_dec->FLACMetadataBlock->bitsPerSample){
+            if(m_dec->FLACFrameHeader->sampleSizeCode == 1) m_dec->FLACMetadataBlock->bitsPerSample =  8;
+            if(m_dec->FLACFrameHeader->sampleSizeCode == 2) m_dec->FLACMetadataBlock->bitsPerSample = 12;
+            if(m_dec->FLACFrameHeader->sampleSizeCode == 4) m_dec->FLACMetadataBlock->bitsPerSample = 16;
+            if(m_dec->FLACFrameHeader->sampleSizeCode == 5) m_dec->FLACMetadataBlock->bitsPerSample = 20;
+            if(m_dec->FLACFrameHeader->sampleSizeCode == 6) m_dec->FLACMetadataBlock->bitsPerSample = 24;
         }
-        if(FLACMetadataBlock->bitsPerSample > 16) return ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG;
-        if(FLACMetadataBlock->bitsPerSample < 8 ) return ERR_FLAG_BITS_PER_SAMPLE_UNKNOWN;
-
-        if(!FLACMetadataBlock->sampleRate){
-            if(FLACFrameHeader->sampleRateCode == 1)  FLACMetadataBlock->sampleRate =  88200;
-            if(FLACFrameHeader->sampleRateCode == 2)  FLACMetadataBlock->sampleRate = 176400;
-            if(FLACFrameHeader->sampleRateCode == 3)  FLACMetadataBlock->sampleRate = 192000;
-            if(FLACFrameHeader->sampleRateCode == 4)  FLACMetadataBlock->sampleRate =   8000;
-            if(FLACFrameHeader->sampleRateCode == 5)  FLACMetadataBlock->sampleRate =  16000;
-            if(FLACFrameHeader->sampleRateCode == 6)  FLACMetadataBlock->sampleRate =  22050;
-            if(FLACFrameHeader->sampleRateCode == 7)  FLACMetadataBlock->sampleRate =  24000;
-            if(FLACFrameHeader->sampleRateCode == 8)  FLACMetadataBlock->sampleRate =  32000;
-            if(FLACFrameHeader->sampleRateCode == 9)  FLACMetadataBlock->sampleRate =  44100;
-            if(FLACFrameHeader->sampleRateCode == 10) FLACMetadataBlock->sampleRate =  48000;
-            if(FLACFrameHeader->sampleRateCode == 11) FLACMetadataBlock->sampleRate =  96000;
+        if(m_dec->FLACMetadataBlock->bitsPerSample > 24) return ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG;
+        if(m_dec->FLACMetadataBlock->bitsPerSample < 8 ) return ERR_FLAG_BITS_PER_SAMPLE_UNKNOWN;
+
+        if(!m_dec->FLACMetadataBlock->sampleRate){
+            if(m_dec->FLACFrameHeader->sampleRateCode == 1)  m_dec->FLACMetadataBlock->sampleRate =  88200;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 2)  m_dec->FLACMetadataBlock->sampleRate = 176400;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 3)  m_dec->FLACMetadataBlock->sampleRate = 192000;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 4)  m_dec->FLACMetadataBlock->sampleRate =   8000;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 5)  m_dec->FLACMetadataBlock->sampleRate =  16000;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 6)  m_dec->FLACMetadataBlock->sampleRate =  22050;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 7)  m_dec->FLACMetadataBlock->sampleRate =  24000;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 8)  m_dec->FLACMetadataBlock->sampleRate =  32000;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 9)  m_dec->FLACMetadataBlock->sampleRate =  44100;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 10) m_dec->FLACMetadataBlock->sampleRate =  48000;
+            if(m_dec->FLACFrameHeader->sampleRateCode == 11) m_dec->FLACMetadataBlock->sampleRate =  96000;
         }
 
         readUint(1);
@@ -283,146 +515,219 @@ int8_t FLACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf){
         }
         count--;
         for (int i = 0; i < count; i++) readUint(8);
-        m_blockSize = 0;
-
-        if (FLACFrameHeader->blockSizeCode == 1)
-            m_blockSize = 192;
-        else if (2 <= FLACFrameHeader->blockSizeCode && FLACFrameHeader->blockSizeCode <= 5)
-            m_blockSize = 576 << (FLACFrameHeader->blockSizeCode - 2);
-        else if (FLACFrameHeader->blockSizeCode == 6)
-            m_blockSize = readUint(8) + 1;
-        else if (FLACFrameHeader->blockSizeCode == 7)
-            m_blockSize = readUint(16) + 1;
-        else if (8 <= FLACFrameHeader->blockSizeCode && FLACFrameHeader->blockSizeCode <= 15)
-            m_blockSize = 256 << (FLACFrameHeader->blockSizeCode - 8);
+        m_dec->blockSize = 0;
+
+        if (m_dec->FLACFrameHeader->blockSizeCode == 1)
+            m_dec->blockSize = 192;
+        else if (2 <= m_dec->FLACFrameHeader->blockSizeCode && m_dec->FLACFrameHeader->blockSizeCode <= 5)
+            m_dec->blockSize = 576 << (m_dec->FLACFrameHeader->blockSizeCode - 2);
+        else if (m_dec->FLACFrameHeader->blockSizeCode == 6)
+            m_dec->blockSize = readUint(8) + 1;
+        else if (m_dec->FLACFrameHeader->blockSizeCode == 7)
+            m_dec->blockSize = readUint(16) + 1;
+        else if (8 <= m_dec->FLACFrameHeader->blockSizeCode && m_dec->FLACFrameHeader->blockSizeCode <= 15)
+            m_dec->blockSize = 256 << (m_dec->FLACFrameHeader->blockSizeCode - 8);
         else{
             return ERR_FLAC_RESERVED_BLOCKSIZE_UNSUPPORTED;
         }
 
-        if(m_blockSize > 8192){
+        if(m_dec->blockSize > MAX_BLOCKSIZE){
             log_e("Error: blockSize too big");
             return ERR_FLAC_BLOCKSIZE_TOO_BIG;
         }
+        uint8_t chans = (m_dec->FLACMetadataBlock->numChannels > 1 || m_dec->FLACFrameHeader->chanAsgn > 0) ? 2 : 1;
+        if(!FLACAllocSamplesBuffer(m_dec, m_dec->blockSize, chans)) return ERR_FLAC_OUT_OF_MEMORY;
 
-        if(FLACFrameHeader->sampleRateCode == 12)
+        if(m_dec->FLACFrameHeader->sampleRateCode == 12)
             readUint(8);
-        else if (FLACFrameHeader->sampleRateCode == 13 || FLACFrameHeader->sampleRateCode == 14){
+        else if (m_dec->FLACFrameHeader->sampleRateCode == 13 || m_dec->FLACFrameHeader->sampleRateCode == 14){
             readUint(16);
         }
         readUint(8);
-        m_status = DECODE_SUBFRAMES;
-        *bytesLeft = m_bytesAvail;
-        m_blockSizeLeft = m_blockSize;
+        alignToByte();  // CRC-8, the header ends on a byte boundary
+        m_dec->status = DECODE_SUBFRAMES;
+        *bytesLeft = m_dec->bytesAvail;
+        m_dec->blockSizeLeft = m_dec->blockSize;
 
         return ERR_FLAC_NONE;
     }
 
-    if(m_status == DECODE_SUBFRAMES){
+    if(m_dec->status == DECODE_SUBFRAMES){
 
         // Decode each channel's subframe, then skip footer
+#ifdef FLAC_PROFILE
+        uint32_t t0 = ESP.getCycleCount();
+#endif
         int ret = decodeSubframes();
         if(ret != 0) return ret;
-        m_status = OUT_SAMPLES;
+        alignToByte();
+        uint16_t crc = readUint(16);
+        alignToByte();  // CRC-16 of the whole frame
+        if(m_dec->crcCheck && crc != crc16(m_dec->frameCRC, m_dec->inptr, m_dec->rIndex - 2)){
+            log_i("frame CRC-16 mismatch");
+            m_dec->status = DECODE_FRAME;
+            return ERR_FLAC_CRC_MISMATCH;
+        }
+#ifdef FLAC_PROFILE
+        m_dec->profCycles += ESP.getCycleCount() - t0;
+        m_dec->profSamples += m_dec->blockSize;
+        if(++m_dec->profFrames == 256){
+            log_i("FLAC %lu cycles/sample, residuals %lu", (unsigned long)(m_dec->profCycles / m_dec->profSamples),
+                  (unsigned long)(m_dec->profResidual / m_dec->profSamples));
+            m_dec->profFrames = 0; m_dec->profSamples = 0; m_dec->profCycles = 0; m_dec->profResidual = 0;
+        }
+#endif
+        m_dec->status = OUT_SAMPLES;
     }
 
-    if(m_status == OUT_SAMPLES){  // Write the decoded samples
+    if(m_dec->status == OUT_SAMPLES){  // Write the decoded samples
         // blocksize can be much greater than outbuff, so we can't stuff all in once
         // therefore we need often more than one loop (split outputblock into pieces)
         uint16_t blockSize;
-        static uint16_t offset = 0;
-        if(m_blockSize < outBuffSize + offset) blockSize = m_blockSize - offset;
+        if(m_dec->blockSize < outBuffSize + m_dec->offset) blockSize = m_dec->blockSize - m_dec->offset;
         else blockSize = outBuffSize;
 
 
-        for (int i = 0; i < blockSize; i++) {
-            for (int j = 0; j < FLACMetadataBlock->numChannels; j++) {
-                int val = FLACsubFramesBuff->samplesBuffer[j][i + offset];
-                if (FLACMetadataBlock->bitsPerSample == 8) val += 128;
-                outbuf[2*i+j] = val;
+        uint8_t d = FLACDecimation(m_dec);
+        uint8_t bps = m_dec->FLACMetadataBlock->bitsPerSample;
+        int8_t  sh = (bps == 8) ? 0 : bps - 16;  // > 0: 20/24 bit streams are cut to 16 bit, < 0: 12 bit is scaled up
+        if(d == 1){
+            for (int i = 0; i < blockSize; i++) {
+                for (int j = 0; j < m_dec->FLACMetadataBlock->numChannels; j++) {
+                    int val = m_dec->FLACsubFramesBuff->samplesBuffer[j][i + m_dec->offset];
+                    if (bps == 8) val += 128;
+                    else if (sh > 0) val >>= sh;
+                    else if (sh < 0) val <<= -sh;
+                    outbuf[2*i+j] = val;
+                }
             }
+            m_dec->validSamples = blockSize * m_dec->FLACMetadataBlock->numChannels;
         }
+        else{ // rate limited, every output sample is the mean of d input samples
+            int n = 0;
+            for (int i = 0; i < blockSize; i += d, n++) {
+                int m = (blockSize - i < d) ? blockSize - i : d;
+                for (int j = 0; j < m_dec->FLACMetadataBlock->numChannels; j++) {
+                    int32_t* s = &m_dec->FLACsubFramesBuff->samplesBuffer[j][i + m_dec->offset];
+                    int sum = 0;
+                    for (int k = 0; k < m; k++) sum += s[k];
+                    int val = sum / m;
+                    if (bps == 8) val += 128;
+                    else if (sh > 0) val >>= sh;
+                    else if (sh < 0) val <<= -sh;
+                    outbuf[2*n+j] = val;
+                }
+            }
+            m_dec->validSamples = n * m_dec->FLACMetadataBlock->numChannels;
+        }
+        m_dec->offset += blockSize;
 
-        m_validSamples = blockSize * FLACMetadataBlock->numChannels;
-        offset += blockSize;
-
-        if(offset != m_blockSize) return GIVE_NEXT_LOOP;
-        offset = 0;
-        if(offset > m_blockSize) { log_e("offset has a wrong value"); }
+        if(m_dec->offset != m_dec->blockSize) return GIVE_NEXT_LOOP;
+        m_dec->offset = 0;
     }
 
-    alignToByte();
-    readUint(16);
-    m_bytesDecoded = *bytesLeft - m_bytesAvail;
-//    log_i("m_bytesDecoded %i", m_bytesDecoded);
-//    m_compressionRatio = (float)m_bytesDecoded / (float)m_blockSize * FLACMetadataBlock->numChannels * (16/8);
-//    log_i("m_compressionRatio % f", m_compressionRatio);
-    *bytesLeft = m_bytesAvail;
-    m_status = DECODE_FRAME;
+    m_dec->bytesDecoded = *bytesLeft - m_dec->bytesAvail;
+//    log_i("m_dec->bytesDecoded %i", m_dec->bytesDecoded);
+//    m_dec->compressionRatio = (float)m_dec->bytesDecoded / (float)m_dec->blockSize * m_dec->FLACMetadataBlock->numChannels * (16/8);
+//    log_i("m_dec->compressionRatio % f", m_dec->compressionRatio);
+    *bytesLeft = m_dec->bytesAvail;
+    m_dec->status = DECODE_FRAME;
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint16_t FLACGetOutputSamps(){
-    int vs = m_validSamples;
-    m_validSamples=0;
+uint16_t FLACGetOutputSamps(FLACDecoder_t* dec){
+    int vs = dec->validSamples;
+    dec->validSamples=0;
     return vs;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint64_t FLACGetTotoalSamplesInStream(){
-    return FLACMetadataBlock->totalSamples;
+uint64_t FLACGetTotoalSamplesInStream(FLACDecoder_t* dec){
+    return dec->FLACMetadataBlock->totalSamples;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint8_t FLACGetBitsPerSample(){
-    return FLACMetadataBlock->bitsPerSample;
+uint8_t FLACGetBitsPerSample(FLACDecoder_t* dec){ // of the output samples, 8 or 16
+    return (dec->FLACMetadataBlock->bitsPerSample == 8) ? 8 : 16;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint8_t FLACGetChannels(){
-    return FLACMetadataBlock->numChannels;
+uint8_t FLACGetChannels(FLACDecoder_t* dec){
+    return dec->FLACMetadataBlock->numChannels;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t FLACGetSampRate(){
-    return FLACMetadataBlock->sampleRate;
+uint32_t FLACGetSampRate(FLACDecoder_t* dec){ // output rate, see FLACSetQuality()
+    return dec->FLACMetadataBlock->sampleRate / FLACDecimation(dec);
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t FLACGetBitRate(){
-    if(FLACMetadataBlock->totalSamples){
-        float BitsPerSamp = (float)FLACMetadataBlock->audioDataLength / (float)FLACMetadataBlock->totalSamples * 8;
-        return ((uint32_t)BitsPerSamp * FLACMetadataBlock->sampleRate);
+uint32_t FLACGetBitRate(FLACDecoder_t* dec){
+    if(dec->FLACMetadataBlock->totalSamples){
+        float BitsPerSamp = (float)dec->FLACMetadataBlock->audioDataLength / (float)dec->FLACMetadataBlock->totalSamples * 8;
+        return ((uint32_t)BitsPerSamp * dec->FLACMetadataBlock->sampleRate);
     }
     return 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t FLACGetAudioFileDuration() {
-    if(FLACGetSampRate()){
-        uint32_t afd = FLACGetTotoalSamplesInStream()/ FLACGetSampRate(); // AudioFileDuration
+uint32_t FLACGetAudioFileDuration(FLACDecoder_t* dec) {
+    if(dec->FLACMetadataBlock->sampleRate){
+        uint32_t afd = FLACGetTotoalSamplesInStream(dec)/ dec->FLACMetadataBlock->sampleRate; // AudioFileDuration
         return afd;
     }
     return 0;
 }
 //----------------------------------------------------------------------------------------------------------------------
+void FLACSetQuality(FLACDecoder_t* dec, uint8_t level){
+    // FLAC_QUALITY_48K: 88.2/96kHz streams are played at 44.1/48kHz, 176.4/192kHz likewise. The subframes are still
+    // decoded at the stream rate, the output (I2S, filters, audio_process_extern) runs at the lower rate.
+    // Pairs or quads are averaged, this damps but does not remove content above the new Nyquist frequency.
+    // Takes effect with the next output chunk, FLACGetSampRate() follows.
+    if(dec) dec->quality = (level > FLAC_QUALITY_48K) ? (uint8_t)FLAC_QUALITY_48K : level;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FLACSetCRCCheck(FLACDecoder_t* dec, bool on){
+    // on: a frame with a wrong CRC-16 is dropped before its samples are output, FLACDecode() returns
+    // ERR_FLAC_CRC_MISMATCH and the caller resyncs. The header CRC-8 is always checked.
+    // Off by default, the CRC-16 (slice-by-4) adds 6...12% to the decode time of 16 bit stereo in flac_resync_test
+    // on the host, not measured on an ESP32
+    if(dec) dec->crcCheck = on;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint8_t FLACDecimation(FLACDecoder_t* dec){
+    if(dec->quality == FLAC_QUALITY_FULL || dec->FLACMetadataBlock->sampleRate <= 48000) return 1;
+    return (dec->FLACMetadataBlock->sampleRate > 96000) ? 4 : 2;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint16_t FLACGetOutputSamps()           {return FLACGetOutputSamps(m_defaultDec);}
+uint64_t FLACGetTotoalSamplesInStream() {return FLACGetTotoalSamplesInStream(m_defaultDec);}
+uint8_t  FLACGetBitsPerSample()         {return FLACGetBitsPerSample(m_defaultDec);}
+uint8_t  FLACGetChannels()              {return FLACGetChannels(m_defaultDec);}
+uint32_t FLACGetSampRate()              {return FLACGetSampRate(m_defaultDec);}
+uint32_t FLACGetBitRate()               {return FLACGetBitRate(m_defaultDec);}
+uint32_t FLACGetAudioFileDuration()     {return FLACGetAudioFileDuration(m_defaultDec);}
+void     FLACSetQuality(uint8_t level)  {FLACSetQuality(m_defaultDec, level);}
+void     FLACSetCRCCheck(bool on)       {FLACSetCRCCheck(m_defaultDec, on);}
+//----------------------------------------------------------------------------------------------------------------------
 int8_t decodeSubframes(){
-    if(FLACFrameHeader->chanAsgn <= 7) {
-        for (int ch = 0; ch < FLACMetadataBlock->numChannels; ch++)
-            decodeSubframe(FLACMetadataBlock->bitsPerSample, ch);
-    }
-    else if (8 <= FLACFrameHeader->chanAsgn && FLACFrameHeader->chanAsgn <= 10) {
-        decodeSubframe(FLACMetadataBlock->bitsPerSample + (FLACFrameHeader->chanAsgn == 9 ? 1 : 0), 0);
-        decodeSubframe(FLACMetadataBlock->bitsPerSample + (FLACFrameHeader->chanAsgn == 9 ? 0 : 1), 1);
-        if(FLACFrameHeader->chanAsgn == 8) {
-            for (int i = 0; i < m_blockSize; i++)
-                FLACsubFramesBuff->samplesBuffer[1][i] = (
-                        FLACsubFramesBuff->samplesBuffer[0][i] -
-                        FLACsubFramesBuff->samplesBuffer[1][i]);
+    if(m_dec->FLACFrameHeader->chanAsgn <= 7) {
+        for (int ch = 0; ch < m_dec->FLACMetadataBlock->numChannels; ch++)
+            decodeSubframe(m_dec->FLACMetadataBlock->bitsPerSample, ch);
+    }
+    else if (8 <= m_dec->FLACFrameHeader->chanAsgn && m_dec->FLACFrameHeader->chanAsgn <= 10) {
+        decodeSubframe(m_dec->FLACMetadataBlock->bitsPerSample + (m_dec->FLACFrameHeader->chanAsgn == 9 ? 1 : 0), 0);
+        decodeSubframe(m_dec->FLACMetadataBlock->bitsPerSample + (m_dec->FLACFrameHeader->chanAsgn == 9 ? 0 : 1), 1);
+        if(m_dec->FLACFrameHeader->chanAsgn == 8) {
+            for (int i = 0; i < m_dec->blockSize; i++)
+                m_dec->FLACsubFramesBuff->samplesBuffer[1][i] = (
+                        m_dec->FLACsubFramesBuff->samplesBuffer[0][i] -
+                        m_dec->FLACsubFramesBuff->samplesBuffer[1][i]);
         }
-        else if (FLACFrameHeader->chanAsgn == 9) {
-            for (int i = 0; i < m_blockSize; i++)
-                FLACsubFramesBuff->samplesBuffer[0][i] += FLACsubFramesBuff->samplesBuffer[1][i];
+        else if (m_dec->FLACFrameHeader->chanAsgn == 9) {
+            for (int i = 0; i < m_dec->blockSize; i++)
+                m_dec->FLACsubFramesBuff->samplesBuffer[0][i] += m_dec->FLACsubFramesBuff->samplesBuffer[1][i];
         }
-        else if (FLACFrameHeader->chanAsgn == 10) {
-            for (int i = 0; i < m_blockSize; i++) {
-                long side =  FLACsubFramesBuff->samplesBuffer[1][i];
-                long right = FLACsubFramesBuff->samplesBuffer[0][i] - (side >> 1);
-                FLACsubFramesBuff->samplesBuffer[1][i] = right;
-                FLACsubFramesBuff->samplesBuffer[0][i] = right + side;
+        else if (m_dec->FLACFrameHeader->chanAsgn == 10) {
+            for (int i = 0; i < m_dec->blockSize; i++) {
+                long side =  m_dec->FLACsubFramesBuff->samplesBuffer[1][i];
+                long right = m_dec->FLACsubFramesBuff->samplesBuffer[0][i] - (side >> 1);
+                m_dec->FLACsubFramesBuff->samplesBuffer[1][i] = right;
+                m_dec->FLACsubFramesBuff->samplesBuffer[0][i] = right + side;
             }
         }
         else {
@@ -449,14 +754,14 @@ int8_t decodeSubframe(uint8_t sampleDepth, uint8_t ch) {
     sampleDepth -= shift;
 
     if(type == 0){  // Constant coding
-        int16_t s= readSignedInt(sampleDepth);
-        for(int i=0; i < m_blockSize; i++){
-            FLACsubFramesBuff->samplesBuffer[ch][i] = s;
+        int32_t s= readSignedInt(sampleDepth);
+        for(int i=0; i < m_dec->blockSize; i++){
+            m_dec->FLACsubFramesBuff->samplesBuffer[ch][i] = s;
         }
     }
     else if (type == 1) {  // Verbatim coding
-        for (int i = 0; i < m_blockSize; i++)
-            FLACsubFramesBuff->samplesBuffer[ch][i] = readSignedInt(sampleDepth);
+        for (int i = 0; i < m_dec->blockSize; i++)
+            m_dec->FLACsubFramesBuff->samplesBuffer[ch][i] = readSignedInt(sampleDepth);
     }
     else if (8 <= type && type <= 12){
         ret = decodeFixedPredictionSubframe(type - 8, sampleDepth, ch);
@@ -470,8 +775,8 @@ int8_t decodeSubframe(uint8_t sampleDepth, uint8_t ch) {
         return ERR_FLAC_RESERVED_SUB_TYPE;
     }
     if(shift>0){
-        for (int i = 0; i < m_blockSize; i++){
-            FLACsubFramesBuff->samplesBuffer[ch][i] <<= shift;
+        for (int i = 0; i < m_dec->blockSize; i++){
+            m_dec->FLACsubFramesBuff->samplesBuffer[ch][i] <<= shift;
         }
     }
     return ERR_FLAC_NONE;
@@ -480,37 +785,38 @@ int8_t decodeSubframe(uint8_t sampleDepth, uint8_t ch) {
 int8_t decodeFixedPredictionSubframe(uint8_t predOrder, uint8_t sampleDepth, uint8_t ch) {
     uint8_t ret = 0;
     for(uint8_t i = 0; i < predOrder; i++)
-        FLACsubFramesBuff->samplesBuffer[ch][i] = readSignedInt(sampleDepth);
+        m_dec->FLACsubFramesBuff->samplesBuffer[ch][i] = readSignedInt(sampleDepth);
     ret = decodeResiduals(predOrder, ch);
     if(ret) return ret;
-    coefs.clear();
-    if(predOrder == 0) coefs.resize(0);
-    if(predOrder == 1) coefs.push_back(1);  // FIXED_PREDICTION_COEFFICIENTS
-    if(predOrder == 2){coefs.push_back(2); coefs.push_back(-1);}
-    if(predOrder == 3){coefs.push_back(3); coefs.push_back(-3); coefs.push_back(1);}
-    if(predOrder == 4){coefs.push_back(4); coefs.push_back(-6); coefs.push_back(4); coefs.push_back(-1);}
     if(predOrder > 4) return ERR_FLAC_PREORDER_TOO_BIG; // Error: preorder > 4"
-    restoreLinearPrediction(ch, 0);
+    static const int8_t fixedCoefs[5][4] = {{0}, {1}, {2, -1}, {3, -3, 1}, {4, -6, 4, -1}};  // FIXED_PREDICTION_COEFFICIENTS
+    for(uint8_t i = 0; i < predOrder; i++) m_dec->coefs[i] = fixedCoefs[predOrder][i];
+    m_dec->coefsLen = predOrder;
+    restoreLinearPrediction(ch, 0, false);
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
 int8_t decodeLinearPredictiveCodingSubframe(int lpcOrder, int sampleDepth, uint8_t ch){
     int8_t ret = 0;
     for (int i = 0; i < lpcOrder; i++)
-        FLACsubFramesBuff->samplesBuffer[ch][i] = readSignedInt(sampleDepth);
+        m_dec->FLACsubFramesBuff->samplesBuffer[ch][i] = readSignedInt(sampleDepth);
     int precision = readUint(4) + 1;
     int shift = readSignedInt(5);
-    coefs.resize(0);
     for (uint8_t i = 0; i < lpcOrder; i++)
-        coefs.push_back(readSignedInt(precision));
+        m_dec->coefs[i] = readSignedInt(precision);
+    m_dec->coefsLen = lpcOrder;
     ret = decodeResiduals(lpcOrder, ch);
     if(ret) return ret;
-    restoreLinearPrediction(ch, shift);
+    uint8_t orderBits = 0;
+    while ((1 << orderBits) < lpcOrder) orderBits++;
+    restoreLinearPrediction(ch, shift, sampleDepth + precision + orderBits > 32);
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
 int8_t decodeResiduals(uint8_t warmup, uint8_t ch) {
-
+#ifdef FLAC_PROFILE
+    uint32_t t0 = ESP.getCycleCount();
+#endif
     int method = readUint(2);
     if (method >= 2)
         return ERR_FLAC_RESERVED_RESIDUAL_CODING; // Reserved residual coding method
@@ -519,9 +825,9 @@ int8_t decodeResiduals(uint8_t warmup, uint8_t ch) {
     int partitionOrder = readUint(4);
 
     int numPartitions = 1 << partitionOrder;
-    if (m_blockSize % numPartitions != 0)
+    if (m_dec->blockSize % numPartitions != 0)
         return ERR_FLAC_WRONG_RICE_PARTITION_NR; //Error: Block size not divisible by number of Rice partitions
-    int partitionSize = m_blockSize/ numPartitions;
+    int partitionSize = m_dec->blockSize/ numPartitions;
 
     for (int i = 0; i < numPartitions; i++) {
         int start = i * partitionSize + (i == 0 ? warmup : 0);
@@ -529,28 +835,110 @@ int8_t decodeResiduals(uint8_t warmup, uint8_t ch) {
 
         int param = readUint(paramBits);
         if (param < escapeParam) {
+#ifdef FLAC_RICE_REFERENCE
             for (int j = start; j < end; j++){
-                FLACsubFramesBuff->samplesBuffer[ch][j] = readRiceSignedInt(param);
+                m_dec->FLACsubFramesBuff->samplesBuffer[ch][j] = readRiceSignedInt(param);
             }
+#else
+            readRicePartition(&m_dec->FLACsubFramesBuff->samplesBuffer[ch][start], end - start, param);
+#endif
         } else {
             int numBits = readUint(5);
             for (int j = start; j < end; j++){
-                FLACsubFramesBuff->samplesBuffer[ch][j] = readSignedInt(numBits);
+                m_dec->FLACsubFramesBuff->samplesBuffer[ch][j] = readSignedInt(numBits);
             }
         }
     }
+#ifdef FLAC_PROFILE
+    m_dec->profResidual += ESP.getCycleCount() - t0;
+#endif
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void restoreLinearPrediction(uint8_t ch, uint8_t shift) {
-
-    for (int i = coefs.size(); i < m_blockSize; i++) {
+static inline __attribute__((always_inline))
+void restoreLPC32(int32_t* s, int n, const int32_t* coefs, const int order, uint8_t shift) {
+    // called with a constant order, the compiler builds one unrolled loop per order
+    int32_t c[12];
+    for (int j = 0; j < order; j++) c[j] = coefs[j];
+    for (int i = order; i < n; i++) {
+        const int32_t* h = s + i;
         int32_t sum = 0;
-        for (int j = 0; j < coefs.size(); j++){
-            sum += FLACsubFramesBuff->samplesBuffer[ch][i - 1 - j] * coefs[j];
+        switch (order) {
+            case 12: sum += c[11] * h[-12];  // fall through
+            case 11: sum += c[10] * h[-11];  // fall through
+            case 10: sum += c[9] * h[-10];  // fall through
+            case 9: sum += c[8] * h[-9];  // fall through
+            case 8: sum += c[7] * h[-8];  // fall through
+            case 7: sum += c[6] * h[-7];  // fall through
+            case 6: sum += c[5] * h[-6];  // fall through
+            case 5: sum += c[4] * h[-5];  // fall through
+            case 4: sum += c[3] * h[-4];  // fall through
+            case 3: sum += c[2] * h[-3];  // fall through
+            case 2: sum += c[1] * h[-2];  // fall through
+            case 1:  sum += c[0] * h[-1];
+        }
+        s[i] += (sum >> shift);
+    }
+}
+static inline __attribute__((always_inline))
+void restoreLPC64(int32_t* s, int n, const int32_t* coefs, const int order, uint8_t shift) {
+    int32_t c[12];
+    for (int j = 0; j < order; j++) c[j] = coefs[j];
+    for (int i = order; i < n; i++) {
+        const int32_t* h = s + i;
+        int64_t sum = 0;
+        switch (order) {
+            case 12: sum += (int64_t)c[11] * h[-12];  // fall through
+            case 11: sum += (int64_t)c[10] * h[-11];  // fall through
+            case 10: sum += (int64_t)c[9] * h[-10];  // fall through
+            case 9: sum += (int64_t)c[8] * h[-9];  // fall through
+            case 8: sum += (int64_t)c[7] * h[-8];  // fall through
+            case 7: sum += (int64_t)c[6] * h[-7];  // fall through
+            case 6: sum += (int64_t)c[5] * h[-6];  // fall through
+            case 5: sum += (int64_t)c[4] * h[-5];  // fall through
+            case 4: sum += (int64_t)c[3] * h[-4];  // fall through
+            case 3: sum += (int64_t)c[2] * h[-3];  // fall through
+            case 2: sum += (int64_t)c[1] * h[-2];  // fall through
+            case 1:  sum += (int64_t)c[0] * h[-1];
         }
-        FLACsubFramesBuff->samplesBuffer[ch][i] += (sum >> shift);
+        s[i] += (int32_t)(sum >> shift);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void restoreLinearPrediction(uint8_t ch, uint8_t shift, bool wide) {
+    // wide: the prediction sum may exceed 32 bits (sample depth + coef precision + log2(order) > 32), e.g. the side
+    // channel of 24 bit streams
+    int32_t* s = m_dec->FLACsubFramesBuff->samplesBuffer[ch];
+    const int32_t* c = m_dec->coefs;
+    int n = m_dec->blockSize;
+
+    switch (m_dec->coefsLen) {
+        case 0:  break;
+        case 1:  if (wide) restoreLPC64(s, n, c,  1, shift); else restoreLPC32(s, n, c,  1, shift); break;
+        case 2:  if (wide) restoreLPC64(s, n, c,  2, shift); else restoreLPC32(s, n, c,  2, shift); break;
+        case 3:  if (wide) restoreLPC64(s, n, c,  3, shift); else restoreLPC32(s, n, c,  3, shift); break;
+        case 4:  if (wide) restoreLPC64(s, n, c,  4, shift); else restoreLPC32(s, n, c,  4, shift); break;
+        case 5:  if (wide) restoreLPC64(s, n, c,  5, shift); else restoreLPC32(s, n, c,  5, shift); break;
+        case 6:  if (wide) restoreLPC64(s, n, c,  6, shift); else restoreLPC32(s, n, c,  6, shift); break;
+        case 7:  if (wide) restoreLPC64(s, n, c,  7, shift); else restoreLPC32(s, n, c,  7, shift); break;
+        case 8:  if (wide) restoreLPC64(s, n, c,  8, shift); else restoreLPC32(s, n, c,  8, shift); break;
+        case 9:  if (wide) restoreLPC64(s, n, c,  9, shift); else restoreLPC32(s, n, c,  9, shift); break;
+        case 10: if (wide) restoreLPC64(s, n, c, 10, shift); else restoreLPC32(s, n, c, 10, shift); break;
+        case 11: if (wide) restoreLPC64(s, n, c, 11, shift); else restoreLPC32(s, n, c, 11, shift); break;
+        case 12: if (wide) restoreLPC64(s, n, c, 12, shift); else restoreLPC32(s, n, c, 12, shift); break;
+        default:  // orders 13...32
+            for (int i = m_dec->coefsLen; i < n; i++) {
+                if (wide) {
+                    int64_t sum = 0;
+                    for (int j = 0; j < m_dec->coefsLen; j++) sum += (int64_t)s[i - 1 - j] * c[j];
+                    s[i] += (int32_t)(sum >> shift);
+                }
+                else {
+                    int32_t sum = 0;
+                    for (int j = 0; j < m_dec->coefsLen; j++) sum += s[i - 1 - j] * c[j];
+                    s[i] += (sum >> shift);
+                }
+            }
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
-
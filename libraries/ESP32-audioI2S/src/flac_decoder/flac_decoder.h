@@ -8,7 +8,7 @@
  *
  *  Restrictions:
  *  blocksize must not exceed 8192
- *  bits per sample must be 8 or 16
+ *  bits per sample 8...24, streams with more than 16 bits are played with 16 bits
  *  num Channels must be 1 or 2
  *
  *
@@ -18,6 +18,11 @@
 
 #include "Arduino.h"
 
+//#define FLAC_RICE_REFERENCE       // decode the rice codes bit by bit and refill the bit reader byte by byte, as before
+                                    // the clz partition decoder, for comparison
+//#define FLAC_PROFILE              // log the CPU cycles per sample of the subframes and of their residuals every
+                                    // 256 frames
+
 #define MAX_CHANNELS 2
 #define MAX_BLOCKSIZE 8192
 #define APLL_DISABLE 0
@@ -25,10 +30,14 @@
 
 
 typedef struct FLACsubFramesBuff_t{
-    int32_t samplesBuffer[MAX_CHANNELS][MAX_BLOCKSIZE];
+    int32_t* samplesBuffer[MAX_CHANNELS];  // allocated with the first frame, grows with bigger blocks
+    uint16_t size;                         // samples per channel
+    uint8_t  chans;                        // allocated channels
 }FLACsubframesBuffer_t;
 
 enum : uint8_t {FLACDECODER_INIT, FLACDECODER_READ_IN, FLACDECODER_WRITE_OUT};
+enum : uint8_t {FLAC_QUALITY_FULL = 0,  // output at the stream rate
+                FLAC_QUALITY_48K = 1};  // streams above 48kHz are decimated by 2 or 4, see FLACSetQuality()
 enum : uint8_t {DECODE_FRAME, DECODE_SUBFRAMES, OUT_SAMPLES};
 enum : int8_t  {GIVE_NEXT_LOOP = +1,
                 ERR_FLAC_NONE = 0,
@@ -42,7 +51,9 @@ enum : int8_t  {GIVE_NEXT_LOOP = +1,
                 ERR_FLAC_RESERVED_RESIDUAL_CODING = -8,
                 ERR_FLAC_WRONG_RICE_PARTITION_NR = -9,
                 ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG = -10,
-                ERR_FLAG_BITS_PER_SAMPLE_UNKNOWN = 11};
+                ERR_FLAG_BITS_PER_SAMPLE_UNKNOWN = 11,
+                ERR_FLAC_OUT_OF_MEMORY = -12,
+                ERR_FLAC_CRC_MISMATCH = -13};
 
 typedef struct FLACMetadataBlock_t{
                               // METADATA_BLOCK_STREAMINFO
@@ -145,12 +156,48 @@ typedef struct FLACFrameHeader_t {
 
 }FLACFrameHeader_t;
 
+/* all state of one decoder instance, created by FLACDecoder_Create()
+ * cost per context on ESP32: 256 bytes (context 196, frame header and metadata 48, FLACsubFramesBuff 12) plus the
+ * samples buffer, 4 bytes per sample and channel of the biggest block so far:
+ *   blocksize 1152 stereo: 9216 bytes, 4096 stereo: 32768 bytes (mono 16384), 8192 stereo: 65536 bytes
+ * independent of the bits per sample. It is allocated with the first frame, in PSRAM if there is one.
+ */
+typedef struct FLACDecoder {
+    FLACFrameHeader_t   *FLACFrameHeader;
+    FLACMetadataBlock_t *FLACMetadataBlock;
+    FLACsubFramesBuff_t *FLACsubFramesBuff;
+    int32_t   coefs[32];            // predictor coefficients of the current subframe
+    uint8_t   coefsLen;             // predictor order
+    uint16_t  blockSize;
+    uint16_t  blockSizeLeft;
+    uint16_t  validSamples;
+    uint8_t   status;
+    uint8_t*  inptr;
+    int32_t   bytesAvail;
+    int32_t   bytesDecoded;
+    float     compressionRatio;
+    uint32_t  rIndex;
+    uint16_t  offset;
+    uint64_t  bitBuffer;
+    uint8_t   bitBufferLen;
+    uint8_t   quality;              // FLAC_QUALITY_xxx
+    bool      crcCheck;             // verify the frame CRC-16, off by default, see FLACSetCRCCheck()
+    uint16_t  frameCRC;             // CRC-16 of the current frame header
+#ifdef FLAC_PROFILE
+    uint32_t  profFrames;
+    uint64_t  profSamples;          // inter-channel samples of profFrames frames
+    uint64_t  profCycles;           // subframes and frame CRC-16
+    uint64_t  profResidual;         // rice partitions
+#endif
+} FLACDecoder_t;
+
+// prototypes, the functions without decoder context work on a default instance
 int      FLACFindSyncWord(unsigned char *buf, int nBytes);
-int      FLACFindOggSyncWord(unsigned char *buf, int nBytes);
-int      FLACparseOggHeader(unsigned char *buf);
+int      FLACParseFrameHeader(const uint8_t *buf, int nBytes, uint16_t nominalBlockSize, uint32_t *firstSample);
 bool     FLACDecoder_AllocateBuffers(void);
 void     FLACDecoder_ClearBuffer();
 void     FLACDecoder_FreeBuffers();
+size_t   FLACDecoder_BufferSize(void);  // bytes FLACDecoder_AllocateBuffers() takes from the arena
 void     FLACSetRawBlockParams(uint8_t Chans, uint32_t SampRate, uint8_t BPS, uint32_t tsis, uint32_t AuDaLength);
 void     FLACDecoderReset();
 int8_t   FLACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf);
@@ -161,15 +208,40 @@ uint8_t  FLACGetChannels();
 uint32_t FLACGetSampRate();
 uint32_t FLACGetBitRate();
 uint32_t FLACGetAudioFileDuration();
+void     FLACSetQuality(uint8_t level);
+void     FLACSetCRCCheck(bool on);
+
+// reentrant API, every context decodes its own stream
+FLACDecoder_t* FLACDecoder_Create(void);
+void     FLACDecoder_Destroy(FLACDecoder_t* dec);
+void     FLACDecoder_ClearBuffer(FLACDecoder_t* dec);
+int      FLACFindSyncWord(FLACDecoder_t* dec, unsigned char *buf, int nBytes);
+void     FLACSetRawBlockParams(FLACDecoder_t* dec, uint8_t Chans, uint32_t SampRate, uint8_t BPS, uint32_t tsis,
+                               uint32_t AuDaLength);
+void     FLACDecoderReset(FLACDecoder_t* dec);
+int8_t   FLACDecode(FLACDecoder_t* dec, uint8_t *inbuf, int *bytesLeft, short *outbuf);
+uint16_t FLACGetOutputSamps(FLACDecoder_t* dec);
+uint64_t FLACGetTotoalSamplesInStream(FLACDecoder_t* dec);
+uint8_t  FLACGetBitsPerSample(FLACDecoder_t* dec);
+uint8_t  FLACGetChannels(FLACDecoder_t* dec);
+uint32_t FLACGetSampRate(FLACDecoder_t* dec);
+uint32_t FLACGetBitRate(FLACDecoder_t* dec);
+uint32_t FLACGetAudioFileDuration(FLACDecoder_t* dec);
+void     FLACSetQuality(FLACDecoder_t* dec, uint8_t level);
+void     FLACSetCRCCheck(FLACDecoder_t* dec, bool on);
+
+//internally used
 uint32_t readUint(uint8_t nBits);
 int32_t  readSignedInt(int nBits);
 int64_t  readRiceSignedInt(uint8_t param);
+void     readRicePartition(int32_t* out, int n, uint8_t param);
 void     alignToByte();
 int8_t   decodeSubframes();
 int8_t   decodeSubframe(uint8_t sampleDepth, uint8_t ch);
 int8_t   decodeFixedPredictionSubframe(uint8_t predOrder, uint8_t sampleDepth, uint8_t ch);
 int8_t   decodeLinearPredictiveCodingSubframe(int lpcOrder, int sampleDepth, uint8_t ch);
 int8_t   decodeResiduals(uint8_t warmup, uint8_t ch);
-void     restoreLinearPrediction(uint8_t ch, uint8_t shift);
-
+void     restoreLinearPrediction(uint8_t ch, uint8_t shift, bool wide);
+uint8_t  FLACDecimation(FLACDecoder_t* dec);
+bool     FLACAllocSamplesBuffer(FLACDecoder_t* dec, uint16_t blockSize, uint8_t chans);
 
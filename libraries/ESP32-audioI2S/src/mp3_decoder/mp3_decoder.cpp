@@ -6,6 +6,9 @@
  *  Updated on: 27.05.2022
  */
 #include "mp3_decoder.h"
+#include "../audio_arena/audio_arena.h"
+#include "../audio_sync/audio_sync.h"
+#include <mutex>
 /* clip to range [-2^n, 2^n - 1] */
 #if 0 //Fast on ARM:
 #define CLIP_2N(y, n) { \
@@ -37,21 +40,13 @@ const uint8_t  m_NGRANS_MPEG2           =1;
 const uint32_t m_SQRTHALF               =0x5a82799a;  // sqrt(0.5) in Q31 format
 
 
-MP3FrameInfo_t *m_MP3FrameInfo;
-SFBandTable_t m_SFBandTable;
-StereoMode_t m_sMode;  /* mono/stereo mode */
-MPEGVersion_t m_MPEGVersion;  /* version ID */
-FrameHeader_t *m_FrameHeader;
-SideInfoSub_t m_SideInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
-SideInfo_t *m_SideInfo;
-CriticalBandInfo_t m_CriticalBandInfo[m_MAX_NCHAN];  /* filled in dequantizer, used in joint stereo reconstruction */
-DequantInfo_t *m_DequantInfo;
-HuffmanInfo_t *m_HuffmanInfo;
-IMDCTInfo_t *m_IMDCTInfo;
-ScaleFactorInfoSub_t m_ScaleFactorInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
-ScaleFactorJS_t *m_ScaleFactorJS;
-SubbandInfo_t *m_SubbandInfo;
-MP3DecInfo_t *m_MP3DecInfo;
+/* The decoder state lives in a MP3Decoder_t context. The API functions make their context the current one of the
+ * calling task, all internal functions work on m_dec. */
+static thread_local MP3Decoder_t *m_dec = NULL;
+static MP3Decoder_t *m_defaultDec = NULL;   // used by the API without context
+static uint16_t *m_huffFast = NULL;          // fast Huffman tables, shared by all contexts
+static uint8_t   m_huffFastUsers = 0;
+static std::mutex m_huffFastLock;            // the contexts can be created and destroyed on different tasks
 
 const unsigned short huffTable[4242] PROGMEM = {
     /* huffTable01[9] */
@@ -432,7 +427,7 @@ const unsigned short huffTable[4242] PROGMEM = {
     0xf001, 0x1a42, 0x1872, 0xf001, 0x1801, 0x1081, 0xf001, 0x1701, 0x1071,
 };
 /* pow(2,-i/4) * pow(j,4/3) for i=0..3 j=0..15, Q25 format */
-const int pow43_14[4][16] PROGMEM = { /* Q28 */
+const int pow43_14[4][16] MP3_DRAM = { /* Q28 */
 {   0x00000000, 0x10000000, 0x285145f3, 0x453a5cdb, 0x0cb2ff53, 0x111989d6,
     0x15ce31c8, 0x1ac7f203, 0x20000000, 0x257106b9, 0x2b16b4a3, 0x30ed74b4,
     0x36f23fa5, 0x3d227bd3, 0x437be656, 0x49fc823c, },
@@ -451,7 +446,7 @@ const int pow43_14[4][16] PROGMEM = { /* Q28 */
 };
 
 /* pow(j,4/3) for j=16..63, Q23 format */
-const int pow43[48] PROGMEM = {
+const int pow43[48] MP3_DRAM = {
     0x1428a2fa, 0x15db1bd6, 0x1796302c, 0x19598d85, 0x1b24e8bb, 0x1cf7fcfa,
     0x1ed28af2, 0x20b4582a, 0x229d2e6e, 0x248cdb55, 0x26832fda, 0x28800000,
     0x2a832287, 0x2c8c70a8, 0x2e9bc5d8, 0x30b0ff99, 0x32cbfd4a, 0x34eca001,
@@ -462,7 +457,7 @@ const int pow43[48] PROGMEM = {
     0x70416360, 0x72d7e8b0, 0x75722ef9, 0x78102b85, 0x7ab1d3ec, 0x7d571e09,
 };
 
-const uint32_t polyCoef[264] PROGMEM = {
+const uint32_t polyCoef[264] MP3_DRAM = {
     /* shuffled vs. original from 0, 1, ... 15 to 0, 15, 2, 13, ... 14, 1 */
     0x00000000, 0x00000074, 0x00000354, 0x0000072c, 0x00001fd4, 0x00005084, 0x000066b8, 0x000249c4,
     0x00049478, 0xfffdb63c, 0x000066b8, 0xffffaf7c, 0x00001fd4, 0xfffff8d4, 0x00000354, 0xffffff8c,
@@ -523,7 +518,7 @@ const int coef32[31] PROGMEM = {
  *      fastWin[2*j+1] = c(j)*(s(j) - c(j))
  * format = Q30
  */
-const uint32_t fastWin36[18] PROGMEM = {
+const uint32_t fastWin36[18] MP3_DRAM = {
         0x42aace8b, 0xc2e92724, 0x47311c28, 0xc95f619a, 0x4a868feb, 0xd0859d8c,
         0x4c913b51, 0xd8243ea0, 0x4d413ccc, 0xe0000000, 0x4c913b51, 0xe7dbc161,
         0x4a868feb, 0xef7a6275, 0x47311c28, 0xf6a09e67, 0x42aace8b, 0xfd16d8dd
@@ -588,7 +583,7 @@ const short slotTab[3][3][15] PROGMEM = {
     },
 };
 
-const uint32_t imdctWin[4][36] PROGMEM = {
+const uint32_t imdctWin[4][36] MP3_DRAM = {
     {
     0x02aace8b, 0x07311c28, 0x0a868fec, 0x0c913b52, 0x0d413ccd, 0x0c913b52, 0x0a868fec, 0x07311c28,
     0x02aace8b, 0xfd16d8dd, 0xf6a09e66, 0xef7a6275, 0xe7dbc161, 0xe0000000, 0xd8243e9f, 0xd0859d8b,
@@ -667,7 +662,7 @@ const uint32_t m_COS3_0 = 0x4545e9ef;  /* Q31 */
 const uint32_t m_COS3_1 = 0x539eba45;  /* Q30 */
 const uint32_t m_COS4_0 = 0x5a82799a;  /* Q31 */
 
-const uint32_t m_dcttab[48] PROGMEM = { // faster in ROM
+const uint32_t m_dcttab[48] MP3_DRAM = { // faster in ROM as long as it stays in the flash cache
     /* first pass */
      m_COS0_0,  m_COS0_15, m_COS1_0,    /* 31, 27, 31 */
      m_COS0_1,  m_COS0_14, m_COS1_1,    /* 31, 29, 31 */
@@ -749,7 +744,7 @@ int CalcBitsUsed(BitStreamInfo_t *bsi, unsigned char *startBuf, int startOffset)
 }
 //----------------------------------------------------------------------------------------------------------------------
 int CheckPadBit(){
-    return (m_FrameHeader->paddingBit ? 1 : 0);
+    return (m_dec->FrameHeader->paddingBit ? 1 : 0);
 }
 //----------------------------------------------------------------------------------------------------------------------
 int UnpackFrameHeader(unsigned char *buf){
@@ -758,49 +753,49 @@ int UnpackFrameHeader(unsigned char *buf){
     if ((buf[0] & m_SYNCWORDH) != m_SYNCWORDH || (buf[1] & m_SYNCWORDL) != m_SYNCWORDL)  return -1;
     /* read header fields - use bitmasks instead of GetBits() for speed, since format never varies */
     verIdx = (buf[1] >> 3) & 0x03;
-    m_MPEGVersion = (MPEGVersion_t) (verIdx == 0 ? MPEG25 : ((verIdx & 0x01) ? MPEG1 : MPEG2));
-    m_FrameHeader->layer = 4 - ((buf[1] >> 1) & 0x03); /* easy mapping of index to layer number, 4 = error */
-    m_FrameHeader->crc = 1 - ((buf[1] >> 0) & 0x01);
-    m_FrameHeader->brIdx = (buf[2] >> 4) & 0x0f;
-    m_FrameHeader->srIdx = (buf[2] >> 2) & 0x03;
-    m_FrameHeader->paddingBit = (buf[2] >> 1) & 0x01;
-    m_FrameHeader->privateBit = (buf[2] >> 0) & 0x01;
-    m_sMode = (StereoMode_t) ((buf[3] >> 6) & 0x03); /* maps to correct enum (see definition) */
-    m_FrameHeader->modeExt = (buf[3] >> 4) & 0x03;
-    m_FrameHeader->copyFlag = (buf[3] >> 3) & 0x01;
-    m_FrameHeader->origFlag = (buf[3] >> 2) & 0x01;
-    m_FrameHeader->emphasis = (buf[3] >> 0) & 0x03;
+    m_dec->MPEGVersion = (MPEGVersion_t) (verIdx == 0 ? MPEG25 : ((verIdx & 0x01) ? MPEG1 : MPEG2));
+    m_dec->FrameHeader->layer = 4 - ((buf[1] >> 1) & 0x03); /* easy mapping of index to layer number, 4 = error */
+    m_dec->FrameHeader->crc = 1 - ((buf[1] >> 0) & 0x01);
+    m_dec->FrameHeader->brIdx = (buf[2] >> 4) & 0x0f;
+    m_dec->FrameHeader->srIdx = (buf[2] >> 2) & 0x03;
+    m_dec->FrameHeader->paddingBit = (buf[2] >> 1) & 0x01;
+    m_dec->FrameHeader->privateBit = (buf[2] >> 0) & 0x01;
+    m_dec->sMode = (StereoMode_t) ((buf[3] >> 6) & 0x03); /* maps to correct enum (see definition) */
+    m_dec->FrameHeader->modeExt = (buf[3] >> 4) & 0x03;
+    m_dec->FrameHeader->copyFlag = (buf[3] >> 3) & 0x01;
+    m_dec->FrameHeader->origFlag = (buf[3] >> 2) & 0x01;
+    m_dec->FrameHeader->emphasis = (buf[3] >> 0) & 0x03;
     /* check parameters to avoid indexing tables with bad values */
-    if (m_FrameHeader->srIdx == 3 || m_FrameHeader->layer == 4 || m_FrameHeader->brIdx == 15) return -1;
+    if (m_dec->FrameHeader->srIdx == 3 || m_dec->FrameHeader->layer == 4 || m_dec->FrameHeader->brIdx == 15) return -1;
     /* for readability (we reference sfBandTable many times in decoder) */
-    m_SFBandTable = sfBandTable[m_MPEGVersion][m_FrameHeader->srIdx];
-    if (m_sMode != Joint) /* just to be safe (dequant, stproc check fh->modeExt) */
-        m_FrameHeader->modeExt = 0;
+    m_dec->SFBandTable = sfBandTable[m_dec->MPEGVersion][m_dec->FrameHeader->srIdx];
+    if (m_dec->sMode != Joint) /* just to be safe (dequant, stproc check fh->modeExt) */
+        m_dec->FrameHeader->modeExt = 0;
     /* init user-accessible data */
-    m_MP3DecInfo->nChans = (m_sMode == Mono ? 1 : 2);
-    m_MP3DecInfo->samprate = samplerateTab[m_MPEGVersion][m_FrameHeader->srIdx];
-    m_MP3DecInfo->nGrans = (m_MPEGVersion == MPEG1 ? m_NGRANS_MPEG1 : m_NGRANS_MPEG2);
-    m_MP3DecInfo->nGranSamps = ((int) samplesPerFrameTab[m_MPEGVersion][m_FrameHeader->layer - 1])/m_MP3DecInfo->nGrans;
-    m_MP3DecInfo->layer = m_FrameHeader->layer;
+    m_dec->MP3DecInfo->nChans = (m_dec->sMode == Mono ? 1 : 2);
+    m_dec->MP3DecInfo->samprate = samplerateTab[m_dec->MPEGVersion][m_dec->FrameHeader->srIdx];
+    m_dec->MP3DecInfo->nGrans = (m_dec->MPEGVersion == MPEG1 ? m_NGRANS_MPEG1 : m_NGRANS_MPEG2);
+    m_dec->MP3DecInfo->nGranSamps = ((int) samplesPerFrameTab[m_dec->MPEGVersion][m_dec->FrameHeader->layer - 1])/m_dec->MP3DecInfo->nGrans;
+    m_dec->MP3DecInfo->layer = m_dec->FrameHeader->layer;
 
     /* get bitrate and nSlots from table, unless brIdx == 0 (free mode) in which case caller must figure it out himself
      * question - do we want to overwrite mp3DecInfo->bitrate with 0 each time if it's free mode, and
      *  copy the pre-calculated actual free bitrate into it in mp3dec.c (according to the spec,
      *  this shouldn't be necessary, since it should be either all frames free or none free)
      */
-    if (m_FrameHeader->brIdx) {
-        m_MP3DecInfo->bitrate=((int) bitrateTab[m_MPEGVersion][m_FrameHeader->layer - 1][m_FrameHeader->brIdx]) * 1000;
+    if (m_dec->FrameHeader->brIdx) {
+        m_dec->MP3DecInfo->bitrate=((int) bitrateTab[m_dec->MPEGVersion][m_dec->FrameHeader->layer - 1][m_dec->FrameHeader->brIdx]) * 1000;
         /* nSlots = total frame bytes (from table) - sideInfo bytes - header - CRC (if present) + pad (if present) */
-        m_MP3DecInfo->nSlots= (int) slotTab[m_MPEGVersion][m_FrameHeader->srIdx][m_FrameHeader->brIdx]
-                - (int) sideBytesTab[m_MPEGVersion][(m_sMode == Mono ? 0 : 1)] - 4
-                - (m_FrameHeader->crc ? 2 : 0) + (m_FrameHeader->paddingBit ? 1 : 0);
+        m_dec->MP3DecInfo->nSlots= (int) slotTab[m_dec->MPEGVersion][m_dec->FrameHeader->srIdx][m_dec->FrameHeader->brIdx]
+                - (int) sideBytesTab[m_dec->MPEGVersion][(m_dec->sMode == Mono ? 0 : 1)] - 4
+                - (m_dec->FrameHeader->crc ? 2 : 0) + (m_dec->FrameHeader->paddingBit ? 1 : 0);
     }
     /* load crc word, if enabled, and return length of frame header (in bytes) */
-    if (m_FrameHeader->crc) {
-        m_FrameHeader->CRCWord = ((int) buf[4] << 8 | (int) buf[5] << 0);
+    if (m_dec->FrameHeader->crc) {
+        m_dec->FrameHeader->CRCWord = ((int) buf[4] << 8 | (int) buf[5] << 0);
         return 6;
     } else {
-        m_FrameHeader->CRCWord = 0;
+        m_dec->FrameHeader->CRCWord = 0;
         return 4;
     }
 }
@@ -812,28 +807,28 @@ int UnpackSideInfo( unsigned char *buf) {
     SideInfoSub_t *sis;
     /* validate pointers and sync word */
     bsi = &bitStreamInfo;
-    if (m_MPEGVersion == MPEG1) {
+    if (m_dec->MPEGVersion == MPEG1) {
         /* MPEG 1 */
-        nBytes=(m_sMode == Mono ? m_SIBYTES_MPEG1_MONO : m_SIBYTES_MPEG1_STEREO);
+        nBytes=(m_dec->sMode == Mono ? m_SIBYTES_MPEG1_MONO : m_SIBYTES_MPEG1_STEREO);
         SetBitstreamPointer(bsi, nBytes, buf);
-        m_SideInfo->mainDataBegin = GetBits(bsi, 9);
-        m_SideInfo->privateBits= GetBits(bsi, (m_sMode == Mono ? 5 : 3));
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++)
-            for (bd = 0; bd < m_MAX_SCFBD; bd++) m_SideInfo->scfsi[ch][bd] = GetBits(bsi, 1);
+        m_dec->SideInfo->mainDataBegin = GetBits(bsi, 9);
+        m_dec->SideInfo->privateBits= GetBits(bsi, (m_dec->sMode == Mono ? 5 : 3));
+        for (ch = 0; ch < m_dec->MP3DecInfo->nChans; ch++)
+            for (bd = 0; bd < m_MAX_SCFBD; bd++) m_dec->SideInfo->scfsi[ch][bd] = GetBits(bsi, 1);
     } else {
         /* MPEG 2, MPEG 2.5 */
-        nBytes=(m_sMode == Mono ? m_SIBYTES_MPEG2_MONO : m_SIBYTES_MPEG2_STEREO);
+        nBytes=(m_dec->sMode == Mono ? m_SIBYTES_MPEG2_MONO : m_SIBYTES_MPEG2_STEREO);
         SetBitstreamPointer(bsi, nBytes, buf);
-        m_SideInfo->mainDataBegin = GetBits(bsi, 8);
-        m_SideInfo->privateBits = GetBits(bsi, (m_sMode == Mono ? 1 : 2));
+        m_dec->SideInfo->mainDataBegin = GetBits(bsi, 8);
+        m_dec->SideInfo->privateBits = GetBits(bsi, (m_dec->sMode == Mono ? 1 : 2));
     }
-    for (gr = 0; gr < m_MP3DecInfo->nGrans; gr++) {
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
-            sis = &m_SideInfoSub[gr][ch]; /* side info subblock for this granule, channel */
+    for (gr = 0; gr < m_dec->MP3DecInfo->nGrans; gr++) {
+        for (ch = 0; ch < m_dec->MP3DecInfo->nChans; ch++) {
+            sis = &m_dec->SideInfoSub[gr][ch]; /* side info subblock for this granule, channel */
             sis->part23Length = GetBits(bsi, 12);
             sis->nBigvals = GetBits(bsi, 9);
             sis->globalGain = GetBits(bsi, 8);
-            sis->sfCompress = GetBits(bsi, (m_MPEGVersion == MPEG1 ? 4 : 9));
+            sis->sfCompress = GetBits(bsi, (m_dec->MPEGVersion == MPEG1 ? 4 : 9));
             sis->winSwitchFlag = GetBits(bsi, 1);
             if (sis->winSwitchFlag) {
                 /* this is a start, stop, short, or mixed block */
@@ -868,12 +863,12 @@ int UnpackSideInfo( unsigned char *buf) {
                 sis->region0Count = GetBits(bsi, 4);
                 sis->region1Count = GetBits(bsi, 3);
             }
-            sis->preFlag = (m_MPEGVersion == MPEG1 ? GetBits(bsi, 1) : 0);
+            sis->preFlag = (m_dec->MPEGVersion == MPEG1 ? GetBits(bsi, 1) : 0);
             sis->sfactScale = GetBits(bsi, 1);
             sis->count1TableSelect = GetBits(bsi, 1);
         }
     }
-    m_MP3DecInfo->mainDataBegin = m_SideInfo->mainDataBegin; /* needed by main decode loop */
+    m_dec->MP3DecInfo->mainDataBegin = m_dec->SideInfo->mainDataBegin; /* needed by main decode loop */
     assert(nBytes == CalcBitsUsed(bsi, buf, 0) >> 3);
     return nBytes;
 }
@@ -1147,14 +1142,14 @@ int UnpackScaleFactors( unsigned char *buf, int *bitOffset, int bitsAvail, int g
     if (*bitOffset)
         GetBits(bsi, *bitOffset);
 
-    if (m_MPEGVersion == MPEG1)
-        UnpackSFMPEG1(bsi, &m_SideInfoSub[gr][ch], &m_ScaleFactorInfoSub[gr][ch],
-                      m_SideInfo->scfsi[ch], gr, &m_ScaleFactorInfoSub[0][ch]);
+    if (m_dec->MPEGVersion == MPEG1)
+        UnpackSFMPEG1(bsi, &m_dec->SideInfoSub[gr][ch], &m_dec->ScaleFactorInfoSub[gr][ch],
+                      m_dec->SideInfo->scfsi[ch], gr, &m_dec->ScaleFactorInfoSub[0][ch]);
     else
-        UnpackSFMPEG2(bsi, &m_SideInfoSub[gr][ch], &m_ScaleFactorInfoSub[gr][ch],
-                      gr, ch, m_FrameHeader->modeExt, m_ScaleFactorJS);
+        UnpackSFMPEG2(bsi, &m_dec->SideInfoSub[gr][ch], &m_dec->ScaleFactorInfoSub[gr][ch],
+                      gr, ch, m_dec->FrameHeader->modeExt, m_dec->ScaleFactorJS);
 
-    m_MP3DecInfo->part23Length[gr][ch] = m_SideInfoSub[gr][ch].part23Length;
+    m_dec->MP3DecInfo->part23Length[gr][ch] = m_dec->SideInfoSub[gr][ch].part23Length;
 
     bitsUsed = CalcBitsUsed(bsi, buf, *bitOffset);
     buf += (bitsUsed + *bitOffset) >> 3;
@@ -1166,6 +1161,27 @@ int UnpackScaleFactors( unsigned char *buf, int *bitOffset, int bitsAvail, int g
  * M P 3 D E C
  **********************************************************************************************************************/
 
+/***********************************************************************************************************************
+ * Function:    CheckFrameHeader
+ *
+ * Description: plausibility check of a 4 byte layer 3 frame header
+ *
+ * Inputs:      pointer to the frame header
+ *
+ * Return:      length of the frame in bytes, 0 in free format (unknown length)
+ *              -1 if the header is invalid
+ **********************************************************************************************************************/
+static int CheckFrameHeader(const unsigned char *buf) {
+    if ((buf[0] & m_SYNCWORDH) != m_SYNCWORDH || (buf[1] & m_SYNCWORDL) != m_SYNCWORDL) return -1;
+    if (((buf[1] >> 1) & 0x03) != 1) return -1;             /* layer 3 only */
+    int brIdx = (buf[2] >> 4) & 0x0f;
+    int srIdx = (buf[2] >> 2) & 0x03;
+    if (brIdx == 15 || srIdx == 3) return -1;
+    if ((buf[3] & 0x03) == 2) return -1;                    /* reserved emphasis */
+    if (brIdx == 0) return 0;
+    int ver = ((buf[1] >> 3) & 0x01) ? MPEG1 : MPEG2;
+    return slotTab[ver][srIdx][brIdx] + ((buf[2] >> 1) & 0x01);
+}
 /***********************************************************************************************************************
  * Function:    MP3FindSyncWord
  *
@@ -1178,17 +1194,45 @@ int UnpackScaleFactors( unsigned char *buf, int *bitOffset, int bitsAvail, int g
  *
  * Return:      offset to first sync word (bytes from start of buf)
  *              -1 if sync not found after searching nBytes
+ *
+ * Notes:       a candidate is only taken if the next two frame headers are consistent with it
+ *              (same version, layer, crc flag and samplerate). If buf ends before that can be
+ *              checked, the candidate is returned, the caller skips up to it and looks again
+ *              with more data. At offset 0 at least one following header must be confirmed, buf has
+ *              to hold more than one maximal frame (1441 bytes). So -1 means that buf contains no frame
+ *              start except maybe the last byte.
  **********************************************************************************************************************/
 int MP3FindSyncWord(unsigned char *buf, int nBytes) {
-    int i;
+    int i = 0;
+
+    /* find byte-aligned syncword - need 12 (MPEG 1,2) matching bits */
+    while ((i = FindFFByte(buf, i, nBytes - 1)) >= 0) {
+        if ((buf[i + 1] & m_SYNCWORDL) != m_SYNCWORDL) {i++; continue;}
+        if (i + 4 > nBytes) return i;                       /* header incomplete */
+        int len = CheckFrameHeader(buf + i);
+        if (len < 0) {i++; continue;}
+        if (len == 0) {                                     /* free format, look for the next identical header */
+            int j = i + 4;
+            while ((j = FindFFByte(buf, j, nBytes - 3)) >= 0) {
+                if (buf[j + 1] == buf[i + 1] && (buf[j + 2] & 0xfc) == (buf[i + 2] & 0xfc)) return i;
+                j++;
+            }
+            if (i > 0) return i;                            /* at offset 0 buf holds a whole frame */
+            i++; continue;
+        }
 
-    /* find byte-aligned syncword - need 12 (MPEG 1,2) or 11 (MPEG 2.5) matching bits */
-    for (i = 0; i < nBytes - 1; i++) {
-        if ((buf[i + 0] & m_SYNCWORDH) == m_SYNCWORDH
-                && (buf[i + 1] & m_SYNCWORDL) == m_SYNCWORDL)
-            return i;
+        int next = i, confirmed = 0;
+        while (confirmed < 2) {
+            next += len;
+            if (next + 4 > nBytes) break;                   /* not enough data to confirm */
+            if (buf[next + 1] != buf[i + 1] || (buf[next + 2] & 0x0c) != (buf[i + 2] & 0x0c)) break;
+            len = CheckFrameHeader(buf + next);
+            if (len <= 0) break;
+            confirmed++;
+        }
+        if (confirmed == 2 || (next + 4 > nBytes && (confirmed || i > 0))) return i;
+        i++;
     }
-
     return -1;
 }
 /***********************************************************************************************************************
@@ -1258,31 +1302,132 @@ int MP3FindFreeSync(unsigned char *buf, unsigned char firstFH[4], int nBytes){
  * Notes:       call this right after calling MP3Decode
  **********************************************************************************************************************/
 void MP3GetLastFrameInfo() {
-    if (m_MP3DecInfo->layer != 3){
-        m_MP3FrameInfo->bitrate=0;
-        m_MP3FrameInfo->nChans=0;
-        m_MP3FrameInfo->samprate=0;
-        m_MP3FrameInfo->bitsPerSample=0;
-        m_MP3FrameInfo->outputSamps=0;
-        m_MP3FrameInfo->layer=0;
-        m_MP3FrameInfo->version=0;
+    if (m_dec->MP3DecInfo->layer != 3){
+        m_dec->MP3FrameInfo->bitrate=0;
+        m_dec->MP3FrameInfo->nChans=0;
+        m_dec->MP3FrameInfo->samprate=0;
+        m_dec->MP3FrameInfo->bitsPerSample=0;
+        m_dec->MP3FrameInfo->outputSamps=0;
+        m_dec->MP3FrameInfo->layer=0;
+        m_dec->MP3FrameInfo->version=0;
     }
     else{
-        m_MP3FrameInfo->bitrate=m_MP3DecInfo->bitrate;
-        m_MP3FrameInfo->nChans=m_MP3DecInfo->nChans;
-        m_MP3FrameInfo->samprate=m_MP3DecInfo->samprate;
-        m_MP3FrameInfo->bitsPerSample=16;
-        m_MP3FrameInfo->outputSamps=m_MP3DecInfo->nChans
-                * (int) samplesPerFrameTab[m_MPEGVersion][m_MP3DecInfo->layer-1];
-        m_MP3FrameInfo->layer=m_MP3DecInfo->layer;
-        m_MP3FrameInfo->version=m_MPEGVersion;
-    }
-}
-int MP3GetSampRate(){return m_MP3FrameInfo->samprate;}
-int MP3GetChannels(){return m_MP3FrameInfo->nChans;}
-int MP3GetBitsPerSample(){return m_MP3FrameInfo->bitsPerSample;}
-int MP3GetBitrate(){return m_MP3FrameInfo->bitrate;}
-int MP3GetOutputSamps(){return m_MP3FrameInfo->outputSamps;}
+        m_dec->MP3FrameInfo->bitrate=m_dec->MP3DecInfo->bitrate;
+        m_dec->MP3FrameInfo->nChans=m_dec->MP3DecInfo->nChans;
+        m_dec->MP3FrameInfo->samprate=m_dec->MP3DecInfo->samprate;
+        m_dec->MP3FrameInfo->bitsPerSample=16;
+        m_dec->MP3FrameInfo->outputSamps=m_dec->MP3DecInfo->nChans
+                * (int) samplesPerFrameTab[m_dec->MPEGVersion][m_dec->MP3DecInfo->layer-1];
+        if (m_dec->quality >= MP3_QUALITY_HALFRATE) {
+            m_dec->MP3FrameInfo->samprate >>= 1;
+            m_dec->MP3FrameInfo->outputSamps >>= 1;
+        }
+        m_dec->MP3FrameInfo->layer=m_dec->MP3DecInfo->layer;
+        m_dec->MP3FrameInfo->version=m_dec->MPEGVersion;
+    }
+}
+int MP3GetSampRate(MP3Decoder_t *dec){return dec->MP3FrameInfo->samprate;}
+int MP3GetChannels(MP3Decoder_t *dec){return dec->MP3FrameInfo->nChans;}
+int MP3GetBitsPerSample(MP3Decoder_t *dec){return dec->MP3FrameInfo->bitsPerSample;}
+int MP3GetBitrate(MP3Decoder_t *dec){return dec->MP3FrameInfo->bitrate;}
+int MP3GetOutputSamps(MP3Decoder_t *dec){return dec->MP3FrameInfo->outputSamps;}
+int MP3GetSampRate(){return MP3GetSampRate(m_defaultDec);}
+int MP3GetChannels(){return MP3GetChannels(m_defaultDec);}
+int MP3GetBitsPerSample(){return MP3GetBitsPerSample(m_defaultDec);}
+int MP3GetBitrate(){return MP3GetBitrate(m_defaultDec);}
+int MP3GetOutputSamps(){return MP3GetOutputSamps(m_defaultDec);}
+/***********************************************************************************************************************
+ * Function:    MP3SetDownmix
+ *
+ * Description: request mono output, the channels of a stereo stream are mixed after the stereo processing and only
+ *                one hybrid transform and one synthesis filterbank run per granule
+ *
+ * Inputs:      decoder context (default instance if omitted), true for mono
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       the output format does not change, a stereo stream still delivers LRLR... with L == R
+ *              can be switched at any frame, the state of the filterbanks is carried over
+ **********************************************************************************************************************/
+void MP3SetDownmix(MP3Decoder_t *dec, bool mono){
+    if(dec) dec->downmix = mono;
+}
+void MP3SetDownmix(bool mono){
+    MP3SetDownmix(m_defaultDec, mono);
+}
+/***********************************************************************************************************************
+ * Function:    MP3SetQuality
+ *
+ * Description: trade audio bandwidth for CPU time
+ *
+ * Inputs:      decoder context (default instance if omitted), MP3_QUALITY_FULL, MP3_QUALITY_LOWPASS or
+ *                MP3_QUALITY_HALFRATE
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       LOWPASS zeroes the spectrum above m_LOWPASS_BANDS subbands, the hybrid transform of those
+ *                subbands is skipped
+ *              HALFRATE keeps 16 subbands and computes only every second output sample of the polyphase filter,
+ *                MP3GetSampRate() and MP3GetOutputSamps() report half the stream values
+ *              takes effect with the next frame, the filterbank state is the same for all levels
+ **********************************************************************************************************************/
+void MP3SetQuality(MP3Decoder_t *dec, uint8_t level){
+    if(dec) dec->quality = (level > MP3_QUALITY_HALFRATE ? (uint8_t)MP3_QUALITY_HALFRATE : level);
+}
+void MP3SetQuality(uint8_t level){
+    MP3SetQuality(m_defaultDec, level);
+}
+/***********************************************************************************************************************
+ * Function:    MP3SetDualCore
+ *
+ * Description: split the IMDCT and the synthesis of stereo granules between both cores
+ *
+ * Inputs:      decoder context (default instance if omitted), true to start the worker task
+ *
+ * Outputs:     none
+ *
+ * Return:      true if the worker is running
+ *
+ * Notes:       the worker is pinned to the core the caller is not running on (core 0 if Audio::loop() runs on
+ *                core 1) with a priority one above the caller, it sleeps on a task notification between granules
+ *              per stereo granule one fork/join: the worker does IMDCT and synthesis of channel 1 while the caller
+ *                does channel 0. Huffman decoding and dequantization stay serial, they share the spectrum buffers
+ *                with the IMDCT. Mono streams and downmixed stereo (MP3SetDownmix()) have no second channel and
+ *                are decoded on the calling core alone
+ *              a stereo granule is only split while that was measured to be faster than one core, low bitrates
+ *                and MP3_QUALITY_HALFRATE may not pay the fork and join, see MP3DualCoreWorth()
+ *              not available on single core chips
+ **********************************************************************************************************************/
+bool MP3SetDualCore(MP3Decoder_t *dec, bool on){
+#ifdef CONFIG_FREERTOS_UNICORE
+    return false;
+#else
+    if(!dec) return false;
+    if(on && !dec->worker) {
+        dec->dualCycles = 0; dec->serialCycles = 0; dec->dualProbe = 0;
+        if(xTaskCreatePinnedToCore(MP3WorkerTask, "mp3worker", 4096, dec, uxTaskPriorityGet(NULL) + 1,
+                                   &dec->worker, xPortGetCoreID() ^ 1) != pdPASS) {
+            dec->worker = NULL;
+            log_e("no worker task for dual core decoding");
+        }
+    }
+    if(!on && dec->worker) {
+        dec->workerPcm = NULL;                      /* quit request */
+        dec->workerCaller = xTaskGetCurrentTaskHandle();
+        xTaskNotifyGive(dec->worker);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        dec->worker = NULL;
+    }
+    return dec->worker != NULL;
+#endif
+}
+bool MP3SetDualCore(bool on){
+    return MP3SetDualCore(m_defaultDec, on);
+}
 /***********************************************************************************************************************
  * Function:    MP3GetNextFrameInfo
  *
@@ -1295,15 +1440,19 @@ int MP3GetOutputSamps(){return m_MP3FrameInfo->outputSamps;}
  *
  * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
  **********************************************************************************************************************/
-int MP3GetNextFrameInfo(unsigned char *buf) {
+int MP3GetNextFrameInfo(MP3Decoder_t *dec, unsigned char *buf) {
 
-    if (UnpackFrameHeader( buf) == -1 || m_MP3DecInfo->layer != 3)
+    m_dec = dec;
+    if (UnpackFrameHeader( buf) == -1 || m_dec->MP3DecInfo->layer != 3)
         return ERR_MP3_INVALID_FRAMEHEADER;
 
     MP3GetLastFrameInfo();
 
     return ERR_MP3_NONE;
 }
+int MP3GetNextFrameInfo(unsigned char *buf) {
+    return MP3GetNextFrameInfo(m_defaultDec, buf);
+}
 /***********************************************************************************************************************
  * Function:    MP3ClearBadFrame
  *
@@ -1318,7 +1467,7 @@ int MP3GetNextFrameInfo(unsigned char *buf) {
  **********************************************************************************************************************/
 void MP3ClearBadFrame( short *outbuf) {
     int i;
-    for (i = 0; i < m_MP3DecInfo->nGrans * m_MP3DecInfo->nGranSamps * m_MP3DecInfo->nChans; i++)
+    for (i = 0; i < m_dec->MP3DecInfo->nGrans * m_dec->MP3DecInfo->nGranSamps * m_dec->MP3DecInfo->nChans; i++)
         outbuf[i] = 0;
 }
 /***********************************************************************************************************************
@@ -1326,7 +1475,9 @@ void MP3ClearBadFrame( short *outbuf) {
  *
  * Description: decode one frame of MP3 data
  *
- * Inputs:      number of valid bytes remaining in inbuf
+ * Inputs:      decoder context (default instance if omitted)
+ *              pointer to the frame
+ *              number of valid bytes remaining in inbuf
  *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
  *              flag indicating whether MP3 data is normal MPEG format (useSize = 0)
  *              or reformatted as "self-contained" frames (useSize = 1)
@@ -1341,10 +1492,20 @@ void MP3ClearBadFrame( short *outbuf) {
  *                is not supported (bit reservoir is not maintained if useSize on)
  **********************************************************************************************************************/
 int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize){
+    return MP3Decode(m_defaultDec, inbuf, bytesLeft, outbuf, useSize);
+}
+int MP3Decode(MP3Decoder_t *dec, unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize){
     int offset, bitOffset, mainBits, gr, ch, fhBytes, siBytes, freeFrameBytes;
     int prevBitOffset, sfBlockBits, huffBlockBits;
     unsigned char *mainPtr;
 
+    if (!dec)
+        return ERR_MP3_NULL_POINTER;
+    m_dec = dec;
+#ifdef MP3_PROFILE
+    uint32_t t0 = ESP.getCycleCount(), t1;
+#endif
+
     /* unpack frame header */
     fhBytes = UnpackFrameHeader(inbuf);
     if (fhBytes < 0)
@@ -1360,21 +1521,21 @@ int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize)
     *bytesLeft -= (fhBytes + siBytes);
 
     /* if free mode, need to calculate bitrate and nSlots manually, based on frame size */
-    if (m_MP3DecInfo->bitrate == 0 || m_MP3DecInfo->freeBitrateFlag) {
-        if(!m_MP3DecInfo->freeBitrateFlag){
+    if (m_dec->MP3DecInfo->bitrate == 0 || m_dec->MP3DecInfo->freeBitrateFlag) {
+        if(!m_dec->MP3DecInfo->freeBitrateFlag){
             /* first time through, need to scan for next sync word and figure out frame size */
-            m_MP3DecInfo->freeBitrateFlag=1;
-            m_MP3DecInfo->freeBitrateSlots=MP3FindFreeSync(inbuf, inbuf - fhBytes - siBytes, *bytesLeft);
-            if(m_MP3DecInfo->freeBitrateSlots < 0){
+            m_dec->MP3DecInfo->freeBitrateFlag=1;
+            m_dec->MP3DecInfo->freeBitrateSlots=MP3FindFreeSync(inbuf, inbuf - fhBytes - siBytes, *bytesLeft);
+            if(m_dec->MP3DecInfo->freeBitrateSlots < 0){
                 MP3ClearBadFrame(outbuf);
-                m_MP3DecInfo->freeBitrateFlag = 0;
+                m_dec->MP3DecInfo->freeBitrateFlag = 0;
                 return ERR_MP3_FREE_BITRATE_SYNC;
             }
-            freeFrameBytes=m_MP3DecInfo->freeBitrateSlots + fhBytes + siBytes;
-            m_MP3DecInfo->bitrate=(freeFrameBytes * m_MP3DecInfo->samprate * 8)
-                    / (m_MP3DecInfo->nGrans * m_MP3DecInfo->nGranSamps);
+            freeFrameBytes=m_dec->MP3DecInfo->freeBitrateSlots + fhBytes + siBytes;
+            m_dec->MP3DecInfo->bitrate=(freeFrameBytes * m_dec->MP3DecInfo->samprate * 8)
+                    / (m_dec->MP3DecInfo->nGrans * m_dec->MP3DecInfo->nGranSamps);
         }
-        m_MP3DecInfo->nSlots = m_MP3DecInfo->freeBitrateSlots + CheckPadBit(); /* add pad byte, if required */
+        m_dec->MP3DecInfo->nSlots = m_dec->MP3DecInfo->freeBitrateSlots + CheckPadBit(); /* add pad byte, if required */
     }
 
     /* useSize != 0 means we're getting reformatted (RTP) packets (see RFC 3119)
@@ -1384,59 +1545,59 @@ int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize)
      *      frame is (in bytesLeft)
      */
     if (useSize) {
-        m_MP3DecInfo->nSlots = *bytesLeft;
-        if (m_MP3DecInfo->mainDataBegin != 0 || m_MP3DecInfo->nSlots <= 0) {
+        m_dec->MP3DecInfo->nSlots = *bytesLeft;
+        if (m_dec->MP3DecInfo->mainDataBegin != 0 || m_dec->MP3DecInfo->nSlots <= 0) {
             /* error - non self-contained frame, or missing frame (size <= 0), could do loss concealment here */
             MP3ClearBadFrame(outbuf);
             return ERR_MP3_INVALID_FRAMEHEADER;
         }
 
         /* can operate in-place on reformatted frames */
-        m_MP3DecInfo->mainDataBytes = m_MP3DecInfo->nSlots;
+        m_dec->MP3DecInfo->mainDataBytes = m_dec->MP3DecInfo->nSlots;
         mainPtr = inbuf;
-        inbuf += m_MP3DecInfo->nSlots;
-        *bytesLeft -= (m_MP3DecInfo->nSlots);
+        inbuf += m_dec->MP3DecInfo->nSlots;
+        *bytesLeft -= (m_dec->MP3DecInfo->nSlots);
     } else {
         /* out of data - assume last or truncated frame */
-        if (m_MP3DecInfo->nSlots > *bytesLeft) {
+        if (m_dec->MP3DecInfo->nSlots > *bytesLeft) {
             MP3ClearBadFrame(outbuf);
             return ERR_MP3_INDATA_UNDERFLOW;
         }
         /* fill main data buffer with enough new data for this frame */
-        if (m_MP3DecInfo->mainDataBytes >= m_MP3DecInfo->mainDataBegin) {
+        if (m_dec->MP3DecInfo->mainDataBytes >= m_dec->MP3DecInfo->mainDataBegin) {
             /* adequate "old" main data available (i.e. bit reservoir) */
-            memmove(m_MP3DecInfo->mainBuf,
-                    m_MP3DecInfo->mainBuf + m_MP3DecInfo->mainDataBytes - m_MP3DecInfo->mainDataBegin,
-                    m_MP3DecInfo->mainDataBegin);
-            memcpy (m_MP3DecInfo->mainBuf + m_MP3DecInfo->mainDataBegin, inbuf,
-                    m_MP3DecInfo->nSlots);
-
-            m_MP3DecInfo->mainDataBytes = m_MP3DecInfo->mainDataBegin + m_MP3DecInfo->nSlots;
-            inbuf += m_MP3DecInfo->nSlots;
-            *bytesLeft -= (m_MP3DecInfo->nSlots);
-            mainPtr = m_MP3DecInfo->mainBuf;
+            memmove(m_dec->MP3DecInfo->mainBuf,
+                    m_dec->MP3DecInfo->mainBuf + m_dec->MP3DecInfo->mainDataBytes - m_dec->MP3DecInfo->mainDataBegin,
+                    m_dec->MP3DecInfo->mainDataBegin);
+            memcpy (m_dec->MP3DecInfo->mainBuf + m_dec->MP3DecInfo->mainDataBegin, inbuf,
+                    m_dec->MP3DecInfo->nSlots);
+
+            m_dec->MP3DecInfo->mainDataBytes = m_dec->MP3DecInfo->mainDataBegin + m_dec->MP3DecInfo->nSlots;
+            inbuf += m_dec->MP3DecInfo->nSlots;
+            *bytesLeft -= (m_dec->MP3DecInfo->nSlots);
+            mainPtr = m_dec->MP3DecInfo->mainBuf;
         } else {
             /* not enough data in bit reservoir from previous frames (perhaps starting in middle of file) */
-            memcpy(m_MP3DecInfo->mainBuf + m_MP3DecInfo->mainDataBytes, inbuf, m_MP3DecInfo->nSlots);
-            m_MP3DecInfo->mainDataBytes += m_MP3DecInfo->nSlots;
-            inbuf += m_MP3DecInfo->nSlots;
-            *bytesLeft -= (m_MP3DecInfo->nSlots);
+            memcpy(m_dec->MP3DecInfo->mainBuf + m_dec->MP3DecInfo->mainDataBytes, inbuf, m_dec->MP3DecInfo->nSlots);
+            m_dec->MP3DecInfo->mainDataBytes += m_dec->MP3DecInfo->nSlots;
+            inbuf += m_dec->MP3DecInfo->nSlots;
+            *bytesLeft -= (m_dec->MP3DecInfo->nSlots);
             MP3ClearBadFrame( outbuf);
             return ERR_MP3_MAINDATA_UNDERFLOW;
         }
     }
     bitOffset = 0;
-    mainBits = m_MP3DecInfo->mainDataBytes * 8;
+    mainBits = m_dec->MP3DecInfo->mainDataBytes * 8;
 
     /* decode one complete frame */
-    for (gr = 0; gr < m_MP3DecInfo->nGrans; gr++) {
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
+    for (gr = 0; gr < m_dec->MP3DecInfo->nGrans; gr++) {
+        for (ch = 0; ch < m_dec->MP3DecInfo->nChans; ch++) {
             /* unpack scale factors and compute size of scale factor block */
             prevBitOffset = bitOffset;
             offset = UnpackScaleFactors( mainPtr, &bitOffset,
                     mainBits, gr, ch);
             sfBlockBits = 8 * offset - prevBitOffset + bitOffset;
-            huffBlockBits = m_MP3DecInfo->part23Length[gr][ch] - sfBlockBits;
+            huffBlockBits = m_dec->MP3DecInfo->part23Length[gr][ch] - sfBlockBits;
             mainPtr += offset;
             mainBits -= sfBlockBits;
 
@@ -1446,7 +1607,13 @@ int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize)
             }
             /* decode Huffman code words */
             prevBitOffset = bitOffset;
+#ifdef MP3_PROFILE
+            t1 = ESP.getCycleCount();
+#endif
             offset = DecodeHuffman( mainPtr, &bitOffset, huffBlockBits, gr, ch);
+#ifdef MP3_PROFILE
+            m_dec->profHuffman += ESP.getCycleCount() - t1;
+#endif
             if (offset < 0) {
                 MP3ClearBadFrame( outbuf);
                 return ERR_MP3_INVALID_HUFFCODES;
@@ -1455,26 +1622,90 @@ int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize)
             mainBits -= (8 * offset - prevBitOffset + bitOffset);
         }
         /* dequantize coefficients, decode stereo, reorder short blocks */
+#ifdef MP3_PROFILE
+        t1 = ESP.getCycleCount();
+#endif
         if (MP3Dequantize( gr) < 0) {
             MP3ClearBadFrame(outbuf);
             return ERR_MP3_INVALID_DEQUANTIZE;
         }
 
+        /* reduced quality, drop the upper subbands */
+        if (m_dec->quality == MP3_QUALITY_LOWPASS) MP3LimitBands(m_LOWPASS_BANDS);
+        if (m_dec->quality == MP3_QUALITY_HALFRATE) MP3LimitBands(m_NBANDS / 2);
+
         /* alias reduction, inverse MDCT, overlap-add, frequency inversion */
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
+#ifdef MP3_PROFILE
+        m_dec->profDequant += ESP.getCycleCount() - t1;
+        t1 = ESP.getCycleCount();
+#endif
+        /* a stereo granule can be split between the cores, it is if that was faster up to now */
+        bool timed = m_dec->worker && m_dec->MP3DecInfo->nChans == 2 && !MP3DownmixActive();
+        uint32_t t2 = timed ? ESP.getCycleCount() : 0;
+        if (MP3DownmixActive()) {
+            if (MP3DownmixIMDCT(gr) < 0) {
+                MP3ClearBadFrame(outbuf);
+                return ERR_MP3_INVALID_IMDCT;
+            }
+        }
+        else if (timed && MP3DualCoreWorth()) {
+            /* channel 1 is transformed and synthesized on the other core */
+            if (MP3DualCoreGranule(gr, outbuf + ((gr * m_dec->MP3DecInfo->nGranSamps * 2) >>
+                                                 (m_dec->quality >= MP3_QUALITY_HALFRATE))) < 0) {
+                MP3ClearBadFrame(outbuf);
+                return ERR_MP3_INVALID_IMDCT;
+            }
+            MP3DualCoreTimed(true, ESP.getCycleCount() - t2);
+#ifdef MP3_PROFILE
+            m_dec->profDual += ESP.getCycleCount() - t1;
+            m_dec->profSplit++;
+            m_dec->profGrans++;
+#endif
+            continue;
+        }
+        else for (ch = 0; ch < m_dec->MP3DecInfo->nChans; ch++) {
             if (IMDCT( gr, ch) < 0) {
                 MP3ClearBadFrame(outbuf);
                 return ERR_MP3_INVALID_IMDCT;
             }
         }
         /* subband transform - if stereo, interleaves pcm LRLRLR */
+#ifdef MP3_PROFILE
+        m_dec->profImdct += ESP.getCycleCount() - t1;
+        t1 = ESP.getCycleCount();
+#endif
         if (Subband(
-                outbuf + gr * m_MP3DecInfo->nGranSamps * m_MP3DecInfo->nChans)
+                outbuf + ((gr * m_dec->MP3DecInfo->nGranSamps * m_dec->MP3DecInfo->nChans) >>
+                          (m_dec->quality >= MP3_QUALITY_HALFRATE)))
                 < 0) {
             MP3ClearBadFrame(outbuf);
             return ERR_MP3_INVALID_SUBBAND;
         }
+        if (timed)
+            MP3DualCoreTimed(false, ESP.getCycleCount() - t2);
+#ifdef MP3_PROFILE
+        m_dec->profSubband += ESP.getCycleCount() - t1;
+        m_dec->profGrans++;
+#endif
+    }
+#ifdef MP3_PROFILE
+    m_dec->profCycles += ESP.getCycleCount() - t0;
+    if (++m_dec->profFrames == 256) {
+        uint32_t split = m_dec->profSplit ? m_dec->profSplit : 1, single = m_dec->profGrans - m_dec->profSplit;
+        if (!single) single = 1;
+        log_i("MP3 placement %d, %lu cycles/frame, per granule Huffman %lu, Dequant %lu, IMDCT %lu, Subband %lu, "
+              "dual core %lu of %lu granules, IMDCT+Subband %lu (join wait %lu), averages dual %lu single %lu",
+              MP3_PLACEMENT, (unsigned long)(m_dec->profCycles / 256),
+              (unsigned long)(m_dec->profHuffman / m_dec->profGrans), (unsigned long)(m_dec->profDequant / m_dec->profGrans),
+              (unsigned long)(m_dec->profImdct / single), (unsigned long)(m_dec->profSubband / single),
+              (unsigned long)m_dec->profSplit, (unsigned long)m_dec->profGrans,
+              (unsigned long)(m_dec->profDual / split), (unsigned long)(m_dec->profJoin / split),
+              (unsigned long)m_dec->dualCycles, (unsigned long)m_dec->serialCycles);
+        m_dec->profFrames = 0; m_dec->profGrans = 0; m_dec->profCycles = 0;
+        m_dec->profHuffman = 0; m_dec->profDequant = 0; m_dec->profImdct = 0; m_dec->profSubband = 0;
+        m_dec->profSplit = 0; m_dec->profDual = 0; m_dec->profJoin = 0;
     }
+#endif
     MP3GetLastFrameInfo();
     return ERR_MP3_NONE;
 }
@@ -1484,35 +1715,42 @@ int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize)
  *
  * Description: clear all the memory needed for the MP3 decoder
  *
- * Inputs:      none
+ * Inputs:      decoder context (default instance if omitted)
  *
  * Outputs:     none
  *
  * Return:      none
  *
  **********************************************************************************************************************/
-void MP3Decoder_ClearBuffer(void) {
+void MP3Decoder_ClearBuffer(MP3Decoder_t *dec) {
 
     /* important to do this - DSP primitives assume a bunch of state variables are 0 on first use */
-    memset( m_MP3DecInfo,         0, sizeof(MP3DecInfo_t));                                    //Clear MP3DecInfo
-    memset(&m_ScaleFactorInfoSub, 0, sizeof(ScaleFactorInfoSub_t)*(m_MAX_NGRAN *m_MAX_NCHAN)); //Clear ScaleFactorInfo
-    memset( m_SideInfo,           0, sizeof(SideInfo_t));                                      //Clear SideInfo
-    memset( m_FrameHeader,        0, sizeof(FrameHeader_t));                                   //Clear FrameHeader
-    memset( m_HuffmanInfo,        0, sizeof(HuffmanInfo_t));                                   //Clear HuffmanInfo
-    memset( m_DequantInfo,        0, sizeof(DequantInfo_t));                                   //Clear DequantInfo
-    memset( m_IMDCTInfo,          0, sizeof(IMDCTInfo_t));                                     //Clear IMDCTInfo
-    memset( m_SubbandInfo,        0, sizeof(SubbandInfo_t));                                   //Clear SubbandInfo
-    memset(&m_CriticalBandInfo,   0, sizeof(CriticalBandInfo_t)*m_MAX_NCHAN);                  //Clear CriticalBandInfo
-    memset( m_ScaleFactorJS,      0, sizeof(ScaleFactorJS_t));                                 //Clear ScaleFactorJS
-    memset(&m_SideInfoSub,        0, sizeof(SideInfoSub_t)*(m_MAX_NGRAN *m_MAX_NCHAN));        //Clear SideInfoSub
-    memset(&m_SFBandTable,        0, sizeof(SFBandTable_t));                                   //Clear SFBandTable
-    memset( m_MP3FrameInfo,       0, sizeof(MP3FrameInfo_t));                                  //Clear MP3FrameInfo
+    memset( dec->MP3DecInfo,         0, sizeof(MP3DecInfo_t));                                    //Clear MP3DecInfo
+    memset(&dec->ScaleFactorInfoSub, 0, sizeof(ScaleFactorInfoSub_t)*(m_MAX_NGRAN *m_MAX_NCHAN)); //Clear ScaleFactorInfo
+    memset( dec->SideInfo,           0, sizeof(SideInfo_t));                                      //Clear SideInfo
+    memset( dec->FrameHeader,        0, sizeof(FrameHeader_t));                                   //Clear FrameHeader
+    memset( dec->HuffmanInfo,        0, sizeof(HuffmanInfo_t));                                   //Clear HuffmanInfo
+    memset( dec->DequantInfo,        0, sizeof(DequantInfo_t));                                   //Clear DequantInfo
+    memset( dec->IMDCTInfo,          0, sizeof(IMDCTInfo_t));                                     //Clear IMDCTInfo
+    memset( dec->SubbandInfo,        0, sizeof(SubbandInfo_t));                                   //Clear SubbandInfo
+    memset(&dec->CriticalBandInfo,   0, sizeof(CriticalBandInfo_t)*m_MAX_NCHAN);                  //Clear CriticalBandInfo
+    memset( dec->ScaleFactorJS,      0, sizeof(ScaleFactorJS_t));                                 //Clear ScaleFactorJS
+    memset(&dec->SideInfoSub,        0, sizeof(SideInfoSub_t)*(m_MAX_NGRAN *m_MAX_NCHAN));        //Clear SideInfoSub
+    memset(&dec->SFBandTable,        0, sizeof(SFBandTable_t));                                   //Clear SFBandTable
+    memset( dec->MP3FrameInfo,       0, sizeof(MP3FrameInfo_t));                                  //Clear MP3FrameInfo
+    dec->sMode = (StereoMode_t)0;
+    dec->MPEGVersion = (MPEGVersion_t)0;
+    dec->monoActive = false;
+    dec->monoSplit = false;
 
     return;
 
 }
+void MP3Decoder_ClearBuffer(void) {
+    if(m_defaultDec) MP3Decoder_ClearBuffer(m_defaultDec);
+}
 /***********************************************************************************************************************
- * Function:    MP3Decoder_AllocateBuffers
+ * Function:    MP3Decoder_Create, MP3Decoder_AllocateBuffers
  *
  * Description: allocate all the memory needed for the MP3 decoder
  *
@@ -1520,50 +1758,80 @@ void MP3Decoder_ClearBuffer(void) {
  *
  * Outputs:     none
  *
- * Return:      pointer to MP3DecInfo structure (initialized with pointers to all
- *                the internal buffers needed for decoding)
+ * Return:      new decoder context or NULL (Create)
+ *              true if the default instance is ready (AllocateBuffers)
  *
  * Notes:       if one or more mallocs fail, function frees any buffers already
  *                allocated before returning
  *
  **********************************************************************************************************************/
 
+// the internal RAM buffers are carved from the arena, the heap is only asked if it is full
 #ifdef CONFIG_IDF_TARGET_ESP32S3
-    // ESP32-S3: If there is PSRAM, prefer it
-    #define __malloc_heap_psram(size) \
-        heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL)
+    #define MP3_RAM_PSRAM   ARENA_PREFER_PSRAM      // ESP32-S3: If there is PSRAM, prefer it
 #else
-    // ESP32, PSRAM is too slow, prefer SRAM
-    #define __malloc_heap_psram(size) \
-        heap_caps_malloc_prefer(size, 2, MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM)
+    #define MP3_RAM_PSRAM   ARENA_PREFER_INTERNAL   // ESP32, PSRAM is too slow, prefer SRAM
 #endif
-
-bool MP3Decoder_AllocateBuffers(void) {
-    if(!m_MP3DecInfo)       {m_MP3DecInfo    = (MP3DecInfo_t*)    __malloc_heap_psram(sizeof(MP3DecInfo_t)   );}
-    if(!m_FrameHeader)      {m_FrameHeader   = (FrameHeader_t*)   __malloc_heap_psram(sizeof(FrameHeader_t)  );}
-    if(!m_SideInfo)         {m_SideInfo      = (SideInfo_t*)      __malloc_heap_psram(sizeof(SideInfo_t)     );}
-    if(!m_ScaleFactorJS)    {m_ScaleFactorJS = (ScaleFactorJS_t*) __malloc_heap_psram(sizeof(ScaleFactorJS_t));}
-    if(!m_HuffmanInfo)      {m_HuffmanInfo   = (HuffmanInfo_t*)   __malloc_heap_psram(sizeof(HuffmanInfo_t)  );}
-    if(!m_DequantInfo)      {m_DequantInfo   = (DequantInfo_t*)   __malloc_heap_psram(sizeof(DequantInfo_t)  );}
-    if(!m_IMDCTInfo)        {m_IMDCTInfo     = (IMDCTInfo_t*)     __malloc_heap_psram(sizeof(IMDCTInfo_t)    );}
-    if(!m_SubbandInfo)      {m_SubbandInfo   = (SubbandInfo_t*)   __malloc_heap_psram(sizeof(SubbandInfo_t)  );}
-    if(!m_MP3FrameInfo)     {m_MP3FrameInfo  = (MP3FrameInfo_t*)  __malloc_heap_psram(sizeof(MP3FrameInfo_t) );}
-
-    if(!m_MP3DecInfo || !m_FrameHeader || !m_SideInfo || !m_ScaleFactorJS || !m_HuffmanInfo ||
-       !m_DequantInfo || !m_IMDCTInfo || !m_SubbandInfo || !m_MP3FrameInfo) {
-        MP3Decoder_FreeBuffers();
+#if MP3_PLACEMENT >= 1
+    #define MP3_RAM_FAST    ARENA_PREFER_INTERNAL   // buffers touched every granule, internal RAM first on all chips
+#else
+    #define MP3_RAM_FAST    MP3_RAM_PSRAM
+#endif
+#define __malloc_heap_psram(size)   ArenaMalloc(size, MP3_RAM_PSRAM)
+#define __malloc_heap_fast(size)    ArenaMalloc(size, MP3_RAM_FAST)
+
+MP3Decoder_t* MP3Decoder_Create(void) {
+    MP3Decoder_t *dec = (MP3Decoder_t*)__malloc_heap_psram(sizeof(MP3Decoder_t));
+    if(!dec) {
+        log_e("not enough memory to allocate mp3decoder context");
+        return NULL;
+    }
+    memset(dec, 0, sizeof(MP3Decoder_t));
+    dec->huffFastRef   = MP3InitHuffFastTables();
+    dec->MP3DecInfo    = (MP3DecInfo_t*)    __malloc_heap_psram(sizeof(MP3DecInfo_t)   );
+    dec->FrameHeader   = (FrameHeader_t*)   __malloc_heap_psram(sizeof(FrameHeader_t)  );
+    dec->SideInfo      = (SideInfo_t*)      __malloc_heap_psram(sizeof(SideInfo_t)     );
+    dec->ScaleFactorJS = (ScaleFactorJS_t*) __malloc_heap_psram(sizeof(ScaleFactorJS_t));
+    dec->HuffmanInfo   = (HuffmanInfo_t*)   __malloc_heap_fast(sizeof(HuffmanInfo_t)   );
+    dec->DequantInfo   = (DequantInfo_t*)   __malloc_heap_fast(sizeof(DequantInfo_t)   );
+    dec->IMDCTInfo     = (IMDCTInfo_t*)     __malloc_heap_fast(sizeof(IMDCTInfo_t)     );
+    dec->SubbandInfo   = (SubbandInfo_t*)   __malloc_heap_fast(sizeof(SubbandInfo_t)   );
+    dec->MP3FrameInfo  = (MP3FrameInfo_t*)  __malloc_heap_psram(sizeof(MP3FrameInfo_t) );
+
+    if(!dec->MP3DecInfo || !dec->FrameHeader || !dec->SideInfo || !dec->ScaleFactorJS || !dec->HuffmanInfo ||
+       !dec->DequantInfo || !dec->IMDCTInfo || !dec->SubbandInfo || !dec->MP3FrameInfo || !dec->huffFastRef) {
+        MP3Decoder_Destroy(dec);
         log_e("not enough memory to allocate mp3decoder buffers");
-        return false;
+        return NULL;
     }
-    MP3Decoder_ClearBuffer();
-    return true;
+    MP3Decoder_ClearBuffer(dec);
+    return dec;
+}
+bool MP3Decoder_AllocateBuffers(void) {
+    if(!m_defaultDec) m_defaultDec = MP3Decoder_Create();
+    else MP3Decoder_ClearBuffer(m_defaultDec);
+    return m_defaultDec != NULL;
+}
+size_t MP3Decoder_BufferSize(void) {
+    // arena bytes of one context, the huffman tables included, the buffers that go to PSRAM count 0
+    return ArenaBlockSize(sizeof(MP3Decoder_t),    MP3_RAM_PSRAM) +
+           ArenaBlockSize(sizeof(MP3DecInfo_t),    MP3_RAM_PSRAM) +
+           ArenaBlockSize(sizeof(FrameHeader_t),   MP3_RAM_PSRAM) +
+           ArenaBlockSize(sizeof(SideInfo_t),      MP3_RAM_PSRAM) +
+           ArenaBlockSize(sizeof(ScaleFactorJS_t), MP3_RAM_PSRAM) +
+           ArenaBlockSize(sizeof(MP3FrameInfo_t),  MP3_RAM_PSRAM) +
+           ArenaBlockSize(sizeof(HuffmanInfo_t),   MP3_RAM_FAST)  +
+           ArenaBlockSize(sizeof(DequantInfo_t),   MP3_RAM_FAST)  +
+           ArenaBlockSize(sizeof(IMDCTInfo_t),     MP3_RAM_FAST)  +
+           ArenaBlockSize(sizeof(SubbandInfo_t),   MP3_RAM_FAST)  +
+           ArenaBlockSize(((m_HUFF_FAST_PAIRTABS + 2) << m_HUFF_FAST_BITS) * sizeof(uint16_t), ARENA_PREFER_INTERNAL);
 }
 /***********************************************************************************************************************
- * Function:    MP3Decoder_FreeBuffers
+ * Function:    MP3Decoder_Destroy, MP3Decoder_FreeBuffers
  *
  * Description: frees all the memory used by the MP3 decoder
  *
- * Inputs:      pointer to initialized MP3DecInfo structure
+ * Inputs:      decoder context (default instance if omitted)
  *
  * Outputs:     none
  *
@@ -1571,19 +1839,29 @@ bool MP3Decoder_AllocateBuffers(void) {
  *
  * Notes:       safe to call even if some buffers were not allocated
  **********************************************************************************************************************/
+void MP3Decoder_Destroy(MP3Decoder_t *dec)
+{
+    if(!dec) return;
+    if(m_dec == dec) m_dec = NULL;
+    MP3SetDualCore(dec, false);
+    if(dec->MP3DecInfo)        {ArenaFree(dec->MP3DecInfo);      dec->MP3DecInfo=NULL;}
+    if(dec->FrameHeader)       {ArenaFree(dec->FrameHeader);     dec->FrameHeader=NULL;}
+    if(dec->SideInfo)          {ArenaFree(dec->SideInfo);        dec->SideInfo=NULL;}
+    if(dec->ScaleFactorJS )    {ArenaFree(dec->ScaleFactorJS);   dec->ScaleFactorJS=NULL;}
+    if(dec->HuffmanInfo)       {ArenaFree(dec->HuffmanInfo);     dec->HuffmanInfo=NULL;}
+    if(dec->DequantInfo)       {ArenaFree(dec->DequantInfo);     dec->DequantInfo=0;}
+    if(dec->IMDCTInfo)         {ArenaFree(dec->IMDCTInfo);       dec->IMDCTInfo=0;}
+    if(dec->SubbandInfo)       {ArenaFree(dec->SubbandInfo);     dec->SubbandInfo=0;}
+    if(dec->MP3FrameInfo)      {ArenaFree(dec->MP3FrameInfo);    dec->MP3FrameInfo=0;}
+    if(dec->huffFastRef)       {MP3FreeHuffFastTables();    dec->huffFastRef=false;}
+    ArenaFree(dec);
+}
 void MP3Decoder_FreeBuffers()
 {
 //    uint32_t i = ESP.getFreeHeap();
 
-    if(m_MP3DecInfo)        {free(m_MP3DecInfo);      m_MP3DecInfo=NULL;}
-    if(m_FrameHeader)       {free(m_FrameHeader);     m_FrameHeader=NULL;}
-    if(m_SideInfo)          {free(m_SideInfo);        m_SideInfo=NULL;}
-    if(m_ScaleFactorJS )    {free(m_ScaleFactorJS);   m_ScaleFactorJS=NULL;}
-    if(m_HuffmanInfo)       {free(m_HuffmanInfo);     m_HuffmanInfo=NULL;}
-    if(m_DequantInfo)       {free(m_DequantInfo);     m_DequantInfo=0;}
-    if(m_IMDCTInfo)         {free(m_IMDCTInfo);       m_IMDCTInfo=0;}
-    if(m_SubbandInfo)       {free(m_SubbandInfo);     m_SubbandInfo=0;}
-    if(m_MP3FrameInfo)      {free(m_MP3FrameInfo);    m_MP3FrameInfo=0;}
+    MP3Decoder_Destroy(m_defaultDec);
+    m_defaultDec = NULL;
 
 //    log_i("MP3Decoder: %lu bytes memory was freed", ESP.getFreeHeap() - i);
 }
@@ -1592,6 +1870,106 @@ void MP3Decoder_FreeBuffers()
  * H U F F M A N N
  **********************************************************************************************************************/
 
+/***********************************************************************************************************************
+ * Function:    MP3InitHuffFastTables, MP3FreeHuffFastTables
+ *
+ * Description: build (free) the single probe lookup tables of the Huffman decoder
+ *
+ * Inputs:      none
+ *
+ * Outputs:     m_huffFast, shared by all decoder contexts, built by the first user, freed by the last one
+ *
+ * Return:      false if not enough memory, otherwise true (Init)
+ *
+ * Notes:       one table per Huffman code table (tables 16..23 and 24..31 share their codes) and two for the
+ *                quad tables, each indexed by the next m_HUFF_FAST_BITS bits of the bitstream
+ *              an entry holds the number of bits of codeword plus sign bits and the signed values,
+ *                0 if the codeword, its sign bits or the linbits do not fit into m_HUFF_FAST_BITS.
+ *                Then the decoder takes the slow path through the multi-level tables
+ *              pairs: bit 0-3 x, bit 4-7 y, bit 8 sign x, bit 9 sign y, bit 12-15 length
+ *              quads: bit 0-3 vwxy (as in quadTable), bit 4-7 signs of y, x, w, v, bit 12-15 length
+ **********************************************************************************************************************/
+static uint16_t MakeHuffFastPair(int tabIdx, unsigned int bits){
+    const unsigned short *tCurr = huffTable + huffTabOffset[tabIdx];
+    HuffTabType_t tabType = (HuffTabType_t)huffTabLookup[tabIdx].tabType;
+    unsigned int cache = bits << (32 - m_HUFF_FAST_BITS);
+    int used = 0, maxBits, len;
+    unsigned short cw;
+
+    if (tabType == oneShot) {
+        maxBits = pgm_read_word(&tCurr[0]) & 0x000f;
+        cw = pgm_read_word(&tCurr[(cache >> (32 - maxBits)) + 1]);
+        len = (cw >> 12) & 0x000f;
+    } else {
+        while (1) {
+            maxBits = pgm_read_word(&tCurr[0]) & 0x000f;
+            cw = pgm_read_word(&tCurr[(cache >> (32 - maxBits)) + 1]);
+            len = (cw >> 12) & 0x000f;
+            if (len) break;
+            used += maxBits;                        /* jump into the next level, needs all maxBits */
+            if (used > m_HUFF_FAST_BITS) return 0;
+            cache <<= maxBits;
+            tCurr += cw;
+        }
+    }
+    int x = (cw >> 4) & 0x000f;
+    int y = (cw >> 8) & 0x000f;
+    if (tabType == loopLinbits && (x == 15 || y == 15)) return 0;
+    used += len;
+    if (used + (x ? 1 : 0) + (y ? 1 : 0) > m_HUFF_FAST_BITS) return 0;
+    cache <<= len;
+    uint16_t e = x | (y << 4);
+    if (x) {e |= (cache >> 31) << 8; cache <<= 1; used++;}
+    if (y) {e |= (cache >> 31) << 9; cache <<= 1; used++;}
+    return e | (used << 12);
+}
+static uint16_t MakeHuffFastQuad(int tabIdx, unsigned int bits){
+    const unsigned char *tBase = quadTable + quadTabOffset[tabIdx];
+    int maxBits = quadTabMaxBits[tabIdx];
+    unsigned int cache = bits << (32 - m_HUFF_FAST_BITS);
+    unsigned char cw = pgm_read_byte(&tBase[cache >> (32 - maxBits)]);
+    int len = (cw >> 4) & 0x0f;
+    int used = len;
+    cache <<= len;
+    uint16_t e = cw & 0x0f;
+    for (int i = 3; i >= 0; i--) {                  /* sign bits in the order v, w, x, y */
+        if (cw & (1 << i)) {
+            if (++used > m_HUFF_FAST_BITS) return 0;
+            e |= (cache >> 31) << (4 + i);
+            cache <<= 1;
+        }
+    }
+    return e | (used << 12);
+}
+bool MP3InitHuffFastTables(){
+    std::lock_guard<std::mutex> lock(m_huffFastLock);  /* the second user waits until the tables are complete */
+    if (m_huffFastUsers++) return true;
+    const int size = (m_HUFF_FAST_PAIRTABS + 2) << m_HUFF_FAST_BITS;
+    /* probed for every codeword, so internal RAM is preferred also where the decoder buffers are in PSRAM */
+    m_huffFast = (uint16_t*)ArenaMalloc(size * sizeof(uint16_t), ARENA_PREFER_INTERNAL);
+    if (!m_huffFast) {
+        m_huffFastUsers = 0;
+        log_e("not enough memory to allocate the mp3 huffman tables");
+        return false;
+    }
+    for (int tabIdx = 0; tabIdx < m_HUFF_PAIRTABS; tabIdx++) {
+        int slot = huffFastSlot[tabIdx];
+        if (slot < 0) continue;
+        uint16_t *t = m_huffFast + (slot << m_HUFF_FAST_BITS);
+        for (unsigned int bits = 0; bits < (1u << m_HUFF_FAST_BITS); bits++) t[bits] = MakeHuffFastPair(tabIdx, bits);
+    }
+    for (int tabIdx = 0; tabIdx < 2; tabIdx++) {
+        uint16_t *t = m_huffFast + ((m_HUFF_FAST_PAIRTABS + tabIdx) << m_HUFF_FAST_BITS);
+        for (unsigned int bits = 0; bits < (1u << m_HUFF_FAST_BITS); bits++) t[bits] = MakeHuffFastQuad(tabIdx, bits);
+    }
+    return true;
+}
+void MP3FreeHuffFastTables(){
+    std::lock_guard<std::mutex> lock(m_huffFastLock);
+    if (!m_huffFastUsers || --m_huffFastUsers) return;
+    ArenaFree(m_huffFast);
+    m_huffFast = NULL;
+}
 /***********************************************************************************************************************
  * Function:    DecodeHuffmanPairs
  *
@@ -1611,13 +1989,17 @@ void MP3Decoder_FreeBuffers()
  * Notes:       assumes that nVals is an even number
  *              si_huff.bit tests every Huffman codeword in every table (though not
  *                necessarily all linBits outputs for x,y > 15)
+ *              most codewords are resolved with their sign bits by one probe of the fast table,
+ *                long codewords and escapes (linbits) go through the multi-level huffTable
  **********************************************************************************************************************/
 // no improvement with section=data
-int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
+int MP3_IRAM DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
     int i, x, y;
     int cachedBits, padBits, len, startBits, linBits, maxBits, minBits;
     HuffTabType_t tabType;
     unsigned short cw, *tBase, *tCurr;
+    const uint16_t *tFast;
+    uint16_t fe;
     unsigned int cache;
 
     if (nVals <= 0)
@@ -1656,104 +2038,50 @@ int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned ch
             xy[i + 1] = 0;
         }
         return 0;
-    } else if (tabType == oneShot) {
-        /* single lookup, no escapes */
-
-        maxBits = (int)( (((unsigned short)(pgm_read_word(&tBase[0])) >>  0) & 0x000f));
-        tBase++;
-        padBits = 0;
-        while (nVals > 0) {
-            /* refill cache - assumes cachedBits <= 16 */
-            if (bitsLeft >= 16) {
-                /* load 2 new bytes into left-justified cache */
+    }
+
+    tFast = m_huffFast + (huffFastSlot[tabIdx] << m_HUFF_FAST_BITS);
+    tCurr = tBase;
+    padBits = 0;
+    while (nVals > 0) {
+        if (bitsLeft >= 16) {
+            /* load new bytes into left-justified cache, until it holds at least 25 bits */
+            do {
+                cache |= (unsigned int) (*buf++) << (24 - cachedBits);
+                cachedBits += 8;
+                bitsLeft -= 8;
+            } while (cachedBits <= 24 && bitsLeft >= 16);
+        } else {
+            /* last time through, pad cache with zeros and drain cache - assumes cachedBits <= 16 */
+            if (cachedBits + bitsLeft <= 0)
+                return -1;
+            if (bitsLeft > 0)
                 cache |= (unsigned int) (*buf++) << (24 - cachedBits);
+            if (bitsLeft > 8)
                 cache |= (unsigned int) (*buf++) << (16 - cachedBits);
-                cachedBits += 16;
-                bitsLeft -= 16;
-            } else {
-                /* last time through, pad cache with zeros and drain cache */
-                if (cachedBits + bitsLeft <= 0)
-                    return -1;
-                if (bitsLeft > 0)
-                    cache |= (unsigned int) (*buf++) << (24 - cachedBits);
-                if (bitsLeft > 8)
-                    cache |= (unsigned int) (*buf++) << (16 - cachedBits);
-                cachedBits += bitsLeft;
-                bitsLeft = 0;
-
-                cache &= (signed int) 0x80000000 >> (cachedBits - 1);
-                padBits = 11;
-                cachedBits += padBits; /* okay if this is > 32 (0's automatically shifted in from right) */
-            }
+            cachedBits += bitsLeft;
+            bitsLeft = 0;
 
-            /* largest maxBits = 9, plus 2 for sign bits, so make sure cache has at least 11 bits */
-            while (nVals > 0 && cachedBits >= 11) {
-                cw = pgm_read_word(&tBase[cache >> (32 - maxBits)]);
+            cache &= (signed int) 0x80000000 >> (cachedBits - 1);
+            padBits = 11;
+            cachedBits += padBits; /* okay if this is > 32 (0's automatically shifted in from right) */
+        }
 
-                len=(int)( (((unsigned short)(cw)) >> 12) & 0x000f);
+        /* largest maxBits = 9, plus 2 for sign bits, so make sure cache has at least 11 bits */
+        while (nVals > 0 && cachedBits >= 11) {
+            if (tCurr == tBase && (fe = tFast[cache >> (32 - m_HUFF_FAST_BITS)]) != 0) {
+                /* codeword and sign bits in one probe */
+                len = fe >> 12;
                 cachedBits -= len;
                 cache <<= len;
-
-                x=(int)( (((unsigned short)(cw)) >>  4) & 0x000f);
-                if (x) {
-                    (x) |= ((cache) & 0x80000000);
-                    cache <<= 1;
-                    cachedBits--;
-                }
-
-
-
-                y=(int)( (((unsigned short)(cw)) >>  8) & 0x000f);
-                if (y) {
-                    (y) |= ((cache) & 0x80000000);
-                    cache <<= 1;
-                    cachedBits--;
-                }
-
-                /* ran out of bits - should never have consumed padBits */
-                if (cachedBits < padBits)
-                    return -1;
-
-                *xy++ = x;
-                *xy++ = y;
-                nVals -= 2;
-            }
-        }
-        bitsLeft += (cachedBits - padBits);
-        return (startBits - bitsLeft);
-    } else if (tabType == loopLinbits || tabType == loopNoLinbits) {
-        tCurr = tBase;
-        padBits = 0;
-        while (nVals > 0) {
-            /* refill cache - assumes cachedBits <= 16 */
-            if (bitsLeft >= 16) {
-                /* load 2 new bytes into left-justified cache */
-                cache |= (unsigned int) (*buf++) << (24 - cachedBits);
-                cache |= (unsigned int) (*buf++) << (16 - cachedBits);
-                cachedBits += 16;
-                bitsLeft -= 16;
+                x = (int)((fe & 0x000f) | ((unsigned int)(fe & 0x0100) << 23));
+                y = (int)(((fe >> 4) & 0x000f) | ((unsigned int)(fe & 0x0200) << 22));
             } else {
-                /* last time through, pad cache with zeros and drain cache */
-                if (cachedBits + bitsLeft <= 0)
-                    return -1;
-                if (bitsLeft > 0)
-                    cache |= (unsigned int) (*buf++) << (24 - cachedBits);
-                if (bitsLeft > 8)
-                    cache |= (unsigned int) (*buf++) << (16 - cachedBits);
-                cachedBits += bitsLeft;
-                bitsLeft = 0;
-
-                cache &= (signed int) 0x80000000 >> (cachedBits - 1);
-                padBits = 11;
-                cachedBits += padBits; /* okay if this is > 32 (0's automatically shifted in from right) */
-            }
-
-            /* largest maxBits = 9, plus 2 for sign bits, so make sure cache has at least 11 bits */
-            while (nVals > 0 && cachedBits >= 11) {
-                maxBits = (int)( (((unsigned short)(pgm_read_word(&tCurr[0]))) >>  0) & 0x000f);
+                maxBits = (int)(pgm_read_word(&tCurr[0]) & 0x000f);
                 cw = pgm_read_word(&tCurr[(cache >> (32 - maxBits)) + 1]);
-                len=(int)( (((unsigned short)(cw)) >> 12) & 0x000f);
+                len = (int)((cw >> 12) & 0x000f);
                 if (!len) {
+                    /* next level of a loop table, may need a refill before */
                     cachedBits -= maxBits;
                     cache <<= maxBits;
                     tCurr += cw;
@@ -1762,8 +2090,8 @@ int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned ch
                 cachedBits -= len;
                 cache <<= len;
 
-                x=(int)( (((unsigned short)(cw)) >>  4) & 0x000f);
-                y=(int)( (((unsigned short)(cw)) >>  8) & 0x000f);
+                x = (int)((cw >> 4) & 0x000f);
+                y = (int)((cw >> 8) & 0x000f);
 
                 if (x == 15 && tabType == loopLinbits) {
                     minBits = linBits + 1 + (y ? 1 : 0);
@@ -1812,23 +2140,20 @@ int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned ch
                     cache <<= 1;
                     cachedBits--;
                 }
+            }
 
-                /* ran out of bits - should never have consumed padBits */
-                if (cachedBits < padBits)
-                    return -1;
+            /* ran out of bits - should never have consumed padBits */
+            if (cachedBits < padBits)
+                return -1;
 
-                *xy++ = x;
-                *xy++ = y;
-                nVals -= 2;
-                tCurr = tBase;
-            }
+            *xy++ = x;
+            *xy++ = y;
+            nVals -= 2;
+            tCurr = tBase;
         }
-        bitsLeft += (cachedBits - padBits);
-        return (startBits - bitsLeft);
     }
-
-    /* error in bitstream - trying to access unused Huffman table */
-    return -1;
+    bitsLeft += (cachedBits - padBits);
+    return (startBits - bitsLeft);
 }
 
 /***********************************************************************************************************************
@@ -1851,16 +2176,19 @@ int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned ch
  * Notes:        si_huff.bit tests every vwxy output in both quad tables
  **********************************************************************************************************************/
 // no improvement with section=data
-int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
+int MP3_IRAM DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
     int i, v, w, x, y;
     int len, maxBits, cachedBits, padBits;
     unsigned int cache;
     unsigned char cw, *tBase;
+    const uint16_t *tFast;
+    uint16_t fe;
 
     if(bitsLeft<=0) return 0;
 
     tBase = (unsigned char *) quadTable + quadTabOffset[tabIdx];
     maxBits = quadTabMaxBits[tabIdx];
+    tFast = m_huffFast + ((m_HUFF_FAST_PAIRTABS + tabIdx) << m_HUFF_FAST_BITS);
 
     /* initially fill cache with any partial byte */
     cache = 0;
@@ -1870,15 +2198,15 @@ int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned
 
     i = padBits = 0;
     while (i < (nVals - 3)) {
-        /* refill cache - assumes cachedBits <= 16 */
         if (bitsLeft >= 16) {
-            /* load 2 new bytes into left-justified cache */
-            cache |= (unsigned int) (*buf++) << (24 - cachedBits);
-            cache |= (unsigned int) (*buf++) << (16 - cachedBits);
-            cachedBits += 16;
-            bitsLeft -= 16;
+            /* load new bytes into left-justified cache, until it holds at least 25 bits */
+            do {
+                cache |= (unsigned int) (*buf++) << (24 - cachedBits);
+                cachedBits += 8;
+                bitsLeft -= 8;
+            } while (cachedBits <= 24 && bitsLeft >= 16);
         } else {
-            /* last time through, pad cache with zeros and drain cache */
+            /* last time through, pad cache with zeros and drain cache - assumes cachedBits <= 16 */
             if(cachedBits+bitsLeft <= 0) return i;
             if(bitsLeft>0) cache |= (unsigned int)(*buf++)<<(24-cachedBits);
             if (bitsLeft > 8) cache |= (unsigned int)(*buf++)<<(16 - cachedBits);
@@ -1892,36 +2220,48 @@ int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned
 
         /* largest maxBits = 6, plus 4 for sign bits, so make sure cache has at least 10 bits */
         while(i < (nVals - 3) && cachedBits >= 10){
-            cw = pgm_read_byte(&tBase[cache >> (32 - maxBits)]);
-            len=(int)( (((unsigned char)(cw)) >> 4) & 0x0f);
-            cachedBits -= len;
-            cache <<= len;
-
-            v=(int)( (((unsigned char)(cw)) >> 3) & 0x01);
-            if (v) {
-                (v) |= ((cache) & 0x80000000);
-                cache <<= 1;
-                cachedBits--;
-            }
-            w=(int)( (((unsigned char)(cw)) >> 2) & 0x01);
-            if (w) {
-                (w) |= ((cache) & 0x80000000);
-                cache <<= 1;
-                cachedBits--;
-            }
+            fe = tFast[cache >> (32 - m_HUFF_FAST_BITS)];
+            if (fe) {
+                /* codeword and sign bits in one probe */
+                len = fe >> 12;
+                cachedBits -= len;
+                cache <<= len;
+                v = (int)(((fe >> 3) & 0x01) | ((unsigned int)(fe & 0x80) << 24));
+                w = (int)(((fe >> 2) & 0x01) | ((unsigned int)(fe & 0x40) << 25));
+                x = (int)(((fe >> 1) & 0x01) | ((unsigned int)(fe & 0x20) << 26));
+                y = (int)(((fe >> 0) & 0x01) | ((unsigned int)(fe & 0x10) << 27));
+            } else {
+                cw = pgm_read_byte(&tBase[cache >> (32 - maxBits)]);
+                len=(int)( (((unsigned char)(cw)) >> 4) & 0x0f);
+                cachedBits -= len;
+                cache <<= len;
 
-            x=(int)( (((unsigned char)(cw)) >> 1) & 0x01);
-            if (x) {
-                (x) |= ((cache) & 0x80000000);
-                cache <<= 1;
-                cachedBits--;
-            }
+                v=(int)( (((unsigned char)(cw)) >> 3) & 0x01);
+                if (v) {
+                    (v) |= ((cache) & 0x80000000);
+                    cache <<= 1;
+                    cachedBits--;
+                }
+                w=(int)( (((unsigned char)(cw)) >> 2) & 0x01);
+                if (w) {
+                    (w) |= ((cache) & 0x80000000);
+                    cache <<= 1;
+                    cachedBits--;
+                }
+
+                x=(int)( (((unsigned char)(cw)) >> 1) & 0x01);
+                if (x) {
+                    (x) |= ((cache) & 0x80000000);
+                    cache <<= 1;
+                    cachedBits--;
+                }
 
-            y=(int)( (((unsigned char)(cw)) >> 0) & 0x01);
-            if (y) {
-                (y) |= ((cache) & 0x80000000);
-                cache <<= 1;
-                cachedBits--;
+                y=(int)( (((unsigned char)(cw)) >> 0) & 0x01);
+                if (y) {
+                    (y) |= ((cache) & 0x80000000);
+                    cache <<= 1;
+                    cachedBits--;
+                }
             }
 
             /* ran out of bits - okay (means we're done) */
@@ -1970,8 +2310,8 @@ int DecodeHuffman(unsigned char *buf, int *bitOffset, int huffBlockBits, int gr,
     unsigned char *startBuf = buf;
 
     SideInfoSub_t *sis;
-    sis = &m_SideInfoSub[gr][ch];
-    //hi = (HuffmanInfo_t*) (m_MP3DecInfo->HuffmanInfoPS);
+    sis = &m_dec->SideInfoSub[gr][ch];
+    //hi = (HuffmanInfo_t*) (m_dec->MP3DecInfo->HuffmanInfoPS);
 
     if (huffBlockBits < 0)
         return -1;
@@ -1979,20 +2319,20 @@ int DecodeHuffman(unsigned char *buf, int *bitOffset, int huffBlockBits, int gr,
     /* figure out region boundaries (the first 2*bigVals coefficients divided into 3 regions) */
     if (sis->winSwitchFlag && sis->blockType == 2) {
         if (sis->mixedBlock == 0) {
-            r1Start = m_SFBandTable.s[(sis->region0Count + 1) / 3] * 3;
+            r1Start = m_dec->SFBandTable.s[(sis->region0Count + 1) / 3] * 3;
         } else {
-            if (m_MPEGVersion == MPEG1) {
-                r1Start = m_SFBandTable.l[sis->region0Count + 1];
+            if (m_dec->MPEGVersion == MPEG1) {
+                r1Start = m_dec->SFBandTable.l[sis->region0Count + 1];
             } else {
                 /* see MPEG2 spec for explanation */
-                w = m_SFBandTable.s[4] - m_SFBandTable.s[3];
-                r1Start = m_SFBandTable.l[6] + 2 * w;
+                w = m_dec->SFBandTable.s[4] - m_dec->SFBandTable.s[3];
+                r1Start = m_dec->SFBandTable.l[6] + 2 * w;
             }
         }
         r2Start = m_MAX_NSAMP; /* short blocks don't have region 2 */
     } else {
-        r1Start = m_SFBandTable.l[sis->region0Count + 1];
-        r2Start = m_SFBandTable.l[sis->region0Count + 1 + sis->region1Count + 1];
+        r1Start = m_dec->SFBandTable.l[sis->region0Count + 1];
+        r2Start = m_dec->SFBandTable.l[sis->region0Count + 1 + sis->region1Count + 1];
     }
 
     /* offset rEnd index by 1 so first region = rEnd[1] - rEnd[0], etc. */
@@ -2002,12 +2342,12 @@ int DecodeHuffman(unsigned char *buf, int *bitOffset, int huffBlockBits, int gr,
     rEnd[0] = 0;
 
     /* rounds up to first all-zero pair (we don't check last pair for (x,y) == (non-zero, zero)) */
-    m_HuffmanInfo->nonZeroBound[ch] = rEnd[3];
+    m_dec->HuffmanInfo->nonZeroBound[ch] = rEnd[3];
 
     /* decode Huffman pairs (rEnd[i] are always even numbers) */
     bitsLeft = huffBlockBits;
     for (i = 0; i < 3; i++) {
-        bitsUsed = DecodeHuffmanPairs(m_HuffmanInfo->huffDecBuf[ch] + rEnd[i],
+        bitsUsed = DecodeHuffmanPairs(m_dec->HuffmanInfo->huffDecBuf[ch] + rEnd[i],
                 rEnd[i + 1] - rEnd[i], sis->tableSelect[i], bitsLeft, buf,
                 *bitOffset);
         if (bitsUsed < 0 || bitsUsed > bitsLeft) /* error - overran end of bitstream */
@@ -2020,13 +2360,13 @@ int DecodeHuffman(unsigned char *buf, int *bitOffset, int huffBlockBits, int gr,
     }
 
     /* decode Huffman quads (if any) */
-    m_HuffmanInfo->nonZeroBound[ch] += DecodeHuffmanQuads(m_HuffmanInfo->huffDecBuf[ch] + rEnd[3],
+    m_dec->HuffmanInfo->nonZeroBound[ch] += DecodeHuffmanQuads(m_dec->HuffmanInfo->huffDecBuf[ch] + rEnd[3],
             m_MAX_NSAMP - rEnd[3], sis->count1TableSelect, bitsLeft, buf,
             *bitOffset);
 
-    assert(m_HuffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
-    for (i = m_HuffmanInfo->nonZeroBound[ch]; i < m_MAX_NSAMP; i++)
-        m_HuffmanInfo->huffDecBuf[ch][i] = 0;
+    assert(m_dec->HuffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
+    for (i = m_dec->HuffmanInfo->nonZeroBound[ch]; i < m_MAX_NSAMP; i++)
+        m_dec->HuffmanInfo->huffDecBuf[ch][i] = 0;
 
     /* If bits used for 576 samples < huffBlockBits, then the extras are considered
      *  to be stuffing bits (throw away, but need to return correct bitstream position)
@@ -2067,13 +2407,13 @@ int DecodeHuffman(unsigned char *buf, int *bitOffset, int huffBlockBits, int gr,
 int MP3Dequantize(int gr){
     int i, ch, nSamps, mOut[2];
     CriticalBandInfo_t *cbi;
-    cbi = &m_CriticalBandInfo[0];
+    cbi = &m_dec->CriticalBandInfo[0];
     mOut[0] = mOut[1] = 0;
 
     /* dequantize all the samples in each channel */
-    for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
-        m_HuffmanInfo->gb[ch] = DequantChannel(m_HuffmanInfo->huffDecBuf[ch], m_DequantInfo->workBuf,
-                &m_HuffmanInfo->nonZeroBound[ch], &m_SideInfoSub[gr][ch], &m_ScaleFactorInfoSub[gr][ch], &cbi[ch]);
+    for (ch = 0; ch < m_dec->MP3DecInfo->nChans; ch++) {
+        m_dec->HuffmanInfo->gb[ch] = DequantChannel(m_dec->HuffmanInfo->huffDecBuf[ch], m_dec->DequantInfo->workBuf,
+                &m_dec->HuffmanInfo->nonZeroBound[ch], &m_dec->SideInfoSub[gr][ch], &m_dec->ScaleFactorInfoSub[gr][ch], &cbi[ch]);
     }
 
     /* joint stereo processing assumes one guard bit in input samples
@@ -2081,53 +2421,53 @@ int MP3Dequantize(int gr){
      *   just make a pass over the data and clip to [-2^30+1, 2^30-1]
      * in practice this may never happen
      */
-    if (m_FrameHeader->modeExt && (m_HuffmanInfo->gb[0] < 1 || m_HuffmanInfo->gb[1] < 1)) {
-        for (i = 0; i < m_HuffmanInfo->nonZeroBound[0]; i++) {
-            if (m_HuffmanInfo->huffDecBuf[0][i] < -0x3fffffff)  m_HuffmanInfo->huffDecBuf[0][i] = -0x3fffffff;
-            if (m_HuffmanInfo->huffDecBuf[0][i] >  0x3fffffff)  m_HuffmanInfo->huffDecBuf[0][i] =  0x3fffffff;
+    if (m_dec->FrameHeader->modeExt && (m_dec->HuffmanInfo->gb[0] < 1 || m_dec->HuffmanInfo->gb[1] < 1)) {
+        for (i = 0; i < m_dec->HuffmanInfo->nonZeroBound[0]; i++) {
+            if (m_dec->HuffmanInfo->huffDecBuf[0][i] < -0x3fffffff)  m_dec->HuffmanInfo->huffDecBuf[0][i] = -0x3fffffff;
+            if (m_dec->HuffmanInfo->huffDecBuf[0][i] >  0x3fffffff)  m_dec->HuffmanInfo->huffDecBuf[0][i] =  0x3fffffff;
         }
-        for (i = 0; i < m_HuffmanInfo->nonZeroBound[1]; i++) {
-            if (m_HuffmanInfo->huffDecBuf[1][i] < -0x3fffffff)  m_HuffmanInfo->huffDecBuf[1][i] = -0x3fffffff;
-            if (m_HuffmanInfo->huffDecBuf[1][i] >  0x3fffffff)  m_HuffmanInfo->huffDecBuf[1][i] =  0x3fffffff;
+        for (i = 0; i < m_dec->HuffmanInfo->nonZeroBound[1]; i++) {
+            if (m_dec->HuffmanInfo->huffDecBuf[1][i] < -0x3fffffff)  m_dec->HuffmanInfo->huffDecBuf[1][i] = -0x3fffffff;
+            if (m_dec->HuffmanInfo->huffDecBuf[1][i] >  0x3fffffff)  m_dec->HuffmanInfo->huffDecBuf[1][i] =  0x3fffffff;
         }
     }
 
     /* do mid-side stereo processing, if enabled */
-    if (m_FrameHeader->modeExt >> 1) {
-        if (m_FrameHeader->modeExt & 0x01) {
+    if (m_dec->FrameHeader->modeExt >> 1) {
+        if (m_dec->FrameHeader->modeExt & 0x01) {
             /* intensity stereo enabled - run mid-side up to start of right zero region */
             if (cbi[1].cbType == 0)
-                nSamps = m_SFBandTable.l[cbi[1].cbEndL + 1];
+                nSamps = m_dec->SFBandTable.l[cbi[1].cbEndL + 1];
             else
-                nSamps = 3 * m_SFBandTable.s[cbi[1].cbEndSMax + 1];
+                nSamps = 3 * m_dec->SFBandTable.s[cbi[1].cbEndSMax + 1];
         } else {
             /* intensity stereo disabled - run mid-side on whole spectrum */
-            nSamps = (m_HuffmanInfo->nonZeroBound[0] > m_HuffmanInfo->nonZeroBound[1] ?
-                                                       m_HuffmanInfo->nonZeroBound[0] : m_HuffmanInfo->nonZeroBound[1]);
+            nSamps = (m_dec->HuffmanInfo->nonZeroBound[0] > m_dec->HuffmanInfo->nonZeroBound[1] ?
+                                                       m_dec->HuffmanInfo->nonZeroBound[0] : m_dec->HuffmanInfo->nonZeroBound[1]);
         }
-        MidSideProc(m_HuffmanInfo->huffDecBuf, nSamps, mOut);
+        MidSideProc(m_dec->HuffmanInfo->huffDecBuf, nSamps, mOut);
     }
 
     /* do intensity stereo processing, if enabled */
-    if (m_FrameHeader->modeExt & 0x01) {
-        nSamps = m_HuffmanInfo->nonZeroBound[0];
-        if (m_MPEGVersion == MPEG1) {
-            IntensityProcMPEG1(m_HuffmanInfo->huffDecBuf, nSamps, &m_ScaleFactorInfoSub[gr][1], &m_CriticalBandInfo[0],
-                    m_FrameHeader->modeExt >> 1, m_SideInfoSub[gr][1].mixedBlock, mOut);
+    if (m_dec->FrameHeader->modeExt & 0x01) {
+        nSamps = m_dec->HuffmanInfo->nonZeroBound[0];
+        if (m_dec->MPEGVersion == MPEG1) {
+            IntensityProcMPEG1(m_dec->HuffmanInfo->huffDecBuf, nSamps, &m_dec->ScaleFactorInfoSub[gr][1], &m_dec->CriticalBandInfo[0],
+                    m_dec->FrameHeader->modeExt >> 1, m_dec->SideInfoSub[gr][1].mixedBlock, mOut);
         } else {
-            IntensityProcMPEG2(m_HuffmanInfo->huffDecBuf, nSamps, &m_ScaleFactorInfoSub[gr][1], &m_CriticalBandInfo[0],
-                    m_ScaleFactorJS, m_FrameHeader->modeExt >> 1, m_SideInfoSub[gr][1].mixedBlock, mOut);
+            IntensityProcMPEG2(m_dec->HuffmanInfo->huffDecBuf, nSamps, &m_dec->ScaleFactorInfoSub[gr][1], &m_dec->CriticalBandInfo[0],
+                    m_dec->ScaleFactorJS, m_dec->FrameHeader->modeExt >> 1, m_dec->SideInfoSub[gr][1].mixedBlock, mOut);
         }
     }
 
     /* adjust guard bit count and nonZeroBound if we did any stereo processing */
-    if (m_FrameHeader->modeExt) {
-        m_HuffmanInfo->gb[0] = CLZ(mOut[0]) - 1;
-        m_HuffmanInfo->gb[1] = CLZ(mOut[1]) - 1;
-        nSamps = (m_HuffmanInfo->nonZeroBound[0] > m_HuffmanInfo->nonZeroBound[1] ?
-                                                       m_HuffmanInfo->nonZeroBound[0] : m_HuffmanInfo->nonZeroBound[1]);
-        m_HuffmanInfo->nonZeroBound[0] = nSamps;
-        m_HuffmanInfo->nonZeroBound[1] = nSamps;
+    if (m_dec->FrameHeader->modeExt) {
+        m_dec->HuffmanInfo->gb[0] = CLZ(mOut[0]) - 1;
+        m_dec->HuffmanInfo->gb[1] = CLZ(mOut[1]) - 1;
+        nSamps = (m_dec->HuffmanInfo->nonZeroBound[0] > m_dec->HuffmanInfo->nonZeroBound[1] ?
+                                                       m_dec->HuffmanInfo->nonZeroBound[0] : m_dec->HuffmanInfo->nonZeroBound[1]);
+        m_dec->HuffmanInfo->nonZeroBound[0] = nSamps;
+        m_dec->HuffmanInfo->nonZeroBound[1] = nSamps;
     }
 
     /* output format Q(DQ_FRACBITS_OUT) */
@@ -2152,7 +2492,7 @@ int MP3Dequantize(int gr){
  *
  * Return:      bitwise-OR of the unsigned outputs (for guard bit calculations)
  **********************************************************************************************************************/
-int DequantBlock(int *inbuf, int *outbuf, int num, int scale){
+int MP3_IRAM DequantBlock(int *inbuf, int *outbuf, int num, int scale){
     int tab4[4];
     int scalef, scalei, shift;
     int sx, x, y;
@@ -2199,7 +2539,7 @@ int DequantBlock(int *inbuf, int *outbuf, int num, int scale){
                 if (x < 0x40000000)
                     x <<= 1, shift += 1;
 
-                coef = (x < m_SQRTHALF) ? poly43lo : poly43hi;
+                coef = ((uint32_t)x < m_SQRTHALF) ? poly43lo : poly43hi;
 
                 /* polynomial */
                 y = coef[0];
@@ -2270,7 +2610,7 @@ int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound,  SideInfoSub
     if (sis->blockType == 2) {
         // cbStartL = 0;
         if (sis->mixedBlock) {
-            cbEndL = (m_MPEGVersion == MPEG1 ? 8 : 6);
+            cbEndL = (m_dec->MPEGVersion == MPEG1 ? 8 : 6);
             cbStartS = 3;
         } else {
             cbEndL = 0;
@@ -2299,7 +2639,7 @@ int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound,  SideInfoSub
      *   dividing every sample by sqrt(2) = multiplying by 2^-.5)
      */
     globalGain = sis->globalGain;
-    if (m_FrameHeader->modeExt >> 1)
+    if (m_dec->FrameHeader->modeExt >> 1)
          globalGain -= 2;
     globalGain += m_IMDCT_SCALE;      /* scale everything by sqrt(2), for fast IMDCT36 */
 
@@ -2307,7 +2647,7 @@ int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound,  SideInfoSub
     for (cb = 0; cb < cbEndL; cb++) {
 
         nonZero = 0;
-        nSamps = m_SFBandTable.l[cb + 1] - m_SFBandTable.l[cb];
+        nSamps = m_dec->SFBandTable.l[cb + 1] - m_dec->SFBandTable.l[cb];
         gainI = 210 - globalGain + sfactMultiplier * (sfis->l[cb] + (sis->preFlag ? (int)preTab[cb] : 0));
 
         nonZero |= DequantBlock(sampleBuf + i, sampleBuf + i, nSamps, gainI);
@@ -2336,7 +2676,7 @@ int DequantChannel(int *sampleBuf, int *workBuf, int *nonZeroBound,  SideInfoSub
     cbMax[2] = cbMax[1] = cbMax[0] = cbStartS;
     for (cb = cbStartS; cb < cbEndS; cb++) {
 
-        nSamps = m_SFBandTable.s[cb + 1] - m_SFBandTable.s[cb];
+        nSamps = m_dec->SFBandTable.s[cb + 1] - m_dec->SFBandTable.s[cb];
         for (w = 0; w < 3; w++) {
             nonZero =  0;
             gainI = 210 - globalGain + 8*sis->subBlockGain[w] + sfactMultiplier*(sfis->s[cb][w]);
@@ -2467,13 +2807,13 @@ void IntensityProcMPEG1(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,  ScaleFacto
         cbStartL = cbi[1].cbEndL + 1;
         cbEndL = cbi[0].cbEndL + 1;
         cbStartS = cbEndS = 0;
-        i = m_SFBandTable.l[cbStartL];
+        i = m_dec->SFBandTable.l[cbStartL];
     } else if (cbi[1].cbType == 1 || cbi[1].cbType == 2) {
         /* short or mixed block */
         cbStartS = cbi[1].cbEndSMax + 1;
         cbEndS = cbi[0].cbEndSMax + 1;
         cbStartL = cbEndL = 0;
-        i = 3 * m_SFBandTable.s[cbStartS];
+        i = 3 * m_dec->SFBandTable.s[cbStartS];
     }
     sampsLeft = nSamps - i; /* process to length of left */
     isfTab = (int *) ISFMpeg1[midSideFlag];
@@ -2490,7 +2830,7 @@ void IntensityProcMPEG1(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,  ScaleFacto
             fr = isfTab[6] - isfTab[isf];
         }
 
-        n = m_SFBandTable.l[cb + 1] - m_SFBandTable.l[cb];
+        n = m_dec->SFBandTable.l[cb + 1] - m_dec->SFBandTable.l[cb];
         for (j = 0; j < n && sampsLeft > 0; j++, i++) {
             xr = MULSHIFT32(fr, x[0][i]) << 2;
             x[1][i] = xr;
@@ -2513,7 +2853,7 @@ void IntensityProcMPEG1(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,  ScaleFacto
                 frs[w] = isfTab[6] - isfTab[isf];
             }
         }
-        n = m_SFBandTable.s[cb + 1] - m_SFBandTable.s[cb];
+        n = m_dec->SFBandTable.s[cb + 1] - m_dec->SFBandTable.s[cb];
         for (j = 0; j < n && sampsLeft >= 3; j++, i += 3) {
             xr = MULSHIFT32(frs[0], x[0][i + 0]) << 2;
             x[1][i + 0] = xr;
@@ -2589,7 +2929,7 @@ void IntensityProcMPEG2(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,
         il[21] = il[22] = 1;
         cbStartL = cbi[1].cbEndL + 1; /* start at end of right */
         cbEndL = cbi[0].cbEndL + 1; /* process to end of left */
-        i = m_SFBandTable.l[cbStartL];
+        i = m_dec->SFBandTable.l[cbStartL];
         sampsLeft = nSamps - i;
 
         for (cb = cbStartL; cb < cbEndL; cb++) {
@@ -2602,7 +2942,7 @@ void IntensityProcMPEG2(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,
                 fl = isfTab[(sfIdx & 0x01 ? isf : 0)];
                 fr = isfTab[(sfIdx & 0x01 ? 0 : isf)];
             }
-            int r=m_SFBandTable.l[cb + 1] - m_SFBandTable.l[cb];
+            int r=m_dec->SFBandTable.l[cb + 1] - m_dec->SFBandTable.l[cb];
             n=(r < sampsLeft ? r : sampsLeft);
             //n = MIN(fh->sfBand->l[cb + 1] - fh->sfBand->l[cb], sampsLeft);
             for (j = 0; j < n; j++, i++) {
@@ -2625,7 +2965,7 @@ void IntensityProcMPEG2(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,
         for (w = 0; w < 3; w++) {
             cbStartS = cbi[1].cbEndS[w] + 1; /* start at end of right */
             cbEndS = cbi[0].cbEndS[w] + 1; /* process to end of left */
-            i = 3 * m_SFBandTable.s[cbStartS] + w;
+            i = 3 * m_dec->SFBandTable.s[cbStartS] + w;
 
             /* skip through sample array by 3, so early-exit logic would be more tricky */
             for (cb = cbStartS; cb < cbEndS; cb++) {
@@ -2638,7 +2978,7 @@ void IntensityProcMPEG2(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,
                     fl = isfTab[(sfIdx & 0x01 ? isf : 0)];
                     fr = isfTab[(sfIdx & 0x01 ? 0 : isf)];
                 }
-                n = m_SFBandTable.s[cb + 1] - m_SFBandTable.s[cb];
+                n = m_dec->SFBandTable.s[cb + 1] - m_dec->SFBandTable.s[cb];
 
                 for (j = 0; j < n; j++, i += 3) {
                     xr = MULSHIFT32(fr, x[0][i]) << 2;
@@ -2660,114 +3000,6 @@ void IntensityProcMPEG2(int x[m_MAX_NCHAN][m_MAX_NSAMP], int nSamps,
  * I M D C T
  **********************************************************************************************************************/
 
-/***********************************************************************************************************************
- * Function:    AntiAlias
- *
- * Description: smooth transition across DCT block boundaries (every 18 coefficients)
- *
- * Inputs:      vector of dequantized coefficients, length = (nBfly+1) * 18
- *              number of "butterflies" to perform (one butterfly means one
- *                inter-block smoothing operation)
- *
- * Outputs:     updated coefficient vector x
- *
- * Return:      none
- *
- * Notes:       weighted average of opposite bands (pairwise) from the 8 samples
- *                before and after each block boundary
- *              nBlocks = (nonZeroBound + 7) / 18, since nZB is the first ZERO sample
- *                above which all other samples are also zero
- *              max gain per sample = 1.372
- *                MAX(i) (abs(csa[i][0]) + abs(csa[i][1]))
- *              bits gained = 0
- *              assume at least 1 guard bit in x[] to avoid overflow
- *                (should be guaranteed from dequant, and max gain from stproc * max
- *                 gain from AntiAlias < 2.0)
- **********************************************************************************************************************/
-// a little bit faster in RAM (< 1 ms per block)
-/* __attribute__ ((section (".data"))) */
-void AntiAlias(int *x, int nBfly){
-    int k, a0, b0, c0, c1;
-    const uint32_t *c;
-
-    /* csa = Q31 */
-    for (k = nBfly; k > 0; k--) {
-        c = csa[0];
-        x += 18;
-        a0 = x[-1];
-        c0 = *c;
-        c++;
-        b0 = x[0];
-        c1 = *c;
-        c++;
-        x[-1] = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1;
-        x[0] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1;
-
-        a0 = x[-2];
-        c0 = *c;
-        c++;
-        b0 = x[1];
-        c1 = *c;
-        c++;
-        x[-2] = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1;
-        x[1] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1;
-
-        a0 = x[-3];
-        c0 = *c;
-        c++;
-        b0 = x[2];
-        c1 = *c;
-        c++;
-        x[-3] = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1;
-        x[2] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1;
-
-        a0 = x[-4];
-        c0 = *c;
-        c++;
-        b0 = x[3];
-        c1 = *c;
-        c++;
-        x[-4] = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1;
-        x[3] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1;
-
-        a0 = x[-5];
-        c0 = *c;
-        c++;
-        b0 = x[4];
-        c1 = *c;
-        c++;
-        x[-5] = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1;
-        x[4] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1;
-
-        a0 = x[-6];
-        c0 = *c;
-        c++;
-        b0 = x[5];
-        c1 = *c;
-        c++;
-        x[-6] = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1;
-        x[5] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1;
-
-        a0 = x[-7];
-        c0 = *c;
-        c++;
-        b0 = x[6];
-        c1 = *c;
-        c++;
-        x[-7] = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1;
-        x[6] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1;
-
-        a0 = x[-8];
-        c0 = *c;
-        c++;
-        b0 = x[7];
-        c1 = *c;
-        c++;
-        x[-8] = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1;
-        x[7] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1;
-    }
-}
-
 /***********************************************************************************************************************
  * Function:    WinPrevious
  *
@@ -2883,7 +3115,7 @@ int FreqInvertRescale(int *y, int *xPrev, int blockIdx, int es) {
 
 
 /* require at least 3 guard bits in x[] to ensure no overflow */
-void idct9(int *x) {
+void MP3_IRAM idct9(int *x) {
     int a1, a2, a3, a4, a5, a6, a7, a8, a9;
     int a10, a11, a12, a13, a14, a15, a16, a17, a18;
     int a19, a20, a21, a22, a23, a24, a25, a26, a27;
@@ -2967,17 +3199,20 @@ void idct9(int *x) {
 /***********************************************************************************************************************
  * Function:    IMDCT36
  *
- * Description: 36-point modified DCT, with windowing and overlap-add (50% overlap)
+ * Description: anti-alias butterflies with the next block, 36-point modified DCT, with windowing and overlap-add
+ *                (50% overlap)
  *
- * Inputs:      vector of 18 coefficients (N/2 inputs produces N outputs, by symmetry)
+ * Inputs:      vector of 18 coefficients (N/2 inputs produces N outputs, by symmetry), followed by the next block
  *              overlap part of last IMDCT (9 samples - see output comments)
  *              window type (0,1,2,3) of current and previous block
  *              current block index (for deciding whether to do frequency inversion)
  *              number of guard bits in input vector
+ *              aa != 0: do the anti-alias butterflies between this block and the next one
  *
  * Outputs:     18 output samples, after windowing and overlap-add with last frame
  *              second half of (unwindowed) 36-point IMDCT - save for next time
  *                only save 9 xPrev samples, using symmetry (see WinPrevious())
+ *              first 8 coefficients of the next block anti-aliased (if aa)
  *
  * Notes:       this is Ken's hyper-fast algorithm, including symmetric sin window
  *                optimization, if applicable
@@ -2991,47 +3226,74 @@ void idct9(int *x) {
  *              this is the fastest known algorithm for performing
  *                long IMDCT + windowing + overlap-add in MP3
  *
+ *              anti-alias: weighted average of opposite bands (pairwise) from the 8 samples
+ *                before and after each block boundary, max gain per sample = 1.372
+ *                MAX(i) (abs(csa[i][0]) + abs(csa[i][1])), bits gained = 0
+ *                the upper 8 samples of this block go straight into the accumulator loop, they are not
+ *                stored back
+ *              a block that is zero after anti-aliasing skips both idct9 (only the overlap is windowed)
+ *
  * Return:      mOut (OR of abs(y) for all y calculated here)
  **********************************************************************************************************************/
 // barely faster in RAM
 
-int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb){
+int MP3_IRAM IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb, int aa){
     int i, es, xBuf[18], xPrevWin[18];
-    int acc1, acc2, s, d, t, mOut;
+    int acc1, acc2, s, d, t, mOut, nz;
     int xo, xe, c, *xp, yLo, yHi;
+    int x0, x1, a0, b0, c0, c1;
     const uint32_t *cp, *wp;
-    acc1 = acc2 = 0;
-    xCurr += 17;
+
     /* 7 gb is always adequate for antialias + accumulator loop + idct9 */
+    es = 0;
     if (gb < 7) {
         /* rarely triggered - 5% to 10% of the time on normal clips (with Q25 input) */
         es = 7 - gb;
-        for (i = 8; i >= 0; i--) {
-            acc1 = ((*xCurr--) >> es) - acc1;
-            acc2 = acc1 - acc2;
-            acc1 = ((*xCurr--) >> es) - acc1;
-            xBuf[i + 9] = acc2; /* odd */
-            xBuf[i + 0] = acc1; /* even */
+        for (i = 0; i < 9; i++)
             xPrev[i] >>= es;
+    }
+
+/* butterfly j across the boundary to the next block, csa = Q31 */
+#define AA_BFLY(j, v) { \
+    a0 = xCurr[17 - (j)];   b0 = xCurr[18 + (j)]; \
+    c0 = csa[(j)][0];       c1 = csa[(j)][1]; \
+    v = (MULSHIFT32(c0, a0) - MULSHIFT32(c1, b0)) << 1; \
+    xCurr[18 + (j)] = (MULSHIFT32(c0, b0) + MULSHIFT32(c1, a0)) << 1; \
+}
+/* max gain = 18, assume adequate guard bits */
+#define ACC_STEP { \
+    nz |= x1 | x0; \
+    acc1 = (x1 >> es) - acc1; \
+    acc2 = acc1 - acc2; \
+    acc1 = (x0 >> es) - acc1; \
+    xBuf[i + 9] = acc2; /* odd */ \
+    xBuf[i + 0] = acc1; /* even */ \
+}
+    acc1 = acc2 = nz = 0;
+    i = 8;
+    if (aa) {
+        for (; i >= 5; i--) {
+            AA_BFLY(2 * (8 - i) + 0, x1);
+            AA_BFLY(2 * (8 - i) + 1, x0);
+            ACC_STEP;
         }
-    } else {
-        es = 0;
-        /* max gain = 18, assume adequate guard bits */
-        for (i = 8; i >= 0; i--) {
-            acc1 = (*xCurr--) - acc1;
-            acc2 = acc1 - acc2;
-            acc1 = (*xCurr--) - acc1;
-            xBuf[i + 9] = acc2; /* odd */
-            xBuf[i + 0] = acc1; /* even */
-        }
     }
+    for (; i >= 0; i--) {
+        x1 = xCurr[2 * i + 1];
+        x0 = xCurr[2 * i + 0];
+        ACC_STEP;
+    }
+#undef ACC_STEP
+#undef AA_BFLY
     /* xEven[0] and xOdd[0] scaled by 0.5 */
     xBuf[9] >>= 1;
     xBuf[0] >>= 1;
 
-    /* do 9-point IDCT on even and odd */
-    idct9(xBuf + 0); /* even */
-    idct9(xBuf + 9); /* odd */
+    /* do 9-point IDCT on even and odd, all zero in a zero block */
+    if (nz) {
+        idct9(xBuf + 0); /* even */
+        idct9(xBuf + 9); /* odd */
+    }
 
     xp = xBuf + 8;
     cp = c18 + 8;
@@ -3287,7 +3549,7 @@ int HybridTransform(int *xCurr, int *xPrev, int y[m_BLOCK_SIZE][m_NBANDS], SideI
 
         /* do 36-point IMDCT, including windowing and overlap-add */
         mOut |= IMDCT36(xCurr, xPrev, &(y[0][i]), currWinIdx, prevWinIdx, i,
-                bc->gbIn);
+                bc->gbIn, i < bc->nBfly);
         xCurr += 18;
         xPrev += 9;
     }
@@ -3368,20 +3630,20 @@ int IMDCT( int gr, int ch) {
     int nBfly, blockCutoff;
     BlockCount_t bc;
 
-    /* m_SideInfo is an array of up to 4 structs, stored as gr0ch0, gr0ch1, gr1ch0, gr1ch1 */
+    /* m_dec->SideInfo is an array of up to 4 structs, stored as gr0ch0, gr0ch1, gr1ch0, gr1ch1 */
     /* anti-aliasing done on whole long blocks only
      * for mixed blocks, nBfly always 1, except 3 for 8 kHz MPEG 2.5 (see sfBandTab)
      *   nLongBlocks = number of blocks with (possibly) non-zero power
      *   nBfly = number of butterflies to do (nLongBlocks - 1, unless no long blocks)
      */
-    blockCutoff = m_SFBandTable.l[(m_MPEGVersion == MPEG1 ? 8 : 6)] / 18; /* same as 3* num short sfb's in spec */
-    if (m_SideInfoSub[gr][ch].blockType != 2) {
+    blockCutoff = m_dec->SFBandTable.l[(m_dec->MPEGVersion == MPEG1 ? 8 : 6)] / 18; /* same as 3* num short sfb's in spec */
+    if (m_dec->SideInfoSub[gr][ch].blockType != 2) {
         /* all long transforms */
-        int x=(m_HuffmanInfo->nonZeroBound[ch] + 7) / 18 + 1;
+        int x=(m_dec->HuffmanInfo->nonZeroBound[ch] + 7) / 18 + 1;
         bc.nBlocksLong=(x<32 ? x : 32);
         //bc.nBlocksLong = min((hi->nonZeroBound[ch] + 7) / 18 + 1, 32);
         nBfly = bc.nBlocksLong - 1;
-    } else if (m_SideInfoSub[gr][ch].blockType == 2 && m_SideInfoSub[gr][ch].mixedBlock) {
+    } else if (m_dec->SideInfoSub[gr][ch].blockType == 2 && m_dec->SideInfoSub[gr][ch].mixedBlock) {
         /* mixed block - long transforms until cutoff, then short transforms */
         bc.nBlocksLong = blockCutoff;
         nBfly = bc.nBlocksLong - 1;
@@ -3391,34 +3653,273 @@ int IMDCT( int gr, int ch) {
         nBfly = 0;
     }
 
-    AntiAlias(m_HuffmanInfo->huffDecBuf[ch], nBfly);
-    int x=m_HuffmanInfo->nonZeroBound[ch];
+    /* the anti-alias butterflies are done in IMDCT36 */
+    bc.nBfly = nBfly;
+    int x=m_dec->HuffmanInfo->nonZeroBound[ch];
     int y=nBfly * 18 + 8;
-    m_HuffmanInfo->nonZeroBound[ch]=(x>y ? x: y);
+    m_dec->HuffmanInfo->nonZeroBound[ch]=(x>y ? x: y);
 
-    assert(m_HuffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
+    assert(m_dec->HuffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
 
     /* for readability, use a struct instead of passing a million parameters to HybridTransform() */
-    bc.nBlocksTotal = (m_HuffmanInfo->nonZeroBound[ch] + 17) / 18;
-    bc.nBlocksPrev = m_IMDCTInfo->numPrevIMDCT[ch];
-    bc.prevType = m_IMDCTInfo->prevType[ch];
-    bc.prevWinSwitch = m_IMDCTInfo->prevWinSwitch[ch];
+    bc.nBlocksTotal = (m_dec->HuffmanInfo->nonZeroBound[ch] + 17) / 18;
+    bc.nBlocksPrev = m_dec->IMDCTInfo->numPrevIMDCT[ch];
+    bc.prevType = m_dec->IMDCTInfo->prevType[ch];
+    bc.prevWinSwitch = m_dec->IMDCTInfo->prevWinSwitch[ch];
     /* where WINDOW switches (not nec. transform) */
-    bc.currWinSwitch = (m_SideInfoSub[gr][ch].mixedBlock ? blockCutoff : 0);
-    bc.gbIn = m_HuffmanInfo->gb[ch];
+    bc.currWinSwitch = (m_dec->SideInfoSub[gr][ch].mixedBlock ? blockCutoff : 0);
+    bc.gbIn = m_dec->HuffmanInfo->gb[ch];
 
-    m_IMDCTInfo->numPrevIMDCT[ch] = HybridTransform(m_HuffmanInfo->huffDecBuf[ch], m_IMDCTInfo->overBuf[ch],
-            m_IMDCTInfo->outBuf[ch], &m_SideInfoSub[gr][ch], &bc);
-    m_IMDCTInfo->prevType[ch] = m_SideInfoSub[gr][ch].blockType;
-    m_IMDCTInfo->prevWinSwitch[ch] = bc.currWinSwitch; /* 0 means not a mixed block (either all short or all long) */
-    m_IMDCTInfo->gb[ch] = bc.gbOut;
+    m_dec->IMDCTInfo->numPrevIMDCT[ch] = HybridTransform(m_dec->HuffmanInfo->huffDecBuf[ch], m_dec->IMDCTInfo->overBuf[ch],
+            m_dec->IMDCTInfo->outBuf[ch], &m_dec->SideInfoSub[gr][ch], &bc);
+    m_dec->IMDCTInfo->prevType[ch] = m_dec->SideInfoSub[gr][ch].blockType;
+    m_dec->IMDCTInfo->prevWinSwitch[ch] = bc.currWinSwitch; /* 0 means not a mixed block (either all short or all long) */
+    m_dec->IMDCTInfo->gb[ch] = bc.gbOut;
 
-    assert(m_IMDCTInfo->numPrevIMDCT[ch] <= m_NBANDS);
+    assert(m_dec->IMDCTInfo->numPrevIMDCT[ch] <= m_NBANDS);
 
     /* output has gained 2 int bits */
     return 0;
 }
 
+/***********************************************************************************************************************
+ * Function:    MP3DownmixActive
+ *
+ * Description: follow MP3SetDownmix(), switch the synthesis of a stereo stream between two channels and one
+ *
+ * Inputs:      none
+ *
+ * Outputs:     vbuf and overlap state handed over between the modes
+ *
+ * Return:      true if this granule is transformed and synthesized once for both channels
+ *
+ * Notes:       the polyphase filter is linear, entering the mix averages the vbuf history of both channels, leaving
+ *                it gives the mixed history to both. The overlaps are merged later by MP3DownmixIMDCT(), once both
+ *                channels are windowed alike
+ **********************************************************************************************************************/
+bool MP3DownmixActive() {
+    int i, j;
+    int *vbuf = m_dec->SubbandInfo->vbuf;
+    IMDCTInfo_t *mi = m_dec->IMDCTInfo;
+    bool mono = m_dec->downmix && m_dec->MP3DecInfo->nChans == 2;
+
+    if (mono && !m_dec->monoActive) {
+        /* vbuf rows hold 32 words channel 0, then 32 words channel 1 */
+        for (i = 0; i < m_MAX_NCHAN * m_VBUF_LENGTH; i += 2 * m_NBANDS)
+            for (j = 0; j < m_NBANDS; j++)
+                vbuf[i + j] = AVG2(vbuf[i + j], vbuf[i + m_NBANDS + j]);
+        m_dec->monoSplit = true;
+    }
+    else if (!mono && m_dec->monoActive) {
+        for (i = 0; i < m_MAX_NCHAN * m_VBUF_LENGTH; i += 2 * m_NBANDS)
+            memcpy(vbuf + i + m_NBANDS, vbuf + i, m_NBANDS * sizeof(int));
+        if (!m_dec->monoSplit) {
+            memcpy(mi->overBuf[1], mi->overBuf[0], sizeof(mi->overBuf[0]));
+            mi->numPrevIMDCT[1] = mi->numPrevIMDCT[0];
+            mi->prevType[1] = mi->prevType[0];
+            mi->prevWinSwitch[1] = mi->prevWinSwitch[0];
+        }
+    }
+    m_dec->monoActive = mono;
+    return mono;
+}
+
+/***********************************************************************************************************************
+ * Function:    MP3DownmixIMDCT
+ *
+ * Description: IMDCT of a stereo granule for mono output
+ *
+ * Inputs:      index of current granule
+ *              dequantized L/R spectra of both channels (after MidSideProc / IntensityProc)
+ *
+ * Outputs:     mix in IMDCTInfo->outBuf[0], ready for the mono synthesis
+ *
+ * Return:      0 on success,  -1 on error
+ *
+ * Notes:       if both channels use the same block type the spectra are averaged and only channel 0 is
+ *                transformed, overBuf[0] then holds the overlap of the mix
+ *              otherwise both channels are transformed, each starting from the mixed overlap, and the outputs
+ *                are averaged. Their overlaps stay separate until prevType matches again (WinPrevious() windows
+ *                the overlap with the previous block type)
+ **********************************************************************************************************************/
+int MP3DownmixIMDCT(int gr) {
+    int i, n;
+    int *y0, *y1;
+    IMDCTInfo_t *mi = m_dec->IMDCTInfo;
+    HuffmanInfo_t *hi = m_dec->HuffmanInfo;
+    SideInfoSub_t *sis0 = &m_dec->SideInfoSub[gr][0];
+    SideInfoSub_t *sis1 = &m_dec->SideInfoSub[gr][1];
+    bool sameWin = sis0->blockType == sis1->blockType && sis0->mixedBlock == sis1->mixedBlock;
+
+    if (m_dec->monoSplit && sameWin && mi->prevType[0] == mi->prevType[1] &&
+        mi->prevWinSwitch[0] == mi->prevWinSwitch[1]) {
+        /* the overlap beyond numPrevIMDCT is zero */
+        for (i = 0; i < m_MAX_NSAMP / 2; i++)
+            mi->overBuf[0][i] = AVG2(mi->overBuf[0][i], mi->overBuf[1][i]);
+        if (mi->numPrevIMDCT[1] > mi->numPrevIMDCT[0]) mi->numPrevIMDCT[0] = mi->numPrevIMDCT[1];
+        m_dec->monoSplit = false;
+    }
+
+    if (!m_dec->monoSplit && sameWin) {
+        /* mix the spectra, one hybrid transform for both channels */
+        n = (hi->nonZeroBound[0] > hi->nonZeroBound[1] ? hi->nonZeroBound[0] : hi->nonZeroBound[1]);
+        for (i = 0; i < n; i++)
+            hi->huffDecBuf[0][i] = AVG2(hi->huffDecBuf[0][i], hi->huffDecBuf[1][i]);
+        hi->nonZeroBound[0] = n;
+        if (hi->gb[1] < hi->gb[0]) hi->gb[0] = hi->gb[1];
+        return IMDCT(gr, 0);
+    }
+
+    if (!m_dec->monoSplit) {
+        /* different windows, both channels continue from the mixed overlap */
+        memcpy(mi->overBuf[1], mi->overBuf[0], sizeof(mi->overBuf[0]));
+        mi->numPrevIMDCT[1] = mi->numPrevIMDCT[0];
+        mi->prevType[1] = mi->prevType[0];
+        mi->prevWinSwitch[1] = mi->prevWinSwitch[0];
+        m_dec->monoSplit = true;
+    }
+    if (IMDCT(gr, 0) < 0 || IMDCT(gr, 1) < 0)
+        return -1;
+    y0 = &mi->outBuf[0][0][0];
+    y1 = &mi->outBuf[1][0][0];
+    for (i = 0; i < m_BLOCK_SIZE * m_NBANDS; i++)
+        y0[i] = AVG2(y0[i], y1[i]);
+    if (mi->gb[1] < mi->gb[0]) mi->gb[0] = mi->gb[1];
+    return 0;
+}
+
+/***********************************************************************************************************************
+ * Function:    MP3WorkerTask
+ *
+ * Description: the second core's part of MP3DualCoreGranule(), IMDCT and synthesis of channel 1
+ *
+ * Inputs:      decoder context, job in workerGr and workerPcm, a NULL workerPcm ends the task
+ *
+ * Outputs:     channel 1 at the odd positions of workerPcm, result in workerRet
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void MP3WorkerTask(void *p) {
+    MP3Decoder_t *dec = (MP3Decoder_t *)p;
+
+    m_dec = dec;    /* m_dec is per task */
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!dec->workerPcm)
+            break;
+        dec->workerRet = IMDCT(dec->workerGr, 1);
+        if (dec->workerRet == 0)
+            SubbandChannel(dec->workerPcm, 1);
+        xTaskNotifyGive(dec->workerCaller);
+    }
+    xTaskNotifyGive(dec->workerCaller);
+    vTaskDelete(NULL);
+}
+
+/***********************************************************************************************************************
+ * Function:    MP3DualCoreGranule
+ *
+ * Description: IMDCT and synthesis of a stereo granule, channel 1 on the worker task, channel 0 on the caller
+ *
+ * Inputs:      index of current granule, PCM output of the granule
+ *
+ * Outputs:     interleaved PCM, updated vindex
+ *
+ * Return:      0 on success,  -1 on error
+ *
+ * Notes:       the channels touch disjoint state: huffDecBuf[ch], overBuf[ch], outBuf[ch], the 32 words of a
+ *                vbuf row that belong to ch and every second output sample. The task notifications are the only
+ *                synchronisation, one fork and one join per granule
+ **********************************************************************************************************************/
+int MP3DualCoreGranule(int gr, short *pcmBuf) {
+    int ret, vindex = 0;
+
+    m_dec->workerGr = gr;
+    m_dec->workerPcm = pcmBuf;
+    m_dec->workerCaller = xTaskGetCurrentTaskHandle();
+    xTaskNotifyGive(m_dec->worker);                 /* fork */
+
+    ret = IMDCT(gr, 0);
+    if (ret == 0)
+        vindex = SubbandChannel(pcmBuf, 0);
+
+#ifdef MP3_PROFILE
+    uint32_t t1 = ESP.getCycleCount();
+#endif
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);        /* join */
+#ifdef MP3_PROFILE
+    m_dec->profJoin += ESP.getCycleCount() - t1;
+#endif
+    if (ret < 0 || m_dec->workerRet < 0)
+        return -1;
+    m_dec->SubbandInfo->vindex = vindex;
+    return 0;
+}
+
+/***********************************************************************************************************************
+ * Function:    MP3DualCoreWorth, MP3DualCoreTimed
+ *
+ * Description: decide whether a stereo granule is split between the cores, and the timing this is based on
+ *
+ * Inputs:      MP3DualCoreTimed: true if the granule was split, cycles of its IMDCT and Subband on the calling core
+ *
+ * Outputs:     running averages dualCycles and serialCycles
+ *
+ * Return:      MP3DualCoreWorth: true if the next granule is to be split
+ *
+ * Notes:       a split costs a fork and a join, two task notifications and the wake up of the worker. It only pays
+ *                if a channel of IMDCT and synthesis takes clearly longer, which depends on the bitrate (number of
+ *                non zero subbands), MP3SetQuality() and the load of the other core. So both ways are timed: the
+ *                faster one is used, the other one is timed again every 32nd stereo granule
+ *              in the split granule the caller measures its own channel, the fork and the wait for the worker. A
+ *                sample is limited to twice the average, a preemption of the decoding task would stand for many
+ *                granules otherwise
+ **********************************************************************************************************************/
+bool MP3DualCoreWorth() {
+    if (!m_dec->serialCycles) return false;        /* time both ways first */
+    if (!m_dec->dualCycles) return true;
+    bool split = m_dec->dualCycles < m_dec->serialCycles;
+    if (++m_dec->dualProbe >= 32) {
+        m_dec->dualProbe = 0;
+        split = !split;
+    }
+    return split;
+}
+void MP3DualCoreTimed(bool split, uint32_t cycles) {
+    uint32_t *avg = split ? &m_dec->dualCycles : &m_dec->serialCycles;
+    if (*avg == 0) *avg = cycles;
+    else {
+        if (cycles > 2 * *avg) cycles = 2 * *avg;   /* the task was preempted, don't let that decide */
+        *avg += ((int32_t)(cycles - *avg)) >> 3;    /* 1/8 new */
+    }
+}
+
+/***********************************************************************************************************************
+ * Function:    MP3LimitBands
+ *
+ * Description: band limit the dequantized spectra of the current granule, see MP3SetQuality()
+ *
+ * Inputs:      number of subbands to keep
+ *
+ * Outputs:     huffDecBuf[ch] zeroed from nBands * 18 on, nonZeroBound[ch] clamped
+ *
+ * Return:      none
+ *
+ * Notes:       call after MP3Dequantize(), short blocks are already reordered into subband order
+ *              IMDCT() skips the transform of the zeroed blocks, only the overlap of the previous granule is added
+ **********************************************************************************************************************/
+void MP3LimitBands(int nBands) {
+    int ch, i;
+    int n = nBands * m_BLOCK_SIZE;
+    HuffmanInfo_t *hi = m_dec->HuffmanInfo;
+
+    for (ch = 0; ch < m_dec->MP3DecInfo->nChans; ch++) {
+        for (i = n; i < hi->nonZeroBound[ch]; i++)
+            hi->huffDecBuf[ch][i] = 0;
+        if (hi->nonZeroBound[ch] > n) hi->nonZeroBound[ch] = n;
+    }
+}
+
 /***********************************************************************************************************************
  * S U B B A N D
  **********************************************************************************************************************/
@@ -3436,36 +3937,74 @@ int IMDCT( int gr, int ch) {
  * Return:      0 on success,  -1 if null input pointers
  **********************************************************************************************************************/
 int Subband( short *pcmBuf) {
-    int b;
-    if (m_MP3DecInfo->nChans == 2) {
+    int b, i;
+    short *pcm = pcmBuf;
+    int vindex = m_dec->SubbandInfo->vindex;
+    int *vbuf = m_dec->SubbandInfo->vbuf;
+    IMDCTInfo_t *mi = m_dec->IMDCTInfo;
+    bool halfRate = (m_dec->quality >= MP3_QUALITY_HALFRATE);
+    int nOut = (halfRate ? m_NBANDS / 2 : m_NBANDS);   /* output samples per block and channel */
+
+    if (m_dec->MP3DecInfo->nChans == 2 && !m_dec->monoActive) {
         /* stereo */
         for (b = 0; b < m_BLOCK_SIZE; b++) {
-            FDCT32(m_IMDCTInfo->outBuf[0][b], m_SubbandInfo->vbuf + 0 * 32, m_SubbandInfo->vindex,
-                    (b & 0x01), m_IMDCTInfo->gb[0]);
-            FDCT32(m_IMDCTInfo->outBuf[1][b], m_SubbandInfo->vbuf + 1 * 32, m_SubbandInfo->vindex,
-                    (b & 0x01), m_IMDCTInfo->gb[1]);
-            PolyphaseStereo(pcmBuf,
-                    m_SubbandInfo->vbuf + m_SubbandInfo->vindex + m_VBUF_LENGTH * (b & 0x01),
-                    polyCoef);
-            m_SubbandInfo->vindex = (m_SubbandInfo->vindex - (b & 0x01)) & 7;
-            pcmBuf += (2 * m_NBANDS);
+            FDCT32(mi->outBuf[0][b], vbuf + 0 * 32, vindex, (b & 0x01), mi->gb[0]);
+            FDCT32(mi->outBuf[1][b], vbuf + 1 * 32, vindex, (b & 0x01), mi->gb[1]);
+            if (halfRate) PolyphaseStereoHalf(pcmBuf, vbuf + vindex + m_VBUF_LENGTH * (b & 0x01), polyCoef);
+            else          PolyphaseStereo(pcmBuf, vbuf + vindex + m_VBUF_LENGTH * (b & 0x01), polyCoef);
+            vindex = (vindex - (b & 0x01)) & 7;
+            pcmBuf += (2 * nOut);
         }
     } else {
         /* mono */
         for (b = 0; b < m_BLOCK_SIZE; b++) {
-            FDCT32(m_IMDCTInfo->outBuf[0][b], m_SubbandInfo->vbuf + 0 * 32, m_SubbandInfo->vindex,
-                    (b & 0x01), m_IMDCTInfo->gb[0]);
-            PolyphaseMono(pcmBuf,
-                    m_SubbandInfo->vbuf + m_SubbandInfo->vindex + m_VBUF_LENGTH * (b & 0x01),
-                    polyCoef);
-            m_SubbandInfo->vindex = (m_SubbandInfo->vindex - (b & 0x01)) & 7;
-            pcmBuf += m_NBANDS;
+            FDCT32(mi->outBuf[0][b], vbuf + 0 * 32, vindex, (b & 0x01), mi->gb[0]);
+            if (halfRate) PolyphaseMonoHalf(pcmBuf, vbuf + vindex + m_VBUF_LENGTH * (b & 0x01), polyCoef);
+            else          PolyphaseMono(pcmBuf, vbuf + vindex + m_VBUF_LENGTH * (b & 0x01), polyCoef);
+            vindex = (vindex - (b & 0x01)) & 7;
+            pcmBuf += nOut;
+        }
+        if (m_dec->MP3DecInfo->nChans == 2) {
+            /* downmixed stereo stream, keep the LRLR... layout */
+            for (i = m_BLOCK_SIZE * nOut - 1; i >= 0; i--)
+                pcm[2 * i] = pcm[2 * i + 1] = pcm[i];
         }
     }
+    m_dec->SubbandInfo->vindex = vindex;
 
     return 0;
 }
 
+/***********************************************************************************************************************
+ * Function:    SubbandChannel
+ *
+ * Description: subband transform of one channel of a stereo granule, see MP3DualCoreGranule()
+ *
+ * Inputs:      PCM output of the granule, channel
+ *
+ * Outputs:     the samples of ch at every second position of pcmBuf (LRLR...)
+ *
+ * Return:      vindex for the next granule, SubbandInfo->vindex is left for the caller to update
+ **********************************************************************************************************************/
+int SubbandChannel(short *pcmBuf, int ch) {
+    int b;
+    int vindex = m_dec->SubbandInfo->vindex;
+    int *vbuf = m_dec->SubbandInfo->vbuf + ch * 32;
+    IMDCTInfo_t *mi = m_dec->IMDCTInfo;
+    bool halfRate = (m_dec->quality >= MP3_QUALITY_HALFRATE);
+    int nOut = (halfRate ? m_NBANDS / 2 : m_NBANDS);
+
+    pcmBuf += ch;
+    for (b = 0; b < m_BLOCK_SIZE; b++) {
+        FDCT32(mi->outBuf[ch][b], vbuf, vindex, (b & 0x01), mi->gb[ch]);
+        if (halfRate) PolyphaseChannelHalf(pcmBuf, vbuf + vindex + m_VBUF_LENGTH * (b & 0x01), polyCoef);
+        else          PolyphaseChannel(pcmBuf, vbuf + vindex + m_VBUF_LENGTH * (b & 0x01), polyCoef);
+        vindex = (vindex - (b & 0x01)) & 7;
+        pcmBuf += (2 * nOut);
+    }
+    return vindex;
+}
+
 /***********************************************************************************************************************
  * D C T 3 2
  **********************************************************************************************************************/
@@ -3505,7 +4044,8 @@ int Subband( short *pcmBuf) {
 
 static const uint8_t FDCT32s1s2[16] = {5,3,3,2,2,1,1,1, 1,1,1,1,1,2,2,4};
 
-void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb) {
+#ifdef MP3_SUBBAND_REFERENCE
+void MP3_IRAM FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb) {
     int i, s, tmp, es;
     const int *cptr = (const int*)m_dcttab;
     int a0, a1, a2, a3, a4, a5, a6, a7;
@@ -3636,6 +4176,108 @@ void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb) {
 		}
 	}
 }
+#else /* MP3_SUBBAND_REFERENCE */
+/* same arithmetic as the reference, first and second pass fully unrolled with constant shifts */
+void MP3_IRAM FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb) {
+    int i, s, tmp, es;
+    const int *cptr = (const int*)m_dcttab;
+    int a0, a1, a2, a3, a4, a5, a6, a7;
+    int b0, b1, b2, b3, b4, b5, b6, b7;
+    int *d;
+
+    es = 0;
+    if (gb < 6) {
+        es = 6 - gb;
+        for (i = 0; i < 32; i++)
+            buf[i] >>= es;
+    }
+
+    /* first pass */
+    D32FP(0, 5, 1);
+    D32FP(1, 3, 1);
+    D32FP(2, 3, 1);
+    D32FP(3, 2, 1);
+    D32FP(4, 2, 1);
+    D32FP(5, 1, 2);
+    D32FP(6, 1, 2);
+    D32FP(7, 1, 4);
+
+    /* second pass, 4 blocks of 8 */
+#define D32SP(x) { \
+    a0 = x[0];          a7 = x[7];          a3 = x[3];          a4 = x[4]; \
+    b0 = a0 + a7;       b7 = MULSHIFT32(cptr[0], a0 - a7) << 1; \
+    b3 = a3 + a4;       b4 = MULSHIFT32(cptr[1], a3 - a4) << 3; \
+    a0 = b0 + b3;       a3 = MULSHIFT32(cptr[2], b0 - b3) << 1; \
+    a4 = b4 + b7;       a7 = MULSHIFT32(cptr[2], b7 - b4) << 1; \
+    a1 = x[1];          a6 = x[6];          a2 = x[2];          a5 = x[5]; \
+    b1 = a1 + a6;       b6 = MULSHIFT32(cptr[3], a1 - a6) << 1; \
+    b2 = a2 + a5;       b5 = MULSHIFT32(cptr[4], a2 - a5) << 1; \
+    a1 = b1 + b2;       a2 = MULSHIFT32(cptr[5], b1 - b2) << 2; \
+    a5 = b5 + b6;       a6 = MULSHIFT32(cptr[5], b6 - b5) << 2; \
+    cptr += 6; \
+    b0 = a0 + a1;       b1 = MULSHIFT32(m_COS4_0, a0 - a1) << 1; \
+    b2 = a2 + a3;       b3 = MULSHIFT32(m_COS4_0, a3 - a2) << 1; \
+    x[0] = b0;          x[1] = b1; \
+    x[2] = b2 + b3;     x[3] = b3; \
+    b4 = a4 + a5;       b5 = MULSHIFT32(m_COS4_0, a4 - a5) << 1; \
+    b6 = a6 + a7;       b7 = MULSHIFT32(m_COS4_0, a7 - a6) << 1; \
+    b6 += b7; \
+    x[4] = b4 + b6;     x[5] = b5 + b7; \
+    x[6] = b5 + b6;     x[7] = b7; \
+}
+    D32SP((buf +  0));
+    D32SP((buf +  8));
+    D32SP((buf + 16));
+    D32SP((buf + 24));
+#undef D32SP
+
+    /* output shuffle into vbuf, each value twice (d[0], d[8]) for the polyphase filter */
+#define D32ST(v) { s = (v); d[0] = d[8] = s; d += 64; }
+    /* sample 0 - always delayed one block */
+    d = dest + 64*16 + ((offset - oddBlock) & 7) + (oddBlock ? 0 : m_VBUF_LENGTH);
+    s = buf[ 0];                d[0] = d[8] = s;
+
+    /* samples 16 to 31 */
+    d = dest + offset + (oddBlock ? m_VBUF_LENGTH  : 0);
+    D32ST(buf[ 1]);
+    tmp = buf[25] + buf[29];
+    D32ST(buf[17] + tmp);       D32ST(buf[ 9] + buf[13]);   D32ST(buf[21] + tmp);
+    tmp = buf[29] + buf[27];
+    D32ST(buf[ 5]);             D32ST(buf[21] + tmp);       D32ST(buf[13] + buf[11]);   D32ST(buf[19] + tmp);
+    tmp = buf[27] + buf[31];
+    D32ST(buf[ 3]);             D32ST(buf[19] + tmp);       D32ST(buf[11] + buf[15]);   D32ST(buf[23] + tmp);
+    tmp = buf[31];
+    D32ST(buf[ 7]);             D32ST(buf[23] + tmp);       D32ST(buf[15]);             D32ST(tmp);
+
+    /* samples 16 to 1 (sample 16 used again) */
+    d = dest + 16 + ((offset - oddBlock) & 7) + (oddBlock ? 0 : m_VBUF_LENGTH);
+    D32ST(buf[ 1]);
+    tmp = buf[30] + buf[25];
+    D32ST(buf[17] + tmp);       D32ST(buf[14] + buf[ 9]);   D32ST(buf[22] + tmp);       D32ST(buf[ 6]);
+    tmp = buf[26] + buf[30];
+    D32ST(buf[22] + tmp);       D32ST(buf[10] + buf[14]);   D32ST(buf[18] + tmp);       D32ST(buf[ 2]);
+    tmp = buf[28] + buf[26];
+    D32ST(buf[18] + tmp);       D32ST(buf[12] + buf[10]);   D32ST(buf[20] + tmp);       D32ST(buf[ 4]);
+    tmp = buf[24] + buf[28];
+    D32ST(buf[20] + tmp);       D32ST(buf[ 8] + buf[12]);   D32ST(buf[16] + tmp);
+#undef D32ST
+
+    if (es) {
+        d = dest + 64*16 + ((offset - oddBlock) & 7) + (oddBlock ? 0 : m_VBUF_LENGTH);
+        s = d[0];   CLIP_2N(s, (31 - es));  d[0] = d[8] = (s << es);
+
+        d = dest + offset + (oddBlock ? m_VBUF_LENGTH  : 0);
+        for (i = 16; i <= 31; i++) {
+            s = d[0];   CLIP_2N(s, (31 - es));  d[0] = d[8] = (s << es);    d += 64;
+        }
+
+        d = dest + 16 + ((offset - oddBlock) & 7) + (oddBlock ? 0 : m_VBUF_LENGTH);
+        for (i = 15; i >= 0; i--) {
+            s = d[0];   CLIP_2N(s, (31 - es));  d[0] = d[8] = (s << es);    d += 64;
+        }
+    }
+}
+#endif /* MP3_SUBBAND_REFERENCE */
 
 /***********************************************************************************************************************
  * P O L Y P H A S E
@@ -3660,6 +4302,7 @@ short ClipToShort(int x, int fracBits){
     return x;
 #endif
 }
+#ifdef MP3_SUBBAND_REFERENCE
 /***********************************************************************************************************************
  * Function:    PolyphaseMono
  *
@@ -3676,7 +4319,7 @@ short ClipToShort(int x, int fracBits){
  *
  * Return:      none
  **********************************************************************************************************************/
-void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
+void MP3_IRAM PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
     int i;
     const uint32_t *coef;
     int *vb1;
@@ -3741,7 +4384,7 @@ void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
  *
  * Notes:       interleaves PCM samples LRLRLR...
  **********************************************************************************************************************/
-void PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
+void MP3_IRAM PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
     int i;
     const uint32_t *coef;
     int *vb1;
@@ -3802,3 +4445,251 @@ void PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
         pcm += 2;
     }
 }
+/***********************************************************************************************************************
+ * Function:    PolyphaseMonoHalf, PolyphaseStereoHalf
+ *
+ * Description: as PolyphaseMono() and PolyphaseStereo(), but only the even output samples 0, 2, ... 30,
+ *                see MP3SetQuality()
+ *
+ * Outputs:     16 PCM samples per channel, interleaved LRLR... for stereo
+ **********************************************************************************************************************/
+void PolyphaseMonoHalf(short *pcm, int *vbuf, const uint32_t *coefBase){
+    short full[m_NBANDS];
+    PolyphaseMono(full, vbuf, coefBase);
+    for (int i = 0; i < m_NBANDS / 2; i++) pcm[i] = full[2 * i];
+}
+
+void PolyphaseStereoHalf(short *pcm, int *vbuf, const uint32_t *coefBase){
+    short full[2 * m_NBANDS];
+    PolyphaseStereo(full, vbuf, coefBase);
+    for (int i = 0; i < m_NBANDS / 2; i++) {
+        pcm[2 * i + 0] = full[4 * i + 0];
+        pcm[2 * i + 1] = full[4 * i + 1];
+    }
+}
+/***********************************************************************************************************************
+ * Function:    PolyphaseChannel, PolyphaseChannelHalf
+ *
+ * Description: as PolyphaseMono() and PolyphaseMonoHalf() for one channel of a stereo granule, see SubbandChannel()
+ *
+ * Outputs:     32 (16) PCM samples at every second position of pcm, interleaved into LRLR...
+ **********************************************************************************************************************/
+void PolyphaseChannel(short *pcm, int *vbuf, const uint32_t *coefBase){
+    short mono[m_NBANDS];
+    PolyphaseMono(mono, vbuf, coefBase);
+    for (int i = 0; i < m_NBANDS; i++) pcm[2 * i] = mono[i];
+}
+
+void PolyphaseChannelHalf(short *pcm, int *vbuf, const uint32_t *coefBase){
+    short mono[m_NBANDS / 2];
+    PolyphaseMonoHalf(mono, vbuf, coefBase);
+    for (int i = 0; i < m_NBANDS / 2; i++) pcm[2 * i] = mono[i];
+}
+#else /* MP3_SUBBAND_REFERENCE */
+/* The kernels below compute the same sums as the reference: signed 32x32 -> 64 bit products (mull/mulsh on
+ * Xtensa) accumulated in int64_t, the 8 taps of every output pair fully unrolled, the negated coefficient
+ * folded into a subtraction and the coefficients of a tap loaded once for both output samples and channels.
+ * vbuf keeps the Helix layout: per tap and channel two runs of 8 consecutive words (vb1[0..7], vb1[16..23]).
+ */
+#define PP_RND      ((int64_t)1 << ((m_DQ_FRACBITS_OUT - 2 - 2 - 15) - 1 + (32 - m_CSHIFT)))
+#define PP_OUT(s)   ClipToShort((int)((s) >> (32 - m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15)
+
+/* output sample 0 (and 1..15 in sum1): c1 * v[j] - c2 * v[23 - j] */
+#define PP_TAP0(v, j, sum1) { \
+    sum1 += (int64_t)(v)[(j)] * c1;     sum1 -= (int64_t)(v)[23 - (j)] * c2; \
+}
+/* output sample i and 32 - i */
+#define PP_TAP2(v, j, sum1, sum2) { \
+    vLo = (v)[(j)];                     vHi = (v)[23 - (j)]; \
+    sum1 += (int64_t)vLo * c1;          sum2 += (int64_t)vLo * c2; \
+    sum1 -= (int64_t)vHi * c2;          sum2 += (int64_t)vHi * c1; \
+}
+
+/* one channel, st = 1 for mono output, st = 2 for one channel of interleaved stereo output */
+static inline __attribute__((always_inline)) void PolyphaseMonoStride(short *pcm, int *vbuf, const uint32_t *coefBase,
+                                                                      const int st){
+    int i, vLo, vHi, c1, c2;
+    const int *coef;
+    int *vb1;
+    int64_t sum1L, sum2L;
+
+    /* special case, output sample 0 */
+    coef = (const int*)coefBase;
+    sum1L = PP_RND;
+#define PP_M0(j) { c1 = coef[2*(j)]; c2 = coef[2*(j)+1]; PP_TAP0(vbuf, j, sum1L); }
+    PP_M0(0); PP_M0(1); PP_M0(2); PP_M0(3); PP_M0(4); PP_M0(5); PP_M0(6); PP_M0(7);
+#undef PP_M0
+    pcm[0] = PP_OUT(sum1L);
+
+    /* special case, output sample 16 */
+    coef = (const int*)coefBase + 256;
+    vb1 = vbuf + 64*16;
+    sum1L = PP_RND;
+#define PP_M16(j) { sum1L += (int64_t)vb1[(j)] * coef[(j)]; }
+    PP_M16(0); PP_M16(1); PP_M16(2); PP_M16(3); PP_M16(4); PP_M16(5); PP_M16(6); PP_M16(7);
+#undef PP_M16
+    pcm[16 * st] = PP_OUT(sum1L);
+
+    /* main convolution loop: sum1L = samples 1, 2, 3, ... 15   sum2L = samples 31, 30, ... 17 */
+    coef = (const int*)coefBase + 16;
+    vb1 = vbuf + 64;
+    pcm += st;
+    for (i = 15; i > 0; i--) {
+        sum1L = sum2L = PP_RND;
+#define PP_M(j) { c1 = coef[2*(j)]; c2 = coef[2*(j)+1]; PP_TAP2(vb1, j, sum1L, sum2L); }
+        PP_M(0); PP_M(1); PP_M(2); PP_M(3); PP_M(4); PP_M(5); PP_M(6); PP_M(7);
+#undef PP_M
+        coef += 16;
+        vb1 += 64;
+        pcm[0]          = PP_OUT(sum1L);
+        pcm[2 * i * st] = PP_OUT(sum2L);
+        pcm += st;
+    }
+}
+
+void MP3_IRAM PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
+    PolyphaseMonoStride(pcm, vbuf, coefBase, 1);
+}
+
+void MP3_IRAM PolyphaseChannel(short *pcm, int *vbuf, const uint32_t *coefBase){
+    PolyphaseMonoStride(pcm, vbuf, coefBase, 2);
+}
+
+void MP3_IRAM PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
+    int i, vLo, vHi, c1, c2;
+    const int *coef;
+    int *vb1;
+    int64_t sum1L, sum2L, sum1R, sum2R;
+
+    /* special case, output sample 0 */
+    coef = (const int*)coefBase;
+    sum1L = sum1R = PP_RND;
+#define PP_S0(j) { c1 = coef[2*(j)]; c2 = coef[2*(j)+1]; PP_TAP0(vbuf, j, sum1L); PP_TAP0(vbuf + 32, j, sum1R); }
+    PP_S0(0); PP_S0(1); PP_S0(2); PP_S0(3); PP_S0(4); PP_S0(5); PP_S0(6); PP_S0(7);
+#undef PP_S0
+    pcm[0] = PP_OUT(sum1L);
+    pcm[1] = PP_OUT(sum1R);
+
+    /* special case, output sample 16 */
+    coef = (const int*)coefBase + 256;
+    vb1 = vbuf + 64*16;
+    sum1L = sum1R = PP_RND;
+#define PP_S16(j) { c1 = coef[(j)]; sum1L += (int64_t)vb1[(j)] * c1; sum1R += (int64_t)vb1[32 + (j)] * c1; }
+    PP_S16(0); PP_S16(1); PP_S16(2); PP_S16(3); PP_S16(4); PP_S16(5); PP_S16(6); PP_S16(7);
+#undef PP_S16
+    pcm[2*16 + 0] = PP_OUT(sum1L);
+    pcm[2*16 + 1] = PP_OUT(sum1R);
+
+    /* main convolution loop: sum1L = samples 1, 2, 3, ... 15   sum2L = samples 31, 30, ... 17 */
+    coef = (const int*)coefBase + 16;
+    vb1 = vbuf + 64;
+    pcm += 2;
+    for (i = 15; i > 0; i--) {
+        sum1L = sum2L = sum1R = sum2R = PP_RND;
+#define PP_S(j) { c1 = coef[2*(j)]; c2 = coef[2*(j)+1]; PP_TAP2(vb1, j, sum1L, sum2L); PP_TAP2(vb1 + 32, j, sum1R, sum2R); }
+        PP_S(0); PP_S(1); PP_S(2); PP_S(3); PP_S(4); PP_S(5); PP_S(6); PP_S(7);
+#undef PP_S
+        coef += 16;
+        vb1 += 64;
+        pcm[0]             = PP_OUT(sum1L);
+        pcm[1]             = PP_OUT(sum1R);
+        pcm[2*2*i + 0]     = PP_OUT(sum2L);
+        pcm[2*2*i + 1]     = PP_OUT(sum2R);
+        pcm += 2;
+    }
+}
+
+/* half rate: only the even output samples, the pairs i, 32 - i of the main loop for even i, every second tap row */
+static inline __attribute__((always_inline)) void PolyphaseMonoHalfStride(short *pcm, int *vbuf,
+                                                                          const uint32_t *coefBase, const int st){
+    int i, vLo, vHi, c1, c2;
+    const int *coef;
+    int *vb1;
+    int64_t sum1L, sum2L;
+
+    /* output sample 0 */
+    coef = (const int*)coefBase;
+    sum1L = PP_RND;
+#define PP_M0(j) { c1 = coef[2*(j)]; c2 = coef[2*(j)+1]; PP_TAP0(vbuf, j, sum1L); }
+    PP_M0(0); PP_M0(1); PP_M0(2); PP_M0(3); PP_M0(4); PP_M0(5); PP_M0(6); PP_M0(7);
+#undef PP_M0
+    pcm[0] = PP_OUT(sum1L);
+
+    /* output sample 16 */
+    coef = (const int*)coefBase + 256;
+    vb1 = vbuf + 64*16;
+    sum1L = PP_RND;
+#define PP_M16(j) { sum1L += (int64_t)vb1[(j)] * coef[(j)]; }
+    PP_M16(0); PP_M16(1); PP_M16(2); PP_M16(3); PP_M16(4); PP_M16(5); PP_M16(6); PP_M16(7);
+#undef PP_M16
+    pcm[8 * st] = PP_OUT(sum1L);
+
+    /* sum1L = samples 2, 4, ... 14   sum2L = samples 30, 28, ... 18 */
+    coef = (const int*)coefBase + 32;
+    vb1 = vbuf + 128;
+    for (i = 1; i < 8; i++) {
+        sum1L = sum2L = PP_RND;
+#define PP_M(j) { c1 = coef[2*(j)]; c2 = coef[2*(j)+1]; PP_TAP2(vb1, j, sum1L, sum2L); }
+        PP_M(0); PP_M(1); PP_M(2); PP_M(3); PP_M(4); PP_M(5); PP_M(6); PP_M(7);
+#undef PP_M
+        coef += 32;
+        vb1 += 128;
+        pcm[i * st]        = PP_OUT(sum1L);
+        pcm[(16 - i) * st] = PP_OUT(sum2L);
+    }
+}
+
+void MP3_IRAM PolyphaseMonoHalf(short *pcm, int *vbuf, const uint32_t *coefBase){
+    PolyphaseMonoHalfStride(pcm, vbuf, coefBase, 1);
+}
+
+void MP3_IRAM PolyphaseChannelHalf(short *pcm, int *vbuf, const uint32_t *coefBase){
+    PolyphaseMonoHalfStride(pcm, vbuf, coefBase, 2);
+}
+
+void MP3_IRAM PolyphaseStereoHalf(short *pcm, int *vbuf, const uint32_t *coefBase){
+    int i, vLo, vHi, c1, c2;
+    const int *coef;
+    int *vb1;
+    int64_t sum1L, sum2L, sum1R, sum2R;
+
+    /* output sample 0 */
+    coef = (const int*)coefBase;
+    sum1L = sum1R = PP_RND;
+#define PP_S0(j) { c1 = coef[2*(j)]; c2 = coef[2*(j)+1]; PP_TAP0(vbuf, j, sum1L); PP_TAP0(vbuf + 32, j, sum1R); }
+    PP_S0(0); PP_S0(1); PP_S0(2); PP_S0(3); PP_S0(4); PP_S0(5); PP_S0(6); PP_S0(7);
+#undef PP_S0
+    pcm[0] = PP_OUT(sum1L);
+    pcm[1] = PP_OUT(sum1R);
+
+    /* output sample 16 */
+    coef = (const int*)coefBase + 256;
+    vb1 = vbuf + 64*16;
+    sum1L = sum1R = PP_RND;
+#define PP_S16(j) { c1 = coef[(j)]; sum1L += (int64_t)vb1[(j)] * c1; sum1R += (int64_t)vb1[32 + (j)] * c1; }
+    PP_S16(0); PP_S16(1); PP_S16(2); PP_S16(3); PP_S16(4); PP_S16(5); PP_S16(6); PP_S16(7);
+#undef PP_S16
+    pcm[2*8 + 0] = PP_OUT(sum1L);
+    pcm[2*8 + 1] = PP_OUT(sum1R);
+
+    /* sum1L = samples 2, 4, ... 14   sum2L = samples 30, 28, ... 18 */
+    coef = (const int*)coefBase + 32;
+    vb1 = vbuf + 128;
+    for (i = 1; i < 8; i++) {
+        sum1L = sum2L = sum1R = sum2R = PP_RND;
+#define PP_S(j) { c1 = coef[2*(j)]; c2 = coef[2*(j)+1]; PP_TAP2(vb1, j, sum1L, sum2L); PP_TAP2(vb1 + 32, j, sum1R, sum2R); }
+        PP_S(0); PP_S(1); PP_S(2); PP_S(3); PP_S(4); PP_S(5); PP_S(6); PP_S(7);
+#undef PP_S
+        coef += 32;
+        vb1 += 128;
+        pcm[2*i + 0]        = PP_OUT(sum1L);
+        pcm[2*i + 1]        = PP_OUT(sum1R);
+        pcm[2*(16 - i) + 0] = PP_OUT(sum2L);
+        pcm[2*(16 - i) + 1] = PP_OUT(sum2R);
+    }
+}
+#undef PP_TAP2
+#undef PP_TAP0
+#undef PP_OUT
+#undef PP_RND
+#endif /* MP3_SUBBAND_REFERENCE */
@@ -4,9 +4,41 @@
 #include "Arduino.h"
 #include "assert.h"
 
+//#define MP3_SUBBAND_REFERENCE     // use the portable Helix C code for FDCT32 and the polyphase filter, for comparison
+//#define MP3_PROFILE               // log the CPU cycles per frame and per granule stage (Huffman, Dequant, IMDCT,
+                                    // Subband) together with MP3_PLACEMENT every 256 frames
+
+/* placement of the hot code and data, trades internal RAM for speed
+ *   0: all buffers follow the chip default (PSRAM first on ESP32-S3), code and tables stay in flash
+ *   1: the buffers touched every granule (SubbandInfo 8708, IMDCTInfo 6944, HuffmanInfo 4624, DequantInfo 792 bytes)
+ *      are taken from internal RAM if possible, PSRAM is only the fallback
+ *   2: as 1, additionally the polyphase filter, FDCT32, IMDCT36/idct9, the Huffman pair/quad decoders and the
+ *      dequantizer run from IRAM (about 10KB) and their constant tables are held in DRAM (about 2.4KB)
+ * the hot set was taken from MP3_PROFILE builds, share of a frame at 128...320kbit/s:
+ * Subband 50...38%, Huffman 19...24%, IMDCT 18...20%, Dequant 11...18%
+ */
+#ifndef MP3_PLACEMENT
+    #define MP3_PLACEMENT 1
+#endif
+#if MP3_PLACEMENT >= 2
+    #define MP3_IRAM IRAM_ATTR
+    #define MP3_DRAM DRAM_ATTR
+#else
+    #define MP3_IRAM
+    #define MP3_DRAM
+#endif
+
+/* decode quality, see MP3SetQuality() */
+enum : uint8_t {MP3_QUALITY_FULL = 0,       // all 32 subbands at the stream rate
+                MP3_QUALITY_LOWPASS = 1,    // subbands >= m_LOWPASS_BANDS are dropped before the hybrid transform
+                MP3_QUALITY_HALFRATE = 2};  // upper 16 subbands dropped, synthesis at half the stream rate
+
 static const uint8_t  m_HUFF_PAIRTABS          =32;
+static const uint8_t  m_HUFF_FAST_BITS         =8;     // bits per probe of the fast Huffman tables
+static const uint8_t  m_HUFF_FAST_PAIRTABS     =15;    // distinct pair tables, 16..23 and 24..31 share the codes
 static const uint8_t  m_BLOCK_SIZE             =18;
 static const uint8_t  m_NBANDS                 =32;
+static const uint8_t  m_LOWPASS_BANDS          =20;    // MP3_QUALITY_LOWPASS, 13.8kHz at 44.1kHz
 static const uint8_t  m_MAX_REORDER_SAMPS      =(192-126)*3;      // largest critical band for short blocks (see sfBandTable)
 static const uint16_t m_VBUF_LENGTH            =17*2* m_NBANDS;    // for double-sized vbuf FIFO
 static const uint8_t  m_MAX_SCFBD              =4;     // max scalefactor bands per channel
@@ -148,6 +180,7 @@ typedef struct IMDCTInfo {
 
 typedef struct BlockCount {
     int nBlocksLong;
+    int nBfly;              /* anti-alias butterflies, between the long blocks 0..nBfly */
     int nBlocksTotal;
     int nBlocksPrev;
     int prevType;
@@ -197,6 +230,55 @@ typedef struct MP3DecInfo {
     int part23Length[m_MAX_NGRAN][m_MAX_NCHAN];
 } MP3DecInfo_t;
 
+/* all state of one decoder instance, created by MP3Decoder_Create()
+ * cost per context on ESP32: 24020 bytes, SubbandInfo 8708 (vbuf), IMDCTInfo 6944 (overlap), HuffmanInfo 4624,
+ * MP3DecInfo 2000 (bit reservoir), DequantInfo 792, the context itself 804 and 148 for the small structs
+ * plus once for all contexts 8704 bytes fast Huffman tables (17 tables of 2^m_HUFF_FAST_BITS entries)
+ * plus 4096 bytes stack of the worker task while MP3SetDualCore() is on
+ */
+typedef struct MP3Decoder {
+    MP3DecInfo_t         *MP3DecInfo;
+    FrameHeader_t        *FrameHeader;
+    SideInfo_t           *SideInfo;
+    ScaleFactorJS_t      *ScaleFactorJS;
+    HuffmanInfo_t        *HuffmanInfo;
+    DequantInfo_t        *DequantInfo;
+    IMDCTInfo_t          *IMDCTInfo;
+    SubbandInfo_t        *SubbandInfo;
+    MP3FrameInfo_t       *MP3FrameInfo;
+    SFBandTable_t         SFBandTable;
+    StereoMode_t          sMode;        /* mono/stereo mode */
+    MPEGVersion_t         MPEGVersion;  /* version ID */
+    SideInfoSub_t         SideInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
+    CriticalBandInfo_t    CriticalBandInfo[m_MAX_NCHAN];  /* filled in dequantizer, used in joint stereo reconstruction */
+    ScaleFactorInfoSub_t  ScaleFactorInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
+    bool                  huffFastRef;  /* holds a reference to the shared fast Huffman tables */
+    bool                  downmix;      /* mono output requested, see MP3SetDownmix() */
+    bool                  monoActive;   /* stereo stream is synthesized once, channel 0 of vbuf/overBuf holds the mix */
+    bool                  monoSplit;    /* overlaps still per channel, merged as soon as both use the same window */
+    uint8_t               quality;      /* MP3_QUALITY_xxx, see MP3SetQuality() */
+    uint8_t               dualProbe;    /* stereo granules since the slower of the two ways was timed */
+    TaskHandle_t          worker;       /* second core, see MP3SetDualCore() */
+    TaskHandle_t          workerCaller; /* task waiting in the join */
+    short                *workerPcm;    /* job of the worker: granule output (channel 1 at the odd positions) */
+    int                   workerGr;
+    int                   workerRet;
+    uint32_t              dualCycles;   /* IMDCT + Subband of a stereo granule split between the cores, and on one */
+    uint32_t              serialCycles; /*   core, running averages, 0: not timed yet. See MP3DualCoreWorth() */
+#ifdef MP3_PROFILE
+    uint32_t              profFrames;
+    uint32_t              profGrans;
+    uint64_t              profCycles;   /* sum over profFrames frames */
+    uint64_t              profHuffman;  /* sum over profGrans granules */
+    uint64_t              profDequant;
+    uint64_t              profImdct;
+    uint64_t              profSubband;
+    uint32_t              profSplit;    /* granules split between the cores */
+    uint64_t              profDual;     /* IMDCT + Subband of the split granules */
+    uint64_t              profJoin;     /* caller waiting for the worker */
+#endif
+} MP3Decoder_t;
+
 
 
 
@@ -344,6 +426,11 @@ const HuffTabLookup_t huffTabLookup[m_HUFF_PAIRTABS] PROGMEM = {
 const int quadTabOffset[2] PROGMEM = {0, 64};
 const int quadTabMaxBits[2] PROGMEM = {6, 4};
 
+/* fast table of each pair table, -1 for tables without codewords */
+const int8_t huffFastSlot[m_HUFF_PAIRTABS] PROGMEM = {
+    -1,  0,  1,  2, -1,  3,  4,  5,  6,  7,  8,  9, 10, 11, -1, 12,
+    13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14,};
+
 /* indexing = [version][samplerate index]
  * sample rate of frame (Hz)
  */
@@ -419,7 +506,7 @@ const unsigned char uniqueIDTab[8] = {0x5f, 0x4b, 0x43, 0x5f, 0x5f, 0x4a, 0x52,
  *   csa[0][i] = CSi, csa[1][i] = CAi
  * format = Q31
  */
-const uint32_t csa[8][2] PROGMEM = {
+const uint32_t csa[8][2] MP3_DRAM = {
     {0x6dc253f0, 0xbe2500aa},
     {0x70dcebe4, 0xc39e4949},
     {0x798d6e73, 0xd7e33f4a},
@@ -454,11 +541,12 @@ const uint32_t csa[8][2] PROGMEM = {
  *   see PolyphaseStereo() and PolyphaseMono()
  */
 
-// prototypes
+// prototypes, the functions without decoder context work on a default instance
 bool MP3Decoder_AllocateBuffers(void);
 void MP3Decoder_FreeBuffers();
+size_t MP3Decoder_BufferSize(void);  // bytes MP3Decoder_AllocateBuffers() takes from the arena
+void MP3Decoder_ClearBuffer(void);
 int  MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize);
-void MP3GetLastFrameInfo();
 int  MP3GetNextFrameInfo(unsigned char *buf);
 int  MP3FindSyncWord(unsigned char *buf, int nBytes);
 int  MP3GetSampRate();
@@ -466,11 +554,33 @@ int  MP3GetChannels();
 int  MP3GetBitsPerSample();
 int  MP3GetBitrate();
 int  MP3GetOutputSamps();
+void MP3SetDownmix(bool mono);
+void MP3SetQuality(uint8_t level);
+bool MP3SetDualCore(bool on);
+
+// reentrant API, every context decodes its own stream
+MP3Decoder_t* MP3Decoder_Create(void);
+void MP3Decoder_Destroy(MP3Decoder_t *dec);
+void MP3Decoder_ClearBuffer(MP3Decoder_t *dec);
+int  MP3Decode(MP3Decoder_t *dec, unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize);
+int  MP3GetNextFrameInfo(MP3Decoder_t *dec, unsigned char *buf);
+int  MP3GetSampRate(MP3Decoder_t *dec);
+int  MP3GetChannels(MP3Decoder_t *dec);
+int  MP3GetBitsPerSample(MP3Decoder_t *dec);
+int  MP3GetBitrate(MP3Decoder_t *dec);
+int  MP3GetOutputSamps(MP3Decoder_t *dec);
+void MP3SetDownmix(MP3Decoder_t *dec, bool mono);
+void MP3SetQuality(MP3Decoder_t *dec, uint8_t level);
+bool MP3SetDualCore(MP3Decoder_t *dec, bool on);
 
 //internally used
-void MP3Decoder_ClearBuffer(void);
+void MP3GetLastFrameInfo();
 void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase);
 void PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase);
+void PolyphaseMonoHalf(short *pcm, int *vbuf, const uint32_t *coefBase);
+void PolyphaseStereoHalf(short *pcm, int *vbuf, const uint32_t *coefBase);
+void PolyphaseChannel(short *pcm, int *vbuf, const uint32_t *coefBase);
+void PolyphaseChannelHalf(short *pcm, int *vbuf, const uint32_t *coefBase);
 void SetBitstreamPointer(BitStreamInfo_t *bsi, int nBytes, unsigned char *buf);
 unsigned int GetBits(BitStreamInfo_t *bsi, int nBits);
 int CalcBitsUsed(BitStreamInfo_t *bsi, unsigned char *startBuf, int startOffset);
@@ -488,26 +598,42 @@ int MP3Dequantize( int gr);
 int IMDCT( int gr, int ch);
 int UnpackScaleFactors( unsigned char *buf, int *bitOffset, int bitsAvail, int gr, int ch);
 int Subband(short *pcmBuf);
+int SubbandChannel(short *pcmBuf, int ch);
 short ClipToShort(int x, int fracBits);
 void RefillBitstreamCache(BitStreamInfo_t *bsi);
 void UnpackSFMPEG1(BitStreamInfo_t *bsi, SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis, int *scfsi, int gr, ScaleFactorInfoSub_t *sfisGr0);
 void UnpackSFMPEG2(BitStreamInfo_t *bsi, SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis, int gr, int ch, int modeExt, ScaleFactorJS_t *sfjs);
 int MP3FindFreeSync(unsigned char *buf, unsigned char firstFH[4], int nBytes);
 void MP3ClearBadFrame( short *outbuf);
+bool MP3InitHuffFastTables();
+void MP3FreeHuffFastTables();
 int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset);
 int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset);
 int DequantBlock(int *inbuf, int *outbuf, int num, int scale);
-void AntiAlias(int *x, int nBfly);
 void WinPrevious(int *xPrev, int *xPrevWin, int btPrev);
 int FreqInvertRescale(int *y, int *xPrev, int blockIdx, int es);
 void idct9(int *x);
-int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb);
+int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb, int aa);
 void imdct12(int *x, int *out);
 int IMDCT12x3(int *xCurr, int *xPrev, int *y, int btPrev, int blockIdx, int gb);
 int HybridTransform(int *xCurr, int *xPrev, int y[m_BLOCK_SIZE][m_NBANDS], SideInfoSub_t *sis, BlockCount_t *bc);
+bool MP3DownmixActive();
+int MP3DownmixIMDCT(int gr);
+void MP3LimitBands(int nBands);
+void MP3WorkerTask(void *p);
+int MP3DualCoreGranule(int gr, short *pcmBuf);
+bool MP3DualCoreWorth();
+void MP3DualCoreTimed(bool split, uint32_t cycles);
 inline uint64_t SAR64(uint64_t x, int n) {return x >> n;}
 inline int MULSHIFT32(int x, int y) { int z; z = (uint64_t) x * (uint64_t) y >> 32; return z;}
 inline uint64_t MADD64(uint64_t sum64, int x, int y) {sum64 += (uint64_t) x * (uint64_t) y; return sum64;}/* returns 64-bit value in [edx:eax] */
 inline uint64_t xSAR64(uint64_t x, int n){return x >> n;}
 inline int FASTABS(int x){ return __builtin_abs(x);} //xtensa has a fast abs instruction //fb
-#define CLZ(x) __builtin_clz(x) //fb
+inline int AVG2(int x, int y){ return (x >> 1) + (y >> 1) + (x & y & 1);} /* floor((x + y) / 2) without overflow */
+inline int CLZ(int x){
+#ifdef __XTENSA__
+    return __builtin_clz(x); //fb, NSAU gives 32 for x == 0
+#else
+    return x ? __builtin_clz(x) : 32; /* __builtin_clz(0) is undefined */
+#endif
+}
@@ -0,0 +1,246 @@
+/*
+ * ogg_demuxer.cpp
+ *
+ * Ogg page parser, the payload stays in the input buffer as long as possible
+ *
+ * page header (RFC 3533):
+ *   0  "OggS"          capture pattern
+ *   4  version         0
+ *   5  header_type     OGG_CONTINUED, OGG_BOS, OGG_EOS
+ *   6  granule pos     64 bit little endian
+ *  14  serial number   32 bit
+ *  18  page sequence   32 bit
+ *  22  CRC             32 bit
+ *  26  segments        number of lacing values that follow, a value < 255 ends a packet
+ *
+ */
+#include "ogg_demuxer.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+OggDemuxer_t* OggDemuxer_Create(void){
+    OggDemuxer_t* ogg = (OggDemuxer_t*) malloc(sizeof(OggDemuxer_t));
+    if(!ogg){
+        log_e("not enough memory to allocate the ogg demuxer");
+        return NULL;
+    }
+    memset(ogg, 0, sizeof(OggDemuxer_t));
+    return ogg;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OggDemuxer_Destroy(OggDemuxer_t* ogg){
+    if(!ogg) return;
+    if(ogg->reasmBuff) free(ogg->reasmBuff);
+    free(ogg);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OggDemuxer_Reset(OggDemuxer_t* ogg){
+    // after a seek or a sync loss, the next page header is searched with OggFindSyncWord(). The reassembly buffer
+    // is kept for the next stream, the statistics too.
+    ogg->f_sync       = false;
+    ogg->f_inPage     = false;
+    ogg->f_skip       = false;
+    ogg->f_inPlace    = false;
+    ogg->f_reasmReady = false;
+    ogg->spanLeft     = 0;
+    ogg->reasmLen     = 0;
+    ogg->pktUsed      = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool isPageHeader(const uint8_t* p){
+    return p[0] == 'O' && p[1] == 'g' && p[2] == 'g' && p[3] == 'S' && p[4] == 0 && p[5] <= 7;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int OggFindSyncWord(const uint8_t* buf, int nBytes){
+    // Return: offset of the next page header, -1 if there is none (up to the last 5 bytes, which can be the start
+    // of one)
+    for(int i = 0; i + 6 <= nBytes; i++){
+        const uint8_t* p = (const uint8_t*)memchr(buf + i, 'O', nBytes - 5 - i);
+        if(!p) break;
+        i = p - buf;
+        if(isPageHeader(p)) return i;
+    }
+    return -1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void packetDone(OggDemuxer_t* ogg){
+    ogg->pktUsed = 0;
+    ogg->packetNo++;
+    ogg->packets++;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool reserveReasm(OggDemuxer_t* ogg, uint32_t size){
+    // the collected part of the packet is kept
+    if(size <= ogg->reasmSize) return true;
+    size = (size + 4095) & ~4095;
+    uint8_t* b = (uint8_t*)(psramFound() ? ps_malloc(size) : malloc(size));
+    if(!b){
+        log_e("not enough memory to reassemble an ogg packet of %u bytes", size);
+        return false;
+    }
+    if(ogg->reasmBuff){
+        memcpy(b, ogg->reasmBuff, ogg->reasmLen);
+        free(ogg->reasmBuff);
+    }
+    ogg->reasmBuff = b;
+    ogg->reasmSize = size;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int OggReadPacket(OggDemuxer_t* ogg, uint8_t* data, int len, uint8_t** pkt, int* pktLen){
+    // data: the unread bytes of the stream, len may end anywhere
+    // Return: > 0 number of bytes consumed by the demuxer (page header, packet part copied), nothing delivered
+    //           0 and *pktLen > 0: the packet (or its not yet decoded rest) is at *pkt, the codec reports what it
+    //             has used with OggPacketUsed(). *pkt == data if it is delivered in place.
+    //           0 and *pktLen == 0: more data is needed
+    //         < 0 ERR_OGG_xxx, ERR_OGG_SYNC_LOST: search the next page with OggFindSyncWord()
+    *pkt = NULL;
+    *pktLen = 0;
+
+    if(ogg->f_reasmReady){
+        *pkt = ogg->reasmBuff + ogg->pktUsed;
+        *pktLen = ogg->reasmLen - ogg->pktUsed;
+        return OGG_PACKET_READY;
+    }
+    if(ogg->f_inPlace){
+        *pkt = data;
+        *pktLen = ogg->spanLeft;
+        return OGG_PACKET_READY;
+    }
+
+    while(ogg->spanLeft == 0){  // next span
+        if(!ogg->f_inPage){     // next page
+            if(len < 27) return 0;
+            if(!isPageHeader(data)){
+                log_i("ogg page header expected");
+                OggDemuxer_Reset(ogg);
+                return ERR_OGG_SYNC_LOST;
+            }
+            uint8_t nSeg = data[26];
+            if(len < 27 + nSeg) return 0;
+            ogg->headerType = data[5];
+            ogg->granule = 0;
+            for(int i = 7; i >= 0; i--) ogg->granule = (ogg->granule << 8) | data[6 + i];
+            ogg->serial = data[14] | (data[15] << 8) | (data[16] << 16) | ((uint32_t)data[17] << 24);
+            memcpy(ogg->lacing, data + 27, nSeg);
+            ogg->segCount = nSeg;
+            ogg->segIdx = 0;
+            ogg->f_inPage = true;
+            ogg->pages++;
+            if(ogg->headerType & OGG_BOS){  // first page of a logical stream, also the next song of a chained stream
+                ogg->f_bos = true;
+                ogg->packetNo = 0;
+                ogg->reasmLen = 0;
+                ogg->f_skip = false;
+            }
+            else if(!(ogg->headerType & OGG_CONTINUED)){  // the packet in work had no end
+                ogg->reasmLen = 0;
+                ogg->f_skip = false;
+            }
+            else if(!ogg->f_sync || (!ogg->reasmLen && !ogg->f_skip)){  // the begin of this packet is lost
+                ogg->f_skip = true;
+            }
+            ogg->f_sync = true;
+            return 27 + nSeg;
+        }
+        if(ogg->segIdx == ogg->segCount){
+            ogg->f_inPage = false;
+            continue;
+        }
+        uint32_t size = 0;
+        bool     ends = false;
+        while(ogg->segIdx < ogg->segCount){
+            uint8_t v = ogg->lacing[ogg->segIdx++];
+            size += v;
+            if(v < 255) {ends = true; break;}
+        }
+        ogg->spanLeft = size;
+        ogg->f_spanEnds = ends;
+        if(!ogg->f_skip && ogg->reasmLen + size > OGG_MAX_PACKET){
+            log_w("ogg packet > %u bytes skipped", OGG_MAX_PACKET);
+            ogg->f_skip = true;
+            ogg->reasmLen = 0;
+        }
+        if(size == 0){  // empty packet or a packet that ends exactly with the last page
+            if(!ends) continue;
+            if(ogg->f_skip) ogg->f_skip = false;
+            else if(ogg->reasmLen){
+                ogg->f_reasmReady = true;
+                *pkt = ogg->reasmBuff;
+                *pktLen = ogg->reasmLen;
+                return OGG_PACKET_READY;
+            }
+            else packetDone(ogg);
+            continue;
+        }
+        bool whole = !ogg->f_skip && !ogg->reasmLen && ends && size <= (uint32_t)len;  // the whole packet is in data
+        if(whole && !ogg->f_copyAll){
+            ogg->f_inPlace = true;
+            *pkt = data;
+            *pktLen = size;
+            return OGG_PACKET_READY;
+        }
+        if(!ogg->f_skip && !reserveReasm(ogg, ogg->reasmLen + size)){  // the packet is lost
+            ogg->f_skip = true;
+            ogg->reasmLen = 0;
+            return ERR_OGG_OUT_OF_MEMORY;
+        }
+    }
+
+    // copy the span (or the part in data) into the reassembly buffer
+    uint32_t n = ogg->spanLeft;
+    if(n > (uint32_t)len) n = len;
+    if(!ogg->f_skip){
+        memcpy(ogg->reasmBuff + ogg->reasmLen, data, n);
+        ogg->reasmLen += n;
+        ogg->bytesCopied += n;
+    }
+    ogg->spanLeft -= n;
+    if(ogg->spanLeft == 0 && ogg->f_spanEnds){
+        if(ogg->f_skip) ogg->f_skip = false;
+        else ogg->f_reasmReady = true;
+    }
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int OggPacketUsed(OggDemuxer_t* ogg, int n){
+    // n bytes of the delivered packet are decoded
+    // Return: bytes to consume from the stream, 0 if the packet came from the reassembly buffer
+    if(n <= 0) return 0;
+    if(ogg->f_reasmReady){
+        ogg->pktUsed += n;
+        if(ogg->pktUsed >= ogg->reasmLen){
+            ogg->f_reasmReady = false;
+            ogg->reasmLen = 0;
+            packetDone(ogg);
+        }
+        return 0;
+    }
+    if(ogg->f_inPlace){
+        if((uint32_t)n > ogg->spanLeft) n = ogg->spanLeft;
+        ogg->spanLeft -= n;
+        ogg->pktUsed += n;
+        if(!ogg->spanLeft){
+            ogg->f_inPlace = false;
+            packetDone(ogg);
+        }
+        return n;
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int OggPacketDrop(OggDemuxer_t* ogg){
+    // the codec can't use the rest of the packet (decode error, unknown header packet)
+    // Return: bytes to consume from the stream
+    if(ogg->f_reasmReady) return OggPacketUsed(ogg, ogg->reasmLen - ogg->pktUsed);
+    if(ogg->f_inPlace)    return OggPacketUsed(ogg, ogg->spanLeft);
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool OggPacketPending(OggDemuxer_t* ogg){
+    return ogg->f_reasmReady || ogg->f_inPlace;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool OggInSync(OggDemuxer_t* ogg){
+    // false after OggDemuxer_Reset() until the next page header is read
+    return ogg->f_sync;
+}
@@ -0,0 +1,63 @@
+/*
+ * ogg_demuxer.h
+ *
+ * Ogg container (RFC 3533), delivers the packets of one logical stream to the codec
+ *
+ *  Restrictions:
+ *  no multiplexed (grouped) streams, the pages of all serial numbers are taken as one stream
+ *  packets bigger than OGG_MAX_PACKET are skipped
+ *  the page CRC is not checked, the codecs check their own frames
+ *
+ */
+#pragma once
+
+#include "Arduino.h"
+
+#define OGG_MAX_PACKET  65536   // biggest packet that is reassembled, a FLAC frame with 8192 samples 24 bit stereo fits
+
+enum : int8_t  {OGG_PACKET_READY = 0,
+                ERR_OGG_NONE = 0,
+                ERR_OGG_SYNC_LOST = -1,         // no page header where one was expected
+                ERR_OGG_OUT_OF_MEMORY = -2};
+enum : uint8_t {OGG_CONTINUED = 0x01, OGG_BOS = 0x02, OGG_EOS = 0x04};  // header_type flags
+
+/* state of one Ogg stream, created by OggDemuxer_Create()
+ * A packet that lies completely inside the bytes passed to OggReadPacket() is delivered in place, only packets that
+ * span pages (or are longer than these bytes) are copied into the reassembly buffer. It is allocated with the first
+ * such packet and grows up to the biggest one, in PSRAM if there is one. Cost: 320 bytes plus the reassembly buffer.
+ */
+typedef struct OggDemuxer {
+    uint8_t   lacing[255];          // segment table of the current page
+    uint8_t   segCount;             // segments in the current page
+    uint8_t   segIdx;               // next segment
+    uint8_t   headerType;           // OGG_CONTINUED | OGG_BOS | OGG_EOS of the current page
+    bool      f_sync;               // the stream position is known, cleared by OggDemuxer_Reset()
+    bool      f_inPage;             // page header read, segments left
+    bool      f_skip;               // the packet in work is dropped (rest of a lost packet or too big)
+    bool      f_bos;                // a new logical stream began (chained stream), cleared by the caller
+    uint32_t  spanLeft;             // bytes of the current span (packet part in this page) not yet delivered/copied
+    bool      f_spanEnds;           // the current span completes its packet
+    bool      f_inPlace;            // the current span is delivered in place
+    bool      f_copyAll;            // every packet goes through the reassembly buffer, for comparison in ogg_bench
+    uint32_t  pktUsed;              // bytes of the delivered packet taken by the codec, 0: packet begin
+    uint8_t*  reasmBuff;            // reassembly buffer
+    uint32_t  reasmSize;            // allocated
+    uint32_t  reasmLen;             // bytes of the packet collected
+    bool      f_reasmReady;         // reasmBuff holds a complete packet
+    uint32_t  serial;               // stream serial number of the current page
+    uint64_t  granule;              // granule position of the last page
+    uint32_t  packetNo;             // packet number in the logical stream, 0 is the first header packet
+    uint32_t  pages;                // statistics
+    uint32_t  packets;
+    uint32_t  bytesCopied;
+} OggDemuxer_t;
+
+OggDemuxer_t* OggDemuxer_Create(void);
+void     OggDemuxer_Destroy(OggDemuxer_t* ogg);
+void     OggDemuxer_Reset(OggDemuxer_t* ogg);
+int      OggFindSyncWord(const uint8_t* buf, int nBytes);
+int      OggReadPacket(OggDemuxer_t* ogg, uint8_t* data, int len, uint8_t** pkt, int* pktLen);
+int      OggPacketUsed(OggDemuxer_t* ogg, int n);
+int      OggPacketDrop(OggDemuxer_t* ogg);
+bool     OggPacketPending(OggDemuxer_t* ogg);
+bool     OggInSync(OggDemuxer_t* ogg);
@@ -0,0 +1,3739 @@
+/*
+ * opus_decoder.cpp
+ *
+ * Opus decoder for the ESP32, CELT (RFC 6716 section 4.3) and SILK (section 4.2) layer in fixed point
+ *
+ * The range decoder, the energy, allocation and PVQ decoding follow the reference implementation step by step, the
+ * bitstream is read exactly as libopus reads it (same final range for every packet). SILK is the fixed point decoder
+ * of the reference with its rounding, 8, 12 or 16kHz resampled to 48kHz. The CELT signal path uses integers:
+ *   band energies         int32, log2 Q16
+ *   normalized spectrum   int16, Q14, each band is a unit vector
+ *   signal                int32, one LSB of the 16 bit output is 1 << SIG_SHIFT
+ * the IMDCT runs on a mixed radix FFT (radix 2, 3, 4, 5) of 60...480 points with Q15 twiddles
+ *
+ */
+#pragma GCC optimize ("O3")
+#include "opus_decoder.h"
+#include "../audio_arena/audio_arena.h"
+
+#define BITRES                  3       // allocation resolution 1/8 bit
+#define MAX_FINE_BITS           8
+#define FINE_OFFSET             21
+#define QTHETA_OFFSET           4
+#define QTHETA_OFFSET_TWOPHASE  16
+#define LOG_MAX_PSEUDO          6
+#define ALLOC_STEPS             6
+#define NB_ALLOC_VECTORS        11
+#define SHORT_MDCT_SIZE         120
+#define MAX_LM                  3
+#define SIG_SHIFT               12
+#define SIG_SAT                 300000000
+#define DB_SHIFT                16
+#define COMBFILTER_MINPERIOD    15
+#define NORM_SIZE               (78 << MAX_LM)  // normalized bands of one channel that can be a folding source
+
+enum : uint8_t {SPREAD_NONE, SPREAD_LIGHT, SPREAD_NORMAL, SPREAD_AGGRESSIVE};
+enum : uint8_t {OPUS_MODE_NONE, OPUS_MODE_SILK, OPUS_MODE_HYBRID, OPUS_MODE_CELT};  // NONE: no frame decoded yet
+
+// The decoder state lives in an OpusDecoder_t context. The API functions make their context the current one of the
+// calling task, all internal functions work on m_dec.
+static thread_local OpusDecoder_t *m_dec = NULL;
+static OpusDecoder_t *m_defaultDec = NULL;   // used by the API without context
+
+//----------------------------------------------------------------------------------------------------------------------
+//          T A B L E S   (48kHz mode, 2.5ms short blocks)
+//----------------------------------------------------------------------------------------------------------------------
+static const int16_t eBands[OPUS_NB_EBANDS + 1] PROGMEM = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 34, 40, 48, 60, 78, 100};
+
+static const uint8_t logN400[OPUS_NB_EBANDS] PROGMEM = {
+    0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 8, 8, 16, 16, 16, 21, 21, 24, 29, 34, 36};
+
+static const int8_t eMeans[OPUS_NB_EBANDS] PROGMEM = {  // mean band energies, log2 Q4
+    103, 100, 92, 85, 81, 77, 72, 70, 78, 75, 73, 71, 78, 74, 69, 72, 70, 74, 76, 71, 60};
+
+static const uint8_t bandAllocation[NB_ALLOC_VECTORS * OPUS_NB_EBANDS] PROGMEM = {  // 1/32 bit per sample
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+     90,  80,  75,  69,  63,  56,  49,  40,  34,  29,  20,  18,  10,   0,   0,   0,   0,   0,   0,   0,   0,
+    110, 100,  90,  84,  78,  71,  65,  58,  51,  45,  39,  32,  26,  20,  12,   0,   0,   0,   0,   0,   0,
+    118, 110, 103,  93,  86,  80,  75,  70,  65,  59,  53,  47,  40,  31,  23,  15,   4,   0,   0,   0,   0,
+    126, 119, 112, 104,  95,  89,  83,  78,  72,  66,  60,  54,  47,  39,  32,  25,  17,  12,   1,   0,   0,
+    134, 127, 120, 114, 103,  97,  91,  85,  78,  72,  66,  60,  54,  47,  41,  35,  29,  23,  16,  10,   1,
+    144, 137, 130, 124, 113, 107, 101,  95,  88,  82,  76,  70,  64,  57,  51,  45,  39,  33,  26,  15,   1,
+    152, 145, 138, 132, 123, 117, 111, 105,  98,  92,  86,  80,  74,  67,  61,  55,  49,  43,  36,  20,   1,
+    162, 155, 148, 142, 133, 127, 121, 115, 108, 102,  96,  90,  84,  77,  71,  65,  59,  53,  46,  30,   1,
+    172, 165, 158, 152, 143, 137, 131, 125, 118, 112, 106, 100,  94,  87,  81,  75,  69,  63,  56,  45,  20,
+    200, 200, 200, 200, 200, 200, 200, 200, 198, 193, 188, 183, 178, 173, 168, 163, 158, 153, 148, 129, 104};
+
+static const uint8_t eProbModel[4][2][42] PROGMEM = {  // Laplace parameters of the coarse energy [LM][intra]
+    {{ 72, 127,  65, 129,  66, 128,  65, 128,  64, 128,  62, 128,  64, 128,  64, 128,  92,  78,  92,  79,  92,  78,
+       90,  79, 116,  41, 115,  40, 114,  40, 132,  26, 132,  26, 145,  17, 161,  12, 176,  10, 177,  11},
+     { 24, 179,  48, 138,  54, 135,  54, 132,  53, 134,  56, 133,  55, 132,  55, 132,  61, 114,  70,  96,  74,  88,
+       75,  88,  87,  74,  89,  66,  91,  67, 100,  59, 108,  50, 120,  40, 122,  37,  97,  43,  78,  50}},
+    {{ 83,  78,  84,  81,  88,  75,  86,  74,  87,  71,  90,  73,  93,  74,  93,  74, 109,  40, 114,  36, 117,  34,
+      117,  34, 143,  17, 145,  18, 146,  19, 162,  12, 165,  10, 178,   7, 189,   6, 190,   8, 177,   9},
+     { 23, 178,  54, 115,  63, 102,  66,  98,  69,  99,  74,  89,  71,  91,  73,  91,  78,  89,  86,  80,  92,  66,
+       93,  64, 102,  59, 103,  60, 104,  60, 117,  52, 123,  44, 138,  35, 133,  31,  97,  38,  77,  45}},
+    {{ 61,  90,  93,  60, 105,  42, 107,  41, 110,  45, 116,  38, 113,  38, 112,  38, 124,  26, 132,  27, 136,  19,
+      140,  20, 155,  14, 159,  16, 158,  18, 170,  13, 177,  10, 187,   8, 192,   6, 175,   9, 159,  10},
+     { 21, 178,  59, 110,  71,  86,  75,  85,  84,  83,  91,  66,  88,  73,  87,  72,  92,  75,  98,  72, 105,  58,
+      107,  54, 115,  52, 114,  55, 112,  56, 129,  51, 132,  40, 150,  33, 140,  29,  98,  35,  77,  42}},
+    {{ 42, 121,  96,  66, 108,  43, 111,  40, 117,  44, 123,  32, 120,  36, 119,  33, 127,  33, 134,  34, 139,  21,
+      147,  23, 152,  20, 158,  25, 154,  26, 166,  21, 173,  16, 184,  13, 184,  10, 150,  13, 139,  15},
+     { 22, 178,  63, 114,  74,  82,  84,  83,  92,  82, 103,  62,  96,  72,  96,  67, 101,  73, 107,  72, 113,  55,
+      118,  52, 125,  52, 118,  52, 117,  55, 135,  49, 137,  39, 157,  32, 145,  29,  97,  33,  77,  40}}};
+
+static const int16_t predCoef[4] PROGMEM = {29440, 26112, 21248, 16384};  // Q15, inter frame energy prediction
+static const int16_t betaCoef[4] PROGMEM = {30147, 22282, 12124, 6554};
+static const int16_t betaIntra = 4915;
+
+static const int8_t  tfSelectTable[4][8] PROGMEM = {
+    {0, -1, 0, -1, 0, -1, 0, -1}, {0, -1, 0, -2, 1, 0, 1, -1}, {0, -2, 0, -3, 2, 0, 1, -1}, {0, -2, 0, -3, 3, 0, 1, -1}};
+
+static const uint8_t log2FracTable[24] PROGMEM = {
+    0, 8, 13, 16, 19, 21, 23, 24, 26, 27, 28, 29, 30, 31, 32, 32, 33, 34, 34, 35, 36, 36, 37, 37};
+
+static const uint8_t smallEnergyIcdf[3] PROGMEM = {2, 1, 0};
+static const uint8_t tapsetIcdf[3]      PROGMEM = {2, 1, 0};
+static const uint8_t spreadIcdf[4]      PROGMEM = {25, 23, 2, 0};
+static const uint8_t trimIcdf[11]       PROGMEM = {126, 124, 119, 109, 87, 41, 19, 9, 4, 2, 0};
+
+static const int16_t combGains[3][3] PROGMEM = {{10048, 7112, 4248}, {15200, 8784, 0}, {26208, 3280, 0}};  // Q15
+static const uint8_t fftFactors[4][10] PROGMEM = {  // radix, remaining length: 480, 240, 120, 60 points
+    {4, 120, 4, 30, 2, 15, 3, 5, 5, 1}, {4, 60, 4, 15, 3, 5, 5, 1}, {4, 30, 2, 15, 3, 5, 5, 1}, {4, 15, 3, 5, 5, 1}};
+static const uint16_t mdctTrigOffset[4] PROGMEM = {0, 960, 1440, 1680};
+
+// pulse cache: bits needed for K pulses in a band, by band and LM (libopus static mode 48000/960)
+static const uint8_t cacheBits50[392] PROGMEM = {
+     40,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,
+      7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,
+      7,  40,  15,  23,  28,  31,  34,  36,  38,  39,  41,  42,  43,  44,  45,  46,  47,  47,  49,  50,
+     51,  52,  53,  54,  55,  55,  57,  58,  59,  60,  61,  62,  63,  63,  65,  66,  67,  68,  69,  70,
+     71,  71,  40,  20,  33,  41,  48,  53,  57,  61,  64,  66,  69,  71,  73,  75,  76,  78,  80,  82,
+     85,  87,  89,  91,  92,  94,  96,  98, 101, 103, 105, 107, 108, 110, 112, 114, 117, 119, 121, 123,
+    124, 126, 128,  40,  23,  39,  51,  60,  67,  73,  79,  83,  87,  91,  94,  97, 100, 102, 105, 107,
+    111, 115, 118, 121, 124, 126, 129, 131, 135, 139, 142, 145, 148, 150, 153, 155, 159, 163, 166, 169,
+    172, 174, 177, 179,  35,  28,  49,  65,  78,  89,  99, 107, 114, 120, 126, 132, 136, 141, 145, 149,
+    153, 159, 165, 171, 176, 180, 185, 189, 192, 199, 205, 211, 216, 220, 225, 229, 232, 239, 245, 251,
+     21,  33,  58,  79,  97, 112, 125, 137, 148, 157, 166, 174, 182, 189, 195, 201, 207, 217, 227, 235,
+    243, 251,  17,  35,  63,  86, 106, 123, 139, 152, 165, 177, 187, 197, 206, 214, 222, 230, 237, 250,
+     25,  31,  55,  75,  91, 105, 117, 128, 138, 146, 154, 161, 168, 174, 180, 185, 190, 200, 208, 215,
+    222, 229, 235, 240, 245, 255,  16,  36,  65,  89, 110, 128, 144, 159, 173, 185, 196, 207, 217, 226,
+    234, 242, 250,  11,  41,  74, 103, 128, 151, 172, 191, 209, 225, 241, 255,   9,  43,  79, 110, 138,
+    163, 186, 207, 227, 246,  12,  39,  71,  99, 123, 144, 164, 182, 198, 214, 228, 241, 253,   9,  44,
+     81, 113, 142, 168, 192, 214, 235, 255,   7,  49,  90, 127, 160, 191, 220, 247,   6,  51,  95, 134,
+    170, 203, 234,   7,  47,  87, 123, 155, 184, 212, 237,   6,  52,  97, 137, 174, 208, 240,   5,  57,
+    106, 151, 192, 231,   5,  59, 111, 158, 202, 243,   5,  55, 103, 147, 187, 224,   5,  60, 113, 161,
+    206, 248,   4,  65, 122, 175, 224,   4,  67, 127, 182, 234};
+static const int16_t cacheIndex50[105] PROGMEM = {
+     -1,  -1,  -1,  -1,  -1,  -1,  -1,  -1,   0,   0,   0,   0,  41,  41,  41,  82,  82, 123, 164, 200, 222,
+      0,   0,   0,   0,   0,   0,   0,   0,  41,  41,  41,  41, 123, 123, 123, 164, 164, 240, 266, 283, 295,
+     41,  41,  41,  41,  41,  41,  41,  41, 123, 123, 123, 123, 240, 240, 240, 266, 266, 305, 318, 328, 336,
+    123, 123, 123, 123, 123, 123, 123, 123, 240, 240, 240, 240, 305, 305, 305, 318, 318, 343, 351, 358, 364,
+    240, 240, 240, 240, 240, 240, 240, 240, 305, 305, 305, 305, 343, 343, 343, 351, 351, 370, 376, 382, 387};
+static const uint8_t cacheCaps50[168] PROGMEM = {
+    224, 224, 224, 224, 224, 224, 224, 224, 160, 160, 160, 160, 185, 185, 185, 178, 178, 168, 134,  61,  37,
+    224, 224, 224, 224, 224, 224, 224, 224, 240, 240, 240, 240, 207, 207, 207, 198, 198, 183, 144,  66,  40,
+    160, 160, 160, 160, 160, 160, 160, 160, 185, 185, 185, 185, 193, 193, 193, 183, 183, 172, 138,  64,  38,
+    240, 240, 240, 240, 240, 240, 240, 240, 207, 207, 207, 207, 204, 204, 204, 193, 193, 180, 143,  66,  40,
+    185, 185, 185, 185, 185, 185, 185, 185, 193, 193, 193, 193, 193, 193, 193, 183, 183, 172, 138,  65,  39,
+    207, 207, 207, 207, 207, 207, 207, 207, 204, 204, 204, 204, 201, 201, 201, 188, 188, 176, 141,  66,  40,
+    193, 193, 193, 193, 193, 193, 193, 193, 193, 193, 193, 193, 194, 194, 194, 184, 184, 173, 139,  65,  39,
+    204, 204, 204, 204, 204, 204, 204, 204, 201, 201, 201, 201, 198, 198, 198, 187, 187, 175, 140,  66,  40};
+static const int16_t mdctTrig[1800] PROGMEM = {
+     32767,  32767,  32767,  32766,  32765,  32763,  32761,  32759,  32756,  32753,  32750,  32746,  32742,  32738,  32733,  32728,
+     32722,  32717,  32710,  32704,  32697,  32690,  32682,  32674,  32666,  32657,  32648,  32639,  32629,  32619,  32609,  32598,
+     32587,  32576,  32564,  32552,  32539,  32526,  32513,  32500,  32486,  32472,  32457,  32442,  32427,  32411,  32395,  32379,
+     32362,  32345,  32328,  32310,  32292,  32274,  32255,  32236,  32217,  32197,  32177,  32157,  32136,  32115,  32093,  32071,
+     32049,  32027,  32004,  31981,  31957,  31933,  31909,  31884,  31859,  31834,  31809,  31783,  31756,  31730,  31703,  31676,
+     31648,  31620,  31592,  31563,  31534,  31505,  31475,  31445,  31415,  31384,  31353,  31322,  31290,  31258,  31226,  31193,
+     31160,  31127,  31093,  31059,  31025,  30990,  30955,  30920,  30884,  30848,  30812,  30775,  30738,  30701,  30663,  30625,
+     30587,  30548,  30509,  30470,  30430,  30390,  30350,  30309,  30269,  30227,  30186,  30144,  30102,  30059,  30016,  29973,
+     29930,  29886,  29842,  29797,  29752,  29707,  29662,  29616,  29570,  29524,  29477,  29430,  29383,  29335,  29287,  29239,
+     29190,  29142,  29092,  29043,  28993,  28943,  28892,  28842,  28791,  28739,  28688,  28636,  28583,  28531,  28478,  28425,
+     28371,  28317,  28263,  28209,  28154,  28099,  28044,  27988,  27932,  27876,  27820,  27763,  27706,  27648,  27591,  27533,
+     27474,  27416,  27357,  27298,  27238,  27178,  27118,  27058,  26997,  26936,  26875,  26814,  26752,  26690,  26628,  26565,
+     26502,  26439,  26375,  26312,  26247,  26183,  26119,  26054,  25988,  25923,  25857,  25791,  25725,  25658,  25592,  25524,
+     25457,  25389,  25322,  25253,  25185,  25116,  25047,  24978,  24908,  24838,  24768,  24698,  24627,  24557,  24485,  24414,
+     24342,  24270,  24198,  24126,  24053,  23980,  23907,  23834,  23760,  23686,  23612,  23537,  23462,  23387,  23312,  23237,
+     23161,  23085,  23009,  22932,  22856,  22779,  22701,  22624,  22546,  22468,  22390,  22312,  22233,  22154,  22075,  21996,
+     21916,  21836,  21756,  21676,  21595,  21515,  21434,  21352,  21271,  21189,  21107,  21025,  20943,  20860,  20777,  20694,
+     20611,  20528,  20444,  20360,  20276,  20192,  20107,  20022,  19937,  19852,  19767,  19681,  19595,  19509,  19423,  19336,
+     19250,  19163,  19076,  18988,  18901,  18813,  18725,  18637,  18549,  18460,  18372,  18283,  18194,  18104,  18015,  17925,
+     17835,  17745,  17655,  17565,  17474,  17383,  17292,  17201,  17110,  17018,  16927,  16835,  16743,  16650,  16558,  16465,
+     16372,  16279,  16186,  16093,  15999,  15906,  15812,  15718,  15624,  15529,  15435,  15340,  15245,  15150,  15055,  14960,
+     14864,  14769,  14673,  14577,  14481,  14385,  14288,  14192,  14095,  13998,  13901,  13804,  13706,  13609,  13511,  13414,
+     13316,  13218,  13119,  13021,  12923,  12824,  12725,  12626,  12527,  12428,  12329,  12230,  12130,  12030,  11930,  11831,
+     11730,  11630,  11530,  11430,  11329,  11228,  11128,  11027,  10926,  10824,  10723,  10622,  10520,  10419,  10317,  10215,
+     10113,  10011,   9909,   9807,   9704,   9602,   9499,   9397,   9294,   9191,   9088,   8985,   8882,   8778,   8675,   8572,
+      8468,   8364,   8261,   8157,   8053,   7949,   7845,   7741,   7637,   7532,   7428,   7323,   7219,   7114,   7009,   6905,
+      6800,   6695,   6590,   6485,   6380,   6274,   6169,   6064,   5958,   5853,   5747,   5642,   5536,   5430,   5325,   5219,
+      5113,   5007,   4901,   4795,   4689,   4583,   4476,   4370,   4264,   4157,   4051,   3945,   3838,   3732,   3625,   3518,
+      3412,   3305,   3198,   3092,   2985,   2878,   2771,   2664,   2558,   2451,   2344,   2237,   2130,   2023,   1916,   1809,
+      1702,   1594,   1487,   1380,   1273,   1166,   1059,    952,    844,    737,    630,    523,    416,    308,    201,     94,
+       -13,   -121,   -228,   -335,   -442,   -550,   -657,   -764,   -871,   -978,  -1086,  -1193,  -1300,  -1407,  -1514,  -1621,
+     -1728,  -1835,  -1942,  -2049,  -2157,  -2263,  -2370,  -2477,  -2584,  -2691,  -2798,  -2905,  -3012,  -3118,  -3225,  -3332,
+     -3439,  -3545,  -3652,  -3758,  -3865,  -3971,  -4078,  -4184,  -4290,  -4397,  -4503,  -4609,  -4715,  -4821,  -4927,  -5033,
+     -5139,  -5245,  -5351,  -5457,  -5562,  -5668,  -5774,  -5879,  -5985,  -6090,  -6195,  -6301,  -6406,  -6511,  -6616,  -6721,
+     -6826,  -6931,  -7036,  -7140,  -7245,  -7349,  -7454,  -7558,  -7663,  -7767,  -7871,  -7975,  -8079,  -8183,  -8287,  -8390,
+     -8494,  -8597,  -8701,  -8804,  -8907,  -9011,  -9114,  -9217,  -9319,  -9422,  -9525,  -9627,  -9730,  -9832,  -9934, -10037,
+    -10139, -10241, -10342, -10444, -10546, -10647, -10748, -10850, -10951, -11052, -11153, -11253, -11354, -11455, -11555, -11655,
+    -11756, -11856, -11955, -12055, -12155, -12254, -12354, -12453, -12552, -12651, -12750, -12849, -12947, -13046, -13144, -13242,
+    -13340, -13438, -13536, -13633, -13731, -13828, -13925, -14022, -14119, -14216, -14312, -14409, -14505, -14601, -14697, -14793,
+    -14888, -14984, -15079, -15174, -15269, -15364, -15459, -15553, -15647, -15741, -15835, -15929, -16023, -16116, -16210, -16303,
+    -16396, -16488, -16581, -16673, -16766, -16858, -16949, -17041, -17133, -17224, -17315, -17406, -17497, -17587, -17678, -17768,
+    -17858, -17948, -18037, -18127, -18216, -18305, -18394, -18483, -18571, -18659, -18747, -18835, -18923, -19010, -19098, -19185,
+    -19271, -19358, -19444, -19531, -19617, -19702, -19788, -19873, -19959, -20043, -20128, -20213, -20297, -20381, -20465, -20549,
+    -20632, -20715, -20798, -20881, -20963, -21046, -21128, -21210, -21291, -21373, -21454, -21535, -21616, -21696, -21776, -21856,
+    -21936, -22016, -22095, -22174, -22253, -22331, -22410, -22488, -22566, -22643, -22721, -22798, -22875, -22951, -23028, -23104,
+    -23180, -23256, -23331, -23406, -23481, -23556, -23630, -23704, -23778, -23852, -23925, -23998, -24071, -24144, -24216, -24288,
+    -24360, -24432, -24503, -24574, -24645, -24716, -24786, -24856, -24926, -24995, -25064, -25133, -25202, -25270, -25339, -25406,
+    -25474, -25541, -25608, -25675, -25742, -25808, -25874, -25939, -26005, -26070, -26135, -26199, -26264, -26327, -26391, -26455,
+    -26518, -26581, -26643, -26705, -26767, -26829, -26891, -26952, -27013, -27073, -27133, -27193, -27253, -27312, -27372, -27430,
+    -27489, -27547, -27605, -27663, -27720, -27777, -27834, -27890, -27946, -28002, -28058, -28113, -28168, -28223, -28277, -28331,
+    -28385, -28438, -28491, -28544, -28596, -28649, -28701, -28752, -28803, -28854, -28905, -28955, -29006, -29055, -29105, -29154,
+    -29203, -29251, -29299, -29347, -29395, -29442, -29489, -29535, -29582, -29628, -29673, -29719, -29764, -29808, -29853, -29897,
+    -29941, -29984, -30027, -30070, -30112, -30154, -30196, -30238, -30279, -30320, -30360, -30400, -30440, -30480, -30519, -30558,
+    -30596, -30635, -30672, -30710, -30747, -30784, -30821, -30857, -30893, -30929, -30964, -30999, -31033, -31068, -31102, -31135,
+    -31168, -31201, -31234, -31266, -31298, -31330, -31361, -31392, -31422, -31453, -31483, -31512, -31541, -31570, -31599, -31627,
+    -31655, -31682, -31710, -31737, -31763, -31789, -31815, -31841, -31866, -31891, -31915, -31939, -31963, -31986, -32010, -32032,
+    -32055, -32077, -32099, -32120, -32141, -32162, -32182, -32202, -32222, -32241, -32260, -32279, -32297, -32315, -32333, -32350,
+    -32367, -32383, -32399, -32415, -32431, -32446, -32461, -32475, -32489, -32503, -32517, -32530, -32542, -32555, -32567, -32579,
+    -32590, -32601, -32612, -32622, -32632, -32641, -32651, -32659, -32668, -32676, -32684, -32692, -32699, -32706, -32712, -32718,
+    -32724, -32729, -32734, -32739, -32743, -32747, -32751, -32754, -32757, -32760, -32762, -32764, -32765, -32767, -32767, -32768,
+     32767,  32767,  32765,  32761,  32756,  32750,  32742,  32732,  32722,  32710,  32696,  32681,  32665,  32647,  32628,  32608,
+     32586,  32562,  32538,  32512,  32484,  32455,  32425,  32393,  32360,  32326,  32290,  32253,  32214,  32174,  32133,  32090,
+     32046,  32001,  31954,  31906,  31856,  31805,  31753,  31700,  31645,  31588,  31530,  31471,  31411,  31349,  31286,  31222,
+     31156,  31089,  31020,  30951,  30880,  30807,  30733,  30658,  30582,  30504,  30425,  30345,  30263,  30181,  30096,  30011,
+     29924,  29836,  29747,  29656,  29564,  29471,  29377,  29281,  29184,  29086,  28987,  28886,  28784,  28681,  28577,  28471,
+     28365,  28257,  28147,  28037,  27925,  27812,  27698,  27583,  27467,  27349,  27231,  27111,  26990,  26868,  26744,  26620,
+     26494,  26367,  26239,  26110,  25980,  25849,  25717,  25583,  25449,  25313,  25176,  25038,  24900,  24760,  24619,  24477,
+     24333,  24189,  24044,  23898,  23751,  23602,  23453,  23303,  23152,  22999,  22846,  22692,  22537,  22380,  22223,  22065,
+     21906,  21746,  21585,  21423,  21261,  21097,  20933,  20767,  20601,  20434,  20265,  20096,  19927,  19756,  19584,  19412,
+     19239,  19065,  18890,  18714,  18538,  18361,  18183,  18004,  17824,  17644,  17463,  17281,  17098,  16915,  16731,  16546,
+     16361,  16175,  15988,  15800,  15612,  15423,  15234,  15043,  14852,  14661,  14469,  14276,  14083,  13889,  13694,  13499,
+     13303,  13107,  12910,  12713,  12515,  12317,  12118,  11918,  11718,  11517,  11316,  11115,  10913,  10710,  10508,  10304,
+     10100,   9896,   9691,   9486,   9281,   9075,   8869,   8662,   8455,   8248,   8040,   7832,   7623,   7415,   7206,   6996,
+      6787,   6577,   6366,   6156,   5945,   5734,   5523,   5311,   5100,   4888,   4675,   4463,   4251,   4038,   3825,   3612,
+      3399,   3185,   2972,   2758,   2544,   2330,   2116,   1902,   1688,   1474,   1260,   1045,    831,    617,    402,    188,
+       -27,   -241,   -456,   -670,   -885,  -1099,  -1313,  -1528,  -1742,  -1956,  -2170,  -2384,  -2598,  -2811,  -3025,  -3239,
+     -3452,  -3665,  -3878,  -4091,  -4304,  -4516,  -4728,  -4941,  -5153,  -5364,  -5576,  -5787,  -5998,  -6209,  -6419,  -6629,
+     -6839,  -7049,  -7258,  -7467,  -7676,  -7884,  -8092,  -8300,  -8507,  -8714,  -8920,  -9127,  -9332,  -9538,  -9743,  -9947,
+    -10151, -10355, -10558, -10761, -10963, -11165, -11367, -11568, -11768, -11968, -12167, -12366, -12565, -12762, -12960, -13156,
+    -13352, -13548, -13743, -13937, -14131, -14324, -14517, -14709, -14900, -15091, -15281, -15470, -15659, -15847, -16035, -16221,
+    -16407, -16593, -16777, -16961, -17144, -17326, -17508, -17689, -17869, -18049, -18227, -18405, -18582, -18758, -18934, -19108,
+    -19282, -19455, -19627, -19799, -19969, -20139, -20308, -20475, -20642, -20809, -20974, -21138, -21301, -21464, -21626, -21786,
+    -21946, -22105, -22263, -22420, -22575, -22730, -22884, -23037, -23189, -23340, -23490, -23640, -23788, -23935, -24080, -24225,
+    -24369, -24512, -24654, -24795, -24934, -25073, -25211, -25347, -25482, -25617, -25750, -25882, -26013, -26143, -26272, -26399,
+    -26526, -26651, -26775, -26898, -27020, -27141, -27260, -27379, -27496, -27612, -27727, -27841, -27953, -28065, -28175, -28284,
+    -28391, -28498, -28603, -28707, -28810, -28911, -29012, -29111, -29209, -29305, -29401, -29495, -29587, -29679, -29769, -29858,
+    -29946, -30032, -30118, -30201, -30284, -30365, -30445, -30524, -30601, -30677, -30752, -30825, -30897, -30968, -31038, -31106,
+    -31172, -31238, -31302, -31365, -31426, -31486, -31545, -31602, -31658, -31713, -31766, -31818, -31869, -31918, -31966, -32012,
+    -32058, -32101, -32144, -32185, -32224, -32262, -32299, -32335, -32369, -32401, -32433, -32463, -32491, -32518, -32544, -32568,
+    -32591, -32613, -32633, -32652, -32669, -32685, -32700, -32713, -32724, -32735, -32744, -32751, -32757, -32762, -32766, -32767,
+     32767,  32764,  32755,  32741,  32720,  32694,  32663,  32626,  32583,  32535,  32481,  32421,  32356,  32286,  32209,  32128,
+     32041,  31948,  31850,  31747,  31638,  31523,  31403,  31278,  31148,  31012,  30871,  30724,  30572,  30415,  30253,  30086,
+     29913,  29736,  29553,  29365,  29172,  28974,  28771,  28564,  28351,  28134,  27911,  27684,  27452,  27216,  26975,  26729,
+     26478,  26223,  25964,  25700,  25432,  25159,  24882,  24601,  24315,  24026,  23732,  23434,  23133,  22827,  22517,  22204,
+     21886,  21565,  21240,  20912,  20580,  20244,  19905,  19563,  19217,  18868,  18516,  18160,  17802,  17440,  17075,  16708,
+     16338,  15964,  15588,  15210,  14829,  14445,  14059,  13670,  13279,  12886,  12490,  12093,  11693,  11291,  10888,  10482,
+     10075,   9666,   9255,   8843,   8429,   8014,   7597,   7180,   6760,   6340,   5919,   5496,   5073,   4649,   4224,   3798,
+      3372,   2945,   2517,   2090,   1661,   1233,    804,    375,    -54,   -483,   -911,  -1340,  -1768,  -2197,  -2624,  -3052,
+     -3479,  -3905,  -4330,  -4755,  -5179,  -5602,  -6024,  -6445,  -6865,  -7284,  -7702,  -8118,  -8533,  -8946,  -9358,  -9768,
+    -10177, -10584, -10989, -11392, -11793, -12192, -12589, -12984, -13377, -13767, -14155, -14541, -14924, -15305, -15683, -16058,
+    -16430, -16800, -17167, -17531, -17892, -18249, -18604, -18956, -19304, -19649, -19990, -20329, -20663, -20994, -21322, -21646,
+    -21966, -22282, -22595, -22904, -23208, -23509, -23806, -24099, -24387, -24672, -24952, -25228, -25499, -25766, -26029, -26288,
+    -26541, -26791, -27035, -27275, -27511, -27741, -27967, -28188, -28405, -28616, -28823, -29024, -29221, -29412, -29599, -29780,
+    -29957, -30128, -30294, -30455, -30611, -30761, -30906, -31046, -31181, -31310, -31434, -31552, -31665, -31773, -31875, -31972,
+    -32063, -32149, -32229, -32304, -32373, -32437, -32495, -32547, -32594, -32635, -32671, -32701, -32726, -32745, -32758, -32766,
+     32767,  32754,  32717,  32658,  32577,  32473,  32348,  32200,  32029,  31837,  31624,  31388,  31131,  30853,  30553,  30232,
+     29891,  29530,  29148,  28746,  28324,  27883,  27423,  26944,  26447,  25931,  25398,  24847,  24279,  23695,  23095,  22478,
+     21846,  21199,  20538,  19863,  19174,  18472,  17757,  17030,  16291,  15541,  14781,  14010,  13230,  12441,  11643,  10837,
+     10024,   9204,   8377,   7545,   6708,   5866,   5020,   4171,   3319,   2464,   1608,    751,   -107,   -965,  -1822,  -2678,
+     -3532,  -4383,  -5232,  -6077,  -6918,  -7754,  -8585,  -9409, -10228, -11039, -11843, -12639, -13426, -14204, -14972, -15730,
+    -16477, -17213, -17937, -18648, -19347, -20033, -20705, -21363, -22006, -22634, -23246, -23843, -24423, -24986, -25533, -26062,
+    -26573, -27066, -27540, -27995, -28431, -28848, -29245, -29622, -29979, -30315, -30630, -30924, -31197, -31449, -31679, -31887,
+    -32074, -32239, -32381, -32501, -32600, -32675, -32729, -32759};
+static const int16_t fftTwiddles[960] PROGMEM = {  // re, im of exp(-2 pi i k / 480)
+     32767,      0,  32765,   -429,  32757,   -858,  32743,  -1286,  32723,  -1715,  32698,  -2143,  32667,  -2571,  32631,  -2998,
+     32588,  -3425,  32541,  -3851,  32488,  -4277,  32429,  -4702,  32365,  -5126,  32295,  -5549,  32219,  -5971,  32138,  -6393,
+     32052,  -6813,  31960,  -7232,  31863,  -7650,  31760,  -8066,  31651,  -8481,  31538,  -8895,  31419,  -9307,  31294,  -9717,
+     31164, -10126,  31029, -10533,  30888, -10938,  30743, -11342,  30592, -11743,  30435, -12142,  30274, -12540,  30107, -12935,
+     29935, -13328,  29758, -13719,  29576, -14107,  29389, -14493,  29197, -14876,  28999, -15257,  28797, -15636,  28590, -16011,
+     28378, -16384,  28161, -16754,  27939, -17121,  27713, -17485,  27482, -17847,  27246, -18205,  27005, -18560,  26760, -18912,
+     26510, -19261,  26255, -19606,  25997, -19948,  25733, -20286,  25466, -20622,  25193, -20953,  24917, -21281,  24636, -21605,
+     24351, -21926,  24062, -22243,  23769, -22556,  23472, -22865,  23170, -23170,  22865, -23472,  22556, -23769,  22243, -24062,
+     21926, -24351,  21605, -24636,  21281, -24917,  20953, -25193,  20622, -25466,  20286, -25733,  19948, -25997,  19606, -26255,
+     19261, -26510,  18912, -26760,  18560, -27005,  18205, -27246,  17847, -27482,  17485, -27713,  17121, -27939,  16754, -28161,
+     16384, -28378,  16011, -28590,  15636, -28797,  15257, -28999,  14876, -29197,  14493, -29389,  14107, -29576,  13719, -29758,
+     13328, -29935,  12935, -30107,  12540, -30274,  12142, -30435,  11743, -30592,  11342, -30743,  10938, -30888,  10533, -31029,
+     10126, -31164,   9717, -31294,   9307, -31419,   8895, -31538,   8481, -31651,   8066, -31760,   7650, -31863,   7232, -31960,
+      6813, -32052,   6393, -32138,   5971, -32219,   5549, -32295,   5126, -32365,   4702, -32429,   4277, -32488,   3851, -32541,
+      3425, -32588,   2998, -32631,   2571, -32667,   2143, -32698,   1715, -32723,   1286, -32743,    858, -32757,    429, -32765,
+         0, -32768,   -429, -32765,   -858, -32757,  -1286, -32743,  -1715, -32723,  -2143, -32698,  -2571, -32667,  -2998, -32631,
+     -3425, -32588,  -3851, -32541,  -4277, -32488,  -4702, -32429,  -5126, -32365,  -5549, -32295,  -5971, -32219,  -6393, -32138,
+     -6813, -32052,  -7232, -31960,  -7650, -31863,  -8066, -31760,  -8481, -31651,  -8895, -31538,  -9307, -31419,  -9717, -31294,
+    -10126, -31164, -10533, -31029, -10938, -30888, -11342, -30743, -11743, -30592, -12142, -30435, -12540, -30274, -12935, -30107,
+    -13328, -29935, -13719, -29758, -14107, -29576, -14493, -29389, -14876, -29197, -15257, -28999, -15636, -28797, -16011, -28590,
+    -16384, -28378, -16754, -28161, -17121, -27939, -17485, -27713, -17847, -27482, -18205, -27246, -18560, -27005, -18912, -26760,
+    -19261, -26510, -19606, -26255, -19948, -25997, -20286, -25733, -20622, -25466, -20953, -25193, -21281, -24917, -21605, -24636,
+    -21926, -24351, -22243, -24062, -22556, -23769, -22865, -23472, -23170, -23170, -23472, -22865, -23769, -22556, -24062, -22243,
+    -24351, -21926, -24636, -21605, -24917, -21281, -25193, -20953, -25466, -20622, -25733, -20286, -25997, -19948, -26255, -19606,
+    -26510, -19261, -26760, -18912, -27005, -18560, -27246, -18205, -27482, -17847, -27713, -17485, -27939, -17121, -28161, -16754,
+    -28378, -16384, -28590, -16011, -28797, -15636, -28999, -15257, -29197, -14876, -29389, -14493, -29576, -14107, -29758, -13719,
+    -29935, -13328, -30107, -12935, -30274, -12540, -30435, -12142, -30592, -11743, -30743, -11342, -30888, -10938, -31029, -10533,
+    -31164, -10126, -31294,  -9717, -31419,  -9307, -31538,  -8895, -31651,  -8481, -31760,  -8066, -31863,  -7650, -31960,  -7232,
+    -32052,  -6813, -32138,  -6393, -32219,  -5971, -32295,  -5549, -32365,  -5126, -32429,  -4702, -32488,  -4277, -32541,  -3851,
+    -32588,  -3425, -32631,  -2998, -32667,  -2571, -32698,  -2143, -32723,  -1715, -32743,  -1286, -32757,   -858, -32765,   -429,
+    -32768,      0, -32765,    429, -32757,    858, -32743,   1286, -32723,   1715, -32698,   2143, -32667,   2571, -32631,   2998,
+    -32588,   3425, -32541,   3851, -32488,   4277, -32429,   4702, -32365,   5126, -32295,   5549, -32219,   5971, -32138,   6393,
+    -32052,   6813, -31960,   7232, -31863,   7650, -31760,   8066, -31651,   8481, -31538,   8895, -31419,   9307, -31294,   9717,
+    -31164,  10126, -31029,  10533, -30888,  10938, -30743,  11342, -30592,  11743, -30435,  12142, -30274,  12540, -30107,  12935,
+    -29935,  13328, -29758,  13719, -29576,  14107, -29389,  14493, -29197,  14876, -28999,  15257, -28797,  15636, -28590,  16011,
+    -28378,  16384, -28161,  16754, -27939,  17121, -27713,  17485, -27482,  17847, -27246,  18205, -27005,  18560, -26760,  18912,
+    -26510,  19261, -26255,  19606, -25997,  19948, -25733,  20286, -25466,  20622, -25193,  20953, -24917,  21281, -24636,  21605,
+    -24351,  21926, -24062,  22243, -23769,  22556, -23472,  22865, -23170,  23170, -22865,  23472, -22556,  23769, -22243,  24062,
+    -21926,  24351, -21605,  24636, -21281,  24917, -20953,  25193, -20622,  25466, -20286,  25733, -19948,  25997, -19606,  26255,
+    -19261,  26510, -18912,  26760, -18560,  27005, -18205,  27246, -17847,  27482, -17485,  27713, -17121,  27939, -16754,  28161,
+    -16384,  28378, -16011,  28590, -15636,  28797, -15257,  28999, -14876,  29197, -14493,  29389, -14107,  29576, -13719,  29758,
+    -13328,  29935, -12935,  30107, -12540,  30274, -12142,  30435, -11743,  30592, -11342,  30743, -10938,  30888, -10533,  31029,
+    -10126,  31164,  -9717,  31294,  -9307,  31419,  -8895,  31538,  -8481,  31651,  -8066,  31760,  -7650,  31863,  -7232,  31960,
+     -6813,  32052,  -6393,  32138,  -5971,  32219,  -5549,  32295,  -5126,  32365,  -4702,  32429,  -4277,  32488,  -3851,  32541,
+     -3425,  32588,  -2998,  32631,  -2571,  32667,  -2143,  32698,  -1715,  32723,  -1286,  32743,   -858,  32757,   -429,  32765,
+         0,  32767,    429,  32765,    858,  32757,   1286,  32743,   1715,  32723,   2143,  32698,   2571,  32667,   2998,  32631,
+      3425,  32588,   3851,  32541,   4277,  32488,   4702,  32429,   5126,  32365,   5549,  32295,   5971,  32219,   6393,  32138,
+      6813,  32052,   7232,  31960,   7650,  31863,   8066,  31760,   8481,  31651,   8895,  31538,   9307,  31419,   9717,  31294,
+     10126,  31164,  10533,  31029,  10938,  30888,  11342,  30743,  11743,  30592,  12142,  30435,  12540,  30274,  12935,  30107,
+     13328,  29935,  13719,  29758,  14107,  29576,  14493,  29389,  14876,  29197,  15257,  28999,  15636,  28797,  16011,  28590,
+     16384,  28378,  16754,  28161,  17121,  27939,  17485,  27713,  17847,  27482,  18205,  27246,  18560,  27005,  18912,  26760,
+     19261,  26510,  19606,  26255,  19948,  25997,  20286,  25733,  20622,  25466,  20953,  25193,  21281,  24917,  21605,  24636,
+     21926,  24351,  22243,  24062,  22556,  23769,  22865,  23472,  23170,  23170,  23472,  22865,  23769,  22556,  24062,  22243,
+     24351,  21926,  24636,  21605,  24917,  21281,  25193,  20953,  25466,  20622,  25733,  20286,  25997,  19948,  26255,  19606,
+     26510,  19261,  26760,  18912,  27005,  18560,  27246,  18205,  27482,  17847,  27713,  17485,  27939,  17121,  28161,  16754,
+     28378,  16384,  28590,  16011,  28797,  15636,  28999,  15257,  29197,  14876,  29389,  14493,  29576,  14107,  29758,  13719,
+     29935,  13328,  30107,  12935,  30274,  12540,  30435,  12142,  30592,  11743,  30743,  11342,  30888,  10938,  31029,  10533,
+     31164,  10126,  31294,   9717,  31419,   9307,  31538,   8895,  31651,   8481,  31760,   8066,  31863,   7650,  31960,   7232,
+     32052,   6813,  32138,   6393,  32219,   5971,  32295,   5549,  32365,   5126,  32429,   4702,  32488,   4277,  32541,   3851,
+     32588,   3425,  32631,   2998,  32667,   2571,  32698,   2143,  32723,   1715,  32743,   1286,  32757,    858,  32765,    429};
+static const int16_t celtWindow[120] PROGMEM = {
+        2,    20,    55,   108,   178,   266,   372,   494,   635,   792,   966,  1157,  1365,  1590,  1831,
+     2089,  2362,  2651,  2956,  3276,  3611,  3961,  4325,  4703,  5094,  5499,  5916,  6346,  6788,  7241,
+     7705,  8179,  8663,  9156,  9657, 10167, 10684, 11207, 11736, 12271, 12810, 13353, 13899, 14447, 14997,
+    15547, 16098, 16648, 17197, 17744, 18287, 18827, 19363, 19893, 20418, 20936, 21447, 21950, 22445, 22931,
+    23407, 23874, 24330, 24774, 25208, 25629, 26039, 26435, 26819, 27190, 27548, 27893, 28224, 28541, 28845,
+    29135, 29411, 29674, 29924, 30160, 30384, 30594, 30792, 30977, 31151, 31313, 31463, 31602, 31731, 31849,
+    31958, 32057, 32148, 32229, 32303, 32370, 32429, 32481, 32528, 32568, 32604, 32634, 32661, 32683, 32701,
+    32717, 32729, 32740, 32748, 32754, 32758, 32762, 32764, 32766, 32767, 32767, 32767, 32767, 32767, 32767};
+//----------------------------------------------------------------------------------------------------------------------
+//          S I L K   T A B L E S   (silk/tables_*.c of the reference)
+//----------------------------------------------------------------------------------------------------------------------
+static const uint8_t silkGainIcdf[3][8] PROGMEM = {  // MSBs of the first gain, by signal type
+    {224, 112,  44,  15,   3,   2,   1,   0},
+    {254, 237, 192, 132,  70,  23,   4,   0},
+    {255, 252, 226, 155,  61,  11,   2,   0}};
+static const uint8_t silkDeltaGainIcdf[41] PROGMEM = {
+    250, 245, 234, 203,  71,  50,  42,  38,  35,  33,  31,  29,  28,  27,  26,  25,  24,  23,  22,  21,  20,
+     19,  18,  17,  16,  15,  14,  13,  12,  11,  10,   9,   8,   7,   6,   5,   4,   3,   2,   1,   0};
+static const uint8_t silkUniform8Icdf[8] PROGMEM = {224, 192, 160, 128, 96, 64, 32, 0};
+static const uint8_t silkUniform6Icdf[6] PROGMEM = {213, 171, 128, 85, 43, 0};
+static const uint8_t silkUniform5Icdf[5] PROGMEM = {205, 154, 102, 51, 0};
+static const uint8_t silkUniform4Icdf[4] PROGMEM = {192, 128, 64, 0};
+static const uint8_t silkUniform3Icdf[3] PROGMEM = {171, 85, 0};
+static const uint8_t silkTypeOffsetNoVadIcdf[2] PROGMEM = {230, 0};
+static const uint8_t silkTypeOffsetVadIcdf[4] PROGMEM = {232, 158, 10, 0};
+static const uint8_t silkNlsfInterpIcdf[5] PROGMEM = {243, 221, 192, 181, 0};
+static const uint8_t silkNlsfExtIcdf[7] PROGMEM = {100, 40, 16, 7, 3, 1, 0};
+static const uint8_t silkLtpScaleIcdf[3] PROGMEM = {128, 64, 0};
+static const uint8_t silkLsbIcdf[2] PROGMEM = {120, 0};
+static const uint8_t silkLbrrFlags2Icdf[3] PROGMEM = {203, 150, 0};
+static const uint8_t silkLbrrFlags3Icdf[7] PROGMEM = {215, 195, 166, 125, 110, 82, 0};
+static const uint8_t silkStereoOnlyMidIcdf[2] PROGMEM = {64, 0};
+static const uint8_t silkStereoPredJointIcdf[25] PROGMEM = {
+    249, 247, 246, 245, 244, 234, 210, 202, 201, 200, 197, 174,  82,  59,  56,  55,  54,  46,  22,  12,
+     11,  10,   9,   7,   0};
+static const int16_t silkStereoPredQuantQ13[16] PROGMEM = {
+    -13732, -10050, -8266, -7526, -6500, -5000, -2950, -820, 820, 2950, 5000, 6500, 7526, 8266, 10050, 13732};
+static const int16_t silkQuantOffsetsQ10[2][2] PROGMEM = {{100, 240}, {32, 100}};  // [voiced][offset type]
+static const uint8_t silkPitchLagIcdf[32] PROGMEM = {
+    253, 250, 244, 233, 212, 182, 150, 131, 120, 110,  98,  85,  72,  60,  49,  40,
+     32,  25,  19,  15,  13,  11,   9,   8,   7,   6,   5,   4,   3,   2,   1,   0};
+static const uint8_t silkPitchDeltaIcdf[21] PROGMEM = {
+    210, 208, 206, 203, 199, 193, 183, 168, 142, 104,  74,  52,  37,  27,  20,  14,  10,   6,   4,   2,   0};
+static const uint8_t silkPitchContourIcdf[34] PROGMEM = {
+    223, 201, 183, 167, 152, 138, 124, 111,  98,  88,  79,  70,  62,  56,  50,  44,  39,
+     35,  31,  27,  24,  21,  18,  16,  14,  12,  10,   8,   6,   4,   3,   2,   1,   0};
+static const uint8_t silkPitchContourNBIcdf[11] PROGMEM = {188, 176, 155, 138, 119, 97, 67, 43, 26, 10, 0};
+static const uint8_t silkPitchContour10msIcdf[12] PROGMEM = {165, 119, 80, 61, 47, 35, 27, 20, 14, 9, 4, 0};
+static const uint8_t silkPitchContour10msNBIcdf[3] PROGMEM = {113, 63, 0};
+static const int8_t silkCBLagsStage2[4][11] PROGMEM = {  // pitch contour codebooks, 8kHz
+    { 0,  2, -1, -1, -1,  0,  0,  1,  1,  0,  1},
+    { 0,  1,  0,  0,  0,  0,  0,  1,  0,  0,  0},
+    { 0,  0,  1,  0,  0,  0,  1,  0,  0,  0,  0},
+    { 0, -1,  2,  1,  0,  1,  1,  0,  0, -1, -1}};
+static const int8_t silkCBLagsStage3[4][34] PROGMEM = {  // 12 and 16kHz
+    { 0,  0,  1, -1,  0,  1, -1,  0, -1,  1, -2,  2, -2, -2,  2, -3,  2,
+      3, -3, -4,  3, -4,  4,  4, -5,  5, -6, -5,  6, -7,  6,  5,  8, -9},
+    { 0,  0,  1,  0,  0,  0,  0,  0,  0,  0, -1,  1,  0,  0,  1, -1,  0,
+      1, -1, -1,  1, -1,  2,  1, -1,  2, -2, -2,  2, -2,  2,  2,  3, -3},
+    { 0,  1,  0,  0,  0,  0,  0,  0,  1,  0,  1,  0,  0,  1, -1,  1,  0,
+      0,  2,  1, -1,  2, -1, -1,  2, -1,  2,  2, -1,  3, -2, -2, -2,  3},
+    { 0,  1,  0,  0,  1,  0,  1, -1,  2, -1,  2, -1,  2,  3, -2,  3, -2,
+     -2,  4,  4, -3,  5, -3, -4,  6, -4,  6,  5, -5,  8, -6, -5, -7,  9}};
+static const int8_t silkCBLagsStage2_10ms[2][3] PROGMEM = {
+    {0, 1, 0},
+    {0, 0, 1}};
+static const int8_t silkCBLagsStage3_10ms[2][12] PROGMEM = {
+    { 0,  0,  1, -1,  1, -1,  2, -2,  2, -2,  3, -3},
+    { 0,  1,  0,  1, -1,  2, -1,  2, -2,  3, -2,  3}};
+static const uint8_t silkLtpPerIndexIcdf[3] PROGMEM = {179, 99, 0};
+static const uint8_t silkLtpGainIcdf0[8] PROGMEM = {71, 56, 43, 30, 21, 12, 6, 0};
+static const uint8_t silkLtpGainIcdf1[16] PROGMEM = {
+    199, 165, 144, 124, 109,  96,  84,  71,  61,  51,  42,  32,  23,  15,   8,   0};
+static const uint8_t silkLtpGainIcdf2[32] PROGMEM = {
+    241, 225, 211, 199, 187, 175, 164, 153, 142, 132, 123, 114, 105,  96,  88,  80,
+     72,  64,  57,  50,  44,  38,  33,  29,  24,  20,  16,  12,   9,   5,   2,   0};
+static const int8_t silkLtpGainVq0[8][5] PROGMEM = {  // LTP filter codebooks, Q7
+    {   4,    6,   24,    7,    5},
+    {   0,    0,    2,    0,    0},
+    {  12,   28,   41,   13,   -4},
+    {  -9,   15,   42,   25,   14},
+    {   1,   -2,   62,   41,   -9},
+    { -10,   37,   65,   -4,    3},
+    {  -6,    4,   66,    7,   -8},
+    {  16,   14,   38,   -3,   33}};
+static const int8_t silkLtpGainVq1[16][5] PROGMEM = {
+    {  13,   22,   39,   23,   12},
+    {  -1,   36,   64,   27,   -6},
+    {  -7,   10,   55,   43,   17},
+    {   1,    1,    8,    1,    1},
+    {   6,  -11,   74,   53,   -9},
+    { -12,   55,   76,  -12,    8},
+    {  -3,    3,   93,   27,   -4},
+    {  26,   39,   59,    3,   -8},
+    {   2,    0,   77,   11,    9},
+    {  -8,   22,   44,   -6,    7},
+    {  40,    9,   26,    3,    9},
+    {  -7,   20,  101,   -7,    4},
+    {   3,   -8,   42,   26,    0},
+    { -15,   33,   68,    2,   23},
+    {  -2,   55,   46,   -2,   15},
+    {   3,   -1,   21,   16,   41}};
+static const int8_t silkLtpGainVq2[32][5] PROGMEM = {
+    {  -6,   27,   61,   39,    5},
+    { -11,   42,   88,    4,    1},
+    {  -2,   60,   65,    6,   -4},
+    {  -1,   -5,   73,   56,    1},
+    {  -9,   19,   94,   29,   -9},
+    {   0,   12,   99,    6,    4},
+    {   8,  -19,  102,   46,  -13},
+    {   3,    2,   13,    3,    2},
+    {   9,  -21,   84,   72,  -18},
+    { -11,   46,  104,  -22,    8},
+    {  18,   38,   48,   23,    0},
+    { -16,   70,   83,  -21,   11},
+    {   5,  -11,  117,   22,   -8},
+    {  -6,   23,  117,  -12,    3},
+    {   3,   -8,   95,   28,    4},
+    { -10,   15,   77,   60,  -15},
+    {  -1,    4,  124,    2,   -4},
+    {   3,   38,   84,   24,  -25},
+    {   2,   13,   42,   13,   31},
+    {  21,   -4,   56,   46,   -1},
+    {  -1,   35,   79,  -13,   19},
+    {  -7,   65,   88,   -9,  -14},
+    {  20,    4,   81,   49,  -29},
+    {  20,    0,   75,    3,  -17},
+    {   5,   -9,   44,   92,   -8},
+    {   1,   -3,   22,   69,   31},
+    {  -6,   95,   41,  -12,    5},
+    {  39,   67,   16,   -4,    1},
+    {   0,   -6,  120,   55,  -36},
+    { -13,   44,  122,    4,  -24},
+    {  81,    5,   11,    3,    7},
+    {   2,    0,    9,   10,   88}};
+static const uint8_t silkRateLevelsIcdf[2][9] PROGMEM = {
+    {241, 190, 178, 132,  87,  74,  41,  14,   0},
+    {223, 193, 157, 140, 106,  57,  39,  18,   0}};
+static const uint8_t silkPulsesPerBlockIcdf[10][18] PROGMEM = {
+    {125,  51,  26,  18,  15,  12,  11,  10,   9,   8,   7,   6,   5,   4,   3,   2,   1,   0},
+    {198, 105,  45,  22,  15,  12,  11,  10,   9,   8,   7,   6,   5,   4,   3,   2,   1,   0},
+    {213, 162, 116,  83,  59,  43,  32,  24,  18,  15,  12,   9,   7,   6,   5,   3,   2,   0},
+    {239, 187, 116,  59,  28,  16,  11,  10,   9,   8,   7,   6,   5,   4,   3,   2,   1,   0},
+    {250, 229, 188, 135,  86,  51,  30,  19,  13,  10,   8,   6,   5,   4,   3,   2,   1,   0},
+    {249, 235, 213, 185, 156, 128, 103,  83,  66,  53,  42,  33,  26,  21,  17,  13,  10,   0},
+    {254, 249, 235, 206, 164, 118,  77,  46,  27,  16,  10,   7,   5,   4,   3,   2,   1,   0},
+    {255, 253, 249, 239, 220, 191, 156, 119,  85,  57,  37,  23,  15,  10,   6,   4,   2,   0},
+    {255, 253, 251, 246, 237, 223, 203, 179, 152, 124,  98,  75,  55,  40,  29,  21,  15,   0},
+    {255, 254, 253, 247, 220, 162, 106,  67,  42,  28,  18,  12,   9,   6,   4,   3,   2,   0}};
+static const uint8_t silkShellCodeTableOffsets[17] PROGMEM = {
+      0,   0,   2,   5,   9,  14,  20,  27,  35,  44,  54,  65,  77,  90, 104, 119, 135};
+static const uint8_t silkShellCodeTable0[152] PROGMEM = {
+    128,   0, 214,  42,   0, 235, 128,  21,   0, 244, 184,  72,  11,   0, 248, 214, 128,  42,   7,
+      0, 248, 225, 170,  80,  25,   5,   0, 251, 236, 198, 126,  54,  18,   3,   0, 250, 238, 211,
+    159,  82,  35,  15,   5,   0, 250, 231, 203, 168, 128,  88,  53,  25,   6,   0, 252, 238, 216,
+    185, 148, 108,  71,  40,  18,   4,   0, 253, 243, 225, 199, 166, 128,  90,  57,  31,  13,   3,
+      0, 254, 246, 233, 212, 183, 147, 109,  73,  44,  23,  10,   2,   0, 255, 250, 240, 223, 198,
+    166, 128,  90,  58,  33,  16,   6,   1,   0, 255, 251, 244, 231, 210, 181, 146, 110,  75,  46,
+     25,  12,   5,   1,   0, 255, 253, 248, 238, 221, 196, 164, 128,  92,  60,  35,  18,   8,   3,
+      1,   0, 255, 253, 249, 242, 229, 208, 180, 146, 110,  76,  48,  27,  14,   7,   3,   1,   0};
+static const uint8_t silkShellCodeTable1[152] PROGMEM = {
+    129,   0, 207,  50,   0, 236, 129,  20,   0, 245, 185,  72,  10,   0, 249, 213, 129,  42,   6,
+      0, 250, 226, 169,  87,  27,   4,   0, 251, 233, 194, 130,  62,  20,   4,   0, 250, 236, 207,
+    160,  99,  47,  17,   3,   0, 255, 240, 217, 182, 131,  81,  41,  11,   1,   0, 255, 254, 233,
+    201, 159, 107,  61,  20,   2,   1,   0, 255, 249, 233, 206, 170, 128,  86,  50,  23,   7,   1,
+      0, 255, 250, 238, 217, 186, 148, 108,  70,  39,  18,   6,   1,   0, 255, 252, 243, 226, 200,
+    166, 128,  90,  56,  30,  13,   4,   1,   0, 255, 252, 245, 231, 209, 180, 146, 110,  76,  47,
+     25,  11,   4,   1,   0, 255, 253, 248, 237, 219, 194, 163, 128,  93,  62,  37,  19,   8,   3,
+      1,   0, 255, 254, 250, 241, 226, 205, 177, 145, 111,  79,  51,  30,  15,   6,   2,   1,   0};
+static const uint8_t silkShellCodeTable2[152] PROGMEM = {
+    129,   0, 203,  54,   0, 234, 129,  23,   0, 245, 184,  73,  10,   0, 250, 215, 129,  41,   5,
+      0, 252, 232, 173,  86,  24,   3,   0, 253, 240, 200, 129,  56,  15,   2,   0, 253, 244, 217,
+    164,  94,  38,  10,   1,   0, 253, 245, 226, 189, 132,  71,  27,   7,   1,   0, 253, 246, 231,
+    203, 159, 105,  56,  23,   6,   1,   0, 255, 248, 235, 213, 179, 133,  85,  47,  19,   5,   1,
+      0, 255, 254, 243, 221, 194, 159, 117,  70,  37,  12,   2,   1,   0, 255, 254, 248, 234, 208,
+    171, 128,  85,  48,  22,   8,   2,   1,   0, 255, 254, 250, 240, 220, 189, 149, 107,  67,  36,
+     16,   6,   2,   1,   0, 255, 254, 251, 243, 227, 201, 166, 128,  90,  55,  29,  13,   5,   2,
+      1,   0, 255, 254, 252, 246, 234, 213, 183, 147, 109,  73,  43,  22,  10,   4,   2,   1,   0};
+static const uint8_t silkShellCodeTable3[152] PROGMEM = {
+    130,   0, 200,  58,   0, 231, 130,  26,   0, 244, 184,  76,  12,   0, 249, 214, 130,  43,   6,
+      0, 252, 232, 173,  87,  24,   3,   0, 253, 241, 203, 131,  56,  14,   2,   0, 254, 246, 221,
+    167,  94,  35,   8,   1,   0, 254, 249, 232, 193, 130,  65,  23,   5,   1,   0, 255, 251, 239,
+    211, 162,  99,  45,  15,   4,   1,   0, 255, 251, 243, 223, 186, 131,  74,  33,  11,   3,   1,
+      0, 255, 252, 245, 230, 202, 158, 105,  57,  24,   8,   2,   1,   0, 255, 253, 247, 235, 214,
+    179, 132,  84,  44,  19,   7,   2,   1,   0, 255, 254, 250, 240, 223, 196, 159, 112,  69,  36,
+     15,   6,   2,   1,   0, 255, 254, 253, 245, 231, 209, 176, 136,  93,  55,  27,  11,   3,   2,
+      1,   0, 255, 254, 253, 252, 239, 221, 194, 158, 117,  76,  42,  18,   4,   3,   2,   1,   0};
+static const uint8_t silkSignIcdf[42] PROGMEM = {
+    254,  49,  67,  77,  82,  93,  99, 198,  11,  18,  24,  31,  36,  45, 255,  46,  66,  78,  87,  94, 104,
+    208,  14,  21,  32,  42,  51,  66, 255,  94, 104, 109, 112, 115, 118, 248,  53,  69,  80,  88,  95, 102};
+static const uint8_t silkNlsfCB1NbMbQ8[320] PROGMEM = {  // first stage NLSF vectors, 10th order
+     12,  35,  60,  83, 108, 132, 157, 180, 206, 228,  15,  32,  55,  77, 101, 125, 151, 175, 201, 225,
+     19,  42,  66,  89, 114, 137, 162, 184, 209, 230,  12,  25,  50,  72,  97, 120, 147, 172, 200, 223,
+     26,  44,  69,  90, 114, 135, 159, 180, 205, 225,  13,  22,  53,  80, 106, 130, 156, 180, 205, 228,
+     15,  25,  44,  64,  90, 115, 142, 168, 196, 222,  19,  24,  62,  82, 100, 120, 145, 168, 190, 214,
+     22,  31,  50,  79, 103, 120, 151, 170, 203, 227,  21,  29,  45,  65, 106, 124, 150, 171, 196, 224,
+     30,  49,  75,  97, 121, 142, 165, 186, 209, 229,  19,  25,  52,  70,  93, 116, 143, 166, 192, 219,
+     26,  34,  62,  75,  97, 118, 145, 167, 194, 217,  25,  33,  56,  70,  91, 113, 143, 165, 196, 223,
+     21,  34,  51,  72,  97, 117, 145, 171, 196, 222,  20,  29,  50,  67,  90, 117, 144, 168, 197, 221,
+     22,  31,  48,  66,  95, 117, 146, 168, 196, 222,  24,  33,  51,  77, 116, 134, 158, 180, 200, 224,
+     21,  28,  70,  87, 106, 124, 149, 170, 194, 217,  26,  33,  53,  64,  83, 117, 152, 173, 204, 225,
+     27,  34,  65,  95, 108, 129, 155, 174, 210, 225,  20,  26,  72,  99, 113, 131, 154, 176, 200, 219,
+     34,  43,  61,  78,  93, 114, 155, 177, 205, 229,  23,  29,  54,  97, 124, 138, 163, 179, 209, 229,
+     30,  38,  56,  89, 118, 129, 158, 178, 200, 231,  21,  29,  49,  63,  85, 111, 142, 163, 193, 222,
+     27,  48,  77, 103, 133, 158, 179, 196, 215, 232,  29,  47,  74,  99, 124, 151, 176, 198, 220, 237,
+     33,  42,  61,  76,  93, 121, 155, 174, 207, 225,  29,  53,  87, 112, 136, 154, 170, 188, 208, 227,
+     24,  30,  52,  84, 131, 150, 166, 186, 203, 229,  37,  48,  64,  84, 104, 118, 156, 177, 201, 230};
+static const int16_t silkNlsfCB1WghtNbMbQ9[320] PROGMEM = {
+    2897, 2314, 2314, 2314, 2287, 2287, 2314, 2300, 2327, 2287,
+    2888, 2580, 2394, 2367, 2314, 2274, 2274, 2274, 2274, 2194,
+    2487, 2340, 2340, 2314, 2314, 2314, 2340, 2340, 2367, 2354,
+    3216, 2766, 2340, 2340, 2314, 2274, 2221, 2207, 2261, 2194,
+    2460, 2474, 2367, 2394, 2394, 2394, 2394, 2367, 2407, 2314,
+    3479, 3056, 2127, 2207, 2274, 2274, 2274, 2287, 2314, 2261,
+    3282, 3141, 2580, 2394, 2247, 2221, 2207, 2194, 2194, 2114,
+    4096, 3845, 2221, 2620, 2620, 2407, 2314, 2394, 2367, 2074,
+    3178, 3244, 2367, 2221, 2553, 2434, 2340, 2314, 2167, 2221,
+    3338, 3488, 2726, 2194, 2261, 2460, 2354, 2367, 2207, 2101,
+    2354, 2420, 2327, 2367, 2394, 2420, 2420, 2420, 2460, 2367,
+    3779, 3629, 2434, 2527, 2367, 2274, 2274, 2300, 2207, 2048,
+    3254, 3225, 2713, 2846, 2447, 2327, 2300, 2300, 2274, 2127,
+    3263, 3300, 2753, 2806, 2447, 2261, 2261, 2247, 2127, 2101,
+    2873, 2981, 2633, 2367, 2407, 2354, 2194, 2247, 2247, 2114,
+    3225, 3197, 2633, 2580, 2274, 2181, 2247, 2221, 2221, 2141,
+    3178, 3310, 2740, 2407, 2274, 2274, 2274, 2287, 2194, 2114,
+    3141, 3272, 2460, 2061, 2287, 2500, 2367, 2487, 2434, 2181,
+    3507, 3282, 2314, 2700, 2647, 2474, 2367, 2394, 2340, 2127,
+    3423, 3535, 3038, 3056, 2300, 1950, 2221, 2274, 2274, 2274,
+    3404, 3366, 2087, 2687, 2873, 2354, 2420, 2274, 2474, 2540,
+    3760, 3488, 1950, 2660, 2897, 2527, 2394, 2367, 2460, 2261,
+    3028, 3272, 2740, 2888, 2740, 2154, 2127, 2287, 2234, 2247,
+    3695, 3657, 2025, 1969, 2660, 2700, 2580, 2500, 2327, 2367,
+    3207, 3413, 2354, 2074, 2888, 2888, 2340, 2487, 2247, 2167,
+    3338, 3366, 2846, 2780, 2327, 2154, 2274, 2287, 2114, 2061,
+    2327, 2300, 2181, 2167, 2181, 2367, 2633, 2700, 2700, 2553,
+    2407, 2434, 2221, 2261, 2221, 2221, 2340, 2420, 2607, 2700,
+    3038, 3244, 2806, 2888, 2474, 2074, 2300, 2314, 2354, 2380,
+    2221, 2154, 2127, 2287, 2500, 2793, 2793, 2620, 2580, 2367,
+    3676, 3713, 2234, 1838, 2181, 2753, 2726, 2673, 2513, 2207,
+    2793, 3160, 2726, 2553, 2846, 2513, 2181, 2394, 2221, 2181};
+static const uint8_t silkNlsfCB1IcdfNbMb[64] PROGMEM = {
+    212, 178, 148, 129, 108,  96,  85,  82,  79,  77,  61,  59,  57,  56,  51,  49,
+     48,  45,  42,  41,  40,  38,  36,  34,  31,  30,  21,  12,  10,   3,   1,   0,
+    255, 245, 244, 236, 233, 225, 217, 203, 190, 176, 175, 161, 149, 136, 125, 114,
+    102,  91,  81,  71,  60,  52,  43,  35,  28,  20,  19,  18,  12,  11,   5,   0};
+static const uint8_t silkNlsfCB2SelectNbMb[160] PROGMEM = {
+     16,   0,   0,   0,   0,  99,  66,  36,  36,  34,  36,  34,  34,  34,  34,  83,  69,  36,  52,  34,
+    116, 102,  70,  68,  68, 176, 102,  68,  68,  34,  65,  85,  68,  84,  36, 116, 141, 152, 139, 170,
+    132, 187, 184, 216, 137, 132, 249, 168, 185, 139, 104, 102, 100,  68,  68, 178, 218, 185, 185, 170,
+    244, 216, 187, 187, 170, 244, 187, 187, 219, 138, 103, 155, 184, 185, 137, 116, 183, 155, 152, 136,
+    132, 217, 184, 184, 170, 164, 217, 171, 155, 139, 244, 169, 184, 185, 170, 164, 216, 223, 218, 138,
+    214, 143, 188, 218, 168, 244, 141, 136, 155, 170, 168, 138, 220, 219, 139, 164, 219, 202, 216, 137,
+    168, 186, 246, 185, 139, 116, 185, 219, 185, 138, 100, 100, 134, 100, 102,  34,  68,  68, 100,  68,
+    168, 203, 221, 218, 168, 167, 154, 136, 104,  70, 164, 246, 171, 137, 139, 137, 155, 218, 219, 139};
+static const uint8_t silkNlsfCB2IcdfNbMb[72] PROGMEM = {
+    255, 254, 253, 238,  14,   3,   2,   1,   0, 255, 254, 252, 218,  35,   3,   2,   1,   0,
+    255, 254, 250, 208,  59,   4,   2,   1,   0, 255, 254, 246, 194,  71,  10,   2,   1,   0,
+    255, 252, 236, 183,  82,   8,   2,   1,   0, 255, 252, 235, 180,  90,  17,   2,   1,   0,
+    255, 248, 224, 171,  97,  30,   4,   1,   0, 255, 254, 236, 173,  95,  37,   7,   1,   0};
+static const uint8_t silkNlsfPredNbMbQ8[18] PROGMEM = {
+    179, 138, 140, 148, 151, 149, 153, 151, 163, 116,  67,  82,  59,  92,  72, 100,  89,  92};
+static const int16_t silkNlsfDeltaMinNbMbQ15[11] PROGMEM = {250, 3, 6, 3, 3, 3, 4, 3, 3, 3, 461};
+static const uint8_t silkNlsfCB1WbQ8[512] PROGMEM = {  // 16th order
+      7,  23,  38,  54,  69,  85, 100, 116, 131, 147, 162, 178, 193, 208, 223, 239,
+     13,  25,  41,  55,  69,  83,  98, 112, 127, 142, 157, 171, 187, 203, 220, 236,
+     15,  21,  34,  51,  61,  78,  92, 106, 126, 136, 152, 167, 185, 205, 225, 240,
+     10,  21,  36,  50,  63,  79,  95, 110, 126, 141, 157, 173, 189, 205, 221, 237,
+     17,  20,  37,  51,  59,  78,  89, 107, 123, 134, 150, 164, 184, 205, 224, 240,
+     10,  15,  32,  51,  67,  81,  96, 112, 129, 142, 158, 173, 189, 204, 220, 236,
+      8,  21,  37,  51,  65,  79,  98, 113, 126, 138, 155, 168, 179, 192, 209, 218,
+     12,  15,  34,  55,  63,  78,  87, 108, 118, 131, 148, 167, 185, 203, 219, 236,
+     16,  19,  32,  36,  56,  79,  91, 108, 118, 136, 154, 171, 186, 204, 220, 237,
+     11,  28,  43,  58,  74,  89, 105, 120, 135, 150, 165, 180, 196, 211, 226, 241,
+      6,  16,  33,  46,  60,  75,  92, 107, 123, 137, 156, 169, 185, 199, 214, 225,
+     11,  19,  30,  44,  57,  74,  89, 105, 121, 135, 152, 169, 186, 202, 218, 234,
+     12,  19,  29,  46,  57,  71,  88, 100, 120, 132, 148, 165, 182, 199, 216, 233,
+     17,  23,  35,  46,  56,  77,  92, 106, 123, 134, 152, 167, 185, 204, 222, 237,
+     14,  17,  45,  53,  63,  75,  89, 107, 115, 132, 151, 171, 188, 206, 221, 240,
+      9,  16,  29,  40,  56,  71,  88, 103, 119, 137, 154, 171, 189, 205, 222, 237,
+     16,  19,  36,  48,  57,  76,  87, 105, 118, 132, 150, 167, 185, 202, 218, 236,
+     12,  17,  29,  54,  71,  81,  94, 104, 126, 136, 149, 164, 182, 201, 221, 237,
+     15,  28,  47,  62,  79,  97, 115, 129, 142, 155, 168, 180, 194, 208, 223, 238,
+      8,  14,  30,  45,  62,  78,  94, 111, 127, 143, 159, 175, 192, 207, 223, 239,
+     17,  30,  49,  62,  79,  92, 107, 119, 132, 145, 160, 174, 190, 204, 220, 235,
+     14,  19,  36,  45,  61,  76,  91, 108, 121, 138, 154, 172, 189, 205, 222, 238,
+     12,  18,  31,  45,  60,  76,  91, 107, 123, 138, 154, 171, 187, 204, 221, 236,
+     13,  17,  31,  43,  53,  70,  83, 103, 114, 131, 149, 167, 185, 203, 220, 237,
+     17,  22,  35,  42,  58,  78,  93, 110, 125, 139, 155, 170, 188, 206, 224, 240,
+      8,  15,  34,  50,  67,  83,  99, 115, 131, 146, 162, 178, 193, 209, 224, 239,
+     13,  16,  41,  66,  73,  86,  95, 111, 128, 137, 150, 163, 183, 206, 225, 241,
+     17,  25,  37,  52,  63,  75,  92, 102, 119, 132, 144, 160, 175, 191, 212, 231,
+     19,  31,  49,  65,  83, 100, 117, 133, 147, 161, 174, 187, 200, 213, 227, 242,
+     18,  31,  52,  68,  88, 103, 117, 126, 138, 149, 163, 177, 192, 207, 223, 239,
+     16,  29,  47,  61,  76,  90, 106, 119, 133, 147, 161, 176, 193, 209, 224, 240,
+     15,  21,  35,  50,  61,  73,  86,  97, 110, 119, 129, 141, 175, 198, 218, 237};
+static const int16_t silkNlsfCB1WghtWbQ9[512] PROGMEM = {
+    3657, 2925, 2925, 2925, 2925, 2925, 2925, 2925, 2925, 2925, 2925, 2925, 2963, 2963, 2925, 2846,
+    3216, 3085, 2972, 3056, 3056, 3010, 3010, 3010, 2963, 2963, 3010, 2972, 2888, 2846, 2846, 2726,
+    3920, 4014, 2981, 3207, 3207, 2934, 3056, 2846, 3122, 3244, 2925, 2846, 2620, 2553, 2780, 2925,
+    3516, 3197, 3010, 3103, 3019, 2888, 2925, 2925, 2925, 2925, 2888, 2888, 2888, 2888, 2888, 2753,
+    5054, 5054, 2934, 3573, 3385, 3056, 3085, 2793, 3160, 3160, 2972, 2846, 2513, 2540, 2753, 2888,
+    4428, 4149, 2700, 2753, 2972, 3010, 2925, 2846, 2981, 3019, 2925, 2925, 2925, 2925, 2888, 2726,
+    3620, 3019, 2972, 3056, 3056, 2873, 2806, 3056, 3216, 3047, 2981, 3291, 3291, 2981, 3310, 2991,
+    5227, 5014, 2540, 3338, 3526, 3385, 3197, 3094, 3376, 2981, 2700, 2647, 2687, 2793, 2846, 2673,
+    5081, 5174, 4615, 4428, 2460, 2897, 3047, 3207, 3169, 2687, 2740, 2888, 2846, 2793, 2846, 2700,
+    3122, 2888, 2963, 2925, 2925, 2925, 2925, 2963, 2963, 2963, 2963, 2925, 2925, 2963, 2963, 2963,
+    4202, 3207, 2981, 3103, 3010, 2888, 2888, 2925, 2972, 2873, 2916, 3019, 2972, 3010, 3197, 2873,
+    3760, 3760, 3244, 3103, 2981, 2888, 2925, 2888, 2972, 2934, 2793, 2793, 2846, 2888, 2888, 2660,
+    3854, 4014, 3207, 3122, 3244, 2934, 3047, 2963, 2963, 3085, 2846, 2793, 2793, 2793, 2793, 2580,
+    3845, 4080, 3357, 3516, 3094, 2740, 3010, 2934, 3122, 3085, 2846, 2846, 2647, 2647, 2846, 2806,
+    5147, 4894, 3225, 3845, 3441, 3169, 2897, 3413, 3451, 2700, 2580, 2673, 2740, 2846, 2806, 2753,
+    4109, 3789, 3291, 3160, 2925, 2888, 2888, 2925, 2793, 2740, 2793, 2740, 2793, 2846, 2888, 2806,
+    5081, 5054, 3047, 3545, 3244, 3056, 3085, 2944, 3103, 2897, 2740, 2740, 2740, 2846, 2793, 2620,
+    4309, 4309, 2860, 2527, 3207, 3376, 3376, 3075, 3075, 3376, 3056, 2846, 2647, 2580, 2726, 2753,
+    3056, 2916, 2806, 2888, 2740, 2687, 2897, 3103, 3150, 3150, 3216, 3169, 3056, 3010, 2963, 2846,
+    4375, 3882, 2925, 2888, 2846, 2888, 2846, 2846, 2888, 2888, 2888, 2846, 2888, 2925, 2888, 2846,
+    2981, 2916, 2916, 2981, 2981, 3056, 3122, 3216, 3150, 3056, 3010, 2972, 2972, 2972, 2925, 2740,
+    4229, 4149, 3310, 3347, 2925, 2963, 2888, 2981, 2981, 2846, 2793, 2740, 2846, 2846, 2846, 2793,
+    4080, 4014, 3103, 3010, 2925, 2925, 2925, 2888, 2925, 2925, 2846, 2846, 2846, 2793, 2888, 2780,
+    4615, 4575, 3169, 3441, 3207, 2981, 2897, 3038, 3122, 2740, 2687, 2687, 2687, 2740, 2793, 2700,
+    4149, 4269, 3789, 3657, 2726, 2780, 2888, 2888, 3010, 2972, 2925, 2846, 2687, 2687, 2793, 2888,
+    4215, 3554, 2753, 2846, 2846, 2888, 2888, 2888, 2925, 2925, 2888, 2925, 2925, 2925, 2963, 2888,
+    5174, 4921, 2261, 3432, 3789, 3479, 3347, 2846, 3310, 3479, 3150, 2897, 2460, 2487, 2753, 2925,
+    3451, 3685, 3122, 3197, 3357, 3047, 3207, 3207, 2981, 3216, 3085, 2925, 2925, 2687, 2540, 2434,
+    2981, 3010, 2793, 2793, 2740, 2793, 2846, 2972, 3056, 3103, 3150, 3150, 3150, 3103, 3010, 3010,
+    2944, 2873, 2687, 2726, 2780, 3010, 3432, 3545, 3357, 3244, 3056, 3010, 2963, 2925, 2888, 2846,
+    3019, 2944, 2897, 3010, 3010, 2972, 3019, 3103, 3056, 3056, 3010, 2888, 2846, 2925, 2925, 2888,
+    3920, 3967, 3010, 3197, 3357, 3216, 3291, 3291, 3479, 3704, 3441, 2726, 2181, 2460, 2580, 2607};
+static const uint8_t silkNlsfCB1IcdfWb[64] PROGMEM = {
+    225, 204, 201, 184, 183, 175, 158, 154, 153, 135, 119, 115, 113, 110, 109,  99,
+     98,  95,  79,  68,  52,  50,  48,  45,  43,  32,  31,  27,  18,  10,   3,   0,
+    255, 251, 235, 230, 212, 201, 196, 182, 167, 166, 163, 151, 138, 124, 110, 104,
+     90,  78,  76,  70,  69,  57,  45,  34,  24,  21,  11,   6,   5,   4,   3,   0};
+static const uint8_t silkNlsfCB2SelectWb[256] PROGMEM = {
+      0,   0,   0,   0,   0,   0,   0,   1, 100, 102, 102,  68,  68,  36,  34,  96,
+    164, 107, 158, 185, 180, 185, 139, 102,  64,  66,  36,  34,  34,   0,   1,  32,
+    208, 139, 141, 191, 152, 185, 155, 104,  96, 171, 104, 166, 102, 102, 102, 132,
+      1,   0,   0,   0,   0,  16,  16,   0,  80, 109,  78, 107, 185, 139, 103, 101,
+    208, 212, 141, 139, 173, 153, 123, 103,  36,   0,   0,   0,   0,   0,   0,   1,
+     48,   0,   0,   0,   0,   0,   0,  32,  68, 135, 123, 119, 119, 103,  69,  98,
+     68, 103, 120, 118, 118, 102,  71,  98, 134, 136, 157, 184, 182, 153, 139, 134,
+    208, 168, 248,  75, 189, 143, 121, 107,  32,  49,  34,  34,  34,   0,  17,   2,
+    210, 235, 139, 123, 185, 137, 105, 134,  98, 135, 104, 182, 100, 183, 171, 134,
+    100,  70,  68,  70,  66,  66,  34, 131,  64, 166, 102,  68,  36,   2,   1,   0,
+    134, 166, 102,  68,  34,  34,  66, 132, 212, 246, 158, 139, 107, 107,  87, 102,
+    100, 219, 125, 122, 137, 118, 103, 132, 114, 135, 137, 105, 171, 106,  50,  34,
+    164, 214, 141, 143, 185, 151, 121, 103, 192,  34,   0,   0,   0,   0,   0,   1,
+    208, 109,  74, 187, 134, 249, 159, 137, 102, 110, 154, 118,  87, 101, 119, 101,
+      0,   2,   0,  36,  36,  66,  68,  35,  96, 164, 102, 100,  36,   0,   2,  33,
+    167, 138, 174, 102, 100,  84,   2,   2, 100, 107, 120, 119,  36, 197,  24,   0};
+static const uint8_t silkNlsfCB2IcdfWb[72] PROGMEM = {
+    255, 254, 253, 244,  12,   3,   2,   1,   0, 255, 254, 252, 224,  38,   3,   2,   1,   0,
+    255, 254, 251, 209,  57,   4,   2,   1,   0, 255, 254, 244, 195,  69,   4,   2,   1,   0,
+    255, 251, 232, 184,  84,   7,   2,   1,   0, 255, 254, 240, 186,  86,  14,   2,   1,   0,
+    255, 254, 239, 178,  91,  30,   5,   1,   0, 255, 248, 227, 177, 100,  19,   2,   1,   0};
+static const uint8_t silkNlsfPredWbQ8[30] PROGMEM = {
+    175, 148, 160, 176, 178, 173, 174, 164, 177, 174, 196, 182, 198, 192, 182,
+     68,  62,  66,  60,  72, 117,  85,  90, 118, 136, 151, 142, 160, 142, 155};
+static const int16_t silkNlsfDeltaMinWbQ15[17] PROGMEM = {
+    100,   3,  40,   3,   3,   3,   5,  14,  14,  10,  11,   3,   8,   9,   7,   3, 347};
+static const int16_t silkLsfCosTabQ12[129] PROGMEM = {  // 2 cos(pi x / 128)
+     8192,  8190,  8182,  8170,  8152,  8130,  8104,  8072,  8034,  7994,  7946,  7896,  7840,  7778,  7714,  7644,
+     7568,  7490,  7406,  7318,  7226,  7128,  7026,  6922,  6812,  6698,  6580,  6458,  6332,  6204,  6070,  5934,
+     5792,  5648,  5502,  5352,  5198,  5040,  4880,  4718,  4552,  4382,  4212,  4038,  3862,  3684,  3502,  3320,
+     3136,  2948,  2760,  2570,  2378,  2186,  1990,  1794,  1598,  1400,  1202,  1002,   802,   602,   402,   202,
+        0,  -202,  -402,  -602,  -802, -1002, -1202, -1400, -1598, -1794, -1990, -2186, -2378, -2570, -2760, -2948,
+    -3136, -3320, -3502, -3684, -3862, -4038, -4212, -4382, -4552, -4718, -4880, -5040, -5198, -5352, -5502, -5648,
+    -5792, -5934, -6070, -6204, -6332, -6458, -6580, -6698, -6812, -6922, -7026, -7128, -7226, -7318, -7406, -7490,
+    -7568, -7644, -7714, -7778, -7840, -7896, -7946, -7994, -8034, -8072, -8104, -8130, -8152, -8170, -8182, -8190,
+    -8192};
+static const uint8_t silkOrdering10[10] PROGMEM = {0, 9, 6, 3, 4, 5, 8, 1, 2, 7};  // cosines in the polynomials
+static const uint8_t silkOrdering16[16] PROGMEM = {0, 15, 8, 7, 4, 11, 12, 3, 2, 13, 10, 5, 6, 9, 14, 1};
+static const int16_t silkResamplerFracFIR12[12][4] PROGMEM = {  // fractional interpolation filter
+    {  189,  -600,   617, 30567},
+    {  117,  -159, -1070, 29704},
+    {   52,   221, -2392, 28276},
+    {   -4,   529, -3350, 26341},
+    {  -48,   758, -3956, 23973},
+    {  -80,   905, -4235, 21254},
+    {  -99,   972, -4222, 18278},
+    { -107,   967, -3957, 15143},
+    { -103,   896, -3487, 11950},
+    {  -91,   773, -2865,  8798},
+    {  -71,   611, -2143,  5784},
+    {  -46,   425, -1375,  2996}};
+static const int16_t silkLtpScalesQ14[3] PROGMEM = {15565, 12288, 8192};
+static const int16_t silkResamplerUp2Hq0[3] PROGMEM = {1746, 14986, -26453};  // allpass coefficients of the 2x
+static const int16_t silkResamplerUp2Hq1[3] PROGMEM = {6854, 25769, -9994};   // upsampler, even and odd samples
+static const uint8_t* const silkLtpGainIcdf[3] = {silkLtpGainIcdf0, silkLtpGainIcdf1, silkLtpGainIcdf2};
+static const int8_t* const silkLtpGainVq[3] = {&silkLtpGainVq0[0][0], &silkLtpGainVq1[0][0], &silkLtpGainVq2[0][0]};
+static const uint8_t* const silkShellCodeTable[4] = {silkShellCodeTable0, silkShellCodeTable1, silkShellCodeTable2,
+                                                     silkShellCodeTable3};
+
+typedef struct SilkNlsfCB {  // NLSF codebook of one bandwidth
+    uint8_t        order;
+    int16_t        quantStepSizeQ16;
+    const uint8_t* cb1NlsfQ8;
+    const int16_t* cb1WghtQ9;
+    const uint8_t* cb1Icdf;
+    const uint8_t* predQ8;
+    const uint8_t* ecSel;
+    const uint8_t* ecIcdf;
+    const int16_t* deltaMinQ15;
+} SilkNlsfCB_t;
+
+static const SilkNlsfCB_t silkNlsfCbNbMb = {10, 11796, silkNlsfCB1NbMbQ8, silkNlsfCB1WghtNbMbQ9, silkNlsfCB1IcdfNbMb,
+                                            silkNlsfPredNbMbQ8, silkNlsfCB2SelectNbMb, silkNlsfCB2IcdfNbMb,
+                                            silkNlsfDeltaMinNbMbQ15};
+static const SilkNlsfCB_t silkNlsfCbWb   = {16, 9830, silkNlsfCB1WbQ8, silkNlsfCB1WghtWbQ9, silkNlsfCB1IcdfWb,
+                                            silkNlsfPredWbQ8, silkNlsfCB2SelectWb, silkNlsfCB2IcdfWb,
+                                            silkNlsfDeltaMinWbQ15};
+//----------------------------------------------------------------------------------------------------------------------
+//          F I X E D   P O I N T   H E L P E R S
+//----------------------------------------------------------------------------------------------------------------------
+static inline __attribute__((always_inline)) int ilog(uint32_t x){  // number of significant bits, EC_ILOG
+    return x ? 32 - __builtin_clz(x) : 0;
+}
+static inline __attribute__((always_inline)) int32_t mulQ15(int32_t a, int32_t b16){
+    return (int32_t)(((int64_t)a * b16) >> 15);
+}
+static inline __attribute__((always_inline)) int16_t mul16Q15(int32_t a16, int32_t b16){
+    return (int16_t)((a16 * b16) >> 15);
+}
+static inline __attribute__((always_inline)) int32_t mul16P15(int32_t a16, int32_t b16){  // rounded
+    return (a16 * b16 + 16384) >> 15;
+}
+static inline __attribute__((always_inline)) int32_t fracMul16(int32_t a, int32_t b){
+    return (16384 + (int32_t)(int16_t)a * (int16_t)b) >> 15;
+}
+static inline __attribute__((always_inline)) int32_t imin(int32_t a, int32_t b){return a < b ? a : b;}
+static inline __attribute__((always_inline)) int32_t imax(int32_t a, int32_t b){return a > b ? a : b;}
+
+static uint32_t isqrt32(uint32_t x){  // floor(sqrt(x))
+    uint32_t r = 0, b = 1UL << 30;
+    while(b > x) b >>= 2;
+    while(b){
+        if(x >= r + b){x -= r + b; r = (r >> 1) + b;}
+        else r >>= 1;
+        b >>= 2;
+    }
+    return r;
+}
+
+static uint32_t invSqrt(uint64_t e, int* sh){
+    // 1 / sqrt(e) = return * 2^-sh, return in [2^29, 2^30], e > 0
+    int l = 63 - __builtin_clzll(e);
+    int s = 60 - l;
+    if(s & 1) s++;
+    uint64_t m = s >= 0 ? e << s : e >> -s;   // [2^60, 2^62)
+    uint64_t r = 0, b = 1ULL << 62;
+    while(b > m) b >>= 2;
+    while(b){
+        if(m >= r + b){m -= r + b; r = (r >> 1) + b;}
+        else r >>= 1;
+        b >>= 2;
+    }
+    *sh = 60 - s / 2;
+    return (uint32_t)((1ULL << 60) / r);
+}
+
+static uint32_t exp2Q30(int32_t x){
+    // 2^x for x <= 1.0 (log2 Q16), result Q30, 0 below 2^-30
+    if(x < -(30 << 16)) return 0;
+    int e = x >> 16;                    // floor
+    int32_t f = x & 0xFFFF;
+    int64_t r = 2034083;                // minimax polynomial of 2^f on [0, 1), Q30, error < 3e-7
+    r = 9599928    + ((r * f) >> 16);
+    r = 59996871   + ((r * f) >> 16);
+    r = 257839529  + ((r * f) >> 16);
+    r = 744271399  + ((r * f) >> 16);
+    r = 1073741824 + ((r * f) >> 16);  // [2^30, 2^31)
+    return e >= 0 ? (uint32_t)(r << e) : (uint32_t)(r >> -e);
+}
+
+static int16_t bitexactCos(int16_t x){  // cos(pi/2 * x / 16384) Q15, the reference's polynomial
+    int32_t tmp = (4096 + ((int32_t)x * x)) >> 13;
+    int16_t x2 = tmp;
+    x2 = (32767 - x2) + fracMul16(x2, (-7651 + fracMul16(x2, (8277 + fracMul16(-626, x2)))));
+    return 1 + x2;
+}
+
+static int bitexactLog2tan(int isin, int icos){
+    int lc = ilog(icos);
+    int ls = ilog(isin);
+    icos <<= 15 - lc;
+    isin <<= 15 - ls;
+    return (ls - lc) * (1 << 11) + fracMul16(isin, fracMul16(isin, -2597) + 7932)
+                                 - fracMul16(icos, fracMul16(icos, -2597) + 7932);
+}
+
+static inline __attribute__((always_inline)) uint32_t lcgRand(uint32_t seed){
+    return 1664525 * seed + 1013904223;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          R A N G E   D E C O D E R   (RFC 6716 section 4.1)
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct RangeDec {
+    const uint8_t* buf;
+    uint32_t storage;
+    uint32_t offs;
+    uint32_t endOffs;
+    uint32_t endWindow;
+    int      nendBits;
+    int      nbitsTotal;
+    uint32_t rng;
+    uint32_t val;
+    uint32_t ext;
+    int      rem;
+    bool     error;
+} RangeDec_t;
+
+#define EC_SYM_BITS   8
+#define EC_CODE_BITS  32
+#define EC_CODE_TOP   (1UL << (EC_CODE_BITS - 1))
+#define EC_CODE_BOT   (EC_CODE_TOP >> EC_SYM_BITS)
+#define EC_CODE_EXTRA ((EC_CODE_BITS - 2) % EC_SYM_BITS + 1)
+#define EC_WINDOW_SIZE 32
+#define EC_UINT_BITS  8
+
+static inline __attribute__((always_inline)) int ecReadByte(RangeDec_t* ec){
+    return ec->offs < ec->storage ? ec->buf[ec->offs++] : 0;
+}
+static inline __attribute__((always_inline)) int ecReadByteFromEnd(RangeDec_t* ec){
+    return ec->endOffs < ec->storage ? ec->buf[ec->storage - ++(ec->endOffs)] : 0;
+}
+static void ecNormalize(RangeDec_t* ec){
+    while(ec->rng <= EC_CODE_BOT){
+        ec->nbitsTotal += EC_SYM_BITS;
+        ec->rng <<= EC_SYM_BITS;
+        int sym = ec->rem;
+        ec->rem = ecReadByte(ec);
+        sym = (sym << EC_SYM_BITS | ec->rem) >> (EC_SYM_BITS - EC_CODE_EXTRA);
+        ec->val = ((ec->val << EC_SYM_BITS) + (0xFF & ~sym)) & (EC_CODE_TOP - 1);
+    }
+}
+static void ecInit(RangeDec_t* ec, const uint8_t* buf, uint32_t storage){
+    ec->buf = buf;
+    ec->storage = storage;
+    ec->endOffs = 0;
+    ec->endWindow = 0;
+    ec->nendBits = 0;
+    ec->nbitsTotal = EC_CODE_BITS + 1 - ((EC_CODE_BITS - EC_CODE_EXTRA) / EC_SYM_BITS) * EC_SYM_BITS;
+    ec->offs = 0;
+    ec->rng = 1UL << EC_CODE_EXTRA;
+    ec->rem = ecReadByte(ec);
+    ec->val = ec->rng - 1 - (ec->rem >> (EC_SYM_BITS - EC_CODE_EXTRA));
+    ec->error = false;
+    ecNormalize(ec);
+}
+static inline uint32_t ecDecode(RangeDec_t* ec, uint32_t ft){
+    ec->ext = ec->rng / ft;
+    uint32_t s = ec->val / ec->ext;
+    return ft - imin(s + 1, ft);
+}
+static inline uint32_t ecDecodeBin(RangeDec_t* ec, int bits){
+    ec->ext = ec->rng >> bits;
+    uint32_t s = ec->val / ec->ext;
+    return (1UL << bits) - imin(s + 1, 1UL << bits);
+}
+static inline void ecUpdate(RangeDec_t* ec, uint32_t fl, uint32_t fh, uint32_t ft){
+    uint32_t s = ec->ext * (ft - fh);
+    ec->val -= s;
+    ec->rng = fl > 0 ? ec->ext * (fh - fl) : ec->rng - s;
+    ecNormalize(ec);
+}
+static int ecBitLogp(RangeDec_t* ec, int logp){  // probability of a one is 1 / (1 << logp)
+    uint32_t r = ec->rng;
+    uint32_t d = ec->val;
+    uint32_t s = r >> logp;
+    int ret = d < s;
+    if(!ret) ec->val = d - s;
+    ec->rng = ret ? s : r - s;
+    ecNormalize(ec);
+    return ret;
+}
+static int ecIcdf(RangeDec_t* ec, const uint8_t* icdf, int ftb){
+    uint32_t s = ec->rng;
+    uint32_t d = ec->val;
+    uint32_t r = s >> ftb;
+    uint32_t t;
+    int ret = -1;
+    do{
+        t = s;
+        s = r * icdf[++ret];
+    } while(d < s);
+    ec->val = d - s;
+    ec->rng = t - s;
+    ecNormalize(ec);
+    return ret;
+}
+static uint32_t ecBits(RangeDec_t* ec, int bits){  // raw bits, read from the end of the frame
+    uint32_t window = ec->endWindow;
+    int available = ec->nendBits;
+    if(available < bits){
+        do{
+            window |= (uint32_t)ecReadByteFromEnd(ec) << available;
+            available += EC_SYM_BITS;
+        } while(available <= EC_WINDOW_SIZE - EC_SYM_BITS);
+    }
+    uint32_t ret = window & ((1UL << bits) - 1);
+    window >>= bits;
+    available -= bits;
+    ec->endWindow = window;
+    ec->nendBits = available;
+    ec->nbitsTotal += bits;
+    return ret;
+}
+static uint32_t ecUint(RangeDec_t* ec, uint32_t ft){  // uniform 0...ft-1, ft > 1
+    ft--;
+    int ftb = ilog(ft);
+    if(ftb > EC_UINT_BITS){
+        ftb -= EC_UINT_BITS;
+        uint32_t ft1 = (ft >> ftb) + 1;
+        uint32_t s = ecDecode(ec, ft1);
+        ecUpdate(ec, s, s + 1, ft1);
+        uint32_t t = s << ftb | ecBits(ec, ftb);
+        if(t <= ft) return t;
+        ec->error = true;
+        return ft;
+    }
+    ft++;
+    uint32_t s = ecDecode(ec, ft);
+    ecUpdate(ec, s, s + 1, ft);
+    return s;
+}
+static inline __attribute__((always_inline)) int32_t ecTell(RangeDec_t* ec){
+    return ec->nbitsTotal - ilog(ec->rng);
+}
+static uint32_t ecTellFrac(RangeDec_t* ec){  // bits used in 1/8 bit
+    uint32_t nbits = ec->nbitsTotal << BITRES;
+    int l = ilog(ec->rng);
+    uint32_t r = ec->rng >> (l - 16);
+    for(int i = BITRES; i-- > 0;){
+        r = r * r >> 15;
+        int b = (int)(r >> 16);
+        l = l << 1 | b;
+        r >>= b;
+    }
+    return nbits - l;
+}
+static int ecLaplace(RangeDec_t* ec, uint32_t fs, int decay){
+    int val = 0;
+    uint32_t fl = 0;
+    uint32_t fm = ecDecodeBin(ec, 15);
+    if(fm >= fs){
+        val++;
+        fl = fs;
+        fs = ((32768 - 2 * 16 - fs) * (int32_t)(16384 - decay) >> 15) + 1;
+        while(fs > 1 && fm >= fl + 2 * fs){
+            fs *= 2;
+            fl += fs;
+            fs = ((fs - 2) * (int32_t)decay) >> 15;
+            fs += 1;
+            val++;
+        }
+        if(fs <= 1){
+            int di = (fm - fl) >> 1;
+            val += di;
+            fl += 2 * di;
+        }
+        if(fm < fl + fs) val = -val;
+        else fl += fs;
+    }
+    ecUpdate(ec, fl, imin(fl + fs, 32768), 32768);
+    return val;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          E N E R G Y
+//----------------------------------------------------------------------------------------------------------------------
+static void unquantCoarseEnergy(RangeDec_t* ec, int start, int end, int32_t* oldE, bool intra, int C, int LM){
+    const uint8_t* probModel = eProbModel[LM][intra];
+    int32_t prev[2] = {0, 0};
+    int32_t coef = intra ? 0 : predCoef[LM];
+    int32_t beta = intra ? betaIntra : betaCoef[LM];
+    int32_t budget = ec->storage * 8;
+    for(int i = start; i < end; i++){
+        for(int c = 0; c < C; c++){
+            int qi;
+            int32_t tell = ecTell(ec);
+            if(budget - tell >= 15){
+                int pi = 2 * imin(i, 20);
+                qi = ecLaplace(ec, probModel[pi] << 7, probModel[pi + 1] << 6);
+            }
+            else if(budget - tell >= 2){
+                qi = ecIcdf(ec, smallEnergyIcdf, 2);
+                qi = (qi >> 1) ^ -(qi & 1);
+            }
+            else if(budget - tell >= 1) qi = -ecBitLogp(ec, 1);
+            else qi = -1;
+            int32_t q = qi * (1 << DB_SHIFT);
+            int32_t* e = &oldE[i + c * OPUS_NB_EBANDS];
+            *e = imax(-(9 << DB_SHIFT), *e);
+            int32_t tmp = mulQ15(*e, coef) + prev[c] + q;
+            *e = imax(-(28 << DB_SHIFT), tmp);
+            prev[c] = prev[c] + q - mulQ15(q, beta);
+        }
+    }
+}
+static void unquantFineEnergy(RangeDec_t* ec, int start, int end, int32_t* oldE, const int* fineQuant, int C){
+    for(int i = start; i < end; i++){
+        if(fineQuant[i] <= 0) continue;
+        for(int c = 0; c < C; c++){
+            int32_t q2 = ecBits(ec, fineQuant[i]);
+            oldE[i + c * OPUS_NB_EBANDS] += (((q2 << DB_SHIFT) + (1 << (DB_SHIFT - 1))) >> fineQuant[i]) - (1 << (DB_SHIFT - 1));
+        }
+    }
+}
+static void unquantEnergyFinalise(RangeDec_t* ec, int start, int end, int32_t* oldE, const int* fineQuant,
+                                  const int* finePriority, int bitsLeft, int C){
+    for(int prio = 0; prio < 2; prio++){
+        for(int i = start; i < end && bitsLeft >= C; i++){
+            if(fineQuant[i] >= MAX_FINE_BITS || finePriority[i] != prio) continue;
+            for(int c = 0; c < C; c++){
+                int32_t q2 = ecBits(ec, 1);
+                oldE[i + c * OPUS_NB_EBANDS] += ((q2 << DB_SHIFT) - (1 << (DB_SHIFT - 1))) >> (fineQuant[i] + 1);
+                bitsLeft--;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          B I T   A L L O C A T I O N
+//----------------------------------------------------------------------------------------------------------------------
+static void initCaps(int* cap, int LM, int C){
+    for(int i = 0; i < OPUS_NB_EBANDS; i++){
+        int N = (eBands[i + 1] - eBands[i]) << LM;
+        cap[i] = (cacheCaps50[OPUS_NB_EBANDS * (2 * LM + C - 1) + i] + 64) * C * N >> 2;
+    }
+}
+
+static int interpBits2Pulses(RangeDec_t* ec, int start, int end, int skipStart, const int* bits1, const int* bits2,
+                             const int* thresh, const int* cap, int32_t total, int32_t* pBalance, int skipRsv,
+                             int* intensity, int intensityRsv, int* dualStereo, int dualStereoRsv, int* bits,
+                             int* ebits, int* finePriority, int C, int LM){
+    int allocFloor = C << BITRES;
+    int stereo = C > 1;
+    int logM = LM << BITRES;
+    int lo = 0, hi = 1 << ALLOC_STEPS;
+    int32_t psum;
+    for(int i = 0; i < ALLOC_STEPS; i++){
+        int mid = (lo + hi) >> 1;
+        psum = 0;
+        bool done = false;
+        for(int j = end; j-- > start;){
+            int tmp = bits1[j] + (mid * (int32_t)bits2[j] >> ALLOC_STEPS);
+            if(tmp >= thresh[j] || done){
+                done = true;
+                psum += imin(tmp, cap[j]);
+            }
+            else if(tmp >= allocFloor) psum += allocFloor;
+        }
+        if(psum > total) hi = mid;
+        else lo = mid;
+    }
+    psum = 0;
+    bool done = false;
+    for(int j = end; j-- > start;){
+        int tmp = bits1[j] + ((int32_t)lo * bits2[j] >> ALLOC_STEPS);
+        if(tmp < thresh[j] && !done) tmp = tmp >= allocFloor ? allocFloor : 0;
+        else done = true;
+        tmp = imin(tmp, cap[j]);
+        bits[j] = tmp;
+        psum += tmp;
+    }
+    int codedBands;
+    for(codedBands = end;; codedBands--){  // decide which bands to skip, working backwards from the end
+        int j = codedBands - 1;
+        if(j <= skipStart){
+            total += skipRsv;
+            break;
+        }
+        int32_t left = total - psum;
+        int32_t percoeff = left / (eBands[codedBands] - eBands[start]);
+        left -= (eBands[codedBands] - eBands[start]) * percoeff;
+        int rem = imax(left - (eBands[j] - eBands[start]), 0);
+        int bandWidth = eBands[codedBands] - eBands[j];
+        int bandBits = (int)(bits[j] + percoeff * bandWidth + rem);
+        if(bandBits >= imax(thresh[j], allocFloor + (1 << BITRES))){
+            if(ecBitLogp(ec, 1)) break;
+            psum += 1 << BITRES;
+            bandBits -= 1 << BITRES;
+        }
+        psum -= bits[j] + intensityRsv;
+        if(intensityRsv > 0) intensityRsv = log2FracTable[j - start];
+        psum += intensityRsv;
+        if(bandBits >= allocFloor){
+            psum += allocFloor;
+            bits[j] = allocFloor;
+        }
+        else bits[j] = 0;
+    }
+    if(intensityRsv > 0) *intensity = start + ecUint(ec, codedBands + 1 - start);
+    else *intensity = 0;
+    if(*intensity <= start){
+        total += dualStereoRsv;
+        dualStereoRsv = 0;
+    }
+    if(dualStereoRsv > 0) *dualStereo = ecBitLogp(ec, 1);
+    else *dualStereo = 0;
+
+    int32_t left = total - psum;  // allocate the remaining bits
+    int32_t percoeff = left / (eBands[codedBands] - eBands[start]);
+    left -= (eBands[codedBands] - eBands[start]) * percoeff;
+    for(int j = start; j < codedBands; j++) bits[j] += (int)percoeff * (eBands[j + 1] - eBands[j]);
+    for(int j = start; j < codedBands; j++){
+        int tmp = (int)imin(left, eBands[j + 1] - eBands[j]);
+        bits[j] += tmp;
+        left -= tmp;
+    }
+    int32_t balance = 0;
+    int j;
+    for(j = start; j < codedBands; j++){
+        int N0 = eBands[j + 1] - eBands[j];
+        int N = N0 << LM;
+        int32_t bit = (int32_t)bits[j] + balance;
+        int32_t excess;
+        if(N > 1){
+            excess = imax(bit - cap[j], 0);
+            bits[j] = bit - excess;
+            int den = C * N + ((C == 2 && N > 2 && !*dualStereo && j < *intensity) ? 1 : 0);
+            int NClogN = den * (logN400[j] + logM);
+            int offset = (NClogN >> 1) - den * FINE_OFFSET;
+            if(N == 2) offset += den << BITRES >> 2;
+            if(bits[j] + offset < den * 2 << BITRES) offset += NClogN >> 2;
+            else if(bits[j] + offset < den * 3 << BITRES) offset += NClogN >> 3;
+            ebits[j] = imax(0, (bits[j] + offset + (den << (BITRES - 1))));
+            ebits[j] = (ebits[j] / den) >> BITRES;
+            if(C * ebits[j] > (bits[j] >> BITRES)) ebits[j] = bits[j] >> stereo >> BITRES;
+            ebits[j] = imin(ebits[j], MAX_FINE_BITS);
+            finePriority[j] = ebits[j] * (den << BITRES) >= bits[j] + offset;
+            bits[j] -= C * ebits[j] << BITRES;
+        }
+        else{  // N = 1, all bits go to fine energy except for a sign bit
+            excess = imax(0, bit - (C << BITRES));
+            bits[j] = bit - excess;
+            ebits[j] = 0;
+            finePriority[j] = 1;
+        }
+        if(excess > 0){  // fine energy can't take advantage of the rebalancing in quantAllBands()
+            int extraFine = imin(excess >> (stereo + BITRES), MAX_FINE_BITS - ebits[j]);
+            ebits[j] += extraFine;
+            int extraBits = extraFine * C << BITRES;
+            finePriority[j] = extraBits >= excess - balance;
+            excess -= extraBits;
+        }
+        balance = excess;
+    }
+    *pBalance = balance;
+    for(; j < end; j++){  // the skipped bands use all their bits for fine energy
+        ebits[j] = bits[j] >> stereo >> BITRES;
+        bits[j] = 0;
+        finePriority[j] = ebits[j] < 1;
+    }
+    return codedBands;
+}
+
+static int computeAllocation(RangeDec_t* ec, int start, int end, const int* offsets, const int* cap, int allocTrim,
+                             int* intensity, int* dualStereo, int32_t total, int32_t* balance, int* pulses,
+                             int* ebits, int* finePriority, int C, int LM){
+    int bits1[OPUS_NB_EBANDS], bits2[OPUS_NB_EBANDS], thresh[OPUS_NB_EBANDS], trimOffset[OPUS_NB_EBANDS];
+    total = imax(total, 0);
+    int skipStart = start;
+    int skipRsv = total >= 1 << BITRES ? 1 << BITRES : 0;  // a bit to signal the end of the skipped bands
+    total -= skipRsv;
+    int intensityRsv = 0, dualStereoRsv = 0;
+    if(C == 2){
+        intensityRsv = log2FracTable[end - start];
+        if(intensityRsv > total) intensityRsv = 0;
+        else{
+            total -= intensityRsv;
+            dualStereoRsv = total >= 1 << BITRES ? 1 << BITRES : 0;
+            total -= dualStereoRsv;
+        }
+    }
+    for(int j = start; j < end; j++){
+        int w = eBands[j + 1] - eBands[j];
+        thresh[j] = imax(C << BITRES, (3 * w << LM << BITRES) >> 4);  // below, no PVQ bits are allocated
+        trimOffset[j] = C * w * (allocTrim - 5 - LM) * (end - j - 1) * (1 << (LM + BITRES)) >> 6;
+        if(w << LM == 1) trimOffset[j] -= C << BITRES;
+    }
+    int lo = 1, hi = NB_ALLOC_VECTORS - 1;
+    do{
+        bool done = false;
+        int32_t psum = 0;
+        int mid = (lo + hi) >> 1;
+        for(int j = end; j-- > start;){
+            int N = eBands[j + 1] - eBands[j];
+            int bitsj = C * N * bandAllocation[mid * OPUS_NB_EBANDS + j] << LM >> 2;
+            if(bitsj > 0) bitsj = imax(0, bitsj + trimOffset[j]);
+            bitsj += offsets[j];
+            if(bitsj >= thresh[j] || done){
+                done = true;
+                psum += imin(bitsj, cap[j]);
+            }
+            else if(bitsj >= C << BITRES) psum += C << BITRES;
+        }
+        if(psum > total) hi = mid - 1;
+        else lo = mid + 1;
+    } while(lo <= hi);
+    hi = lo--;
+    for(int j = start; j < end; j++){
+        int N = eBands[j + 1] - eBands[j];
+        int bits1j = C * N * bandAllocation[lo * OPUS_NB_EBANDS + j] << LM >> 2;
+        int bits2j = hi >= NB_ALLOC_VECTORS ? cap[j] : C * N * bandAllocation[hi * OPUS_NB_EBANDS + j] << LM >> 2;
+        if(bits1j > 0) bits1j = imax(0, bits1j + trimOffset[j]);
+        if(bits2j > 0) bits2j = imax(0, bits2j + trimOffset[j]);
+        if(lo > 0) bits1j += offsets[j];
+        bits2j += offsets[j];
+        if(offsets[j] > 0) skipStart = j;
+        bits2j = imax(0, bits2j - bits1j);
+        bits1[j] = bits1j;
+        bits2[j] = bits2j;
+    }
+    return interpBits2Pulses(ec, start, end, skipStart, bits1, bits2, thresh, cap, total, balance, skipRsv, intensity,
+                             intensityRsv, dualStereo, dualStereoRsv, pulses, ebits, finePriority, C, LM);
+}
+
+static inline __attribute__((always_inline)) int getPulses(int i){
+    return i < 8 ? i : (8 + (i & 7)) << ((i >> 3) - 1);
+}
+static int bits2Pulses(int band, int LM, int bits){
+    const uint8_t* cache = cacheBits50 + cacheIndex50[(LM + 1) * OPUS_NB_EBANDS + band];
+    int lo = 0, hi = cache[0];
+    bits--;
+    for(int i = 0; i < LOG_MAX_PSEUDO; i++){
+        int mid = (lo + hi + 1) >> 1;
+        if((int)cache[mid] >= bits) hi = mid;
+        else lo = mid;
+    }
+    if(bits - (lo == 0 ? -1 : (int)cache[lo]) <= (int)cache[hi] - bits) return lo;
+    return hi;
+}
+static inline __attribute__((always_inline)) int pulses2Bits(int band, int LM, int pulses){
+    const uint8_t* cache = cacheBits50 + cacheIndex50[(LM + 1) * OPUS_NB_EBANDS + band];
+    return pulses == 0 ? 0 : cache[pulses] + 1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          P V Q   ( C W R S   I N D E X   D E C O D I N G )
+//----------------------------------------------------------------------------------------------------------------------
+// U(N, K) rows are built on the fly (no 5KB table), u must hold K + 2 values
+
+static inline void cwrsNext(uint32_t* ui, int len, uint32_t ui0){
+    int j = 1;
+    do{
+        uint32_t ui1 = ui[j] + ui[j - 1] + ui0;
+        ui[j - 1] = ui0;
+        ui0 = ui1;
+    } while(++j < len);
+    ui[j - 1] = ui0;
+}
+static inline void cwrsPrev(uint32_t* ui, int len, uint32_t ui0){
+    int j = 1;
+    do{
+        uint32_t ui1 = ui[j] - ui[j - 1] - ui0;
+        ui[j - 1] = ui0;
+        ui0 = ui1;
+    } while(++j < len);
+    ui[j - 1] = ui0;
+}
+static uint32_t cwrsRow(int N, int K, uint32_t* u){  // returns V(N, K), the number of codewords
+    int len = K + 2;
+    u[0] = 0;
+    u[1] = 1;
+    for(int k = 2; k < len; k++) u[k] = (k << 1) - 1;
+    for(int k = 2; k < N; k++) cwrsNext(u + 1, K + 1, 1);
+    return u[K] + u[K + 1];
+}
+static uint32_t decodePulses(RangeDec_t* ec, int* y, int N, int K){
+    // Return: sum of the squared pulses
+    uint32_t u[130];  // K <= 128
+    uint32_t i = ecUint(ec, cwrsRow(N, K, u));
+    uint32_t yy = 0;
+    int j = 0;
+    do{
+        uint32_t p = u[K + 1];
+        int s = -(i >= p);
+        i -= p & s;
+        int yj = K;
+        p = u[K];
+        while(p > i) p = u[--K];
+        i -= p;
+        yj -= K;
+        y[j] = (yj + s) ^ s;
+        yy += yj * yj;
+        cwrsPrev(u, K + 2, 0);
+    } while(++j < N);
+    return yy;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+static void scaleToGain(int16_t* X, const int* iy, const int16_t* x, int N, uint64_t E, int gain){
+    // X = v * gain / |v| in Q14, v is iy (integers) or x (Q14)
+    int sh;
+    uint32_t r = invSqrt(E, &sh);
+    int64_t g = (int64_t)r * gain;   // 1 / |v| * gain * 2^-(sh + 15)
+    sh += 1;                          // Q15 gain to Q14 output
+    if(iy) for(int i = 0; i < N; i++) X[i] = (int16_t)((iy[i] * g + (1LL << (sh - 1))) >> sh);
+    else   for(int i = 0; i < N; i++) X[i] = (int16_t)((x[i]  * g + (1LL << (sh - 1))) >> sh);
+}
+static void renormalise(int16_t* X, int N, int gain){
+    uint64_t E = 1;
+    for(int i = 0; i < N; i++) E += (int32_t)X[i] * X[i];
+    scaleToGain(X, NULL, X, N, E, gain);
+}
+static void expRotation1(int16_t* X, int len, int stride, int32_t c, int32_t s){
+    int16_t* Xp = X;
+    int32_t ms = -s;
+    for(int i = 0; i < len - stride; i++){
+        int32_t x1 = Xp[0];
+        int32_t x2 = Xp[stride];
+        Xp[stride] = (int16_t)((c * x2 + s * x1 + 16384) >> 15);
+        *Xp++      = (int16_t)((c * x1 + ms * x2 + 16384) >> 15);
+    }
+    Xp = &X[len - 2 * stride - 1];
+    for(int i = len - 2 * stride - 1; i >= 0; i--){
+        int32_t x1 = Xp[0];
+        int32_t x2 = Xp[stride];
+        Xp[stride] = (int16_t)((c * x2 + s * x1 + 16384) >> 15);
+        *Xp--      = (int16_t)((c * x1 + ms * x2 + 16384) >> 15);
+    }
+}
+static void expRotation(int16_t* X, int len, int stride, int K, int spread){  // inverse spreading rotation
+    static const uint8_t spreadFactor[3] = {15, 10, 5};
+    if(2 * K >= len || spread == SPREAD_NONE) return;
+    int factor = spreadFactor[spread - 1];
+    int32_t gain = 32767 * len / (len + factor * K);
+    int32_t theta = ((gain * gain) >> 15) >> 1;
+    int32_t c = bitexactCos(theta >> 1);            // cos(pi/2 * theta)
+    int32_t s = bitexactCos(16384 - (theta >> 1));  // sin(pi/2 * theta)
+    int stride2 = 0;
+    if(len >= 8 * stride){
+        stride2 = 1;
+        while((stride2 * stride2 + stride2) * stride + (stride >> 2) < len) stride2++;
+    }
+    len /= stride;
+    for(int i = 0; i < stride; i++){
+        if(stride2) expRotation1(X + i * len, len, stride2, s, c);
+        expRotation1(X + i * len, len, 1, c, s);
+    }
+}
+static uint32_t algUnquant(RangeDec_t* ec, int16_t* X, int N, int K, int spread, int B, int gain){
+    // Return: collapse mask, a bit for every short block that has pulses
+    int iy[176];
+    uint32_t Ryy = decodePulses(ec, iy, N, K);
+    scaleToGain(X, iy, NULL, N, Ryy, gain);
+    expRotation(X, N, B, K, spread);
+    if(B <= 1) return 1;
+    int N0 = N / B;
+    uint32_t cm = 0;
+    for(int i = 0; i < B; i++){
+        int tmp = 0;
+        for(int j = 0; j < N0; j++) tmp |= iy[i * N0 + j];
+        cm |= (tmp != 0) << i;
+    }
+    return cm;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          B A N D S
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct BandCtx {
+    RangeDec_t* ec;
+    int         i;              // band
+    int         intensity;
+    int         spread;
+    int         tfChange;
+    int32_t     remainingBits;
+    uint32_t    seed;
+    bool        disableInv;
+} BandCtx_t;
+
+typedef struct SplitCtx {
+    int inv;
+    int imid;
+    int iside;
+    int delta;
+    int itheta;
+    int qalloc;
+} SplitCtx_t;
+
+static const uint8_t orderyTable[30] PROGMEM = {
+    1, 0,
+    3, 0, 2, 1,
+    7, 0, 4, 3, 6, 1, 5, 2,
+    15, 0, 8, 7, 12, 3, 11, 4, 14, 1, 9, 6, 13, 2, 10, 5};
+
+static void haar1(int16_t* X, int N0, int stride){
+    N0 >>= 1;
+    for(int i = 0; i < stride; i++){
+        for(int j = 0; j < N0; j++){
+            int32_t tmp1 = 23170 * X[stride * 2 * j + i];
+            int32_t tmp2 = 23170 * X[stride * (2 * j + 1) + i];
+            X[stride * 2 * j + i]       = (int16_t)((tmp1 + tmp2 + 16384) >> 15);
+            X[stride * (2 * j + 1) + i] = (int16_t)((tmp1 - tmp2 + 16384) >> 15);
+        }
+    }
+}
+static void deinterleaveHadamard(int16_t* X, int N0, int stride, bool hadamard){
+    int16_t tmp[176];
+    int N = N0 * stride;
+    if(hadamard){
+        const uint8_t* ordery = orderyTable + stride - 2;
+        for(int i = 0; i < stride; i++)
+            for(int j = 0; j < N0; j++) tmp[ordery[i] * N0 + j] = X[j * stride + i];
+    }
+    else{
+        for(int i = 0; i < stride; i++)
+            for(int j = 0; j < N0; j++) tmp[i * N0 + j] = X[j * stride + i];
+    }
+    memcpy(X, tmp, N * sizeof(int16_t));
+}
+static void interleaveHadamard(int16_t* X, int N0, int stride, bool hadamard){
+    int16_t tmp[176];
+    int N = N0 * stride;
+    if(hadamard){
+        const uint8_t* ordery = orderyTable + stride - 2;
+        for(int i = 0; i < stride; i++)
+            for(int j = 0; j < N0; j++) tmp[j * stride + i] = X[ordery[i] * N0 + j];
+    }
+    else{
+        for(int i = 0; i < stride; i++)
+            for(int j = 0; j < N0; j++) tmp[j * stride + i] = X[i * N0 + j];
+    }
+    memcpy(X, tmp, N * sizeof(int16_t));
+}
+
+static int computeQn(int N, int b, int offset, int pulseCap, bool stereo){
+    static const int16_t exp2Table8[8] = {16384, 17866, 19483, 21247, 23170, 25267, 27554, 30048};
+    int N2 = 2 * N - 1;
+    if(stereo && N == 2) N2--;
+    int qb = (b + N2 * offset) / N2;
+    qb = imin(b - pulseCap - (4 << BITRES), qb);
+    qb = imin(8 << BITRES, qb);
+    if(qb < (1 << BITRES >> 1)) return 1;
+    int qn = exp2Table8[qb & 0x7] >> (14 - (qb >> BITRES));
+    return (qn + 1) >> 1 << 1;
+}
+
+static void computeTheta(BandCtx_t* ctx, SplitCtx_t* sctx, int N, int* b, int B, int B0, int LM, bool stereo,
+                         int* fill){
+    RangeDec_t* ec = ctx->ec;
+    int i = ctx->i;
+    int itheta = 0;
+    int inv = 0;
+    int pulseCap = logN400[i] + LM * (1 << BITRES);
+    int offset = (pulseCap >> 1) - (stereo && N == 2 ? QTHETA_OFFSET_TWOPHASE : QTHETA_OFFSET);
+    int qn = computeQn(N, *b, offset, pulseCap, stereo);
+    if(stereo && i >= ctx->intensity) qn = 1;
+    int32_t tell = ecTellFrac(ec);
+    if(qn != 1){
+        if(stereo && N > 2){  // a step pdf for stereo
+            int p0 = 3;
+            int x0 = qn / 2;
+            int ft = p0 * (x0 + 1) + x0;
+            int fs = ecDecode(ec, ft);
+            int x = fs < (x0 + 1) * p0 ? fs / p0 : x0 + 1 + (fs - (x0 + 1) * p0);
+            ecUpdate(ec, x <= x0 ? p0 * x : (x - 1 - x0) + (x0 + 1) * p0,
+                         x <= x0 ? p0 * (x + 1) : (x - x0) + (x0 + 1) * p0, ft);
+            itheta = x;
+        }
+        else if(B0 > 1 || stereo){  // uniform pdf for the time split
+            itheta = ecUint(ec, qn + 1);
+        }
+        else{  // triangular pdf for the rest
+            int fs, fl;
+            int ft = ((qn >> 1) + 1) * ((qn >> 1) + 1);
+            int fm = ecDecode(ec, ft);
+            if(fm < ((qn >> 1) * ((qn >> 1) + 1) >> 1)){
+                itheta = (isqrt32(8 * (uint32_t)fm + 1) - 1) >> 1;
+                fs = itheta + 1;
+                fl = itheta * (itheta + 1) >> 1;
+            }
+            else{
+                itheta = (2 * (qn + 1) - isqrt32(8 * (uint32_t)(ft - fm - 1) + 1)) >> 1;
+                fs = qn + 1 - itheta;
+                fl = ft - ((qn + 1 - itheta) * (qn + 2 - itheta) >> 1);
+            }
+            ecUpdate(ec, fl, fl + fs, ft);
+        }
+        itheta = itheta * 16384 / qn;
+    }
+    else if(stereo){
+        if(*b > 2 << BITRES && ctx->remainingBits > 2 << BITRES) inv = ecBitLogp(ec, 2);
+        if(ctx->disableInv) inv = 0;  // keeps a mono downmix intact
+        itheta = 0;
+    }
+    int qalloc = ecTellFrac(ec) - tell;
+    *b -= qalloc;
+    int imid, iside, delta;
+    if(itheta == 0){
+        imid = 32767;
+        iside = 0;
+        *fill &= (1 << B) - 1;
+        delta = -16384;
+    }
+    else if(itheta == 16384){
+        imid = 0;
+        iside = 32767;
+        *fill &= ((1 << B) - 1) << B;
+        delta = 16384;
+    }
+    else{
+        imid = bitexactCos(itheta);
+        iside = bitexactCos(16384 - itheta);
+        delta = fracMul16((N - 1) << 7, bitexactLog2tan(iside, imid));  // mid/side allocation of least error
+    }
+    sctx->inv = inv;
+    sctx->imid = imid;
+    sctx->iside = iside;
+    sctx->delta = delta;
+    sctx->itheta = itheta;
+    sctx->qalloc = qalloc;
+}
+
+static uint32_t quantBandN1(BandCtx_t* ctx, int16_t* X, int16_t* Y, int16_t* lowbandOut){
+    int16_t* x = X;
+    int c = 0;
+    do{
+        int sign = 0;
+        if(ctx->remainingBits >= 1 << BITRES){
+            sign = ecBits(ctx->ec, 1);
+            ctx->remainingBits -= 1 << BITRES;
+        }
+        x[0] = sign ? -16384 : 16384;
+        x = Y;
+    } while(++c < 1 + (Y != NULL));
+    if(lowbandOut) lowbandOut[0] = X[0] >> 4;
+    return 1;
+}
+
+static uint32_t quantPartition(BandCtx_t* ctx, int16_t* X, int N, int b, int B, int16_t* lowband, int LM, int gain,
+                               int fill){
+    const uint8_t* cache = cacheBits50 + cacheIndex50[(LM + 1) * OPUS_NB_EBANDS + ctx->i];
+    uint32_t cm = 0;
+    if(LM != -1 && b > cache[cache[0]] + 12 && N > 2){  // we need 1.5 bits more than we can produce, split the band
+        int B0 = B;
+        SplitCtx_t sctx;
+        N >>= 1;
+        int16_t* Y = X + N;
+        LM -= 1;
+        if(B == 1) fill = (fill & 1) | (fill << 1);
+        B = (B + 1) >> 1;
+        computeTheta(ctx, &sctx, N, &b, B, B0, LM, false, &fill);
+        int mid = sctx.imid;
+        int side = sctx.iside;
+        int delta = sctx.delta;
+        int itheta = sctx.itheta;
+        if(B0 > 1 && (itheta & 0x3FFF)){  // give more bits to low-energy MDCTs than they would otherwise deserve
+            if(itheta > 8192) delta -= delta >> (4 - LM);
+            else delta = imin(0, delta + (N << BITRES >> (5 - LM)));
+        }
+        int mbits = imax(0, imin(b, (b - delta) / 2));
+        int sbits = b - mbits;
+        ctx->remainingBits -= sctx.qalloc;
+        int16_t* nextLowband2 = lowband ? lowband + N : NULL;
+        int32_t rebalance = ctx->remainingBits;
+        if(mbits >= sbits){
+            cm = quantPartition(ctx, X, N, mbits, B, lowband, LM, mul16P15(gain, mid), fill);
+            rebalance = mbits - (rebalance - ctx->remainingBits);
+            if(rebalance > 3 << BITRES && itheta != 0) sbits += rebalance - (3 << BITRES);
+            cm |= quantPartition(ctx, Y, N, sbits, B, nextLowband2, LM, mul16P15(gain, side), fill >> B) << (B0 >> 1);
+        }
+        else{
+            cm = quantPartition(ctx, Y, N, sbits, B, nextLowband2, LM, mul16P15(gain, side), fill >> B) << (B0 >> 1);
+            rebalance = sbits - (rebalance - ctx->remainingBits);
+            if(rebalance > 3 << BITRES && itheta != 16384) mbits += rebalance - (3 << BITRES);
+            cm |= quantPartition(ctx, X, N, mbits, B, lowband, LM, mul16P15(gain, mid), fill);
+        }
+        return cm;
+    }
+    int q = bits2Pulses(ctx->i, LM, b);
+    int currBits = pulses2Bits(ctx->i, LM, q);
+    ctx->remainingBits -= currBits;
+    while(ctx->remainingBits < 0 && q > 0){  // never bust the budget
+        ctx->remainingBits += currBits;
+        q--;
+        currBits = pulses2Bits(ctx->i, LM, q);
+        ctx->remainingBits -= currBits;
+    }
+    if(q != 0) return algUnquant(ctx->ec, X, N, getPulses(q), ctx->spread, B, gain);
+
+    uint32_t cmMask = (1UL << B) - 1;  // no pulse, fill the band anyway
+    fill &= cmMask;
+    if(!fill){
+        memset(X, 0, N * sizeof(int16_t));
+        return 0;
+    }
+    if(lowband == NULL){  // noise
+        for(int j = 0; j < N; j++){
+            ctx->seed = lcgRand(ctx->seed);
+            X[j] = (int16_t)((int32_t)ctx->seed >> 20);
+        }
+        cm = cmMask;
+    }
+    else{  // folded spectrum, the noise is about 48dB below the folding level
+        for(int j = 0; j < N; j++){
+            ctx->seed = lcgRand(ctx->seed);
+            X[j] = lowband[j] + ((ctx->seed & 0x8000) ? 4 : -4);
+        }
+        cm = fill;
+    }
+    renormalise(X, N, gain);
+    return cm;
+}
+
+static uint32_t quantBand(BandCtx_t* ctx, int16_t* X, int N, int b, int B, int16_t* lowband, int LM,
+                          int16_t* lowbandOut, int gain, int16_t* lowbandScratch, int fill){
+    static const uint8_t bitInterleaveTable[16] = {0, 1, 1, 1, 2, 3, 3, 3, 2, 3, 3, 3, 2, 3, 3, 3};
+    static const uint8_t bitDeinterleaveTable[16] = {
+        0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F, 0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF};
+    int N0 = N;
+    int NB = N;
+    int B0 = B;
+    int timeDivide = 0;
+    int recombine = 0;
+    bool longBlocks = B0 == 1;
+    int tfChange = ctx->tfChange;
+    NB /= B;
+    if(N == 1) return quantBandN1(ctx, X, NULL, lowbandOut);
+    if(tfChange > 0) recombine = tfChange;
+    if(lowbandScratch && lowband && (recombine || ((NB & 1) == 0 && tfChange < 0) || B0 > 1)){
+        memcpy(lowbandScratch, lowband, N * sizeof(int16_t));
+        lowband = lowbandScratch;
+    }
+    for(int k = 0; k < recombine; k++){  // band recombining to increase the frequency resolution
+        if(lowband) haar1(lowband, N >> k, 1 << k);
+        fill = bitInterleaveTable[fill & 0xF] | bitInterleaveTable[fill >> 4] << 2;
+    }
+    B >>= recombine;
+    NB <<= recombine;
+    while((NB & 1) == 0 && tfChange < 0){  // increasing the time resolution
+        if(lowband) haar1(lowband, NB, B);
+        fill |= fill << B;
+        B <<= 1;
+        NB >>= 1;
+        timeDivide++;
+        tfChange++;
+    }
+    B0 = B;
+    int NB0 = NB;
+    if(B0 > 1 && lowband) deinterleaveHadamard(lowband, NB >> recombine, B0 << recombine, longBlocks);
+
+    uint32_t cm = quantPartition(ctx, X, N, b, B, lowband, LM, gain, fill);
+
+    if(B0 > 1) interleaveHadamard(X, NB >> recombine, B0 << recombine, longBlocks);
+    NB = NB0;
+    B = B0;
+    for(int k = 0; k < timeDivide; k++){  // undo the time-frequency changes
+        B >>= 1;
+        NB <<= 1;
+        cm |= cm >> B;
+        haar1(X, NB, B);
+    }
+    for(int k = 0; k < recombine; k++){
+        cm = bitDeinterleaveTable[cm];
+        haar1(X, N0 >> k, 1 << k);
+    }
+    B <<= recombine;
+    if(lowbandOut){  // scale the output for later folding
+        int32_t n = isqrt32(N0 << 22);
+        for(int j = 0; j < N0; j++) lowbandOut[j] = mul16Q15(n, X[j]);
+    }
+    return cm & ((1 << B) - 1);
+}
+
+static void stereoMerge(int16_t* X, int16_t* Y, int mid, int N){
+    int64_t xp = 0, side = 0;
+    for(int j = 0; j < N; j++){
+        xp   += (int32_t)Y[j] * X[j];
+        side += (int32_t)Y[j] * Y[j];
+    }
+    xp = (mid * xp) >> 15;  // compensating for the mid normalization
+    int64_t mid2 = mid >> 1;
+    int64_t El = mid2 * mid2 + side - 2 * xp;
+    int64_t Er = mid2 * mid2 + side + 2 * xp;
+    if(Er < 161061 || El < 161061){  // 6e-4 Q28
+        memcpy(Y, X, N * sizeof(int16_t));
+        return;
+    }
+    int shl, shr;
+    int64_t lgain = invSqrt(El, &shl);
+    int64_t rgain = invSqrt(Er, &shr);
+    shl -= 14;
+    shr -= 14;
+    for(int j = 0; j < N; j++){
+        int32_t l = mul16P15(mid, X[j]);  // the side is already scaled
+        int32_t r = Y[j];
+        X[j] = (int16_t)(((l - r) * lgain + (1LL << (shl - 1))) >> shl);
+        Y[j] = (int16_t)(((l + r) * rgain + (1LL << (shr - 1))) >> shr);
+    }
+}
+
+static uint32_t quantBandStereo(BandCtx_t* ctx, int16_t* X, int16_t* Y, int N, int b, int B, int16_t* lowband,
+                                int LM, int16_t* lowbandOut, int16_t* lowbandScratch, int fill){
+    if(N == 1) return quantBandN1(ctx, X, Y, lowbandOut);
+    SplitCtx_t sctx;
+    int origFill = fill;
+    uint32_t cm;
+    computeTheta(ctx, &sctx, N, &b, B, B, LM, true, &fill);
+    int mid = sctx.imid;
+    int side = sctx.iside;
+    int itheta = sctx.itheta;
+    if(N == 2){  // mid and side are orthogonal, the side needs one bit only
+        int sbits = (itheta != 0 && itheta != 16384) ? 1 << BITRES : 0;
+        int mbits = b - sbits;
+        int c = itheta > 8192;
+        ctx->remainingBits -= sctx.qalloc + sbits;
+        int16_t* x2 = c ? Y : X;
+        int16_t* y2 = c ? X : Y;
+        int sign = 0;
+        if(sbits) sign = ecBits(ctx->ec, 1);
+        sign = 1 - 2 * sign;
+        // orig_fill: the side is folded even if itheta == 16384 cleared the low bits of fill
+        cm = quantBand(ctx, x2, N, mbits, B, lowband, LM, lowbandOut, 32767, lowbandScratch, origFill);
+        y2[0] = -sign * x2[1];
+        y2[1] = sign * x2[0];
+        X[0] = mul16Q15(mid, X[0]);
+        X[1] = mul16Q15(mid, X[1]);
+        Y[0] = mul16Q15(side, Y[0]);
+        Y[1] = mul16Q15(side, Y[1]);
+        int16_t tmp = X[0];
+        X[0] = tmp - Y[0];
+        Y[0] = tmp + Y[0];
+        tmp = X[1];
+        X[1] = tmp - Y[1];
+        Y[1] = tmp + Y[1];
+    }
+    else{
+        int mbits = imax(0, imin(b, (b - sctx.delta) / 2));
+        int sbits = b - mbits;
+        ctx->remainingBits -= sctx.qalloc;
+        int32_t rebalance = ctx->remainingBits;
+        // the mid is not scaled, it is needed normalized for later folding. The high bits of fill are always zero
+        // in a stereo split, the side is not folded
+        if(mbits >= sbits){
+            cm = quantBand(ctx, X, N, mbits, B, lowband, LM, lowbandOut, 32767, lowbandScratch, fill);
+            rebalance = mbits - (rebalance - ctx->remainingBits);
+            if(rebalance > 3 << BITRES && itheta != 0) sbits += rebalance - (3 << BITRES);
+            cm |= quantBand(ctx, Y, N, sbits, B, NULL, LM, NULL, side, NULL, fill >> B);
+        }
+        else{
+            cm = quantBand(ctx, Y, N, sbits, B, NULL, LM, NULL, side, NULL, fill >> B);
+            rebalance = sbits - (rebalance - ctx->remainingBits);
+            if(rebalance > 3 << BITRES && itheta != 16384) mbits += rebalance - (3 << BITRES);
+            cm |= quantBand(ctx, X, N, mbits, B, lowband, LM, lowbandOut, 32767, lowbandScratch, fill);
+        }
+        stereoMerge(X, Y, mid, N);
+    }
+    if(sctx.inv) for(int j = 0; j < N; j++) Y[j] = -Y[j];
+    return cm;
+}
+
+static void quantAllBands(RangeDec_t* ec, int start, int end, int16_t* X_, int16_t* Y_, uint8_t* collapseMasks,
+                          const int* pulses, bool shortBlocks, int spread, int dualStereo, int intensity,
+                          const int* tfRes, int32_t totalBits, int32_t balance, int LM, int codedBands,
+                          uint32_t* seed, bool disableInv, int16_t* norm){
+    int M = 1 << LM;
+    int B = shortBlocks ? M : 1;
+    int C = Y_ ? 2 : 1;
+    int normOffset = M * eBands[start];  // norm holds the bands from the start band on
+    int16_t* norm2 = norm + M * eBands[OPUS_NB_EBANDS - 1] - normOffset;
+    int16_t* lowbandScratch = X_ + M * eBands[OPUS_NB_EBANDS - 1];  // the last band is decoded last
+    int lowbandOffset = 0;
+    bool updateLowband = true;
+    BandCtx_t ctx;
+    ctx.ec = ec;
+    ctx.intensity = intensity;
+    ctx.spread = spread;
+    ctx.seed = *seed;
+    ctx.disableInv = disableInv;
+    for(int i = start; i < end; i++){
+        ctx.i = i;
+        bool last = (i == end - 1);
+        int16_t* X = X_ + M * eBands[i];
+        int16_t* Y = Y_ ? Y_ + M * eBands[i] : NULL;
+        int N = M * eBands[i + 1] - M * eBands[i];
+        int32_t tell = ecTellFrac(ec);
+        if(i != start) balance -= tell;
+        ctx.remainingBits = totalBits - tell - 1;
+        int b = 0;
+        if(i <= codedBands - 1){
+            int32_t currBalance = balance / imin(3, codedBands - i);
+            b = imax(0, imin(16383, imin(ctx.remainingBits + 1, pulses[i] + currBalance)));
+        }
+        if((M * eBands[i] - N >= normOffset || i == start + 1) && (updateLowband || lowbandOffset == 0)) lowbandOffset = i;
+        if(i == start + 1){  // enough of the first band to fold the second one (hybrid), nothing for CELT only
+            int n1 = M * (eBands[start + 1] - eBands[start]);
+            int n2 = M * (eBands[start + 2] - eBands[start + 1]);
+            memcpy(&norm[n1], &norm[2 * n1 - n2], (n2 - n1) * sizeof(int16_t));
+            if(dualStereo) memcpy(&norm2[n1], &norm2[2 * n1 - n2], (n2 - n1) * sizeof(int16_t));
+        }
+        int tfChange = tfRes[i];
+        ctx.tfChange = tfChange;
+        if(last) lowbandScratch = NULL;
+        int effectiveLowband = -1;
+        uint32_t xcm, ycm;
+        if(lowbandOffset != 0 && (spread != SPREAD_AGGRESSIVE || B > 1 || tfChange < 0)){
+            // a conservative estimate of the collapse masks of the bands we fold from
+            effectiveLowband = imax(0, M * eBands[lowbandOffset] - normOffset - N);
+            int foldStart = lowbandOffset;
+            while(M * eBands[--foldStart] > effectiveLowband + normOffset);
+            int foldEnd = lowbandOffset - 1;
+            while(++foldEnd < i && M * eBands[foldEnd] < effectiveLowband + normOffset + N);
+            xcm = ycm = 0;
+            int foldI = foldStart;
+            do{
+                xcm |= collapseMasks[foldI * C + 0];
+                ycm |= collapseMasks[foldI * C + C - 1];
+            } while(++foldI < foldEnd);
+        }
+        else xcm = ycm = (1 << B) - 1;  // the LCG folds, all blocks are (almost always) non-zero
+        if(dualStereo && i == intensity){  // switch off dual stereo to do intensity
+            dualStereo = 0;
+            for(int j = 0; j < M * eBands[i] - normOffset; j++) norm[j] = (norm[j] + norm2[j]) >> 1;
+        }
+        if(dualStereo){
+            xcm = quantBand(&ctx, X, N, b / 2, B, effectiveLowband != -1 ? norm + effectiveLowband : NULL, LM,
+                            last ? NULL : norm + M * eBands[i] - normOffset, 32767, lowbandScratch, xcm);
+            ycm = quantBand(&ctx, Y, N, b / 2, B, effectiveLowband != -1 ? norm2 + effectiveLowband : NULL, LM,
+                            last ? NULL : norm2 + M * eBands[i] - normOffset, 32767, lowbandScratch, ycm);
+        }
+        else{
+            if(Y) xcm = quantBandStereo(&ctx, X, Y, N, b, B, effectiveLowband != -1 ? norm + effectiveLowband : NULL,
+                                        LM, last ? NULL : norm + M * eBands[i] - normOffset, lowbandScratch, xcm | ycm);
+            else  xcm = quantBand(&ctx, X, N, b, B, effectiveLowband != -1 ? norm + effectiveLowband : NULL, LM,
+                                  last ? NULL : norm + M * eBands[i] - normOffset, 32767, lowbandScratch, xcm | ycm);
+            ycm = xcm;
+        }
+        collapseMasks[i * C + 0] = (uint8_t)xcm;
+        collapseMasks[i * C + C - 1] = (uint8_t)ycm;
+        balance += pulses[i] + tell;
+        updateLowband = b > (N << BITRES);  // the folding position follows as long as there is 1 bit/sample depth
+    }
+    *seed = ctx.seed;
+}
+
+static void antiCollapse(int16_t* X_, const uint8_t* collapseMasks, int LM, int C, int size, int start, int end,
+                         const int32_t* logE, const int32_t* prev1LogE, const int32_t* prev2LogE, const int* pulses,
+                         uint32_t seed){
+    for(int i = start; i < end; i++){
+        int N0 = eBands[i + 1] - eBands[i];
+        int depth = ((1 + pulses[i]) / N0) >> LM;  // 1/8 bit
+        uint32_t thresh = exp2Q30(-(depth << (DB_SHIFT - BITRES)) - (1 << DB_SHIFT));
+        int sh;
+        uint32_t sqrt1 = invSqrt(N0 << LM, &sh);
+        sqrt1 >>= sh - 15;                          // 1 / sqrt(N0 << LM), Q15
+        for(int c = 0; c < C; c++){
+            int32_t prev1 = prev1LogE[c * OPUS_NB_EBANDS + i];
+            int32_t prev2 = prev2LogE[c * OPUS_NB_EBANDS + i];
+            if(C == 1){
+                prev1 = imax(prev1, prev1LogE[OPUS_NB_EBANDS + i]);
+                prev2 = imax(prev2, prev2LogE[OPUS_NB_EBANDS + i]);
+            }
+            int32_t Ediff = imax(0, logE[c * OPUS_NB_EBANDS + i] - imin(prev1, prev2));
+            // short blocks don't have the energy of long blocks, r is doubled (2.8 times for LM 3)
+            uint64_t r = exp2Q30(-Ediff + (1 << DB_SHIFT));
+            if(LM == 3) r = (r * 46341) >> 15;
+            if(r > thresh) r = thresh;
+            int16_t r14 = (int16_t)((r * sqrt1) >> 31);
+            int16_t* X = X_ + c * size + (eBands[i] << LM);
+            bool renorm = false;
+            for(int k = 0; k < 1 << LM; k++){
+                if(collapseMasks[i * C + c] & 1 << k) continue;
+                for(int j = 0; j < N0; j++){  // the block collapsed, fill it with noise
+                    seed = lcgRand(seed);
+                    X[(j << LM) + k] = (seed & 0x8000) ? r14 : -r14;
+                }
+                renorm = true;
+            }
+            if(renorm) renormalise(X, N0 << LM, 32767);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          S Y N T H E S I S
+//----------------------------------------------------------------------------------------------------------------------
+static void denormaliseBands(const int16_t* X, int32_t* freq, const int32_t* bandLogE, int start, int end, int M,
+                             bool silence){
+    int N = M * SHORT_MDCT_SIZE;
+    if(silence) start = end = 0;
+    int bound = M * eBands[end];
+    memset(freq, 0, M * eBands[start] * sizeof(int32_t));
+    for(int i = start; i < end; i++){
+        int32_t lg = bandLogE[i] + (eMeans[i] << (DB_SHIFT - 4));
+        int e = lg >> DB_SHIFT;
+        int sh = 32 - e;                             // freq = X * 2^lg in Q12: X(Q14) * mant(Q30) >> (32 - e)
+        if(sh < 12) sh = 12;                         // a band 32 times louder than full scale, corrupt
+        int32_t mant = sh < 63 ? exp2Q30(lg & 0xFFFF) : 0;
+        for(int j = M * eBands[i]; j < M * eBands[i + 1]; j++){
+            int64_t f = sh < 63 ? ((int64_t)X[j] * mant) >> sh : 0;
+            freq[j] = f > SIG_SAT ? SIG_SAT : f < -SIG_SAT ? -SIG_SAT : (int32_t)f;
+        }
+    }
+    memset(freq + bound, 0, (N - bound) * sizeof(int32_t));
+}
+
+typedef struct {int32_t r, i;} cpx_t;
+
+static inline __attribute__((always_inline)) void cmul(cpx_t& out, const cpx_t& a, const int16_t* tw){
+    out.r = mulQ15(a.r, tw[0]) - mulQ15(a.i, tw[1]);
+    out.i = mulQ15(a.r, tw[1]) + mulQ15(a.i, tw[0]);
+}
+
+static void bfly2(cpx_t* F, int fstride, int m){
+    cpx_t* F2 = F + m;
+    for(int u = 0; u < m; u++){
+        cpx_t t;
+        cmul(t, F2[u], &fftTwiddles[2 * u * fstride]);
+        F2[u].r = F[u].r - t.r;
+        F2[u].i = F[u].i - t.i;
+        F[u].r += t.r;
+        F[u].i += t.i;
+    }
+}
+static void bfly3(cpx_t* F, int fstride, int m){
+    int32_t epi3i = fftTwiddles[2 * fstride * m + 1];
+    for(int u = 0; u < m; u++){
+        cpx_t s0, s1, s2, s3;
+        cmul(s1, F[u + m],     &fftTwiddles[2 * u * fstride]);
+        cmul(s2, F[u + 2 * m], &fftTwiddles[4 * u * fstride]);
+        s3.r = s1.r + s2.r;
+        s3.i = s1.i + s2.i;
+        s0.r = s1.r - s2.r;
+        s0.i = s1.i - s2.i;
+        F[u + m].r = F[u].r - (s3.r >> 1);
+        F[u + m].i = F[u].i - (s3.i >> 1);
+        s0.r = mulQ15(s0.r, epi3i);
+        s0.i = mulQ15(s0.i, epi3i);
+        F[u].r += s3.r;
+        F[u].i += s3.i;
+        F[u + 2 * m].r = F[u + m].r + s0.i;
+        F[u + 2 * m].i = F[u + m].i - s0.r;
+        F[u + m].r -= s0.i;
+        F[u + m].i += s0.r;
+    }
+}
+static void bfly4(cpx_t* F, int fstride, int m){
+    for(int u = 0; u < m; u++){
+        cpx_t s0, s1, s2, s3, s4, s5;
+        cmul(s0, F[u + m],     &fftTwiddles[2 * u * fstride]);
+        cmul(s1, F[u + 2 * m], &fftTwiddles[4 * u * fstride]);
+        cmul(s2, F[u + 3 * m], &fftTwiddles[6 * u * fstride]);
+        s5.r = F[u].r - s1.r;
+        s5.i = F[u].i - s1.i;
+        F[u].r += s1.r;
+        F[u].i += s1.i;
+        s3.r = s0.r + s2.r;
+        s3.i = s0.i + s2.i;
+        s4.r = s0.r - s2.r;
+        s4.i = s0.i - s2.i;
+        F[u + 2 * m].r = F[u].r - s3.r;
+        F[u + 2 * m].i = F[u].i - s3.i;
+        F[u].r += s3.r;
+        F[u].i += s3.i;
+        F[u + m].r     = s5.r + s4.i;
+        F[u + m].i     = s5.i - s4.r;
+        F[u + 3 * m].r = s5.r - s4.i;
+        F[u + 3 * m].i = s5.i + s4.r;
+    }
+}
+static void bfly5(cpx_t* F, int fstride, int m){
+    const int16_t* ya = &fftTwiddles[2 * fstride * m];
+    const int16_t* yb = &fftTwiddles[4 * fstride * m];
+    cpx_t* F0 = F;
+    cpx_t* F1 = F + m;
+    cpx_t* F2 = F + 2 * m;
+    cpx_t* F3 = F + 3 * m;
+    cpx_t* F4 = F + 4 * m;
+    for(int u = 0; u < m; u++){
+        cpx_t s0 = F0[u], s1, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11, s12;
+        cmul(s1, F1[u], &fftTwiddles[2 * u * fstride]);
+        cmul(s2, F2[u], &fftTwiddles[4 * u * fstride]);
+        cmul(s3, F3[u], &fftTwiddles[6 * u * fstride]);
+        cmul(s4, F4[u], &fftTwiddles[8 * u * fstride]);
+        s7.r  = s1.r + s4.r;  s7.i  = s1.i + s4.i;
+        s10.r = s1.r - s4.r;  s10.i = s1.i - s4.i;
+        s8.r  = s2.r + s3.r;  s8.i  = s2.i + s3.i;
+        s9.r  = s2.r - s3.r;  s9.i  = s2.i - s3.i;
+        F0[u].r += s7.r + s8.r;
+        F0[u].i += s7.i + s8.i;
+        s5.r = s0.r + mulQ15(s7.r, ya[0]) + mulQ15(s8.r, yb[0]);
+        s5.i = s0.i + mulQ15(s7.i, ya[0]) + mulQ15(s8.i, yb[0]);
+        s6.r =  mulQ15(s10.i, ya[1]) + mulQ15(s9.i, yb[1]);
+        s6.i = -mulQ15(s10.r, ya[1]) - mulQ15(s9.r, yb[1]);
+        F1[u].r = s5.r - s6.r;  F1[u].i = s5.i - s6.i;
+        F4[u].r = s5.r + s6.r;  F4[u].i = s5.i + s6.i;
+        s11.r = s0.r + mulQ15(s7.r, yb[0]) + mulQ15(s8.r, ya[0]);
+        s11.i = s0.i + mulQ15(s7.i, yb[0]) + mulQ15(s8.i, ya[0]);
+        s12.r = -mulQ15(s10.i, yb[1]) + mulQ15(s9.i, ya[1]);
+        s12.i =  mulQ15(s10.r, yb[1]) - mulQ15(s9.r, ya[1]);
+        F2[u].r = s11.r + s12.r;  F2[u].i = s11.i + s12.i;
+        F3[u].r = s11.r - s12.r;  F3[u].i = s11.i - s12.i;
+    }
+}
+static void fftWork(cpx_t* out, const cpx_t* in, int fstride, const uint8_t* factors, int twMul){
+    // recursive decimation in time, the twiddles of the 480 point table are used with the step twMul
+    int p = factors[0];
+    int m = factors[1];
+    if(m == 1){
+        for(int j = 0; j < p; j++) out[j] = in[j * fstride];
+    }
+    else{
+        for(int j = 0; j < p; j++) fftWork(out + j * m, in + j * fstride, fstride * p, factors + 2, twMul);
+    }
+    switch(p){
+        case 2: bfly2(out, fstride * twMul, m); break;
+        case 3: bfly3(out, fstride * twMul, m); break;
+        case 4: bfly4(out, fstride * twMul, m); break;
+        case 5: bfly5(out, fstride * twMul, m); break;
+    }
+}
+
+static void imdct(const int32_t* in, int32_t* out, int shift, int stride, int32_t* fftBuf){
+    // inverse MDCT of N / 2 = 960 >> shift coefficients (every stride-th of in), windowed, overlap added to out
+    int N = 1920 >> shift;
+    int N2 = N >> 1;
+    int N4 = N >> 2;
+    const int16_t* t = mdctTrig + mdctTrigOffset[shift];
+    cpx_t* f = (cpx_t*)fftBuf;
+    const int32_t* xp1 = in;
+    const int32_t* xp2 = in + stride * (N2 - 1);
+    for(int i = 0; i < N4; i++){  // pre-rotate, real and imaginary swapped, a forward FFT does the inverse
+        f[i].r = mulQ15(*xp1, t[i]) - mulQ15(*xp2, t[N4 + i]);
+        f[i].i = mulQ15(*xp2, t[i]) + mulQ15(*xp1, t[N4 + i]);
+        xp1 += 2 * stride;
+        xp2 -= 2 * stride;
+    }
+    fftWork((cpx_t*)(out + (OPUS_OVERLAP >> 1)), f, 1, fftFactors[shift], 1 << shift);
+
+    int32_t* yp0 = out + (OPUS_OVERLAP >> 1);  // post-rotate and de-shuffle from both ends, in place
+    int32_t* yp1 = out + (OPUS_OVERLAP >> 1) + N2 - 2;
+    for(int i = 0; i < (N4 + 1) >> 1; i++){
+        int32_t re = yp0[1];
+        int32_t im = yp0[0];
+        int32_t yr = mulQ15(re, t[i]) + mulQ15(im, t[N4 + i]);
+        int32_t yi = mulQ15(re, t[N4 + i]) - mulQ15(im, t[i]);
+        re = yp1[1];
+        im = yp1[0];
+        yp0[0] = yr;
+        yp1[1] = yi;
+        int32_t t0 = t[N4 - i - 1];
+        int32_t t1 = t[N2 - i - 1];
+        yr = mulQ15(re, t0) + mulQ15(im, t1);
+        yi = mulQ15(re, t1) - mulQ15(im, t0);
+        yp1[0] = yr;
+        yp0[1] = yi;
+        yp0 += 2;
+        yp1 -= 2;
+    }
+    for(int i = 0; i < OPUS_OVERLAP / 2; i++){  // mirror on both sides for TDAC
+        int32_t x1 = out[OPUS_OVERLAP - 1 - i];
+        int32_t x2 = out[i];
+        int32_t w1 = celtWindow[i];
+        int32_t w2 = celtWindow[OPUS_OVERLAP - 1 - i];
+        out[i] = mulQ15(x2, w2) - mulQ15(x1, w1);
+        out[OPUS_OVERLAP - 1 - i] = mulQ15(x2, w1) + mulQ15(x1, w2);
+    }
+}
+
+static void combFilter(int32_t* x, int T0, int T1, int N, int g0, int g1, int tapset0, int tapset1){
+    // pitch postfilter, in place (IIR), crossfades from the old to the new parameters over the overlap
+    if(g0 == 0 && g1 == 0) return;
+    T0 = imax(T0, COMBFILTER_MINPERIOD);
+    T1 = imax(T1, COMBFILTER_MINPERIOD);
+    int32_t g00 = mul16P15(g0, combGains[tapset0][0]);
+    int32_t g01 = mul16P15(g0, combGains[tapset0][1]);
+    int32_t g02 = mul16P15(g0, combGains[tapset0][2]);
+    int32_t g10 = mul16P15(g1, combGains[tapset1][0]);
+    int32_t g11 = mul16P15(g1, combGains[tapset1][1]);
+    int32_t g12 = mul16P15(g1, combGains[tapset1][2]);
+    int32_t x1 = x[-T1 + 1];
+    int32_t x2 = x[-T1];
+    int32_t x3 = x[-T1 - 1];
+    int32_t x4 = x[-T1 - 2];
+    int overlap = (g0 == g1 && T0 == T1 && tapset0 == tapset1) ? 0 : OPUS_OVERLAP;  // no change, no crossfade
+    int i;
+    for(i = 0; i < overlap; i++){
+        int32_t x0 = x[i - T1 + 2];
+        int32_t f = mul16Q15(celtWindow[i], celtWindow[i]);
+        int32_t y = x[i]
+                  + mulQ15(x[i - T0], mul16Q15(32767 - f, g00))
+                  + mulQ15(x[i - T0 + 1] + x[i - T0 - 1], mul16Q15(32767 - f, g01))
+                  + mulQ15(x[i - T0 + 2] + x[i - T0 - 2], mul16Q15(32767 - f, g02))
+                  + mulQ15(x2, mul16Q15(f, g10))
+                  + mulQ15(x1 + x3, mul16Q15(f, g11))
+                  + mulQ15(x0 + x4, mul16Q15(f, g12));
+        x[i] = imax(-SIG_SAT, imin(SIG_SAT, y));
+        x4 = x3;
+        x3 = x2;
+        x2 = x1;
+        x1 = x0;
+    }
+    if(g1 == 0) return;
+    for(; i < N; i++){  // the part with the constant filter
+        int32_t x0 = x[i - T1 + 2];
+        int32_t y = x[i] + mulQ15(x2, g10) + mulQ15(x1 + x3, g11) + mulQ15(x0 + x4, g12);
+        x[i] = imax(-SIG_SAT, imin(SIG_SAT, y));
+        x4 = x3;
+        x3 = x2;
+        x2 = x1;
+        x1 = x0;
+    }
+}
+
+static void deemphasis(int32_t** in, int16_t* pcm, int N, int CC, int32_t* mem, int32_t gainQ16){
+    // the output gain of the OpusHead is applied here
+    for(int c = 0; c < CC; c++){
+        const int32_t* x = in[c];
+        int16_t* y = pcm + c;
+        int32_t m = mem[c];
+        for(int j = 0; j < N; j++){
+            int32_t tmp = x[j] + m;
+            m = mulQ15(tmp, 27853);
+            int64_t s = gainQ16 ? ((int64_t)tmp * gainQ16) >> 16 : tmp;
+            s = (s + (1 << (SIG_SHIFT - 1))) >> SIG_SHIFT;
+            y[j * CC] = s > 32767 ? 32767 : s < -32768 ? -32768 : (int16_t)s;
+        }
+        mem[c] = m;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          C E L T   F R A M E
+//----------------------------------------------------------------------------------------------------------------------
+static void tfDecode(RangeDec_t* ec, int start, int end, bool isTransient, int* tfRes, int LM){
+    uint32_t budget = ec->storage * 8;
+    uint32_t tell = ecTell(ec);
+    int logp = isTransient ? 2 : 4;
+    int tfSelectRsv = LM > 0 && tell + logp + 1 <= budget;
+    budget -= tfSelectRsv;
+    int tfChanged = 0, curr = 0;
+    for(int i = start; i < end; i++){
+        if(tell + logp <= budget){
+            curr ^= ecBitLogp(ec, logp);
+            tell = ecTell(ec);
+            tfChanged |= curr;
+        }
+        tfRes[i] = curr;
+        logp = isTransient ? 4 : 5;
+    }
+    int tfSelect = 0;
+    if(tfSelectRsv && tfSelectTable[LM][4 * isTransient + 0 + tfChanged] != tfSelectTable[LM][4 * isTransient + 2 + tfChanged]){
+        tfSelect = ecBitLogp(ec, 1);
+    }
+    for(int i = start; i < end; i++) tfRes[i] = tfSelectTable[LM][4 * isTransient + 2 * tfSelect + tfRes[i]];
+}
+
+static void celtReset(){
+    for(int c = 0; c < OPUS_MAX_CHANNELS; c++){
+        memset(m_dec->decodeMem[c], 0, (OPUS_DECODE_BUFFER + OPUS_OVERLAP) * sizeof(int32_t));
+        m_dec->preemphMem[c] = 0;
+    }
+    for(int i = 0; i < 2 * OPUS_NB_EBANDS; i++){
+        m_dec->oldBandE[i] = 0;
+        m_dec->oldLogE[i] = m_dec->oldLogE2[i] = -(28 << DB_SHIFT);
+    }
+    m_dec->rng = 0;
+    m_dec->pfPeriod = m_dec->pfPeriodOld = 0;
+    m_dec->pfGain = m_dec->pfGainOld = 0;
+    m_dec->pfTapset = m_dec->pfTapsetOld = 0;
+}
+
+static int8_t celtDecode(RangeDec_t* ec, const uint8_t* data, int len, int16_t* pcm, int LM, int C, int start, int end){
+    // one CELT frame of 120 << LM samples, data == NULL: the frame is lost. ec: the range decoder the SILK layer of a
+    // hybrid frame has used (start 17), NULL for CELT only
+    // Return: ERR_OPUS_NONE or ERR_OPUS_FRAME_CORRUPT, the samples are output in both cases
+    int CC = m_dec->channels;
+    int M = 1 << LM;
+    int N = M * SHORT_MDCT_SIZE;
+    int32_t* outSyn[OPUS_MAX_CHANNELS];
+    for(int c = 0; c < CC; c++) outSyn[c] = m_dec->decodeMem[c] + OPUS_DECODE_BUFFER - N;
+
+    if(data == NULL){  // no concealment, the last frame decays through the overlap and the postfilter
+        for(int c = 0; c < CC; c++){
+            memmove(m_dec->decodeMem[c], m_dec->decodeMem[c] + N, (OPUS_DECODE_BUFFER - N + OPUS_OVERLAP / 2) * sizeof(int32_t));
+            denormaliseBands(m_dec->X, m_dec->freq, m_dec->oldBandE, start, end, M, true);
+            imdct(m_dec->freq, outSyn[c], 3 - LM, 1, m_dec->fftBuf);
+            combFilter(outSyn[c], m_dec->pfPeriod, m_dec->pfPeriod, N, m_dec->pfGain, m_dec->pfGain,
+                       m_dec->pfTapset, m_dec->pfTapset);
+        }
+        deemphasis(outSyn, pcm, N, CC, m_dec->preemphMem, m_dec->gainQ16);
+        m_dec->pfGainOld = m_dec->pfGain;
+        return ERR_OPUS_NONE;
+    }
+
+    RangeDec_t dec;
+    if(!ec){
+        ec = &dec;
+        ecInit(ec, data, len);
+    }
+    int32_t* oldBandE = m_dec->oldBandE;
+    if(C == 1){
+        for(int i = 0; i < OPUS_NB_EBANDS; i++) oldBandE[i] = imax(oldBandE[i], oldBandE[OPUS_NB_EBANDS + i]);
+    }
+    int32_t totalBits = len * 8;
+    int32_t tell = ecTell(ec);
+    bool silence;
+    if(tell >= totalBits) silence = true;
+    else if(tell == 1) silence = ecBitLogp(ec, 15);
+    else silence = false;
+    if(silence){  // pretend all remaining bits are read
+        tell = len * 8;
+        ec->nbitsTotal += tell - ecTell(ec);
+    }
+    int pfGain = 0, pfPitch = 0, pfTapset = 0;
+    if(start == 0 && tell + 16 <= totalBits){
+        if(ecBitLogp(ec, 1)){
+            int octave = ecUint(ec, 6);
+            pfPitch = (16 << octave) + ecBits(ec, 4 + octave) - 1;
+            int qg = ecBits(ec, 3);
+            if(ecTell(ec) + 2 <= totalBits) pfTapset = ecIcdf(ec, tapsetIcdf, 2);
+            pfGain = 3072 * (qg + 1);  // 0.09375 Q15
+        }
+        tell = ecTell(ec);
+    }
+    bool isTransient = false;
+    if(LM > 0 && tell + 3 <= totalBits){
+        isTransient = ecBitLogp(ec, 3);
+        tell = ecTell(ec);
+    }
+    bool intra = tell + 3 <= totalBits ? ecBitLogp(ec, 3) : false;
+    unquantCoarseEnergy(ec, start, end, oldBandE, intra, C, LM);
+
+    int tfRes[OPUS_NB_EBANDS];
+    tfDecode(ec, start, end, isTransient, tfRes, LM);
+    tell = ecTell(ec);
+    int spread = SPREAD_NORMAL;
+    if(tell + 4 <= totalBits) spread = ecIcdf(ec, spreadIcdf, 5);
+
+    int cap[OPUS_NB_EBANDS], offsets[OPUS_NB_EBANDS];
+    initCaps(cap, LM, C);
+    int dynallocLogp = 6;
+    totalBits <<= BITRES;
+    tell = ecTellFrac(ec);
+    for(int i = start; i < end; i++){
+        int width = C * (eBands[i + 1] - eBands[i]) << LM;
+        int quanta = imin(width << BITRES, imax(6 << BITRES, width));  // 6 bits, at most 1 and at least 1/8 bit/sample
+        int loopLogp = dynallocLogp;
+        int boost = 0;
+        while(tell + (loopLogp << BITRES) < totalBits && boost < cap[i]){
+            int flag = ecBitLogp(ec, loopLogp);
+            tell = ecTellFrac(ec);
+            if(!flag) break;
+            boost += quanta;
+            totalBits -= quanta;
+            loopLogp = 1;
+        }
+        offsets[i] = boost;
+        if(boost > 0) dynallocLogp = imax(2, dynallocLogp - 1);
+    }
+    int allocTrim = tell + (6 << BITRES) <= totalBits ? ecIcdf(ec, trimIcdf, 7) : 5;
+    int32_t bits = (((int32_t)len * 8) << BITRES) - ecTellFrac(ec) - 1;
+    int antiCollapseRsv = isTransient && LM >= 2 && bits >= ((LM + 2) << BITRES) ? (1 << BITRES) : 0;
+    bits -= antiCollapseRsv;
+
+    int pulses[OPUS_NB_EBANDS], fineQuant[OPUS_NB_EBANDS], finePriority[OPUS_NB_EBANDS];
+    int intensity = 0, dualStereo = 0;
+    int32_t balance = 0;
+    int codedBands = computeAllocation(ec, start, end, offsets, cap, allocTrim, &intensity, &dualStereo, bits, &balance,
+                                       pulses, fineQuant, finePriority, C, LM);
+    unquantFineEnergy(ec, start, end, oldBandE, fineQuant, C);
+
+    for(int c = 0; c < CC; c++){
+        memmove(m_dec->decodeMem[c], m_dec->decodeMem[c] + N, (OPUS_DECODE_BUFFER - N + OPUS_OVERLAP / 2) * sizeof(int32_t));
+    }
+    uint8_t collapseMasks[2 * OPUS_NB_EBANDS];
+    int16_t* X = m_dec->X;
+    quantAllBands(ec, start, end, X, C == 2 ? X + N : NULL, collapseMasks, pulses, isTransient, spread, dualStereo, intensity,
+                  tfRes, len * (8 << BITRES) - antiCollapseRsv, balance, LM, codedBands, &m_dec->rng,
+                  CC == 1, m_dec->norm);
+    bool antiCollapseOn = false;
+    if(antiCollapseRsv > 0) antiCollapseOn = ecBits(ec, 1);
+    unquantEnergyFinalise(ec, start, end, oldBandE, fineQuant, finePriority, len * 8 - ecTell(ec), C);
+    if(antiCollapseOn) antiCollapse(X, collapseMasks, LM, C, N, start, end, oldBandE, m_dec->oldLogE, m_dec->oldLogE2,
+                                    pulses, m_dec->rng);
+    if(silence){
+        for(int i = 0; i < C * OPUS_NB_EBANDS; i++) oldBandE[i] = -(28 << DB_SHIFT);
+    }
+
+    // synthesis
+    int B = isTransient ? M : 1;
+    int NB = isTransient ? SHORT_MDCT_SIZE : N;
+    int shift = isTransient ? MAX_LM : MAX_LM - LM;
+    int32_t* freq = m_dec->freq;
+    if(CC == 2 && C == 1){  // a mono frame to two channels, the IMDCT keeps its input
+        denormaliseBands(X, freq, oldBandE, start, end, M, silence);
+        for(int c = 0; c < 2; c++)
+            for(int b = 0; b < B; b++) imdct(freq + b, outSyn[c] + NB * b, shift, B, m_dec->fftBuf);
+    }
+    else if(CC == 1 && C == 2){  // downmix, the output buffer holds the second channel for a while
+        int32_t* freq2 = outSyn[0] + OPUS_OVERLAP / 2;
+        denormaliseBands(X, freq, oldBandE, start, end, M, silence);
+        denormaliseBands(X + N, freq2, oldBandE + OPUS_NB_EBANDS, start, end, M, silence);
+        for(int i = 0; i < N; i++) freq[i] = (freq[i] >> 1) + (freq2[i] >> 1);
+        for(int b = 0; b < B; b++) imdct(freq + b, outSyn[0] + NB * b, shift, B, m_dec->fftBuf);
+    }
+    else{
+        for(int c = 0; c < CC; c++){
+            denormaliseBands(X + c * N, freq, oldBandE + c * OPUS_NB_EBANDS, start, end, M, silence);
+            for(int b = 0; b < B; b++) imdct(freq + b, outSyn[c] + NB * b, shift, B, m_dec->fftBuf);
+        }
+    }
+    for(int c = 0; c < CC; c++){  // saturate, the postfilter can't overflow
+        for(int i = 0; i < N; i++) outSyn[c][i] = imax(-SIG_SAT, imin(SIG_SAT, outSyn[c][i]));
+    }
+    for(int c = 0; c < CC; c++){
+        m_dec->pfPeriod = imax(m_dec->pfPeriod, COMBFILTER_MINPERIOD);
+        m_dec->pfPeriodOld = imax(m_dec->pfPeriodOld, COMBFILTER_MINPERIOD);
+        combFilter(outSyn[c], m_dec->pfPeriodOld, m_dec->pfPeriod, SHORT_MDCT_SIZE, m_dec->pfGainOld, m_dec->pfGain,
+                   m_dec->pfTapsetOld, m_dec->pfTapset);
+        if(LM != 0) combFilter(outSyn[c] + SHORT_MDCT_SIZE, m_dec->pfPeriod, pfPitch, N - SHORT_MDCT_SIZE,
+                               m_dec->pfGain, pfGain, m_dec->pfTapset, pfTapset);
+    }
+    m_dec->pfPeriodOld = m_dec->pfPeriod;
+    m_dec->pfGainOld = m_dec->pfGain;
+    m_dec->pfTapsetOld = m_dec->pfTapset;
+    m_dec->pfPeriod = pfPitch;
+    m_dec->pfGain = pfGain;
+    m_dec->pfTapset = pfTapset;
+    if(LM != 0){
+        m_dec->pfPeriodOld = m_dec->pfPeriod;
+        m_dec->pfGainOld = m_dec->pfGain;
+        m_dec->pfTapsetOld = m_dec->pfTapset;
+    }
+
+    if(C == 1) memcpy(&oldBandE[OPUS_NB_EBANDS], oldBandE, OPUS_NB_EBANDS * sizeof(int32_t));
+    if(!isTransient){
+        memcpy(m_dec->oldLogE2, m_dec->oldLogE, 2 * OPUS_NB_EBANDS * sizeof(int32_t));
+        memcpy(m_dec->oldLogE, oldBandE, 2 * OPUS_NB_EBANDS * sizeof(int32_t));
+    }
+    else{
+        for(int i = 0; i < 2 * OPUS_NB_EBANDS; i++) m_dec->oldLogE[i] = imin(m_dec->oldLogE[i], oldBandE[i]);
+    }
+    for(int c = 0; c < 2; c++){  // clear the bands below the start and above the end band
+        for(int i = 0; i < OPUS_NB_EBANDS; i++){
+            if(i >= start && i < end) continue;
+            oldBandE[c * OPUS_NB_EBANDS + i] = 0;
+            m_dec->oldLogE[c * OPUS_NB_EBANDS + i] = m_dec->oldLogE2[c * OPUS_NB_EBANDS + i] = -(28 << DB_SHIFT);
+        }
+    }
+    m_dec->rng = ec->rng;
+    deemphasis(outSyn, pcm, N, CC, m_dec->preemphMem, m_dec->gainQ16);
+    if(ecTell(ec) > 8 * len || ec->error) return ERR_OPUS_FRAME_CORRUPT;
+    return ERR_OPUS_NONE;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          S I L K   A R I T H M E T I C   (the macros of the reference, silk/SigProc_FIX.h)
+//----------------------------------------------------------------------------------------------------------------------
+static inline __attribute__((always_inline)) int32_t smulwb(int32_t a, int32_t b){  // (a * (int16)b) >> 16
+    return (int32_t)(((int64_t)a * (int16_t)b) >> 16);
+}
+static inline __attribute__((always_inline)) int32_t smulww(int32_t a, int32_t b){  // (a * b) >> 16
+    return (int32_t)(((int64_t)a * b) >> 16);
+}
+static inline __attribute__((always_inline)) int32_t smmul(int32_t a, int32_t b){   // (a * b) >> 32
+    return (int32_t)(((int64_t)a * b) >> 32);
+}
+static inline __attribute__((always_inline)) int32_t smulbb(int32_t a, int32_t b){
+    return (int32_t)(int16_t)a * (int16_t)b;
+}
+static inline __attribute__((always_inline)) int32_t rshiftRound(int32_t a, int sh){
+    return sh == 1 ? (a >> 1) + (a & 1) : ((a >> (sh - 1)) + 1) >> 1;
+}
+static inline __attribute__((always_inline)) int64_t rshiftRound64(int64_t a, int sh){
+    return ((a >> (sh - 1)) + 1) >> 1;
+}
+static inline __attribute__((always_inline)) int32_t lshift32(int32_t a, int sh){  // wraps like the reference
+    return (int32_t)((uint32_t)a << sh);
+}
+static inline __attribute__((always_inline)) int32_t limit32(int32_t a, int32_t lim1, int32_t lim2){
+    if(lim1 > lim2) return a > lim1 ? lim1 : a < lim2 ? lim2 : a;
+    return a > lim2 ? lim2 : a < lim1 ? lim1 : a;
+}
+static inline __attribute__((always_inline)) int16_t sat16(int32_t a){
+    return a > 32767 ? 32767 : a < -32768 ? -32768 : (int16_t)a;
+}
+static inline __attribute__((always_inline)) int32_t lshiftSat32(int32_t a, int sh){
+    return lshift32(limit32(a, INT32_MIN >> sh, INT32_MAX >> sh), sh);
+}
+static inline __attribute__((always_inline)) int32_t addSat32(int32_t a, int32_t b){
+    int64_t s = (int64_t)a + b;
+    return s > INT32_MAX ? INT32_MAX : s < INT32_MIN ? INT32_MIN : (int32_t)s;
+}
+static inline __attribute__((always_inline)) int32_t subSat32(int32_t a, int32_t b){
+    int64_t s = (int64_t)a - b;
+    return s > INT32_MAX ? INT32_MAX : s < INT32_MIN ? INT32_MIN : (int32_t)s;
+}
+static inline __attribute__((always_inline)) int clz32(int32_t x){
+    return x ? __builtin_clz((uint32_t)x) : 32;
+}
+static int32_t inverse32VarQ(int32_t b32, int qRes){  // 1 / b32 in Q qRes
+    int bHeadrm = clz32(abs(b32)) - 1;
+    int32_t bNrm = lshift32(b32, bHeadrm);
+    int32_t bInv = (INT32_MAX >> 2) / (bNrm >> 16);
+    int32_t result = lshift32(bInv, 16);
+    int32_t errQ32 = lshift32((1 << 29) - smulwb(bNrm, bInv), 3);
+    result += smulww(errQ32, bInv);
+    int sh = 61 - bHeadrm - qRes;
+    if(sh <= 0) return lshiftSat32(result, -sh);
+    return sh < 32 ? result >> sh : 0;
+}
+static int32_t div32VarQ(int32_t a32, int32_t b32, int qRes){  // a32 / b32 in Q qRes
+    int aHeadrm = clz32(abs(a32)) - 1;
+    int32_t aNrm = lshift32(a32, aHeadrm);
+    int bHeadrm = clz32(abs(b32)) - 1;
+    int32_t bNrm = lshift32(b32, bHeadrm);
+    int32_t bInv = (INT32_MAX >> 2) / (bNrm >> 16);
+    int32_t result = smulwb(aNrm, bInv);
+    aNrm = (int32_t)((uint32_t)aNrm - ((uint32_t)smmul(bNrm, result) << 3));
+    result += smulwb(aNrm, bInv);
+    int sh = 29 + aHeadrm - bHeadrm - qRes;
+    if(sh < 0) return lshiftSat32(result, -sh);
+    return sh < 32 ? result >> sh : 0;
+}
+static int32_t silkLog2Lin(int32_t inLogQ7){  // 2^(in / 128)
+    if(inLogQ7 < 0) return 0;
+    if(inLogQ7 >= 3967) return INT32_MAX;
+    int32_t out = 1 << (inLogQ7 >> 7);
+    int32_t frac = inLogQ7 & 0x7F;
+    int32_t poly = frac + smulwb(smulbb(frac, 128 - frac), -174);  // piecewise parabolic
+    if(inLogQ7 < 2048) return out + ((out * poly) >> 7);
+    return out + (out >> 7) * poly;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          S I L K   P A R A M E T E R S   (RFC 6716 section 4.2.7)
+//----------------------------------------------------------------------------------------------------------------------
+enum : uint8_t {SILK_NO_VOICE, SILK_UNVOICED, SILK_VOICED};
+enum : uint8_t {SILK_CODE_INDEPENDENTLY, SILK_CODE_INDEPENDENTLY_NO_LTP_SCALING, SILK_CODE_CONDITIONALLY};
+
+typedef struct SilkIndices {  // side information of one SILK frame as coded
+    int8_t   gainsIndices[4];
+    int8_t   ltpIndex[4];
+    int8_t   nlsfIndices[SILK_MAX_ORDER + 1];
+    int16_t  lagIndex;
+    int8_t   contourIndex;
+    int8_t   signalType;
+    int8_t   quantOffsetType;
+    int8_t   nlsfInterpCoefQ2;
+    int8_t   perIndex;
+    int8_t   ltpScaleIndex;
+    int8_t   seed;
+} SilkIndices_t;
+
+typedef struct SilkControl {  // the parameters decoded from the indices
+    int32_t  gainsQ16[4];
+    int16_t  predCoefQ12[2][SILK_MAX_ORDER];   // first and second half of the frame
+    int16_t  ltpCoefQ14[4 * 5];
+    int      pitchL[4];
+    int32_t  ltpScaleQ14;
+} SilkControl_t;
+
+static inline const SilkNlsfCB_t* silkNlsfCB(const SilkChannel_t* ch){
+    return ch->lpcOrder == 16 ? &silkNlsfCbWb : &silkNlsfCbNbMb;
+}
+
+static void silkNlsfUnpack(int16_t* ecIx, uint8_t* predQ8, const SilkNlsfCB_t* cb, int cb1Index){
+    // entropy table offsets and predictor coefficients of the second stage
+    const uint8_t* ecSel = cb->ecSel + cb1Index * cb->order / 2;
+    for(int i = 0; i < cb->order; i += 2){
+        int entry = *ecSel++;
+        ecIx[i]       = ((entry >> 1) & 7) * 9;
+        predQ8[i]     = cb->predQ8[i + (entry & 1) * (cb->order - 1)];
+        ecIx[i + 1]   = ((entry >> 5) & 7) * 9;
+        predQ8[i + 1] = cb->predQ8[i + ((entry >> 4) & 1) * (cb->order - 1) + 1];
+    }
+}
+
+static void silkDecodeIndices(SilkChannel_t* ch, RangeDec_t* ec, SilkIndices_t* idx, bool voiceActivity,
+                              int condCoding){
+    int ix = voiceActivity ? ecIcdf(ec, silkTypeOffsetVadIcdf, 8) + 2 : ecIcdf(ec, silkTypeOffsetNoVadIcdf, 8);
+    idx->signalType = ix >> 1;
+    idx->quantOffsetType = ix & 1;
+    if(condCoding == SILK_CODE_CONDITIONALLY) idx->gainsIndices[0] = ecIcdf(ec, silkDeltaGainIcdf, 8);
+    else{
+        idx->gainsIndices[0] = ecIcdf(ec, silkGainIcdf[idx->signalType], 8) << 3;
+        idx->gainsIndices[0] += ecIcdf(ec, silkUniform8Icdf, 8);
+    }
+    for(int i = 1; i < ch->nbSubfr; i++) idx->gainsIndices[i] = ecIcdf(ec, silkDeltaGainIcdf, 8);
+
+    const SilkNlsfCB_t* cb = silkNlsfCB(ch);
+    idx->nlsfIndices[0] = ecIcdf(ec, cb->cb1Icdf + (idx->signalType >> 1) * 32, 8);
+    int16_t ecIx[SILK_MAX_ORDER];
+    uint8_t predQ8[SILK_MAX_ORDER];
+    silkNlsfUnpack(ecIx, predQ8, cb, idx->nlsfIndices[0]);
+    for(int i = 0; i < cb->order; i++){
+        ix = ecIcdf(ec, cb->ecIcdf + ecIx[i], 8);
+        if(ix == 0) ix -= ecIcdf(ec, silkNlsfExtIcdf, 8);
+        else if(ix == 8) ix += ecIcdf(ec, silkNlsfExtIcdf, 8);
+        idx->nlsfIndices[i + 1] = ix - 4;
+    }
+    idx->nlsfInterpCoefQ2 = ch->nbSubfr == 4 ? ecIcdf(ec, silkNlsfInterpIcdf, 8) : 4;
+
+    if(idx->signalType == SILK_VOICED){
+        bool absolute = true;
+        if(condCoding == SILK_CODE_CONDITIONALLY && ch->ecPrevSignalType == SILK_VOICED){
+            int delta = ecIcdf(ec, silkPitchDeltaIcdf, 8);
+            if(delta > 0){
+                idx->lagIndex = ch->ecPrevLagIndex + delta - 9;
+                absolute = false;
+            }
+        }
+        if(absolute){
+            const uint8_t* lowBitsIcdf = ch->fsKHz == 16 ? silkUniform8Icdf :
+                                         ch->fsKHz == 12 ? silkUniform6Icdf : silkUniform4Icdf;
+            idx->lagIndex = ecIcdf(ec, silkPitchLagIcdf, 8) * (ch->fsKHz >> 1);
+            idx->lagIndex += ecIcdf(ec, lowBitsIcdf, 8);
+        }
+        ch->ecPrevLagIndex = idx->lagIndex;
+        const uint8_t* contourIcdf;
+        if(ch->fsKHz == 8) contourIcdf = ch->nbSubfr == 4 ? silkPitchContourNBIcdf : silkPitchContour10msNBIcdf;
+        else               contourIcdf = ch->nbSubfr == 4 ? silkPitchContourIcdf : silkPitchContour10msIcdf;
+        idx->contourIndex = ecIcdf(ec, contourIcdf, 8);
+        idx->perIndex = ecIcdf(ec, silkLtpPerIndexIcdf, 8);
+        for(int k = 0; k < ch->nbSubfr; k++) idx->ltpIndex[k] = ecIcdf(ec, silkLtpGainIcdf[idx->perIndex], 8);
+        idx->ltpScaleIndex = condCoding == SILK_CODE_INDEPENDENTLY ? ecIcdf(ec, silkLtpScaleIcdf, 8) : 0;
+    }
+    ch->ecPrevSignalType = idx->signalType;
+    idx->seed = ecIcdf(ec, silkUniform4Icdf, 8);
+}
+
+static void silkShellDecode(RangeDec_t* ec, int16_t* p, int pulses, int len){
+    // splits the pulses of len positions into two halves, depth first as the encoder codes them
+    if(pulses == 0){
+        memset(p, 0, len * sizeof(int16_t));
+        return;
+    }
+    const uint8_t* table = silkShellCodeTable[ilog(len) - 2];
+    int left = ecIcdf(ec, &table[silkShellCodeTableOffsets[pulses]], 8);
+    if(len == 2){
+        p[0] = left;
+        p[1] = pulses - left;
+        return;
+    }
+    silkShellDecode(ec, p, left, len >> 1);
+    silkShellDecode(ec, p + (len >> 1), pulses - left, len >> 1);
+}
+
+static void silkDecodePulses(RangeDec_t* ec, int16_t* pulses, int signalType, int quantOffsetType, int frameLength){
+    // the excitation in blocks of 16 samples: pulse count, their positions, the LSBs and the signs
+    int rateLevel = ecIcdf(ec, silkRateLevelsIcdf[signalType >> 1], 8);
+    int blocks = (frameLength + 15) >> 4;  // 10ms at 12kHz is 7.5 blocks
+    int sumPulses[20], nLshifts[20];
+    for(int i = 0; i < blocks; i++){
+        nLshifts[i] = 0;
+        sumPulses[i] = ecIcdf(ec, silkPulsesPerBlockIcdf[rateLevel], 8);
+        while(sumPulses[i] == 17){  // more than 16 pulses: one more LSB
+            nLshifts[i]++;
+            sumPulses[i] = ecIcdf(ec, silkPulsesPerBlockIcdf[9] + (nLshifts[i] == 10), 8);
+        }
+    }
+    for(int i = 0; i < blocks; i++) silkShellDecode(ec, pulses + 16 * i, sumPulses[i], 16);
+    for(int i = 0; i < blocks; i++){
+        if(nLshifts[i] == 0) continue;
+        int16_t* q = pulses + 16 * i;
+        for(int k = 0; k < 16; k++){
+            int absQ = q[k];
+            for(int j = 0; j < nLshifts[i]; j++) absQ = (absQ << 1) + ecIcdf(ec, silkLsbIcdf, 8);
+            q[k] = absQ;
+        }
+        sumPulses[i] |= nLshifts[i] << 5;
+    }
+    const uint8_t* signIcdf = silkSignIcdf + 7 * (quantOffsetType + (signalType << 1));
+    uint8_t icdf[2] = {0, 0};
+    for(int i = 0; i < (frameLength + 8) >> 4; i++){
+        if(sumPulses[i] <= 0) continue;
+        icdf[0] = signIcdf[imin(sumPulses[i] & 0x1F, 6)];
+        int16_t* q = pulses + 16 * i;
+        for(int j = 0; j < 16; j++){
+            if(q[j] > 0) q[j] *= 2 * ecIcdf(ec, icdf, 8) - 1;
+        }
+    }
+}
+
+static void silkGainsDequant(int32_t* gainQ16, const int8_t* ind, int8_t* prevInd, bool conditional, int nbSubfr){
+    // 64 levels of 1.37dB from 2 to 88dB, the first index absolute or all as deltas to the last one
+    int prev = *prevInd;
+    for(int k = 0; k < nbSubfr; k++){
+        if(k == 0 && !conditional) prev = imax(ind[k], prev - 16);
+        else{
+            int indTmp = ind[k] - 4;
+            int threshold = 2 * 36 - 64 + prev;  // double step size above
+            if(indTmp > threshold) prev += (indTmp << 1) - threshold;
+            else prev += indTmp;
+        }
+        prev = imax(0, imin(63, prev));
+        gainQ16[k] = silkLog2Lin(imin(smulwb(1907825, prev) + 2090, 3967));
+    }
+    *prevInd = prev;
+}
+
+static void silkNlsfStabilize(int16_t* nlsf, const int16_t* deltaMin, int L){
+    // moves the NLSFs apart to the minimum distances, the worst pair first. Fallback: sort and clamp
+    for(int loops = 0; loops < 20; loops++){
+        int minDiff = nlsf[0] - deltaMin[0];
+        int I = 0;
+        for(int i = 1; i < L; i++){
+            int diff = nlsf[i] - (nlsf[i - 1] + deltaMin[i]);
+            if(diff < minDiff){
+                minDiff = diff;
+                I = i;
+            }
+        }
+        int diff = (1 << 15) - (nlsf[L - 1] + deltaMin[L]);
+        if(diff < minDiff){
+            minDiff = diff;
+            I = L;
+        }
+        if(minDiff >= 0) return;
+        if(I == 0) nlsf[0] = deltaMin[0];
+        else if(I == L) nlsf[L - 1] = (1 << 15) - deltaMin[L];
+        else{
+            int32_t minCenter = 0;
+            for(int k = 0; k < I; k++) minCenter += deltaMin[k];
+            minCenter += deltaMin[I] >> 1;
+            int32_t maxCenter = 1 << 15;
+            for(int k = L; k > I; k--) maxCenter -= deltaMin[k];
+            maxCenter -= deltaMin[I] >> 1;
+            int32_t center = limit32(rshiftRound(nlsf[I - 1] + nlsf[I], 1), minCenter, maxCenter);
+            nlsf[I - 1] = center - (deltaMin[I] >> 1);
+            nlsf[I] = nlsf[I - 1] + deltaMin[I];
+        }
+    }
+    for(int i = 1; i < L; i++){
+        int16_t v = nlsf[i];
+        int j;
+        for(j = i - 1; j >= 0 && v < nlsf[j]; j--) nlsf[j + 1] = nlsf[j];
+        nlsf[j + 1] = v;
+    }
+    nlsf[0] = imax(nlsf[0], deltaMin[0]);
+    for(int i = 1; i < L; i++) nlsf[i] = imax(nlsf[i], sat16(nlsf[i - 1] + deltaMin[i]));
+    nlsf[L - 1] = imin(nlsf[L - 1], (1 << 15) - deltaMin[L]);
+    for(int i = L - 2; i >= 0; i--) nlsf[i] = imin(nlsf[i], nlsf[i + 1] - deltaMin[i + 1]);
+}
+
+static void silkNlsfDecode(int16_t* nlsfQ15, const int8_t* nlsfIndices, const SilkNlsfCB_t* cb){
+    // first stage vector plus the backward predicted, weighted residual of the second stage
+    int16_t ecIx[SILK_MAX_ORDER], resQ10[SILK_MAX_ORDER];
+    uint8_t predQ8[SILK_MAX_ORDER];
+    silkNlsfUnpack(ecIx, predQ8, cb, nlsfIndices[0]);
+    int32_t outQ10 = 0;
+    for(int i = cb->order - 1; i >= 0; i--){
+        int32_t predQ10 = smulbb(outQ10, predQ8[i]) >> 8;
+        outQ10 = nlsfIndices[i + 1] << 10;
+        if(outQ10 > 0) outQ10 -= 102;       // quantization level adjustment, 0.1 Q10
+        else if(outQ10 < 0) outQ10 += 102;
+        outQ10 = predQ10 + smulwb(outQ10, cb->quantStepSizeQ16);
+        resQ10[i] = outQ10;
+    }
+    const uint8_t* cb1 = cb->cb1NlsfQ8 + nlsfIndices[0] * cb->order;
+    const int16_t* w = cb->cb1WghtQ9 + nlsfIndices[0] * cb->order;
+    for(int i = 0; i < cb->order; i++){
+        int32_t v = ((int32_t)resQ10[i] << 14) / w[i] + (cb1[i] << 7);
+        nlsfQ15[i] = imax(0, imin(32767, v));
+    }
+    silkNlsfStabilize(nlsfQ15, cb->deltaMinQ15, cb->order);
+}
+
+static void silkBwExpander32(int32_t* ar, int d, int32_t chirpQ16){  // ar[i] *= chirp^(i + 1)
+    int32_t chirpMinusOneQ16 = chirpQ16 - 65536;
+    for(int i = 0; i < d - 1; i++){
+        ar[i] = smulww(chirpQ16, ar[i]);
+        chirpQ16 += rshiftRound((int32_t)((uint32_t)chirpQ16 * (uint32_t)chirpMinusOneQ16), 16);
+    }
+    ar[d - 1] = smulww(chirpQ16, ar[d - 1]);
+}
+
+static void silkLpcFit(int16_t* aQ12, int32_t* aQ17, int d){
+    // Q17 to Q12 without overflow, at most 10 bandwidth expansions, then saturation
+    int i;
+    for(i = 0; i < 10; i++){
+        int32_t maxabs = 0;
+        int idx = 0;
+        for(int k = 0; k < d; k++){
+            int32_t absval = abs(aQ17[k]);
+            if(absval > maxabs){
+                maxabs = absval;
+                idx = k;
+            }
+        }
+        maxabs = rshiftRound(maxabs, 5);
+        if(maxabs <= INT16_MAX) break;
+        maxabs = imin(maxabs, 163838);
+        int32_t chirpQ16 = 65470 - ((maxabs - INT16_MAX) << 14) / ((maxabs * (idx + 1)) >> 2);
+        silkBwExpander32(aQ17, d, chirpQ16);
+    }
+    for(int k = 0; k < d; k++){
+        if(i == 10){
+            aQ12[k] = sat16(rshiftRound(aQ17[k], 5));
+            aQ17[k] = aQ12[k] << 5;
+        }
+        else aQ12[k] = rshiftRound(aQ17[k], 5);
+    }
+}
+
+static int32_t silkLpcInversePredGain(const int16_t* aQ12, int order){
+    // 0 if the filter is unstable or its prediction gain is above 40dB
+    const int32_t aLimit = 16773022;  // 0.99975 Q24
+    int32_t aQA[SILK_MAX_ORDER];
+    int32_t dcResp = 0;
+    for(int k = 0; k < order; k++){
+        dcResp += aQ12[k];
+        aQA[k] = (int32_t)aQ12[k] << 12;  // Q24
+    }
+    if(dcResp >= 4096) return 0;
+    int32_t invGainQ30 = 1 << 30;
+    for(int k = order - 1; k >= 0; k--){
+        if(aQA[k] > aLimit || aQA[k] < -aLimit) return 0;
+        int32_t rcQ31 = -lshift32(aQA[k], 7);
+        int32_t rcMult1Q30 = (1 << 30) - smmul(rcQ31, rcQ31);
+        invGainQ30 = lshift32(smmul(invGainQ30, rcMult1Q30), 2);
+        if(invGainQ30 < 107374) return 0;  // 1 / 10000 Q30
+        if(k == 0) break;
+        int mult2Q = 32 - clz32(abs(rcMult1Q30));
+        int32_t rcMult2 = inverse32VarQ(rcMult1Q30, mult2Q + 30);
+        for(int n = 0; n < (k + 1) >> 1; n++){
+            int32_t tmp1 = aQA[n];
+            int32_t tmp2 = aQA[k - n - 1];
+            int64_t t = rshiftRound64((int64_t)subSat32(tmp1, (int32_t)rshiftRound64((int64_t)tmp2 * rcQ31, 31)) *
+                                      rcMult2, mult2Q);
+            if(t > INT32_MAX || t < INT32_MIN) return 0;
+            aQA[n] = (int32_t)t;
+            t = rshiftRound64((int64_t)subSat32(tmp2, (int32_t)rshiftRound64((int64_t)tmp1 * rcQ31, 31)) * rcMult2,
+                              mult2Q);
+            if(t > INT32_MAX || t < INT32_MIN) return 0;
+            aQA[k - n - 1] = (int32_t)t;
+        }
+    }
+    return invGainQ30;
+}
+
+static void silkNlsf2AFindPoly(int32_t* out, const int32_t* cLsf, int dd){
+    out[0] = 1 << 16;
+    out[1] = -cLsf[0];
+    for(int k = 1; k < dd; k++){
+        int32_t ftmp = cLsf[2 * k];
+        out[k + 1] = lshift32(out[k - 1], 1) - (int32_t)rshiftRound64((int64_t)ftmp * out[k], 16);
+        for(int n = k; n > 1; n--) out[n] += out[n - 2] - (int32_t)rshiftRound64((int64_t)ftmp * out[n - 1], 16);
+        out[1] -= ftmp;
+    }
+}
+
+static void silkNlsf2A(int16_t* aQ12, const int16_t* nlsf, int d){
+    // NLSFs to LPC coefficients through the symmetric and antisymmetric polynomials, made stable
+    const uint8_t* ordering = d == 16 ? silkOrdering16 : silkOrdering10;
+    int32_t cosLsfQA[SILK_MAX_ORDER], P[SILK_MAX_ORDER / 2 + 1], Q[SILK_MAX_ORDER / 2 + 1], a32QA1[SILK_MAX_ORDER];
+    for(int k = 0; k < d; k++){
+        int fInt = nlsf[k] >> 8;
+        int fFrac = nlsf[k] - (fInt << 8);
+        int32_t cosVal = silkLsfCosTabQ12[fInt];
+        int32_t delta = silkLsfCosTabQ12[fInt + 1] - cosVal;
+        cosLsfQA[ordering[k]] = rshiftRound((cosVal << 8) + delta * fFrac, 4);  // Q16
+    }
+    int dd = d >> 1;
+    silkNlsf2AFindPoly(P, cosLsfQA, dd);
+    silkNlsf2AFindPoly(Q, cosLsfQA + 1, dd);
+    for(int k = 0; k < dd; k++){
+        int32_t pTmp = P[k + 1] + P[k];
+        int32_t qTmp = Q[k + 1] - Q[k];
+        a32QA1[k] = -qTmp - pTmp;
+        a32QA1[d - k - 1] = qTmp - pTmp;
+    }
+    silkLpcFit(aQ12, a32QA1, d);
+    for(int i = 0; silkLpcInversePredGain(aQ12, d) == 0 && i < 16; i++){
+        silkBwExpander32(a32QA1, d, 65536 - (2 << i));
+        for(int k = 0; k < d; k++) aQ12[k] = rshiftRound(a32QA1[k], 5);
+    }
+}
+
+static void silkDecodePitch(int lagIndex, int contourIndex, int* pitchL, int fsKHz, int nbSubfr){
+    const int8_t* cb;
+    int cbSize;
+    if(fsKHz == 8){
+        if(nbSubfr == 4){cb = &silkCBLagsStage2[0][0];      cbSize = 11;}
+        else            {cb = &silkCBLagsStage2_10ms[0][0]; cbSize = 3;}
+    }
+    else{
+        if(nbSubfr == 4){cb = &silkCBLagsStage3[0][0];      cbSize = 34;}
+        else            {cb = &silkCBLagsStage3_10ms[0][0]; cbSize = 12;}
+    }
+    int minLag = 2 * fsKHz, maxLag = 18 * fsKHz;
+    int lag = minLag + lagIndex;
+    for(int k = 0; k < nbSubfr; k++) pitchL[k] = imax(minLag, imin(maxLag, lag + cb[k * cbSize + contourIndex]));
+}
+
+static void silkDecodeParameters(SilkChannel_t* ch, SilkIndices_t* idx, SilkControl_t* ctrl, int condCoding){
+    silkGainsDequant(ctrl->gainsQ16, idx->gainsIndices, &ch->lastGainIndex, condCoding == SILK_CODE_CONDITIONALLY,
+                     ch->nbSubfr);
+    int16_t nlsfQ15[SILK_MAX_ORDER];
+    silkNlsfDecode(nlsfQ15, idx->nlsfIndices, silkNlsfCB(ch));
+    silkNlsf2A(ctrl->predCoefQ12[1], nlsfQ15, ch->lpcOrder);
+    if(ch->firstFrameAfterReset) idx->nlsfInterpCoefQ2 = 4;
+    if(idx->nlsfInterpCoefQ2 < 4){  // the first half of the frame uses NLSFs between the last and these
+        int16_t nlsf0Q15[SILK_MAX_ORDER];
+        for(int i = 0; i < ch->lpcOrder; i++){
+            nlsf0Q15[i] = ch->prevNLSFQ15[i] + ((idx->nlsfInterpCoefQ2 * (nlsfQ15[i] - ch->prevNLSFQ15[i])) >> 2);
+        }
+        silkNlsf2A(ctrl->predCoefQ12[0], nlsf0Q15, ch->lpcOrder);
+    }
+    else memcpy(ctrl->predCoefQ12[0], ctrl->predCoefQ12[1], ch->lpcOrder * sizeof(int16_t));
+    memcpy(ch->prevNLSFQ15, nlsfQ15, ch->lpcOrder * sizeof(int16_t));
+
+    if(idx->signalType == SILK_VOICED){
+        silkDecodePitch(idx->lagIndex, idx->contourIndex, ctrl->pitchL, ch->fsKHz, ch->nbSubfr);
+        const int8_t* cbk = silkLtpGainVq[idx->perIndex];
+        for(int k = 0; k < ch->nbSubfr; k++){
+            for(int i = 0; i < 5; i++) ctrl->ltpCoefQ14[k * 5 + i] = cbk[idx->ltpIndex[k] * 5 + i] << 7;
+        }
+        ctrl->ltpScaleQ14 = silkLtpScalesQ14[idx->ltpScaleIndex];
+    }
+    else{
+        memset(ctrl->pitchL, 0, sizeof(ctrl->pitchL));
+        memset(ctrl->ltpCoefQ14, 0, sizeof(ctrl->ltpCoefQ14));
+        idx->perIndex = 0;
+        ctrl->ltpScaleQ14 = 0;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          S I L K   S Y N T H E S I S
+//----------------------------------------------------------------------------------------------------------------------
+static void silkLpcAnalysisFilter(int16_t* out, const int16_t* in, const int16_t* B, int len, int d){
+    // the residual of in, the first d outputs are zero
+    for(int ix = d; ix < len; ix++){
+        const int16_t* x = &in[ix - 1];
+        uint32_t acc = 0;  // wraps like the reference
+        for(int j = 0; j < d; j++) acc += (uint32_t)smulbb(x[-j], B[j]);
+        int32_t r = (int32_t)(((uint32_t)x[1] << 12) - acc);
+        out[ix] = sat16(rshiftRound(r, 12));
+    }
+    memset(out, 0, d * sizeof(int16_t));
+}
+
+static void silkDecodeCore(SilkChannel_t* ch, const SilkIndices_t* idx, const SilkControl_t* ctrl, int16_t* xq,
+                           const int16_t* pulses){
+    // excitation, long term (pitch) and short term (LPC) synthesis. The buffers are the scratch of the CELT IMDCT,
+    // behind the pulses
+    int32_t* sLtpQ15 = m_dec->freq + SILK_MAX_FRAME / 2;   // ltpMemLength + frameLength
+    int32_t* excQ14  = sLtpQ15 + 2 * SILK_MAX_FRAME;       // frameLength
+    int32_t* resQ14  = excQ14 + SILK_MAX_FRAME;            // subfrLength
+    int32_t* sLpcQ14 = resQ14 + SILK_MAX_FRAME / 4;        // subfrLength + 16
+    int16_t* sLtp    = (int16_t*)(sLpcQ14 + SILK_MAX_FRAME / 4 + SILK_MAX_ORDER);  // ltpMemLength
+
+    int32_t offsetQ10 = silkQuantOffsetsQ10[idx->signalType >> 1][idx->quantOffsetType];
+    bool nlsfInterpolation = idx->nlsfInterpCoefQ2 < 4;
+    uint32_t seed = idx->seed;
+    for(int i = 0; i < ch->frameLength; i++){
+        seed = 907633515 + seed * 196314165;
+        int32_t e = (int32_t)pulses[i] << 14;
+        if(e > 0) e -= 80 << 4;        // quantization level adjustment
+        else if(e < 0) e += 80 << 4;
+        e += offsetQ10 << 4;
+        excQ14[i] = (int32_t)seed < 0 ? -e : e;
+        seed += pulses[i];
+    }
+
+    memcpy(sLpcQ14, ch->sLPCQ14, SILK_MAX_ORDER * sizeof(int32_t));
+    const int32_t* pexc = excQ14;
+    int16_t* pxq = xq;
+    int L = ch->subfrLength;
+    int d = ch->lpcOrder;
+    int sLtpBufIdx = ch->ltpMemLength;
+    for(int k = 0; k < ch->nbSubfr; k++){
+        const int16_t* A = ctrl->predCoefQ12[k >> 1];
+        const int16_t* B = &ctrl->ltpCoefQ14[k * 5];
+        int32_t gainQ10 = ctrl->gainsQ16[k] >> 6;
+        int32_t invGainQ31 = inverse32VarQ(ctrl->gainsQ16[k], 47);
+        int32_t gainAdjQ16 = 1 << 16;
+        if(ctrl->gainsQ16[k] != ch->prevGainQ16){  // the filter states follow the gain
+            gainAdjQ16 = div32VarQ(ch->prevGainQ16, ctrl->gainsQ16[k], 16);
+            for(int i = 0; i < SILK_MAX_ORDER; i++) sLpcQ14[i] = smulww(gainAdjQ16, sLpcQ14[i]);
+        }
+        ch->prevGainQ16 = ctrl->gainsQ16[k];
+
+        const int32_t* presQ14 = pexc;
+        if(idx->signalType == SILK_VOICED){
+            int lag = ctrl->pitchL[k];
+            if(k == 0 || (k == 2 && nlsfInterpolation)){  // re-whiten the history with this LPC filter
+                int startIdx = ch->ltpMemLength - lag - d - 2;
+                if(k == 2) memcpy(&ch->outBuf[ch->ltpMemLength], xq, 2 * L * sizeof(int16_t));
+                silkLpcAnalysisFilter(&sLtp[startIdx], &ch->outBuf[startIdx + k * L], A, ch->ltpMemLength - startIdx, d);
+                if(k == 0) invGainQ31 = lshift32(smulwb(invGainQ31, ctrl->ltpScaleQ14), 2);
+                for(int i = 0; i < lag + 2; i++){
+                    sLtpQ15[sLtpBufIdx - i - 1] = smulwb(invGainQ31, sLtp[ch->ltpMemLength - i - 1]);
+                }
+            }
+            else if(gainAdjQ16 != 1 << 16){
+                for(int i = 0; i < lag + 2; i++){
+                    sLtpQ15[sLtpBufIdx - i - 1] = smulww(gainAdjQ16, sLtpQ15[sLtpBufIdx - i - 1]);
+                }
+            }
+            const int32_t* predLag = &sLtpQ15[sLtpBufIdx - lag + 2];
+            for(int i = 0; i < L; i++){  // 5 tap long term prediction
+                int32_t p = 2 + smulwb(predLag[0], B[0]) + smulwb(predLag[-1], B[1]) + smulwb(predLag[-2], B[2]) +
+                            smulwb(predLag[-3], B[3]) + smulwb(predLag[-4], B[4]);
+                predLag++;
+                resQ14[i] = pexc[i] + lshift32(p, 1);
+                sLtpQ15[sLtpBufIdx++] = lshift32(resQ14[i], 1);
+            }
+            presQ14 = resQ14;
+        }
+        for(int i = 0; i < L; i++){
+            int32_t* s = &sLpcQ14[SILK_MAX_ORDER + i];
+            uint32_t p = d >> 1;  // rounding, wraps like the reference
+            for(int j = 0; j < d; j++) p += smulwb(s[-j - 1], A[j]);
+            s[0] = addSat32(presQ14[i], lshiftSat32((int32_t)p, 4));
+            pxq[i] = sat16(rshiftRound(smulww(s[0], gainQ10), 8));
+        }
+        memcpy(sLpcQ14, &sLpcQ14[L], SILK_MAX_ORDER * sizeof(int32_t));
+        pexc += L;
+        pxq += L;
+    }
+    memcpy(ch->sLPCQ14, sLpcQ14, SILK_MAX_ORDER * sizeof(int32_t));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          S I L K   S T E R E O   A N D   R E S A M P L E R
+//----------------------------------------------------------------------------------------------------------------------
+static void silkStereoDecodePred(RangeDec_t* ec, int32_t* predQ13){
+    int ix[2][3];
+    int n = ecIcdf(ec, silkStereoPredJointIcdf, 8);
+    ix[0][2] = n / 5;
+    ix[1][2] = n - 5 * ix[0][2];
+    for(int i = 0; i < 2; i++){
+        ix[i][0] = ecIcdf(ec, silkUniform3Icdf, 8);
+        ix[i][1] = ecIcdf(ec, silkUniform5Icdf, 8);
+    }
+    for(int i = 0; i < 2; i++){
+        ix[i][0] += 3 * ix[i][2];
+        int32_t lowQ13 = silkStereoPredQuantQ13[ix[i][0]];
+        int32_t stepQ13 = smulwb(silkStereoPredQuantQ13[ix[i][0] + 1] - lowQ13, 6554);  // 0.5 / 5 Q16
+        predQ13[i] = lowQ13 + smulbb(stepQ13, 2 * ix[i][1] + 1);
+    }
+    predQ13[0] -= predQ13[1];
+}
+
+static void silkStereoMsToLr(int16_t* x1, int16_t* x2, const int32_t* predQ13, int fsKHz, int frameLength){
+    // mid and side (2 samples of history in front) to left and right, the predictor is interpolated in the first 8ms
+    OpusDecoder_t* d = m_dec;
+    memcpy(x1, d->silkSMid, 2 * sizeof(int16_t));
+    memcpy(x2, d->silkSSide, 2 * sizeof(int16_t));
+    memcpy(d->silkSMid, &x1[frameLength], 2 * sizeof(int16_t));
+    memcpy(d->silkSSide, &x2[frameLength], 2 * sizeof(int16_t));
+    int32_t pred0 = d->silkPredPrevQ13[0], pred1 = d->silkPredPrevQ13[1];
+    int32_t denomQ16 = (1 << 16) / (8 * fsKHz);
+    int32_t delta0 = rshiftRound(smulbb(predQ13[0] - pred0, denomQ16), 16);
+    int32_t delta1 = rshiftRound(smulbb(predQ13[1] - pred1, denomQ16), 16);
+    for(int n = 0; n < frameLength; n++){
+        if(n < 8 * fsKHz){
+            pred0 += delta0;
+            pred1 += delta1;
+        }
+        else{
+            pred0 = predQ13[0];
+            pred1 = predQ13[1];
+        }
+        int32_t sum = (x1[n] + x1[n + 2] + (x1[n + 1] << 1)) << 9;  // low passed mid, Q11
+        sum = ((int32_t)x2[n + 1] << 8) + smulwb(sum, pred0);
+        sum = sum + smulwb((int32_t)x1[n + 1] << 11, pred1);
+        x2[n + 1] = sat16(rshiftRound(sum, 8));
+    }
+    d->silkPredPrevQ13[0] = predQ13[0];
+    d->silkPredPrevQ13[1] = predQ13[1];
+    for(int n = 0; n < frameLength; n++){
+        int32_t sum = x1[n + 1] + x2[n + 1];
+        int32_t diff = x1[n + 1] - x2[n + 1];
+        x1[n + 1] = sat16(sum);
+        x2[n + 1] = sat16(diff);
+    }
+}
+
+static void silkResamplerInit(SilkChannel_t* ch, int fsKHz){  // fsKHz to 48kHz
+    memset(ch->rsIIR, 0, sizeof(ch->rsIIR));
+    memset(ch->rsFIR, 0, sizeof(ch->rsFIR));
+    memset(ch->rsDelayBuf, 0, sizeof(ch->rsDelayBuf));
+    ch->rsInputDelay = fsKHz == 8 ? 0 : fsKHz == 12 ? 4 : 7;
+    int32_t fsIn = fsKHz * 1000;
+    ch->rsInvRatioQ16 = lshift32((fsIn << 15) / 48000, 2);
+    while(smulww(ch->rsInvRatioQ16, 48000) < fsIn << 1) ch->rsInvRatioQ16++;
+}
+
+static void silkUp2Hq(int32_t* S, int16_t* out, const int16_t* in, int len){
+    // 2x upsampler, two chains of three allpass sections for the even and the odd samples
+    for(int k = 0; k < len; k++){
+        int32_t in32 = (int32_t)in[k] << 10;
+        int32_t Y = in32 - S[0];
+        int32_t X = smulwb(Y, silkResamplerUp2Hq0[0]);
+        int32_t out1 = S[0] + X;
+        S[0] = in32 + X;
+        Y = out1 - S[1];
+        X = smulwb(Y, silkResamplerUp2Hq0[1]);
+        int32_t out2 = S[1] + X;
+        S[1] = out1 + X;
+        Y = out2 - S[2];
+        X = Y + smulwb(Y, silkResamplerUp2Hq0[2]);
+        out1 = S[2] + X;
+        S[2] = out2 + X;
+        out[2 * k] = sat16(rshiftRound(out1, 10));
+
+        Y = in32 - S[3];
+        X = smulwb(Y, silkResamplerUp2Hq1[0]);
+        out1 = S[3] + X;
+        S[3] = in32 + X;
+        Y = out1 - S[4];
+        X = smulwb(Y, silkResamplerUp2Hq1[1]);
+        out2 = S[4] + X;
+        S[4] = out1 + X;
+        Y = out2 - S[5];
+        X = Y + smulwb(Y, silkResamplerUp2Hq1[2]);
+        out1 = S[5] + X;
+        S[5] = out2 + X;
+        out[2 * k + 1] = sat16(rshiftRound(out1, 10));
+    }
+}
+
+static int16_t* silkResamplerIIRFIR(SilkChannel_t* ch, int16_t* out, const int16_t* in, int inLen){
+    // 2x upsampling, then the fractional 8 tap FIR interpolation, in batches of 10ms
+    int16_t* buf = (int16_t*)m_dec->freq + OPUS_MAX_FRAME_SIZE;  // behind the output of silkResample(), 20ms
+    int batch = ch->fsKHz * 10;
+    memcpy(buf, ch->rsFIR, 8 * sizeof(int16_t));
+    int n;
+    while(true){
+        n = imin(inLen, batch);
+        silkUp2Hq(ch->rsIIR, &buf[8], in, n);
+        int32_t maxIndexQ16 = n << 17;
+        for(int32_t indexQ16 = 0; indexQ16 < maxIndexQ16; indexQ16 += ch->rsInvRatioQ16){
+            int t = smulwb(indexQ16 & 0xFFFF, 12);
+            const int16_t* b = &buf[indexQ16 >> 16];
+            const int16_t* f0 = silkResamplerFracFIR12[t];
+            const int16_t* f1 = silkResamplerFracFIR12[11 - t];
+            int32_t r = smulbb(b[0], f0[0]) + smulbb(b[1], f0[1]) + smulbb(b[2], f0[2]) + smulbb(b[3], f0[3]) +
+                        smulbb(b[4], f1[3]) + smulbb(b[5], f1[2]) + smulbb(b[6], f1[1]) + smulbb(b[7], f1[0]);
+            *out++ = sat16(rshiftRound(r, 15));
+        }
+        in += n;
+        inLen -= n;
+        if(inLen <= 0) break;
+        memcpy(buf, &buf[n << 1], 8 * sizeof(int16_t));
+    }
+    memcpy(ch->rsFIR, &buf[n << 1], 8 * sizeof(int16_t));
+    return out;
+}
+
+static void silkResample(SilkChannel_t* ch, int16_t* out, const int16_t* in, int inLen){
+    // inLen samples at fsKHz to 48kHz, the first ms comes through the delay buffer
+    int fsIn = ch->fsKHz;
+    int n = fsIn - ch->rsInputDelay;
+    memcpy(&ch->rsDelayBuf[ch->rsInputDelay], in, n * sizeof(int16_t));
+    silkResamplerIIRFIR(ch, out, ch->rsDelayBuf, fsIn);
+    silkResamplerIIRFIR(ch, out + 48, in + n, inLen - fsIn);
+    memcpy(ch->rsDelayBuf, &in[inLen - ch->rsInputDelay], ch->rsInputDelay * sizeof(int16_t));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          S I L K   F R A M E
+//----------------------------------------------------------------------------------------------------------------------
+#define SILK_BUF_STRIDE  (SILK_MAX_FRAME + 2)  // one channel of one SILK frame in silkBuf, 2 samples history in front
+#define SILK_BUF_SIZE    (2 * SILK_MAX_FRAMES * SILK_BUF_STRIDE + OPUS_MAX_CHANNELS * 2 * OPUS_OVERLAP)  // and xBuf
+
+static void silkInitChannel(SilkChannel_t* ch){
+    memset(ch, 0, sizeof(SilkChannel_t));
+    ch->prevGainQ16 = 65536;
+    ch->firstFrameAfterReset = true;
+}
+
+static void silkReset(){
+    for(int n = 0; n < OPUS_MAX_CHANNELS; n++) silkInitChannel(&m_dec->silk[n]);
+    memset(m_dec->silkPredPrevQ13, 0, sizeof(m_dec->silkPredPrevQ13));
+    memset(m_dec->silkSMid, 0, sizeof(m_dec->silkSMid));
+    memset(m_dec->silkSSide, 0, sizeof(m_dec->silkSSide));
+    m_dec->silkPrevDecodeOnlyMiddle = false;
+}
+
+static void silkSetFs(SilkChannel_t* ch, int fsKHz){
+    ch->subfrLength = 5 * fsKHz;
+    int frameLength = ch->nbSubfr * ch->subfrLength;
+    if(ch->fsKHz != fsKHz){
+        silkResamplerInit(ch, fsKHz);
+        ch->ltpMemLength = 20 * fsKHz;
+        ch->lpcOrder = fsKHz == 16 ? 16 : 10;
+        ch->firstFrameAfterReset = true;
+        ch->lastGainIndex = 10;
+        memset(ch->outBuf, 0, sizeof(ch->outBuf));
+        memset(ch->sLPCQ14, 0, sizeof(ch->sLPCQ14));
+    }
+    ch->fsKHz = fsKHz;
+    ch->frameLength = frameLength;
+}
+
+static void silkDecodeChannel(SilkChannel_t* ch, RangeDec_t* ec, int16_t* out, int condCoding){
+    // one frame of one channel, ec == NULL: lost, the output is silence
+    int L = ch->frameLength;
+    if(ec){
+        SilkIndices_t idx;
+        SilkControl_t ctrl;
+        int16_t* pulses = (int16_t*)m_dec->freq;
+        silkDecodeIndices(ch, ec, &idx, ch->vadFlags[ch->nFramesDecoded], condCoding);
+        silkDecodePulses(ec, pulses, idx.signalType, idx.quantOffsetType, L);
+        silkDecodeParameters(ch, &idx, &ctrl, condCoding);
+        silkDecodeCore(ch, &idx, &ctrl, out, pulses);
+        ch->firstFrameAfterReset = false;
+    }
+    else{
+        memset(out, 0, L * sizeof(int16_t));
+        memset(ch->sLPCQ14, 0, sizeof(ch->sLPCQ14));
+    }
+    int mvLen = ch->ltpMemLength - L;
+    memmove(ch->outBuf, &ch->outBuf[L], mvLen * sizeof(int16_t));
+    memcpy(&ch->outBuf[mvLen], out, L * sizeof(int16_t));
+}
+
+static void silkDecode(RangeDec_t* ec, int C, int fsKHz, int payloadMs, int frame){
+    // SILK frame number 'frame' (10 or 20ms) of the Opus frame in work, all channels to silkBuf at the internal rate,
+    // silk_Decode() of the reference. ec == NULL: lost, each 20ms are decoded as a packet of their own
+    OpusDecoder_t* d = m_dec;
+    SilkChannel_t* ch = d->silk;
+    int16_t* out[2];
+    out[0] = d->silkBuf + 2 * frame * SILK_BUF_STRIDE;
+    out[1] = out[0] + SILK_BUF_STRIDE;
+    bool first = frame == 0 || !ec;
+    if(first){
+        for(int n = 0; n < C; n++) ch[n].nFramesDecoded = 0;
+    }
+    if(C > d->silkChannels) silkInitChannel(&ch[1]);  // mono to stereo
+    if(frame == 0) d->silkStereoToMono = C == 1 && d->silkChannels == 2 && fsKHz == ch[0].fsKHz;
+    if(ch[0].nFramesDecoded == 0){
+        for(int n = 0; n < C; n++){
+            ch[n].nFramesPerPacket = payloadMs == 40 ? 2 : payloadMs == 60 ? 3 : 1;
+            ch[n].nbSubfr = payloadMs == 10 ? 2 : 4;
+            silkSetFs(&ch[n], fsKHz);
+        }
+    }
+    if(d->channels == 2 && C == 2 && d->silkChannels == 1){
+        memset(d->silkPredPrevQ13, 0, sizeof(d->silkPredPrevQ13));
+        memset(d->silkSSide, 0, sizeof(d->silkSSide));
+        memcpy(ch[1].rsIIR, ch[0].rsIIR, sizeof(ch[0].rsIIR));
+        memcpy(ch[1].rsFIR, ch[0].rsFIR, sizeof(ch[0].rsFIR));
+        memcpy(ch[1].rsDelayBuf, ch[0].rsDelayBuf, sizeof(ch[0].rsDelayBuf));
+        ch[1].rsInvRatioQ16 = ch[0].rsInvRatioQ16;
+        ch[1].rsInputDelay = ch[0].rsInputDelay;
+    }
+    d->silkChannels = C;
+
+    int32_t predQ13[2] = {0, 0};
+    int decodeOnlyMiddle = 0;
+    if(ec && ch[0].nFramesDecoded == 0){  // the VAD and LBRR flags of all frames in front of the first one
+        bool lbrr[OPUS_MAX_CHANNELS];
+        for(int n = 0; n < C; n++){
+            for(int i = 0; i < ch[n].nFramesPerPacket; i++) ch[n].vadFlags[i] = ecBitLogp(ec, 1);
+            lbrr[n] = ecBitLogp(ec, 1);
+        }
+        for(int n = 0; n < C; n++){
+            memset(ch[n].lbrrFlags, 0, sizeof(ch[n].lbrrFlags));
+            if(!lbrr[n]) continue;
+            if(ch[n].nFramesPerPacket == 1) ch[n].lbrrFlags[0] = 1;
+            else{
+                int sym = ecIcdf(ec, ch[n].nFramesPerPacket == 2 ? silkLbrrFlags2Icdf : silkLbrrFlags3Icdf, 8) + 1;
+                for(int i = 0; i < ch[n].nFramesPerPacket; i++) ch[n].lbrrFlags[i] = (sym >> i) & 1;
+            }
+        }
+        for(int i = 0; i < ch[0].nFramesPerPacket; i++){  // the redundancy (LBRR) is read and dropped
+            for(int n = 0; n < C; n++){
+                if(!ch[n].lbrrFlags[i]) continue;
+                if(C == 2 && n == 0){
+                    silkStereoDecodePred(ec, predQ13);
+                    if(!ch[1].lbrrFlags[i]) decodeOnlyMiddle = ecIcdf(ec, silkStereoOnlyMidIcdf, 8);
+                }
+                int condCoding = i > 0 && ch[n].lbrrFlags[i - 1] ? SILK_CODE_CONDITIONALLY : SILK_CODE_INDEPENDENTLY;
+                SilkIndices_t idx;
+                silkDecodeIndices(&ch[n], ec, &idx, true, condCoding);
+                silkDecodePulses(ec, (int16_t*)d->freq, idx.signalType, idx.quantOffsetType, ch[n].frameLength);
+            }
+        }
+    }
+    if(C == 2){
+        if(ec){
+            silkStereoDecodePred(ec, predQ13);
+            decodeOnlyMiddle = ch[1].vadFlags[ch[0].nFramesDecoded] ? 0 : ecIcdf(ec, silkStereoOnlyMidIcdf, 8);
+        }
+        else{
+            predQ13[0] = d->silkPredPrevQ13[0];
+            predQ13[1] = d->silkPredPrevQ13[1];
+        }
+        if(!decodeOnlyMiddle && d->silkPrevDecodeOnlyMiddle){  // the side channel restarts
+            memset(ch[1].outBuf, 0, sizeof(ch[1].outBuf));
+            memset(ch[1].sLPCQ14, 0, sizeof(ch[1].sLPCQ14));
+            ch[1].lastGainIndex = 10;
+            ch[1].firstFrameAfterReset = true;
+        }
+    }
+    int L = ch[0].frameLength;
+    for(int n = 0; n < C; n++){
+        if(n == 0 || !decodeOnlyMiddle){
+            int frameIndex = ch[0].nFramesDecoded - n;
+            int condCoding;
+            if(frameIndex <= 0) condCoding = SILK_CODE_INDEPENDENTLY;
+            else if(n > 0 && d->silkPrevDecodeOnlyMiddle) condCoding = SILK_CODE_INDEPENDENTLY_NO_LTP_SCALING;
+            else condCoding = SILK_CODE_CONDITIONALLY;
+            silkDecodeChannel(&ch[n], ec, out[n] + 2, condCoding);
+        }
+        else memset(out[n] + 2, 0, L * sizeof(int16_t));
+        ch[n].nFramesDecoded++;
+    }
+    if(d->channels == 2 && C == 2) silkStereoMsToLr(out[0], out[1], predQ13, ch[0].fsKHz, L);
+    else{
+        memcpy(out[0], d->silkSMid, 2 * sizeof(int16_t));
+        memcpy(d->silkSMid, &out[0][L], 2 * sizeof(int16_t));
+    }
+    if(!ec){
+        for(int n = 0; n < C; n++) ch[n].lastGainIndex = 10;
+    }
+    else d->silkPrevDecodeOnlyMiddle = decodeOnlyMiddle;
+}
+
+static void silkAddPcm(int16_t* pcm, const int16_t* x, int n, int CC){  // with the output gain of the OpusHead
+    int32_t g = m_dec->gainQ16;
+    for(int i = 0; i < n; i++){
+        int32_t s = g ? (int32_t)(((int64_t)x[i] * g + 32768) >> 16) : x[i];
+        pcm[i * CC] = sat16(pcm[i * CC] + s);
+    }
+}
+
+static void silkAddFrame(int frame, int16_t* pcm){
+    // resamples a decoded SILK frame to 48kHz and adds it to the CELT output in pcm
+    OpusDecoder_t* d = m_dec;
+    int CC = d->channels;
+    int C = d->silkChannels;
+    int L = d->silk[0].frameLength;
+    int n = d->chunkSamples;
+    int16_t* rs = (int16_t*)d->freq;
+    const int16_t* in = d->silkBuf + 2 * frame * SILK_BUF_STRIDE + 1;  // mid/side to left/right is 1 sample late
+    for(int c = 0; c < imin(CC, C); c++){
+        silkResample(&d->silk[c], rs, in + c * SILK_BUF_STRIDE, L);
+        silkAddPcm(pcm + c, rs, n, CC);
+    }
+    if(CC == 2 && C == 1){  // mono to both channels, after stereo the right resampler runs out with the mono signal
+        if(frame == 0 && d->silkStereoToMono) silkResample(&d->silk[1], rs, in, L);
+        silkAddPcm(pcm + 1, rs, n, CC);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          O P U S   P A C K E T   (RFC 6716 section 3)
+//----------------------------------------------------------------------------------------------------------------------
+static int samplesPerFrame(uint8_t toc){  // at 48kHz
+    if(toc & 0x80) return (48000 << ((toc >> 3) & 3)) / 400;       // CELT 2.5...20ms
+    if((toc & 0x60) == 0x60) return (toc & 0x08) ? 960 : 480;      // hybrid 10, 20ms
+    int audioSize = (toc >> 3) & 3;                                 // SILK 10, 20, 40, 60ms
+    return audioSize == 3 ? 2880 : (48000 << audioSize) / 100;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int parseSize(const uint8_t* data, int len, uint16_t* size){
+    if(len < 1) return -1;
+    if(data[0] < 252){
+        *size = data[0];
+        return 1;
+    }
+    if(len < 2) return -1;
+    *size = 4 * data[1] + data[0];
+    return 2;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int8_t parsePacket(const uint8_t* data, int len){
+    // fills toc, frameCount, frameOffset and frameSize, the padding is ignored
+    const uint8_t* p = data;
+    uint16_t* size = m_dec->frameSize;
+    int count;
+    uint16_t lastSize;
+    uint8_t toc = *p++;
+    len--;
+    int frameSamples = samplesPerFrame(toc);
+    switch(toc & 3){
+        case 0:  // one frame
+            count = 1;
+            lastSize = len;
+            break;
+        case 1:  // two frames of equal size
+            count = 2;
+            if(len & 1) return ERR_OPUS_INVALID_PACKET;
+            lastSize = size[0] = len / 2;
+            break;
+        case 2: {  // two frames of different size
+            count = 2;
+            int n = parseSize(p, len, &size[0]);
+            len -= n;
+            if(n < 0 || size[0] > len) return ERR_OPUS_INVALID_PACKET;
+            p += n;
+            lastSize = len - size[0];
+            break;
+        }
+        default: {  // any number of frames, CBR or VBR
+            if(len < 1) return ERR_OPUS_INVALID_PACKET;
+            uint8_t ch = *p++;
+            len--;
+            count = ch & 0x3F;
+            if(count <= 0 || frameSamples * count > 5760) return ERR_OPUS_INVALID_PACKET;
+            if(ch & 0x40){  // padding
+                int pb;
+                do{
+                    if(len <= 0) return ERR_OPUS_INVALID_PACKET;
+                    pb = *p++;
+                    len--;
+                    len -= pb == 255 ? 254 : pb;
+                } while(pb == 255);
+            }
+            if(len < 0) return ERR_OPUS_INVALID_PACKET;
+            if(ch & 0x80){  // VBR
+                int last = len;
+                for(int i = 0; i < count - 1; i++){
+                    int n = parseSize(p, len, &size[i]);
+                    len -= n;
+                    if(n < 0 || size[i] > len) return ERR_OPUS_INVALID_PACKET;
+                    p += n;
+                    last -= n + size[i];
+                }
+                if(last < 0) return ERR_OPUS_INVALID_PACKET;
+                lastSize = last;
+            }
+            else{
+                lastSize = len / count;
+                if(lastSize * count != len) return ERR_OPUS_INVALID_PACKET;
+                for(int i = 0; i < count - 1; i++) size[i] = lastSize;
+            }
+            break;
+        }
+    }
+    if(lastSize > 1275) return ERR_OPUS_INVALID_PACKET;
+    size[count - 1] = lastSize;
+    uint16_t offs = p - data;
+    for(int i = 0; i < count; i++){
+        m_dec->frameOffset[i] = offs;
+        offs += size[i];
+    }
+    m_dec->toc = toc;
+    m_dec->frameCount = count;
+    m_dec->frameIdx = 0;
+    m_dec->bitRate = (uint32_t)m_dec->packetLen * 8 * 48000 / (frameSamples * count);
+    return ERR_OPUS_NONE;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          O P U S   F R A M E
+//----------------------------------------------------------------------------------------------------------------------
+static void smoothFade(const int16_t* in1, const int16_t* in2, int16_t* out, int CC){
+    // 2.5ms cross fade from in1 to in2 with the square of the CELT window
+    for(int c = 0; c < CC; c++){
+        for(int i = 0; i < OPUS_OVERLAP; i++){
+            int32_t w = (celtWindow[i] * celtWindow[i]) >> 15;
+            int k = i * CC + c;
+            out[k] = (w * in2[k] + (32767 - w) * in1[k]) >> 15;
+        }
+    }
+}
+
+static void fadeToRedundancy(int16_t* pcm){
+    // the end of a SILK or hybrid frame fades into the second half of the redundant CELT frame
+    int CC = m_dec->channels;
+    int16_t* p = pcm + CC * (m_dec->chunkSamples - OPUS_OVERLAP);
+    smoothFade(p, m_dec->xBuf + CC * OPUS_OVERLAP, p, CC);
+}
+
+static void fadeFromXBuf(int16_t* pcm){
+    // the first 2.5ms are those of xBuf, the next 2.5ms fade from xBuf to the frame
+    int CC = m_dec->channels;
+    memcpy(pcm, m_dec->xBuf, CC * OPUS_OVERLAP * sizeof(int16_t));
+    smoothFade(m_dec->xBuf + CC * OPUS_OVERLAP, pcm + CC * OPUS_OVERLAP, pcm + CC * OPUS_OVERLAP, CC);
+}
+
+static int8_t decodeFrame(const uint8_t* data, int len, int16_t* pcm){
+    // one Opus frame in the order of opus_decode_frame(), data == NULL: the frame is lost. The first 20ms are output to
+    // pcm, the rest of a 40 or 60ms SILK frame waits in silkBuf for decodeChunk()
+    // Return: ERR_OPUS_NONE or ERR_OPUS_FRAME_CORRUPT, the samples are output in both cases
+    static const uint8_t endBands[5] = {13, 17, 17, 19, 21};  // NB, MB, WB, SWB, FB
+    OpusDecoder_t* d = m_dec;
+    int CC = d->channels;
+    uint8_t toc = d->toc;
+    int audioSize = samplesPerFrame(toc);
+    d->chunkSamples = imin(audioSize, OPUS_MAX_FRAME_SIZE);
+    d->chunkCount = audioSize / d->chunkSamples;
+    d->chunkIdx = 1;
+    d->f_fadeOut = false;
+    d->f_lost = data == NULL;
+    int C = (toc & 0x04) ? 2 : 1;
+    int bw = (toc >> 5) & 3;
+    int mode;
+    if(toc & 0x80){
+        mode = OPUS_MODE_CELT;
+        bw = bw ? bw + 1 : 0;  // no MB
+    }
+    else if((toc & 0x60) == 0x60){
+        mode = OPUS_MODE_HYBRID;
+        bw = (toc & 0x10) ? 4 : 3;
+    }
+    else mode = OPUS_MODE_SILK;
+    int end = endBands[bw];
+
+    if(!data){  // the last mode goes on, CELT after a redundant frame
+        mode = d->prevRedundancy ? (int)OPUS_MODE_CELT : d->prevMode;
+        d->mode = mode;
+        if(mode == OPUS_MODE_SILK || mode == OPUS_MODE_HYBRID){  // each 20ms as a packet of their own
+            int ms = imax(10, d->chunkSamples / 48);
+            for(int k = 0; k < d->chunkCount; k++) silkDecode(NULL, d->silkChannels, d->silk[0].fsKHz, ms, k);
+        }
+        if(mode == OPUS_MODE_CELT || mode == OPUS_MODE_HYBRID){
+            celtDecode(NULL, NULL, 0, pcm, ilog(d->chunkSamples / SHORT_MDCT_SIZE) - 1, C,
+                       mode == OPUS_MODE_HYBRID ? 17 : 0, end);
+        }
+        else memset(pcm, 0, d->chunkSamples * CC * sizeof(int16_t));
+        if(mode == OPUS_MODE_SILK || mode == OPUS_MODE_HYBRID) silkAddFrame(0, pcm);
+        d->finalRange = 0;
+        d->prevMode = mode;
+        d->prevRedundancy = false;
+        return ERR_OPUS_NONE;
+    }
+    d->mode = mode;
+
+    // CELT to or from SILK without a redundant frame: 5ms of the old mode's concealment are faded in
+    bool transition = d->prevMode != OPUS_MODE_NONE &&
+                      ((mode == OPUS_MODE_CELT && d->prevMode != OPUS_MODE_CELT && !d->prevRedundancy) ||
+                       (mode != OPUS_MODE_CELT && d->prevMode == OPUS_MODE_CELT));
+    int transitionLM = audioSize >= 2 * SHORT_MDCT_SIZE ? 1 : 0;
+    if(transition && mode == OPUS_MODE_CELT){
+        if(d->prevMode == OPUS_MODE_HYBRID) celtDecode(NULL, NULL, 0, d->xBuf, transitionLM, C, 17, end);
+        else memset(d->xBuf, 0, CC * (SHORT_MDCT_SIZE << transitionLM) * sizeof(int16_t));  // SILK is not concealed
+    }
+
+    RangeDec_t ec;
+    ecInit(&ec, data, len);
+    if(mode != OPUS_MODE_CELT){
+        if(d->prevMode == OPUS_MODE_CELT) silkReset();
+        int fsKHz = mode == OPUS_MODE_HYBRID ? 16 : 8 + 4 * bw;
+        for(int k = 0; k < d->chunkCount; k++) silkDecode(&ec, C, fsKHz, audioSize / 48, k);
+    }
+
+    // a redundant 5ms CELT frame at the end of the frame: SILK or hybrid to CELT, or CELT to SILK or hybrid
+    bool redundancy = false, celtToSilk = false;
+    int redundancyBytes = 0;
+    uint32_t redundantRng = 0;
+    if(mode != OPUS_MODE_CELT && ecTell(&ec) + 17 + 20 * (mode == OPUS_MODE_HYBRID) <= 8 * len){
+        redundancy = mode == OPUS_MODE_HYBRID ? ecBitLogp(&ec, 12) : true;
+        if(redundancy){
+            celtToSilk = ecBitLogp(&ec, 1);
+            redundancyBytes = mode == OPUS_MODE_HYBRID ? ecUint(&ec, 256) + 2 : len - ((ecTell(&ec) + 7) >> 3);
+            len -= redundancyBytes;
+            if(len * 8 < ecTell(&ec)){  // not a valid packet
+                len = 0;
+                redundancyBytes = 0;
+                redundancy = false;
+            }
+            ec.storage -= redundancyBytes;
+        }
+    }
+    if(redundancy) transition = false;
+    if(transition && mode != OPUS_MODE_CELT) celtDecode(NULL, NULL, 0, d->xBuf, transitionLM, C, 0, end);
+    if(redundancy && celtToSilk){  // decoded for the final range even if it is not used
+        celtDecode(NULL, data + len, redundancyBytes, d->xBuf, 1, C, 0, end);
+        redundantRng = d->rng;
+    }
+
+    int8_t ret = ERR_OPUS_NONE;
+    if(mode != OPUS_MODE_SILK){
+        if(mode != d->prevMode && d->prevMode != OPUS_MODE_NONE && !d->prevRedundancy) celtReset();
+        int LM = mode == OPUS_MODE_CELT ? (toc >> 3) & 3 : ilog(audioSize / SHORT_MDCT_SIZE) - 1;
+        ret = celtDecode(&ec, data, len, pcm, LM, C, mode == OPUS_MODE_HYBRID ? 17 : 0, end);
+    }
+    else{
+        memset(pcm, 0, d->chunkSamples * CC * sizeof(int16_t));
+        if(d->prevMode == OPUS_MODE_HYBRID && !(redundancy && celtToSilk && d->prevRedundancy)){
+            static const uint8_t silence[2] = {0xFF, 0xFF};  // the CELT MDCT fades the hybrid frame out
+            celtDecode(NULL, silence, 2, pcm, 0, C, 0, end);
+        }
+    }
+    if(mode != OPUS_MODE_CELT) silkAddFrame(0, pcm);
+
+    if(redundancy && !celtToSilk){
+        celtReset();
+        celtDecode(NULL, data + len, redundancyBytes, d->xBuf, 1, C, 0, end);
+        redundantRng = d->rng;
+        d->f_fadeOut = true;
+        if(d->chunkCount == 1) fadeToRedundancy(pcm);
+    }
+    if(redundancy && celtToSilk && (d->prevMode != OPUS_MODE_SILK || d->prevRedundancy)) fadeFromXBuf(pcm);
+    if(transition){
+        if(audioSize >= 2 * SHORT_MDCT_SIZE) fadeFromXBuf(pcm);
+        else smoothFade(d->xBuf, pcm, pcm, CC);
+    }
+    d->finalRange = len <= 1 ? 0 : ec.rng ^ redundantRng;
+    d->prevMode = mode;
+    d->prevRedundancy = redundancy && !celtToSilk;
+    return ret;
+}
+
+static void decodeChunk(int16_t* pcm){
+    // the next 20ms of a 40 or 60ms SILK frame or of their concealment
+    OpusDecoder_t* d = m_dec;
+    int k = d->chunkIdx++;
+    if(d->f_lost && (d->mode == OPUS_MODE_CELT || d->mode == OPUS_MODE_HYBRID)){
+        celtDecode(NULL, NULL, 0, pcm, MAX_LM, d->channels, d->mode == OPUS_MODE_HYBRID ? 17 : 0, OPUS_NB_EBANDS);
+    }
+    else memset(pcm, 0, d->chunkSamples * d->channels * sizeof(int16_t));
+    if(d->mode == OPUS_MODE_SILK || d->mode == OPUS_MODE_HYBRID) silkAddFrame(k, pcm);
+    if(k == d->chunkCount - 1 && d->f_fadeOut) fadeToRedundancy(pcm);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          O P U S   I N I   S E C T I O N
+//----------------------------------------------------------------------------------------------------------------------
+// the internal RAM buffers are carved from the arena, the heap is only asked if it is full
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+    #define OPUS_RAM    ARENA_PREFER_PSRAM      // ESP32-S3: If there is PSRAM, prefer it
+#else
+    #define OPUS_RAM    ARENA_PREFER_INTERNAL   // ESP32, PSRAM is too slow, prefer SRAM
+#endif
+#define __malloc_opus(size) ArenaMalloc(size, OPUS_RAM)
+
+OpusDecoder_t* OPUSDecoder_Create(void){
+    OpusDecoder_t* dec = (OpusDecoder_t*) __malloc_opus(sizeof(OpusDecoder_t));
+    if(!dec){
+        log_e("not enough memory to allocate the opus decoder");
+        return NULL;
+    }
+    memset(dec, 0, sizeof(OpusDecoder_t));
+    bool ok = true;
+    for(int c = 0; c < OPUS_MAX_CHANNELS; c++){
+        dec->decodeMem[c] = (int32_t*)__malloc_opus((OPUS_DECODE_BUFFER + OPUS_OVERLAP) * sizeof(int32_t));
+        ok &= dec->decodeMem[c] != NULL;
+    }
+    // X and norm in one block, freq and fftBuf in one block
+    dec->X    = (int16_t*)__malloc_opus((2 * OPUS_MAX_FRAME_SIZE + 2 * NORM_SIZE) * sizeof(int16_t));
+    dec->freq = (int32_t*)__malloc_opus(2 * OPUS_MAX_FRAME_SIZE * sizeof(int32_t));
+    dec->silkBuf = (int16_t*)__malloc_opus(SILK_BUF_SIZE * sizeof(int16_t));  // silkBuf and xBuf
+    if(!ok || !dec->X || !dec->freq || !dec->silkBuf){
+        log_e("not enough memory to allocate opusdecoder buffers");
+        OPUSDecoder_Destroy(dec);
+        return NULL;
+    }
+    dec->norm = dec->X + 2 * OPUS_MAX_FRAME_SIZE;
+    dec->fftBuf = dec->freq + OPUS_MAX_FRAME_SIZE;
+    dec->xBuf = dec->silkBuf + 2 * SILK_MAX_FRAMES * SILK_BUF_STRIDE;
+    dec->channels = 2;
+    OPUSDecoderReset(dec);
+    return dec;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool OPUSDecoder_AllocateBuffers(void){
+    if(!m_defaultDec) m_defaultDec = OPUSDecoder_Create();
+    else OPUSDecoderReset(m_defaultDec);
+    return m_defaultDec != NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t OPUSDecoder_BufferSize(void){
+    // arena bytes of one context
+    return ArenaBlockSize(sizeof(OpusDecoder_t), OPUS_RAM) +
+           OPUS_MAX_CHANNELS * ArenaBlockSize((OPUS_DECODE_BUFFER + OPUS_OVERLAP) * sizeof(int32_t), OPUS_RAM) +
+           ArenaBlockSize((2 * OPUS_MAX_FRAME_SIZE + 2 * NORM_SIZE) * sizeof(int16_t), OPUS_RAM) +
+           ArenaBlockSize(2 * OPUS_MAX_FRAME_SIZE * sizeof(int32_t), OPUS_RAM) +
+           ArenaBlockSize(SILK_BUF_SIZE * sizeof(int16_t), OPUS_RAM);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OPUSDecoder_Destroy(OpusDecoder_t* dec){
+    if(!dec) return;
+    if(m_dec == dec) m_dec = NULL;
+    for(int c = 0; c < OPUS_MAX_CHANNELS; c++) ArenaFree(dec->decodeMem[c]);
+    ArenaFree(dec->X);
+    ArenaFree(dec->freq);
+    ArenaFree(dec->silkBuf);
+    ArenaFree(dec);
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OPUSDecoder_FreeBuffers(){
+    OPUSDecoder_Destroy(m_defaultDec);
+    m_defaultDec = NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OPUSDecoderReset(OpusDecoder_t* dec){
+    // after a seek or a decode error, the OpusHead values are kept. The pre-skip is not repeated.
+    m_dec = dec;
+    celtReset();
+    silkReset();
+    dec->silkChannels = 0;
+    dec->prevMode = OPUS_MODE_NONE;
+    dec->prevRedundancy = false;
+    dec->frameCount = dec->frameIdx = 0;
+    dec->chunkCount = dec->chunkIdx = 0;
+    dec->validSamples = 0;
+}
+void OPUSDecoderReset(){
+    if(m_defaultDec) OPUSDecoderReset(m_defaultDec);
+}
+//----------------------------------------------------------------------------------------------------------------------
+int8_t OPUSParseOpusHead(OpusDecoder_t* dec, uint8_t *inbuf, int nBytes){
+    // the identification header (RFC 7845 section 5.1), the first packet of the stream
+    if(nBytes < 19 || memcmp(inbuf, "OpusHead", 8) || (inbuf[8] >> 4) != 0) return ERR_OPUS_HEADER;
+    uint8_t channels = inbuf[9];
+    if(channels < 1 || channels > OPUS_MAX_CHANNELS || inbuf[18] != 0){  // mapping family 0 only
+        log_e("opus with %d channels, mapping family %d is not supported", channels, inbuf[18]);
+        return ERR_OPUS_CHANNELS_OUT_OF_RANGE;
+    }
+    dec->channels = channels;
+    dec->preSkip = inbuf[10] | (inbuf[11] << 8);
+    dec->inputSampleRate = inbuf[12] | (inbuf[13] << 8) | (inbuf[14] << 16) | ((uint32_t)inbuf[15] << 24);
+    dec->outputGain = (int16_t)(inbuf[16] | (inbuf[17] << 8));
+    dec->gainQ16 = 0;
+    if(dec->outputGain){  // 10^(gain / (20 * 256)) = 2^(gain * 0.000648765), limited to +-84dB
+        int32_t lg = imax(-(14 << DB_SHIFT), imin((14 << DB_SHIFT), dec->outputGain * 42517 / 1000));
+        dec->gainQ16 = exp2Q30(lg - (14 << DB_SHIFT));
+    }
+    dec->skipLeft = dec->preSkip;
+    dec->framesDecoded = dec->framesLost = 0;
+    OPUSDecoderReset(dec);
+    return ERR_OPUS_NONE;
+}
+int8_t OPUSParseOpusHead(uint8_t *inbuf, int nBytes){
+    if(!m_defaultDec) return ERR_OPUS_NOT_INITIALIZED;
+    return OPUSParseOpusHead(m_defaultDec, inbuf, nBytes);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//          D E C O D E R
+//----------------------------------------------------------------------------------------------------------------------
+int8_t OPUSDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf){
+    if(!m_defaultDec) return ERR_OPUS_NOT_INITIALIZED;
+    return OPUSDecode(m_defaultDec, inbuf, bytesLeft, outbuf);
+}
+int8_t OPUSDecode(OpusDecoder_t* dec, uint8_t *inbuf, int *bytesLeft, short *outbuf){
+    // inbuf holds one whole packet (*bytesLeft bytes), it is decoded in parts of at most 20ms, one frame or 20ms of a
+    // longer SILK frame per call: OPUS_CONTINUE returns the samples of a part and nothing is consumed, the next call has
+    // to pass the same packet. The last part consumes the packet and returns ERR_OPUS_NONE.
+    m_dec = dec;
+    m_dec->validSamples = 0;
+
+    if(m_dec->frameIdx >= m_dec->frameCount && m_dec->chunkIdx >= m_dec->chunkCount){  // a new packet
+        m_dec->packetLen = *bytesLeft;
+        if(m_dec->packetLen == 0){  // lost, one frame of the last frame size is concealed
+            m_dec->frameCount = 1;
+            m_dec->frameIdx = 0;
+            m_dec->frameSize[0] = 0;
+        }
+        else{
+            int8_t ret = parsePacket(inbuf, m_dec->packetLen);
+            if(ret){
+                m_dec->frameCount = m_dec->frameIdx = 0;
+                return ret;
+            }
+        }
+    }
+
+    int8_t ret;
+    if(m_dec->chunkIdx < m_dec->chunkCount){  // the rest of a long SILK frame
+        decodeChunk(outbuf);
+        ret = ERR_OPUS_NONE;
+    }
+    else{
+        uint16_t size = m_dec->frameSize[m_dec->frameIdx];
+        const uint8_t* data = size > 1 ? inbuf + m_dec->frameOffset[m_dec->frameIdx] : NULL;
+        m_dec->frameIdx++;
+        if(data) m_dec->framesDecoded++;
+        else     m_dec->framesLost++;
+        ret = decodeFrame(data, size, outbuf);
+    }
+    if(ret){
+        m_dec->frameCount = m_dec->frameIdx = 0;
+        m_dec->chunkCount = m_dec->chunkIdx = 0;
+        return ret;
+    }
+
+    int samples = m_dec->chunkSamples;
+    if(m_dec->skipLeft){  // pre-skip, the encoder delay at the stream begin
+        int n = imin(m_dec->skipLeft, samples);
+        m_dec->skipLeft -= n;
+        samples -= n;
+        memmove(outbuf, outbuf + n * m_dec->channels, samples * m_dec->channels * sizeof(int16_t));
+    }
+    m_dec->validSamples = samples * m_dec->channels;
+
+    if(m_dec->frameIdx < m_dec->frameCount || m_dec->chunkIdx < m_dec->chunkCount) return OPUS_CONTINUE;
+    *bytesLeft -= m_dec->packetLen;
+    return ERR_OPUS_NONE;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint16_t OPUSGetOutputSamps(OpusDecoder_t* dec){  // all channels
+    int vs = dec->validSamples;
+    dec->validSamples = 0;
+    return vs;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint8_t OPUSGetChannels(OpusDecoder_t* dec){
+    return dec->channels;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t OPUSGetSampRate(OpusDecoder_t* dec){  // the decoder always runs at 48kHz
+    (void)dec;
+    return 48000;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint8_t OPUSGetBitsPerSample(OpusDecoder_t* dec){
+    (void)dec;
+    return 16;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t OPUSGetBitRate(OpusDecoder_t* dec){  // of the last packet
+    return dec->bitRate;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t OPUSGetFinalRange(OpusDecoder_t* dec){  // compare with the encoder's OPUS_GET_FINAL_RANGE
+    return dec->finalRange;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint16_t OPUSGetOutputSamps()    {return m_defaultDec ? OPUSGetOutputSamps(m_defaultDec) : 0;}
+uint8_t  OPUSGetChannels()       {return m_defaultDec ? OPUSGetChannels(m_defaultDec) : 0;}
+uint32_t OPUSGetSampRate()       {return 48000;}
+uint8_t  OPUSGetBitsPerSample()  {return 16;}
+uint32_t OPUSGetBitRate()        {return m_defaultDec ? OPUSGetBitRate(m_defaultDec) : 0;}
+uint32_t OPUSGetFinalRange()     {return m_defaultDec ? OPUSGetFinalRange(m_defaultDec) : 0;}
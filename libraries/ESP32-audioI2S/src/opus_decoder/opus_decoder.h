@@ -0,0 +1,146 @@
+/*
+ * opus_decoder.h
+ *
+ * Opus (RFC 6716) in an Ogg container (RFC 7845), one packet per OPUSDecode() call sequence
+ *
+ *  CELT, SILK and hybrid frames and the transitions between them (redundant CELT frames, cross fades) as libopus
+ *  decodes them, SILK in the fixed point arithmetic of the reference: a SILK only stream is bit exact
+ *
+ *  Restrictions:
+ *  channel mapping family 0 (mono or stereo), the output is 48kHz 16 bit
+ *  lost packets (length 0 or 1) are replaced by the decay of the last CELT frame and silence for SILK, there is no
+ *  pitch based concealment, no comfort noise and the SILK redundancy (LBRR) is skipped
+ *
+ */
+#pragma once
+
+#include "Arduino.h"
+
+#define OPUS_MAX_CHANNELS     2
+#define OPUS_MAX_FRAME_SIZE   960     // samples per channel of one CELT frame (20ms)
+#define OPUS_MAX_FRAMES       48      // frames per packet (120ms of 2.5ms frames)
+#define OPUS_OVERLAP          120     // MDCT window overlap
+#define OPUS_DECODE_BUFFER    2048    // synthesis history per channel, the postfilter looks back up to 1024 samples
+#define OPUS_NB_EBANDS        21
+#define SILK_MAX_FRAME        320     // samples of one SILK frame (20ms at 16kHz)
+#define SILK_MAX_ORDER        16      // LPC order (wideband)
+#define SILK_MAX_FRAMES       3       // SILK frames per Opus frame (60ms)
+
+enum : int8_t  {OPUS_CONTINUE = +1,               // a frame is output, the packet has more of them
+                ERR_OPUS_NONE = 0,
+                ERR_OPUS_CHANNELS_OUT_OF_RANGE = -1,
+                ERR_OPUS_INVALID_PACKET = -2,
+                ERR_OPUS_NOT_INITIALIZED = -3,
+                ERR_OPUS_OUT_OF_MEMORY = -4,
+                ERR_OPUS_HEADER = -5,
+                ERR_OPUS_FRAME_CORRUPT = -6};    // the frame used more bits than it has
+
+/* state of one SILK channel (mid or side), silk_decoder_state of the reference without the concealment and CNG */
+typedef struct SilkChannel {
+    int32_t   prevGainQ16;                  // gain of the last subframe
+    int32_t   sLPCQ14[SILK_MAX_ORDER];      // LPC synthesis filter state
+    int32_t   rsIIR[6];                     // resampler to 48kHz: 2x upsampler allpass state
+    int32_t   rsInvRatioQ16;                //     input step per output sample
+    int16_t   rsFIR[8];                     //     fractional interpolation FIR state
+    int16_t   rsDelayBuf[16];               //     1ms of input
+    uint8_t   rsInputDelay;                 //     samples
+    int16_t   outBuf[2 * SILK_MAX_FRAME];   // output history, the LTP filter looks back 20ms
+    int16_t   prevNLSFQ15[SILK_MAX_ORDER];  // NLSFs of the last frame, interpolated in the first half of a 20ms frame
+    uint8_t   fsKHz;                        // internal rate 8, 12, 16kHz, 0: not yet set
+    uint8_t   nbSubfr;                      // subframes of 5ms, 2 (10ms) or 4 (20ms)
+    uint8_t   lpcOrder;                     // 10 narrow and medium band, 16 wide band
+    uint8_t   subfrLength;
+    uint16_t  frameLength;
+    uint16_t  ltpMemLength;
+    int8_t    lastGainIndex;
+    uint8_t   ecPrevSignalType;             // of the last frame, the conditional coding depends on it
+    int16_t   ecPrevLagIndex;
+    bool      firstFrameAfterReset;
+    uint8_t   nFramesDecoded;               // of the Opus frame in work
+    uint8_t   nFramesPerPacket;             // SILK frames per Opus frame
+    uint8_t   vadFlags[SILK_MAX_FRAMES];
+    uint8_t   lbrrFlags[SILK_MAX_FRAMES];
+} SilkChannel_t;
+
+/* all state of one decoder instance, created by OPUSDecoder_Create()
+ * The synthesis state (IMDCT overlap, postfilter history, band energies, SILK filters) lives in the context, the
+ * scratch buffers of one frame are allocated with it, from the arena (audio_arena.h) or in PSRAM. Cost per context on
+ * ESP32: 3.7KB plus decodeMem 17344, X/norm 6336, freq/fftBuf 7680 and silkBuf 4824 bytes, 39.0KB for a stereo stream.
+ * The tables (12.7KB, 5.5KB of them SILK) are in flash.
+ */
+typedef struct OpusDecoder {
+    int32_t*  decodeMem[OPUS_MAX_CHANNELS]; // OPUS_DECODE_BUFFER + OPUS_OVERLAP signal samples per channel
+    int16_t*  X;                            // normalized spectrum of both channels, Q14
+    int16_t*  norm;                         // folding source, the normalized bands decoded so far
+    int32_t*  freq;                         // denormalized spectrum of one channel, IMDCT input
+    int32_t*  fftBuf;                       // complex FFT input of one (short) block
+    int32_t   oldBandE[2 * OPUS_NB_EBANDS]; // band energies, log2 Q16
+    int32_t   oldLogE[2 * OPUS_NB_EBANDS];  // energies of the frames before, used by the anti-collapse noise
+    int32_t   oldLogE2[2 * OPUS_NB_EBANDS];
+    int32_t   preemphMem[OPUS_MAX_CHANNELS];// deemphasis filter state
+    uint32_t  rng;                          // range coder state of the last frame, seeds the folding noise
+    uint16_t  pfPeriod,  pfPeriodOld;       // postfilter (pitch comb filter) of this and of the last frame
+    int16_t   pfGain,    pfGainOld;         // Q15
+    uint8_t   pfTapset,  pfTapsetOld;
+    SilkChannel_t silk[OPUS_MAX_CHANNELS];  // mid and side
+    int16_t*  silkBuf;                      // decoded SILK frames of the Opus frame in work, 2 samples history each
+    int16_t*  xBuf;                         // 5ms of CELT: redundant frame or transition
+    int16_t   silkPredPrevQ13[2];           // stereo predictor of the last frame
+    int16_t   silkSMid[2];                  // last samples of mid and side, mid/side to left/right is 1 sample late
+    int16_t   silkSSide[2];
+    uint8_t   silkChannels;                 // coded channels of the last SILK frame
+    bool      silkPrevDecodeOnlyMiddle;     // the side channel of the last frame was not coded
+    bool      silkStereoToMono;             // the first SILK frame of the Opus frame in work switched stereo to mono
+    uint8_t   prevMode;                     // coding mode of the last frame, 0: none yet
+    bool      prevRedundancy;               // the last frame ended with a redundant CELT frame (SILK to CELT)
+    uint8_t   channels;                     // OpusHead: output channels 1 or 2
+    uint16_t  preSkip;                      // OpusHead: samples to drop at the stream begin
+    int16_t   outputGain;                   // OpusHead: Q7.8 dB
+    int32_t   gainQ16;                      // linear output gain, 0: unity
+    uint32_t  inputSampleRate;              // OpusHead: rate of the encoder input, informational
+    uint16_t  skipLeft;                     // pre-skip samples not yet dropped
+    uint8_t   toc;                          // TOC byte of the packet in work
+    uint8_t   frameCount;                   // frames of the packet in work
+    uint8_t   frameIdx;                     // next frame to decode, frameCount: no packet in work
+    uint16_t  frameOffset[OPUS_MAX_FRAMES]; // position of each frame in the packet
+    uint16_t  frameSize[OPUS_MAX_FRAMES];   // bytes of each frame
+    uint16_t  packetLen;                    // bytes of the packet in work including the padding
+    uint8_t   mode;                         // coding mode of the frame in work
+    uint8_t   chunkCount;                   // 20ms parts of the frame in work (40, 60ms SILK frames are output in
+    uint8_t   chunkIdx;                     // parts), next part to output
+    uint16_t  chunkSamples;                 // per channel
+    bool      f_lost;                       // the frame in work is lost
+    bool      f_fadeOut;                    // fade the end of the frame in work to the redundant CELT frame in xBuf
+    uint16_t  validSamples;                 // samples (all channels) of the last output
+    uint32_t  bitRate;
+    uint32_t  finalRange;                   // range coder state after the last frame, libopus OPUS_GET_FINAL_RANGE
+    uint32_t  framesDecoded;                // statistics
+    uint32_t  framesLost;
+} OpusDecoder_t;
+
+// prototypes, the functions without decoder context work on a default instance
+bool     OPUSDecoder_AllocateBuffers(void);
+void     OPUSDecoder_FreeBuffers();
+size_t   OPUSDecoder_BufferSize(void);  // bytes OPUSDecoder_AllocateBuffers() takes from the arena
+void     OPUSDecoderReset();
+int8_t   OPUSParseOpusHead(uint8_t *inbuf, int nBytes);
+int8_t   OPUSDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf);
+uint16_t OPUSGetOutputSamps();
+uint8_t  OPUSGetChannels();
+uint32_t OPUSGetSampRate();
+uint8_t  OPUSGetBitsPerSample();
+uint32_t OPUSGetBitRate();
+uint32_t OPUSGetFinalRange();
+
+// reentrant API, every context decodes its own stream
+OpusDecoder_t* OPUSDecoder_Create(void);
+void     OPUSDecoder_Destroy(OpusDecoder_t* dec);
+void     OPUSDecoderReset(OpusDecoder_t* dec);
+int8_t   OPUSParseOpusHead(OpusDecoder_t* dec, uint8_t *inbuf, int nBytes);
+int8_t   OPUSDecode(OpusDecoder_t* dec, uint8_t *inbuf, int *bytesLeft, short *outbuf);
+uint16_t OPUSGetOutputSamps(OpusDecoder_t* dec);
+uint8_t  OPUSGetChannels(OpusDecoder_t* dec);
+uint32_t OPUSGetSampRate(OpusDecoder_t* dec);
+uint8_t  OPUSGetBitsPerSample(OpusDecoder_t* dec);
+uint32_t OPUSGetBitRate(OpusDecoder_t* dec);
+uint32_t OPUSGetFinalRange(OpusDecoder_t* dec);
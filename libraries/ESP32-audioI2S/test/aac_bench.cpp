@@ -0,0 +1,75 @@
+/*
+ * aac_bench.cpp
+ *
+ * CPU cycles per AAC frame and of its stages, for HE-AAC the SBR part: QMF analysis, HF generation and adjustment,
+ * QMF synthesis. Frames per second and how many times faster than real time.
+ *
+ *  built with AAC_PROFILE, the profile counters of the decoder are read after every frame. Each file is decoded
+ *  several times, the fastest pass is reported, the others are disturbed by the host.
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "aac_decoder/aac_decoder.h"
+
+#ifndef AAC_PROFILE
+    #error "aac_bench needs AAC_PROFILE"
+#endif
+
+static const char* files[] = {"test_128k_stereo.aac", "test_48k_mono_32kHz.aac", "test_192k_stereo_48kHz.aac",
+                               "test_he_aac_stereo.aac"};
+static const int   passes  = 20;
+
+static void bench(const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> d = loadFile(path);
+    std::vector<int16_t> pcm(2 * 2048);
+    enum {FRAME, NOISELESS, IMDCT, SBR, QMFA, HF, QMFS, N};
+    uint64_t best[N];
+    for(auto& b : best) b = ~0ULL;
+    double bestTime = 1e9;                                       // seconds per frame
+    int    sampRate = 0, samps = 0;
+
+    for(int k = 0; k < passes; k++) {
+        uint64_t sum[N] = {0};
+        uint32_t frames = 0, profiled = 0;
+        AACDecoder_t* dec = AACDecoder_Create();
+        int left = d.size();
+        double t = seconds();
+        while(left > 7) {
+            uint64_t before[N] = {0, dec->profNoiseless, dec->profImdct, dec->profSBR, dec->profQMFA, dec->profHF,
+                                  dec->profQMFS};
+            uint32_t t0 = ESP.getCycleCount();
+            int err = AACDecode(dec, d.data() + d.size() - left, &left, pcm.data());
+            uint32_t t1 = ESP.getCycleCount();
+            if(err) break;
+            sum[FRAME] += t1 - t0;
+            frames++;
+            if(dec->profFrames == 0) continue;                   // the decoder has just logged and cleared its counters
+            uint64_t after[N] = {0, dec->profNoiseless, dec->profImdct, dec->profSBR, dec->profQMFA, dec->profHF,
+                                 dec->profQMFS};
+            for(int i = NOISELESS; i < N; i++) sum[i] += after[i] - before[i];
+            profiled++;
+        }
+        bestTime = std::min(bestTime, (seconds() - t) / frames);
+        sampRate = AACGetSampRate(dec);
+        samps    = AACGetOutputSamps(dec) / AACGetChannels(dec);
+        AACDecoder_Destroy(dec);
+        best[FRAME] = std::min(best[FRAME], sum[FRAME] / frames);
+        for(int i = NOISELESS; i < N; i++) best[i] = std::min(best[i], sum[i] / profiled);
+    }
+    printf("%-26s %6.0f frames/s (%4.0fx real time), %7llu cycles/frame, noiseless+dequant %6llu, PNS/TNS/IMDCT %6llu",
+           name, 1 / bestTime, samps / (bestTime * sampRate), (unsigned long long)best[FRAME],
+           (unsigned long long)best[NOISELESS], (unsigned long long)best[IMDCT]);
+    if(best[SBR]) printf(", SBR %6llu (QMF analysis %6llu, HF gen+adj %6llu, QMF synthesis %6llu)",
+                         (unsigned long long)best[SBR], (unsigned long long)best[QMFA], (unsigned long long)best[HF],
+                         (unsigned long long)best[QMFS]);
+    printf("\n");
+}
+
+int main() {
+    printf("AAC\n");
+    for(auto f : files) bench(f);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * aac_test.cpp
+ *
+ * bit exactness of the AAC decoder: the pcm of the test files must be the same as that of the Helix code the decoder
+ * is based on (CRC-32 of the pcm and number of frames, taken from the decoder before the optimizations)
+ *
+ *  the LC files have long and short blocks, TNS and PNS, mono and stereo at 32, 44.1 and 48kHz, they cover the spectral
+ *  Huffman tables and the DCT4/R4FFT of both block lengths. test_he_aac_stereo.aac is HE-AAC (implicit SBR, 22.05kHz
+ *  core), it covers the SBR QMF and HF kernels, test_he_aac_mono.aac (24kHz core, no PS) has to be output in mono. The
+ *  frame count is that of the ADTS frames in the file, none may be dropped.
+ *
+ *  test_he_aacv2_20band.aac and test_he_aacv2_34band.aac are HE-AACv2 with parametric stereo (10/20 and 34 band
+ *  parameters, mono 24kHz core), Helix has no PS: their CRC is that of this decoder, checked against ffmpeg with a
+ *  median SNR per 2048 samples of 80dB (20 bands) and 57dB (34 bands, mapped to 20). They have to be output in stereo
+ *  with L != R.
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "aac_decoder/aac_decoder.h"
+
+static const struct {
+    const char* file;
+    uint32_t    crc;
+    int         frames;
+    int         channels;                                        // AACGetChannels() after the last frame
+    bool        lr;                                              // a frame with L != R, a PS stream is not mono
+} golden[] = {
+    {"test_128k_stereo.aac",       0xa2e591ba, 260, 2, true },
+    {"test_he_aac_stereo.aac",     0x31e88d8b, 130, 2, true },
+    {"test_he_aac_mono.aac",       0xd7718608, 100, 1, false},
+    {"test_48k_mono_32kHz.aac",    0xdc25624b, 126, 1, false},
+    {"test_192k_stereo_48kHz.aac", 0xaa88ca1a, 142, 2, true },
+    {"test_he_aacv2_20band.aac",   0xf3c5bf9f, 100, 2, true },
+    {"test_he_aacv2_34band.aac",   0x3e86ccfe, 100, 2, true },
+};
+
+/* decodes the whole file, returns the number of frames, *lr: a stereo frame with L != R was output */
+static int decodeFile(const char* name, uint32_t* crc, bool* lr) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> d = loadFile(path);
+    std::vector<int16_t> pcm(2 * 2048);
+    int left = d.size();
+    int frames = 0;
+    *crc = 0;
+    *lr = false;
+    while(left > 7) {
+        int err = AACDecode(d.data() + d.size() - left, &left, pcm.data());
+        if(err == ERR_AAC_INDATA_UNDERFLOW) break;               // incomplete last frame
+        if(err) {
+            printf("FAIL: %s, AACDecode error %i in frame %i\n", name, err, frames);
+            exit(1);
+        }
+        *crc = crc32(*crc, pcm.data(), AACGetOutputSamps() * 2);
+        for(int i = 0; AACGetChannels() == 2 && !*lr && i < AACGetOutputSamps(); i += 2) *lr = pcm[i] != pcm[i + 1];
+        frames++;
+    }
+    return frames;
+}
+
+int main() {
+    int fails = 0;
+    for(auto& g : golden) {
+        uint32_t crc;
+        bool     lr;
+        if(!AACDecoder_AllocateBuffers()) {
+            printf("FAIL: AACDecoder_AllocateBuffers\n");
+            return 1;
+        }
+        int frames = decodeFile(g.file, &crc, &lr);
+        int channels = AACGetChannels();
+        AACDecoder_FreeBuffers();
+        bool ok = crc == g.crc && frames == g.frames && channels == g.channels && lr == g.lr;
+        printf("%-28s %4i frames, crc %08x, %i channels%s %s\n", g.file, frames, crc, channels, lr ? ", L != R" : "",
+               ok ? "ok" : "FAIL");
+        if(!ok) fails++;
+    }
+    printf("aac: %s\n", fails ? "FAIL" : "bit exact");
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * flac_bench.cpp
+ *
+ * CPU cycles per sample (inter-channel) of the FLAC subframes and of their rice coded residuals, frames per second and
+ * how many times faster than real time
+ *
+ *  built with FLAC_PROFILE twice: flac_bench with the clz rice partition decoder and 32 bit refills, flac_bench_ref
+ *  with FLAC_RICE_REFERENCE (bit by bit unary codes, byte refills). The fastest of several passes is reported.
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "flac_decoder/flac_decoder.h"
+
+#ifndef FLAC_PROFILE
+    #error "flac_bench needs FLAC_PROFILE"
+#endif
+
+static const char* files[] = {"test_16bit_stereo.flac"};
+static const int   passes  = 20;
+
+static void bench(const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> d = loadFile(path);
+    std::vector<int16_t> pcm(2 * 2048);
+    uint64_t bestSubframes = ~0ULL, bestResidual = ~0ULL;
+    double   bestFrame = 1e9, bestSample = 1e9;                  // seconds
+    uint32_t sampRate = 0;
+
+    for(int k = 0; k < passes; k++) {
+        uint64_t cycles = 0, residual = 0, samples = 0, total = 0, frames = 0;
+        FLACDecoder_t* dec = FLACDecoder_Create();
+        int left = d.size() - skipFLACMetadata(d);
+        double t0 = seconds();
+        while(left > 0) {
+            uint64_t cy = dec->profCycles, re = dec->profResidual, sa = dec->profSamples;
+            int err = FLACDecode(dec, d.data() + d.size() - left, &left, pcm.data());
+            if(err < 0) break;
+            int samps = FLACGetOutputSamps(dec);
+            total += samps / FLACGetChannels(dec);
+            if(samps && err == ERR_FLAC_NONE) frames++;
+            if(dec->profFrames == 0) continue;                   // the decoder has just logged and cleared its counters
+            cycles   += dec->profCycles - cy;
+            residual += dec->profResidual - re;
+            samples  += dec->profSamples - sa;
+        }
+        double t = seconds() - t0;
+        bestFrame  = std::min(bestFrame, t / frames);
+        bestSample = std::min(bestSample, t / total);
+        sampRate = FLACGetSampRate(dec);
+        FLACDecoder_Destroy(dec);
+        bestSubframes = std::min(bestSubframes, cycles / samples);
+        bestResidual  = std::min(bestResidual, residual / samples);
+    }
+    printf("%-26s %6.0f frames/s (%4.0fx real time), per sample subframes %4llu cycles, residuals %4llu\n", name,
+           1 / bestFrame, 1 / (bestSample * sampRate), (unsigned long long)bestSubframes,
+           (unsigned long long)bestResidual);
+}
+
+int main() {
+#ifdef FLAC_RICE_REFERENCE
+    printf("FLAC, reference rice decoder (FLAC_RICE_REFERENCE)\n");
+#else
+    printf("FLAC, clz rice decoder\n");
+#endif
+    for(auto f : files) bench(f);
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * flac_resync_test.cpp
+ *
+ * FLAC with injected corruption: no damaged frame may reach the output and the decoder has to be back on the next
+ * frame, with the frame CRC-16 check (FLACSetCRCCheck(true)) and for comparison without it (default)
+ *
+ *  In every run a few frames of the test file get a flipped bit or a burst of random bytes. The stream is played the
+ *  way Audio::sendBytes() does it: FLACFindSyncWord() until the frame start is at offset 0, then FLACDecode() until an
+ *  error, after an error the search starts again 2 bytes on. Every output sample is compared with the clean decode.
+ *  Reported are the wrong samples, the frames lost per damaged frame (1 is an immediate resync) and the cost of the
+ *  CRC-16 on the clean file.
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "flac_decoder/flac_decoder.h"
+#include <algorithm>
+#include <map>
+#include <random>
+
+static const int   windowSize = 32768;    // bytes given to the decoder at once, more than two frames
+static const int   runs       = 300;
+static const int   hitsPerRun = 3;
+static std::mt19937 rnd(1);
+
+struct result_t {
+    long   wrongSamples;                   // output samples that differ from the clean decode
+    int    goodFrames;                     // frames output completely and correctly
+    int    errors;                         // FLACDecode() errors
+};
+
+/* plays s from pos, frames maps the frame starts to the first sample of the frame */
+static result_t play(FLACDecoder_t* dec, std::vector<uint8_t>& s, int pos, const std::map<int, int>& frames,
+                     const std::vector<int16_t>& clean) {
+    std::vector<int16_t> pcm(2 * 2048);
+    result_t r = {0, 0, 0};
+    bool playing = false, frameOk = false;
+    int  frameStart = -1, offset = 0;
+    FLACDecoderReset(dec);
+    while(pos < (int)s.size() - 16) {
+        int n = std::min(windowSize, (int)s.size() - pos);
+        if(!playing) {
+            int q = FLACFindSyncWord(dec, &s[pos], n);
+            if(q < 0) {pos += n - 5; continue;}
+            if(q == 0) playing = true;
+            pos += q;
+            continue;
+        }
+        if(dec->status == DECODE_FRAME) {                        // a new frame starts at pos
+            auto f = frames.find(pos);
+            frameStart = f == frames.end() ? -1 : f->second;
+            frameOk = frameStart >= 0;
+            offset = 0;
+        }
+        int left = n;
+        int err = FLACDecode(dec, &s[pos], &left, pcm.data());
+        int used = n - left;
+        if(err < 0) {
+            r.errors++;
+            playing = false;
+            pos += used ? used : 2;
+            continue;
+        }
+        int samps = FLACGetOutputSamps(dec);
+        for(int i = 0; i < samps; i++) {
+            int k = 2 * frameStart + offset + i;
+            if(frameStart < 0 || k >= (int)clean.size() || pcm[i] != clean[k]) {r.wrongSamples++; frameOk = false;}
+        }
+        offset += samps;
+        if(samps && err == ERR_FLAC_NONE && frameOk) r.goodFrames++;
+        if(!used && !samps && err == ERR_FLAC_NONE) {playing = false; pos++;}   // framesize 0
+        pos += used;
+    }
+    return r;
+}
+
+int main() {
+    std::vector<uint8_t> s = loadFile(TESTFILES "test_16bit_stereo.flac");
+    int first = skipFLACMetadata(s);
+
+    // frame starts and the clean pcm
+    std::vector<int> starts;
+    std::map<int, int> frames;
+    std::vector<int16_t> clean, pcm(2 * 2048);
+    FLACDecoder_t* dec = FLACDecoder_Create();
+    int left = s.size() - first;
+    while(left > 0) {
+        int pos = s.size() - left;
+        if(dec->status == DECODE_FRAME) {starts.push_back(pos); frames[pos] = clean.size() / 2;}
+        int err = FLACDecode(dec, &s[pos], &left, pcm.data());
+        if(err < 0) {printf("FAIL: clean file, FLACDecode error %i\n", err); return 1;}
+        int samps = FLACGetOutputSamps(dec);
+        clean.insert(clean.end(), pcm.begin(), pcm.begin() + samps);
+    }
+    starts.push_back(s.size());                                  // end of the last frame
+    int numFrames = frames.size();
+
+    // cost of the CRC-16, clean file
+    double t[2] = {1e9, 1e9};
+    for(int k = 0; k < 40; k++) {                                // interleaved, the host disturbs both alike
+        for(int crc = 0; crc < 2; crc++) {
+            FLACSetCRCCheck(dec, crc);
+            double t0 = seconds();
+            result_t r = play(dec, s, first, frames, clean);
+            t[crc] = std::min(t[crc], seconds() - t0);
+            if(r.wrongSamples || r.goodFrames != numFrames) {printf("FAIL: clean file, wrong output\n"); return 1;}
+        }
+    }
+    printf("FLAC, %i frames, decode time without CRC-16 check %.2f ms, with %.2f ms (%+.1f%%)\n", numFrames,
+           t[0] * 1e3, t[1] * 1e3, 100 * (t[1] / t[0] - 1));
+
+    int fails = 0;
+    for(int crc = 1; crc >= 0; crc--) {
+        FLACSetCRCCheck(dec, crc);
+        std::mt19937 rnd0 = rnd;                                 // the same damage for both
+        long wrong = 0, lost = 0, hits = 0, errors = 0;
+        for(int run = 0; run < runs; run++) {
+            std::vector<uint8_t> d = s;
+            std::vector<int> hit;
+            while((int)hit.size() < hitsPerRun) {                // different frames
+                int f = rnd0() % numFrames;
+                if(std::find(hit.begin(), hit.end(), f) == hit.end()) hit.push_back(f);
+            }
+            for(int f : hit) {
+                int len = starts[f + 1] - starts[f];
+                if(run & 1) {                                    // burst of random bytes
+                    int burst = 1 + rnd0() % 64;
+                    int p = starts[f] + rnd0() % (len - burst);
+                    for(int j = 0; j < burst; j++) d[p + j] ^= 1 + rnd0() % 255;
+                }
+                else d[starts[f] + rnd0() % len] ^= 1 << (rnd0() % 8);   // one flipped bit
+            }
+            result_t r = play(dec, d, first, frames, clean);
+            wrong  += r.wrongSamples;
+            lost   += numFrames - r.goodFrames;
+            hits   += hitsPerRun;
+            errors += r.errors;
+        }
+        printf("     CRC-16 check %-3s  %8ld wrong samples, %.3f frames lost per damaged frame, %ld decode errors\n",
+               crc ? "on" : "off", wrong, (double)lost / hits, errors);
+        if(crc && (wrong || lost != hits)) fails++;
+    }
+    FLACDecoder_Destroy(dec);
+    printf("flac resync: %s\n", fails ? "FAIL" : "ok");
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * flac_test.cpp
+ *
+ * the FLAC decoder is lossless: the pcm of the test file must be that of the stream (CRC-32 of the interleaved 16 bit
+ * pcm and number of frames, taken from libavcodec)
+ *
+ *  built twice: flac_test with the clz rice partition decoder, flac_test_ref with FLAC_RICE_REFERENCE, so both paths
+ *  are compared against the same values
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "flac_decoder/flac_decoder.h"
+
+static const struct {
+    const char* file;
+    uint32_t    crc;
+    int         frames;
+} golden[] = {
+    {"test_16bit_stereo.flac", 0xc684139a, 29},
+};
+
+/* decodes the whole file, returns the number of frames */
+static int decodeFile(const char* name, uint32_t* crc) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> d = loadFile(path);
+    std::vector<int16_t> pcm(2 * 2048);
+    FLACDecoder_t* dec = FLACDecoder_Create();
+    if(!dec) {
+        printf("FAIL: FLACDecoder_Create\n");
+        exit(1);
+    }
+    // STREAMINFO is not passed, channels, rate and bits per sample come from the frame headers
+    int left = d.size() - skipFLACMetadata(d);
+    int frames = 0;
+    *crc = 0;
+    while(left > 0) {
+        int err = FLACDecode(dec, d.data() + d.size() - left, &left, pcm.data());
+        if(err < 0) {
+            printf("FAIL: %s, FLACDecode error %i in frame %i\n", name, err, frames);
+            exit(1);
+        }
+        int samps = FLACGetOutputSamps(dec);                     // 0 after the frame header
+        *crc = crc32(*crc, pcm.data(), samps * 2);
+        if(samps && err == ERR_FLAC_NONE) frames++;              // GIVE_NEXT_LOOP: more samples of this frame
+    }
+    FLACDecoder_Destroy(dec);
+    return frames;
+}
+
+int main() {
+    int fails = 0;
+    for(auto& g : golden) {
+        uint32_t crc;
+        int frames = decodeFile(g.file, &crc);
+        bool ok = crc == g.crc && frames == g.frames;
+        printf("%-28s %4i frames, crc %08x %s\n", g.file, frames, crc, ok ? "ok" : "FAIL");
+        if(!ok) fails++;
+    }
+#ifdef FLAC_RICE_REFERENCE
+    printf("flac reference rice decoder: %s\n", fails ? "FAIL" : "lossless");
+#else
+    printf("flac: %s\n", fails ? "FAIL" : "lossless");
+#endif
+    return fails ? 1 : 0;
+}
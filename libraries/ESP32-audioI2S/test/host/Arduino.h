@@ -0,0 +1,78 @@
+/*
+ * Arduino.h
+ *
+ * host replacement of the parts of Arduino-ESP32 and FreeRTOS the decoders use, so that they can be built and
+ * measured on a PC. Audio.cpp is not built here, it needs WiFi and the file systems.
+ *
+ *  ESP.getCycleCount() reads the time stamp counter of the host, cycle counts are only comparable between runs on the
+ *  same machine. MALLOC_CAP_SPIRAM allocations come from the heap like all others, psramFound() says true unless the
+ *  environment variable NOPSRAM is set.
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+using std::min;
+using std::max;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define PI 3.14159265358979323846
+typedef bool boolean;
+
+#define log_e(fmt, ...) do{ if(getenv("LOG")) fprintf(stderr, "E " fmt "\n", ##__VA_ARGS__); }while(0)
+#define log_w(fmt, ...) do{ if(getenv("LOG")) fprintf(stderr, "W " fmt "\n", ##__VA_ARGS__); }while(0)
+#define log_i(fmt, ...) do{ if(getenv("LOG")) fprintf(stderr, "I " fmt "\n", ##__VA_ARGS__); }while(0)
+#define log_d(fmt, ...) do{}while(0)
+#define log_v(fmt, ...) do{}while(0)
+
+#define pgm_read_byte(a)  (*(const uint8_t*)(a))
+#define pgm_read_word(a)  (*(const uint16_t*)(a))
+#define pgm_read_dword(a) (*(const uint32_t*)(a))
+
+#define MALLOC_CAP_DEFAULT  0x01
+#define MALLOC_CAP_SPIRAM   0x02
+#define MALLOC_CAP_INTERNAL 0x04
+#define MALLOC_CAP_8BIT     0x08
+#define MALLOC_CAP_32BIT    0x10
+
+inline bool   psramFound() {return !getenv("NOPSRAM");}
+inline void*  ps_malloc(size_t size) {return malloc(size);}
+inline void*  heap_caps_malloc(size_t size, uint32_t) {return malloc(size);}
+inline void*  heap_caps_malloc_prefer(size_t size, size_t, ...) {return malloc(size);}
+inline size_t heap_caps_get_free_size(uint32_t) {return 1 << 20;}
+inline size_t heap_caps_get_largest_free_block(uint32_t) {return 1 << 20;}
+
+unsigned long millis();
+unsigned long micros();
+
+struct EspClass {
+    uint32_t getCycleCount();
+    uint32_t getFreeHeap() {return 1 << 20;}
+};
+extern EspClass ESP;
+
+// FreeRTOS: a task is a thread, task notifications are counting semaphores
+typedef void* TaskHandle_t;
+typedef int   BaseType_t;
+typedef uint32_t TickType_t;
+#define pdTRUE          1
+#define pdFALSE         0
+#define pdPASS          1
+#define portMAX_DELAY   0xffffffff
+BaseType_t   xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stack, void* arg, int prio,
+                                     TaskHandle_t* handle, int core);
+void         vTaskDelete(TaskHandle_t handle);
+uint32_t     ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+void         xTaskNotifyGive(TaskHandle_t handle);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+inline int   uxTaskPriorityGet(TaskHandle_t) {return 1;}
+inline int   xPortGetCoreID() {return 1;}
@@ -0,0 +1,114 @@
+/*
+ * host.cpp
+ *
+ * implementation of the host replacements in Arduino.h, and the helpers the tests share
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+EspClass ESP;
+static const auto t_start = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t_start).count();
+}
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start).count();
+}
+uint32_t EspClass::getCycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t_start).count();
+#endif
+}
+//----------------------------------------------------------------------------------------------------------------------
+struct HostTask {
+    std::mutex              m;
+    std::condition_variable cv;
+    uint32_t                notified = 0;
+};
+static thread_local HostTask* t_self = nullptr;
+
+static HostTask* selfTask() {
+    if(!t_self) t_self = new HostTask;
+    return t_self;
+}
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char*, uint32_t, void* arg, int, TaskHandle_t* handle, int) {
+    HostTask* t = new HostTask;
+    if(handle) *handle = t;
+    std::thread([=] { t_self = t; fn(arg); }).detach();
+    return pdPASS;
+}
+void vTaskDelete(TaskHandle_t handle) {
+    if(!handle) pthread_exit(nullptr);  // the task ends itself
+}
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t) {
+    HostTask* t = selfTask();
+    std::unique_lock<std::mutex> lock(t->m);
+    t->cv.wait(lock, [&] { return t->notified > 0; });
+    uint32_t v = t->notified;
+    if(clearOnExit) t->notified = 0;
+    else t->notified--;
+    return v;
+}
+void xTaskNotifyGive(TaskHandle_t handle) {
+    HostTask* t = (HostTask*)handle;
+    {
+        std::lock_guard<std::mutex> lock(t->m);
+        t->notified++;
+    }
+    t->cv.notify_one();
+}
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return selfTask();
+}
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<uint8_t> loadFile(const char* path) {
+    std::vector<uint8_t> d;
+    FILE* f = fopen(path, "rb");
+    if(!f) {
+        fprintf(stderr, "can't open %s\n", path);
+        exit(2);
+    }
+    uint8_t b[65536];
+    size_t n;
+    while((n = fread(b, 1, sizeof(b), f)) > 0) d.insert(d.end(), b, b + n);
+    fclose(f);
+    return d;
+}
+size_t skipID3(const std::vector<uint8_t>& d) {
+    if(d.size() > 10 && !memcmp(d.data(), "ID3", 3)) return 10 + ((d[6] << 21) | (d[7] << 14) | (d[8] << 7) | d[9]);
+    return 0;
+}
+size_t skipFLACMetadata(const std::vector<uint8_t>& d) {
+    if(d.size() < 8 || memcmp(d.data(), "fLaC", 4)) return 0;
+    size_t pos = 4;
+    bool last = false;
+    while(!last && pos + 4 <= d.size()) {
+        last = d[pos] & 0x80;
+        pos += 4 + ((d[pos + 1] << 16) | (d[pos + 2] << 8) | d[pos + 3]);
+    }
+    return pos;
+}
+uint32_t crc32(uint32_t crc, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while(len--) {
+        crc ^= *p++;
+        for(int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+double seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+}
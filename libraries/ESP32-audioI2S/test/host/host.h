@@ -0,0 +1,19 @@
+/*
+ * host.h
+ *
+ * helpers shared by the host tests and benchmarks
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define TESTFILES "../additional_info/Testfiles/"
+
+std::vector<uint8_t> loadFile(const char* path);           // whole file, exits if it can't be read
+size_t   skipID3(const std::vector<uint8_t>& d);            // bytes of a leading ID3v2 tag
+size_t   skipFLACMetadata(const std::vector<uint8_t>& d);   // bytes of "fLaC" and the metadata blocks
+uint32_t crc32(uint32_t crc, const void* data, size_t len); // CRC-32 (IEEE 802.3), start with crc = 0
+double   seconds();                                         // monotonic time
@@ -0,0 +1,116 @@
+/*
+ * mp3_bench.cpp
+ *
+ * CPU cycles per MP3 frame, of the hybrid transform (IMDCT) and of the synthesis filterbank (Subband) per granule
+ *
+ * MP3SetDualCore(): frames per second with and without the worker, share of the stereo granules MP3DualCoreWorth() split
+ * and its running averages. With a single CPU on the host the split can't pay, it should be given up after the first
+ * granules; the two core figures have to be taken on the ESP32.
+ *
+ *  built with MP3_PROFILE twice: mp3_bench with the fast filterbank, mp3_bench_ref with MP3_SUBBAND_REFERENCE. Each
+ *  file is decoded several times, the profile counters of the decoder are read after every frame. The fastest pass is
+ *  reported, the others are disturbed by the host.
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "mp3_decoder/mp3_decoder.h"
+
+#ifndef MP3_PROFILE
+    #error "mp3_bench needs MP3_PROFILE"
+#endif
+
+static const char* files[] = {"test_128k_stereo.mp3", "test_64k_stereo_24kHz.mp3", "test_48k_mono_22kHz.mp3",
+                               "test_320k_stereo.mp3"};
+static const int   passes  = 20;
+
+static void bench(const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> d = loadFile(path);
+    std::vector<int16_t> pcm(2 * 1152);
+    uint64_t bestFrame = ~0ULL, bestImdct = ~0ULL, bestSubband = ~0ULL;
+
+    for(int k = 0; k < passes; k++) {
+        uint64_t cycles = 0, imdct = 0, subband = 0;
+        uint32_t frames = 0, grans = 0;
+        MP3Decoder_t* dec = MP3Decoder_Create();
+        int left = d.size() - skipID3(d);
+        while(left > 4) {
+            uint64_t im = dec->profImdct;
+            uint64_t sb = dec->profSubband;
+            uint32_t gr = dec->profGrans;
+            uint32_t t0 = ESP.getCycleCount();
+            int err = MP3Decode(dec, d.data() + d.size() - left, &left, pcm.data(), 0);
+            uint32_t t1 = ESP.getCycleCount();
+            if(err == ERR_MP3_MAINDATA_UNDERFLOW) continue;
+            if(err) break;
+            cycles += t1 - t0;
+            frames++;
+            if(dec->profFrames == 0) continue;                   // the decoder has just logged and cleared its counters
+            imdct   += dec->profImdct - im;
+            subband += dec->profSubband - sb;
+            grans   += dec->profGrans - gr;
+        }
+        MP3Decoder_Destroy(dec);
+        bestFrame   = std::min(bestFrame, cycles / frames);
+        bestImdct   = std::min(bestImdct, imdct / grans);
+        bestSubband = std::min(bestSubband, subband / grans);
+    }
+    printf("%-28s %8llu cycles/frame, per granule IMDCT %6llu, Subband %6llu\n", name, (unsigned long long)bestFrame,
+           (unsigned long long)bestImdct, (unsigned long long)bestSubband);
+}
+
+static void benchDual(const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> d = loadFile(path);
+    std::vector<int16_t> pcm(2 * 1152);
+    double   fps[2];
+    uint32_t crc[2], split = 0, grans = 0, dualCycles = 0, serialCycles = 0;
+
+    for(int dual = 0; dual < 2; dual++) {
+        double best = 1e9;
+        for(int k = 0; k < passes / 4; k++) {
+            MP3Decoder_t* dec = MP3Decoder_Create();
+            if(dual && !MP3SetDualCore(dec, true)) {printf("FAIL: no worker task\n"); exit(1);}
+            int left = d.size() - skipID3(d), frames = 0;
+            crc[dual] = 0;
+            double t0 = seconds();
+            while(left > 4) {
+                uint32_t sp = dec->profSplit, gr = dec->profGrans;
+                int err = MP3Decode(dec, d.data() + d.size() - left, &left, pcm.data(), 0);
+                if(err == ERR_MP3_MAINDATA_UNDERFLOW) continue;
+                if(err) break;
+                crc[dual] = crc32(crc[dual], pcm.data(), MP3GetOutputSamps(dec) * 2);
+                frames++;
+                if(dual && dec->profFrames) {split += dec->profSplit - sp; grans += dec->profGrans - gr;}
+            }
+            best = std::min(best, (seconds() - t0) / frames);
+            dualCycles = dec->dualCycles; serialCycles = dec->serialCycles;
+            MP3Decoder_Destroy(dec);
+        }
+        fps[dual] = 1 / best;
+    }
+    printf("%-28s one core %6.0f frames/s, with worker %6.0f frames/s, %5.1f%% of the granules split, "
+           "averages dual %u single %u cycles %s\n", name, fps[0], fps[1], 100.0 * split / grans, dualCycles,
+           serialCycles, crc[0] == crc[1] ? "" : "DIFFERENT OUTPUT");
+    if(crc[0] != crc[1]) {
+        printf("FAIL: dual core output differs\n");
+        exit(1);
+    }
+}
+
+int main() {
+#ifdef MP3_SUBBAND_REFERENCE
+    printf("MP3, reference subband (MP3_SUBBAND_REFERENCE)\n");
+#else
+    printf("MP3, fast subband\n");
+#endif
+    for(auto f : files) bench(f);
+    printf("MP3SetDualCore\n");
+    benchDual("test_128k_stereo.mp3");
+    benchDual("test_64k_stereo_24kHz.mp3");
+    benchDual("test_320k_stereo.mp3");
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * mp3_test.cpp
+ *
+ * bit exactness of the MP3 decoder: the pcm of the test files must be the same as that of the Helix code the
+ * decoder is based on (CRC-32 of the pcm and number of frames, taken from the decoder before the optimizations)
+ *
+ *  built twice: mp3_test with the fast synthesis filterbank, mp3_test_ref with MP3_SUBBAND_REFERENCE, so both paths
+ *  are compared against the same values
+ *
+ *  the hybrid transform (anti-alias, IMDCT36/IMDCT12x3, overlap) sees long and short blocks in all files, the guard bit
+ *  rescaling in test_320k_stereo.mp3 and all-zero blocks below nonZeroBound in the silent and low passed parts of
+ *  test_96k_stereo_gaps.mp3
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "mp3_decoder/mp3_decoder.h"
+
+static const struct {
+    const char* file;
+    uint32_t    crc;
+    int         frames;
+} golden[] = {
+    {"test_128k_stereo.mp3",      0xab30fec1, 232},
+    {"test_64k_stereo_24kHz.mp3", 0x32342ff0, 253},
+    {"test_48k_mono_22kHz.mp3",   0x2ea6b2f2, 157},
+    {"test_320k_stereo.mp3",      0xe8a28545, 117},
+    {"test_96k_stereo_gaps.mp3",  0xe2e92f89, 156},
+};
+
+/* decodes the whole file, returns the number of frames */
+static int decodeFile(const char* name, uint32_t* crc) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> d = loadFile(path);
+    std::vector<int16_t> pcm(2 * 1152);
+    int left = d.size() - skipID3(d);
+    int frames = 0;
+    *crc = 0;
+    while(left > 4) {
+        int err = MP3Decode(d.data() + d.size() - left, &left, pcm.data(), 0);
+        if(err == ERR_MP3_MAINDATA_UNDERFLOW) continue;          // bit reservoir not filled yet, no output
+        if(err == ERR_MP3_INDATA_UNDERFLOW) break;               // incomplete last frame
+        if(err) {
+            printf("FAIL: %s, MP3Decode error %i in frame %i\n", name, err, frames);
+            exit(1);
+        }
+        *crc = crc32(*crc, pcm.data(), MP3GetOutputSamps() * 2);
+        frames++;
+    }
+    return frames;
+}
+
+int main() {
+    if(!MP3Decoder_AllocateBuffers()) {
+        printf("FAIL: MP3Decoder_AllocateBuffers\n");
+        return 1;
+    }
+    int fails = 0;
+    for(auto& g : golden) {
+        uint32_t crc;
+        MP3Decoder_ClearBuffer();
+        int frames = decodeFile(g.file, &crc);
+        bool ok = crc == g.crc && frames == g.frames;
+        printf("%-28s %4i frames, crc %08x %s\n", g.file, frames, crc, ok ? "ok" : "FAIL");
+        if(!ok) fails++;
+    }
+    MP3Decoder_FreeBuffers();
+#ifdef MP3_SUBBAND_REFERENCE
+    printf("mp3 reference subband: %s\n", fails ? "FAIL" : "bit exact");
+#else
+    printf("mp3: %s\n", fails ? "FAIL" : "bit exact");
+#endif
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * ogg_bench.cpp
+ *
+ * Ogg demuxer: CPU cycles per page and per KB, share of the packets delivered in place and of the bytes copied, for
+ * some sizes of the input window (the bytes Audio has in InBuff). For comparison the same demuxer with f_copyAll, it
+ * copies every packet into the reassembly buffer and goes through the same calls.
+ *
+ *  test_16bit_stereo_flac.ogg is test_16bit_stereo.flac in Ogg with pages of about 4KB as libogg writes them, the
+ *  FLAC frames (about 11KB) span 3 or 4 pages and have to be copied. test_96k_stereo_opus.ogg (CELT, 20ms) has 10
+ *  packets per page, they can be delivered in place. Each file is played twice in a row as a chained stream (a second
+ *  BOS page). Checked for both ways: the packets are the same as those of a plain page parser (copyAll), both BOS
+ *  pages are seen, and the FLAC packets decode to the pcm of test_16bit_stereo.flac for both songs. The cycles are
+ *  those of the whole loop without the checks, the fastest of several passes.
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "ogg_demuxer/ogg_demuxer.h"
+#include "flac_decoder/flac_decoder.h"
+
+static const char*    files[]   = {"test_16bit_stereo_flac.ogg", "test_96k_stereo_opus.ogg"};
+static const uint32_t flacCRC   = 0xc684139a;   // pcm of test_16bit_stereo.flac, see flac_test.cpp
+static const int      windows[] = {1024, 4096, 16384, 65536};
+static const int      passes   = 50;
+
+/* plain page parser, copies every packet, returns the number of packets, crc over all packets if crc != NULL */
+static int copyAll(const std::vector<uint8_t>& s, std::vector<uint8_t>& pkt, uint32_t* crc) {
+    int packets = 0;
+    if(crc) *crc = 0;
+    pkt.clear();
+    for(size_t i = 0; i + 27 <= s.size();) {
+        const uint8_t* h = &s[i];
+        int n = h[26];
+        const uint8_t* p = h + 27 + n;
+        for(int k = 0; k < n; k++) {
+            pkt.insert(pkt.end(), p, p + h[27 + k]);
+            p += h[27 + k];
+            if(h[27 + k] < 255) {                                // packet complete
+                if(crc) *crc = crc32(*crc, pkt.data(), pkt.size());
+                packets++;
+                pkt.clear();
+            }
+        }
+        i = p - s.data();
+    }
+    return packets;
+}
+
+struct result_t {
+    int      packets, inPlace, bos;
+    uint32_t crc;                                                // over all packets
+    uint32_t pcmCRC[2];                                          // decoded FLAC of both songs
+    uint32_t pages, bytesCopied;
+};
+
+/* plays s the way Audio::sendBytes() does it, the codec takes each packet as a whole. check: crc of the packets and
+ * FLAC decoding, else only the demuxer runs. copy: every packet is copied */
+static result_t demux(const std::vector<uint8_t>& s, int window, bool copy, bool check) {
+    std::vector<int16_t> pcm(2 * 2048);
+    result_t r = {};
+    OggDemuxer_t*  ogg = OggDemuxer_Create();
+    ogg->f_copyAll = copy;
+    FLACDecoder_t* dec = check ? FLACDecoder_Create() : NULL;
+    size_t pos = 0;
+    bool   flac = false;
+    // at the end the last packet can still wait in the reassembly buffer, see Audio::processLocalFile()
+    while(pos < s.size() || OggPacketPending(ogg)) {
+        int len = std::min((size_t)window, s.size() - pos);
+        uint8_t* pkt;
+        int pktLen;
+        int res = OggReadPacket(ogg, (uint8_t*)&s[pos], len, &pkt, &pktLen);
+        if(res < 0) {printf("FAIL: OggReadPacket error %i at %zu\n", res, pos); exit(1);}
+        if(res > 0) {pos += res; continue;}
+        if(!pktLen) break;                                       // more data needed, there is none
+        if(ogg->f_bos) {                                         // first packet of a logical stream
+            ogg->f_bos = false;
+            r.bos++;
+            flac = pktLen >= 5 && pkt[0] == 0x7F && !memcmp(pkt + 1, "FLAC", 4);
+        }
+        if(pkt == &s[pos]) r.inPlace++;
+        r.packets++;
+        if(check) r.crc = crc32(r.crc, pkt, pktLen);
+        if(check && flac && pkt[0] == 0xFF) {                    // FLAC frame, the header packets begin with 0x7F or
+            int left = pktLen;                                   // a metadata block type
+            do {
+                int err = FLACDecode(dec, pkt + pktLen - left, &left, pcm.data());
+                if(err < 0) {printf("FAIL: FLACDecode error %i\n", err); exit(1);}
+                r.pcmCRC[r.bos - 1] = crc32(r.pcmCRC[r.bos - 1], pcm.data(), FLACGetOutputSamps(dec) * 2);
+            } while(left > 0 || dec->status != DECODE_FRAME);
+        }
+        pos += OggPacketUsed(ogg, pktLen);
+    }
+    if(pos != s.size()) {printf("FAIL: demuxer stopped at %zu of %zu bytes\n", pos, s.size()); exit(1);}
+    r.pages = ogg->pages;
+    r.bytesCopied = ogg->bytesCopied;
+    FLACDecoder_Destroy(dec);
+    OggDemuxer_Destroy(ogg);
+    return r;
+}
+
+static int bench(const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> s = loadFile(path);
+    s.insert(s.end(), s.begin(), s.end());                       // chained: the same song twice
+    bool flac = strstr(name, "flac");
+    std::vector<uint8_t> buf;
+    uint32_t crc;
+    int packets = copyAll(s, buf, &crc);
+    int pages = 0;
+    for(size_t i = 0; i + 27 <= s.size(); pages++) {
+        int n = s[i + 26], body = 0;
+        for(int k = 0; k < n; k++) body += s[i + 27 + k];
+        i += 27 + n + body;
+    }
+    printf("%s twice, %zu bytes, %i pages, %i packets\n", name, s.size(), pages, packets);
+
+    int fails = 0;
+    for(int w : windows) {
+        for(bool copy : {false, true}) {
+            result_t r = demux(s, w, copy, true);
+            bool ok = r.packets == packets && r.crc == crc && r.bos == 2 && (int)r.pages == pages &&
+                      (!flac || (r.pcmCRC[0] == flacCRC && r.pcmCRC[1] == flacCRC));
+            uint64_t best = ~0ULL;
+            for(int k = 0; k < passes; k++) {
+                uint32_t t0 = ESP.getCycleCount();
+                demux(s, w, copy, false);
+                best = std::min(best, (uint64_t)(ESP.getCycleCount() - t0));
+            }
+            printf("     window %5i bytes, %-8s %6llu cycles/page, %5llu cycles/KB, in place %3i%% of the packets, "
+                   "copied %3i%% of the bytes %s\n", w, copy ? "copying" : "in place",
+                   (unsigned long long)(best / r.pages), (unsigned long long)(best * 1024 / s.size()),
+                   100 * r.inPlace / r.packets, (int)(100.0 * r.bytesCopied / s.size()), ok ? "" : "WRONG PACKETS");
+            if(!ok) fails++;
+        }
+    }
+    return fails;
+}
+
+int main() {
+    int fails = 0;
+    for(auto f : files) fails += bench(f);
+    if(fails) printf("FAIL: the demuxer delivered other packets\n");
+    return fails ? 1 : 0;
+}
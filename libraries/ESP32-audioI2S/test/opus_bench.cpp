@@ -0,0 +1,80 @@
+/*
+ * opus_bench.cpp
+ *
+ * CPU cycles of the Opus decoder per 20ms of output for SILK, hybrid and CELT streams (the test files of opus_test),
+ * the slowest 20ms and how many times faster than real time.
+ *
+ *  The packets are taken from the Ogg file before, only OPUSDecode() is measured. Every call outputs 20ms (a 60ms
+ *  SILK frame in 3 calls, the first decodes all of it). Each file is decoded several times, the fastest pass is
+ *  reported, the others are disturbed by the host. The cycles are those of the host, not of an ESP32.
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "ogg_demuxer/ogg_demuxer.h"
+#include "opus_decoder/opus_decoder.h"
+
+static const char* files[] = {"test_32k_stereo_silk.ogg", "test_12k_mono_silk_60ms.ogg", "test_48k_stereo_hybrid.ogg",
+                              "test_24k_stereo_opus_modes.ogg", "test_96k_stereo_opus.ogg"};
+static const int   passes  = 20;
+
+/* all packets of the file, the first is OpusHead */
+static std::vector<std::vector<uint8_t>> readPackets(const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> s = loadFile(path);
+    std::vector<std::vector<uint8_t>> packets;
+    OggDemuxer_t* ogg = OggDemuxer_Create();
+    size_t pos = 0;
+    while(pos < s.size() || OggPacketPending(ogg)) {
+        uint8_t* pkt;
+        int pktLen;
+        int res = OggReadPacket(ogg, &s[pos], s.size() - pos, &pkt, &pktLen);
+        if(res < 0) {printf("FAIL: %s, OggReadPacket error %i at %zu\n", name, res, pos); exit(1);}
+        if(res > 0) {pos += res; continue;}
+        if(!pktLen) break;
+        if(ogg->packetNo != 1) packets.emplace_back(pkt, pkt + pktLen);  // without OpusTags
+        pos += OggPacketUsed(ogg, pktLen);
+    }
+    OggDemuxer_Destroy(ogg);
+    return packets;
+}
+
+static void bench(const char* name) {
+    std::vector<std::vector<uint8_t>> packets = readPackets(name);
+    std::vector<int16_t> pcm(2 * OPUS_MAX_FRAME_SIZE);
+    uint64_t best = ~0ULL, bestMax = ~0ULL;                      // cycles per 20ms, mean and slowest
+    double   bestTime = 1e9;                                     // seconds per 20ms
+
+    for(int k = 0; k < passes; k++) {
+        OpusDecoder_t* dec = OPUSDecoder_Create();
+        OPUSParseOpusHead(dec, packets[0].data(), packets[0].size());
+        uint64_t sum = 0, slowest = 0;
+        uint32_t calls = 0;
+        double t = seconds();
+        for(size_t i = 1; i < packets.size(); i++) {
+            int left = packets[i].size(), err;
+            do {
+                uint32_t t0 = ESP.getCycleCount();
+                err = OPUSDecode(dec, packets[i].data(), &left, pcm.data());
+                uint32_t c = ESP.getCycleCount() - t0;
+                if(err < 0) {printf("FAIL: %s, OPUSDecode error %i in packet %zu\n", name, err, i); exit(1);}
+                sum += c;
+                slowest = std::max(slowest, (uint64_t)c);
+                calls++;
+            } while(err == OPUS_CONTINUE);
+        }
+        bestTime = std::min(bestTime, (seconds() - t) / calls);
+        OPUSDecoder_Destroy(dec);
+        best    = std::min(best, sum / calls);
+        bestMax = std::min(bestMax, slowest);
+    }
+    printf("%-30s %7llu cycles/20ms, slowest %7llu, %5.0fx real time\n", name, (unsigned long long)best,
+           (unsigned long long)bestMax, 0.020 / bestTime);
+}
+
+int main() {
+    printf("Opus\n");
+    for(auto f : files) bench(f);
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * opus_test.cpp
+ *
+ * Opus decoder against libopus 1.6 (fixed point output of opus_decode()): CRC-32 of the interleaved 16 bit pcm after
+ * the pre-skip, the XOR of the final range coder states of all packets and number of packets
+ *
+ *  The SILK decoder is that of the reference, SILK only streams must be bit exact (crc and range from libopus). CELT
+ *  is decoded in another fixed point arithmetic, for CELT and hybrid streams only the range is that of libopus, it
+ *  shows that every symbol was read as libopus reads it. Their crc is the one of this decoder, checked on the host
+ *  against the float output of libopus: hybrid 81dB, the mode switches 69dB, CELT 96kbit/s 78dB SNR.
+ *
+ *  test_32k_stereo_silk.ogg       SILK wideband, 20ms, stereo
+ *  test_12k_mono_silk_60ms.ogg    SILK narrowband, 60ms frames (decoded in 3 calls of 20ms each)
+ *  test_48k_stereo_hybrid.ogg     hybrid fullband, 20ms
+ *  test_24k_stereo_opus_modes.ogg SILK, hybrid and CELT frames and the transitions with redundant CELT frames
+ *  test_96k_stereo_opus.ogg       CELT fullband, 20ms
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "ogg_demuxer/ogg_demuxer.h"
+#include "opus_decoder/opus_decoder.h"
+
+static const struct {
+    const char* file;
+    uint32_t    crc;
+    uint32_t    range;
+    int         packets;
+} golden[] = {
+    {"test_32k_stereo_silk.ogg",       0x0c4bfa2f, 0x38b3914f, 250},
+    {"test_12k_mono_silk_60ms.ogg",    0x1e66d35c, 0x77b1db29,  83},
+    {"test_48k_stereo_hybrid.ogg",     0xe9c45c85, 0x6df83cb3, 250},
+    {"test_24k_stereo_opus_modes.ogg", 0x7056c915, 0x472941f2, 250},
+    {"test_96k_stereo_opus.ogg",       0x544d40b7, 0x6b8f20a2, 300},
+};
+
+/* decodes the whole file, returns the number of audio packets */
+static int decodeFile(const char* name, uint32_t* crc, uint32_t* range) {
+    char path[256];
+    snprintf(path, sizeof(path), TESTFILES "%s", name);
+    std::vector<uint8_t> s = loadFile(path);
+    std::vector<int16_t> pcm(2 * OPUS_MAX_FRAME_SIZE);
+    OggDemuxer_t*  ogg = OggDemuxer_Create();
+    OpusDecoder_t* dec = OPUSDecoder_Create();
+    if(!ogg || !dec) {
+        printf("FAIL: OggDemuxer_Create, OPUSDecoder_Create\n");
+        exit(1);
+    }
+    size_t pos = 0;
+    int packets = 0;
+    *crc = *range = 0;
+    while(pos < s.size() || OggPacketPending(ogg)) {
+        uint8_t* pkt;
+        int pktLen;
+        int res = OggReadPacket(ogg, &s[pos], s.size() - pos, &pkt, &pktLen);
+        if(res < 0) {printf("FAIL: %s, OggReadPacket error %i at %zu\n", name, res, pos); exit(1);}
+        if(res > 0) {pos += res; continue;}
+        if(!pktLen) break;
+        if(ogg->packetNo == 0) {                                 // OpusHead
+            int err = OPUSParseOpusHead(dec, pkt, pktLen);
+            if(err) {printf("FAIL: %s, OPUSParseOpusHead error %i\n", name, err); exit(1);}
+        }
+        else if(ogg->packetNo > 1) {                             // after OpusTags
+            int left = pktLen, err;
+            do {
+                err = OPUSDecode(dec, pkt, &left, pcm.data());
+                if(err < 0) {printf("FAIL: %s, OPUSDecode error %i in packet %i\n", name, err, packets); exit(1);}
+                *crc = crc32(*crc, pcm.data(), OPUSGetOutputSamps(dec) * 2);
+            } while(err == OPUS_CONTINUE);
+            *range ^= OPUSGetFinalRange(dec);
+            packets++;
+        }
+        pos += OggPacketUsed(ogg, pktLen);
+    }
+    OPUSDecoder_Destroy(dec);
+    OggDemuxer_Destroy(ogg);
+    return packets;
+}
+
+int main() {
+    int fails = 0;
+    for(auto& g : golden) {
+        uint32_t crc, range;
+        int packets = decodeFile(g.file, &crc, &range);
+        bool ok = crc == g.crc && range == g.range && packets == g.packets;
+        printf("%-30s %4i packets, crc %08x, range %08x %s\n", g.file, packets, crc, range, ok ? "ok" : "FAIL");
+        if(!ok) fails++;
+    }
+    printf("opus: %s\n", fails ? "FAIL" : "ok");
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * sync_bench.cpp
+ *
+ * resync after corrupted stream data: MP3FindSyncWord(), AACFindSyncWord() and FLACFindSyncWord()
+ *
+ *  Bursts of random bytes are written over the test files. After each burst the search starts at the first corrupted
+ *  byte, the way Audio does it: skip to a returned candidate and look again until it is at offset 0. A lock on a
+ *  position that is no frame start of the clean file is a false lock. For comparison the same is done with a plain
+ *  scan for the sync word, as the decoders did before.
+ *
+ *  Also checked: an ADTS frame with four raw data blocks is found and decodes like the four single block frames it
+ *  was made of.
+ *
+ */
+#include "Arduino.h"
+#include "host.h"
+#include "mp3_decoder/mp3_decoder.h"
+#include "aac_decoder/aac_decoder.h"
+#include "flac_decoder/flac_decoder.h"
+#include <set>
+#include <random>
+
+enum {MP3, AAC, FLAC};
+static const char* codecName[3] = {"MP3", "AAC", "FLAC"};
+static const int   windowSize   = 4096;     // bytes given to FindSyncWord at once
+static const int   numBursts    = 4000;
+static std::mt19937 rnd(1);
+
+// frame starts of the clean files --------------------------------------------------------------------------------------
+static int mp3FrameLen(const uint8_t* h) {
+    static const int br[2][15] = {{0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},   // MPEG1 L3
+                                  {0,  8, 16, 24, 32, 40, 48, 56,  64,  80,  96, 112, 128, 144, 160}};  // MPEG2 L3
+    static const int sr[3][3] = {{44100, 48000, 32000}, {22050, 24000, 16000}, {11025, 12000, 8000}};
+    if(h[0] != 0xFF || (h[1] & 0xE0) != 0xE0 || ((h[1] >> 1) & 3) != 1) return -1;
+    int ver = (h[1] >> 3) & 3;                                   // 3: MPEG1, 2: MPEG2, 0: MPEG2.5
+    int brIdx = h[2] >> 4, srIdx = (h[2] >> 2) & 3, pad = (h[2] >> 1) & 1;
+    if(ver == 1 || brIdx == 0 || brIdx == 15 || srIdx == 3) return -1;
+    int v = ver == 3 ? 0 : 1;
+    return (v ? 72000 : 144000) * br[v][brIdx] / sr[ver == 3 ? 0 : ver == 2 ? 1 : 2][srIdx] + pad;
+}
+static std::vector<int> frameStarts(int codec, const std::vector<uint8_t>& s) {
+    std::vector<int> starts;
+    if(codec == MP3) {
+        for(size_t i = skipID3(s); i + 4 <= s.size();) {
+            int len = mp3FrameLen(&s[i]);
+            if(len <= 0) break;
+            starts.push_back(i);
+            i += len;
+        }
+    }
+    if(codec == AAC) {
+        for(size_t i = skipID3(s); i + 7 <= s.size();) {
+            int len = ((s[i + 3] & 0x03) << 11) | (s[i + 4] << 3) | (s[i + 5] >> 5);
+            if(s[i] != 0xFF || (s[i + 1] & 0xF6) != 0xF0 || len < 7) break;
+            starts.push_back(i);
+            i += len;
+        }
+    }
+    if(codec == FLAC) {                                          // fixed blocksize, frame numbers count up
+        uint32_t num, expected = 0;
+        for(size_t i = 4; i + 16 <= s.size(); i++) {
+            if(s[i] == 0xFF && (s[i + 1] & 0xFE) == 0xF8 && FLACParseFrameHeader(&s[i], s.size() - i, 1, &num) &&
+               num == expected) {
+                starts.push_back(i);
+                expected++;
+            }
+        }
+    }
+    return starts;
+}
+// the search -----------------------------------------------------------------------------------------------------------
+static int plainScan(int codec, const uint8_t* b, int n) {       // sync word only
+    uint8_t m2 = codec == FLAC ? 0xF8 : 0xF0;
+    for(int i = 0; i < n - 1; i++) if(b[i] == 0xFF && (b[i + 1] & m2) == m2) return i;
+    return -1;
+}
+static int findSync(int codec, bool plain, FLACDecoder_t* fd, uint8_t* b, int n) {
+    if(plain) return plainScan(codec, b, n);
+    if(codec == MP3) return MP3FindSyncWord(b, n);
+    if(codec == AAC) return AACFindSyncWord(b, n);
+    return FLACFindSyncWord(fd, b, n);
+}
+static int resync(int codec, bool plain, FLACDecoder_t* fd, std::vector<uint8_t>& s, int pos) {
+    while(pos < (int)s.size() - 16) {
+        int n = std::min(windowSize, (int)s.size() - pos);
+        int r = findSync(codec, plain, fd, &s[pos], n);
+        if(r < 0) {pos += n - 1; continue;}
+        if(r == 0 || plain) return pos + r;
+        pos += r;
+    }
+    return -1;
+}
+static void bench(int codec, const char* file) {
+    std::vector<uint8_t> clean = loadFile(file);
+    std::vector<int> st = frameStarts(codec, clean);
+    std::set<int> starts(st.begin(), st.end());
+    FLACDecoder_t* fd = FLACDecoder_Create();
+    printf("%-4s %6zu bytes, %4zu frames\n", codecName[codec], clean.size(), st.size());
+
+    for(int plain = 1; plain >= 0; plain--) {
+        int falseLocks = 0, lost = 0;
+        long resyncBytes = 0;
+        double t = 0;
+        for(int k = 0; k < numBursts; k++) {
+            std::vector<uint8_t> s = clean;
+            int burst = 16 + rnd() % 1500;
+            int pos = st[0] + rnd() % (s.size() - st[0] - burst - 3 * windowSize);
+            for(int j = 0; j < burst; j++) s[pos + j] = rnd();
+            double t0 = seconds();
+            int q = resync(codec, plain, fd, s, pos);
+            t += seconds() - t0;
+            if(q < 0) {lost++; continue;}
+            if(q < pos + burst || !starts.count(q)) falseLocks++;
+            else resyncBytes += q - (pos + burst);               // frames given away after the burst
+        }
+        int good = numBursts - falseLocks - lost;
+        printf("     %-10s false lock %5.2f%%, no lock %5.2f%%, skipped after the burst %5ld bytes, %6.2f us/resync\n",
+               plain ? "sync word:" : "FindSync:", 100.0 * falseLocks / numBursts, 100.0 * lost / numBursts,
+               good ? resyncBytes / good : 0, t / numBursts * 1e6);
+        if(!plain && falseLocks * 100 > numBursts) {
+            printf("FAIL: too many false locks\n");
+            exit(1);
+        }
+    }
+    FLACDecoder_Destroy(fd);
+}
+// ADTS frames with more than one raw data block --------------------------------------------------------------------------
+static void multiBlockADTS(const char* file) {
+    std::vector<uint8_t> s = loadFile(file);
+    std::vector<int> st = frameStarts(AAC, s);
+    std::vector<uint8_t> merged;
+    size_t n = st.size() - st.size() % 4;
+    auto frameEnd = [&](size_t f) {return f + 1 < st.size() ? st[f + 1] : (int)s.size();};
+    int maxLen = 0;
+    for(size_t f = 0; f < n; f += 4) {                           // four frames become one with 4 raw data blocks
+        if(!(s[st[f] + 1] & 0x01)) {printf("FAIL: ADTS with crc\n"); exit(1);}
+        int len = 7;
+        for(int k = 0; k < 4; k++) len += frameEnd(f + k) - st[f + k] - 7;
+        uint8_t h[7];
+        memcpy(h, &s[st[f]], 7);
+        h[3] = (h[3] & 0xFC) | ((len >> 11) & 0x03);
+        h[4] = len >> 3;
+        h[5] = (h[5] & 0x1F) | ((len & 0x07) << 5);
+        h[6] = (h[6] & 0xFC) | 3;
+        merged.insert(merged.end(), h, h + 7);
+        for(int k = 0; k < 4; k++) merged.insert(merged.end(), s.begin() + st[f + k] + 7, s.begin() + frameEnd(f + k));
+        maxLen = std::max(maxLen, len);
+    }
+    if(AACFindSyncWord(merged.data(), merged.size()) != 0) {printf("FAIL: 4 block ADTS frame not found\n"); exit(1);}
+
+    // decode both, the pcm must be the same
+    uint32_t crc[2] = {0, 0};
+    int frames[2] = {0, 0};
+    std::vector<int16_t> pcm(2 * 2048 * 2);
+    for(int m = 0; m < 2; m++) {
+        std::vector<uint8_t>& d = m ? merged : s;
+        AACDecoder_t* dec = AACDecoder_Create();
+        uint8_t* p   = m ? d.data() : d.data() + st[0];
+        uint8_t* end = m ? d.data() + d.size() : d.data() + frameEnd(n - 1);
+        int left = end - p;
+        while(left > 0) {
+            int err = AACDecode(dec, end - left, &left, pcm.data());
+            if(err) {printf("FAIL: AACDecode error %i\n", err); exit(1);}
+            crc[m] = crc32(crc[m], pcm.data(), AACGetOutputSamps(dec) * 2);
+            frames[m]++;
+        }
+        AACDecoder_Destroy(dec);
+    }
+    printf("ADTS with 4 raw data blocks: longest frame %i bytes, %i blocks decoded %s\n", maxLen, frames[1],
+           crc[0] == crc[1] && frames[0] == frames[1] ? "bit exact" : "DIFFERENT");
+    if(crc[0] != crc[1] || frames[0] != frames[1]) {
+        printf("FAIL: multi block ADTS frames decode differently\n");
+        exit(1);
+    }
+}
+
+int main() {
+    bench(MP3,  TESTFILES "test_128k_stereo.mp3");
+    bench(AAC,  TESTFILES "test_128k_stereo.aac");
+    bench(FLAC, TESTFILES "test_16bit_stereo.flac");
+    multiBlockADTS(TESTFILES "test_128k_stereo.aac");
+    return 0;
+}